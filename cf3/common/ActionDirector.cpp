@@ -16,6 +16,7 @@
 #include "common/OptionList.hpp"
 #include "common/PropertyList.hpp"
 #include "common/Signal.hpp"
+#include "common/Tracer.hpp"
 #include "common/URI.hpp"
 
 #include "common/XML/Protocol.hpp"
@@ -48,6 +49,7 @@ void ActionDirector::execute()
     if(!disabled)
     {
       CFdebug << name() << ": Executing action " << action->uri().path() << CFendl;
+      TraceSpan span(*action);
       action->execute();
     }
     else
@@ -10,6 +10,8 @@
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
 #include <boost/iostreams/restrict.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 #include "rapidxml/rapidxml.hpp"
 
@@ -31,9 +33,10 @@ namespace common {
 
 struct BinaryDataReader::Implementation
 {
-  Implementation(const URI& file, const Uint rank) :
+  Implementation(const URI& file, const Uint rank, const bool use_mmap) :
     xml_doc(XML::parse_file(file)),
-    m_rank(rank)
+    m_rank(rank),
+    m_mmap(use_mmap)
   {
     XmlNode cfbinary(xml_doc->content->first_node("cfbinary"));
     cf3_assert(from_str<Uint>(cfbinary.attribute_value("version")) == version());
@@ -43,16 +46,12 @@ struct BinaryDataReader::Implementation
     for(; node.is_valid(); node = XmlNode(node.content->next_sibling("node")))
     {
       const Uint found_rank = from_str<Uint>(node.attribute_value("rank"));
-      if(found_rank != m_rank)
-        continue;
-
-      const std::string binary_file_name = node.attribute_value("filename");
-
-      binary_file.open(binary_file_name, std::ios_base::in | std::ios_base::binary);
-      my_node = node;
+      if(found_rank >= rank_nodes.size())
+        rank_nodes.resize(found_rank+1);
+      rank_nodes[found_rank] = node;
     }
 
-    if(!my_node.is_valid())
+    if(m_rank >= rank_nodes.size() || !rank_nodes[m_rank].is_valid())
       throw SetupError(FromHere(), "No node found for rank " + to_str(m_rank));
   }
 
@@ -65,10 +64,17 @@ struct BinaryDataReader::Implementation
     static const Uint current_version = 1;
     return current_version;
   }
+
+  XmlNode get_node(const Uint rank)
+  {
+    if(rank >= rank_nodes.size() || !rank_nodes[rank].is_valid())
+      throw SetupError(FromHere(), "No node found for rank " + to_str(rank));
+    return rank_nodes[rank];
+  }
   
-  XmlNode get_block_node(const Uint block_idx)
+  XmlNode get_block_node(const Uint block_idx, const Uint rank)
   {
-    XmlNode block_node(my_node.content->first_node("block"));
+    XmlNode block_node(get_node(rank).content->first_node("block"));
     for(; block_node.is_valid(); block_node = XmlNode(block_node.content->next_sibling("block")))
     {
       if(from_str<Uint>(block_node.attribute_value("index")) == block_idx)
@@ -78,18 +84,59 @@ struct BinaryDataReader::Implementation
     throw SetupError(FromHere(), "Block with index " + to_str(block_idx) + " was not found");
   }
 
-  void read_data_block(char *data, const Uint count, const Uint block_idx)
+  /// Files written before the "compressed" attribute existed are always compressed
+  bool is_compressed(XmlNode& block_node)
+  {
+    const std::string compressed = block_node.attribute_value("compressed");
+    return compressed.empty() || from_str<bool>(compressed);
+  }
+
+  void read_data_block(char *data, const boost::uint64_t count, const Uint block_idx, const Uint rank)
   {
     static const std::string block_prefix("__CFDATA_BEGIN");
     
-    XmlNode block_node = get_block_node(block_idx);
+    XmlNode block_node = get_block_node(block_idx, rank);
       
-    const Uint block_begin = from_str<Uint>(block_node.attribute_value("begin"));
-    const Uint block_end = from_str<Uint>(block_node.attribute_value("end"));
-    const Uint compressed_size = block_end - block_begin - block_prefix.size();
+    // Offsets in a shared file may exceed 4 GiB
+    const boost::uint64_t block_begin = from_str<boost::uint64_t>(block_node.attribute_value("begin"));
+    const boost::uint64_t block_end = from_str<boost::uint64_t>(block_node.attribute_value("end"));
+    const boost::uint64_t data_size = block_end - block_begin - block_prefix.size();
+    const bool compressed = is_compressed(block_node);
+    if(!compressed && count > data_size)
+      throw SetupError(FromHere(), "Block " + to_str(block_idx) + " holds " + to_str(data_size) + " bytes, but " + to_str(count) + " were requested");
+
+    const std::string filename = get_node(rank).attribute_value("filename");
+    if(m_mmap)
+    {
+      const boost::iostreams::mapped_file_source& mapped_file = get_mapped_file(filename);
+      if(block_end > mapped_file.size())
+        throw SetupError(FromHere(), "Block " + to_str(block_idx) + " extends beyond the end of file " + filename);
+      const char* block_data = mapped_file.data() + block_begin;
+      if(std::string(block_data, block_prefix.size()) != block_prefix)
+        throw SetupError(FromHere(), "Bad block prefix for block " + to_str(block_idx));
+      block_data += block_prefix.size();
+
+      if(count != 0)
+      {
+        if(compressed)
+        {
+          boost::iostreams::filtering_istream decompressing_stream;
+          decompressing_stream.push(boost::iostreams::zlib_decompressor());
+          decompressing_stream.push(boost::iostreams::array_source(block_data, data_size));
+          decompressing_stream.read(data, count);
+        }
+        else
+        {
+          std::copy(block_data, block_data + count, data);
+        }
+      }
+      return;
+    }
+
+    boost::filesystem::fstream& binary_file = get_file(filename);
 
     // Check the prefix
-    binary_file.seekg(block_begin);
+    binary_file.seekg(static_cast<std::streamoff>(block_begin));
     std::vector<char> prefix_buf(block_prefix.size());
     binary_file.read(&prefix_buf[0], block_prefix.size());
     const std::string read_prefix(prefix_buf.begin(), prefix_buf.end());
@@ -98,31 +145,64 @@ struct BinaryDataReader::Implementation
    
     if(count != 0)
     {
-      // Build a decompressing stream
-      boost::iostreams::filtering_istream decompressing_stream;
-      decompressing_stream.set_auto_close(false);
-      decompressing_stream.push(boost::iostreams::zlib_decompressor());
-      decompressing_stream.push(boost::iostreams::restrict(binary_file, 0, compressed_size));
-      
-      // Read the data
-      decompressing_stream.read(data, count);
-      decompressing_stream.pop();
+      if(compressed)
+      {
+        // Build a decompressing stream
+        boost::iostreams::filtering_istream decompressing_stream;
+        decompressing_stream.set_auto_close(false);
+        decompressing_stream.push(boost::iostreams::zlib_decompressor());
+        decompressing_stream.push(boost::iostreams::restrict(binary_file, 0, data_size));
+
+        // Read the data
+        decompressing_stream.read(data, count);
+        decompressing_stream.pop();
+        cf3_assert(static_cast<boost::uint64_t>(binary_file.tellg()) == block_end);
+      }
+      else
+      {
+        binary_file.read(data, count);
+      }
     }
-    
-    cf3_assert(binary_file.tellg() == block_end);
+  }
+
+  boost::filesystem::fstream& get_file(const std::string& filename)
+  {
+    boost::shared_ptr<boost::filesystem::fstream>& binary_file = binary_files[filename];
+    if(is_null(binary_file))
+    {
+      binary_file.reset(new boost::filesystem::fstream());
+      binary_file->open(filename, std::ios_base::in | std::ios_base::binary);
+      if(!binary_file->is_open())
+        throw SetupError(FromHere(), "Could not open binary file " + filename);
+    }
+    return *binary_file;
+  }
+
+  const boost::iostreams::mapped_file_source& get_mapped_file(const std::string& filename)
+  {
+    boost::shared_ptr<boost::iostreams::mapped_file_source>& mapped_file = mapped_files[filename];
+    if(is_null(mapped_file))
+      mapped_file.reset(new boost::iostreams::mapped_file_source(filename));
+    return *mapped_file;
   }
 
   // XML document describing all data added
   boost::shared_ptr<XmlDoc> xml_doc;
 
-  // Binary file
-  boost::filesystem::fstream binary_file;
+  // Binary files, indexed by file name. With a shared file, all ranks use the same file.
+  std::map< std::string, boost::shared_ptr<boost::filesystem::fstream> > binary_files;
 
-  // Xml data for the blocks associated with the current rank
-  XmlNode my_node;
+  // Memory-mapped binary files, indexed by file name
+  std::map< std::string, boost::shared_ptr<boost::iostreams::mapped_file_source> > mapped_files;
+
+  // Xml data for the blocks associated with each rank
+  std::vector<XmlNode> rank_nodes;
 
   // Rank to read
   const Uint m_rank;
+
+  // Read through memory-mapping instead of streams
+  const bool m_mmap;
 };
   
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -138,6 +218,11 @@ BinaryDataReader::BinaryDataReader ( const std::string& name ) : Component(name)
     .pretty_name("Rank")
     .description("Rank for which to read data")
     .attach_trigger(boost::bind(&BinaryDataReader::trigger_file, this));
+
+  options().add("mmap", false)
+    .pretty_name("Memory Map")
+    .description("Read the binary files through memory-mapping instead of file streams")
+    .attach_trigger(boost::bind(&BinaryDataReader::trigger_file, this));
 }
 
 BinaryDataReader::~BinaryDataReader()
@@ -150,43 +235,82 @@ void BinaryDataReader::close()
   m_implementation.reset();
 }
 
+Uint BinaryDataReader::nb_ranks()
+{
+  check_open();
+  return m_implementation->rank_nodes.size();
+}
+
 Uint BinaryDataReader::block_cols ( const Uint block_idx )
 {
-  return from_str<Uint>(m_implementation->get_block_node(block_idx).attribute_value("nb_cols"));
+  return block_cols(block_idx, default_rank());
+}
+
+Uint BinaryDataReader::block_cols ( const Uint block_idx, const Uint rank )
+{
+  check_open();
+  return from_str<Uint>(m_implementation->get_block_node(block_idx, rank).attribute_value("nb_cols"));
 }
 
 Uint BinaryDataReader::block_rows ( const Uint block_idx )
 {
-  return from_str<Uint>(m_implementation->get_block_node(block_idx).attribute_value("nb_rows"));
+  return block_rows(block_idx, default_rank());
+}
+
+Uint BinaryDataReader::block_rows ( const Uint block_idx, const Uint rank )
+{
+  check_open();
+  return from_str<Uint>(m_implementation->get_block_node(block_idx, rank).attribute_value("nb_rows"));
 }
 
 std::string BinaryDataReader::block_name ( const Uint block_idx )
 {
-  return m_implementation->get_block_node(block_idx).attribute_value("name");
+  check_open();
+  return m_implementation->get_block_node(block_idx, default_rank()).attribute_value("name");
 }
 
 std::string BinaryDataReader::block_type_name ( const Uint block_idx )
 {
-  return m_implementation->get_block_node(block_idx).attribute_value("type_name");
+  return block_type_name(block_idx, default_rank());
 }
 
+std::string BinaryDataReader::block_type_name ( const Uint block_idx, const Uint rank )
+{
+  check_open();
+  return m_implementation->get_block_node(block_idx, rank).attribute_value("type_name");
+}
+
+void BinaryDataReader::read_data_block(char *data, const boost::uint64_t count, const Uint block_idx, const Uint rank)
+{
+  check_open();
+  m_implementation->read_data_block(data, count, block_idx, rank);
+}
 
-void BinaryDataReader::read_data_block(char *data, const Uint count, const Uint block_idx)
+Uint BinaryDataReader::default_rank() const
+{
+  return options().value<Uint>("rank");
+}
+
+void BinaryDataReader::check_open()
 {
   if(is_null(m_implementation.get()))
     throw SetupError(FromHere(), "No open file for BinaryDataReader at " + uri().path());
-  
-  m_implementation->read_data_block(data, count, block_idx);
 }
 
 void BinaryDataReader::trigger_file()
 {
   const URI file_uri = options().value<URI>("file");
+  // Options may be set before the file
+  if(file_uri.path().empty())
+  {
+    m_implementation.reset();
+    return;
+  }
   if(!boost::filesystem::exists(file_uri.path()))
   {
     throw SetupError(FromHere(), "Input file " + file_uri.path() + " does not exist");
   }
-  m_implementation.reset(new Implementation(file_uri, options().value<Uint>("rank")));
+  m_implementation.reset(new Implementation(file_uri, options().value<Uint>("rank"), options().value<bool>("mmap")));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
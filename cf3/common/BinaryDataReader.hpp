@@ -7,9 +7,11 @@
 #ifndef cf3_common_BinaryDataReader_hpp
 #define cf3_common_BinaryDataReader_hpp
 
+#include <boost/cstdint.hpp>
 #include <boost/scoped_ptr.hpp>
 
 #include "common/Component.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/List.hpp"
 #include "common/Table.hpp"
 
@@ -38,46 +40,111 @@ public: // functions
   template<typename T>
   void read_table(Table<T>& table, const Uint block_idx)
   {
-    if(block_type_name(block_idx) != class_name<T>())
-      throw SetupError(FromHere(), "Block at index " + to_str(block_idx) + " is of type " + block_type_name(block_idx) + " and can't be stored in " + table.type_name());
+    read_table(table, block_idx, default_rank());
+  }
+
+  /// Read the given block, as written by the given rank, into the supplied table. The table is resized as needed
+  template<typename T>
+  void read_table(Table<T>& table, const Uint block_idx, const Uint rank)
+  {
+    if(block_type_name(block_idx, rank) != class_name<T>())
+      throw SetupError(FromHere(), "Block at index " + to_str(block_idx) + " of rank " + to_str(rank) + " is of type " + block_type_name(block_idx, rank) + " and can't be stored in " + table.type_name());
     
-    const Uint rows = block_rows(block_idx);
-    const Uint cols = block_cols(block_idx);
+    const Uint rows = block_rows(block_idx, rank);
+    const Uint cols = block_cols(block_idx, rank);
     table.set_row_size(cols);
     table.resize(rows);
-    read_data_block(reinterpret_cast<char*>(table.array().data()), sizeof(T)*rows*cols, block_idx);
+    if(table.is_column_major())
+    {
+      // The data is stored row by row
+      typename Table<T>::ArrayT row_major(boost::extents[rows][cols]);
+      read_data_block(reinterpret_cast<char*>(row_major.data()), static_cast<boost::uint64_t>(sizeof(T))*rows*cols, block_idx, rank);
+      table.array() = row_major;
+      return;
+    }
+    read_data_block(reinterpret_cast<char*>(table.array().data()), static_cast<boost::uint64_t>(sizeof(T))*rows*cols, block_idx, rank);
   }
   
   /// Read the given block into the supplied list. The list is resized as needed
   template<typename T>
   void read_list(List<T>& list, const Uint block_idx)
   {
-    if(block_type_name(block_idx) != class_name<T>())
-      throw SetupError(FromHere(), "Block at index " + to_str(block_idx) + " is of type " + block_type_name(block_idx) + " and can't be stored in " + list.type_name());
+    read_list(list, block_idx, default_rank());
+  }
+
+  /// Read the given block, as written by the given rank, into the supplied list. The list is resized as needed
+  template<typename T>
+  void read_list(List<T>& list, const Uint block_idx, const Uint rank)
+  {
+    if(block_type_name(block_idx, rank) != class_name<T>())
+      throw SetupError(FromHere(), "Block at index " + to_str(block_idx) + " of rank " + to_str(rank) + " is of type " + block_type_name(block_idx, rank) + " and can't be stored in " + list.type_name());
     
-    const Uint rows = block_rows(block_idx);
+    const Uint rows = block_rows(block_idx, rank);
     list.resize(rows);
-    read_data_block(reinterpret_cast<char*>(list.array().data()), sizeof(T)*rows, block_idx);
+    read_data_block(reinterpret_cast<char*>(list.array().data()), static_cast<boost::uint64_t>(sizeof(T))*rows, block_idx, rank);
+  }
+
+  /// Read the supplied compressed table from the given offsets block and the values block that follows it,
+  /// as written by BinaryDataWriter::append_data. The table is resized as needed
+  template<typename T>
+  void read_compressed_table(CompressedTable<T>& table, const Uint block_idx)
+  {
+    if(block_type_name(block_idx) != class_name<Uint>())
+      throw SetupError(FromHere(), "Block at index " + to_str(block_idx) + " is of type " + block_type_name(block_idx) + " and can't hold the offsets of " + table.type_name());
+    if(block_type_name(block_idx+1) != class_name<T>())
+      throw SetupError(FromHere(), "Block at index " + to_str(block_idx+1) + " is of type " + block_type_name(block_idx+1) + " and can't hold the values of " + table.type_name());
+
+    const Uint nb_offsets = block_rows(block_idx);
+    const Uint nb_values = block_rows(block_idx+1);
+    if(nb_offsets == 0)
+      throw SetupError(FromHere(), "Block at index " + to_str(block_idx) + " does not contain row offsets");
+
+    table.offsets().resize(nb_offsets);
+    read_data_block(reinterpret_cast<char*>(&table.offsets()[0]), sizeof(Uint)*nb_offsets, block_idx, default_rank());
+    if(table.offsets().back() != nb_values)
+      throw SetupError(FromHere(), "Row offsets in block " + to_str(block_idx) + " don't match the " + to_str(nb_values) + " values in block " + to_str(block_idx+1));
+
+    table.values().resize(nb_values);
+    if(nb_values != 0)
+      read_data_block(reinterpret_cast<char*>(&table.values()[0]), sizeof(T)*nb_values, block_idx+1, default_rank());
   }
 
   /// Close the current file
   void close();
 
+  /// Number of ranks that wrote the file
+  Uint nb_ranks();
+
   /// Number of rows for the given block
   Uint block_rows(const Uint block_idx);
 
+  /// Number of rows for the given block, as written by the given rank
+  Uint block_rows(const Uint block_idx, const Uint rank);
+
   /// Number of columns for the given block
   Uint block_cols(const Uint block_idx);
 
+  /// Number of columns for the given block, as written by the given rank
+  Uint block_cols(const Uint block_idx, const Uint rank);
+
   /// Name of the given block
   std::string block_name(const Uint block_idx);
   
   /// Type name of the data stored in the given block
   std::string block_type_name(const Uint block_idx);
 
+  /// Type name of the data stored in the given block, as written by the given rank
+  std::string block_type_name(const Uint block_idx, const Uint rank);
+
 private:
   // Read aata block from the binary file
-  void read_data_block(char* data, const Uint count, const Uint block_idx);
+  void read_data_block(char* data, const boost::uint64_t count, const Uint block_idx, const Uint rank);
+
+  // Rank configured through the options
+  Uint default_rank() const;
+
+  // Throw if no file is open
+  void check_open();
 
   // Trigger on output file change
   void trigger_file();
@@ -4,12 +4,15 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <limits>
+
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/assign/list_of.hpp>
 
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/device/file_descriptor.hpp>
 
 #include "common/Log.hpp"
@@ -29,20 +32,51 @@
 namespace cf3 {
 namespace common {
 
+namespace detail
+{
+
+boost::uint64_t shared_block_begin(const boost::uint64_t file_end, const std::vector<boost::uint64_t>& block_sizes, const Uint rank)
+{
+  cf3_assert(rank < block_sizes.size());
+  boost::uint64_t result = file_end;
+  for(Uint i = 0; i != rank; ++i)
+    result += block_sizes[i];
+  return result;
+}
+
+}
+
 struct BinaryDataWriter::Implementation
 {
-  Implementation(const URI& file) :
-    filename(build_filename(file, PE::Comm::instance().rank())),
+  Implementation(const URI& file, const bool shared_file, const bool compress) :
+    filename(shared_file ? build_shared_filename(file) : build_filename(file, PE::Comm::instance().rank())),
     xml_filename(file),
     index(0),
     xml_doc("1.0", "ISO-8859-1"),
-    m_total_count(0)
+    m_total_count(0),
+    m_written_count(0),
+    m_compress(compress),
+    m_shared(shared_file && PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1),
+    m_file_end(0)
   {
     const Uint v = version();
-    out_file.open(filename, std::ios_base::out | std::ios_base::binary);
-    out_file.write(reinterpret_cast<const char*>(&v), sizeof(Uint));
-
     PE::Comm& comm = PE::Comm::instance();
+    if(m_shared)
+    {
+      // All ranks write into the same file, at offsets agreed upon for each block
+      MPI_CHECK_RESULT(MPI_File_open, (comm.communicator(), const_cast<char*>(filename.c_str()), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &m_mpi_file));
+      MPI_CHECK_RESULT(MPI_File_set_size, (m_mpi_file, 0));
+      if(comm.rank() == 0)
+        MPI_CHECK_RESULT(MPI_File_write_at, (m_mpi_file, 0, const_cast<Uint*>(&v), sizeof(Uint), MPI_BYTE, MPI_STATUS_IGNORE));
+      m_file_end = sizeof(Uint);
+    }
+    else
+    {
+      out_file.open(filename, std::ios_base::out | std::ios_base::binary);
+      out_file.write(reinterpret_cast<const char*>(&v), sizeof(Uint));
+    }
+    m_written_count = sizeof(Uint);
+
     // Rank 0 writes out an XML file that lists all filenames for all CPUs
     if(comm.rank() == 0)
     {
@@ -53,7 +87,7 @@ struct BinaryDataWriter::Implementation
       for(Uint i = 0; i != comm.size(); ++i)
       {
         XmlNode node = node_list.add_node("node");
-        node.set_attribute("filename", build_filename(file, i));
+        node.set_attribute("filename", shared_file ? filename : build_filename(file, i));
         node.set_attribute("rank", to_str(i));
         node_xml_data.push_back(node);
       }
@@ -62,8 +96,11 @@ struct BinaryDataWriter::Implementation
 
   ~Implementation()
   {
-    CFdebug << "wrote a total of " << m_total_count << " bytes with a compression ratio of " << static_cast<Real>(out_file.tellp()) / static_cast<Real>(m_total_count) * 100. << "%" << CFendl;
-    out_file.close();
+    CFdebug << "wrote a total of " << m_total_count << " bytes with a compression ratio of " << static_cast<Real>(m_written_count) / static_cast<Real>(m_total_count) * 100. << "%" << CFendl;
+    if(m_shared)
+      MPI_File_close(&m_mpi_file);
+    else
+      out_file.close();
     if(PE::Comm::instance().rank() == 0)
       XML::to_file(xml_doc, xml_filename);
 
@@ -72,34 +109,53 @@ struct BinaryDataWriter::Implementation
 
   Uint write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name)
   {
-    cf3_assert(out_file.is_open());
     PE::Comm& comm = PE::Comm::instance();
     // Prefix and suffix markers
     static const std::string block_prefix("__CFDATA_BEGIN");
 
-    const Uint block_begin = out_file.tellp();
-
-    // Write the prefix
-    out_file.write(block_prefix.c_str(), block_prefix.size());
-    
-    if(count != 0)
+    // Compress the data in memory, so the size of the block is known before it is written
+    std::string compressed_data;
+    if(m_compress && count != 0)
     {
-      // Build a compressed stream
       boost::iostreams::filtering_ostream compressing_stream;
       compressing_stream.push(boost::iostreams::zlib_compressor());
-      compressing_stream.push(out_file);
-      
-      // Write the data
+      compressing_stream.push(boost::iostreams::back_inserter(compressed_data));
       compressing_stream.write(data, count);
       compressing_stream.pop();
     }
+    const char* block_data = m_compress ? compressed_data.data() : data;
+    const boost::uint64_t block_data_size = m_compress ? static_cast<boost::uint64_t>(compressed_data.size()) : static_cast<boost::uint64_t>(count);
 
-    const Uint block_end = out_file.tellp();
+    // Offsets are 64 bit, since the shared file holds the data of all ranks and easily grows beyond 4 GiB
+    boost::uint64_t block_begin = 0;
+    if(m_shared)
+    {
+      const boost::uint64_t my_block_size = block_prefix.size() + block_data_size;
+      std::vector<boost::uint64_t> block_sizes;
+      comm.all_gather(my_block_size, block_sizes);
+      block_begin = detail::shared_block_begin(m_file_end, block_sizes, comm.rank());
+      for(Uint i = 0; i != block_sizes.size(); ++i)
+        m_file_end += block_sizes[i];
+
+      write_shared(block_begin, block_prefix.c_str(), block_prefix.size());
+      write_shared(block_begin + block_prefix.size(), block_data, block_data_size);
+    }
+    else
+    {
+      cf3_assert(out_file.is_open());
+      block_begin = static_cast<boost::uint64_t>(out_file.tellp());
+      out_file.write(block_prefix.c_str(), block_prefix.size());
+      if(block_data_size != 0)
+        out_file.write(block_data, block_data_size);
+    }
+
+    const boost::uint64_t block_end = block_begin + block_prefix.size() + block_data_size;
+    m_written_count += block_prefix.size() + block_data_size;
 
     // Data describing the block on the current CPU
-    const std::vector<Uint> my_block_info = boost::assign::list_of(nb_rows)(nb_cols)(block_begin)(block_end);
+    const std::vector<boost::uint64_t> my_block_info = boost::assign::list_of<boost::uint64_t>(nb_rows)(nb_cols)(block_begin)(block_end);
     const Uint block_info_size = my_block_info.size();
-    std::vector<Uint> global_block_info;
+    std::vector<boost::uint64_t> global_block_info;
     const Uint root = 0;
     if(comm.is_active())
     {
@@ -125,6 +181,7 @@ struct BinaryDataWriter::Implementation
         block_xml.set_attribute("nb_cols", to_str(global_block_info[j+1]));
         block_xml.set_attribute("begin", to_str(global_block_info[j+2]));
         block_xml.set_attribute("end", to_str(global_block_info[j+3]));
+        block_xml.set_attribute("compressed", to_str(m_compress));
       }
     }
 
@@ -134,6 +191,26 @@ struct BinaryDataWriter::Implementation
     return index - 1;
   }
 
+  /// Collective write of size bytes at offset into the shared file. The MPI count is an int, so the data is written as
+  /// a number of fixed-size chunks followed by the remaining bytes, keeping both counts in range for blocks above 2 GiB.
+  /// All ranks make the same two calls, even if they have nothing to write.
+  void write_shared(const boost::uint64_t offset, const char* data, const boost::uint64_t size)
+  {
+    static const boost::uint64_t chunk_size = 1024*1024;
+    const boost::uint64_t nb_chunks = size / chunk_size;
+    const boost::uint64_t remainder = size % chunk_size;
+    cf3_assert(nb_chunks <= static_cast<boost::uint64_t>(std::numeric_limits<int>::max()));
+
+    MPI_Datatype chunk_type;
+    MPI_CHECK_RESULT(MPI_Type_contiguous, (static_cast<int>(chunk_size), MPI_BYTE, &chunk_type));
+    MPI_CHECK_RESULT(MPI_Type_commit, (&chunk_type));
+    MPI_CHECK_RESULT(MPI_File_write_at_all, (m_mpi_file, static_cast<MPI_Offset>(offset), const_cast<char*>(data), static_cast<int>(nb_chunks), chunk_type, MPI_STATUS_IGNORE));
+    MPI_CHECK_RESULT(MPI_Type_free, (&chunk_type));
+
+    const boost::uint64_t remainder_offset = nb_chunks*chunk_size;
+    MPI_CHECK_RESULT(MPI_File_write_at_all, (m_mpi_file, static_cast<MPI_Offset>(offset + remainder_offset), const_cast<char*>(data + remainder_offset), static_cast<int>(remainder), MPI_BYTE, MPI_STATUS_IGNORE));
+  }
+
   Uint version() const
   {
     static const Uint current_version = 1;
@@ -148,6 +225,14 @@ struct BinaryDataWriter::Implementation
     return result.path();
   }
 
+  std::string build_shared_filename(const URI& input)
+  {
+    const URI my_dir = input.base_path();
+    const std::string basename = input.base_name();
+    const URI result(my_dir / (basename + ".cfbin"));
+    return result.path();
+  }
+
   const std::string filename;
   const URI xml_filename;
   boost::filesystem::fstream out_file;
@@ -159,7 +244,22 @@ struct BinaryDataWriter::Implementation
   XmlDoc xml_doc;
 
   std::vector<XmlNode> node_xml_data;
-  Uint m_total_count;
+  boost::uint64_t m_total_count;
+
+  // Number of bytes written to the file by this rank
+  boost::uint64_t m_written_count;
+
+  // True if the data blocks are compressed
+  const bool m_compress;
+
+  // True if all ranks write to a single file using MPI-IO
+  const bool m_shared;
+
+  // Shared file handle
+  MPI_File m_mpi_file;
+
+  // Size of the shared file after the last written block
+  boost::uint64_t m_file_end;
 };
   
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -170,6 +270,16 @@ BinaryDataWriter::BinaryDataWriter ( const std::string& name ) : Component(name)
     .pretty_name("File")
     .description("File name for the output file")
     .attach_trigger(boost::bind(&BinaryDataWriter::trigger_file, this));
+
+  options().add("shared_file", false)
+    .pretty_name("Shared File")
+    .description("Write the data of all ranks into a single file, using MPI-IO collective writes")
+    .attach_trigger(boost::bind(&BinaryDataWriter::trigger_file, this));
+
+  options().add("compress", true)
+    .pretty_name("Compress")
+    .description("Compress the data blocks using zlib. Uncompressed blocks can be memory-mapped and read partially by BinaryDataReader")
+    .attach_trigger(boost::bind(&BinaryDataWriter::trigger_file, this));
 }
 
 BinaryDataWriter::~BinaryDataWriter()
@@ -186,7 +296,7 @@ Uint BinaryDataWriter::write_data_block(const char* data, const std::streamsize
 {
   if(is_null(m_implementation.get()))
   {
-    m_implementation.reset(new Implementation(options().value<URI>("file")));
+    m_implementation.reset(new Implementation(options().value<URI>("file"), options().value<bool>("shared_file"), options().value<bool>("compress")));
   }
 
   return m_implementation->write_data_block(data, count, list_name, nb_rows, nb_cols, type_name);
@@ -7,9 +7,11 @@
 #ifndef cf3_common_BinaryDataWriter_hpp
 #define cf3_common_BinaryDataWriter_hpp
 
+#include <boost/cstdint.hpp>
 #include <boost/scoped_ptr.hpp>
 
 #include "common/Component.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/List.hpp"
 #include "common/Table.hpp"
 
@@ -20,8 +22,16 @@ namespace common {
   
 ///////////////////////////////////////////////////////////////////////////////////////
 
-  
-/// Component for writing binary data collected into a single file
+namespace detail
+{
+  /// Offset in a shared binary file of the block written by the given rank, when all ranks append blocks of the given sizes
+  /// to a file that currently ends at file_end. The blocks are stored in rank order.
+  Common_API boost::uint64_t shared_block_begin(const boost::uint64_t file_end, const std::vector<boost::uint64_t>& block_sizes, const Uint rank);
+}
+
+/// Component for writing binary data collected into a single file.
+/// By default each rank writes its own file, listed in an XML index written by rank 0. With the "shared_file" option,
+/// all ranks write into one file using MPI-IO collective writes, each block of a rank following the blocks of the lower ranks.
 class Common_API BinaryDataWriter : public Component {
 
 public: // functions
@@ -34,10 +44,17 @@ public: // functions
   /// Get the class name
   static std::string type_name () { return "BinaryDataWriter"; }
 
-  /// Append a new data block containing data from the supplied table. An index into the current file is returned
+  /// Append a new data block containing data from the supplied table. An index into the current file is returned.
+  /// The data is always written row by row, so column-major tables are copied first
   template<typename T>
   Uint append_data(const Table<T>& table)
   {
+    if(table.is_column_major())
+    {
+      typename Table<T>::ArrayT row_major(boost::extents[table.size()][table.row_size()]);
+      row_major = table.array();
+      return write_data_block(reinterpret_cast<const char*>(row_major.data()), sizeof(T)*table.row_size()*table.size(), table.name(), table.size(), table.row_size(), class_name<T>());
+    }
     return write_data_block(reinterpret_cast<const char*>(table.array().data()), sizeof(T)*table.row_size()*table.size(), table.name(), table.size(), table.row_size(), class_name<T>());
   }
   
@@ -48,6 +65,17 @@ public: // functions
     return write_data_block(reinterpret_cast<const char*>(list.array().data()), sizeof(T)*list.size(), list.name(), list.size(), 1, class_name<T>());
   }
 
+  /// Append the supplied compressed table as two consecutive data blocks: first the row offsets, then the values.
+  /// The index of the offsets block is returned
+  template<typename T>
+  Uint append_data(const CompressedTable<T>& table)
+  {
+    const Uint offsets_idx = write_data_block(reinterpret_cast<const char*>(&table.offsets()[0]), sizeof(Uint)*table.offsets().size(), table.name() + "_offsets", table.offsets().size(), 1, class_name<Uint>());
+    const T* values = table.nb_values() == 0 ? 0 : &table.values()[0];
+    write_data_block(reinterpret_cast<const char*>(values), sizeof(T)*table.nb_values(), table.name(), table.nb_values(), 1, class_name<T>());
+    return offsets_idx;
+  }
+
   /// Close the current file
   void close();
 
@@ -7,7 +7,8 @@
 #include <sstream>
 #include <boost/cast.hpp>
 #include <boost/tokenizer.hpp>
-#include <boost/algorithm/string.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "rapidxml/rapidxml.hpp"
 
@@ -52,11 +53,39 @@ ComponentBuilder < Component, Component, LibCommon > Component_Builder;
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+  /// Protects the component ID counter, the search and path caches and the tree generations,
+  /// since searches may be run from several threads, even on const components.
+  /// This is a single lock for all trees, so threads searching unrelated trees still contend on it.
+  /// It is only held for the cache bookkeeping, never during the search itself.
+  boost::mutex& cache_mutex()
+  {
+    // Never destroyed, since components may be removed during static destruction
+    static boost::mutex* mutex = new boost::mutex();
+    return *mutex;
+  }
+
+  /// Next free component ID
+  Uint next_component_id()
+  {
+    boost::lock_guard<boost::mutex> lock(cache_mutex());
+    static Uint id = 0;
+    return id++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 Component::Component ( const std::string& name ) :
     m_name (),
     m_properties(new PropertyList()),
     m_options(new OptionList()),
-    m_parent(0)
+    m_parent(0),
+    m_id(detail::next_component_id()),
+    m_tree_generation(0),
+    m_path_cache_root_id(m_id),
+    m_path_cache_generation(0)
 {
   // accept name
 
@@ -241,6 +270,7 @@ void Component::rename ( const std::string& name )
   }
 
   m_name = name;
+  tree_changed();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -307,6 +337,7 @@ Component& Component::add_component ( const boost::shared_ptr<Component>& subcom
 
   subcomp->m_parent = this;
 
+  tree_changed();
   raise_tree_updated_event();
 
   return *subcomp;
@@ -384,6 +415,7 @@ boost::shared_ptr<Component> Component::remove_component ( const std::string& na
     }
     m_components = new_storage;
 
+    tree_changed();
     raise_tree_updated_event();
 
     return comp;                                   // return it to client
@@ -474,6 +506,50 @@ void Component::change_parent(Handle<Component> to_parent)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void Component::tree_changed()
+{
+  boost::lock_guard<boost::mutex> lock(detail::cache_mutex());
+  for(Component* comp = this; comp != 0; comp = comp->m_parent)
+  {
+    ++comp->m_tree_generation;
+    comp->m_components_cache.clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Uint Component::tree_generation() const
+{
+  boost::lock_guard<boost::mutex> lock(detail::cache_mutex());
+  return m_tree_generation;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::shared_ptr<void> Component::find_cached_components(const std::type_info& list_type, const bool recurse, Uint& generation) const
+{
+  boost::lock_guard<boost::mutex> lock(detail::cache_mutex());
+  generation = m_tree_generation;
+  const ComponentsCacheT::const_iterator cached = m_components_cache.find(&list_type);
+  if(cached == m_components_cache.end())
+    return boost::shared_ptr<void>();
+  return recurse ? cached->second.recursive : cached->second.children;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void Component::store_cached_components(const std::type_info& list_type, const bool recurse, const boost::shared_ptr<void>& list, const Uint generation) const
+{
+  boost::lock_guard<boost::mutex> lock(detail::cache_mutex());
+  // Don't store a list that was built while the tree changed
+  if(generation != m_tree_generation)
+    return;
+  CachedComponents& cached = m_components_cache[&list_type];
+  (recurse ? cached.recursive : cached.children) = list;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void Component::move_to ( Component& new_parent )
 {
   cf3_assert(m_parent);
@@ -486,58 +562,77 @@ void Component::move_to ( Component& new_parent )
 
 Handle<Component> Component::access_component(const URI& path) const
 {
-  // Return self for trivial path or at end of recursion.
-  if(path.path() == "." || path.empty())
-    return const_cast<Component*>(this)->handle<Component>();
+  const std::string path_str = path.path();
 
-  // If the path is absolute, make it relative and pass it to the root
-  if(path.is_absolute())
+  // A path can only lead to components of the same tree, so the cache is valid as long as the root is the same
+  // and its tree generation did not change. The root is identified by its ID, since IDs are never reused.
+  Uint root_id = 0;
+  Uint generation = 0;
   {
-    // String without protocol
-    std::string new_path = path.path();
-
-    // Remove any leading /
-    boost::algorithm::trim_left_if(new_path, boost::algorithm::is_any_of("/"));
-
-    if(new_path.empty())
+    boost::lock_guard<boost::mutex> lock(detail::cache_mutex());
+    const Component* tree_root = this;
+    while(tree_root->m_parent)
+      tree_root = tree_root->m_parent;
+    root_id = tree_root->m_id;
+    generation = tree_root->m_tree_generation;
+
+    // Drop the cached paths if this component moved to another tree or the tree was modified since they were stored
+    if(m_path_cache_root_id != root_id || m_path_cache_generation != generation)
     {
-      return const_cast<Component*>(root().get())->handle<Component>();
+      m_path_cache.clear();
+      m_path_cache_root_id = root_id;
+      m_path_cache_generation = generation;
     }
 
-    // Pass the rest to root
-    return root()->access_component(URI(new_path, cf3::common::URI::Scheme::CPATH));
+    const std::map<std::string, Handle<Component> >::const_iterator cached = m_path_cache.find(path_str);
+    if(cached != m_path_cache.end() && is_not_null(cached->second))
+      return cached->second;
   }
 
-  // Relative path
-  std::string path_str = path.path();
-  // Remove trailing /
-  boost::algorithm::trim_right_if(path_str, boost::algorithm::is_any_of("/"));
-
-  // Find the first separator
-  const std::size_t first_sep = path_str.find("/");
-  const bool has_no_separator = (first_sep == std::string::npos);
-
-  // Current part of the path to parse
-  const std::string current_part = has_no_separator ? path_str : path_str.substr(0, first_sep);
-
-  // Remainder of the path to parse, set to "." if there were no more parts
-  const std::string next_part = has_no_separator ? "." : path_str.substr(first_sep+1, path_str.size());
-
-  // Dispatch to self
-  if(current_part == "." || current_part.empty())
-    return access_component(next_part);
+  // Walk the path, starting from the root if it is absolute. The segment string is reused to avoid allocations.
+  const Component* current = path.is_absolute() ? root().get() : this;
+  const std::size_t path_size = path_str.size();
+  std::string segment;
+  std::size_t segment_begin = 0;
+  while(segment_begin < path_size)
+  {
+    std::size_t segment_end = path_str.find('/', segment_begin);
+    if(segment_end == std::string::npos)
+      segment_end = path_size;
+    segment.assign(path_str, segment_begin, segment_end - segment_begin);
+    segment_begin = segment_end + 1;
+
+    // Stay at the current component
+    if(segment.empty() || segment == ".")
+      continue;
+
+    // Go to the parent
+    if(segment == "..")
+    {
+      current = current->m_parent;
+      if(!current)
+        return Handle<Component>();
+      continue;
+    }
 
-  // Dispatch to parent
-  if(current_part == "..")
-    return m_parent ? m_parent->access_component(next_part) : Handle<Component>();
+    // Go to the child, returning null if not found
+    const CompLookupT::const_iterator found = current->m_component_lookup.find(segment);
+    if(found == current->m_component_lookup.end())
+      return Handle<Component>();
+    current = current->m_components[found->second].get();
+  }
 
-  // Dispatch to child
-  Handle<Component const> child = get_child(current_part);
-  if(is_not_null(child))
-    return child->access_component(next_part);
+  const Handle<Component> result = const_cast<Component*>(current)->handle<Component>();
 
-  // Return null if not found
-  return Handle<Component>();
+  boost::lock_guard<boost::mutex> lock(detail::cache_mutex());
+  // Only store the result if the tree did not change during the lookup
+  const Component* tree_root = this;
+  while(tree_root->m_parent)
+    tree_root = tree_root->m_parent;
+  if(tree_root->m_id == root_id && tree_root->m_tree_generation == generation
+     && m_path_cache_root_id == root_id && m_path_cache_generation == generation)
+    m_path_cache[path_str] = result;
+  return result;
 }
 
 //Handle<Component const> Component::access_component(const URI& path) const
@@ -1317,72 +1412,60 @@ void Component::on_ping_event(SignalArgs& args)
 
 Component::iterator Component::begin()
 {
-  std::vector<boost::shared_ptr<Component> > vec;
-  put_components<Component>(vec, false); // not recursive
-  return Component::iterator(vec, 0);    // begin
+  return Component::iterator(cached_components<Component>(false), 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::iterator Component::end()
 {
-  std::vector<boost::shared_ptr<Component> > vec;
-  put_components<Component>(vec, false);        // not recursive
-  return Component::iterator(vec, vec.size());  // end
+  const boost::shared_ptr< const std::vector< boost::shared_ptr<Component> > > vec = cached_components<Component>(false);
+  return Component::iterator(vec, vec->size());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::const_iterator Component::begin() const
 {
-  std::vector<boost::shared_ptr<Component const> > vec;
-  put_components<Component>(vec, false); // not recursive
-  return Component::const_iterator(vec, 0);    // begin
+  return Component::const_iterator(cached_components<Component>(false), 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::const_iterator Component::end() const
 {
-  std::vector<boost::shared_ptr<Component const> > vec;
-  put_components<Component>(vec, false);        // not recursive
-  return Component::const_iterator(vec, vec.size());  // end
+  const boost::shared_ptr< const std::vector< boost::shared_ptr<Component const> > > vec = cached_components<Component>(false);
+  return Component::const_iterator(vec, vec->size());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::iterator Component::recursive_begin()
 {
-  std::vector<boost::shared_ptr<Component> > vec;
-  put_components<Component>(vec, true);  // recursive
-  return Component::iterator(vec, 0);    // begin
+  return Component::iterator(cached_components<Component>(true), 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::iterator Component::recursive_end()
 {
-  std::vector<boost::shared_ptr<Component> > vec;
-  put_components<Component>(vec, true);         // recursive
-  return Component::iterator(vec, vec.size());  // end
+  const boost::shared_ptr< const std::vector< boost::shared_ptr<Component> > > vec = cached_components<Component>(true);
+  return Component::iterator(vec, vec->size());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::const_iterator Component::recursive_begin() const
 {
-  std::vector<boost::shared_ptr<Component const> > vec;
-  put_components<Component>(vec, true);  // recursive
-  return Component::const_iterator(vec, 0);    // begin
+  return Component::const_iterator(cached_components<Component>(true), 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::const_iterator Component::recursive_end() const
 {
-  std::vector<boost::shared_ptr<Component const> > vec;
-  put_components<Component>(vec, true);         // recursive
-  return Component::const_iterator(vec, vec.size());  // end
+  const boost::shared_ptr< const std::vector< boost::shared_ptr<Component const> > > vec = cached_components<Component>(true);
+  return Component::const_iterator(vec, vec->size());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
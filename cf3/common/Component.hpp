@@ -13,6 +13,11 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <cstring>
+#include <map>
+#include <typeinfo>
+#include <vector>
+
 #include <boost/version.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
@@ -145,6 +150,14 @@ public: // functions
   /// Access the name of the component
   const std::string& name () const { return m_name; }
 
+  /// Number that identifies this component within the process. It is assigned at construction and never reused,
+  /// so it is a cheaper key than the uri() when storing data per component.
+  Uint id () const { return m_id; }
+
+  /// Counter that is incremented each time a component is added, removed or renamed in the subtree of this component.
+  /// Code that stores results derived from the subtree can compare it to know if they are still valid.
+  Uint tree_generation () const;
+
   /// Rename the component
   void rename ( const std::string& name );
 
@@ -159,7 +172,7 @@ public: // functions
   /// @post path statisfies URI::is_absolute()
   void complete_path ( URI& path ) const;
 
-  /// Looks for a component via its path
+  /// Looks for a component via its path. Results are cached per path until the tree this component belongs to changes.
   /// @param path to the component
   /// @return handle to component or null if it doesn't exist
   /// @warning the return type is non-const!!! ( same reasoning as for parent() )
@@ -397,6 +410,18 @@ public: // functions
   template<typename ComponentT>
   void put_components(std::vector< boost::shared_ptr<ComponentT const> >& vec, const bool recurse) const;
 
+  /// Shared list with the result of put_components. The list is cached until the subtree of this component
+  /// changes, so repeated searches don't walk the tree. The returned list is never modified.
+  /// The cache is protected by a mutex, so searches may run from several threads as long as the tree itself is not modified concurrently.
+  template<typename ComponentT>
+  boost::shared_ptr< const std::vector< boost::shared_ptr<ComponentT> > > cached_components(const bool recurse);
+
+  /// Shared list with the result of put_components. The list is cached until the subtree of this component
+  /// changes, so repeated searches don't walk the tree. The returned list is never modified.
+  /// The cache is protected by a mutex, so searches may run from several threads as long as the tree itself is not modified concurrently.
+  template<typename ComponentT>
+  boost::shared_ptr< const std::vector< boost::shared_ptr<ComponentT const> > > cached_components(const bool recurse) const;
+
 
 
 protected: // functions
@@ -408,6 +433,19 @@ private: // helper functions
   /// Modify the parent of this component
   void change_parent(Handle<Component> to_parent);
 
+  /// Invalidate the cached searches of this component and its parents, after a change in the tree
+  void tree_changed();
+
+  /// Get the cached list of the given type, filling it if needed
+  template<typename VectorT, typename ComponentT, typename ThisT>
+  static boost::shared_ptr<const VectorT> cached_components_impl(ThisT& self, const bool recurse);
+
+  /// Look up a cached list, returning null if it is not cached. Also returns the tree generation at the time of the lookup.
+  boost::shared_ptr<void> find_cached_components(const std::type_info& list_type, const bool recurse, Uint& generation) const;
+
+  /// Store a cached list, unless the tree generation changed since the given value
+  void store_cached_components(const std::type_info& list_type, const bool recurse, const boost::shared_ptr<void>& list, const Uint generation) const;
+
   /// insures the sub component has a unique name within this component
   std::string ensure_unique_name ( Component& subcomp );
 
@@ -434,6 +472,33 @@ private: // data
   CompLookupT m_component_lookup;
   /// pointer to parent, naked pointer because of static components
   Component* m_parent;
+  /// unique number of this component
+  Uint m_id;
+  /// incremented at each change in the subtree of this component
+  Uint m_tree_generation;
+
+  /// Compare type_info by name, since a type can have more than one type_info object when using shared libraries
+  struct TypeInfoLess
+  {
+    bool operator()(const std::type_info* a, const std::type_info* b) const { return std::strcmp(a->name(), b->name()) < 0; }
+  };
+
+  /// Lists of children and of the complete subtree for one component type, stored as std::vector< boost::shared_ptr<T> >
+  struct CachedComponents
+  {
+    boost::shared_ptr<void> children;
+    boost::shared_ptr<void> recursive;
+  };
+
+  /// cached searches, keyed by the type of the list. Cleared when the subtree changes.
+  typedef std::map<const std::type_info*, CachedComponents, TypeInfoLess> ComponentsCacheT;
+  mutable ComponentsCacheT m_components_cache;
+  /// cached results of access_component
+  mutable std::map<std::string, Handle<Component> > m_path_cache;
+  /// ID of the root of the tree at the time m_path_cache was filled
+  mutable Uint m_path_cache_root_id;
+  /// tree generation of that root at the time m_path_cache was filled
+  mutable Uint m_path_cache_generation;
 
 protected: // functions
 
@@ -524,6 +589,35 @@ inline void Component::put_components<Component>(std::vector<boost::shared_ptr<C
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+template<typename VectorT, typename ComponentT, typename ThisT>
+inline boost::shared_ptr<const VectorT> Component::cached_components_impl(ThisT& self, const bool recurse)
+{
+  Uint generation = 0;
+  boost::shared_ptr<void> list = self.find_cached_components(typeid(VectorT), recurse, generation);
+  if(!list)
+  {
+    boost::shared_ptr<VectorT> result(new VectorT());
+    self.template put_components<ComponentT>(*result, recurse);
+    list = result;
+    self.store_cached_components(typeid(VectorT), recurse, list, generation);
+  }
+  return boost::static_pointer_cast<const VectorT>(list);
+}
+
+template<typename ComponentT>
+inline boost::shared_ptr< const std::vector< boost::shared_ptr<ComponentT> > > Component::cached_components(const bool recurse)
+{
+  return cached_components_impl< std::vector< boost::shared_ptr<ComponentT> >, ComponentT >(*this, recurse);
+}
+
+template<typename ComponentT>
+inline boost::shared_ptr< const std::vector< boost::shared_ptr<ComponentT const> > > Component::cached_components(const bool recurse) const
+{
+  return cached_components_impl< std::vector< boost::shared_ptr<ComponentT const> >, ComponentT >(*this, recurse);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 /// Create a component by providing the name of its builder
 /// No factory name is needed, so no factories are used (also no auto-loading of factory).
 /// Component is built directly from the builder.
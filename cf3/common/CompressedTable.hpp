@@ -0,0 +1,262 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_CompressedTable_hpp
+#define cf3_common_CompressedTable_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <numeric>
+
+#include <boost/range/iterator_range.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/Component.hpp"
+#include "common/StringConversion.hpp"
+#include "common/Foreach.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+class CompressedTableBufferT;
+
+/// Component holding a table with variable row-size per row, in compressed row storage.
+/// All values are stored contiguously, and an offsets array of size()+1 entries
+/// marks the start of each row. Compared to DynTable, this avoids one allocation per row.
+/// Changing the size of a single row is expensive, so tables are best filled by first setting
+/// all row sizes (set_row_sizes), or by appending rows through a Buffer.
+/// @note T can't be bool, since the rows are ranges of pointers into a std::vector<T>
+template<typename T>
+class CompressedTable : public common::Component {
+
+public:
+
+  typedef std::vector<T> ValuesT;
+  typedef std::vector<Uint> OffsetsT;
+  typedef CompressedTableBufferT<T> Buffer;
+  typedef boost::iterator_range<T*> Row;
+  typedef boost::iterator_range<const T*> ConstRow;
+
+  /// Contructor
+  /// @param name of the component
+  CompressedTable ( const std::string& name ) : Component(name), m_offsets(1, 0u) { }
+
+  ~CompressedTable () {}
+
+  /// Get the class name
+  static std::string type_name () { return "CompressedTable<"+common::class_name<T>()+">"; }
+
+  /// Number of rows
+  Uint size() const { return m_offsets.size() - 1; }
+
+  /// Total number of values, summed over all rows
+  Uint nb_values() const { return m_values.size(); }
+
+  /// Change the number of rows. Added rows are empty.
+  void resize(const Uint new_size)
+  {
+    if(new_size < size())
+      m_values.resize(m_offsets[new_size]);
+    m_offsets.resize(new_size+1, m_offsets.back());
+  }
+
+  /// Remove all rows
+  void clear()
+  {
+    m_offsets.assign(1, 0u);
+    m_values.clear();
+  }
+
+  Uint row_size(const Uint i) const { return m_offsets[i+1] - m_offsets[i]; }
+
+  /// Change the size of a single row. This moves all values of the following rows.
+  void set_row_size(const Uint i, const Uint s)
+  {
+    const Uint old_size = row_size(i);
+    if(s == old_size)
+      return;
+
+    if(s > old_size)
+      m_values.insert(m_values.begin() + m_offsets[i+1], s - old_size, T());
+    else
+      m_values.erase(m_values.begin() + m_offsets[i] + s, m_values.begin() + m_offsets[i+1]);
+
+    const Uint nb_rows = size();
+    for(Uint j = i+1; j <= nb_rows; ++j)
+      m_offsets[j] = m_offsets[j] + s - old_size;
+  }
+
+  /// Resize the table to sizes.size() rows, where row i has size sizes[i].
+  /// Existing values are discarded.
+  template<typename VectorT>
+  void set_row_sizes(const VectorT& sizes)
+  {
+    m_offsets.resize(sizes.size()+1);
+    m_offsets[0] = 0;
+    std::partial_sum(sizes.begin(), sizes.end(), m_offsets.begin()+1);
+    m_values.assign(m_offsets.back(), T());
+  }
+
+  Buffer create_buffer(const size_t buffersize=16384)
+  {
+    return Buffer(*this,buffersize);
+  }
+
+  boost::shared_ptr<Buffer> create_buffer_ptr(const size_t buffersize=16384)
+  {
+    return boost::shared_ptr<Buffer> ( new Buffer (*this,buffersize) );
+  }
+
+  template<typename VectorT>
+  void set_row(const Uint array_idx, const VectorT& row)
+  {
+    if (row.size() != row_size(array_idx))
+      set_row_size(array_idx, row.size());
+
+    Uint j=m_offsets[array_idx];
+    boost_foreach( const typename VectorT::value_type& v, row)
+      m_values[j++] = v;
+  }
+
+  Row operator[] (const Uint idx)
+  {
+    cf3_assert(idx < size());
+    T* begin = values_begin();
+    return Row(begin + m_offsets[idx], begin + m_offsets[idx+1]);
+  }
+
+  ConstRow operator[] (const Uint idx) const
+  {
+    cf3_assert(idx < size());
+    const T* begin = values_begin();
+    return ConstRow(begin + m_offsets[idx], begin + m_offsets[idx+1]);
+  }
+
+  /// @return The start of each row, with one extra entry marking the end of the last row
+  OffsetsT& offsets() { return m_offsets; }
+
+  /// @return The start of each row, with one extra entry marking the end of the last row
+  const OffsetsT& offsets() const { return m_offsets; }
+
+  /// @return The values of all rows, stored contiguously
+  ValuesT& values() { return m_values; }
+
+  /// @return The values of all rows, stored contiguously
+  const ValuesT& values() const { return m_values; }
+
+private: // functions
+
+  T* values_begin() { return m_values.empty() ? 0 : &m_values[0]; }
+  const T* values_begin() const { return m_values.empty() ? 0 : &m_values[0]; }
+
+private: // data
+
+  /// Start of each row in m_values
+  OffsetsT m_offsets;
+
+  /// Values of all rows
+  ValuesT m_values;
+
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
+std::ostream& operator<<(std::ostream& os, CompressedTable<Uint>::ConstRow row);
+std::ostream& operator<<(std::ostream& os, CompressedTable<int>::ConstRow row);
+std::ostream& operator<<(std::ostream& os, CompressedTable<Real>::ConstRow row);
+std::ostream& operator<<(std::ostream& os, CompressedTable<std::string>::ConstRow row);
+
+std::ostream& operator<<(std::ostream& os, const CompressedTable<Uint>& table);
+std::ostream& operator<<(std::ostream& os, const CompressedTable<int>& table);
+std::ostream& operator<<(std::ostream& os, const CompressedTable<Real>& table);
+std::ostream& operator<<(std::ostream& os, const CompressedTable<std::string>& table);
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Buffer to append rows to a CompressedTable. Rows are collected in a separate
+/// compressed storage and appended to the table in one go when flush() is called,
+/// or when the buffer is destroyed.
+template <typename T>
+class CompressedTableBufferT
+{
+public:
+
+  CompressedTableBufferT(CompressedTable<T>& table, const size_t nb_values) :
+    m_table(table),
+    m_offsets(1, 0u)
+  {
+    m_values.reserve(nb_values);
+  }
+
+  ~CompressedTableBufferT()
+  {
+    flush();
+  }
+
+  /// Add a row, returning the index it will have in the table after flushing
+  template <typename VectorT>
+  Uint add_row(const VectorT& row)
+  {
+    boost_foreach( const typename VectorT::value_type& v, row)
+      m_values.push_back(v);
+    m_offsets.push_back(m_values.size());
+    return m_table.size() + m_offsets.size() - 2;
+  }
+
+  /// Number of rows waiting to be flushed
+  Uint size() const { return m_offsets.size() - 1; }
+
+  /// Discard all rows that were not flushed yet
+  void reset()
+  {
+    m_offsets.assign(1, 0u);
+    m_values.clear();
+  }
+
+  /// Append the buffered rows to the table
+  void flush()
+  {
+    if(size() == 0)
+      return;
+
+    typename CompressedTable<T>::OffsetsT& offsets = m_table.offsets();
+    typename CompressedTable<T>::ValuesT& values = m_table.values();
+
+    const Uint values_start = values.size();
+    values.insert(values.end(), m_values.begin(), m_values.end());
+
+    offsets.reserve(offsets.size() + size());
+    for(Uint i = 1; i != m_offsets.size(); ++i)
+      offsets.push_back(values_start + m_offsets[i]);
+
+    reset();
+  }
+
+private:
+
+  /// reference to the table the buffer works on
+  CompressedTable<T>& m_table;
+
+  /// Start of each buffered row in m_values
+  std::vector<Uint> m_offsets;
+
+  /// Values of the buffered rows
+  std::vector<T> m_values;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_CompressedTable_hpp
@@ -12,6 +12,7 @@
 #include "common/Log.hpp"
 #include "common/Environment.hpp"
 #include "common/PropertyList.hpp"
+#include "common/Tracer.hpp"
 
 namespace cf3 {
 namespace common {
@@ -102,6 +103,28 @@ Environment::Environment ( const std::string& name) : Component ( name )
       .mark_basic()
       .attach_trigger(boost::bind(&Environment::trigger_log_level,this));
 
+  options().add("asynchronous_log", false)
+      .pretty_name("Asynchronous Log")
+      .description("If true, log output to the screen and log files is written by a background thread, and repeated identical lines are aggregated.")
+      .mark_basic()
+      .attach_trigger(boost::bind(&Environment::trigger_asynchronous_log,this));
+
+  options().add("binary_log_files", false)
+      .pretty_name("Binary Log Files")
+      .description("If true and the log is asynchronous, log files are written as binary records with rank and time stamp.")
+      .attach_trigger(boost::bind(&Environment::trigger_asynchronous_log,this));
+
+  options().add("tracing", Tracer::instance().is_enabled())
+      .pretty_name("Tracing")
+      .description("If true, the execution of actions is recorded by the Tracer, for output with PrintTimingTree")
+      .mark_basic()
+      .attach_trigger(boost::bind(&Environment::trigger_tracing,this));
+
+  options().add("trace_buffer_size", Tracer::instance().buffer_size())
+      .pretty_name("Trace Buffer Size")
+      .description("Maximum number of trace events kept per thread. Older events are discarded when the buffer is full.")
+      .attach_trigger(boost::bind(&Environment::trigger_trace_buffer_size,this));
+
   trigger_log_level();
 
   // signals
@@ -180,5 +203,26 @@ void Environment::trigger_log_level()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Environment::trigger_asynchronous_log()
+{
+  Logger::instance().set_asynchronous(options().value<bool>("asynchronous_log"), options().value<bool>("binary_log_files"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Environment::trigger_tracing()
+{
+  Tracer::instance().enable(options().value<bool>("tracing"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Environment::trigger_trace_buffer_size()
+{
+  Tracer::instance().set_buffer_size(options().value<Uint>("trace_buffer_size"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // common
 } // cf3
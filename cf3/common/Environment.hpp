@@ -51,6 +51,12 @@ private: // functions
 
   void trigger_log_level();
 
+  void trigger_asynchronous_log();
+
+  void trigger_tracing();
+
+  void trigger_trace_buffer_size();
+
 }; // Environment
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -74,36 +74,36 @@ struct ComponentIteratorSelector {
           type;
 };
 
+/// Shared list of components of type ComponentT below ParentT, constness determined by the constness of ParentT
+template<typename ParentT, typename ComponentT=Component>
+struct ComponentListPtr {
+  typedef boost::shared_ptr< const std::vector< typename ComponentPtr<ParentT,ComponentT>::type > > type;
+};
+
 template<typename ComponentT, typename ParentT>
 inline typename ComponentIteratorSelector<ParentT,ComponentT>::type component_begin(ParentT& component)
 {
-  std::vector< typename ComponentPtr<ParentT,ComponentT>::type > vec;
-  component.template put_components<ComponentT>(vec, false); // not recursive
-  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, 0); // begin
+  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(component.template cached_components<ComponentT>(false), 0); // begin
 }
 
 template<typename ComponentT, typename ParentT>
 inline typename ComponentIteratorSelector<ParentT,ComponentT>::type component_end(ParentT& component)
 {
-  std::vector< typename ComponentPtr<ParentT,ComponentT>::type > vec;
-  component.template put_components<ComponentT>(vec, false);  // not recursive
-  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, vec.size()); // end
+  const typename ComponentListPtr<ParentT,ComponentT>::type vec = component.template cached_components<ComponentT>(false); // not recursive
+  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, vec->size()); // end
 }
 
 template<typename ComponentT, typename ParentT>
 inline typename ComponentIteratorSelector<ParentT,ComponentT>::type component_recursive_begin(ParentT& component)
 {
-  std::vector< typename ComponentPtr<ParentT,ComponentT>::type > vec;
-  component.template put_components<ComponentT>(vec, true); // recursive
-  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, 0); // begin
+  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(component.template cached_components<ComponentT>(true), 0); // begin
 }
 
 template<typename ComponentT, typename ParentT>
 inline typename ComponentIteratorSelector<ParentT,ComponentT>::type component_recursive_end(ParentT& component)
 {
-  std::vector< typename ComponentPtr<ParentT,ComponentT>::type > vec;
-  component.template put_components<ComponentT>(vec, true); // recursive
-  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, vec.size()); // end
+  const typename ComponentListPtr<ParentT,ComponentT>::type vec = component.template cached_components<ComponentT>(true); // recursive
+  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, vec->size()); // end
 }
 
 ////////////////////////////////////////////////////////////////////////////////
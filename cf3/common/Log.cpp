@@ -6,6 +6,7 @@
 
 #define BOOST_SELECT_BY_SIZE_MAX_CASE 20
 
+#include <boost/bind.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/device/file.hpp>
 
@@ -22,6 +23,7 @@
 #include "common/Core.hpp"
 #include "common/Environment.hpp"
 #include "common/Log.hpp"
+#include "common/LogAsyncWriter.hpp"
 #include "common/PE/Comm.hpp"
 #include "common/OptionList.hpp"
 
@@ -36,7 +38,35 @@ namespace common {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Logger::Logger()
+namespace detail
+{
+
+void write_to_ostream(std::ostream* stream, const char* data, const std::streamsize size)
+{
+  stream->write(data, size);
+}
+
+void flush_ostream(std::ostream* stream)
+{
+  stream->flush();
+}
+
+void write_to_file(iostreams::file_descriptor_sink file, const char* data, const std::streamsize size)
+{
+  file.write(data, size);
+}
+
+void no_flush()
+{
+}
+
+} // detail
+
+//////////////////////////////////////////////////////////////////////////////
+
+Logger::Logger() :
+  m_file_open(false),
+  m_binary_files(false)
 {
   // streams initialization
   m_streams[ERROR]   = new LogStream("Error",   ERROR);
@@ -56,6 +86,9 @@ Logger::~Logger()
 
   for(it = m_streams.begin() ; it != m_streams.end() ; it++)
     delete it->second;
+
+  // Writes what is left in the queue
+  m_async_writer.reset();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -136,6 +169,16 @@ void Logger::openFiles()
     m_streams[ERROR]->setFile(fdLogFile);
     m_streams[WARNING]->setFile(fdLogFile);
     m_streams[DEBUG]->setFile(fdLogFile);
+
+    m_log_file = fdLogFile;
+    m_file_open = true;
+
+    if(is_not_null(m_async_writer.get()))
+    {
+      const Uint file_target = m_async_writer->add_target(boost::bind(detail::write_to_file, m_log_file, _1, _2), detail::no_flush, m_binary_files ? LogAsyncWriter::BINARY : LogAsyncWriter::TEXT, rank);
+      for(std::map<LogLevel, LogStream *>::iterator it = m_streams.begin() ; it != m_streams.end() ; it++)
+        it->second->setAsyncWriter(LogStream::FILE, m_async_writer.get(), file_target, it->first == ERROR);
+    }
   }
 }
 
@@ -151,5 +194,53 @@ void Logger::set_log_level(const Uint log_level)
 
 //////////////////////////////////////////////////////////////////////////////
 
+void Logger::set_asynchronous(const bool asynchronous, const bool binary_files)
+{
+  const bool was_asynchronous = is_not_null(m_async_writer.get());
+  if(asynchronous == was_asynchronous && binary_files == m_binary_files)
+    return;
+
+  std::map<LogLevel, LogStream *>::iterator it;
+
+  if(was_asynchronous)
+  {
+    for(it = m_streams.begin() ; it != m_streams.end() ; it++)
+    {
+      it->second->setAsyncWriter(LogStream::SCREEN, NULL);
+      it->second->setAsyncWriter(LogStream::FILE, NULL);
+    }
+    m_async_writer.reset();
+  }
+
+  m_binary_files = binary_files;
+
+  if(asynchronous)
+  {
+    m_async_writer.reset(new LogAsyncWriter());
+    connect_async_writer(binary_files);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Logger::connect_async_writer(const bool binary_files)
+{
+  const Uint rank = PE::Comm::instance().rank();
+  const Uint screen_target = m_async_writer->add_target(boost::bind(detail::write_to_ostream, &std::cout, _1, _2), boost::bind(detail::flush_ostream, &std::cout), LogAsyncWriter::TEXT, rank);
+  Uint file_target = 0;
+  if(m_file_open)
+    file_target = m_async_writer->add_target(boost::bind(detail::write_to_file, m_log_file, _1, _2), detail::no_flush, binary_files ? LogAsyncWriter::BINARY : LogAsyncWriter::TEXT, rank);
+
+  std::map<LogLevel, LogStream *>::iterator it;
+  for(it = m_streams.begin() ; it != m_streams.end() ; it++)
+  {
+    const bool blocking = it->first == ERROR;
+    it->second->setAsyncWriter(LogStream::SCREEN, m_async_writer.get(), screen_target, blocking);
+    it->second->setAsyncWriter(LogStream::FILE, m_async_writer.get(), file_target, blocking);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 } // common
 } // cf3
@@ -7,6 +7,8 @@
 #ifndef cf3_common_Log_hpp
 #define cf3_common_Log_hpp
 
+#include <boost/scoped_ptr.hpp>
+
 #include "common/CommonAPI.hpp"
 #include "common/LogLevel.hpp"
 #include "common/LogStream.hpp"
@@ -17,6 +19,7 @@
 namespace cf3 {
 namespace common {
 
+class LogAsyncWriter;
 class LogStream;
 
 /// @brief Main class of the logging system.
@@ -80,13 +83,40 @@ class Common_API Logger : public boost::noncopyable {
 
   void set_log_level(const Uint log_level);
 
+  /// @brief Writes the screen and file output of all streams on a background thread.
+
+  /// The error stream waits for its messages to be written, so errors are not lost
+  /// if the program aborts. Repeated identical lines are aggregated.
+  /// @param asynchronous If @c false, all streams write directly to their outputs again.
+  /// @param binary_files If @c true, the log files are written as binary records
+  /// (see LogAsyncWriter::BINARY). The screen output always remains text.
+  void set_asynchronous(const bool asynchronous, const bool binary_files = false);
+
+  /// @brief The background writer, or @c NULL if the output is synchronous
+  LogAsyncWriter * async_writer() { return m_async_writer.get(); }
+
   private :
 
+  /// @brief Sends the output of all streams to the background writer
+  void connect_async_writer(const bool binary_files);
+
   /// @brief Managed streams.
 
   /// The key is the stream type. The value is a pointer to the stream.
   std::map<LogLevel, LogStream *> m_streams;
 
+  /// @brief Background writer used when the output is asynchronous
+  boost::scoped_ptr<LogAsyncWriter> m_async_writer;
+
+  /// @brief The log file, if opened by @c #openFiles()
+  boost::iostreams::file_descriptor_sink m_log_file;
+
+  /// @brief True if @c #openFiles() opened a log file
+  bool m_file_open;
+
+  /// @brief True if the log file is written in the binary format
+  bool m_binary_files;
+
   /// @brief Constructor
   Logger();
 
@@ -0,0 +1,397 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <istream>
+
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/Foreach.hpp"
+#include "common/LogAsyncWriter.hpp"
+#include "common/StringConversion.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+class LogAsyncWriter::Implementation
+{
+public:
+  /// Queued data for one target
+  struct Chunk
+  {
+    Uint target;
+    Real time;
+    Uint begin;
+    Uint end;
+  };
+
+  /// Output state of a target, only used by the writer thread once the target is added
+  struct Target
+  {
+    WriteFunctionT write;
+    FlushFunctionT flush;
+    Format format;
+    Uint rank;
+
+    /// Start of a line that did not end yet
+    std::string partial_line;
+    Real partial_line_time;
+
+    /// Last complete line and the number of times it was repeated
+    std::string last_line;
+    Uint nb_repeats;
+  };
+
+  Implementation() :
+    epoch(boost::posix_time::microsec_clock::universal_time()),
+    aggregate_duplicates(true),
+    nb_aggregated(0),
+    max_queue_size(16*1024*1024),
+    nb_blocked_writes(0),
+    flush_requests(0),
+    flushes_done(0),
+    stop(false)
+  {
+    thread = boost::thread(boost::bind(&Implementation::run, this));
+  }
+
+  ~Implementation()
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(mutex);
+      stop = true;
+    }
+    queue_condition.notify_one();
+    thread.join();
+  }
+
+  Real now() const
+  {
+    return static_cast<Real>((boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds()) * 1e-6;
+  }
+
+  /// Writer thread main loop
+  void run()
+  {
+    std::vector<char> data;
+    std::vector<Chunk> chunks;
+    std::vector< boost::shared_ptr<Target> > current_targets;
+    while(true)
+    {
+      Uint flush_request;
+      bool stopping;
+      bool aggregate;
+      {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        // Wake up regularly, so output appears even if nobody flushes
+        while(queued_chunks.empty() && flush_requests == flushes_done && !stop)
+        {
+          if(!queue_condition.timed_wait(lock, boost::posix_time::milliseconds(100)))
+            break;
+        }
+        data.swap(queued_data);
+        chunks.swap(queued_chunks);
+        current_targets = targets;
+        flush_request = flush_requests;
+        stopping = stop;
+        aggregate = aggregate_duplicates;
+      }
+      // The queue is empty again, so blocked writers can continue
+      space_condition.notify_all();
+
+      const bool force = flush_request != flushes_done || stopping;
+      Uint nb_new_aggregated = 0;
+      if(force || !chunks.empty())
+        nb_new_aggregated = process(data, chunks, current_targets, aggregate, force);
+      data.clear();
+      chunks.clear();
+
+      {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        flushes_done = flush_request;
+        nb_aggregated += nb_new_aggregated;
+        if(stopping && queued_chunks.empty())
+          break;
+      }
+      flush_condition.notify_all();
+    }
+    flush_condition.notify_all();
+  }
+
+  /// Write the given chunks. If force is true, unfinished lines and pending repeat counts are written as well.
+  /// Returns the number of lines that were aggregated.
+  Uint process(const std::vector<char>& data, const std::vector<Chunk>& chunks, const std::vector< boost::shared_ptr<Target> >& current_targets, const bool aggregate, const bool force)
+  {
+    Uint nb_new_aggregated = 0;
+    boost_foreach(const Chunk& chunk, chunks)
+    {
+      Target& target = *current_targets[chunk.target];
+      Uint line_begin = chunk.begin;
+      for(Uint i = chunk.begin; i != chunk.end; ++i)
+      {
+        if(data[i] == '\n')
+        {
+          if(target.partial_line.empty())
+            target.partial_line_time = chunk.time;
+          target.partial_line.append(&data[line_begin], i - line_begin);
+          nb_new_aggregated += write_line(target, target.partial_line, target.partial_line_time, aggregate);
+          target.partial_line.clear();
+          line_begin = i+1;
+        }
+      }
+      if(line_begin != chunk.end)
+      {
+        if(target.partial_line.empty())
+          target.partial_line_time = chunk.time;
+        target.partial_line.append(&data[line_begin], chunk.end - line_begin);
+      }
+    }
+
+    boost_foreach(const boost::shared_ptr<Target>& target, current_targets)
+    {
+      if(force)
+      {
+        write_repeats(*target, now());
+        if(!target->partial_line.empty())
+        {
+          // The partial line is output as is, so the next message continues on the same line
+          write_raw(*target, target->partial_line, target->partial_line_time, false);
+          target->last_line.clear();
+          target->partial_line.clear();
+        }
+      }
+      target->flush();
+    }
+
+    return nb_new_aggregated;
+  }
+
+  /// Write a complete line, or count it if it repeats the previous one. Returns 1 if the line was aggregated.
+  Uint write_line(Target& target, const std::string& line, const Real time, const bool aggregate)
+  {
+    if(aggregate && !line.empty() && line == target.last_line)
+    {
+      ++target.nb_repeats;
+      return 1;
+    }
+
+    write_repeats(target, time);
+    write_raw(target, line, time, true);
+    target.last_line = line;
+    return 0;
+  }
+
+  /// Write a line with the number of repeats of the last line, if any
+  void write_repeats(Target& target, const Real time)
+  {
+    if(target.nb_repeats == 0)
+      return;
+
+    write_raw(target, "(previous message repeated " + to_str(target.nb_repeats) + " times)", time, true);
+    target.nb_repeats = 0;
+  }
+
+  void write_raw(Target& target, const std::string& line, const Real time, const bool end_line)
+  {
+    if(target.format == TEXT)
+    {
+      target.write(line.data(), line.size());
+      if(end_line)
+        target.write("\n", 1);
+      return;
+    }
+
+    const boost::uint32_t rank = target.rank;
+    const double record_time = time;
+    const boost::uint32_t size = line.size();
+    target.write(reinterpret_cast<const char*>(&rank), sizeof(rank));
+    target.write(reinterpret_cast<const char*>(&record_time), sizeof(record_time));
+    target.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    target.write(line.data(), line.size());
+  }
+
+  const boost::posix_time::ptime epoch;
+
+  /// Protects all data below, except for the contents of the targets
+  mutable boost::mutex mutex;
+  boost::condition_variable queue_condition;
+  boost::condition_variable flush_condition;
+  boost::condition_variable space_condition;
+
+  std::vector<char> queued_data;
+  std::vector<Chunk> queued_chunks;
+
+  /// The writer thread takes a copy of this list with each batch, and is the only one using the targets after they are added
+  std::vector< boost::shared_ptr<Target> > targets;
+
+  bool aggregate_duplicates;
+  Uint nb_aggregated;
+  Uint max_queue_size;
+  Uint nb_blocked_writes;
+  Uint flush_requests;
+  Uint flushes_done;
+  bool stop;
+
+  boost::thread thread;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogAsyncWriter::LogAsyncWriter() : m_implementation(new Implementation())
+{
+}
+
+LogAsyncWriter::~LogAsyncWriter()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint LogAsyncWriter::add_target(const WriteFunctionT& write, const FlushFunctionT& flush, const Format format, const Uint rank)
+{
+  boost::shared_ptr<Implementation::Target> target(new Implementation::Target());
+  target->write = write;
+  target->flush = flush;
+  target->format = format;
+  target->rank = rank;
+  target->partial_line_time = 0.;
+  target->nb_repeats = 0;
+
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  m_implementation->targets.push_back(target);
+  return m_implementation->targets.size() - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogAsyncWriter::write(const Uint target, const char* data, const std::streamsize size)
+{
+  const Real time = m_implementation->now();
+  boost::unique_lock<boost::mutex> lock(m_implementation->mutex);
+  cf3_assert(target < m_implementation->targets.size());
+  if(!m_implementation->queued_data.empty() && m_implementation->queued_data.size() + size > m_implementation->max_queue_size)
+  {
+    ++m_implementation->nb_blocked_writes;
+    m_implementation->queue_condition.notify_one();
+    while(!m_implementation->queued_data.empty() && m_implementation->queued_data.size() + size > m_implementation->max_queue_size)
+      m_implementation->space_condition.wait(lock);
+  }
+  Implementation::Chunk chunk;
+  chunk.target = target;
+  chunk.time = time;
+  chunk.begin = m_implementation->queued_data.size();
+  m_implementation->queued_data.insert(m_implementation->queued_data.end(), data, data + size);
+  chunk.end = m_implementation->queued_data.size();
+  m_implementation->queued_chunks.push_back(chunk);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogAsyncWriter::flush()
+{
+  boost::unique_lock<boost::mutex> lock(m_implementation->mutex);
+  const Uint request = ++m_implementation->flush_requests;
+  m_implementation->queue_condition.notify_one();
+  while(m_implementation->flushes_done < request)
+    m_implementation->flush_condition.wait(lock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogAsyncWriter::set_aggregate_duplicates(const bool aggregate)
+{
+  flush();
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  m_implementation->aggregate_duplicates = aggregate;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint LogAsyncWriter::nb_aggregated() const
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  return m_implementation->nb_aggregated;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogAsyncWriter::set_max_queue_size(const Uint max_size)
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  m_implementation->max_queue_size = max_size;
+  m_implementation->space_condition.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint LogAsyncWriter::nb_blocked_writes() const
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  return m_implementation->nb_blocked_writes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<LogRecord> LogAsyncWriter::read_binary(std::istream& input)
+{
+  std::vector<LogRecord> result;
+  while(true)
+  {
+    boost::uint32_t rank, size;
+    double time;
+    input.read(reinterpret_cast<char*>(&rank), sizeof(rank));
+    if(input.gcount() == 0)
+      break;
+    input.read(reinterpret_cast<char*>(&time), sizeof(time));
+    input.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if(!input)
+      throw FileFormatError(FromHere(), "Truncated binary log record header");
+
+    LogRecord record;
+    record.rank = rank;
+    record.time = time;
+    record.message.resize(size);
+    if(size != 0)
+      input.read(&record.message[0], size);
+    if(!input)
+      throw FileFormatError(FromHere(), "Truncated binary log record");
+    result.push_back(record);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogAsyncSink::LogAsyncSink(LogAsyncWriter& writer, const Uint target, const bool blocking) :
+  m_writer(&writer),
+  m_target(target),
+  m_blocking(blocking)
+{
+}
+
+std::streamsize LogAsyncSink::write(const char* s, std::streamsize n)
+{
+  m_writer->write(m_target, s, n);
+  if(m_blocking)
+    m_writer->flush();
+  return n;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
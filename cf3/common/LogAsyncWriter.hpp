@@ -0,0 +1,156 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_LogAsyncWriter_hpp
+#define cf3_common_LogAsyncWriter_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iosfwd>
+
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/iostreams/categories.hpp>
+
+#include "common/CF.hpp"
+#include "common/CommonAPI.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief A single log line, as stored in the binary log format
+struct Common_API LogRecord
+{
+  /// Rank that wrote the line
+  Uint rank;
+
+  /// Time at which the line was queued, in seconds since the writer was created
+  Real time;
+
+  /// The line, without the end of line character
+  std::string message;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Writes log output on a background thread
+
+/// Log streams only copy their messages into a queue, so the calling thread does not wait
+/// on the file system or the terminal. The background thread writes the queued data in batches,
+/// one line at a time. The queue is bounded: a write that would make it exceed the maximum size
+/// waits until the writer thread has taken the queued data, so a thread that logs faster than the
+/// output can handle is slowed down instead of exhausting the memory.
+///
+/// Consecutive identical lines to the same target can be aggregated into a single line followed by
+/// a repeat count. Each rank has its own writer, so this only collapses the repeats within the output
+/// of one rank. Identical lines from different ranks are not aggregated: that would need communication
+/// between the ranks, which the writer thread does not do.
+/// Targets are registered using functions to write and flush the actual output.
+class Common_API LogAsyncWriter : public boost::noncopyable
+{
+public:
+
+  /// @brief Output format of a target
+  enum Format
+  {
+    /// @brief Plain text, as written by a synchronous log stream
+    TEXT,
+
+    /// @brief Binary records, each consisting of the rank (32 bit unsigned integer), the time (double),
+    /// the message length (32 bit unsigned integer) and the message characters. Integers and doubles are
+    /// stored in the native byte order. Use read_binary to read them back.
+    BINARY
+  };
+
+  typedef boost::function<void (const char*, const std::streamsize)> WriteFunctionT;
+  typedef boost::function<void ()> FlushFunctionT;
+
+  /// @brief Constructor. Starts the writer thread.
+  LogAsyncWriter();
+
+  /// @brief Destructor. Writes all queued data and stops the writer thread.
+  ~LogAsyncWriter();
+
+  /// @brief Registers a new output target
+  /// @param write Function that writes to the target. Only called from the writer thread.
+  /// @param flush Function that flushes the target after each batch. Only called from the writer thread.
+  /// @param format Output format for the target
+  /// @param rank Rank that is stored in binary records
+  /// @return The index of the new target, to be used in write
+  Uint add_target(const WriteFunctionT& write, const FlushFunctionT& flush, const Format format, const Uint rank = 0);
+
+  /// @brief Queues data for output to the given target. Waits if the queue is full.
+  /// Must not be called from the write or flush functions of a target.
+  void write(const Uint target, const char* data, const std::streamsize size);
+
+  /// @brief Waits until all data queued up to now is written and the targets are flushed
+  void flush();
+
+  /// @brief If true, consecutive identical lines to the same target are only written once,
+  /// followed by a line with the number of repeats. Enabled by default.
+  void set_aggregate_duplicates(const bool aggregate);
+
+  /// @brief Number of lines that were not written because they repeated the previous line
+  Uint nb_aggregated() const;
+
+  /// @brief Maximum number of bytes in the queue. A write that doesn't fit waits until the queue is
+  /// taken by the writer thread, unless the queue is empty. Defaults to 16 MiB.
+  void set_max_queue_size(const Uint max_size);
+
+  /// @brief Number of writes that had to wait because the queue was full
+  Uint nb_blocked_writes() const;
+
+  /// @brief Reads all records from a stream in the BINARY format
+  static std::vector<LogRecord> read_binary(std::istream& input);
+
+private:
+
+  /// Contains the queue and the writer thread
+  class Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
+
+}; // class LogAsyncWriter
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Boost iostreams sink that queues its output on a LogAsyncWriter
+
+/// Used as the device at the end of the filter chain of an asynchronous log destination.
+class Common_API LogAsyncSink
+{
+public:
+
+  typedef char char_type;
+  typedef boost::iostreams::sink_tag category;
+
+  /// @param writer The writer that outputs the data
+  /// @param target Target index, as returned by LogAsyncWriter::add_target
+  /// @param blocking If true, each write waits until the data is output. This keeps the order with
+  /// the messages that other streams sent to the same writer.
+  LogAsyncSink(LogAsyncWriter& writer, const Uint target, const bool blocking = false);
+
+  std::streamsize write(const char* s, std::streamsize n);
+
+private:
+
+  LogAsyncWriter* m_writer;
+  Uint m_target;
+  bool m_blocking;
+
+}; // class LogAsyncSink
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_LogAsyncWriter_hpp
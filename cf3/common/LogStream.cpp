@@ -7,7 +7,9 @@
 #include <iostream>
 
 #include "common/PE/Comm.hpp"
+#include "common/BasicExceptions.hpp"
 #include "common/Log.hpp"
+#include "common/LogAsyncWriter.hpp"
 #include "common/LogStream.hpp"
 #include "common/LogLevelFilter.hpp"
 #include "common/LogStampFilter.hpp"
@@ -318,12 +320,37 @@ void LogStream::setFile(const iostreams::file_descriptor_sink & fileDescr)
     stream->push(fileDescr);
 
     m_destinations[FILE] = stream;
+    m_file = fileDescr;
   }
 }
 
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
+void LogStream::setAsyncWriter(LogDestination destination, LogAsyncWriter * writer, Uint target, bool blocking)
+{
+  if(destination != SCREEN && destination != FILE)
+    throw NotSupported(FromHere(), "Only the SCREEN and FILE log destinations can be asynchronous");
+
+  if(destination == FILE && !this->isFileOpen())
+    return;
+
+  // Replace the device at the end of the filter chain
+  iostreams::filtering_ostream * stream = m_destinations[destination];
+  stream->strict_sync();
+  stream->pop();
+
+  if(writer != NULL)
+    stream->push(LogAsyncSink(*writer, target, blocking));
+  else if(destination == SCREEN)
+    stream->push(std::cout);
+  else
+    stream->push(m_file);
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
 LogLevelFilter & LogStream::getLevelFilter(LogDestination dest) const
 {
   return *m_destinations.find(dest)->second->component<LogLevelFilter>(0);
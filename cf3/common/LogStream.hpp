@@ -17,6 +17,7 @@ namespace cf3 {
 namespace common {
 
 class CodeLocation;
+class LogAsyncWriter;
 class LogToStream;
 class LogLevelFilter;
 class LogStampFilter;
@@ -248,6 +249,17 @@ class Common_API LogStream
   /// @param fileDescr The file descriptor.
   void setFile(const boost::iostreams::file_descriptor_sink & fileDescr);
 
+  /// @brief Sends the output of a destination through a background writer.
+
+  /// Only @c #SCREEN and @c #FILE can be asynchronous. If @c writer is @c NULL,
+  /// the destination writes directly to its output again. If @c destination
+  /// is @c #FILE but @c #isFileOpen() returns @c false, nothing is done.
+  /// @param destination The destination.
+  /// @param writer The writer, which must outlive its use by this stream.
+  /// @param target Target of the writer, as returned by LogAsyncWriter::add_target.
+  /// @param blocking If @c true, each flush waits until the output is written.
+  void setAsyncWriter(LogDestination destination, LogAsyncWriter * writer, Uint target = 0, bool blocking = false);
+
   /// @brief Cheks whether the file is set.
 
   /// @return Returns @c true if the file has already been set.
@@ -302,6 +314,9 @@ class Common_API LogStream
   /// @brief Buffer for @c #STRING destination
   std::string m_buffer;
 
+  /// @brief Device of the @c #FILE destination, kept to restore it after asynchronous output
+  boost::iostreams::file_descriptor_sink m_file;
+
   /// @brief Stream name
 
   /// This attribute is used on @c #FILE stream creation.
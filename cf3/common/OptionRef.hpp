@@ -0,0 +1,114 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+/// @file OptionRef.hpp
+
+#ifndef cf3_common_OptionRef_hpp
+#define cf3_common_OptionRef_hpp
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "common/Handle.hpp"
+#include "common/OptionList.hpp"
+
+namespace cf3 {
+namespace common {
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+/// Typed access to the value of an option, for use in code that runs often.
+/// The option is looked up by name and its value cast once, when binding. A trigger on the option
+/// refreshes the cached value each time the option changes, so reading it costs no map lookup or any_cast.
+/// Contrary to Option::link_to, this also works for options of other components, and the link is
+/// removed again when the OptionRef is destroyed or rebound.
+/// Triggers that were attached to the option before binding run before the value is refreshed.
+template<typename T>
+class OptionRef : boost::noncopyable
+{
+public:
+  /// Unbound reference
+  OptionRef() : m_value(), m_trigger_id(0)
+  {
+  }
+
+  /// Bind to the option with the given name
+  OptionRef(OptionList& options, const std::string& name) : m_value(), m_trigger_id(0)
+  {
+    bind(options, name);
+  }
+
+  ~OptionRef()
+  {
+    release();
+  }
+
+  /// Bind to the option with the given name, releasing any previous option
+  /// @throw CastingFailed if the option does not hold a T
+  void bind(OptionList& options, const std::string& name)
+  {
+    release();
+    m_option = Handle<Option>(options.option_ptr(name));
+    refresh();
+    m_trigger_id = m_option->attach_trigger_tracked(boost::bind(&OptionRef<T>::refresh, this));
+  }
+
+  /// Detach from the option, if it still exists
+  void release()
+  {
+    if(is_not_null(m_option))
+      m_option->detach_trigger(m_trigger_id);
+    m_option = Handle<Option>();
+  }
+
+  /// True if the reference is bound to an option that still exists
+  bool is_bound() const
+  {
+    return is_not_null(m_option);
+  }
+
+  /// The cached value of the option
+  const T& value() const
+  {
+    cf3_assert(is_bound());
+    return m_value;
+  }
+
+  /// The cached value of the option
+  operator const T&() const
+  {
+    return value();
+  }
+
+  /// Name of the bound option
+  std::string name() const
+  {
+    cf3_assert(is_bound());
+    return m_option->name();
+  }
+
+private:
+  /// Copy the value from the option
+  void refresh()
+  {
+    m_value = m_option->template value<T>();
+  }
+
+  Handle<Option> m_option;
+  T m_value;
+  Option::TriggerID m_trigger_id;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_OptionRef_hpp
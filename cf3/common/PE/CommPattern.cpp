@@ -51,7 +51,9 @@ CommPattern::CommPattern(const std::string& name): Component(name), m_gid(alloca
   m_sendCount(PE::Comm::instance().size(),0),
   m_sendMap(0),
   m_recvCount(PE::Comm::instance().size(),0),
-  m_recvMap(0)
+  m_recvMap(0),
+  m_communicator(MPI_COMM_NULL),
+  m_next_tag(0)
 {
   //self->regist_signal ( "update" , "Executes communication patterns on all the registered data.", "" ).connect ( boost::bind ( &CommPattern2::update, self, _1 ) );
   m_isUpToDate=false;
@@ -62,6 +64,8 @@ CommPattern::CommPattern(const std::string& name): Component(name), m_gid(alloca
 
 CommPattern::~CommPattern()
 {
+  free_exchanges();
+  if (m_communicator!=MPI_COMM_NULL && PE::Comm::instance().is_active()) MPI_Comm_free(&m_communicator);
   if (m_gid.get()!=nullptr) m_gid->remove_tag("gid_of_"+this->name());
 }
 
@@ -202,6 +206,10 @@ PECheckPoint(1000,"002");
 
 PECheckPoint(1000,"003");
 
+  // the persistent requests of the non-blocking synchronization are bound to the old pattern
+  free_exchanges();
+  if (m_communicator==MPI_COMM_NULL) MPI_CHECK_RESULT(MPI_Comm_dup,(PE::Comm::instance().communicator(),&m_communicator));
+
   // get stuff
   const CPint irank=(CPint)PE::Comm::instance().rank();
   const CPint nproc=(CPint)PE::Comm::instance().size();
@@ -566,6 +574,14 @@ void CommPattern::setup()
 
 void CommPattern::synchronize_all()
 {
+  if ( PE::Comm::instance().is_active() )
+  {
+    // all objects are in flight at the same time
+    begin_synchronize_all();
+    end_synchronize_all();
+    return;
+  }
+
   std::vector<unsigned char> sndbuf(1);
   std::vector<unsigned char> rcvbuf(1);
   BOOST_FOREACH( CommWrapper& pobj, find_components_recursively<CommWrapper>(*this) )
@@ -578,16 +594,21 @@ void CommPattern::synchronize_all()
 
 void CommPattern::synchronize( const std::string& name )
 {
-  std::vector<unsigned char> sndbuf(1);
-  std::vector<unsigned char> rcvbuf(1);
   Handle<CommWrapper> pobj(get_child(name));
-  synchronize_this(*pobj,sndbuf,rcvbuf);
+  synchronize(*pobj);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void CommPattern::synchronize( const CommWrapper& pobj )
 {
+  if ( PE::Comm::instance().is_active() )
+  {
+    begin_synchronize(pobj);
+    end_synchronize(pobj);
+    return;
+  }
+
   std::vector<unsigned char> sndbuf(1);
   std::vector<unsigned char> rcvbuf(1);
   synchronize_this(pobj,sndbuf,rcvbuf);
@@ -611,6 +632,168 @@ void CommPattern::synchronize_this( const CommWrapper& pobj, std::vector<unsigne
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void CommPattern::begin_synchronize( const CommWrapper& pobj )
+{
+  if ( !pobj.needs_update() )
+    return;
+
+  // without MPI there are no messages to overlap with
+  if ( !PE::Comm::instance().is_active() )
+  {
+    synchronize(pobj);
+    return;
+  }
+
+  Exchange& ex = exchange(pobj);
+  if (ex.in_progress) throw common::ShouldNotBeHere(FromHere(),"Synchronization of '" + pobj.name() + "' in commpattern '" + name() + "' was already started.");
+
+  if (!m_sendMap.empty()) pobj.pack(m_sendMap,&ex.sndbuf[0]);
+  if (!ex.requests.empty()) MPI_CHECK_RESULT(MPI_Startall,((int)ex.requests.size(),&ex.requests[0]));
+  ex.in_progress=true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::begin_synchronize( const std::string& name )
+{
+  Handle<CommWrapper> pobj(get_child(name));
+  begin_synchronize(*pobj);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::end_synchronize( const CommWrapper& pobj )
+{
+  if ( !pobj.needs_update() || !PE::Comm::instance().is_active() )
+    return;
+
+  std::map<Uint, Exchange>::iterator ex_it = m_exchanges.find(pobj.id());
+  if (ex_it == m_exchanges.end() || !ex_it->second.in_progress)
+    throw common::ShouldNotBeHere(FromHere(),"Synchronization of '" + pobj.name() + "' in commpattern '" + name() + "' was not started.");
+
+  Exchange& ex = ex_it->second;
+  if (!ex.requests.empty()) MPI_CHECK_RESULT(MPI_Waitall,((int)ex.requests.size(),&ex.requests[0],MPI_STATUSES_IGNORE));
+  ex.in_progress=false;
+  if (!m_recvMap.empty()) pobj.unpack(&ex.rcvbuf[0],m_recvMap);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::end_synchronize( const std::string& name )
+{
+  Handle<CommWrapper> pobj(get_child(name));
+  end_synchronize(*pobj);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::begin_synchronize_all()
+{
+  BOOST_FOREACH( CommWrapper& pobj, find_components_recursively<CommWrapper>(*this) )
+  {
+    begin_synchronize(pobj);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::end_synchronize_all()
+{
+  BOOST_FOREACH( CommWrapper& pobj, find_components_recursively<CommWrapper>(*this) )
+  {
+    end_synchronize(pobj);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+CommPattern::Exchange& CommPattern::exchange( const CommWrapper& pobj )
+{
+  const Uint item_size = pobj.size_of()*pobj.stride();
+  std::map<Uint, Exchange>::iterator ex_it = m_exchanges.find(pobj.id());
+  if (ex_it == m_exchanges.end())
+  {
+    // MPI guarantees at least 32767 tags, and the communicator is only used by this pattern
+    ex_it = m_exchanges.insert(std::make_pair(pobj.id(), Exchange())).first;
+    ex_it->second.tag = m_next_tag;
+    m_next_tag = (m_next_tag+1)%32767;
+  }
+  Exchange& ex = ex_it->second;
+  if (ex.item_size == item_size || ex.in_progress)
+    return ex;
+
+  // (re)create the persistent requests, with one message per neighbouring process
+  release_requests(ex);
+  ex.item_size=item_size;
+  ex.sndbuf.resize(m_sendMap.size()*item_size);
+  ex.rcvbuf.resize(m_recvMap.size()*item_size);
+
+  cf3_assert(m_communicator!=MPI_COMM_NULL || m_sendMap.size()+m_recvMap.size()==0);
+  const int tag=ex.tag;
+  const Uint nproc=PE::Comm::instance().size();
+  Uint recv_offset=0;
+  Uint send_offset=0;
+  for (Uint i=0; i<nproc; ++i)
+  {
+    const int recv_size=m_recvCount[i]*item_size;
+    if (recv_size!=0)
+    {
+      MPI_Request request;
+      MPI_CHECK_RESULT(MPI_Recv_init,(&ex.rcvbuf[recv_offset],recv_size,MPI_BYTE,(int)i,tag,m_communicator,&request));
+      ex.requests.push_back(request);
+      recv_offset+=recv_size;
+    }
+    const int send_size=m_sendCount[i]*item_size;
+    if (send_size!=0)
+    {
+      MPI_Request request;
+      MPI_CHECK_RESULT(MPI_Send_init,(&ex.sndbuf[send_offset],send_size,MPI_BYTE,(int)i,tag,m_communicator,&request));
+      ex.requests.push_back(request);
+      send_offset+=send_size;
+    }
+  }
+  return ex;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::release_requests( Exchange& ex )
+{
+  // requests can not be released after MPI was finalized
+  if (!ex.requests.empty() && PE::Comm::instance().is_active())
+  {
+    if (ex.in_progress) MPI_CHECK_RESULT(MPI_Waitall,((int)ex.requests.size(),&ex.requests[0],MPI_STATUSES_IGNORE));
+    BOOST_FOREACH( MPI_Request& request, ex.requests )
+      MPI_CHECK_RESULT(MPI_Request_free,(&request));
+  }
+  ex.requests.clear();
+  ex.in_progress=false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::free_exchange( const CommWrapper& pobj )
+{
+  std::map<Uint, Exchange>::iterator ex_it = m_exchanges.find(pobj.id());
+  if (ex_it == m_exchanges.end())
+    return;
+
+  release_requests(ex_it->second);
+  m_exchanges.erase(ex_it);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::free_exchanges()
+{
+  for (std::map<Uint, Exchange>::iterator ex_it = m_exchanges.begin(); ex_it != m_exchanges.end(); ++ex_it)
+    release_requests(ex_it->second);
+  m_exchanges.clear();
+  m_next_tag=0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void CommPattern::add_global(Uint gid, Uint rank)
 {
   // later a mechanism could be implemented when commpattern can give gids by calling a "reserve(int num)" beforehand, to optimize performance
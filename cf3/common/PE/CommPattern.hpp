@@ -7,6 +7,8 @@
 #ifndef cf3_common_PE_CommPattern_hpp
 #define cf3_common_PE_CommPattern_hpp
 
+#include <map>
+
 #include "common/Component.hpp"
 #include "common/BoostArray.hpp"
 #include "common/PE/Comm.hpp"
@@ -188,8 +190,10 @@ public:
   /// removes data by name
   void clear( const std::string& name)
   {
+    Handle<CommWrapper> pobj(get_child(name));
+    if (is_not_null(pobj))
+      free_exchange(*pobj);
     remove_component(name);
-    // anything to be deallocated?
   }
 
   //@} END DATA REGISTRATION
@@ -229,6 +233,32 @@ public:
   /// @param name the name of the parallel object
   void synchronize( const CommWrapper& pobj );
 
+  /// start synchronizing the parallel object, without waiting for the communication to finish
+  /// the updatable values are packed immediately, so they may be modified again right after this call
+  /// the ghost values must not be accessed until end_synchronize returns
+  /// beware: must be called for the same objects in the same order on all processes, since the message tag of an object
+  /// is assigned when it is first started after setup
+  /// @param pobj the parallel object
+  void begin_synchronize( const CommWrapper& pobj );
+
+  /// start synchronizing the parallel object designated by its name
+  /// @param name the name of the parallel object
+  void begin_synchronize( const std::string& name );
+
+  /// wait for the synchronization started by begin_synchronize and store the received ghost values
+  /// @param pobj the parallel object
+  void end_synchronize( const CommWrapper& pobj );
+
+  /// wait for the synchronization of the parallel object designated by its name
+  /// @param name the name of the parallel object
+  void end_synchronize( const std::string& name );
+
+  /// start synchronizing all parallel objects
+  void begin_synchronize_all();
+
+  /// wait for the synchronization of all parallel objects
+  void end_synchronize_all();
+
   /// add element to the commpattern
   /// when all changes done, all needs to be committed by calling setup
   /// if global id is not on current rank, then a ghost is automatically created on current rank
@@ -297,6 +327,40 @@ protected: // helper function
 
 private:
 
+  /// buffers and persistent requests for the non-blocking synchronization of one parallel object
+  /// they are kept between calls and only rebuilt when the pattern or the object size changes
+  struct Exchange
+  {
+    Exchange() : item_size(0), tag(0), in_progress(false) {}
+    std::vector<unsigned char> sndbuf;
+    std::vector<unsigned char> rcvbuf;
+    std::vector<MPI_Request> requests;
+    Uint item_size;
+    int tag;
+    bool in_progress;
+  };
+
+  /// get the exchange for the given object, (re)creating the persistent requests if needed
+  Exchange& exchange( const CommWrapper& pobj );
+
+  /// release the persistent requests of an exchange, waiting for it to finish if needed
+  void release_requests( Exchange& ex );
+
+  /// release the persistent requests of the given object
+  void free_exchange( const CommWrapper& pobj );
+
+  /// release the persistent requests of all objects, needed when the pattern changes
+  void free_exchanges();
+
+  /// exchanges of the objects, by component id, which unlike the address is never reused for another object
+  std::map<Uint, Exchange> m_exchanges;
+
+  /// private duplicate of the communicator, so the messages of the exchanges can't match any other message
+  MPI_Comm m_communicator;
+
+  /// tag for the next exchange that is created, exchanges get sequential tags in the order they are first started
+  int m_next_tag;
+
   /// @name PROPERTIES
   //@{
 
@@ -298,13 +298,28 @@ class CommWrapperMArray<T,2>: public CommWrapper{
     /// @return pointer to data
     void* start_view()
     {
+      // Column-major arrays are not stored row by row, so the view is a copy
+      if(is_column_major())
+        return const_cast<void*>(pack());
       return (void*)&(*m_data)[0][0];
     }
 
     /// Finalizes view to the raw data held by the class wrapped by the commwrapper.
     /// @warning if the underlying data is not linear the data is copied back, therefore performance is degraded
     /// @param data pointer to the data
-    void end_view(void* data) { return; }
+    void end_view(void* data)
+    {
+      if(is_column_major())
+      {
+        unpack(data);
+        delete[] (T*)data;
+      }
+    }
+
+    bool is_column_major() const
+    {
+      return m_data->storage_order() == boost::general_storage_order<2>(boost::fortran_storage_order());
+    }
 
   private:
 
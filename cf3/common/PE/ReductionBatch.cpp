@@ -0,0 +1,239 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <map>
+
+#include "common/Assertions.hpp"
+#include "common/BasicExceptions.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/datatype.hpp"
+#include "common/PE/ReductionBatch.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+namespace PE {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+/// MPI operation on a complete batch buffer. The first value is the number of sums, which are
+/// added, and the remaining values are maxima. The batch is a single element of a contiguous
+/// datatype, so MPI can not split it, and the buffer length follows from the datatype size.
+void reduce_batch(void* in_, void* out_, int* len, Datatype* type)
+{
+  int type_size;
+  MPI_Type_size(*type, &type_size);
+  const int nb_values = type_size / sizeof(Real);
+
+  const Real* in = static_cast<const Real*>(in_);
+  Real* out = static_cast<Real*>(out_);
+  for(int i = 0; i != *len; ++i, in += nb_values, out += nb_values)
+  {
+    const int sums_end = 1 + static_cast<int>(in[0]);
+    for(int j = 1; j != sums_end; ++j)
+      out[j] += in[j];
+    for(int j = sums_end; j != nb_values; ++j)
+      out[j] = in[j] > out[j] ? in[j] : out[j];
+  }
+}
+
+/// Registered once, like the custom operations from operations.hpp
+Operation batch_operation()
+{
+  static Operation op((Operation)nullptr);
+  if(op == (Operation)nullptr)
+    MPI_CHECK_RESULT(MPI_Op_create, (reduce_batch, true, &op));
+  return op;
+}
+
+/// Contiguous datatype for a batch of nb_values Reals. Committed once for each size that is used.
+Datatype batch_datatype(const int nb_values)
+{
+  static std::map<int, Datatype> types;
+  std::map<int, Datatype>::iterator found = types.find(nb_values);
+  if(found != types.end())
+    return found->second;
+
+  Datatype type;
+  MPI_CHECK_RESULT(MPI_Type_contiguous, (nb_values, get_mpi_datatype<Real>(Real()), &type));
+  MPI_CHECK_RESULT(MPI_Type_commit, (&type));
+  types[nb_values] = type;
+  return type;
+}
+
+} // detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+ReductionBatch::ReductionBatch() :
+  m_pending(false),
+  m_has_results(false),
+  m_request_active(false)
+{
+}
+
+ReductionBatch::~ReductionBatch()
+{
+  if(m_request_active && Comm::instance().is_active())
+    MPI_Wait(&m_request, MPI_STATUS_IGNORE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint ReductionBatch::add_sum(const Real value)
+{
+  return add(SUM, &value, 1);
+}
+
+Uint ReductionBatch::add_sum(const Real* values, const Uint nb_values)
+{
+  return add(SUM, values, nb_values);
+}
+
+Uint ReductionBatch::add_min(const Real value)
+{
+  return add(MIN, &value, 1);
+}
+
+Uint ReductionBatch::add_min(const Real* values, const Uint nb_values)
+{
+  return add(MIN, values, nb_values);
+}
+
+Uint ReductionBatch::add_max(const Real value)
+{
+  return add(MAX, &value, 1);
+}
+
+Uint ReductionBatch::add_max(const Real* values, const Uint nb_values)
+{
+  return add(MAX, values, nb_values);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint ReductionBatch::add(const Kind kind, const Real* values, const Uint nb_values)
+{
+  if(m_pending)
+    throw SetupError(FromHere(), "Values can not be added to a ReductionBatch while it is reducing");
+
+  std::vector<Real>& kind_values = kind == SUM ? m_sums : (kind == MAX ? m_maxima : m_minima);
+  const Uint first = m_kinds.size();
+  for(Uint i = 0; i != nb_values; ++i)
+  {
+    m_kinds.push_back(kind);
+    m_positions.push_back(kind_values.size());
+    kind_values.push_back(values[i]);
+  }
+  m_has_results = false;
+  return first;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ReductionBatch::begin()
+{
+  if(m_pending)
+    throw SetupError(FromHere(), "ReductionBatch::begin called twice without end");
+
+  // Minima are reduced as maxima of the negated values, so a single operation handles everything
+  const Uint nb_sums = m_sums.size();
+  const Uint nb_maxima = m_maxima.size();
+  const Uint nb_values = 1 + nb_sums + nb_maxima + m_minima.size();
+  m_send_buffer.resize(nb_values);
+  m_receive_buffer.resize(nb_values);
+  m_send_buffer[0] = static_cast<Real>(nb_sums);
+  std::copy(m_sums.begin(), m_sums.end(), m_send_buffer.begin() + 1);
+  std::copy(m_maxima.begin(), m_maxima.end(), m_send_buffer.begin() + 1 + nb_sums);
+  for(Uint i = 0; i != m_minima.size(); ++i)
+    m_send_buffer[1 + nb_sums + nb_maxima + i] = -m_minima[i];
+
+  m_pending = true;
+  m_has_results = false;
+
+  if(!Comm::instance().is_active() || Comm::instance().size() == 1)
+  {
+    m_receive_buffer = m_send_buffer;
+    return;
+  }
+
+  const Datatype type = detail::batch_datatype(nb_values);
+#if MPI_VERSION >= 3
+  MPI_CHECK_RESULT(MPI_Iallreduce, (&m_send_buffer[0], &m_receive_buffer[0], 1, type, detail::batch_operation(), Comm::instance().communicator(), &m_request));
+  m_request_active = true;
+#else
+  MPI_CHECK_RESULT(MPI_Allreduce, (&m_send_buffer[0], &m_receive_buffer[0], 1, type, detail::batch_operation(), Comm::instance().communicator()));
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ReductionBatch::end()
+{
+  if(!m_pending)
+    throw SetupError(FromHere(), "ReductionBatch::end called without begin");
+
+  if(m_request_active)
+  {
+    m_request_active = false;
+    MPI_CHECK_RESULT(MPI_Wait, (&m_request, MPI_STATUS_IGNORE));
+  }
+
+  m_pending = false;
+  m_has_results = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ReductionBatch::execute()
+{
+  begin();
+  end();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Real ReductionBatch::result(const Uint idx) const
+{
+  if(!m_has_results)
+    throw SetupError(FromHere(), "ReductionBatch has no results, call execute or begin and end first");
+  cf3_assert(idx < m_kinds.size());
+
+  const Uint nb_sums = m_sums.size();
+  const Uint position = m_positions[idx];
+  switch(m_kinds[idx])
+  {
+    case SUM: return m_receive_buffer[1 + position];
+    case MAX: return m_receive_buffer[1 + nb_sums + position];
+    default:  return -m_receive_buffer[1 + nb_sums + m_maxima.size() + position];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ReductionBatch::clear()
+{
+  if(m_pending)
+    throw SetupError(FromHere(), "ReductionBatch can not be cleared while it is reducing");
+
+  m_kinds.clear();
+  m_positions.clear();
+  m_sums.clear();
+  m_maxima.clear();
+  m_minima.clear();
+  m_has_results = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // PE
+} // common
+} // cf3
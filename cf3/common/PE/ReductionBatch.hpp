@@ -0,0 +1,118 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_PE_ReductionBatch_hpp
+#define cf3_common_PE_ReductionBatch_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "common/CF.hpp"
+#include "common/CommonAPI.hpp"
+#include "common/PE/types.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+namespace PE {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Combines sums, minima and maxima of Real values into a single all_reduce
+///
+/// Code that would otherwise call all_reduce several times registers its local values
+/// using add_sum, add_min and add_max, which return the index of the first added value.
+/// begin() starts one reduction over all ranks, and after end() the global values are
+/// available through result(). The communication overlaps with the work done between begin()
+/// and end() if the MPI library has non-blocking collectives (MPI 3 or newer).
+/// All ranks must add the same kinds and numbers of values in the same order.
+/// clear() prepares the batch for the next phase, keeping the allocated memory.
+/// If the parallel environment is not active, the results are the local values.
+///
+/// The stop criteria of a solver::actions::Iterate loop share one batch per iteration, through
+/// solver::Criterion::contribute and solver::Criterion::collect. Other actions that reduce values
+/// still use their own batch or all_reduce.
+///
+/// Counts can be reduced as sums too: Real represents integers exactly up to 2^53.
+class Common_API ReductionBatch : public boost::noncopyable
+{
+public:
+
+  ReductionBatch();
+
+  /// Waits for a pending reduction
+  ~ReductionBatch();
+
+  /// @name Registration of local values. Not allowed between begin() and end().
+  //@{
+  Uint add_sum(const Real value);
+  Uint add_sum(const Real* values, const Uint nb_values);
+  Uint add_min(const Real value);
+  Uint add_min(const Real* values, const Uint nb_values);
+  Uint add_max(const Real value);
+  Uint add_max(const Real* values, const Uint nb_values);
+  //@}
+
+  /// Start the reduction of all registered values
+  void begin();
+
+  /// Wait for the reduction started by begin()
+  void end();
+
+  /// Reduce all registered values, equivalent to begin() followed by end()
+  void execute();
+
+  /// Global value for the given index, as returned by the add functions (plus the offset within an added array)
+  Real result(const Uint idx) const;
+
+  /// Number of registered values
+  Uint size() const { return m_kinds.size(); }
+
+  /// True between begin() and end()
+  bool is_pending() const { return m_pending; }
+
+  /// Remove all values and results
+  void clear();
+
+private:
+
+  enum Kind { SUM, MIN, MAX };
+
+  Uint add(const Kind kind, const Real* values, const Uint nb_values);
+
+  /// Kind of each registered value
+  std::vector<Kind> m_kinds;
+  /// Position of each registered value in the reduced buffer
+  std::vector<Uint> m_positions;
+
+  /// Local values for each kind, in the order they were added
+  std::vector<Real> m_sums;
+  std::vector<Real> m_maxima;
+  std::vector<Real> m_minima;
+
+  /// Send and receive buffers, laid out as the number of sums, the sums, the maxima and the negated minima
+  std::vector<Real> m_send_buffer;
+  std::vector<Real> m_receive_buffer;
+
+  bool m_pending;
+  bool m_has_results;
+  bool m_request_active;
+  MPI_Request m_request;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // PE
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_PE_ReductionBatch_hpp
@@ -4,9 +4,13 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <sstream>
+
 #include "common/Builder.hpp"
+#include "common/Log.hpp"
 #include "common/OptionList.hpp"
 #include "common/TimedComponent.hpp"
+#include "common/Tracer.hpp"
 
 #include "PrintTimingTree.hpp"
 
@@ -24,12 +28,26 @@ PrintTimingTree::PrintTimingTree(const std::string& name): Action(name)
     .pretty_name("Root")
     .link_to(&m_root)
     .mark_basic();
+
+  options().add("trace_file", m_trace_file)
+    .description("If tracing is enabled in the environment, write the traced events of each rank to this file, in Chrome trace format")
+    .pretty_name("Trace File")
+    .link_to(&m_trace_file);
 }
 
 void PrintTimingTree::execute()
 {
   if(is_not_null(m_root))
     print_timing_tree(*m_root);
+
+  if(Tracer::instance().is_enabled())
+  {
+    std::ostringstream statistics;
+    Tracer::instance().print_statistics(statistics);
+    CFinfo << statistics.str() << CFflush;
+    if(!m_trace_file.empty())
+      Tracer::instance().write_chrome_trace(m_trace_file);
+  }
 }
 
 
@@ -34,6 +34,8 @@ public: // functions
 private:
   // Root component to print timings from
   Handle<Component> m_root;
+  // File to write the Chrome trace to, if not empty
+  std::string m_trace_file;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
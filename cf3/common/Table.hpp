@@ -11,6 +11,8 @@
 
 #include <iosfwd>
 
+#include <boost/scoped_ptr.hpp>
+
 #include "common/Component.hpp"
 
 #include "common/Table_fwd.hpp"
@@ -27,7 +29,9 @@ namespace common {
 /// @brief Component holding a 2 dimensional array of a templated type
 ///
 /// The internal structure is that of a boost::multi_array,
-/// so storage is contingent in memory for reducing cache missing
+/// so storage is contingent in memory for reducing cache missing.
+/// By default each row is contiguous. After set_column_major(true),
+/// each column is contiguous instead, and rows are strided views.
 //
 /// The table can be filled through a buffer. The buffer avoids
 /// the typical reallocation in a std::vector. Flushing the buffer
@@ -65,7 +69,7 @@ public: // functions
 
   /// Contructor
   /// @param name of the component
-  Table ( const std::string& name )  : Component ( name ), m_pos(0)
+  Table ( const std::string& name )  : Component ( name ), m_array(new ArrayT()), m_pos(0)
   {  }
 
   /// Get the component type name
@@ -77,23 +81,46 @@ public: // functions
   /// @param[in] nb_cols number of columns in the table.
   void set_row_size(const Uint nb_cols)
   {
-    m_array.resize(boost::extents[size()][nb_cols]);
+    m_array->resize(boost::extents[size()][nb_cols]);
   }
 
   /// Resize the array to the given number of rows
   /// @param[in] nb_rows The number of rows after resizing
   virtual void resize(const Uint nb_rows)
   {
-    m_array.resize(boost::extents[nb_rows][row_size()]);
+    m_array->resize(boost::extents[nb_rows][row_size()]);
+  }
+
+  /// Choose between storing each row contiguously (the default) or each column contiguously, keeping the values.
+  /// Column-major storage suits kernels that only access a few columns. Row access through operator[] keeps working,
+  /// but code that takes the address of a row entry must take array().strides() into account.
+  /// The storage order is kept when the table is resized.
+  /// Changing the order replaces the array, so references obtained through array() and buffers become invalid.
+  void set_column_major(const bool column_major)
+  {
+    if(column_major == is_column_major())
+      return;
+
+    // boost::multi_array can't change the storage order of an existing array, so a reordered copy replaces it
+    const boost::general_storage_order<2> order = column_major ? boost::general_storage_order<2>(boost::fortran_storage_order()) : boost::general_storage_order<2>(boost::c_storage_order());
+    boost::scoped_ptr<ArrayT> reordered(new ArrayT(boost::extents[size()][row_size()], order));
+    *reordered = *m_array;
+    m_array.swap(reordered);
+  }
+
+  /// True if each column is stored contiguously
+  bool is_column_major() const
+  {
+    return m_array->storage_order() == boost::general_storage_order<2>(boost::fortran_storage_order());
   }
 
   /// Modifiable access to the internal structure
   /// @return A reference to the array data
-  ArrayT& array() { return m_array; }
+  ArrayT& array() { return *m_array; }
 
   /// Non-modifiable access to the internal structure
   /// @return A const reference to the array data
-  const ArrayT& array() const { return m_array; }
+  const ArrayT& array() const { return *m_array; }
 
   /// Create a buffer with a given number of entries
   /// @param[in] buffersize the size that the buffer is allocated with
@@ -103,34 +130,34 @@ public: // functions
   {
     // make sure the array has its columnsize defined
     cf3_assert(row_size() > 0);
-    return Buffer(m_array,buffersize);
+    return Buffer(*m_array,buffersize);
   }
 
   typename boost::shared_ptr<Buffer> create_buffer_ptr(const size_t buffersize=16384)
   {
     // make sure the array has its columnsize defined
     cf3_assert(row_size() > 0);
-    return typename boost::shared_ptr<Buffer> ( new Buffer (m_array,buffersize) );
+    return typename boost::shared_ptr<Buffer> ( new Buffer (*m_array,buffersize) );
   }
 
 
   /// Operator to have modifiable access to a table-row
   /// @return A mutable row of the underlying array
-  Row operator[](const Uint idx) { return m_array[idx]; }
+  Row operator[](const Uint idx) { return (*m_array)[idx]; }
 
   /// Operator to have non-modifiable access to a table-row
   /// @return A const row of the underlying array
-  ConstRow operator[](const Uint idx) const { return m_array[idx]; }
+  ConstRow operator[](const Uint idx) const { return (*m_array)[idx]; }
 
   /// Number of rows, excluding rows that may be in the buffer
   /// @return The number of local rows in the array
-  Uint size() const { return m_array.size(); }
+  Uint size() const { return m_array->size(); }
 
   /// Number of columns , or number of elements of one table-row
   /// @return The number of elements in each row, i.e. the number of columns of the array
   /// @note All row_sizes are the same, so an index is not required, but
   /// could be passed to be consistent with DynTable with variable row_sizes
-  Uint row_size(Uint i=0) const { return m_array.shape()[1]; }
+  Uint row_size(Uint i=0) const { return m_array->shape()[1]; }
 
   /// copy a given row into the array, The row type must have the size() function declared
   /// @param[in] array_idx the index of the row that will be set
@@ -140,7 +167,7 @@ public: // functions
   {
     cf3_assert(row.size() == row_size());
 
-    Row row_to_set = m_array[array_idx];
+    Row row_to_set = (*m_array)[array_idx];
 
     for(Uint j=0; j<row.size(); ++j)
       row_to_set[j] = row[j];
@@ -161,8 +188,8 @@ public: // functions
 
 private: // data
 
-  /// storage of the array
-  ArrayT m_array;
+  /// storage of the array, held through a pointer so set_column_major can replace it
+  boost::scoped_ptr<ArrayT> m_array;
   /// position when used as output stream
   Uint m_pos;
 };
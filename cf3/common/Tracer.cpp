@@ -0,0 +1,399 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/Component.hpp"
+#include "common/Foreach.hpp"
+#include "common/StringConversion.hpp"
+#include "common/Tracer.hpp"
+
+#include "common/PE/Comm.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+/// Accumulated time and number of calls for one span name
+struct TraceTotal
+{
+  TraceTotal() : time(0.), count(0) {}
+  Real time;
+  Uint count;
+};
+
+typedef std::map<std::string, TraceTotal> TraceTotalsT;
+
+/// Events recorded by a single thread
+struct TraceBuffer
+{
+  TraceBuffer(const Uint capacity) : events(capacity), nb_recorded(0) {}
+
+  /// Ring buffer of completed events
+  std::vector<TraceEvent> events;
+  /// Total number of events recorded since the last clear
+  Uint nb_recorded;
+
+  /// Name and start time of the spans that are still open
+  std::vector< std::pair<std::string, Real> > open_spans;
+
+  TraceTotalsT totals;
+
+  /// Protects the data above against reads from other threads
+  boost::mutex mutex;
+};
+
+/// Buffers are owned by the Tracer, since they are needed after their thread ends
+void no_cleanup(TraceBuffer*)
+{
+}
+
+/// Escape a string for use in JSON
+std::string json_escape(const std::string& str)
+{
+  std::string result;
+  result.reserve(str.size());
+  boost_foreach(const char c, str)
+  {
+    if(c == '"' || c == '\\')
+      result.push_back('\\');
+    result.push_back(c);
+  }
+  return result;
+}
+
+/// Compare statistics by decreasing maximum time
+bool greater_max(const TraceStatistics& a, const TraceStatistics& b)
+{
+  return a.max > b.max;
+}
+
+} // detail
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+class Tracer::Implementation
+{
+public:
+  Implementation() :
+    epoch(boost::posix_time::microsec_clock::universal_time()),
+    thread_buffer(&detail::no_cleanup)
+  {
+  }
+
+  /// Wall clock time since the creation of the tracer
+  Real now() const
+  {
+    return static_cast<Real>((boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds()) * 1e-6;
+  }
+
+  /// Buffer for the calling thread, created on first use
+  detail::TraceBuffer& buffer(const Uint capacity)
+  {
+    detail::TraceBuffer* result = thread_buffer.get();
+    if(result == 0)
+    {
+      boost::shared_ptr<detail::TraceBuffer> new_buffer(new detail::TraceBuffer(capacity));
+      boost::lock_guard<boost::mutex> lock(mutex);
+      buffers.push_back(new_buffer);
+      result = new_buffer.get();
+      thread_buffer.reset(result);
+    }
+    return *result;
+  }
+
+  const boost::posix_time::ptime epoch;
+  mutable boost::mutex mutex;
+  std::vector< boost::shared_ptr<detail::TraceBuffer> > buffers;
+  boost::thread_specific_ptr<detail::TraceBuffer> thread_buffer;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+Tracer& Tracer::instance()
+{
+  static Tracer tracer;
+  return tracer;
+}
+
+Tracer::Tracer() :
+  m_implementation(new Implementation()),
+  m_enabled(0),
+  m_buffer_size(100000)
+{
+}
+
+Tracer::~Tracer()
+{
+}
+
+void Tracer::enable(const bool enabled)
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  if(enabled && m_enabled == 0)
+    ++m_enabled;
+  else if(!enabled && m_enabled != 0)
+    --m_enabled;
+}
+
+void Tracer::set_buffer_size(const Uint buffer_size)
+{
+  if(buffer_size == 0)
+    throw BadValue(FromHere(), "Trace buffer size must be at least 1");
+  m_buffer_size = buffer_size;
+}
+
+void Tracer::begin(const std::string& name)
+{
+  detail::TraceBuffer& buffer = m_implementation->buffer(m_buffer_size);
+  const Real start_time = m_implementation->now();
+  boost::lock_guard<boost::mutex> lock(buffer.mutex);
+  buffer.open_spans.push_back(std::make_pair(name, start_time));
+}
+
+void Tracer::end()
+{
+  const Real end_time = m_implementation->now();
+  detail::TraceBuffer& buffer = m_implementation->buffer(m_buffer_size);
+  boost::lock_guard<boost::mutex> buffer_lock(buffer.mutex);
+  cf3_assert(!buffer.open_spans.empty());
+
+  TraceEvent& event = buffer.events[buffer.nb_recorded % buffer.events.size()];
+  event.name = buffer.open_spans.back().first;
+  event.start = buffer.open_spans.back().second;
+  event.duration = end_time - event.start;
+  event.depth = buffer.open_spans.size() - 1;
+  ++buffer.nb_recorded;
+
+  detail::TraceTotal& total = buffer.totals[event.name];
+  total.time += event.duration;
+  ++total.count;
+
+  buffer.open_spans.pop_back();
+}
+
+void Tracer::clear()
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  boost_foreach(const boost::shared_ptr<detail::TraceBuffer>& buffer, m_implementation->buffers)
+  {
+    boost::lock_guard<boost::mutex> buffer_lock(buffer->mutex);
+    buffer->nb_recorded = 0;
+    buffer->totals.clear();
+  }
+}
+
+std::vector< std::vector<TraceEvent> > Tracer::events() const
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  std::vector< std::vector<TraceEvent> > result;
+  result.reserve(m_implementation->buffers.size());
+  boost_foreach(const boost::shared_ptr<detail::TraceBuffer>& buffer, m_implementation->buffers)
+  {
+    boost::lock_guard<boost::mutex> buffer_lock(buffer->mutex);
+    result.push_back(std::vector<TraceEvent>());
+    std::vector<TraceEvent>& thread_events = result.back();
+    const Uint capacity = buffer->events.size();
+    if(buffer->nb_recorded <= capacity)
+    {
+      thread_events.assign(buffer->events.begin(), buffer->events.begin() + buffer->nb_recorded);
+    }
+    else
+    {
+      // The buffer wrapped around, so the oldest event is the one that would be overwritten next
+      const Uint oldest = buffer->nb_recorded % capacity;
+      thread_events.assign(buffer->events.begin() + oldest, buffer->events.end());
+      thread_events.insert(thread_events.end(), buffer->events.begin(), buffer->events.begin() + oldest);
+    }
+  }
+  return result;
+}
+
+std::vector<TraceStatistics> Tracer::reduce_statistics() const
+{
+  // Merge the totals of all threads
+  detail::TraceTotalsT local_totals;
+  {
+    boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+    boost_foreach(const boost::shared_ptr<detail::TraceBuffer>& buffer, m_implementation->buffers)
+    {
+      boost::lock_guard<boost::mutex> buffer_lock(buffer->mutex);
+      for(detail::TraceTotalsT::const_iterator it = buffer->totals.begin(); it != buffer->totals.end(); ++it)
+      {
+        detail::TraceTotal& total = local_totals[it->first];
+        total.time += it->second.time;
+        total.count += it->second.count;
+      }
+    }
+  }
+
+  const bool is_parallel = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1;
+
+  // Names of the spans seen on any rank, in the same order on all ranks
+  std::vector<std::string> names;
+  if(is_parallel)
+  {
+    // Each name is terminated by a null character, and the buffer always ends with one
+    std::vector<char> local_names;
+    for(detail::TraceTotalsT::const_iterator it = local_totals.begin(); it != local_totals.end(); ++it)
+    {
+      local_names.insert(local_names.end(), it->first.begin(), it->first.end());
+      local_names.push_back('\0');
+    }
+    local_names.push_back('\0');
+
+    std::vector<int> nb_chars;
+    PE::Comm::instance().all_gather(static_cast<int>(local_names.size()), nb_chars);
+    std::vector<char> all_names;
+    PE::Comm::instance().all_gather(local_names, local_names.size(), all_names, nb_chars);
+
+    std::set<std::string> unique_names;
+    const std::vector<char>::const_iterator all_names_end = all_names.end();
+    std::vector<char>::const_iterator name_begin = all_names.begin();
+    while(name_begin != all_names_end)
+    {
+      const std::vector<char>::const_iterator name_end = std::find(name_begin, all_names_end, '\0');
+      if(name_end != name_begin)
+        unique_names.insert(std::string(name_begin, name_end));
+      name_begin = name_end == all_names_end ? name_end : name_end + 1;
+    }
+    names.assign(unique_names.begin(), unique_names.end());
+  }
+  else
+  {
+    for(detail::TraceTotalsT::const_iterator it = local_totals.begin(); it != local_totals.end(); ++it)
+      names.push_back(it->first);
+  }
+
+  const Uint nb_names = names.size();
+  std::vector<Real> times(nb_names, 0.);
+  std::vector<Uint> counts(nb_names, 0);
+  for(Uint i = 0; i != nb_names; ++i)
+  {
+    detail::TraceTotalsT::const_iterator it = local_totals.find(names[i]);
+    if(it != local_totals.end())
+    {
+      times[i] = it->second.time;
+      counts[i] = it->second.count;
+    }
+  }
+
+  std::vector<Real> min_times(times), sum_times(times), max_times(times);
+  std::vector<Uint> max_counts(counts);
+  if(is_parallel && nb_names != 0)
+  {
+    PE::Comm::instance().all_reduce(PE::min(), &times[0], nb_names, &min_times[0]);
+    PE::Comm::instance().all_reduce(PE::plus(), &times[0], nb_names, &sum_times[0]);
+    PE::Comm::instance().all_reduce(PE::max(), &times[0], nb_names, &max_times[0]);
+    PE::Comm::instance().all_reduce(PE::max(), &counts[0], nb_names, &max_counts[0]);
+  }
+
+  const Real nb_procs = is_parallel ? static_cast<Real>(PE::Comm::instance().size()) : 1.;
+  std::vector<TraceStatistics> result(nb_names);
+  for(Uint i = 0; i != nb_names; ++i)
+  {
+    TraceStatistics& stats = result[i];
+    stats.name = names[i];
+    stats.count = max_counts[i];
+    stats.min = min_times[i];
+    stats.mean = sum_times[i] / nb_procs;
+    stats.max = max_times[i];
+    stats.imbalance = stats.mean > 0. ? stats.max / stats.mean : 1.;
+  }
+
+  return result;
+}
+
+void Tracer::print_statistics(std::ostream& out) const
+{
+  std::vector<TraceStatistics> statistics = reduce_statistics();
+  if(PE::Comm::instance().rank() != 0)
+    return;
+
+  std::sort(statistics.begin(), statistics.end(), detail::greater_max);
+  out << "Traced time in seconds, with [min, mean, max] over CPUs of the total per CPU, and imbalance as max/mean\n";
+  boost_foreach(const TraceStatistics& stats, statistics)
+  {
+    out << stats.name
+        << ": min: " << stats.min
+        << ", mean: " << stats.mean
+        << ", max: " << stats.max
+        << ", imbalance: " << stats.imbalance
+        << ", count: " << stats.count << "\n";
+  }
+  out << std::flush;
+}
+
+void Tracer::write_chrome_trace(const std::string& filename) const
+{
+  const bool is_parallel = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1;
+  const Uint rank = is_parallel ? PE::Comm::instance().rank() : 0;
+
+  std::string rank_filename = filename;
+  if(is_parallel)
+  {
+    const std::string::size_type dot = filename.rfind('.');
+    const std::string::size_type slash = filename.rfind('/');
+    const std::string suffix = "-" + to_str(rank);
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+      rank_filename += suffix;
+    else
+      rank_filename.insert(dot, suffix);
+  }
+
+  std::ofstream file(rank_filename.c_str());
+  if(!file)
+    throw FileSystemError(FromHere(), "Could not open trace file " + rank_filename);
+
+  file << "{\"traceEvents\":[\n";
+  file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+
+  const std::vector< std::vector<TraceEvent> > all_events = events();
+  const Uint nb_threads = all_events.size();
+  for(Uint thread = 0; thread != nb_threads; ++thread)
+  {
+    boost_foreach(const TraceEvent& event, all_events[thread])
+    {
+      file << ",\n{\"name\":\"" << detail::json_escape(event.name) << "\",\"cat\":\"cf3\",\"ph\":\"X\""
+           << ",\"ts\":" << static_cast<boost::uint64_t>(event.start * 1e6)
+           << ",\"dur\":" << static_cast<boost::uint64_t>(event.duration * 1e6)
+           << ",\"pid\":" << rank << ",\"tid\":" << thread << "}";
+    }
+  }
+
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+TraceSpan::TraceSpan(const Component& component) : m_active(Tracer::instance().is_enabled())
+{
+  if(m_active)
+    Tracer::instance().begin(component.uri().path());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+/////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,132 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_Tracer_hpp
+#define cf3_common_Tracer_hpp
+
+#include <iosfwd>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/detail/atomic_count.hpp>
+
+#include "common/CF.hpp"
+#include "common/CommonAPI.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+class Component;
+
+/// A single completed span, with times in seconds since the tracer was created
+struct Common_API TraceEvent
+{
+  std::string name;
+  Real start;
+  Real duration;
+  Uint depth;
+};
+
+/// Statistics of the total time spent in one span name, reduced over all ranks
+struct Common_API TraceStatistics
+{
+  std::string name;
+  /// Number of calls, maximum over the ranks
+  Uint count;
+  /// Minimum, mean and maximum over the ranks of the total time per rank
+  Real min;
+  Real mean;
+  Real max;
+  /// Load imbalance, as the ratio of the maximum to the mean time
+  Real imbalance;
+};
+
+/// Records nested spans of execution, to find where the time goes and how well it is balanced over the ranks.
+/// Each thread keeps its own fixed-size ring buffer of events, so only the most recent events are kept when
+/// the buffer is full. The total time and call count per span name is accumulated separately, and is never lost.
+/// Each buffer has its own mutex, so recording only contends with a thread that reads out the events or statistics.
+/// Tracing is disabled by default, in which case a TraceSpan only costs a test of a boolean.
+class Common_API Tracer : public boost::noncopyable
+{
+public:
+  /// Access the unique instance
+  static Tracer& instance();
+
+  ~Tracer();
+
+  /// Enable or disable recording of spans
+  void enable(const bool enabled);
+
+  bool is_enabled() const { return m_enabled != 0; }
+
+  /// Maximum number of events kept per thread. Applies to threads that record their first event after the change.
+  void set_buffer_size(const Uint buffer_size);
+
+  Uint buffer_size() const { return m_buffer_size; }
+
+  /// Open a span on the calling thread. Spans must be closed in reverse order.
+  void begin(const std::string& name);
+
+  /// Close the most recently opened span of the calling thread
+  void end();
+
+  /// Forget all recorded events and totals
+  void clear();
+
+  /// Recorded events of all threads, per thread and in order of completion
+  std::vector< std::vector<TraceEvent> > events() const;
+
+  /// Reduce the time spent in each span name over all ranks. Collective if the communicator is active.
+  std::vector<TraceStatistics> reduce_statistics() const;
+
+  /// Print the output of reduce_statistics on rank 0, sorted by decreasing maximum time. Collective.
+  void print_statistics(std::ostream& out) const;
+
+  /// Write the events of this rank in the Chrome trace event format, readable by chrome://tracing and Perfetto.
+  /// In parallel, the rank is appended to the file name, i.e. "trace.json" becomes "trace-3.json"
+  void write_chrome_trace(const std::string& filename) const;
+
+private:
+  Tracer();
+
+  class Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
+
+  /// Non-zero if enabled. Read on every span by all threads, so it is atomic. Only changed through enable.
+  boost::detail::atomic_count m_enabled;
+  Uint m_buffer_size;
+};
+
+/// Scoped span, recorded only if the Tracer is enabled when it is created
+class Common_API TraceSpan : public boost::noncopyable
+{
+public:
+  TraceSpan(const std::string& name) : m_active(Tracer::instance().is_enabled())
+  {
+    if(m_active)
+      Tracer::instance().begin(name);
+  }
+
+  /// Use the path of the component as name. The path is only computed if tracing is enabled.
+  TraceSpan(const Component& component);
+
+  ~TraceSpan()
+  {
+    if(m_active)
+      Tracer::instance().end();
+  }
+
+private:
+  const bool m_active;
+};
+
+} // common
+} // cf3
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_Tracer_hpp
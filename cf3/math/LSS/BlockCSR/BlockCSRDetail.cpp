@@ -0,0 +1,108 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+
+#include "math/LSS/BlockCSR/BlockCSRDetail.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::shared_ptr<common::PE::CommPattern> copy_comm_pattern(common::PE::CommPattern& cp, const std::string& name)
+{
+  boost::shared_ptr<common::PE::CommPattern> result;
+  if(!common::PE::Comm::instance().is_active())
+    return result;
+
+  const Uint nb_nodes = cp.isUpdatable().size();
+  std::vector<Uint> gids;
+  cp.gid()->pack(gids);
+  cf3_assert(gids.size() == nb_nodes);
+  std::vector<Uint> ranks(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    ranks[i] = cp.rank(i);
+
+  result = common::allocate_component<common::PE::CommPattern>(name);
+  result->insert("gid", gids, 1, false);
+  result->setup(Handle<common::PE::CommWrapper>(result->get_child("gid")), ranks);
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void create_node_map(const Uint nb_nodes, std::vector<Uint>& node_map, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  cf3_assert(periodic_links_nodes.size() == periodic_links_active.size());
+  cf3_assert(periodic_links_active.empty() || periodic_links_active.size() == nb_nodes);
+  node_map.resize(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    node_map[i] = i;
+
+  if(periodic_links_active.empty())
+    return;
+
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(!periodic_links_active[i])
+      continue;
+    Uint final_linked_node = periodic_links_nodes[i];
+    while(periodic_links_active[final_linked_node])
+      final_linked_node = periodic_links_nodes[final_linked_node];
+    node_map[i] = final_linked_node;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void axpby(const std::vector<Uint>& rows, const Uint neq, const Real a, const std::vector<Real>& x, const Real b, std::vector<Real>& y)
+{
+  const Uint nb_rows = rows.size();
+  for(Uint i = 0; i != nb_rows; ++i)
+  {
+    const Uint begin = rows[i]*neq;
+    const Uint end = begin + neq;
+    for(Uint j = begin; j != end; ++j)
+      y[j] = a*x[j] + b*y[j];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Real dot(const std::vector<Uint>& rows, const Uint neq, const std::vector<Real>& a, const std::vector<Real>& b)
+{
+  Real local_result = 0.;
+  const Uint nb_rows = rows.size();
+  for(Uint i = 0; i != nb_rows; ++i)
+  {
+    const Uint begin = rows[i]*neq;
+    const Uint end = begin + neq;
+    for(Uint j = begin; j != end; ++j)
+      local_result += a[j]*b[j];
+  }
+
+  if(!common::PE::Comm::instance().is_active())
+    return local_result;
+
+  Real result = 0.;
+  common::PE::Comm::instance().all_reduce(common::PE::plus(), &local_result, 1, &result);
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace detail
+} // namespace LSS
+} // namespace math
+} // namespace cf3
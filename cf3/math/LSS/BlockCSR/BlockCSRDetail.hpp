@@ -0,0 +1,218 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_BlockCSRDetail_hpp
+#define cf3_Math_LSS_BlockCSRDetail_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "common/CF.hpp"
+
+#include "math/LSS/LibLSS.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file BlockCSRDetail.hpp Shared functions and dense block kernels for the BlockCSR classes
+
+  Blocks are neq x neq dense matrices in row-major order. The kernels are templated on the block
+  size, so the loops are fully unrolled for the common sizes 2 to 7. A block size of 0 means the
+  size is only known at run time, and is then taken from the neq argument.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+  namespace common { namespace PE { class CommPattern; } }
+namespace math {
+namespace LSS {
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Create a comm pattern with the same distribution as cp, in process local numbering.
+/// Needed because the registered data of cp is owned by someone else.
+/// @return Null if the parallel environment is not active
+boost::shared_ptr<common::PE::CommPattern> copy_comm_pattern(common::PE::CommPattern& cp, const std::string& name);
+
+/// Map each process local node to the node that stores its values. This is the node itself,
+/// except for nodes with an active periodic link, which map to the final node in their chain of links.
+void create_node_map(const Uint nb_nodes, std::vector<Uint>& node_map, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active);
+
+/// y = a*x + b*y, for the given block rows
+void axpby(const std::vector<Uint>& rows, const Uint neq, const Real a, const std::vector<Real>& x, const Real b, std::vector<Real>& y);
+
+/// Dot product over the blocks listed in rows, summed over all processes
+Real dot(const std::vector<Uint>& rows, const Uint neq, const std::vector<Real>& a, const std::vector<Real>& b);
+
+/// Call f.template apply<N>() with N equal to neq if there is a specialized kernel, or 0 otherwise
+template<typename FunctorT>
+void dispatch_block_size(const Uint neq, FunctorT& f)
+{
+  switch(neq)
+  {
+    case 2: f.template apply<2>(); break;
+    case 3: f.template apply<3>(); break;
+    case 4: f.template apply<4>(); break;
+    case 5: f.template apply<5>(); break;
+    case 6: f.template apply<6>(); break;
+    case 7: f.template apply<7>(); break;
+    default: f.template apply<0>();
+  }
+}
+
+/// Block size, known at compile time if N is not 0
+template<int N>
+inline int block_size(const int neq)
+{
+  return N == 0 ? neq : N;
+}
+
+/// y += a*x
+template<int N>
+inline void block_gemv_add(const Real* a, const Real* x, Real* y, const int neq)
+{
+  const int n = block_size<N>(neq);
+  for(int i = 0; i != n; ++i)
+  {
+    Real sum = 0.;
+    for(int j = 0; j != n; ++j)
+      sum += a[i*n+j] * x[j];
+    y[i] += sum;
+  }
+}
+
+/// y -= a*x
+template<int N>
+inline void block_gemv_sub(const Real* a, const Real* x, Real* y, const int neq)
+{
+  const int n = block_size<N>(neq);
+  for(int i = 0; i != n; ++i)
+  {
+    Real sum = 0.;
+    for(int j = 0; j != n; ++j)
+      sum += a[i*n+j] * x[j];
+    y[i] -= sum;
+  }
+}
+
+/// y = a*x
+template<int N>
+inline void block_gemv(const Real* a, const Real* x, Real* y, const int neq)
+{
+  const int n = block_size<N>(neq);
+  for(int i = 0; i != n; ++i)
+  {
+    Real sum = 0.;
+    for(int j = 0; j != n; ++j)
+      sum += a[i*n+j] * x[j];
+    y[i] = sum;
+  }
+}
+
+/// c = a*b
+template<int N>
+inline void block_gemm(const Real* a, const Real* b, Real* c, const int neq)
+{
+  const int n = block_size<N>(neq);
+  for(int i = 0; i != n*n; ++i)
+    c[i] = 0.;
+  for(int i = 0; i != n; ++i)
+    for(int k = 0; k != n; ++k)
+    {
+      const Real a_ik = a[i*n+k];
+      for(int j = 0; j != n; ++j)
+        c[i*n+j] += a_ik * b[k*n+j];
+    }
+}
+
+/// c -= a*b
+template<int N>
+inline void block_gemm_sub(const Real* a, const Real* b, Real* c, const int neq)
+{
+  const int n = block_size<N>(neq);
+  for(int i = 0; i != n; ++i)
+    for(int k = 0; k != n; ++k)
+    {
+      const Real a_ik = a[i*n+k];
+      for(int j = 0; j != n; ++j)
+        c[i*n+j] -= a_ik * b[k*n+j];
+    }
+}
+
+/// Invert a using Gauss-Jordan elimination with partial pivoting
+/// @param work Scratch space of at least neq*neq values
+/// @return false if a is singular
+template<int N>
+inline bool block_invert(const Real* a, Real* inv, Real* work, const int neq)
+{
+  const int n = block_size<N>(neq);
+  for(int i = 0; i != n*n; ++i)
+  {
+    work[i] = a[i];
+    inv[i] = 0.;
+  }
+  for(int i = 0; i != n; ++i)
+    inv[i*n+i] = 1.;
+
+  for(int k = 0; k != n; ++k)
+  {
+    int pivot_row = k;
+    for(int i = k+1; i != n; ++i)
+      if(std::abs(work[i*n+k]) > std::abs(work[pivot_row*n+k]))
+        pivot_row = i;
+
+    if(work[pivot_row*n+k] == 0.)
+      return false;
+
+    if(pivot_row != k)
+    {
+      for(int j = 0; j != n; ++j)
+      {
+        std::swap(work[k*n+j], work[pivot_row*n+j]);
+        std::swap(inv[k*n+j], inv[pivot_row*n+j]);
+      }
+    }
+
+    const Real inv_pivot = 1. / work[k*n+k];
+    for(int j = 0; j != n; ++j)
+    {
+      work[k*n+j] *= inv_pivot;
+      inv[k*n+j] *= inv_pivot;
+    }
+
+    for(int i = 0; i != n; ++i)
+    {
+      if(i == k)
+        continue;
+      const Real factor = work[i*n+k];
+      if(factor == 0.)
+        continue;
+      for(int j = 0; j != n; ++j)
+      {
+        work[i*n+j] -= factor * work[k*n+j];
+        inv[i*n+j] -= factor * inv[k*n+j];
+      }
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace detail
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_BlockCSRDetail_hpp
@@ -0,0 +1,752 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "common/Assertions.hpp"
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "common/PropertyList.hpp"
+#include "common/StringConversion.hpp"
+
+#include "math/LSS/BlockCSR/BlockCSRDetail.hpp"
+#include "math/LSS/BlockCSR/BlockCSRMatrix.hpp"
+#include "math/LSS/BlockCSR/BlockCSRVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file BlockCSRMatrix.cpp Implementation of LSS::Matrix for the native block CSR solver.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Block matrix-vector product over the active rows
+struct BlockMultiply
+{
+  BlockMultiply(const std::vector<Uint>& active_rows, const std::vector<Uint>& row_offsets, const std::vector<Uint>& column_indices, const std::vector<Real>& values, const Real* x, Real* y, const int neq) :
+    active_rows(active_rows),
+    row_offsets(row_offsets),
+    column_indices(column_indices),
+    values(values),
+    x(x),
+    y(y),
+    neq(neq)
+  {
+  }
+
+  template<int N>
+  void apply()
+  {
+    const int n = block_size<N>(neq);
+    const Uint nn = n*n;
+    const Uint nb_rows = active_rows.size();
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      const Uint row = active_rows[i];
+      Real* y_row = y + row*n;
+      for(int j = 0; j != n; ++j)
+        y_row[j] = 0.;
+      const Uint row_end = row_offsets[row+1];
+      for(Uint p = row_offsets[row]; p != row_end; ++p)
+        block_gemv_add<N>(&values[p*nn], x + column_indices[p]*n, y_row, n);
+    }
+  }
+
+  const std::vector<Uint>& active_rows;
+  const std::vector<Uint>& row_offsets;
+  const std::vector<Uint>& column_indices;
+  const std::vector<Real>& values;
+  const Real* x;
+  Real* y;
+  const int neq;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < LSS::BlockCSRMatrix, LSS::Matrix, LSS::LibLSS > BlockCSRMatrix_Builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+BlockCSRMatrix::BlockCSRMatrix(const std::string& name) :
+  LSS::Matrix(name),
+  m_is_created(false),
+  m_neq(0),
+  m_blockrow_size(0)
+{
+  properties().add("vector_type", std::string("cf3.math.LSS.BlockCSRVector"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  if (m_is_created) destroy();
+
+  const Uint nb_nodes = cp.isUpdatable().size();
+  cf3_assert(starting_indices.size() == nb_nodes+1);
+
+  m_neq = neq;
+  m_blockrow_size = nb_nodes;
+  detail::create_node_map(nb_nodes, m_node_map, periodic_links_nodes, periodic_links_active);
+
+  m_is_active.assign(nb_nodes, false);
+  m_active_rows.clear();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(cp.isUpdatable()[i] && m_node_map[i] == i)
+    {
+      m_is_active[i] = true;
+      m_active_rows.push_back(i);
+    }
+  }
+
+  // Nodes that were merged into each row through a periodic link
+  std::vector< std::vector<Uint> > inverse_periodic_links;
+  if(!periodic_links_active.empty())
+  {
+    inverse_periodic_links.resize(nb_nodes);
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      if(m_node_map[i] != i)
+        inverse_periodic_links[m_node_map[i]].push_back(i);
+    }
+  }
+
+  // Sparsity structure, with sorted columns and a diagonal block for each active row
+  m_row_offsets.assign(nb_nodes+1, 0u);
+  m_diagonal_positions.assign(nb_nodes, 0u);
+  m_column_indices.clear();
+  m_column_indices.reserve(node_connectivity.size());
+  std::vector<Uint> row_nodes;
+  std::vector<Uint> row_columns;
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(m_is_active[i])
+    {
+      row_nodes.assign(1, i);
+      if(!inverse_periodic_links.empty())
+        row_nodes.insert(row_nodes.end(), inverse_periodic_links[i].begin(), inverse_periodic_links[i].end());
+
+      row_columns.assign(1, i);
+      for(std::vector<Uint>::const_iterator node_it = row_nodes.begin(); node_it != row_nodes.end(); ++node_it)
+      {
+        const Uint columns_end = starting_indices[*node_it+1];
+        for(Uint l = starting_indices[*node_it]; l != columns_end; ++l)
+          row_columns.push_back(m_node_map[node_connectivity[l]]);
+      }
+      std::sort(row_columns.begin(), row_columns.end());
+      row_columns.erase(std::unique(row_columns.begin(), row_columns.end()), row_columns.end());
+
+      m_diagonal_positions[i] = m_column_indices.size() + (std::lower_bound(row_columns.begin(), row_columns.end(), i) - row_columns.begin());
+      m_column_indices.insert(m_column_indices.end(), row_columns.begin(), row_columns.end());
+    }
+    m_row_offsets[i+1] = m_column_indices.size();
+  }
+
+  m_values.assign(m_column_indices.size()*m_neq*m_neq, 0.);
+
+  setup_ghost_exchange(cp);
+
+  m_is_created = true;
+  CFdebug << "Rank " << common::PE::Comm::instance().rank() << ": Created a block CSR matrix with " << m_active_rows.size() << " local block rows, "
+          << m_column_indices.size() << " blocks of size " << m_neq << "x" << m_neq << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::create_blocked(cf3::common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  throw common::NotImplemented(FromHere(), "create_blocked is not implemented for BlockCSRMatrix");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::destroy()
+{
+  m_node_map.clear();
+  m_is_active.clear();
+  m_active_rows.clear();
+  m_row_offsets.clear();
+  m_column_indices.clear();
+  m_diagonal_positions.clear();
+  m_values.clear();
+  m_symmetric_dirichlet_values.clear();
+  m_comm_pattern.reset();
+  m_ghosted_x.clear();
+  m_apply_buffer.clear();
+  m_column_buffer.clear();
+  m_neq=0;
+  m_blockrow_size=0;
+  m_is_created=false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::setup_ghost_exchange(common::PE::CommPattern& cp)
+{
+  m_ghosted_x.assign(m_blockrow_size*m_neq, 0.);
+  m_comm_pattern = detail::copy_comm_pattern(cp, "CommPattern");
+  if(is_not_null(m_comm_pattern))
+    m_comm_pattern->insert("x", m_ghosted_x, m_neq, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Uint BlockCSRMatrix::block_position(const Uint row, const Uint col) const
+{
+  const std::vector<Uint>::const_iterator row_begin = m_column_indices.begin() + m_row_offsets[row];
+  const std::vector<Uint>::const_iterator row_end = m_column_indices.begin() + m_row_offsets[row+1];
+  const std::vector<Uint>::const_iterator it = std::lower_bound(row_begin, row_end, col);
+  if(it == row_end || *it != col)
+    return m_column_indices.size();
+  return it - m_column_indices.begin();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Uint BlockCSRMatrix::checked_block_position(const Uint row, const Uint col) const
+{
+  const Uint result = block_position(row, col);
+  if(result == m_column_indices.size())
+    throw common::BadValue(FromHere(),"Trying to access an illegal entry: block (" + common::to_str(row) + ", " + common::to_str(col) + ") is not in the sparsity pattern.");
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::column_blocks(const Uint col, std::vector< std::pair<Uint, Uint> >& blocks) const
+{
+  blocks.clear();
+  // The matrix is structurally symmetric, so the rows with a block in an active column are the columns of its own row.
+  // A ghost column has no row on this process, so all active rows are searched.
+  const bool col_is_active = m_is_active[col];
+  const Uint nb_rows = col_is_active ? m_row_offsets[col+1] - m_row_offsets[col] : m_active_rows.size();
+  for(Uint i = 0; i != nb_rows; ++i)
+  {
+    const Uint row = col_is_active ? m_column_indices[m_row_offsets[col] + i] : m_active_rows[i];
+    if(!m_is_active[row])
+      continue;
+    const Uint pos = block_position(row, col);
+    if(pos != m_column_indices.size())
+      blocks.push_back(std::make_pair(row, pos));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+BlockCSRVector& BlockCSRMatrix::block_csr_vector(Vector& v, const std::string& function)
+{
+  BlockCSRVector* result = dynamic_cast<BlockCSRVector*>(&v);
+  if(is_null(result))
+    throw common::SetupError(FromHere(), function + " method of BlockCSRMatrix needs a BlockCSRVector, but a " + v.derived_type_name() + " was supplied instead.");
+  return *result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::set_value(const Uint icol, const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  const Uint row = m_node_map[irow/m_neq];
+  if(!m_is_active[row])
+    return;
+  const Uint pos = checked_block_position(row, m_node_map[icol/m_neq]);
+  m_values[pos*m_neq*m_neq + (irow%m_neq)*m_neq + icol%m_neq] = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::add_value(const Uint icol, const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  const Uint row = m_node_map[irow/m_neq];
+  if(!m_is_active[row])
+    return;
+  const Uint pos = checked_block_position(row, m_node_map[icol/m_neq]);
+  m_values[pos*m_neq*m_neq + (irow%m_neq)*m_neq + icol%m_neq] += value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::get_value(const Uint icol, const Uint irow, Real& value)
+{
+  cf3_assert(m_is_created);
+  const Uint pos = checked_block_position(m_node_map[irow/m_neq], m_node_map[icol/m_neq]);
+  value = m_values[pos*m_neq*m_neq + (irow%m_neq)*m_neq + icol%m_neq];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::set_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks = values.indices.size();
+  const Uint nb_cols = nb_blocks*m_neq;
+  cf3_assert(values.mat.rows() == nb_cols);
+  const Real* mat = values.mat.data();
+  for(Uint i = 0; i != nb_blocks; ++i)
+  {
+    const Uint row = m_node_map[values.indices[i]];
+    if(!m_is_active[row])
+      continue;
+    for(Uint j = 0; j != nb_blocks; ++j)
+    {
+      Real* block = &m_values[checked_block_position(row, m_node_map[values.indices[j]])*m_neq*m_neq];
+      for(Uint a = 0; a != m_neq; ++a)
+      {
+        const Real* mat_row = mat + (i*m_neq+a)*nb_cols + j*m_neq;
+        for(Uint b = 0; b != m_neq; ++b)
+          block[a*m_neq+b] = mat_row[b];
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::add_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks = values.indices.size();
+  const Uint nb_cols = nb_blocks*m_neq;
+  cf3_assert(values.mat.rows() == nb_cols);
+  const Real* mat = values.mat.data();
+  for(Uint i = 0; i != nb_blocks; ++i)
+  {
+    const Uint row = m_node_map[values.indices[i]];
+    if(!m_is_active[row])
+      continue;
+    for(Uint j = 0; j != nb_blocks; ++j)
+    {
+      Real* block = &m_values[checked_block_position(row, m_node_map[values.indices[j]])*m_neq*m_neq];
+      for(Uint a = 0; a != m_neq; ++a)
+      {
+        const Real* mat_row = mat + (i*m_neq+a)*nb_cols + j*m_neq;
+        for(Uint b = 0; b != m_neq; ++b)
+          block[a*m_neq+b] += mat_row[b];
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::get_values(BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  values.mat.setZero();
+  const Uint nb_blocks = values.indices.size();
+  const Uint nb_cols = nb_blocks*m_neq;
+  cf3_assert(values.mat.rows() == nb_cols);
+  Real* mat = values.mat.data();
+  for(Uint i = 0; i != nb_blocks; ++i)
+  {
+    const Uint row = m_node_map[values.indices[i]];
+    if(!m_is_active[row])
+      continue;
+    for(Uint j = 0; j != nb_blocks; ++j)
+    {
+      const Uint pos = block_position(row, m_node_map[values.indices[j]]);
+      if(pos == m_column_indices.size())
+        continue;
+      const Real* block = &m_values[pos*m_neq*m_neq];
+      for(Uint a = 0; a != m_neq; ++a)
+      {
+        Real* mat_row = mat + (i*m_neq+a)*nb_cols + j*m_neq;
+        for(Uint b = 0; b != m_neq; ++b)
+          mat_row[b] = block[a*m_neq+b];
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval)
+{
+  cf3_assert(m_is_created);
+  const Uint row = m_node_map[iblockrow];
+  if(!m_is_active[row])
+    return;
+
+  const Uint row_end = m_row_offsets[row+1];
+  for(Uint p = m_row_offsets[row]; p != row_end; ++p)
+  {
+    Real* block_row = &m_values[p*m_neq*m_neq + ieq*m_neq];
+    for(Uint b = 0; b != m_neq; ++b)
+      block_row[b] = offdiagval;
+  }
+  m_values[m_diagonal_positions[row]*m_neq*m_neq + ieq*m_neq + ieq] = diagval;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values)
+{
+  cf3_assert(m_is_created);
+  values.assign(m_blockrow_size*m_neq, 0.);
+  const Uint block_size = m_neq*m_neq;
+
+  column_blocks(m_node_map[iblockcol], m_column_buffer);
+  for(std::vector< std::pair<Uint, Uint> >::const_iterator it = m_column_buffer.begin(); it != m_column_buffer.end(); ++it)
+  {
+    Real* block = &m_values[it->second*block_size];
+    for(Uint a = 0; a != m_neq; ++a)
+    {
+      values[it->first*m_neq + a] = block[a*m_neq + ieq];
+      block[a*m_neq + ieq] = 0.;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs)
+{
+  cf3_assert(m_is_created);
+  std::vector<Real>& rhs_data = block_csr_vector(rhs, "symmetric_dirichlet").data();
+  const Uint bc_row = m_node_map[blockrow];
+  const Uint block_size = m_neq*m_neq;
+
+  DirichletEntryT& cached_col_values = m_symmetric_dirichlet_values[bc_row*m_neq + ieq];
+
+  if(cached_col_values.empty())
+  {
+    column_blocks(bc_row, m_column_buffer);
+    for(std::vector< std::pair<Uint, Uint> >::const_iterator it = m_column_buffer.begin(); it != m_column_buffer.end(); ++it)
+    {
+      const Uint other_row = it->first;
+      Real* block = &m_values[it->second*block_size];
+      for(Uint a = 0; a != m_neq; ++a)
+      {
+        if(other_row == bc_row && a == ieq)
+          continue;
+        const Uint rhs_idx = other_row*m_neq + a;
+        const Real entry = block[a*m_neq + ieq];
+        cached_col_values.push_back(std::make_pair(rhs_idx, entry));
+        rhs_data[rhs_idx] -= entry * value;
+        block[a*m_neq + ieq] = 0.;
+      }
+    }
+
+    set_row(blockrow, ieq, 1., 0.);
+  }
+  else // Reuse the cached values, if the matrix wasn't reset since the previous BC application
+  {
+    for(DirichletEntryT::const_iterator it = cached_col_values.begin(); it != cached_col_values.end(); ++it)
+      rhs_data[it->first] -= it->second * value;
+  }
+
+  rhs.set_value(blockrow, ieq, value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from)
+{
+  cf3_assert(m_is_created);
+  const Uint row_to = m_node_map[iblockrow_to];
+  const Uint row_from = m_node_map[iblockrow_from];
+  if(!m_is_active[row_to] || !m_is_active[row_from])
+    return;
+
+  const Uint to_begin = m_row_offsets[row_to];
+  const Uint from_begin = m_row_offsets[row_from];
+  const Uint nb_blocks = m_row_offsets[row_from+1] - from_begin;
+  if(m_row_offsets[row_to+1] - to_begin != nb_blocks)
+    throw common::BadValue(FromHere(),"Number of entries do not match for the two block rows to be tied together.");
+  if(!std::equal(m_column_indices.begin() + from_begin, m_column_indices.begin() + from_begin + nb_blocks, m_column_indices.begin() + to_begin))
+    throw common::BadValue(FromHere(),"Indices of the entries do not match for the two block rows to be tied together.");
+
+  const Uint block_size = m_neq*m_neq;
+
+  // Move the from row into the to row
+  Real* to_values = &m_values[to_begin*block_size];
+  Real* from_values = &m_values[from_begin*block_size];
+  for(Uint i = 0; i != nb_blocks*block_size; ++i)
+  {
+    to_values[i] += from_values[i];
+    from_values[i] = 0.;
+  }
+
+  // The from row now ties its value to the to row
+  Real* from_diag = &m_values[m_diagonal_positions[row_from]*block_size];
+  Real* from_pair = &m_values[checked_block_position(row_from, row_to)*block_size];
+  for(Uint a = 0; a != m_neq; ++a)
+  {
+    from_diag[a*m_neq+a] = 1.;
+    from_pair[a*m_neq+a] = -1.;
+  }
+
+  // Since both values are equal, the coefficients for the from column can be added to the to column
+  Real* to_diag = &m_values[m_diagonal_positions[row_to]*block_size];
+  Real* to_pair = &m_values[checked_block_position(row_to, row_from)*block_size];
+  for(Uint i = 0; i != block_size; ++i)
+  {
+    to_diag[i] += to_pair[i];
+    to_pair[i] = 0.;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::set_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_blockrow_size*m_neq);
+  for(Uint i = 0; i != m_blockrow_size; ++i)
+  {
+    const Uint row = m_node_map[i];
+    if(!m_is_active[row])
+      continue;
+    Real* block = &m_values[m_diagonal_positions[row]*m_neq*m_neq];
+    for(Uint a = 0; a != m_neq; ++a)
+      block[a*m_neq+a] = diag[i*m_neq+a];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::add_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_blockrow_size*m_neq);
+  for(Uint i = 0; i != m_blockrow_size; ++i)
+  {
+    const Uint row = m_node_map[i];
+    if(!m_is_active[row])
+      continue;
+    Real* block = &m_values[m_diagonal_positions[row]*m_neq*m_neq];
+    for(Uint a = 0; a != m_neq; ++a)
+      block[a*m_neq+a] += diag[i*m_neq+a];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::get_diagonal(std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  diag.assign(m_blockrow_size*m_neq, 0.);
+  for(Uint i = 0; i != m_blockrow_size; ++i)
+  {
+    const Uint row = m_node_map[i];
+    if(!m_is_active[row])
+      continue;
+    const Real* block = &m_values[m_diagonal_positions[row]*m_neq*m_neq];
+    for(Uint a = 0; a != m_neq; ++a)
+      diag[i*m_neq+a] = block[a*m_neq+a];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::reset(Real reset_to)
+{
+  cf3_assert(m_is_created);
+  m_values.assign(m_values.size(), reset_to);
+  m_symmetric_dirichlet_values.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::print(common::LogStream& stream)
+{
+  std::stringstream sstream;
+  print(sstream);
+  stream << sstream.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::print(std::ostream& stream)
+{
+  if (m_is_created)
+  {
+    const Uint block_size = m_neq*m_neq;
+    for(std::vector<Uint>::const_iterator row_it = m_active_rows.begin(); row_it != m_active_rows.end(); ++row_it)
+    {
+      const Uint row = *row_it;
+      const Uint row_end = m_row_offsets[row+1];
+      for(Uint p = m_row_offsets[row]; p != row_end; ++p)
+        for(Uint a = 0; a != m_neq; ++a)
+          for(Uint b = 0; b != m_neq; ++b)
+            stream << m_column_indices[p]*m_neq+b << " " << -(int)(row*m_neq+a) << " " << m_values[p*block_size + a*m_neq + b] << "\n";
+    }
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << m_active_rows.size()*m_neq << "\n";
+    stream << "# number of cols:       " << m_blockrow_size*m_neq << "\n";
+    stream << "# number of block rows: " << m_active_rows.size() << "\n";
+    stream << "# number of block cols: " << m_blockrow_size << "\n";
+    stream << "# number of entries:    " << m_values.size() << "\n" << std::flush;
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::print(const std::string& filename, std::ios_base::openmode mode )
+{
+  std::ofstream stream(filename.c_str(),mode);
+  stream << "VARIABLES=COL,ROW,VAL\n" << std::flush;
+  stream << "ZONE T=\"" << type_name() << "::" << name() <<  "\"\n" << std::flush;
+  print(stream);
+  stream.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::print_native(std::ostream& stream)
+{
+  if (!m_is_created)
+    return;
+
+  for(std::vector<Uint>::const_iterator row_it = m_active_rows.begin(); row_it != m_active_rows.end(); ++row_it)
+  {
+    const Uint row = *row_it;
+    stream << "block row " << row << ":";
+    const Uint row_end = m_row_offsets[row+1];
+    for(Uint p = m_row_offsets[row]; p != row_end; ++p)
+      stream << " " << m_column_indices[p];
+    stream << "\n";
+  }
+  stream << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::clone_to(Matrix &other)
+{
+  if(!m_is_created)
+    throw common::SetupError(FromHere(), "Matrix to clone " + uri().string() + " is not created");
+
+  BlockCSRMatrix* other_ptr = dynamic_cast<BlockCSRMatrix*>(&other);
+  if(is_null(other_ptr))
+    throw common::SetupError(FromHere(), "clone_to method of BlockCSRMatrix needs another BlockCSRMatrix, but a " + other.derived_type_name() + " was supplied instead.");
+
+  other_ptr->destroy();
+  other_ptr->m_neq = m_neq;
+  other_ptr->m_blockrow_size = m_blockrow_size;
+  other_ptr->m_node_map = m_node_map;
+  other_ptr->m_is_active = m_is_active;
+  other_ptr->m_active_rows = m_active_rows;
+  other_ptr->m_row_offsets = m_row_offsets;
+  other_ptr->m_column_indices = m_column_indices;
+  other_ptr->m_diagonal_positions = m_diagonal_positions;
+  other_ptr->m_values = m_values;
+  other_ptr->m_symmetric_dirichlet_values = m_symmetric_dirichlet_values;
+  if(is_not_null(m_comm_pattern))
+    other_ptr->setup_ghost_exchange(*m_comm_pattern);
+  else
+    other_ptr->m_ghosted_x.assign(m_blockrow_size*m_neq, 0.);
+  other_ptr->m_is_created = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::read_native(const common::URI& file)
+{
+  throw common::NotImplemented(FromHere(), "read_native method is not implemented for " + derived_type_name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::multiply(const std::vector<Real>& x, std::vector<Real>& y)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(x.size() == m_blockrow_size*m_neq);
+  cf3_assert(y.size() == m_blockrow_size*m_neq);
+  if(m_active_rows.empty())
+    return;
+
+  const Real* x_data = &x[0];
+  if(is_not_null(m_comm_pattern))
+  {
+    std::copy(x.begin(), x.end(), m_ghosted_x.begin());
+    m_comm_pattern->synchronize("x");
+    x_data = &m_ghosted_x[0];
+  }
+
+  detail::BlockMultiply f(m_active_rows, m_row_offsets, m_column_indices, m_values, x_data, &y[0], m_neq);
+  detail::dispatch_block_size(m_neq, f);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::apply(const Handle<Vector>& y, const Handle<Vector const>& x, const Real alpha, const Real beta)
+{
+  Handle<BlockCSRVector> y_vec(y);
+  Handle<BlockCSRVector const> x_vec(x);
+  if(is_null(y_vec) || is_null(x_vec))
+    throw common::SetupError(FromHere(), "BlockCSRMatrix::apply must be given BlockCSRVector arguments");
+
+  std::vector<Real>& ax = m_apply_buffer;
+  ax.resize(m_blockrow_size*m_neq, 0.);
+  multiply(x_vec->data(), ax);
+
+  std::vector<Real>& y_data = y_vec->data();
+  for(std::vector<Uint>::const_iterator row_it = m_active_rows.begin(); row_it != m_active_rows.end(); ++row_it)
+  {
+    const Uint begin = *row_it*m_neq;
+    const Uint end = begin + m_neq;
+    for(Uint i = begin; i != end; ++i)
+      y_data[i] = beta == 0. ? alpha*ax[i] : alpha*ax[i] + beta*y_data[i];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRMatrix::debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values)
+{
+  row_indices.clear(); col_indices.clear(); values.clear();
+  row_indices.reserve(m_values.size()); col_indices.reserve(m_values.size()); values.reserve(m_values.size());
+  const Uint block_size = m_neq*m_neq;
+  for(std::vector<Uint>::const_iterator row_it = m_active_rows.begin(); row_it != m_active_rows.end(); ++row_it)
+  {
+    const Uint row = *row_it;
+    const Uint row_end = m_row_offsets[row+1];
+    for(Uint p = m_row_offsets[row]; p != row_end; ++p)
+    {
+      for(Uint a = 0; a != m_neq; ++a)
+      {
+        for(Uint b = 0; b != m_neq; ++b)
+        {
+          row_indices.push_back(row*m_neq+a);
+          col_indices.push_back(m_column_indices[p]*m_neq+b);
+          values.push_back(m_values[p*block_size + a*m_neq + b]);
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
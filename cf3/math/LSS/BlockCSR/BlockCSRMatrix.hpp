@@ -0,0 +1,265 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_BlockCSRMatrix_hpp
+#define cf3_Math_LSS_BlockCSRMatrix_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <map>
+
+#include "math/LSS/LibLSS.hpp"
+#include "math/LSS/BlockAccumulator.hpp"
+#include "math/LSS/Matrix.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file BlockCSRMatrix.hpp Definition of LSS::Matrix for the native block CSR solver.
+
+  The matrix is stored in block compressed sparse row format, with a dense neq x neq block (row-major)
+  for each nonzero node pair. Compared to a scalar CSR matrix, only one column index is stored per block,
+  and the matrix-vector product works on whole blocks. Blocks of size 2 to 7 use kernels with a compile-time size.
+
+  Block rows are in process local numbering. Only the rows of the nodes owned by this process are filled,
+  the ghost rows are empty. Nodes with an active periodic link are merged into the node they link to.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+class BlockCSRVector;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API BlockCSRMatrix : public LSS::Matrix {
+public:
+
+  /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
+  //@{
+
+  /// name of the type
+  static std::string type_name () { return "BlockCSRMatrix"; }
+
+  /// Accessor to solver type
+  const std::string solvertype() { return "BlockCSR"; }
+
+  /// Accessor to the flag if matrix, solution and rhs are tied together or not
+  virtual const bool is_swappable(const LSS::Vector& solution, const LSS::Vector& rhs) { return true; }
+
+  /// Default constructor
+  BlockCSRMatrix(const std::string& name);
+
+  /// Setup sparsity structure
+  void create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Not supported, since it breaks the block structure
+  void create_blocked(cf3::common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Deallocate underlying data
+  void destroy();
+
+  //@} END CREATION, DESTRUCTION AND COMPONENT SYSTEM
+
+  /// @name INDIVIDUAL ACCESS
+  //@{
+
+  /// Set value at given location in the matrix
+  void set_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Add value at given location in the matrix
+  void add_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Get value at given location in the matrix
+  void get_value(const Uint icol, const Uint irow, Real& value);
+
+  //@} END INDIVIDUAL ACCESS
+
+  /// @name EFFICCIENT ACCESS
+  //@{
+
+  /// Set a list of values
+  void set_values(const BlockAccumulator& values);
+
+  /// Add a list of values
+  void add_values(const BlockAccumulator& values);
+
+  /// Add a list of values
+  void get_values(BlockAccumulator& values);
+
+  /// Set a row, diagonal and off-diagonals values separately (dirichlet-type boundaries)
+  void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval);
+
+  /// Get a column and replace it to zero (dirichlet-type boundaries, when trying to preserve symmetry)
+  void get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values);
+
+  /// Apply a dirichlet boundary condition, preserving symmetry by moving entries to the RHS
+  void symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, LSS::Vector& rhs);
+
+  /// Add one line to another and tie to it via dirichlet-style (applying periodicity)
+  void tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from);
+
+  /// Set the diagonal
+  void set_diagonal(const std::vector<Real>& diag);
+
+  /// Add to the diagonal
+  void add_diagonal(const std::vector<Real>& diag);
+
+  /// Get the diagonal
+  void get_diagonal(std::vector<Real>& diag);
+
+  /// Reset Matrix
+  void reset(Real reset_to=0.);
+
+  //@} END EFFICCIENT ACCESS
+
+  /// @name MISCELLANEOUS
+  //@{
+
+  /// Print to wherever
+  void print(common::LogStream& stream);
+
+  /// Print to wherever
+  void print(std::ostream& stream);
+
+  /// Print to file given by filename
+  void print(const std::string& filename, std::ios_base::openmode mode = std::ios_base::out );
+
+  /// Prints the block structure
+  void print_native(std::ostream& stream);
+
+  /// Accessor to the state of create
+  const bool is_created() { return m_is_created; }
+
+  /// Accessor to the number of equations
+  const Uint neq() { return m_neq; }
+
+  /// Accessor to the number of block rows
+  const Uint blockrow_size() { return m_blockrow_size; }
+
+  /// Accessor to the number of block columns
+  const Uint blockcol_size() { return m_blockrow_size; }
+
+  /// Make a deep copy of the current matrix into other
+  void clone_to(Matrix& other);
+
+  /// Not supported
+  void read_native(const common::URI& file);
+
+  //@} END MISCELLANEOUS
+
+  /// @name LINEAR ALGEBRA
+  //@{
+
+  /// Compute y = alpha*A*x + beta*y
+  void apply(const Handle<Vector>& y, const Handle<Vector const>& x, const Real alpha = 1., const Real beta = 0.);
+
+  //@} END LINEAR ALGEBRA
+
+  /// @name BLOCK CSR DATA
+  /// @attention these functions are not part of the interface, only used between the BlockCSR classes
+  //@{
+
+  /// Compute y = A*x for the active rows. The ghost values of x are updated internally, the ghost values of y are left untouched.
+  /// @param x Values in the storage layout of BlockCSRVector
+  /// @param y Values in the storage layout of BlockCSRVector
+  void multiply(const std::vector<Real>& x, std::vector<Real>& y);
+
+  /// The block rows that are owned by this process and not merged into another row through a periodic link
+  const std::vector<Uint>& active_rows() const { return m_active_rows; }
+
+  /// For each block row, the start of the row in column_indices(), with one extra entry marking the end of the last row
+  const std::vector<Uint>& row_offsets() const { return m_row_offsets; }
+
+  /// Column of each block, sorted within each row
+  const std::vector<Uint>& column_indices() const { return m_column_indices; }
+
+  /// Position of the diagonal block of each active row
+  const std::vector<Uint>& diagonal_positions() const { return m_diagonal_positions; }
+
+  /// The values of all blocks, neq*neq for each block
+  const std::vector<Real>& values() const { return m_values; }
+
+  //@} END BLOCK CSR DATA
+
+  /// @name TEST ONLY
+  //@{
+
+  /// exports the matrix into big linear arrays
+  /// @attention only for debug and utest purposes
+  void debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values);
+
+  //@} END TEST ONLY
+
+private:
+
+  /// Index into the blocks of the block at the given block row and column, or m_column_indices.size() if it is not in the sparsity pattern
+  Uint block_position(const Uint row, const Uint col) const;
+
+  /// Same as block_position, but throws if the block is absent
+  Uint checked_block_position(const Uint row, const Uint col) const;
+
+  /// Collect the (block row, block position) of each block in the given block column, for the active rows only
+  void column_blocks(const Uint col, std::vector< std::pair<Uint, Uint> >& blocks) const;
+
+  /// Register the ghosted copy of the matrix-vector product input with the comm pattern
+  void setup_ghost_exchange(common::PE::CommPattern& cp);
+
+  /// Access to a BlockCSRVector from the interface type, throwing if the type is wrong
+  BlockCSRVector& block_csr_vector(Vector& v, const std::string& function);
+
+  /// status of the matrix
+  bool m_is_created;
+
+  /// number of equations
+  Uint m_neq;
+
+  /// number of block rows (and columns), equal to the number of nodes on this process
+  Uint m_blockrow_size;
+
+  /// maps each process local node to the block row that holds its equations, to account for periodic links
+  std::vector<Uint> m_node_map;
+
+  /// true for the rows owned by this process and not linked to another row
+  std::vector<bool> m_is_active;
+
+  /// list of the active rows
+  std::vector<Uint> m_active_rows;
+
+  /// Block compressed row storage
+  std::vector<Uint> m_row_offsets;
+  std::vector<Uint> m_column_indices;
+  std::vector<Uint> m_diagonal_positions;
+  std::vector<Real> m_values;
+
+  /// Values that were moved to the RHS by symmetric_dirichlet, for each (block column*neq + equation), as pairs of (RHS index, matrix value)
+  typedef std::vector< std::pair<Uint, Real> > DirichletEntryT;
+  std::map<Uint, DirichletEntryT> m_symmetric_dirichlet_values;
+
+  /// Copy of the input of multiply, with up to date ghost values
+  std::vector<Real> m_ghosted_x;
+
+  /// Storage for A*x in apply, kept between calls to avoid an allocation per product
+  std::vector<Real> m_apply_buffer;
+
+  /// Blocks of the column handled by get_column_and_replace_to_zero or symmetric_dirichlet
+  std::vector< std::pair<Uint, Uint> > m_column_buffer;
+
+  /// Comm pattern to update m_ghosted_x. Null in serial.
+  boost::shared_ptr<common::PE::CommPattern> m_comm_pattern;
+
+}; // end of class BlockCSRMatrix
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_BlockCSRMatrix_hpp
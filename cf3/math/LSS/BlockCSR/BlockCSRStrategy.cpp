@@ -0,0 +1,234 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+
+#include <boost/assign/list_of.hpp>
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "math/LSS/BlockCSR/BlockCSRDetail.hpp"
+#include "math/LSS/BlockCSR/BlockCSRMatrix.hpp"
+#include "math/LSS/BlockCSR/BlockCSRStrategy.hpp"
+#include "math/LSS/BlockCSR/BlockCSRVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder<BlockCSRStrategy, SolutionStrategy, LibLSS> BlockCSRStrategy_builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+BlockCSRStrategy::BlockCSRStrategy(const std::string& name) :
+  SolutionStrategy(name),
+  m_max_iterations(1000u),
+  m_tolerance(1e-8)
+{
+  std::vector<std::string> preconditioners = boost::assign::list_of("ILU0")("Jacobi")("None");
+  options().add("preconditioner", std::string("ILU0"))
+    .pretty_name("Preconditioner")
+    .description("Block preconditioner: ILU0 (incomplete block LU without fill-in), Jacobi (inverse of the diagonal blocks) or None. "
+                 "In parallel, both only couple the rows of the same process.")
+    .restricted_list() = std::vector<boost::any>(preconditioners.begin(), preconditioners.end());
+
+  options().add("max_iterations", m_max_iterations)
+    .pretty_name("Maximum Iterations")
+    .description("Maximum number of BiCGStab iterations")
+    .link_to(&m_max_iterations)
+    .mark_basic();
+
+  options().add("tolerance", m_tolerance)
+    .pretty_name("Tolerance")
+    .description("Convergence criterion for the norm of the residual, relative to the norm of the right hand side")
+    .link_to(&m_tolerance)
+    .mark_basic();
+
+  properties().add("iterations", 0u);
+  properties().add("residual", 0.);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+BlockCSRStrategy::~BlockCSRStrategy()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRStrategy::set_matrix(const Handle< Matrix >& matrix)
+{
+  m_matrix = Handle<BlockCSRMatrix>(matrix);
+  if(is_null(m_matrix))
+    throw common::SetupError(FromHere(), "BlockCSRStrategy needs a BlockCSRMatrix, but got " + matrix->derived_type_name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRStrategy::set_rhs(const Handle< Vector >& rhs)
+{
+  m_rhs = Handle<BlockCSRVector>(rhs);
+  if(is_null(m_rhs))
+    throw common::SetupError(FromHere(), "BlockCSRStrategy needs a BlockCSRVector as RHS, but got " + rhs->derived_type_name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRStrategy::set_solution(const Handle< Vector >& solution)
+{
+  m_solution = Handle<BlockCSRVector>(solution);
+  if(is_null(m_solution))
+    throw common::SetupError(FromHere(), "BlockCSRStrategy needs a BlockCSRVector as solution, but got " + solution->derived_type_name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRStrategy::check_setup()
+{
+  if(is_null(m_matrix))
+    throw common::SetupError(FromHere(), "Null matrix for " + uri().path());
+
+  if(is_null(m_rhs))
+    throw common::SetupError(FromHere(), "Null RHS for " + uri().path());
+
+  if(is_null(m_solution))
+    throw common::SetupError(FromHere(), "Null solution vector for " + uri().path());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRStrategy::solve()
+{
+  check_setup();
+
+  const std::string preconditioner = options().value<std::string>("preconditioner");
+  const BlockPreconditioner::Type preconditioner_type = preconditioner == "ILU0" ? BlockPreconditioner::ILU0 :
+                                                        (preconditioner == "Jacobi" ? BlockPreconditioner::JACOBI : BlockPreconditioner::NONE);
+  m_preconditioner.compute(*m_matrix, preconditioner_type);
+
+  const std::vector<Uint>& rows = m_matrix->active_rows();
+  const Uint neq = m_matrix->neq();
+  std::vector<Real>& x = m_solution->data();
+  const std::vector<Real>& b = m_rhs->data();
+  const Uint size = x.size();
+  cf3_assert(b.size() == size);
+
+  std::vector<Real> r(size, 0.), r0(size, 0.), p(size, 0.), v(size, 0.), s(size, 0.), t(size, 0.), p_hat(size, 0.), s_hat(size, 0.);
+
+  // r = b - A x
+  m_matrix->multiply(x, r);
+  detail::axpby(rows, neq, 1., b, -1., r);
+
+  const Real b_norm = std::sqrt(detail::dot(rows, neq, b, b));
+  const Real threshold = m_tolerance * (b_norm > 0. ? b_norm : 1.);
+  Real r_norm = std::sqrt(detail::dot(rows, neq, r, r));
+
+  bool converged = r_norm <= threshold;
+  Uint iteration = 0;
+  r0 = r;
+  Real rho = 1., alpha = 1., omega = 1.;
+  while(!converged && iteration != m_max_iterations)
+  {
+    ++iteration;
+    const Real rho_new = detail::dot(rows, neq, r0, r);
+    if(rho_new == 0.)
+      break;
+
+    // p = r + beta*(p - omega*v)
+    if(iteration == 1)
+    {
+      p = r;
+    }
+    else
+    {
+      const Real beta = (rho_new/rho) * (alpha/omega);
+      detail::axpby(rows, neq, -omega, v, 1., p);
+      detail::axpby(rows, neq, 1., r, beta, p);
+    }
+
+    m_preconditioner.apply(p, p_hat);
+    m_matrix->multiply(p_hat, v);
+    const Real r0_v = detail::dot(rows, neq, r0, v);
+    if(r0_v == 0.)
+      break;
+    alpha = rho_new / r0_v;
+
+    // s = r - alpha*v
+    s = r;
+    detail::axpby(rows, neq, -alpha, v, 1., s);
+    const Real s_norm = std::sqrt(detail::dot(rows, neq, s, s));
+    if(s_norm <= threshold)
+    {
+      detail::axpby(rows, neq, alpha, p_hat, 1., x);
+      r_norm = s_norm;
+      converged = true;
+      break;
+    }
+
+    m_preconditioner.apply(s, s_hat);
+    m_matrix->multiply(s_hat, t);
+    const Real t_t = detail::dot(rows, neq, t, t);
+    omega = t_t == 0. ? 0. : detail::dot(rows, neq, t, s) / t_t;
+
+    // x += alpha*p_hat + omega*s_hat and r = s - omega*t
+    detail::axpby(rows, neq, alpha, p_hat, 1., x);
+    detail::axpby(rows, neq, omega, s_hat, 1., x);
+    r = s;
+    detail::axpby(rows, neq, -omega, t, 1., r);
+    r_norm = std::sqrt(detail::dot(rows, neq, r, r));
+    converged = r_norm <= threshold;
+
+    if(omega == 0.)
+      break;
+    rho = rho_new;
+  }
+
+  m_solution->sync();
+
+  const Real relative_residual = b_norm > 0. ? r_norm / b_norm : r_norm;
+  properties()["iterations"] = iteration;
+  properties()["residual"] = relative_residual;
+
+  if(converged)
+    CFdebug << "BlockCSRStrategy " << uri().path() << " converged in " << iteration << " iterations, relative residual " << relative_residual << CFendl;
+  else
+    CFwarn << "BlockCSRStrategy " << uri().path() << " did not converge after " << iteration << " iterations, relative residual " << relative_residual << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Real BlockCSRStrategy::compute_residual()
+{
+  check_setup();
+
+  const std::vector<Uint>& rows = m_matrix->active_rows();
+  const Uint neq = m_matrix->neq();
+  std::vector<Real> r(m_rhs->data().size(), 0.);
+  m_matrix->multiply(m_solution->data(), r);
+  detail::axpby(rows, neq, 1., m_rhs->data(), -1., r);
+  return std::sqrt(detail::dot(rows, neq, r, r));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRStrategy::set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
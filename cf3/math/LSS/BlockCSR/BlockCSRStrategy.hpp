@@ -0,0 +1,73 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_BlockCSRStrategy_hpp
+#define cf3_Math_LSS_BlockCSRStrategy_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "math/LSS/SolutionStrategy.hpp"
+#include "math/LSS/BlockCSR/BlockPreconditioner.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file BlockCSRStrategy.hpp Preconditioned BiCGStab solver for the native block CSR matrix
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+class BlockCSRMatrix;
+class BlockCSRVector;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Solves a system with a BlockCSRMatrix using BiCGStab, with block-ILU(0), block-Jacobi or no preconditioning.
+/// The current value of the solution vector is used as initial guess.
+class LSS_API BlockCSRStrategy : public SolutionStrategy
+{
+public:
+  /// Default constructor
+  BlockCSRStrategy(const std::string& name);
+  ~BlockCSRStrategy();
+
+  /// name of the type
+  static std::string type_name () { return "BlockCSRStrategy"; }
+
+  void set_matrix(const Handle<LSS::Matrix>& matrix);
+  void set_rhs(const Handle<LSS::Vector>& rhs);
+  void set_solution(const Handle<LSS::Vector>& solution);
+  void solve();
+  Real compute_residual();
+
+  /// Coordinates are not used by the block preconditioners
+  virtual void set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active);
+
+private:
+  /// Check that the matrix and vectors are set
+  void check_setup();
+
+  Handle<BlockCSRMatrix> m_matrix;
+  Handle<BlockCSRVector> m_rhs;
+  Handle<BlockCSRVector> m_solution;
+
+  BlockPreconditioner m_preconditioner;
+
+  Uint m_max_iterations;
+  Real m_tolerance;
+}; // end of class BlockCSRStrategy
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_BlockCSRStrategy_hpp
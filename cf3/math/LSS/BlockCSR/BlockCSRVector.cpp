@@ -0,0 +1,408 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <fstream>
+
+#include "common/Assertions.hpp"
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+
+#include "math/LSS/BlockCSR/BlockCSRDetail.hpp"
+#include "math/LSS/BlockCSR/BlockCSRVector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file BlockCSRVector.cpp Implementation of LSS::Vector for the native block CSR solver.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::math::LSS;
+
+common::ComponentBuilder < LSS::BlockCSRVector, LSS::Vector, LSS::LibLSS > BlockCSRVector_Builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+BlockCSRVector::BlockCSRVector(const std::string& name) :
+  LSS::Vector(name),
+  m_neq(0),
+  m_blockrow_size(0),
+  m_is_created(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::create(common::PE::CommPattern& cp, Uint neq, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  if (m_is_created) destroy();
+
+  m_neq=neq;
+  m_blockrow_size=cp.isUpdatable().size();
+  detail::create_node_map(m_blockrow_size, m_node_map, periodic_links_nodes, periodic_links_active);
+  m_data.assign(m_blockrow_size*m_neq, 0.);
+
+  m_comm_pattern = detail::copy_comm_pattern(cp, "CommPattern");
+  if(is_not_null(m_comm_pattern))
+    m_comm_pattern->insert(name(), m_data, m_neq, true);
+
+  m_is_created=true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  throw common::NotImplemented(FromHere(), "create_blocked is not implemented for BlockCSRVector");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::destroy()
+{
+  if(is_not_null(m_comm_pattern) && is_not_null(m_comm_pattern->get_child(name())))
+    m_comm_pattern->remove_component(name());
+  m_comm_pattern.reset();
+  m_data.clear();
+  m_node_map.clear();
+  m_neq=0;
+  m_blockrow_size=0;
+  m_is_created=false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::set_value(const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  m_data[index(irow/m_neq, irow%m_neq)]=value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::add_value(const Uint irow, const Real value)
+{
+  cf3_assert(m_is_created);
+  m_data[index(irow/m_neq, irow%m_neq)]+=value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::get_value(const Uint irow, Real& value)
+{
+  cf3_assert(m_is_created);
+  value=m_data[index(irow/m_neq, irow%m_neq)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::set_value(const Uint iblockrow, const Uint ieq, const Real value)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(iblockrow<m_blockrow_size);
+  m_data[index(iblockrow, ieq)]=value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::add_value(const Uint iblockrow, const Uint ieq, const Real value)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(iblockrow<m_blockrow_size);
+  m_data[index(iblockrow, ieq)]+=value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::get_value(const Uint iblockrow, const Uint ieq, Real& value)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(iblockrow<m_blockrow_size);
+  value=m_data[index(iblockrow, ieq)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::set_rhs_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks=values.indices.size();
+  const Real* vals=values.rhs.data();
+  for (Uint i=0; i!=nb_blocks; ++i)
+  {
+    cf3_assert(values.indices[i] < m_blockrow_size);
+    Real* block=&m_data[index(values.indices[i], 0)];
+    for (Uint j=0; j!=m_neq; ++j)
+      block[j]=*vals++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::add_rhs_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks=values.indices.size();
+  const Real* vals=values.rhs.data();
+  for (Uint i=0; i!=nb_blocks; ++i)
+  {
+    cf3_assert(values.indices[i] < m_blockrow_size);
+    Real* block=&m_data[index(values.indices[i], 0)];
+    for (Uint j=0; j!=m_neq; ++j)
+      block[j]+=*vals++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::get_rhs_values(BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks=values.indices.size();
+  Real* vals=values.rhs.data();
+  for (Uint i=0; i!=nb_blocks; ++i)
+  {
+    cf3_assert(values.indices[i] < m_blockrow_size);
+    const Real* block=&m_data[index(values.indices[i], 0)];
+    for (Uint j=0; j!=m_neq; ++j)
+      *vals++=block[j];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::set_sol_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks=values.indices.size();
+  const Real* vals=values.sol.data();
+  for (Uint i=0; i!=nb_blocks; ++i)
+  {
+    cf3_assert(values.indices[i] < m_blockrow_size);
+    Real* block=&m_data[index(values.indices[i], 0)];
+    for (Uint j=0; j!=m_neq; ++j)
+      block[j]=*vals++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::add_sol_values(const BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks=values.indices.size();
+  const Real* vals=values.sol.data();
+  for (Uint i=0; i!=nb_blocks; ++i)
+  {
+    cf3_assert(values.indices[i] < m_blockrow_size);
+    Real* block=&m_data[index(values.indices[i], 0)];
+    for (Uint j=0; j!=m_neq; ++j)
+      block[j]+=*vals++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::get_sol_values(BlockAccumulator& values)
+{
+  cf3_assert(m_is_created);
+  const Uint nb_blocks=values.indices.size();
+  Real* vals=values.sol.data();
+  for (Uint i=0; i!=nb_blocks; ++i)
+  {
+    cf3_assert(values.indices[i] < m_blockrow_size);
+    const Real* block=&m_data[index(values.indices[i], 0)];
+    for (Uint j=0; j!=m_neq; ++j)
+      *vals++=block[j];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::reset(Real reset_to)
+{
+  cf3_assert(m_is_created);
+  m_data.assign(m_data.size(), reset_to);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::get( boost::multi_array<Real, 2>& data)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(data.shape()[0]==m_blockrow_size);
+  cf3_assert(data.shape()[1]==m_neq);
+  for (Uint i=0; i!=m_blockrow_size; ++i)
+    for (Uint j=0; j!=m_neq; ++j)
+      data[i][j]=m_data[index(i, j)];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::set( boost::multi_array<Real, 2>& data)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(data.shape()[0]==m_blockrow_size);
+  cf3_assert(data.shape()[1]==m_neq);
+  for (Uint i=0; i!=m_blockrow_size; ++i)
+    for (Uint j=0; j!=m_neq; ++j)
+      m_data[index(i, j)]=data[i][j];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::print(common::LogStream& stream)
+{
+  if (m_is_created)
+  {
+    for (Uint i=0; i!=m_blockrow_size; ++i)
+      for (Uint j=0; j!=m_neq; ++j)
+        stream << 0 << " " << -(int)(i*m_neq+j) << " " << m_data[index(i, j)] << "\n";
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << m_blockrow_size*m_neq << "\n";
+    stream << "# number of block rows: " << m_blockrow_size << "\n";
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::print(std::ostream& stream)
+{
+  if (m_is_created)
+  {
+    for (Uint i=0; i!=m_blockrow_size; ++i)
+      for (Uint j=0; j!=m_neq; ++j)
+        stream << 0 << " " << -(int)(i*m_neq+j) << " " << m_data[index(i, j)] << "\n";
+    stream << "# name:                 " << name() << "\n";
+    stream << "# type_name:            " << type_name() << "\n";
+    stream << "# process:              " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:  " << m_neq << "\n";
+    stream << "# number of rows:       " << m_blockrow_size*m_neq << "\n";
+    stream << "# number of block rows: " << m_blockrow_size << "\n" << std::flush;
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::print(const std::string& filename, std::ios_base::openmode mode)
+{
+  std::ofstream stream(filename.c_str(),mode);
+  stream << "VARIABLES=COL,ROW,VAL\n" << std::flush;
+  stream << "ZONE T=\"" << type_name() << "::" << name() <<  "\"\n" << std::flush;
+  print(stream);
+  stream.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::print_native(std::ostream& stream)
+{
+  print(stream);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::debug_data(std::vector<Real>& values)
+{
+  cf3_assert(m_is_created);
+  values.clear();
+  values.reserve(m_blockrow_size*m_neq);
+  for (Uint i=0; i!=m_blockrow_size; ++i)
+    for (Uint j=0; j!=m_neq; ++j)
+      values.push_back(m_data[index(i, j)]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::clone_to(Vector &other)
+{
+  if(!m_is_created)
+    throw common::SetupError(FromHere(), "Vector to clone " + uri().string() + " is not created");
+  BlockCSRVector* other_ptr = dynamic_cast<BlockCSRVector*>(&other);
+  if(is_null(other_ptr))
+    throw common::SetupError(FromHere(), "clone_to method of BlockCSRVector needs another BlockCSRVector, but a " + other.derived_type_name() + " was supplied instead.");
+  other_ptr->destroy();
+  other_ptr->m_data = m_data;
+  other_ptr->m_neq = m_neq;
+  other_ptr->m_blockrow_size = m_blockrow_size;
+  other_ptr->m_node_map = m_node_map;
+  other_ptr->m_is_created = m_is_created;
+  other_ptr->m_comm_pattern = m_comm_pattern;
+  if(is_not_null(m_comm_pattern))
+    m_comm_pattern->insert(other_ptr->name(), other_ptr->m_data, m_neq, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::assign(const Vector& source)
+{
+  BlockCSRVector const* source_ptr = dynamic_cast<BlockCSRVector const*>(&source);
+
+  if(is_null(source_ptr))
+    throw common::SetupError(FromHere(), "assign method of BlockCSRVector needs another BlockCSRVector, but a " + source.derived_type_name() + " was supplied instead.");
+
+  if(source_ptr->m_data.size() != m_data.size())
+    throw common::SetupError(FromHere(), "assign method of BlockCSRVector got a vector with incorrect size");
+
+  m_data.assign(source_ptr->m_data.begin(), source_ptr->m_data.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::update ( const Vector& source, const Real alpha )
+{
+  BlockCSRVector const* source_ptr = dynamic_cast<BlockCSRVector const*>(&source);
+
+  if(is_null(source_ptr))
+    throw common::SetupError(FromHere(), "update method of BlockCSRVector needs another BlockCSRVector, but a " + source.derived_type_name() + " was supplied instead.");
+
+  if(source_ptr->m_data.size() != m_data.size())
+    throw common::SetupError(FromHere(), "update method of BlockCSRVector got a vector with incorrect size");
+
+  const Uint size = m_data.size();
+  for(Uint i = 0; i != size; ++i)
+    m_data[i] += alpha*source_ptr->m_data[i];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::scale ( const Real alpha )
+{
+  const Uint size = m_data.size();
+  for(Uint i = 0; i != size; ++i)
+    m_data[i] *= alpha;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::sync()
+{
+  if(is_not_null(m_comm_pattern))
+    m_comm_pattern->synchronize(name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockCSRVector::read_native(const common::URI& filename, const std::string type)
+{
+  throw common::NotImplemented(FromHere(), "read_native method is not implemented for " + derived_type_name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
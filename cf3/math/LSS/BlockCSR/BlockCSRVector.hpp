@@ -0,0 +1,196 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_BlockCSRVector_hpp
+#define cf3_Math_LSS_BlockCSRVector_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "math/LSS/LibLSS.hpp"
+#include "math/LSS/BlockAccumulator.hpp"
+#include "math/LSS/Vector.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file BlockCSRVector.hpp Definition of LSS::Vector for the native block CSR solver.
+
+  Values are stored per node in process local numbering, with the neq values of each node stored contiguously.
+  Ghost nodes are kept in place, and are updated from their owner by sync().
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API BlockCSRVector : public LSS::Vector {
+public:
+
+  /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
+  //@{
+
+  /// name of the type
+  static std::string type_name () { return "BlockCSRVector"; }
+
+  /// Accessor to solver type
+  const std::string solvertype() { return "BlockCSR"; }
+
+  /// Default constructor
+  BlockCSRVector(const std::string& name);
+
+  /// Setup sparsity structure
+  void create(common::PE::CommPattern& cp, Uint neq, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Not supported, since it breaks the block structure
+  void create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Deallocate underlying data
+  void destroy();
+
+  //@} END CREATION, DESTRUCTION AND COMPONENT SYSTEM
+
+  /// @name INDIVIDUAL ACCESS
+  //@{
+
+  /// Set value at given location in the matrix
+  void set_value(const Uint irow, const Real value);
+
+  /// Add value at given location in the matrix
+  void add_value(const Uint irow, const Real value);
+
+  /// Get value at given location in the matrix
+  void get_value(const Uint irow, Real& value);
+
+  /// Set value at given location in the matrix
+  void set_value(const Uint iblockrow, const Uint ieq, const Real value);
+
+  /// Add value at given location in the matrix
+  void add_value(const Uint iblockrow, const Uint ieq, const Real value);
+
+  /// Get value at given location in the matrix
+  void get_value(const Uint iblockrow, const Uint ieq, Real& value);
+
+  //@} END INDIVIDUAL ACCESS
+
+  /// @name EFFICCIENT ACCESS
+  //@{
+
+  /// Set a list of values to rhs
+  void set_rhs_values(const BlockAccumulator& values);
+
+  /// Add a list of values to rhs
+  void add_rhs_values(const BlockAccumulator& values);
+
+  /// Get a list of values from rhs
+  void get_rhs_values(BlockAccumulator& values);
+
+  /// Set a list of values to sol
+  void set_sol_values(const BlockAccumulator& values);
+
+  /// Add a list of values to sol
+  void add_sol_values(const BlockAccumulator& values);
+
+  /// Get a list of values from sol
+  void get_sol_values(BlockAccumulator& values);
+
+  /// Reset Vector
+  void reset(Real reset_to=0.);
+
+  /// Copies the contents out of the LSS::Vector to table.
+  void get( boost::multi_array<Real, 2>& data);
+
+  /// Copies the contents of the table into the LSS::Vector.
+  void set( boost::multi_array<Real, 2>& data);
+
+  //@} END EFFICCIENT ACCESS
+
+  /// @name MISCELLANEOUS
+  //@{
+
+  /// Print to wherever
+  void print(common::LogStream& stream);
+
+  /// Print to wherever
+  void print(std::ostream& stream);
+
+  /// Print to file given by filename
+  void print(const std::string& filename, std::ios_base::openmode mode = std::ios_base::out );
+
+  void print_native(std::ostream& stream);
+
+  /// Accessor to the state of create
+  const bool is_created() { return m_is_created; }
+
+  /// Accessor to the number of equations
+  const Uint neq() { return m_neq; }
+
+  /// Accessor to the number of block rows
+  const Uint blockrow_size() { return m_blockrow_size; }
+
+  void clone_to(Vector &other);
+
+  void assign(const Vector& source);
+
+  void update ( const Vector& source, const Real alpha = 1. );
+
+  void scale ( const Real alpha );
+
+  void sync();
+
+  void read_native(const common::URI& filename, const std::string type = "");
+
+  /// Storage of the values, neq values per process local node.
+  /// Nodes with a periodic link have no storage of their own, their values are those of the linked node.
+  /// @attention this function is not part of the interface, only used between the BlockCSR classes
+  std::vector<Real>& data() { return m_data; }
+  const std::vector<Real>& data() const { return m_data; }
+
+  //@} END MISCELLANEOUS
+
+  /// @name TEST ONLY
+  //@{
+
+  /// exports the vector into big linear array
+  /// @attention only for debug and utest purposes
+  void debug_data(std::vector<Real>& values);
+
+  //@} END TEST ONLY
+
+private:
+
+  /// Index in m_data of the given equation for the given node
+  Uint index(const Uint iblockrow, const Uint ieq) const { return m_node_map[iblockrow]*m_neq + ieq; }
+
+  /// Actual vector data
+  std::vector<Real> m_data;
+
+  /// number of equations
+  Uint m_neq;
+
+  /// number of blocks
+  Uint m_blockrow_size;
+
+  /// status of the vector
+  bool m_is_created;
+
+  /// maps each process local node to the node that stores its values, to account for periodic links
+  std::vector<Uint> m_node_map;
+
+  /// The comm pattern is kept as shared ptr, so it can be shared between any clones of this vector.
+  boost::shared_ptr<common::PE::CommPattern> m_comm_pattern;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_BlockCSRVector_hpp
@@ -0,0 +1,306 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "common/BasicExceptions.hpp"
+#include "common/StringConversion.hpp"
+
+#include "math/Consts.hpp"
+
+#include "math/LSS/BlockCSR/BlockCSRDetail.hpp"
+#include "math/LSS/BlockCSR/BlockCSRMatrix.hpp"
+#include "math/LSS/BlockCSR/BlockPreconditioner.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Invert the diagonal blocks of the matrix
+struct InvertDiagonal
+{
+  InvertDiagonal(const BlockCSRMatrix& matrix, const std::vector<Real>& values, std::vector<Real>& inverse_diagonal, const int neq) :
+    matrix(matrix),
+    values(values),
+    inverse_diagonal(inverse_diagonal),
+    neq(neq)
+  {
+  }
+
+  template<int N>
+  void apply()
+  {
+    const int n = block_size<N>(neq);
+    const Uint nn = n*n;
+    std::vector<Real> work(nn);
+    const std::vector<Uint>& active_rows = matrix.active_rows();
+    const std::vector<Uint>& diagonal_positions = matrix.diagonal_positions();
+    const Uint nb_rows = active_rows.size();
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      const Uint row = active_rows[i];
+      if(!block_invert<N>(&values[diagonal_positions[row]*nn], &inverse_diagonal[row*nn], &work[0], n))
+        throw common::BadValue(FromHere(), "Singular diagonal block in block row " + common::to_str(row));
+    }
+  }
+
+  const BlockCSRMatrix& matrix;
+  const std::vector<Real>& values;
+  std::vector<Real>& inverse_diagonal;
+  const int neq;
+};
+
+/// Incomplete block LU factorization without fill-in, in row (IKJ) order
+struct FactorizeILU0
+{
+  FactorizeILU0(const BlockCSRMatrix& matrix, const std::vector<bool>& is_active, std::vector<Real>& factors, std::vector<Real>& inverse_diagonal, const int neq) :
+    matrix(matrix),
+    is_active(is_active),
+    factors(factors),
+    inverse_diagonal(inverse_diagonal),
+    neq(neq)
+  {
+  }
+
+  template<int N>
+  void apply()
+  {
+    const int n = block_size<N>(neq);
+    const Uint nn = n*n;
+    const std::vector<Uint>& active_rows = matrix.active_rows();
+    const std::vector<Uint>& row_offsets = matrix.row_offsets();
+    const std::vector<Uint>& columns = matrix.column_indices();
+    const std::vector<Uint>& diagonal_positions = matrix.diagonal_positions();
+
+    const Uint not_found = math::Consts::uint_max();
+    std::vector<Uint> position(row_offsets.size()-1, not_found);
+    std::vector<Real> product(nn);
+    std::vector<Real> work(nn);
+
+    const Uint nb_rows = active_rows.size();
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      const Uint row = active_rows[i];
+      const Uint row_begin = row_offsets[row];
+      const Uint row_end = row_offsets[row+1];
+      for(Uint p = row_begin; p != row_end; ++p)
+        position[columns[p]] = p;
+
+      for(Uint p = row_begin; p != diagonal_positions[row]; ++p)
+      {
+        const Uint k = columns[p];
+        if(!is_active[k])
+          continue;
+
+        // L_ik = A_ik U_kk^-1
+        Real* l_ik = &factors[p*nn];
+        block_gemm<N>(l_ik, &inverse_diagonal[k*nn], &product[0], n);
+        std::copy(product.begin(), product.end(), l_ik);
+
+        // A_ij -= L_ik U_kj, for the j > k present in row i
+        const Uint k_end = row_offsets[k+1];
+        for(Uint q = diagonal_positions[k]+1; q != k_end; ++q)
+        {
+          const Uint pos_ij = position[columns[q]];
+          if(pos_ij != not_found)
+            block_gemm_sub<N>(l_ik, &factors[q*nn], &factors[pos_ij*nn], n);
+        }
+      }
+
+      if(!block_invert<N>(&factors[diagonal_positions[row]*nn], &inverse_diagonal[row*nn], &work[0], n))
+        throw common::BadValue(FromHere(), "Singular pivot block in the ILU factorization at block row " + common::to_str(row));
+
+      for(Uint p = row_begin; p != row_end; ++p)
+        position[columns[p]] = not_found;
+    }
+  }
+
+  const BlockCSRMatrix& matrix;
+  const std::vector<bool>& is_active;
+  std::vector<Real>& factors;
+  std::vector<Real>& inverse_diagonal;
+  const int neq;
+};
+
+/// Apply the block-Jacobi preconditioner
+struct ApplyJacobi
+{
+  ApplyJacobi(const BlockCSRMatrix& matrix, const std::vector<Real>& inverse_diagonal, const std::vector<Real>& r, std::vector<Real>& z, const int neq) :
+    matrix(matrix),
+    inverse_diagonal(inverse_diagonal),
+    r(r),
+    z(z),
+    neq(neq)
+  {
+  }
+
+  template<int N>
+  void apply()
+  {
+    const int n = block_size<N>(neq);
+    const Uint nn = n*n;
+    const std::vector<Uint>& active_rows = matrix.active_rows();
+    const Uint nb_rows = active_rows.size();
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      const Uint row = active_rows[i];
+      block_gemv<N>(&inverse_diagonal[row*nn], &r[row*n], &z[row*n], n);
+    }
+  }
+
+  const BlockCSRMatrix& matrix;
+  const std::vector<Real>& inverse_diagonal;
+  const std::vector<Real>& r;
+  std::vector<Real>& z;
+  const int neq;
+};
+
+/// Forward and backward substitution with the ILU(0) factors
+struct ApplyILU0
+{
+  ApplyILU0(const BlockCSRMatrix& matrix, const std::vector<bool>& is_active, const std::vector<Real>& factors, const std::vector<Real>& inverse_diagonal, const std::vector<Real>& r, std::vector<Real>& z, const int neq) :
+    matrix(matrix),
+    is_active(is_active),
+    factors(factors),
+    inverse_diagonal(inverse_diagonal),
+    r(r),
+    z(z),
+    neq(neq)
+  {
+  }
+
+  template<int N>
+  void apply()
+  {
+    const int n = block_size<N>(neq);
+    const Uint nn = n*n;
+    const std::vector<Uint>& active_rows = matrix.active_rows();
+    const std::vector<Uint>& row_offsets = matrix.row_offsets();
+    const std::vector<Uint>& columns = matrix.column_indices();
+    const std::vector<Uint>& diagonal_positions = matrix.diagonal_positions();
+    std::vector<Real> tmp(n);
+
+    // Solve L y = r, with unit diagonal blocks
+    const Uint nb_rows = active_rows.size();
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      const Uint row = active_rows[i];
+      Real* z_row = &z[row*n];
+      for(int j = 0; j != n; ++j)
+        z_row[j] = r[row*n+j];
+      for(Uint p = row_offsets[row]; p != diagonal_positions[row]; ++p)
+      {
+        if(is_active[columns[p]])
+          block_gemv_sub<N>(&factors[p*nn], &z[columns[p]*n], z_row, n);
+      }
+    }
+
+    // Solve U z = y
+    for(Uint i = nb_rows; i != 0; --i)
+    {
+      const Uint row = active_rows[i-1];
+      Real* z_row = &z[row*n];
+      const Uint row_end = row_offsets[row+1];
+      for(Uint p = diagonal_positions[row]+1; p != row_end; ++p)
+      {
+        if(is_active[columns[p]])
+          block_gemv_sub<N>(&factors[p*nn], &z[columns[p]*n], z_row, n);
+      }
+      std::copy(z_row, z_row+n, tmp.begin());
+      block_gemv<N>(&inverse_diagonal[row*nn], &tmp[0], z_row, n);
+    }
+  }
+
+  const BlockCSRMatrix& matrix;
+  const std::vector<bool>& is_active;
+  const std::vector<Real>& factors;
+  const std::vector<Real>& inverse_diagonal;
+  const std::vector<Real>& r;
+  std::vector<Real>& z;
+  const int neq;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+BlockPreconditioner::BlockPreconditioner() :
+  m_type(NONE),
+  m_matrix(0),
+  m_neq(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockPreconditioner::compute(BlockCSRMatrix& matrix, const Type type)
+{
+  m_type = type;
+  m_matrix = &matrix;
+  m_factors.clear();
+  m_neq = matrix.neq();
+
+  if(m_type == NONE)
+    return;
+
+  const Uint neq = m_neq;
+  const Uint nb_rows = matrix.blockrow_size();
+  m_inverse_diagonal.assign(nb_rows*neq*neq, 0.);
+
+  if(m_type == JACOBI)
+  {
+    detail::InvertDiagonal f(matrix, matrix.values(), m_inverse_diagonal, neq);
+    detail::dispatch_block_size(neq, f);
+    return;
+  }
+
+  m_is_active.assign(nb_rows, false);
+  const std::vector<Uint>& active_rows = matrix.active_rows();
+  for(std::vector<Uint>::const_iterator it = active_rows.begin(); it != active_rows.end(); ++it)
+    m_is_active[*it] = true;
+
+  m_factors = matrix.values();
+  detail::FactorizeILU0 f(matrix, m_is_active, m_factors, m_inverse_diagonal, neq);
+  detail::dispatch_block_size(neq, f);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void BlockPreconditioner::apply(const std::vector<Real>& r, std::vector<Real>& z) const
+{
+  cf3_assert(r.size() == z.size());
+  if(m_type == NONE)
+  {
+    z = r;
+    return;
+  }
+
+  cf3_assert(m_matrix != 0);
+  const Uint neq = m_neq;
+  if(m_type == JACOBI)
+  {
+    detail::ApplyJacobi f(*m_matrix, m_inverse_diagonal, r, z, neq);
+    detail::dispatch_block_size(neq, f);
+  }
+  else
+  {
+    detail::ApplyILU0 f(*m_matrix, m_is_active, m_factors, m_inverse_diagonal, r, z, neq);
+    detail::dispatch_block_size(neq, f);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
@@ -0,0 +1,78 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_BlockPreconditioner_hpp
+#define cf3_Math_LSS_BlockPreconditioner_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include "common/CF.hpp"
+
+#include "math/LSS/LibLSS.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file BlockPreconditioner.hpp Block-Jacobi and block-ILU(0) preconditioning for BlockCSRMatrix
+
+  Both preconditioners only use the blocks coupling rows owned by the same process, so in parallel
+  they act as a block-Jacobi method between the processes.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+class BlockCSRMatrix;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API BlockPreconditioner
+{
+public:
+
+  enum Type { NONE, JACOBI, ILU0 };
+
+  BlockPreconditioner();
+
+  /// Compute the preconditioner for the current values of the matrix
+  /// @throw common::BadValue if a singular diagonal block is encountered
+  void compute(BlockCSRMatrix& matrix, const Type type);
+
+  /// Compute z = M^-1 r, for the active rows of the matrix
+  void apply(const std::vector<Real>& r, std::vector<Real>& z) const;
+
+private:
+
+  Type m_type;
+
+  /// Matrix that was used in the last call to compute
+  const BlockCSRMatrix* m_matrix;
+
+  /// Number of equations of m_matrix
+  Uint m_neq;
+
+  /// Inverse of the (factored) diagonal block of each row
+  std::vector<Real> m_inverse_diagonal;
+
+  /// ILU(0) factors, in the sparsity structure of the matrix. The strictly lower blocks hold L, the strictly upper blocks hold U.
+  std::vector<Real> m_factors;
+
+  /// true for the rows owned by this process and not linked to another row
+  std::vector<bool> m_is_active;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_BlockPreconditioner_hpp
@@ -0,0 +1,710 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <boost/bind.hpp>
+
+#include "common/Assertions.hpp"
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "common/PropertyList.hpp"
+#include "common/StringConversion.hpp"
+
+#include "math/LSS/BlockCSR/BlockCSRDetail.hpp"
+#include "math/LSS/BlockCSR/BlockCSRVector.hpp"
+#include "math/LSS/MatrixFree/MatrixFreeMatrix.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file MatrixFreeMatrix.cpp Implementation of LSS::Matrix for the matrix-free operator on tensor-product hexahedra.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < LSS::MatrixFreeMatrix, LSS::Matrix, LSS::LibLSS > MatrixFreeMatrix_Builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+MatrixFreeMatrix::MatrixFreeMatrix(const std::string& name) :
+  LSS::Matrix(name),
+  m_is_created(false),
+  m_neq(0),
+  m_blockrow_size(0),
+  m_mass_coefficient(0.),
+  m_diffusion_coefficient(1.),
+  m_nb_elements(0),
+  m_operator_diagonal_valid(false),
+  m_has_constraints(false)
+{
+  properties().add("vector_type", std::string("cf3.math.LSS.BlockCSRVector"));
+
+  options().add("mass_coefficient", m_mass_coefficient)
+    .pretty_name("Mass Coefficient")
+    .description("Factor for the mass matrix in the operator")
+    .link_to(&m_mass_coefficient)
+    .attach_trigger(boost::bind(&MatrixFreeMatrix::trigger_coefficients, this))
+    .mark_basic();
+
+  options().add("diffusion_coefficient", m_diffusion_coefficient)
+    .pretty_name("Diffusion Coefficient")
+    .description("Factor for the Laplacian in the operator")
+    .link_to(&m_diffusion_coefficient)
+    .attach_trigger(boost::bind(&MatrixFreeMatrix::trigger_coefficients, this))
+    .mark_basic();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  if (m_is_created) destroy();
+
+  const Uint nb_nodes = cp.isUpdatable().size();
+
+  m_neq = neq;
+  m_blockrow_size = nb_nodes;
+  detail::create_node_map(nb_nodes, m_node_map, periodic_links_nodes, periodic_links_active);
+
+  m_is_active.assign(nb_nodes, false);
+  m_active_rows.clear();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    if(cp.isUpdatable()[i] && m_node_map[i] == i)
+    {
+      m_is_active[i] = true;
+      m_active_rows.push_back(i);
+    }
+  }
+
+  m_diagonal_correction.assign(nb_nodes*m_neq, 0.);
+  m_constraints.assign(nb_nodes*m_neq, static_cast<Uint>(UNCONSTRAINED));
+  m_constrained_diagonal.assign(nb_nodes*m_neq, 0.);
+  m_has_constraints = false;
+
+  setup_ghost_exchange(cp);
+
+  m_is_created = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::create_blocked(cf3::common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  throw common::NotImplemented(FromHere(), "create_blocked is not implemented for MatrixFreeMatrix");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::destroy()
+{
+  m_node_map.clear();
+  m_is_active.clear();
+  m_active_rows.clear();
+  m_kernel = detail::SumFactorization();
+  m_nb_elements = 0;
+  m_element_rows.clear();
+  m_geometry.clear();
+  m_row_elements_offsets.clear();
+  m_row_elements.clear();
+  m_operator_diagonal.clear();
+  m_operator_diagonal_valid = false;
+  m_diagonal_correction.clear();
+  m_constraints.clear();
+  m_constrained_diagonal.clear();
+  m_has_constraints = false;
+  m_batch_in.clear();
+  m_batch_out.clear();
+  m_product.clear();
+  m_comm_pattern.reset();
+  m_ghosted_x.clear();
+  m_neq=0;
+  m_blockrow_size=0;
+  m_is_created=false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::set_operator(const Uint nb_dofs_1d, const Uint nb_qdr_1d, const std::vector<Real>& values_1d, const std::vector<Real>& derivatives_1d, const std::vector<Uint>& element_rows, const std::vector<Real>& geometry)
+{
+  if(!m_is_created)
+    throw common::SetupError(FromHere(), "MatrixFreeMatrix " + uri().path() + " must be created before setting the operator");
+
+  const Uint nb_dofs = nb_dofs_1d*nb_dofs_1d*nb_dofs_1d;
+  const Uint nb_qdr = nb_qdr_1d*nb_qdr_1d*nb_qdr_1d;
+  const Uint nb_factors = detail::SumFactorization::nb_geometric_factors;
+  if(nb_dofs == 0 || nb_qdr == 0)
+    throw common::BadValue(FromHere(), "MatrixFreeMatrix needs at least one node and one quadrature point per direction");
+  if(values_1d.size() != nb_dofs_1d*nb_qdr_1d || derivatives_1d.size() != nb_dofs_1d*nb_qdr_1d)
+    throw common::BadValue(FromHere(), "Size mismatch for the 1D shape function values or derivatives: expected " + common::to_str(nb_dofs_1d*nb_qdr_1d) + " entries");
+  if(element_rows.size() % nb_dofs != 0)
+    throw common::BadValue(FromHere(), "Size of the element rows " + common::to_str(element_rows.size()) + " is not a multiple of the number of nodes per element " + common::to_str(nb_dofs));
+
+  m_nb_elements = element_rows.size() / nb_dofs;
+  if(geometry.size() != m_nb_elements*nb_qdr*nb_factors)
+    throw common::BadValue(FromHere(), "Size mismatch for the geometric factors: expected " + common::to_str(m_nb_elements*nb_qdr*nb_factors) + " entries, got " + common::to_str(geometry.size()));
+
+  m_kernel.setup(nb_dofs_1d, nb_qdr_1d, values_1d, derivatives_1d, batch_size);
+
+  // Interleave the data of the elements in each batch, padding the last batch with empty elements
+  const Uint nb_batches = (m_nb_elements + batch_size - 1) / batch_size;
+  m_element_rows.assign(nb_batches*nb_dofs*batch_size, m_blockrow_size);
+  m_geometry.assign(nb_batches*nb_qdr*nb_factors*batch_size, 0.);
+  for(Uint elem = 0; elem != m_nb_elements; ++elem)
+  {
+    const Uint batch = elem / batch_size;
+    const Uint lane = elem % batch_size;
+    for(Uint i = 0; i != nb_dofs; ++i)
+    {
+      const Uint row = element_rows[elem*nb_dofs + i];
+      if(row >= m_blockrow_size)
+        throw common::BadValue(FromHere(), "Row " + common::to_str(row) + " of element " + common::to_str(elem) + " is out of range");
+      m_element_rows[(batch*nb_dofs + i)*batch_size + lane] = m_node_map[row];
+    }
+    for(Uint j = 0; j != nb_qdr*nb_factors; ++j)
+      m_geometry[(batch*nb_qdr*nb_factors + j)*batch_size + lane] = geometry[elem*nb_qdr*nb_factors + j];
+  }
+
+  // Elements around each row, for the dirichlet columns
+  m_row_elements_offsets.assign(m_blockrow_size+1, 0u);
+  for(Uint batch = 0; batch != nb_batches; ++batch)
+  {
+    for(Uint lane = 0; lane != batch_size; ++lane)
+    {
+      for(Uint i = 0; i != nb_dofs; ++i)
+      {
+        const Uint row = m_element_rows[(batch*nb_dofs + i)*batch_size + lane];
+        if(row != m_blockrow_size)
+          ++m_row_elements_offsets[row+1];
+      }
+    }
+  }
+  for(Uint row = 0; row != m_blockrow_size; ++row)
+    m_row_elements_offsets[row+1] += m_row_elements_offsets[row];
+  m_row_elements.resize(m_row_elements_offsets.back());
+  std::vector<Uint> fill_positions(m_row_elements_offsets.begin(), m_row_elements_offsets.end()-1);
+  for(Uint batch = 0; batch != nb_batches; ++batch)
+  {
+    for(Uint lane = 0; lane != batch_size; ++lane)
+    {
+      for(Uint i = 0; i != nb_dofs; ++i)
+      {
+        const Uint row = m_element_rows[(batch*nb_dofs + i)*batch_size + lane];
+        if(row != m_blockrow_size)
+          m_row_elements[fill_positions[row]++] = batch*batch_size + lane;
+      }
+    }
+  }
+
+  m_batch_in.assign(nb_dofs*batch_size, 0.);
+  m_batch_out.assign(nb_dofs*batch_size, 0.);
+  m_operator_diagonal_valid = false;
+
+  CFdebug << "Rank " << common::PE::Comm::instance().rank() << ": Matrix-free operator " << uri().path() << " has " << m_nb_elements << " elements with "
+          << nb_dofs_1d << "^3 nodes and " << nb_qdr_1d << "^3 quadrature points" << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::setup_ghost_exchange(common::PE::CommPattern& cp)
+{
+  m_ghosted_x.assign(m_blockrow_size*m_neq, 0.);
+  m_comm_pattern = detail::copy_comm_pattern(cp, "CommPattern");
+  if(is_not_null(m_comm_pattern))
+    m_comm_pattern->insert("x", m_ghosted_x, m_neq, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+BlockCSRVector& MatrixFreeMatrix::block_csr_vector(Vector& v, const std::string& function)
+{
+  BlockCSRVector* result = dynamic_cast<BlockCSRVector*>(&v);
+  if(is_null(result))
+    throw common::SetupError(FromHere(), function + " method of MatrixFreeMatrix needs a BlockCSRVector, but a " + v.derived_type_name() + " was supplied instead.");
+  return *result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::trigger_coefficients()
+{
+  m_operator_diagonal_valid = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::set_value(const Uint icol, const Uint irow, const Real value)
+{
+  throw common::NotImplemented(FromHere(), "set_value is not supported by MatrixFreeMatrix, since it stores no entries");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::add_value(const Uint icol, const Uint irow, const Real value)
+{
+  throw common::NotImplemented(FromHere(), "add_value is not supported by MatrixFreeMatrix, since it stores no entries");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::get_value(const Uint icol, const Uint irow, Real& value)
+{
+  throw common::NotImplemented(FromHere(), "get_value is not supported by MatrixFreeMatrix, since it stores no entries");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::set_values(const BlockAccumulator& values)
+{
+  throw common::NotImplemented(FromHere(), "set_values is not supported by MatrixFreeMatrix, the operator is set through set_operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::add_values(const BlockAccumulator& values)
+{
+  throw common::NotImplemented(FromHere(), "add_values is not supported by MatrixFreeMatrix, the operator is set through set_operator");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::get_values(BlockAccumulator& values)
+{
+  throw common::NotImplemented(FromHere(), "get_values is not supported by MatrixFreeMatrix, since it stores no entries");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval)
+{
+  cf3_assert(m_is_created);
+  if(offdiagval != 0.)
+    throw common::NotImplemented(FromHere(), "MatrixFreeMatrix only supports set_row with zero off-diagonal values");
+
+  const Uint row = m_node_map[iblockrow];
+  if(!m_is_active[row])
+    return;
+
+  const Uint idx = row*m_neq + ieq;
+  if(m_constraints[idx] == UNCONSTRAINED)
+    m_constraints[idx] = ROW;
+  m_constrained_diagonal[idx] = diagval;
+  m_has_constraints = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values)
+{
+  throw common::NotImplemented(FromHere(), "get_column_and_replace_to_zero is not implemented for MatrixFreeMatrix");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs)
+{
+  cf3_assert(m_is_created);
+  std::vector<Real>& rhs_data = block_csr_vector(rhs, "symmetric_dirichlet").data();
+  const Uint bc_row = m_node_map[blockrow];
+  const Uint nb_dofs = m_kernel.nb_dofs();
+  const Uint nb_qdr = m_kernel.nb_qdr();
+  const Uint nb_factors = detail::SumFactorization::nb_geometric_factors;
+
+  // Move the column to the RHS, computing it element by element. Constrained rows have no off-diagonal entries.
+  const Uint elements_end = m_row_elements_offsets.empty() ? 0 : m_row_elements_offsets[bc_row+1];
+  const Uint elements_begin = m_row_elements_offsets.empty() ? 0 : m_row_elements_offsets[bc_row];
+  for(Uint p = elements_begin; p != elements_end; ++p)
+  {
+    // Skip repeated entries for elements that contain the row more than once
+    if(p != elements_begin && m_row_elements[p] == m_row_elements[p-1])
+      continue;
+
+    const Uint batch = m_row_elements[p] / batch_size;
+    const Uint lane = m_row_elements[p] % batch_size;
+    const Uint* rows = &m_element_rows[batch*nb_dofs*batch_size];
+    std::fill(m_batch_in.begin(), m_batch_in.end(), 0.);
+    for(Uint i = 0; i != nb_dofs; ++i)
+    {
+      if(rows[i*batch_size + lane] == bc_row)
+        m_batch_in[i*batch_size + lane] = 1.;
+    }
+    m_kernel.apply<batch_size>(&m_geometry[batch*nb_qdr*nb_factors*batch_size], m_mass_coefficient, m_diffusion_coefficient, &m_batch_in[0], &m_batch_out[0]);
+    for(Uint i = 0; i != nb_dofs; ++i)
+    {
+      const Uint other_row = rows[i*batch_size + lane];
+      if(other_row == bc_row || !m_is_active[other_row])
+        continue;
+      const Uint rhs_idx = other_row*m_neq + ieq;
+      if(m_constraints[rhs_idx] != UNCONSTRAINED)
+        continue;
+      rhs_data[rhs_idx] -= m_batch_out[i*batch_size + lane] * value;
+    }
+  }
+
+  const Uint idx = bc_row*m_neq + ieq;
+  m_constraints[idx] = SYMMETRIC;
+  m_constrained_diagonal[idx] = 1.;
+  m_has_constraints = true;
+
+  rhs.set_value(blockrow, ieq, value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from)
+{
+  throw common::NotImplemented(FromHere(), "tie_blockrow_pairs is not implemented for MatrixFreeMatrix, periodic links must be passed to create");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::update_operator_diagonal()
+{
+  if(m_operator_diagonal_valid)
+    return;
+
+  m_operator_diagonal.assign(m_blockrow_size, 0.);
+  const Uint nb_dofs = m_kernel.nb_dofs();
+  const Uint nb_qdr = m_kernel.nb_qdr();
+  const Uint nb_factors = detail::SumFactorization::nb_geometric_factors;
+  const Uint nb_batches = nb_dofs == 0 ? 0 : m_element_rows.size() / (nb_dofs*batch_size);
+  for(Uint batch = 0; batch != nb_batches; ++batch)
+  {
+    m_kernel.diagonal<batch_size>(&m_geometry[batch*nb_qdr*nb_factors*batch_size], m_mass_coefficient, m_diffusion_coefficient, &m_batch_out[0]);
+    const Uint* rows = &m_element_rows[batch*nb_dofs*batch_size];
+    for(Uint i = 0; i != nb_dofs*batch_size; ++i)
+    {
+      if(rows[i] != m_blockrow_size)
+        m_operator_diagonal[rows[i]] += m_batch_out[i];
+    }
+  }
+
+  m_operator_diagonal_valid = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::set_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_blockrow_size*m_neq);
+  update_operator_diagonal();
+  for(Uint i = 0; i != m_blockrow_size; ++i)
+  {
+    const Uint row = m_node_map[i];
+    if(!m_is_active[row])
+      continue;
+    for(Uint a = 0; a != m_neq; ++a)
+    {
+      const Uint idx = row*m_neq + a;
+      if(m_constraints[idx] == UNCONSTRAINED)
+        m_diagonal_correction[idx] = diag[i*m_neq+a] - m_operator_diagonal[row];
+      else
+        m_constrained_diagonal[idx] = diag[i*m_neq+a];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::add_diagonal(const std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(diag.size() == m_blockrow_size*m_neq);
+  for(Uint i = 0; i != m_blockrow_size; ++i)
+  {
+    const Uint row = m_node_map[i];
+    if(!m_is_active[row])
+      continue;
+    for(Uint a = 0; a != m_neq; ++a)
+    {
+      const Uint idx = row*m_neq + a;
+      if(m_constraints[idx] == UNCONSTRAINED)
+        m_diagonal_correction[idx] += diag[i*m_neq+a];
+      else
+        m_constrained_diagonal[idx] += diag[i*m_neq+a];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::get_diagonal(std::vector<Real>& diag)
+{
+  cf3_assert(m_is_created);
+  update_operator_diagonal();
+  diag.assign(m_blockrow_size*m_neq, 0.);
+  for(Uint i = 0; i != m_blockrow_size; ++i)
+  {
+    const Uint row = m_node_map[i];
+    if(!m_is_active[row])
+      continue;
+    for(Uint a = 0; a != m_neq; ++a)
+    {
+      const Uint idx = row*m_neq + a;
+      diag[i*m_neq+a] = m_constraints[idx] == UNCONSTRAINED ? m_operator_diagonal[row] + m_diagonal_correction[idx] : m_constrained_diagonal[idx];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::reset(Real reset_to)
+{
+  cf3_assert(m_is_created);
+  if(reset_to != 0.)
+    throw common::BadValue(FromHere(), "MatrixFreeMatrix can only be reset to zero corrections, got " + common::to_str(reset_to));
+  m_diagonal_correction.assign(m_diagonal_correction.size(), 0.);
+  m_constraints.assign(m_constraints.size(), static_cast<Uint>(UNCONSTRAINED));
+  m_constrained_diagonal.assign(m_constrained_diagonal.size(), 0.);
+  m_has_constraints = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::print(common::LogStream& stream)
+{
+  std::stringstream sstream;
+  print(sstream);
+  stream << sstream.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::print(std::ostream& stream)
+{
+  if (m_is_created)
+  {
+    stream << "# name:                   " << name() << "\n";
+    stream << "# type_name:              " << type_name() << "\n";
+    stream << "# process:                " << common::PE::Comm::instance().rank() << "\n";
+    stream << "# number of equations:    " << m_neq << "\n";
+    stream << "# number of rows:         " << m_active_rows.size()*m_neq << "\n";
+    stream << "# number of cols:         " << m_blockrow_size*m_neq << "\n";
+    stream << "# number of elements:     " << m_nb_elements << "\n";
+    stream << "# nodes per direction:    " << m_kernel.nb_dofs_1d() << "\n";
+    stream << "# quadrature points:      " << m_kernel.nb_qdr_1d() << "\n";
+    stream << "# mass coefficient:       " << m_mass_coefficient << "\n";
+    stream << "# diffusion coefficient:  " << m_diffusion_coefficient << "\n" << std::flush;
+  } else {
+    stream << name() << " of type " << type_name() << "::is_created() is false, nothing is printed.";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::print(const std::string& filename, std::ios_base::openmode mode )
+{
+  std::ofstream stream(filename.c_str(),mode);
+  print(stream);
+  stream.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::print_native(std::ostream& stream)
+{
+  if (!m_is_created)
+    return;
+
+  const Uint nb_dofs = m_kernel.nb_dofs();
+  for(Uint elem = 0; elem != m_nb_elements; ++elem)
+  {
+    const Uint batch = elem / batch_size;
+    const Uint lane = elem % batch_size;
+    stream << "element " << elem << ":";
+    for(Uint i = 0; i != nb_dofs; ++i)
+      stream << " " << m_element_rows[(batch*nb_dofs + i)*batch_size + lane];
+    stream << "\n";
+  }
+  stream << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::clone_to(Matrix &other)
+{
+  if(!m_is_created)
+    throw common::SetupError(FromHere(), "Matrix to clone " + uri().string() + " is not created");
+
+  MatrixFreeMatrix* other_ptr = dynamic_cast<MatrixFreeMatrix*>(&other);
+  if(is_null(other_ptr))
+    throw common::SetupError(FromHere(), "clone_to method of MatrixFreeMatrix needs another MatrixFreeMatrix, but a " + other.derived_type_name() + " was supplied instead.");
+
+  other_ptr->destroy();
+  other_ptr->m_neq = m_neq;
+  other_ptr->m_blockrow_size = m_blockrow_size;
+  other_ptr->m_node_map = m_node_map;
+  other_ptr->m_is_active = m_is_active;
+  other_ptr->m_active_rows = m_active_rows;
+  other_ptr->options().set("mass_coefficient", m_mass_coefficient);
+  other_ptr->options().set("diffusion_coefficient", m_diffusion_coefficient);
+  other_ptr->m_kernel = m_kernel;
+  other_ptr->m_nb_elements = m_nb_elements;
+  other_ptr->m_element_rows = m_element_rows;
+  other_ptr->m_geometry = m_geometry;
+  other_ptr->m_row_elements_offsets = m_row_elements_offsets;
+  other_ptr->m_row_elements = m_row_elements;
+  other_ptr->m_operator_diagonal = m_operator_diagonal;
+  other_ptr->m_operator_diagonal_valid = m_operator_diagonal_valid;
+  other_ptr->m_diagonal_correction = m_diagonal_correction;
+  other_ptr->m_constraints = m_constraints;
+  other_ptr->m_constrained_diagonal = m_constrained_diagonal;
+  other_ptr->m_has_constraints = m_has_constraints;
+  other_ptr->m_batch_in = m_batch_in;
+  other_ptr->m_batch_out = m_batch_out;
+  if(is_not_null(m_comm_pattern))
+    other_ptr->setup_ghost_exchange(*m_comm_pattern);
+  else
+    other_ptr->m_ghosted_x.assign(m_blockrow_size*m_neq, 0.);
+  other_ptr->m_is_created = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::read_native(const common::URI& file)
+{
+  throw common::NotImplemented(FromHere(), "read_native method is not implemented for " + derived_type_name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::add_element_products(const Real* x, Real* y, const Uint ieq)
+{
+  const Uint nb_dofs = m_kernel.nb_dofs();
+  const Uint nb_qdr = m_kernel.nb_qdr();
+  const Uint nb_factors = detail::SumFactorization::nb_geometric_factors;
+  const Uint nb_batches = nb_dofs == 0 ? 0 : m_element_rows.size() / (nb_dofs*batch_size);
+  const Uint batch_values = nb_dofs*batch_size;
+  for(Uint batch = 0; batch != nb_batches; ++batch)
+  {
+    const Uint* rows = &m_element_rows[batch*batch_values];
+    for(Uint i = 0; i != batch_values; ++i)
+      m_batch_in[i] = rows[i] == m_blockrow_size ? 0. : x[rows[i]*m_neq + ieq];
+
+    m_kernel.apply<batch_size>(&m_geometry[batch*nb_qdr*nb_factors*batch_size], m_mass_coefficient, m_diffusion_coefficient, &m_batch_in[0], &m_batch_out[0]);
+
+    for(Uint i = 0; i != batch_values; ++i)
+    {
+      if(rows[i] != m_blockrow_size)
+        y[rows[i]*m_neq + ieq] += m_batch_out[i];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::multiply(const std::vector<Real>& x, std::vector<Real>& y)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(x.size() == m_blockrow_size*m_neq);
+  cf3_assert(y.size() == m_blockrow_size*m_neq);
+  if(m_active_rows.empty())
+    return;
+
+  const Real* x_data = &x[0];
+  if(is_not_null(m_comm_pattern) || m_has_constraints)
+  {
+    std::copy(x.begin(), x.end(), m_ghosted_x.begin());
+    if(is_not_null(m_comm_pattern))
+      m_comm_pattern->synchronize("x");
+    x_data = &m_ghosted_x[0];
+  }
+
+  // The columns of the symmetric dirichlet conditions were moved to the RHS
+  if(m_has_constraints)
+  {
+    const Uint size = m_constraints.size();
+    for(Uint i = 0; i != size; ++i)
+    {
+      if(m_constraints[i] == SYMMETRIC)
+        m_ghosted_x[i] = 0.;
+    }
+  }
+
+  // Ghost rows of y may be changed by the element products, so these are accumulated separately
+  m_product.assign(m_blockrow_size*m_neq, 0.);
+  for(Uint ieq = 0; ieq != m_neq; ++ieq)
+    add_element_products(x_data, &m_product[0], ieq);
+
+  for(std::vector<Uint>::const_iterator row_it = m_active_rows.begin(); row_it != m_active_rows.end(); ++row_it)
+  {
+    const Uint begin = *row_it*m_neq;
+    const Uint end = begin + m_neq;
+    for(Uint i = begin; i != end; ++i)
+      y[i] = m_constraints[i] == UNCONSTRAINED ? m_product[i] + m_diagonal_correction[i]*x[i] : m_constrained_diagonal[i]*x[i];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::apply(const Handle<Vector>& y, const Handle<Vector const>& x, const Real alpha, const Real beta)
+{
+  Handle<BlockCSRVector> y_vec(y);
+  Handle<BlockCSRVector const> x_vec(x);
+  if(is_null(y_vec) || is_null(x_vec))
+    throw common::SetupError(FromHere(), "MatrixFreeMatrix::apply must be given BlockCSRVector arguments");
+
+  std::vector<Real> ax(m_blockrow_size*m_neq, 0.);
+  multiply(x_vec->data(), ax);
+
+  std::vector<Real>& y_data = y_vec->data();
+  for(std::vector<Uint>::const_iterator row_it = m_active_rows.begin(); row_it != m_active_rows.end(); ++row_it)
+  {
+    const Uint begin = *row_it*m_neq;
+    const Uint end = begin + m_neq;
+    for(Uint i = begin; i != end; ++i)
+      y_data[i] = beta == 0. ? alpha*ax[i] : alpha*ax[i] + beta*y_data[i];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeMatrix::debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values)
+{
+  row_indices.clear(); col_indices.clear(); values.clear();
+  const Uint size = m_blockrow_size*m_neq;
+  std::vector<Real> unit(size, 0.), column(size, 0.);
+  for(Uint col = 0; col != size; ++col)
+  {
+    unit[col] = 1.;
+    multiply(unit, column);
+    unit[col] = 0.;
+    for(std::vector<Uint>::const_iterator row_it = m_active_rows.begin(); row_it != m_active_rows.end(); ++row_it)
+    {
+      for(Uint a = 0; a != m_neq; ++a)
+      {
+        const Uint row = *row_it*m_neq + a;
+        if(column[row] != 0.)
+        {
+          row_indices.push_back(row);
+          col_indices.push_back(col);
+          values.push_back(column[row]);
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
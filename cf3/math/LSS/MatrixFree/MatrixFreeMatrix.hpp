@@ -0,0 +1,298 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_MatrixFreeMatrix_hpp
+#define cf3_Math_LSS_MatrixFreeMatrix_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "math/LSS/LibLSS.hpp"
+#include "math/LSS/Matrix.hpp"
+#include "math/LSS/MatrixFree/SumFactorization.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file MatrixFreeMatrix.hpp Definition of LSS::Matrix for a matrix-free operator on tensor-product hexahedra.
+
+  No matrix entries are stored. The product with a vector evaluates the element integrals of mass*M + diffusion*K,
+  with M the mass matrix and K the Laplacian, using sum factorisation over elements with nb_dofs_1d^3 nodes.
+  Each equation gets the same scalar operator. Only the geometric factors at the quadrature points are stored, so
+  the memory use does not grow with the number of couplings between the nodes, as it does for an assembled matrix.
+
+  The element data is set through set_operator, after create. Dirichlet conditions (set_row and symmetric_dirichlet)
+  and changes to the diagonal are stored as corrections to the operator, and are cleared by reset. Setting or adding
+  entries from element matrices is not supported.
+
+  The vectors are BlockCSRVectors. As for the BlockCSRMatrix, only the rows owned by this process are computed,
+  and nodes with an active periodic link are merged into the node they link to.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+class BlockCSRVector;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+class LSS_API MatrixFreeMatrix : public LSS::Matrix {
+public:
+
+  /// Number of elements that are processed together by the vectorized kernels
+  enum { batch_size = 4 };
+
+  /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
+  //@{
+
+  /// name of the type
+  static std::string type_name () { return "MatrixFreeMatrix"; }
+
+  /// Accessor to solver type
+  const std::string solvertype() { return "MatrixFree"; }
+
+  /// Accessor to the flag if matrix, solution and rhs are tied together or not
+  virtual const bool is_swappable(const LSS::Vector& solution, const LSS::Vector& rhs) { return true; }
+
+  /// Default constructor
+  MatrixFreeMatrix(const std::string& name);
+
+  /// Setup the distribution of the rows. The node connectivity is not needed, since the couplings follow from the elements.
+  void create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Not supported, all equations share the same operator
+  void create_blocked(cf3::common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+
+  /// Deallocate underlying data
+  void destroy();
+
+  /// Set the elements the operator is made of
+  /// @param nb_dofs_1d Number of nodes along each direction of an element
+  /// @param nb_qdr_1d Number of quadrature points along each direction of an element
+  /// @param values_1d 1D shape function values at the 1D quadrature points, nb_qdr_1d x nb_dofs_1d in row-major order
+  /// @param derivatives_1d 1D shape function derivatives at the 1D quadrature points, same layout as values_1d
+  /// @param element_rows For each element, the block row of each of its nb_dofs_1d^3 nodes in lexicographic order
+  /// @param geometry For each element and each of its nb_qdr_1d^3 quadrature points, the geometric factors described in SumFactorization
+  void set_operator(const Uint nb_dofs_1d, const Uint nb_qdr_1d, const std::vector<Real>& values_1d, const std::vector<Real>& derivatives_1d, const std::vector<Uint>& element_rows, const std::vector<Real>& geometry);
+
+  //@} END CREATION, DESTRUCTION AND COMPONENT SYSTEM
+
+  /// @name INDIVIDUAL ACCESS
+  //@{
+
+  /// Not supported, there are no stored entries
+  void set_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Not supported, there are no stored entries
+  void add_value(const Uint icol, const Uint irow, const Real value);
+
+  /// Not supported, there are no stored entries
+  void get_value(const Uint icol, const Uint irow, Real& value);
+
+  //@} END INDIVIDUAL ACCESS
+
+  /// @name EFFICCIENT ACCESS
+  //@{
+
+  /// Not supported, there are no stored entries
+  void set_values(const BlockAccumulator& values);
+
+  /// Not supported, there are no stored entries
+  void add_values(const BlockAccumulator& values);
+
+  /// Not supported, there are no stored entries
+  void get_values(BlockAccumulator& values);
+
+  /// Replace a row by diagval on the diagonal. Only offdiagval == 0 is supported.
+  void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval);
+
+  /// Not supported
+  void get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values);
+
+  /// Apply a dirichlet boundary condition, preserving symmetry by moving the column to the RHS.
+  /// The column is computed from the elements that contain the node.
+  void symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, LSS::Vector& rhs);
+
+  /// Not supported, use the periodic links in create instead
+  void tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from);
+
+  /// Set the diagonal, by storing the difference with the diagonal of the operator
+  void set_diagonal(const std::vector<Real>& diag);
+
+  /// Add to the diagonal
+  void add_diagonal(const std::vector<Real>& diag);
+
+  /// Get the diagonal
+  void get_diagonal(std::vector<Real>& diag);
+
+  /// Remove the dirichlet conditions and diagonal changes. The operator itself is kept, so reset_to must be 0.
+  void reset(Real reset_to=0.);
+
+  //@} END EFFICCIENT ACCESS
+
+  /// @name MISCELLANEOUS
+  //@{
+
+  /// Print to wherever
+  void print(common::LogStream& stream);
+
+  /// Print to wherever
+  void print(std::ostream& stream);
+
+  /// Print to file given by filename
+  void print(const std::string& filename, std::ios_base::openmode mode = std::ios_base::out );
+
+  /// Prints the element structure
+  void print_native(std::ostream& stream);
+
+  /// Accessor to the state of create
+  const bool is_created() { return m_is_created; }
+
+  /// Accessor to the number of equations
+  const Uint neq() { return m_neq; }
+
+  /// Accessor to the number of block rows
+  const Uint blockrow_size() { return m_blockrow_size; }
+
+  /// Accessor to the number of block columns
+  const Uint blockcol_size() { return m_blockrow_size; }
+
+  /// Make a deep copy of the current matrix into other
+  void clone_to(Matrix& other);
+
+  /// Not supported
+  void read_native(const common::URI& file);
+
+  //@} END MISCELLANEOUS
+
+  /// @name LINEAR ALGEBRA
+  //@{
+
+  /// Compute y = alpha*A*x + beta*y
+  void apply(const Handle<Vector>& y, const Handle<Vector const>& x, const Real alpha = 1., const Real beta = 0.);
+
+  //@} END LINEAR ALGEBRA
+
+  /// @name MATRIX-FREE DATA
+  /// @attention these functions are not part of the interface, only used by MatrixFreeStrategy
+  //@{
+
+  /// Compute y = A*x for the active rows. The ghost values of x are updated internally, the ghost values of y are left untouched.
+  /// @param x Values in the storage layout of BlockCSRVector
+  /// @param y Values in the storage layout of BlockCSRVector
+  void multiply(const std::vector<Real>& x, std::vector<Real>& y);
+
+  /// The block rows that are owned by this process and not merged into another row through a periodic link
+  const std::vector<Uint>& active_rows() const { return m_active_rows; }
+
+  /// Number of elements in the operator
+  Uint nb_elements() const { return m_nb_elements; }
+
+  //@} END MATRIX-FREE DATA
+
+  /// @name TEST ONLY
+  //@{
+
+  /// Exports the matrix into big linear arrays, by applying the operator to each unit vector
+  /// @attention only for debug and utest purposes, and only in serial
+  void debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values);
+
+  //@} END TEST ONLY
+
+private:
+
+  /// Kind of dirichlet condition on each row
+  enum ConstraintT { UNCONSTRAINED = 0, ROW = 1, SYMMETRIC = 2 };
+
+  /// Register the ghosted copy of the matrix-vector product input with the comm pattern
+  void setup_ghost_exchange(common::PE::CommPattern& cp);
+
+  /// Access to a BlockCSRVector from the interface type, throwing if the type is wrong
+  BlockCSRVector& block_csr_vector(Vector& v, const std::string& function);
+
+  /// Add the operator times x to y, for equation ieq of all elements
+  void add_element_products(const Real* x, Real* y, const Uint ieq);
+
+  /// Update m_operator_diagonal if the operator or the coefficients changed
+  void update_operator_diagonal();
+
+  /// Called when the coefficients change
+  void trigger_coefficients();
+
+  /// status of the matrix
+  bool m_is_created;
+
+  /// number of equations
+  Uint m_neq;
+
+  /// number of block rows (and columns), equal to the number of nodes on this process
+  Uint m_blockrow_size;
+
+  /// maps each process local node to the block row that holds its equations, to account for periodic links
+  std::vector<Uint> m_node_map;
+
+  /// true for the rows owned by this process and not linked to another row
+  std::vector<bool> m_is_active;
+
+  /// list of the active rows
+  std::vector<Uint> m_active_rows;
+
+  /// Coefficients of the mass matrix and the Laplacian
+  Real m_mass_coefficient;
+  Real m_diffusion_coefficient;
+
+  /// Tensor-product kernels
+  detail::SumFactorization m_kernel;
+
+  /// Number of elements
+  Uint m_nb_elements;
+
+  /// Block row of each node, per batch of elements: for each node of the element, batch_size values. Padding lanes hold m_blockrow_size.
+  std::vector<Uint> m_element_rows;
+
+  /// Geometric factors, per batch of elements: for each quadrature point, nb_geometric_factors times batch_size values
+  std::vector<Real> m_geometry;
+
+  /// For each block row, the batch*batch_size + lane of the elements that contain it, in compressed row format
+  std::vector<Uint> m_row_elements_offsets;
+  std::vector<Uint> m_row_elements;
+
+  /// Diagonal of the operator, without the corrections, for each block row and equation
+  std::vector<Real> m_operator_diagonal;
+  bool m_operator_diagonal_valid;
+
+  /// Added to the diagonal by set_diagonal and add_diagonal
+  std::vector<Real> m_diagonal_correction;
+
+  /// Dirichlet condition type and diagonal value of each row and equation
+  std::vector<Uint> m_constraints;
+  std::vector<Real> m_constrained_diagonal;
+  bool m_has_constraints;
+
+  /// Scratch space for the gather and scatter of a batch
+  std::vector<Real> m_batch_in;
+  std::vector<Real> m_batch_out;
+
+  /// Result of the element products, including the ghost rows
+  std::vector<Real> m_product;
+
+  /// Copy of the input of multiply, with up to date ghost values
+  std::vector<Real> m_ghosted_x;
+
+  /// Comm pattern to update m_ghosted_x. Null in serial.
+  boost::shared_ptr<common::PE::CommPattern> m_comm_pattern;
+
+}; // end of class MatrixFreeMatrix
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_MatrixFreeMatrix_hpp
@@ -0,0 +1,310 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+
+#include <boost/assign/list_of.hpp>
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "math/LSS/BlockCSR/BlockCSRDetail.hpp"
+#include "math/LSS/BlockCSR/BlockCSRVector.hpp"
+#include "math/LSS/MatrixFree/MatrixFreeMatrix.hpp"
+#include "math/LSS/MatrixFree/MatrixFreeStrategy.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder<MatrixFreeStrategy, SolutionStrategy, LibLSS> MatrixFreeStrategy_builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+MatrixFreeStrategy::MatrixFreeStrategy(const std::string& name) :
+  SolutionStrategy(name),
+  m_max_iterations(1000u),
+  m_tolerance(1e-8),
+  m_chebyshev_degree(4u),
+  m_eigenvalue_iterations(15u),
+  m_smoothing_range(30.),
+  m_lambda_min(0.),
+  m_lambda_max(0.)
+{
+  std::vector<std::string> preconditioners = boost::assign::list_of("Chebyshev")("Jacobi")("None");
+  options().add("preconditioner", std::string("Chebyshev"))
+    .pretty_name("Preconditioner")
+    .description("Preconditioner: Chebyshev (polynomial in the Jacobi-preconditioned matrix), Jacobi (inverse of the diagonal) or None")
+    .restricted_list() = std::vector<boost::any>(preconditioners.begin(), preconditioners.end());
+
+  options().add("max_iterations", m_max_iterations)
+    .pretty_name("Maximum Iterations")
+    .description("Maximum number of conjugate gradient iterations")
+    .link_to(&m_max_iterations)
+    .mark_basic();
+
+  options().add("tolerance", m_tolerance)
+    .pretty_name("Tolerance")
+    .description("Convergence criterion for the norm of the residual, relative to the norm of the right hand side")
+    .link_to(&m_tolerance)
+    .mark_basic();
+
+  options().add("chebyshev_degree", m_chebyshev_degree)
+    .pretty_name("Chebyshev Degree")
+    .description("Number of matrix-vector products in each application of the Chebyshev preconditioner")
+    .link_to(&m_chebyshev_degree);
+
+  options().add("eigenvalue_iterations", m_eigenvalue_iterations)
+    .pretty_name("Eigenvalue Iterations")
+    .description("Number of power iterations to estimate the largest eigenvalue for the Chebyshev preconditioner")
+    .link_to(&m_eigenvalue_iterations);
+
+  options().add("smoothing_range", m_smoothing_range)
+    .pretty_name("Smoothing Range")
+    .description("Ratio between the largest and the smallest eigenvalue targeted by the Chebyshev preconditioner")
+    .link_to(&m_smoothing_range);
+
+  properties().add("iterations", 0u);
+  properties().add("residual", 0.);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+MatrixFreeStrategy::~MatrixFreeStrategy()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeStrategy::set_matrix(const Handle< Matrix >& matrix)
+{
+  m_matrix = Handle<MatrixFreeMatrix>(matrix);
+  if(is_null(m_matrix))
+    throw common::SetupError(FromHere(), "MatrixFreeStrategy needs a MatrixFreeMatrix, but got " + matrix->derived_type_name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeStrategy::set_rhs(const Handle< Vector >& rhs)
+{
+  m_rhs = Handle<BlockCSRVector>(rhs);
+  if(is_null(m_rhs))
+    throw common::SetupError(FromHere(), "MatrixFreeStrategy needs a BlockCSRVector as RHS, but got " + rhs->derived_type_name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeStrategy::set_solution(const Handle< Vector >& solution)
+{
+  m_solution = Handle<BlockCSRVector>(solution);
+  if(is_null(m_solution))
+    throw common::SetupError(FromHere(), "MatrixFreeStrategy needs a BlockCSRVector as solution, but got " + solution->derived_type_name());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeStrategy::check_setup()
+{
+  if(is_null(m_matrix))
+    throw common::SetupError(FromHere(), "Null matrix for " + uri().path());
+
+  if(is_null(m_rhs))
+    throw common::SetupError(FromHere(), "Null RHS for " + uri().path());
+
+  if(is_null(m_solution))
+    throw common::SetupError(FromHere(), "Null solution vector for " + uri().path());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Real MatrixFreeStrategy::estimate_max_eigenvalue()
+{
+  const std::vector<Uint>& rows = m_matrix->active_rows();
+  const Uint neq = m_matrix->neq();
+  const Uint size = m_inverse_diagonal.size();
+
+  // Deterministic start vector that is not aligned with the smooth modes
+  std::vector<Real> v(size, 0.), w(size, 0.);
+  for(Uint i = 0; i != size; ++i)
+    v[i] = 1. + 0.1*static_cast<Real>(i % 7);
+
+  Real lambda = 0.;
+  for(Uint it = 0; it != m_eigenvalue_iterations; ++it)
+  {
+    const Real v_norm = std::sqrt(detail::dot(rows, neq, v, v));
+    if(v_norm == 0.)
+      break;
+    detail::axpby(rows, neq, 0., v, 1./v_norm, v);
+    m_matrix->multiply(v, w);
+    for(Uint i = 0; i != size; ++i)
+      w[i] *= m_inverse_diagonal[i];
+    lambda = detail::dot(rows, neq, v, w);
+    v.swap(w);
+  }
+
+  return lambda;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeStrategy::precondition(const std::vector<Real>& r, std::vector<Real>& z)
+{
+  const std::vector<Uint>& rows = m_matrix->active_rows();
+  const Uint neq = m_matrix->neq();
+  const Uint size = r.size();
+
+  if(m_inverse_diagonal.empty())
+  {
+    z = r;
+    return;
+  }
+
+  // Jacobi, also the first step of the Chebyshev iteration with zero initial guess
+  const Real theta = m_lambda_max == 0. ? 1. : 0.5*(m_lambda_max + m_lambda_min);
+  for(Uint i = 0; i != size; ++i)
+    z[i] = m_inverse_diagonal[i]*r[i] / theta;
+
+  if(m_lambda_max == 0.)
+    return;
+
+  // Chebyshev iteration for A z = r, see Saad, Iterative methods for sparse linear systems, algorithm 12.1
+  const Real delta = 0.5*(m_lambda_max - m_lambda_min);
+  const Real sigma = theta / delta;
+  Real rho = 1. / sigma;
+  std::vector<Real>& d = m_chebyshev_d;
+  std::vector<Real>& res = m_chebyshev_r;
+  d = z;
+  res.assign(size, 0.);
+  for(Uint k = 1; k < m_chebyshev_degree; ++k)
+  {
+    m_matrix->multiply(z, res);
+    detail::axpby(rows, neq, 1., r, -1., res);
+    const Real rho_new = 1. / (2.*sigma - rho);
+    const Real factor = 2.*rho_new / delta;
+    for(Uint i = 0; i != size; ++i)
+      res[i] *= m_inverse_diagonal[i];
+    detail::axpby(rows, neq, factor, res, rho_new*rho, d);
+    detail::axpby(rows, neq, 1., d, 1., z);
+    rho = rho_new;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeStrategy::solve()
+{
+  check_setup();
+
+  const std::vector<Uint>& rows = m_matrix->active_rows();
+  const Uint neq = m_matrix->neq();
+  std::vector<Real>& x = m_solution->data();
+  const std::vector<Real>& b = m_rhs->data();
+  const Uint size = x.size();
+  cf3_assert(b.size() == size);
+
+  // Setup the preconditioner for the current diagonal and dirichlet conditions
+  const std::string preconditioner = options().value<std::string>("preconditioner");
+  m_inverse_diagonal.clear();
+  m_lambda_min = 0.;
+  m_lambda_max = 0.;
+  if(preconditioner != "None")
+  {
+    m_matrix->get_diagonal(m_inverse_diagonal);
+    for(Uint i = 0; i != size; ++i)
+      m_inverse_diagonal[i] = m_inverse_diagonal[i] == 0. ? 0. : 1. / m_inverse_diagonal[i];
+    if(preconditioner == "Chebyshev" && m_chebyshev_degree > 1)
+    {
+      // Safety factor, since the power iteration approaches the largest eigenvalue from below
+      m_lambda_max = 1.2 * estimate_max_eigenvalue();
+      m_lambda_min = m_lambda_max / m_smoothing_range;
+    }
+  }
+
+  std::vector<Real> r(size, 0.), z(size, 0.), p(size, 0.), q(size, 0.);
+
+  // r = b - A x
+  m_matrix->multiply(x, r);
+  detail::axpby(rows, neq, 1., b, -1., r);
+
+  const Real b_norm = std::sqrt(detail::dot(rows, neq, b, b));
+  const Real threshold = m_tolerance * (b_norm > 0. ? b_norm : 1.);
+  Real r_norm = std::sqrt(detail::dot(rows, neq, r, r));
+
+  bool converged = r_norm <= threshold;
+  Uint iteration = 0;
+  Real rho = 1.;
+  while(!converged && iteration != m_max_iterations)
+  {
+    ++iteration;
+    precondition(r, z);
+    const Real rho_new = detail::dot(rows, neq, r, z);
+    if(rho_new == 0.)
+      break;
+
+    // p = z + beta*p
+    if(iteration == 1)
+      p = z;
+    else
+      detail::axpby(rows, neq, 1., z, rho_new/rho, p);
+
+    m_matrix->multiply(p, q);
+    const Real p_q = detail::dot(rows, neq, p, q);
+    if(p_q == 0.)
+      break;
+    const Real alpha = rho_new / p_q;
+
+    detail::axpby(rows, neq, alpha, p, 1., x);
+    detail::axpby(rows, neq, -alpha, q, 1., r);
+    r_norm = std::sqrt(detail::dot(rows, neq, r, r));
+    converged = r_norm <= threshold;
+    rho = rho_new;
+  }
+
+  m_solution->sync();
+
+  const Real relative_residual = b_norm > 0. ? r_norm / b_norm : r_norm;
+  properties()["iterations"] = iteration;
+  properties()["residual"] = relative_residual;
+
+  if(converged)
+    CFdebug << "MatrixFreeStrategy " << uri().path() << " converged in " << iteration << " iterations, relative residual " << relative_residual << CFendl;
+  else
+    CFwarn << "MatrixFreeStrategy " << uri().path() << " did not converge after " << iteration << " iterations, relative residual " << relative_residual << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Real MatrixFreeStrategy::compute_residual()
+{
+  check_setup();
+
+  const std::vector<Uint>& rows = m_matrix->active_rows();
+  const Uint neq = m_matrix->neq();
+  std::vector<Real> r(m_rhs->data().size(), 0.);
+  m_matrix->multiply(m_solution->data(), r);
+  detail::axpby(rows, neq, 1., m_rhs->data(), -1., r);
+  return std::sqrt(detail::dot(rows, neq, r, r));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void MatrixFreeStrategy::set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
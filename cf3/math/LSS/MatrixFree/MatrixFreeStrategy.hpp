@@ -0,0 +1,92 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_MatrixFreeStrategy_hpp
+#define cf3_Math_LSS_MatrixFreeStrategy_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "math/LSS/SolutionStrategy.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file MatrixFreeStrategy.hpp Preconditioned conjugate gradient solver for the matrix-free operator
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+class MatrixFreeMatrix;
+class BlockCSRVector;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Solves a system with a MatrixFreeMatrix using the conjugate gradient method. The preconditioner only needs the
+/// diagonal and the product with the matrix: Jacobi, or a Chebyshev polynomial in the Jacobi-preconditioned matrix.
+/// The largest eigenvalue needed for the Chebyshev polynomial is estimated with a few power iterations at each solve.
+/// The current value of the solution vector is used as initial guess.
+class LSS_API MatrixFreeStrategy : public SolutionStrategy
+{
+public:
+  /// Default constructor
+  MatrixFreeStrategy(const std::string& name);
+  ~MatrixFreeStrategy();
+
+  /// name of the type
+  static std::string type_name () { return "MatrixFreeStrategy"; }
+
+  void set_matrix(const Handle<LSS::Matrix>& matrix);
+  void set_rhs(const Handle<LSS::Vector>& rhs);
+  void set_solution(const Handle<LSS::Vector>& solution);
+  void solve();
+  Real compute_residual();
+
+  /// Coordinates are not used by the preconditioners
+  virtual void set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active);
+
+private:
+  /// Check that the matrix and vectors are set
+  void check_setup();
+
+  /// Estimate the largest eigenvalue of D^-1 A using power iterations
+  Real estimate_max_eigenvalue();
+
+  /// Compute z = M^-1 r
+  void precondition(const std::vector<Real>& r, std::vector<Real>& z);
+
+  Handle<MatrixFreeMatrix> m_matrix;
+  Handle<BlockCSRVector> m_rhs;
+  Handle<BlockCSRVector> m_solution;
+
+  Uint m_max_iterations;
+  Real m_tolerance;
+  Uint m_chebyshev_degree;
+  Uint m_eigenvalue_iterations;
+  Real m_smoothing_range;
+
+  /// Inverse of the diagonal of the matrix, 0 for the rows that are not active
+  std::vector<Real> m_inverse_diagonal;
+
+  /// Bounds of the eigenvalues of D^-1 A used by the Chebyshev polynomial
+  Real m_lambda_min;
+  Real m_lambda_max;
+
+  /// Work vectors for the preconditioner
+  std::vector<Real> m_chebyshev_d;
+  std::vector<Real> m_chebyshev_r;
+}; // end of class MatrixFreeStrategy
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_MatrixFreeStrategy_hpp
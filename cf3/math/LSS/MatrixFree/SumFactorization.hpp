@@ -0,0 +1,269 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_SumFactorization_hpp
+#define cf3_Math_LSS_SumFactorization_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <vector>
+
+#include "common/CF.hpp"
+
+#include "math/LSS/LibLSS.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file SumFactorization.hpp Tensor-product kernels for the matrix-free operator on hexahedra
+
+  An element has nb_dofs_1d^3 nodes and nb_qdr_1d^3 quadrature points, both numbered lexicographically
+  with the first direction running fastest. The 1D shape function values and derivatives at the 1D quadrature points
+  are stored as nb_qdr_1d x nb_dofs_1d row-major matrices. Interpolating to the quadrature points and integrating back
+  is then done one direction at a time, which costs O(n^4) per element instead of the O(n^6) of a dense element matrix.
+
+  The kernels work on a batch of W elements at once. Each value is stored as W consecutive reals, one per element (lane),
+  so the innermost loop is over the lanes and gets vectorized by the compiler, whatever the polynomial order.
+**/
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Contract a batch of 3D tensors along one direction with a 1D matrix, or with its transpose.
+/// The matrix has nb_rows x nb_cols entries in row-major order. Without transpose, the size along the direction goes
+/// from nb_cols to nb_rows, with transpose from nb_rows to nb_cols.
+/// @param sizes Size of the input along each direction
+/// @param dir Direction to contract (0, 1 or 2)
+/// @param add Add the result to out instead of overwriting it
+template<int W, bool Transpose>
+inline void contract(const Real* matrix, const Uint nb_rows, const Uint nb_cols, const Uint* sizes, const Uint dir, const Real* in, Real* out, const bool add)
+{
+  const Uint n_in = Transpose ? nb_rows : nb_cols;
+  const Uint n_out = Transpose ? nb_cols : nb_rows;
+  const Uint stride = dir == 0 ? 1 : (dir == 1 ? sizes[0] : sizes[0]*sizes[1]);
+  const Uint nb_outer = dir == 0 ? sizes[1]*sizes[2] : (dir == 1 ? sizes[2] : 1);
+  Real sum[W];
+  for(Uint o = 0; o != nb_outer; ++o)
+  {
+    for(Uint a = 0; a != n_out; ++a)
+    {
+      for(Uint p = 0; p != stride; ++p)
+      {
+        for(int l = 0; l != W; ++l)
+          sum[l] = 0.;
+        for(Uint b = 0; b != n_in; ++b)
+        {
+          const Real c = Transpose ? matrix[b*nb_cols + a] : matrix[a*nb_cols + b];
+          const Real* x = in + ((o*n_in + b)*stride + p)*W;
+          for(int l = 0; l != W; ++l)
+            sum[l] += c*x[l];
+        }
+        Real* y = out + ((o*n_out + a)*stride + p)*W;
+        if(add)
+        {
+          for(int l = 0; l != W; ++l)
+            y[l] += sum[l];
+        }
+        else
+        {
+          for(int l = 0; l != W; ++l)
+            y[l] = sum[l];
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sum-factorised application of the element operator mass*M + diffusion*K on tensor-product hexahedra
+class SumFactorization
+{
+public:
+  /// Number of geometric factors per quadrature point: the determinant of the Jacobian times the quadrature weight,
+  /// followed by the upper triangle of that value times (J J^T)^-1 (xx, xy, xz, yy, yz, zz), with J(i,j) = dx_j/dksi_i
+  enum { nb_geometric_factors = 7 };
+
+  SumFactorization() : m_nb_dofs_1d(0), m_nb_qdr_1d(0)
+  {
+  }
+
+  /// Set the 1D shape function values and derivatives at the 1D quadrature points, both nb_qdr_1d x nb_dofs_1d and row-major
+  void setup(const Uint nb_dofs_1d, const Uint nb_qdr_1d, const std::vector<Real>& values, const std::vector<Real>& derivatives, const Uint batch_size)
+  {
+    m_nb_dofs_1d = nb_dofs_1d;
+    m_nb_qdr_1d = nb_qdr_1d;
+    m_values = values;
+    m_derivatives = derivatives;
+    const Uint nb_entries = nb_dofs_1d*nb_qdr_1d;
+    m_values_squared.resize(nb_entries);
+    m_mixed.resize(nb_entries);
+    m_derivatives_squared.resize(nb_entries);
+    for(Uint i = 0; i != nb_entries; ++i)
+    {
+      m_values_squared[i] = values[i]*values[i];
+      m_mixed[i] = values[i]*derivatives[i];
+      m_derivatives_squared[i] = derivatives[i]*derivatives[i];
+    }
+
+    const Uint n = std::max(nb_dofs_1d, nb_qdr_1d);
+    const Uint work_size = n*n*n*batch_size;
+    for(Uint i = 0; i != nb_work; ++i)
+      m_work[i].assign(work_size, 0.);
+  }
+
+  Uint nb_dofs_1d() const { return m_nb_dofs_1d; }
+  Uint nb_qdr_1d() const { return m_nb_qdr_1d; }
+  Uint nb_dofs() const { return m_nb_dofs_1d*m_nb_dofs_1d*m_nb_dofs_1d; }
+  Uint nb_qdr() const { return m_nb_qdr_1d*m_nb_qdr_1d*m_nb_qdr_1d; }
+
+  /// Compute y = (mass*M + diffusion*K) u for a batch of W elements
+  /// @param geometry The geometric factors, for each quadrature point nb_geometric_factors values of W lanes each
+  template<int W>
+  void apply(const Real* geometry, const Real mass, const Real diffusion, const Real* u, Real* y)
+  {
+    const Uint nd = m_nb_dofs_1d;
+    const Uint nq = m_nb_qdr_1d;
+    const Real* B = &m_values[0];
+    const Real* D = &m_derivatives[0];
+    Real* a = &m_work[0][0];
+    Real* b = &m_work[1][0];
+    Real* c = &m_work[2][0];
+    Real* val = &m_work[3][0];
+    Real* gx = &m_work[4][0];
+    Real* gy = &m_work[5][0];
+    Real* gz = &m_work[6][0];
+
+    const Uint s_ddd[3] = {nd, nd, nd};
+    const Uint s_ddq[3] = {nd, nd, nq};
+    const Uint s_dqq[3] = {nd, nq, nq};
+    const Uint s_qqq[3] = {nq, nq, nq};
+
+    // Values and reference gradients at the quadrature points
+    contract<W, false>(B, nq, nd, s_ddd, 2, u, a, false);
+    contract<W, false>(B, nq, nd, s_ddq, 1, a, b, false);
+    contract<W, false>(D, nq, nd, s_ddq, 1, a, c, false);
+    contract<W, false>(B, nq, nd, s_dqq, 0, b, val, false);
+    contract<W, false>(D, nq, nd, s_dqq, 0, b, gx, false);
+    contract<W, false>(B, nq, nd, s_dqq, 0, c, gy, false);
+    contract<W, false>(D, nq, nd, s_ddd, 2, u, a, false);
+    contract<W, false>(B, nq, nd, s_ddq, 1, a, b, false);
+    contract<W, false>(B, nq, nd, s_dqq, 0, b, gz, false);
+
+    // Apply the coefficients and the geometry
+    const Uint nb_qdr = nq*nq*nq;
+    for(Uint q = 0; q != nb_qdr; ++q)
+    {
+      const Real* g = geometry + q*nb_geometric_factors*W;
+      Real* v_q = val + q*W;
+      Real* x_q = gx + q*W;
+      Real* y_q = gy + q*W;
+      Real* z_q = gz + q*W;
+      for(int l = 0; l != W; ++l)
+      {
+        const Real dx = x_q[l], dy = y_q[l], dz = z_q[l];
+        v_q[l] *= mass*g[l];
+        x_q[l] = diffusion*(g[W+l]*dx + g[2*W+l]*dy + g[3*W+l]*dz);
+        y_q[l] = diffusion*(g[2*W+l]*dx + g[4*W+l]*dy + g[5*W+l]*dz);
+        z_q[l] = diffusion*(g[3*W+l]*dx + g[5*W+l]*dy + g[6*W+l]*dz);
+      }
+    }
+
+    // Integrate back, multiplying with the transposed matrices in the reverse order
+    contract<W, true>(B, nq, nd, s_qqq, 0, val, b, false);
+    contract<W, true>(D, nq, nd, s_qqq, 0, gx, b, true);
+    contract<W, true>(B, nq, nd, s_qqq, 0, gy, c, false);
+    contract<W, true>(B, nq, nd, s_dqq, 1, b, a, false);
+    contract<W, true>(D, nq, nd, s_dqq, 1, c, a, true);
+    contract<W, true>(B, nq, nd, s_ddq, 2, a, y, false);
+    contract<W, true>(B, nq, nd, s_qqq, 0, gz, b, false);
+    contract<W, true>(B, nq, nd, s_dqq, 1, b, c, false);
+    contract<W, true>(D, nq, nd, s_ddq, 2, c, y, true);
+  }
+
+  /// Compute the diagonal of the element matrices of a batch of W elements
+  template<int W>
+  void diagonal(const Real* geometry, const Real mass, const Real diffusion, Real* diag)
+  {
+    const Uint nb_values = nb_dofs()*W;
+    for(Uint i = 0; i != nb_values; ++i)
+      diag[i] = 0.;
+
+    // Each term of the integrand is a product of 1D factors, so the diagonal is integrated the same way as the operator
+    const Real* BB = &m_values_squared[0];
+    const Real* DB = &m_mixed[0];
+    const Real* DD = &m_derivatives_squared[0];
+    integrate_separable<W>(geometry, 0, mass, BB, BB, BB, diag);
+    integrate_separable<W>(geometry, 1, diffusion, DD, BB, BB, diag);
+    integrate_separable<W>(geometry, 2, 2.*diffusion, DB, DB, BB, diag);
+    integrate_separable<W>(geometry, 3, 2.*diffusion, DB, BB, DB, diag);
+    integrate_separable<W>(geometry, 4, diffusion, BB, DD, BB, diag);
+    integrate_separable<W>(geometry, 5, 2.*diffusion, BB, DB, DB, diag);
+    integrate_separable<W>(geometry, 6, diffusion, BB, BB, DD, diag);
+  }
+
+private:
+  /// Add the integral of factor * geometric factor g times the product of the 1D matrices in each direction to out
+  template<int W>
+  void integrate_separable(const Real* geometry, const Uint g, const Real factor, const Real* mx, const Real* my, const Real* mz, Real* out)
+  {
+    if(factor == 0.)
+      return;
+
+    const Uint nd = m_nb_dofs_1d;
+    const Uint nq = m_nb_qdr_1d;
+    Real* f = &m_work[3][0];
+    Real* a = &m_work[0][0];
+    Real* b = &m_work[1][0];
+
+    const Uint nb_qdr = nq*nq*nq;
+    for(Uint q = 0; q != nb_qdr; ++q)
+    {
+      const Real* g_q = geometry + (q*nb_geometric_factors + g)*W;
+      for(int l = 0; l != W; ++l)
+        f[q*W+l] = factor*g_q[l];
+    }
+
+    const Uint s_ddq[3] = {nd, nd, nq};
+    const Uint s_dqq[3] = {nd, nq, nq};
+    const Uint s_qqq[3] = {nq, nq, nq};
+    contract<W, true>(mx, nq, nd, s_qqq, 0, f, a, false);
+    contract<W, true>(my, nq, nd, s_dqq, 1, a, b, false);
+    contract<W, true>(mz, nq, nd, s_ddq, 2, b, out, true);
+  }
+
+  Uint m_nb_dofs_1d;
+  Uint m_nb_qdr_1d;
+
+  /// 1D matrices, nb_qdr_1d x nb_dofs_1d
+  std::vector<Real> m_values;
+  std::vector<Real> m_derivatives;
+
+  /// Entry-wise products of the 1D matrices, used for the diagonal
+  std::vector<Real> m_values_squared;
+  std::vector<Real> m_mixed;
+  std::vector<Real> m_derivatives_squared;
+
+  /// Scratch space for the intermediate tensors
+  enum { nb_work = 7 };
+  std::vector<Real> m_work[nb_work];
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace detail
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_SumFactorization_hpp
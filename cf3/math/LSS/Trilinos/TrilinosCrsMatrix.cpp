@@ -6,9 +6,11 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 
+#include <boost/bind.hpp>
 #include <boost/pointer_cast.hpp>
 
 #include "Teuchos_ConfigDefs.hpp"
@@ -38,6 +40,7 @@
 #include "common/OptionList.hpp"
 #include "common/OptionT.hpp"
 #include "common/PropertyList.hpp"
+#include "common/StringConversion.hpp"
 #include "math/LSS/Trilinos/TrilinosCrsMatrix.hpp"
 #include "math/LSS/Trilinos/TrilinosDetail.hpp"
 #include "math/LSS/Trilinos/TrilinosVector.hpp"
@@ -70,9 +73,21 @@ TrilinosCrsMatrix::TrilinosCrsMatrix(const std::string& name) :
   m_num_my_elements(0),
   m_p2m(0),
   m_converted_indices(0),
-  m_comm(common::PE::Comm::instance().communicator())
+  m_comm(common::PE::Comm::instance().communicator()),
+  m_use_assembly_plan(false),
+  m_plan_cursor(0),
+  m_plan_matrix(0)
 {
   properties().add("vector_type", std::string("cf3.math.LSS.TrilinosVector"));
+
+  options().add("assembly_plan", m_use_assembly_plan)
+    .pretty_name("Assembly Plan")
+    .description("Record the position in the matrix of the values added for each block, and reuse it in later assemblies. "
+                 "Useful when the same blocks are added in the same order after each reset, e.g. for unsteady problems on a fixed mesh.")
+    .link_to(&m_use_assembly_plan)
+    .attach_trigger(boost::bind(&TrilinosCrsMatrix::trigger_assembly_plan, this));
+
+  clear_assembly_plan();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -159,6 +174,7 @@ void TrilinosCrsMatrix::destroy()
   m_neq=0;
   m_num_my_elements=0;
   m_is_created=false;
+  clear_assembly_plan();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -228,29 +244,164 @@ void TrilinosCrsMatrix::set_values(const BlockAccumulator& values)
 void TrilinosCrsMatrix::add_values(const BlockAccumulator& values)
 {
   cf3_assert(m_is_created);
+  if(m_use_assembly_plan && boost::this_thread::get_id() == m_plan_thread && add_values_planned(values))
+    return;
+
   const Uint nb_nodes = values.indices.size();
   const int num_entries = nb_nodes*m_neq;
   cf3_assert(values.mat.rows() == num_entries);
-  // Convert the index vector
+  // Convert the index vector. Each thread has its own buffer, so blocks that touch different rows can be added concurrently
+  std::vector<int>& converted_indices = thread_converted_indices(num_entries);
   for(Uint i = 0; i != nb_nodes; ++i)
   {
     const Uint local_start_idx = values.indices[i]*m_neq;
     for(int j = 0; j != m_neq; ++j)
-      m_converted_indices[i*m_neq+j] = m_p2m[local_start_idx+j];
+      converted_indices[i*m_neq+j] = m_p2m[local_start_idx+j];
   }
   // insert the values
   for(Uint i = 0; i != nb_nodes; ++i)
   {
     for(int j = 0; j != m_neq; ++j)
     {
-      if(m_converted_indices[i*m_neq+j] < m_num_my_elements)
-        TRILINOS_THROW(m_mat->SumIntoMyValues(m_converted_indices[i*m_neq+j], num_entries, values.mat.data()+(num_entries*(i*m_neq+j)),&m_converted_indices[0]));
+      if(converted_indices[i*m_neq+j] < m_num_my_elements)
+        TRILINOS_THROW(m_mat->SumIntoMyValues(converted_indices[i*m_neq+j], num_entries, values.mat.data()+(num_entries*(i*m_neq+j)),&converted_indices[0]));
     }
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+std::vector<int>& TrilinosCrsMatrix::thread_converted_indices(const Uint size)
+{
+  std::vector<int>* result = m_thread_converted_indices.get();
+  if(is_null(result))
+  {
+    result = new std::vector<int>();
+    m_thread_converted_indices.reset(result);
+  }
+  if(result->size() < size)
+    result->resize(size);
+  return *result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TrilinosCrsMatrix::add_values_planned(const BlockAccumulator& values)
+{
+  int* row_offsets;
+  int* col_indices;
+  Real* matrix_values;
+  // Only possible if the matrix uses contiguous CRS storage
+  if(m_mat->ExtractCrsDataPointers(row_offsets, col_indices, matrix_values) != 0)
+    return false;
+
+  if(m_mat.get() != m_plan_matrix)
+  {
+    clear_assembly_plan();
+    m_plan_matrix = m_mat.get();
+  }
+
+  const Uint nb_nodes = values.indices.size();
+  const int num_entries = nb_nodes*m_neq;
+  cf3_assert(values.mat.rows() == num_entries);
+
+  const Uint block = m_plan_cursor;
+  const Uint nb_recorded_blocks = m_plan_block_starts.size() - 1;
+  cf3_assert(block <= nb_recorded_blocks);
+  if(block == nb_recorded_blocks
+    || m_plan_block_starts[block+1] - m_plan_block_starts[block] != nb_nodes
+    || !std::equal(values.indices.begin(), values.indices.end(), m_plan_indices.begin() + m_plan_block_starts[block]))
+  {
+    record_plan_block(values, block, row_offsets, col_indices);
+  }
+  ++m_plan_cursor;
+
+  // Scatter-add the block directly into the value array
+  const int* offsets = &m_plan_value_offsets[m_plan_offset_starts[block]];
+  const Real* block_values = values.mat.data();
+  for(int i = 0; i != num_entries; ++i)
+  {
+    const int row_start = i*num_entries;
+    if(offsets[row_start] < 0)
+      continue;
+    for(int j = 0; j != num_entries; ++j)
+      matrix_values[offsets[row_start+j]] += block_values[row_start+j];
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosCrsMatrix::record_plan_block(const BlockAccumulator& values, const Uint block, const int* row_offsets, const int* col_indices)
+{
+  const Uint nb_nodes = values.indices.size();
+  const int num_entries = nb_nodes*m_neq;
+  std::vector<int>& converted_indices = thread_converted_indices(num_entries);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    const Uint local_start_idx = values.indices[i]*m_neq;
+    for(int j = 0; j != m_neq; ++j)
+      converted_indices[i*m_neq+j] = m_p2m[local_start_idx+j];
+  }
+
+  // Look up all offsets before touching the plan, so it stays consistent if a column is missing
+  std::vector<int> block_offsets;
+  block_offsets.reserve(num_entries*num_entries);
+  for(int i = 0; i != num_entries; ++i)
+  {
+    const int row = converted_indices[i];
+    if(row >= m_num_my_elements)
+    {
+      block_offsets.insert(block_offsets.end(), num_entries, -1);
+      continue;
+    }
+
+    const int* row_begin = col_indices + row_offsets[row];
+    const int* row_end = col_indices + row_offsets[row+1];
+    for(int j = 0; j != num_entries; ++j)
+    {
+      const int* col = std::find(row_begin, row_end, converted_indices[j]);
+      if(col == row_end)
+        throw common::BadValue(FromHere(), "Column " + common::to_str(converted_indices[j]) + " is not in the sparsity pattern of row " + common::to_str(row));
+      block_offsets.push_back(col - col_indices);
+    }
+  }
+
+  // Blocks are not added in the same order as before, so the rest of the plan is discarded
+  m_plan_block_starts.resize(block+1);
+  m_plan_indices.resize(m_plan_block_starts.back());
+  m_plan_offset_starts.resize(block+1);
+  m_plan_value_offsets.resize(m_plan_offset_starts.back());
+
+  m_plan_indices.insert(m_plan_indices.end(), values.indices.begin(), values.indices.end());
+  m_plan_block_starts.push_back(m_plan_indices.size());
+  m_plan_value_offsets.insert(m_plan_value_offsets.end(), block_offsets.begin(), block_offsets.end());
+  m_plan_offset_starts.push_back(m_plan_value_offsets.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosCrsMatrix::clear_assembly_plan()
+{
+  m_plan_indices.clear();
+  m_plan_block_starts.assign(1, 0u);
+  m_plan_value_offsets.clear();
+  m_plan_offset_starts.assign(1, 0u);
+  m_plan_cursor = 0;
+  m_plan_matrix = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosCrsMatrix::trigger_assembly_plan()
+{
+  clear_assembly_plan();
+  m_plan_thread = boost::this_thread::get_id();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void TrilinosCrsMatrix::get_values(BlockAccumulator& values)
 {
   cf3_assert(m_is_created);
@@ -511,6 +662,10 @@ void TrilinosCrsMatrix::reset(Real reset_to)
 
   m_symmetric_dirichlet_values.clear();
   m_dirichlet_nodes.clear();
+
+  // Start a new assembly
+  m_plan_cursor = 0;
+  m_plan_thread = boost::this_thread::get_id();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -13,6 +13,9 @@
 #include <Epetra_CrsMatrix.h>
 #include <Teuchos_RCP.hpp>
 
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+
 #include "math/LSS/LibLSS.hpp"
 #include "math/LSS/BlockAccumulator.hpp"
 #include "math/LSS/Vector.hpp"
@@ -87,6 +90,8 @@ public:
   /// Add a list of values
   /// local ibdices
   /// eigen, templatization on top level
+  /// If the assembly_plan option is set, the positions of the entries in the matrix value array are recorded
+  /// for each block on the first assembly, and later assemblies add the values directly at these positions.
   void add_values(const BlockAccumulator& values);
 
   /// Add a list of values
@@ -204,6 +209,22 @@ public:
 
 private:
 
+  /// Add the values using the assembly plan, recording the current block if it does not match the plan.
+  /// Returns false if the plan can't be used for the current matrix
+  bool add_values_planned(const BlockAccumulator& values);
+
+  /// Record the value offsets for the given block, discarding the plan from that block on
+  void record_plan_block(const BlockAccumulator& values, const Uint block, const int* row_offsets, const int* col_indices);
+
+  /// Discard the assembly plan
+  void clear_assembly_plan();
+
+  /// Called when the assembly_plan option changes
+  void trigger_assembly_plan();
+
+  /// Index buffer for the calling thread, with at least size entries
+  std::vector<int>& thread_converted_indices(const Uint size);
+
   /// teuchos style smart pointer wrapping the matrix
   Teuchos::RCP<Epetra_CrsMatrix> m_mat;
 
@@ -225,6 +246,9 @@ private:
   /// a helper array used in set/add/get_values to avoid frequent new+free combo
   std::vector<int> m_converted_indices;
 
+  /// Per-thread version of m_converted_indices, for add_values, which may be called from several threads at once
+  boost::thread_specific_ptr< std::vector<int> > m_thread_converted_indices;
+
   /// Copy of the connectivity data
   std::vector<int> m_node_connectivity, m_starting_indices;
 
@@ -234,6 +258,39 @@ private:
   DirichletMapT m_symmetric_dirichlet_values;
 
   std::vector< std::pair<Uint,Uint> > m_dirichlet_nodes;
+
+  /// @name ASSEMBLY PLAN
+  /// Blocks passed to add_values are numbered in the order they are added since the last reset(). For each block, the
+  /// node indices and the offset of each entry in the CRS value array are stored, so later assemblies that add the same
+  /// blocks in the same order skip the index conversion and the column search in each row.
+  /// The plan is only used from the thread that last called reset(), so concurrent assemblies fall back to SumIntoMyValues.
+  //@{
+
+  /// True if the assembly plan is used
+  bool m_use_assembly_plan;
+
+  /// Node indices of each recorded block, concatenated
+  std::vector<Uint> m_plan_indices;
+
+  /// Start of each block in m_plan_indices, with one extra entry marking the end
+  std::vector<Uint> m_plan_block_starts;
+
+  /// Offset in the CRS value array for each entry of each recorded block, row-major per block. -1 for rows that are not owned by this process
+  std::vector<int> m_plan_value_offsets;
+
+  /// Start of each block in m_plan_value_offsets, with one extra entry marking the end
+  std::vector<Uint> m_plan_offset_starts;
+
+  /// Number of blocks added since the last reset()
+  Uint m_plan_cursor;
+
+  /// Matrix for which the plan was recorded
+  const Epetra_CrsMatrix* m_plan_matrix;
+
+  /// Thread that is allowed to use the plan
+  boost::thread::id m_plan_thread;
+
+  //@} END ASSEMBLY PLAN
 }; // end of class Matrix
 
 ////////////////////////////////////////////////////////////////////////////////////////////
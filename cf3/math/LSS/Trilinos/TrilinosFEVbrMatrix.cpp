@@ -127,6 +127,7 @@ void TrilinosFEVbrMatrix::create(cf3::common::PE::CommPattern& cp, const Uint ne
 
   // set class properties
   m_is_created=true;
+  m_assembly_thread = boost::this_thread::get_id();
   m_neq=neq;
   m_blockrow_size=nmyglobalelements;
   m_blockcol_size=cp.gid()->size();
@@ -226,6 +227,7 @@ void TrilinosFEVbrMatrix::get_value(const Uint icol, const Uint irow, Real& valu
 void TrilinosFEVbrMatrix::set_values(const BlockAccumulator& values)
 {
   cf3_assert(m_is_created);
+  check_assembly_thread("set_values");
   Epetra_SerialDenseMatrix **val;
   int* colindices;
   int blockrowsize;
@@ -314,6 +316,7 @@ void TrilinosFEVbrMatrix::add_values(const BlockAccumulator& values)
 */
 /* FINAL OPTIMIZED */
   cf3_assert(m_is_created);
+  check_assembly_thread("add_values");
   Epetra_SerialDenseMatrix **val;
   int* colindices;
   int blockrowsize;
@@ -359,6 +362,7 @@ void TrilinosFEVbrMatrix::add_values(const BlockAccumulator& values)
 void TrilinosFEVbrMatrix::get_values(BlockAccumulator& values)
 {
   cf3_assert(m_is_created);
+  check_assembly_thread("get_values");
   Epetra_SerialDenseMatrix **val;
   int* colindices;
   int blockrowsize;
@@ -662,6 +666,16 @@ void TrilinosFEVbrMatrix::reset(Real reset_to)
 {
   cf3_assert(m_is_created);
   m_mat->PutScalar(reset_to);
+  m_assembly_thread = boost::this_thread::get_id();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosFEVbrMatrix::check_assembly_thread(const std::string& function) const
+{
+  if(boost::this_thread::get_id() != m_assembly_thread)
+    throw common::NotSupported(FromHere(), function + " of TrilinosFEVbrMatrix " + uri().path() + " was called from a thread other than the one that created or reset the matrix. "
+                               "The matrix shares an index buffer between calls, so it cannot be assembled from several threads: use nb_threads = 1 or a TrilinosCrsMatrix.");
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
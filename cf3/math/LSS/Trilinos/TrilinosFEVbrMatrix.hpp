@@ -9,6 +9,8 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <boost/thread/thread.hpp>
+
 #include <Epetra_MpiComm.h>
 #include <Epetra_FEVbrMatrix.h>
 #include <Teuchos_RCP.hpp>
@@ -173,6 +175,9 @@ public:
 
 private:
 
+  /// Throw if called from another thread than m_assembly_thread
+  void check_assembly_thread(const std::string& function) const;
+
   /// teuchos style smart pointer wrapping an epetra fevbrmatrix
   Teuchos::RCP<Epetra_FEVbrMatrix> m_mat;
 
@@ -197,6 +202,9 @@ private:
   /// a helper array used in set/add/get_values to avoid frequent new+free combo
   std::vector<int> m_converted_indices;
 
+  /// Thread that created or last reset the matrix. Since m_converted_indices is shared, only this thread may call set/add/get_values.
+  boost::thread::id m_assembly_thread;
+
   /// Copy of the connectivity data
   std::vector<int> m_node_connectivity, m_starting_indices;
 
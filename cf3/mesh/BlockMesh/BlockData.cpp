@@ -4,9 +4,14 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <set>
+
 #include <boost/assign/list_of.hpp>
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "common/Builder.hpp"
 #include "common/Core.hpp"
@@ -30,7 +35,6 @@
 #include "mesh/Elements.hpp"
 #include "mesh/Mesh.hpp"
 #include "mesh/MeshElements.hpp"
-#include "mesh/MeshTransformer.hpp"
 #include "mesh/Dictionary.hpp"
 #include "mesh/Field.hpp"
 #include "mesh/ConnectivityData.hpp"
@@ -103,6 +107,44 @@ namespace detail
     output.push_back(ValT(input.size()));
     std::copy(input.begin(), input.end(), output.back().begin());
   }
+
+  /// Calls a functor for a range of indices, to run it in a thread
+  template<typename FunctorT>
+  struct RangeThread
+  {
+    RangeThread(const FunctorT& f, const Uint begin, const Uint end) : functor(f), range_begin(begin), range_end(end)
+    {
+    }
+
+    void operator()()
+    {
+      functor(range_begin, range_end);
+    }
+
+    FunctorT functor;
+    Uint range_begin;
+    Uint range_end;
+  };
+
+  /// Split [0, nb_items) into nb_threads contiguous ranges and call functor(begin, end) for each range in a separate thread
+  template<typename FunctorT>
+  void run_threaded(const Uint nb_threads, const Uint nb_items, const FunctorT& functor)
+  {
+    const Uint nb_ranges = std::min(nb_threads, nb_items);
+    if(nb_ranges < 2)
+    {
+      RangeThread<FunctorT>(functor, 0, nb_items)();
+      return;
+    }
+
+    boost::thread_group threads;
+    for(Uint i = 1; i != nb_ranges; ++i)
+      threads.create_thread(RangeThread<FunctorT>(functor, (nb_items*i)/nb_ranges, (nb_items*(i+1))/nb_ranges));
+
+    // The calling thread takes the first range
+    RangeThread<FunctorT>(functor, 0, nb_items/nb_ranges)();
+    threads.join_all();
+  }
 }
 
 ComponentBuilder < BlockArrays, Component, LibBlockMesh > BlockArrays_Builder;
@@ -168,45 +210,65 @@ struct BlockArrays::Implementation
     {
     }
 
-    /// Get the block corresponding to index i in a certain direction. Meant to be called sequentially like:
-    ///  block[i][j][k]
-    Block operator[](const Uint i) const
+    /// Get the block that stores the node with the given indices. The indices are modified to be relative to the returned block.
+    /// An index equal to the number of points in a direction refers to the first layer of points of the neighbor in that direction.
+    const Block* locate(Uint* idx, const Uint nb_dims) const
     {
-      const Uint search_direction = search_indices.size();
-      cf3_assert(search_direction < dimensions);
-
-      // Data can be found in the neigboring block
-      if(i == nb_points[search_direction])
+      const Block* result = this;
+      for(Uint d = 0; d != nb_dims; ++d)
       {
-        Block neighbor = *neighbors[search_direction];
-        for(Uint j = 0; j != search_direction; ++j)
-          neighbor = neighbor[search_indices[j]];
-        neighbor.search_indices.push_back(0);
-        return neighbor;
+        if(idx[d] == result->nb_points[d])
+        {
+          cf3_assert(result->neighbors[d] != nullptr);
+          idx[d] = 0;
+          // Indices in the previous directions must be looked up again in the neighbor
+          result = result->neighbors[d]->locate(idx, d);
+        }
       }
-
-      // We have the data here
-      Block result = *this;
-      result.search_indices.push_back(i);
       return result;
     }
 
-    /// Get the global index. Available after "dimension" subsequent calls to operator[]
-    Uint global_idx() const
+    /// Same as locate, but returns nullptr if the indices lead beyond a bounded side instead of failing
+    const Block* find(Uint* idx, const Uint nb_dims) const
     {
-      cf3_assert(search_indices.size() == dimensions);
-      Uint result = start_index;
-      for(Uint i = 0; i != dimensions; ++i)
+      const Block* result = this;
+      for(Uint d = 0; d != nb_dims; ++d)
       {
-        result += strides[i]*search_indices[i];
+        if(idx[d] > result->nb_points[d])
+          return nullptr;
+        if(idx[d] == result->nb_points[d])
+        {
+          if(result->neighbors[d] == nullptr)
+            return nullptr;
+          idx[d] = 0;
+          result = result->neighbors[d]->find(idx, d);
+          if(result == nullptr)
+            return nullptr;
+        }
       }
       return result;
     }
 
+    /// Global index of the node with the given indices, 2D version
+    Uint global_idx(const Uint i, const Uint j) const
+    {
+      cf3_assert(dimensions == 2);
+      Uint idx[2] = {i, j};
+      const Block* block = locate(idx, 2);
+      return block->start_index + block->strides[0]*idx[0] + block->strides[1]*idx[1];
+    }
+
+    /// Global index of the node with the given indices, 3D version
+    Uint global_idx(const Uint i, const Uint j, const Uint k) const
+    {
+      cf3_assert(dimensions == 3);
+      Uint idx[3] = {i, j, k};
+      const Block* block = locate(idx, 3);
+      return block->start_index + block->strides[0]*idx[0] + block->strides[1]*idx[1] + block->strides[2]*idx[2];
+    }
+
     /// Number of dimensions (2 or 3)
     Uint dimensions;
-    /// Previous indices passed to operator[]
-    std::vector<Uint> search_indices;
     /// Number of points in each direction
     std::vector<Uint> nb_points;
     /// Number of elements
@@ -223,6 +285,12 @@ struct BlockArrays::Implementation
     Uint start_index;
     /// True if the block is stored on the current MPI rank
     bool is_local;
+    /// MPI rank that stores the block
+    Uint rank;
+    /// Global index of the first volume element of the block
+    Uint element_offset;
+    /// Blocks with cells that use nodes stored in this block, including the block itself
+    std::vector<const Block*> referring_blocks;
   };
 
   struct Patch
@@ -234,6 +302,7 @@ struct BlockArrays::Implementation
     /// @param orientation Direction of the patch normal
     Patch(const Block& a_block, const Uint fixed_dir, const Uint idx, const Uint orientation) :
       block(a_block),
+      element_offset(0),
       fixed_direction(fixed_dir),
       fixed_idx(idx),
       m_orientation(orientation)
@@ -255,7 +324,7 @@ struct BlockArrays::Implementation
     {
       cf3_assert(block.dimensions == 2);
       i = fixed_idx ? i : segments[0]-i;
-      return block[fixed_direction == 0 ? fixed_idx : i][fixed_direction == 1 ? fixed_idx : i].global_idx();
+      return block.global_idx(fixed_direction == 0 ? fixed_idx : i, fixed_direction == 1 ? fixed_idx : i);
     }
 
     /// Access to a global index, 2D version
@@ -269,17 +338,19 @@ struct BlockArrays::Implementation
       switch(fixed_direction)
       {
         case 0:
-          return block[fixed_idx][i][j].global_idx();
+          return block.global_idx(fixed_idx, i, j);
         case 1:
-          return block[i][fixed_idx][j].global_idx();
+          return block.global_idx(i, fixed_idx, j);
         case 2:
-          return block[i][j][fixed_idx].global_idx();
+          return block.global_idx(i, j, fixed_idx);
       }
       return 0;
     }
 
     const Block& block;
     Uint nb_elems;
+    /// Global index of the first element of the patch
+    Uint element_offset;
     std::vector<Uint> segments;
     Uint fixed_direction;
     Uint fixed_idx;
@@ -314,6 +385,8 @@ struct BlockArrays::Implementation
   {
     trigger_block_regions();
     ghost_counter = 0;
+    global_to_local.clear();
+    nodes_dist.clear();
     const Uint rank = PE::Comm::instance().rank();
     const Uint partition_begin = block_distribution[rank];
     const Uint partition_end = block_distribution[rank+1];
@@ -353,6 +426,7 @@ struct BlockArrays::Implementation
     {
       Block& block = block_list[block_idx];
       block.is_local = block_idx >= partition_begin && block_idx < partition_end;
+      block.rank = std::upper_bound(block_distribution.begin(), block_distribution.end(), block_idx) - 1 - block_distribution.begin();
       block.start_index = block_start;
 
       const Table<Uint>::ConstRow row = (*blocks)[block_idx];
@@ -418,6 +492,27 @@ struct BlockArrays::Implementation
       }
       block_start += nb_points;
     }
+
+    // A node on the positive side of a block is stored in the block that is reached by walking the neighbor links. Since neighbors
+    // share the number of segments along their interface, it is enough to check the extremes of the node indices in each direction.
+    BOOST_FOREACH(Block& block, block_list)
+    {
+      block.referring_blocks.clear();
+    }
+    BOOST_FOREACH(const Block& block, block_list)
+    {
+      for(Uint corner = 0; corner != (1u << dimensions); ++corner)
+      {
+        Uint idx[3];
+        for(Uint d = 0; d != dimensions; ++d)
+          idx[d] = (corner & (1u << d)) ? block.segments[d] : 0;
+        const Block* storing_block = block.find(idx, dimensions);
+        cf3_assert(storing_block != nullptr);
+        std::vector<const Block*>& referring = block_list[storing_block - &block_list[0]].referring_blocks;
+        if(std::find(referring.begin(), referring.end(), &block) == referring.end())
+          referring.push_back(&block);
+      }
+    }
   }
 
   /// Distribution of nodes among the CPUs
@@ -462,6 +557,17 @@ struct BlockArrays::Implementation
     return stored_gid.first->second;
   }
 
+  /// Convert a global index to a local one. Ghost nodes must have been added using to_local, so this may be called from several threads
+  Uint local_idx(const Uint gid) const
+  {
+    if(gid >= local_nodes_begin && gid < local_nodes_end)
+      return gid - local_nodes_begin;
+
+    const IndexMapT::const_iterator ghost_it = global_to_local.find(gid);
+    cf3_assert(ghost_it != global_to_local.end());
+    return ghost_it->second;
+  }
+
   template<typename T>
   void check_handle(const Handle<T>& h, const std::string& signal_name, const std::string& description)
   {
@@ -469,50 +575,164 @@ struct BlockArrays::Implementation
       throw SetupError(FromHere(), description + " not defined. Did you call the " + signal_name + " signal?");
   }
 
-  void add_block(const Table<Uint>::ConstRow& segments, const Uint block_idx, Connectivity& volume_connectivity, Uint& element_idx)
+  /// Number the elements of all ranks in the order in which each rank creates them: first the volume regions, sorted by name, then the patches.
+  /// This only needs the block data, so each rank knows the global index of any element without communication.
+  void create_element_numbering(const Uint nb_procs)
   {
-    if(segments.size() == 3)
+    const Uint nb_blocks = block_list.size();
+
+    // Start of the numbering for each rank
+    std::vector<Uint> next_idx(nb_procs+1, 0);
+    for(Uint block_idx = 0; block_idx != nb_blocks; ++block_idx)
+      next_idx[block_list[block_idx].rank+1] += block_list[block_idx].nb_elems;
+    for(PatchMapT::const_iterator it = patch_map.begin(); it != patch_map.end(); ++it)
     {
-      for(Uint k = 0; k != segments[ZZ]; ++k)
+      BOOST_FOREACH(const Patch& patch, it->second)
       {
-        for(Uint j = 0; j != segments[YY]; ++j)
-        {
-          for(Uint i = 0; i != segments[XX]; ++i)
-          {
-            common::Table<Uint>::Row element_connectivity = volume_connectivity[element_idx++];
-            element_connectivity[0] = to_local(block_list[block_idx][i  ][j  ][k  ].global_idx());
-            element_connectivity[1] = to_local(block_list[block_idx][i+1][j  ][k  ].global_idx());
-            element_connectivity[2] = to_local(block_list[block_idx][i+1][j+1][k  ].global_idx());
-            element_connectivity[3] = to_local(block_list[block_idx][i  ][j+1][k  ].global_idx());
-            element_connectivity[4] = to_local(block_list[block_idx][i  ][j  ][k+1].global_idx());
-            element_connectivity[5] = to_local(block_list[block_idx][i+1][j  ][k+1].global_idx());
-            element_connectivity[6] = to_local(block_list[block_idx][i+1][j+1][k+1].global_idx());
-            element_connectivity[7] = to_local(block_list[block_idx][i  ][j+1][k+1].global_idx());
-          }
-        }
+        next_idx[patch.block.rank+1] += patch.nb_elems;
+      }
+    }
+    for(Uint i = 1; i != nb_procs+1; ++i)
+      next_idx[i] += next_idx[i-1];
+
+    const std::set<std::string> region_names(block_regions.begin(), block_regions.end());
+    BOOST_FOREACH(const std::string& region_name, region_names)
+    {
+      for(Uint block_idx = 0; block_idx != nb_blocks; ++block_idx)
+      {
+        if(block_regions[block_idx] != region_name)
+          continue;
+        Block& block = block_list[block_idx];
+        block.element_offset = next_idx[block.rank];
+        next_idx[block.rank] += block.nb_elems;
+      }
+    }
+
+    for(PatchMapT::iterator it = patch_map.begin(); it != patch_map.end(); ++it)
+    {
+      BOOST_FOREACH(Patch& patch, it->second)
+      {
+        patch.element_offset = next_idx[patch.block.rank];
+        next_idx[patch.block.rank] += patch.nb_elems;
       }
     }
+  }
+
+  /// Global indices of the nodes of a volume element, given its index in the block
+  void cell_nodes(const Block& block, const Uint cell, Uint* gids) const
+  {
+    const Uint i = cell % block.segments[XX];
+    if(block.dimensions == 3)
+    {
+      const Uint j = (cell / block.segments[XX]) % block.segments[YY];
+      const Uint k = cell / (block.segments[XX]*block.segments[YY]);
+      gids[0] = block.global_idx(i  , j  , k  );
+      gids[1] = block.global_idx(i+1, j  , k  );
+      gids[2] = block.global_idx(i+1, j+1, k  );
+      gids[3] = block.global_idx(i  , j+1, k  );
+      gids[4] = block.global_idx(i  , j  , k+1);
+      gids[5] = block.global_idx(i+1, j  , k+1);
+      gids[6] = block.global_idx(i+1, j+1, k+1);
+      gids[7] = block.global_idx(i  , j+1, k+1);
+    }
+    else
+    {
+      cf3_assert(block.dimensions == 2);
+      const Uint j = cell / block.segments[XX];
+      gids[0] = block.global_idx(i  , j  );
+      gids[1] = block.global_idx(i+1, j  );
+      gids[2] = block.global_idx(i+1, j+1);
+      gids[3] = block.global_idx(i  , j+1);
+    }
+  }
+
+  /// Global indices of the nodes of a surface element, given its index in the patch
+  void face_nodes(const Patch& patch, const Uint face, Uint* gids) const
+  {
+    if(patch.block.dimensions == 3)
+    {
+      static const Uint idx_offsets[6][4][2] = {
+        {{0,0},{0,1},{1,1},{1,0}},
+        {{0,0},{0,1},{1,1},{1,0}},
+        {{0,0},{0,1},{1,1},{1,0}},
+        {{0,0},{1,0},{1,1},{0,1}},
+        {{0,0},{0,1},{1,1},{1,0}},
+        {{0,0},{1,0},{1,1},{0,1}}
+      };
+
+      const Uint i = face / patch.segments[1];
+      const Uint j = face % patch.segments[1];
+      for(Uint n = 0; n != 4; ++n)
+        gids[n] = patch.global_idx(i + idx_offsets[patch.m_orientation][n][0], j + idx_offsets[patch.m_orientation][n][1]);
+    }
     else
     {
-      cf3_assert(segments.size() == 2);
-      for(Uint j = 0; j != segments[YY]; ++j)
+      cf3_assert(patch.block.dimensions == 2);
+      const Uint first_offset = patch.fixed_direction == 0 ? 1 : 0;
+      const Uint second_offset = patch.fixed_direction == 0 ? 0 : 1;
+      gids[1] = patch.global_idx(face + first_offset);
+      gids[0] = patch.global_idx(face + second_offset);
+    }
+  }
+
+  /// Add the ghost nodes of a local block. These can only be on the positive sides, where the nodes may belong to the neighbor block.
+  void add_block_ghosts(const Uint block_idx)
+  {
+    const Block& block = block_list[block_idx];
+    const Uint nx = block.segments[XX];
+    const Uint ny = block.segments[YY];
+    if(block.dimensions == 3)
+    {
+      const Uint nz = block.segments[ZZ];
+      for(Uint k = 0; k <= nz; ++k)
       {
-        for(Uint i = 0; i != segments[XX]; ++i)
+        for(Uint j = 0; j <= ny; ++j)
         {
-          common::Table<Uint>::Row element_connectivity = volume_connectivity[element_idx++];
-          element_connectivity[0] = to_local(block_list[block_idx][i  ][j  ].global_idx());
-          element_connectivity[1] = to_local(block_list[block_idx][i+1][j  ].global_idx());
-          element_connectivity[2] = to_local(block_list[block_idx][i+1][j+1].global_idx());
-          element_connectivity[3] = to_local(block_list[block_idx][i  ][j+1].global_idx());
+          // Away from the positive Y and Z sides, only the last node in the X direction is on the boundary
+          for(Uint i = (j == ny || k == nz) ? 0 : nx; i <= nx; ++i)
+            to_local(block.global_idx(i, j, k));
         }
       }
     }
+    else
+    {
+      for(Uint j = 0; j <= ny; ++j)
+      {
+        for(Uint i = j == ny ? 0 : nx; i <= nx; ++i)
+          to_local(block.global_idx(i, j));
+      }
+    }
+  }
+
+  /// Set the connectivity, rank and global index of the elements of a local block, for the element layers [layer_begin, layer_end) in the last direction.
+  /// The ghosts must have been added using add_block_ghosts first, after that the layers may be filled concurrently.
+  void fill_block_elements(const Uint block_idx, Elements& elements, const Uint first_element, const Uint layer_begin, const Uint layer_end) const
+  {
+    const Block& block = block_list[block_idx];
+    const Uint nb_nodes = block.dimensions == 3 ? 8 : 4;
+    const Uint layer_size = block.nb_elems / block.segments[block.dimensions-1];
+    Connectivity& connectivity = elements.geometry_space().connectivity();
+    common::List<Uint>& ranks = elements.rank();
+    common::List<Uint>& gids = elements.glb_idx();
+
+    Uint nodes[8];
+    for(Uint cell = layer_begin*layer_size; cell != layer_end*layer_size; ++cell)
+    {
+      const Uint element_idx = first_element + cell;
+      cell_nodes(block, cell, nodes);
+      Connectivity::Row element_connectivity = connectivity[element_idx];
+      for(Uint n = 0; n != nb_nodes; ++n)
+        element_connectivity[n] = local_idx(nodes[n]);
+      ranks[element_idx] = block.rank;
+      gids[element_idx] = block.element_offset + cell;
+    }
   }
 
-  /// Create the block coordinates
+  /// Create the block coordinates, for the node layers [k_begin, k_end) in the Z direction
   template<typename ET>
-  void fill_block_coordinates_3d(Table<Real>& mesh_coords, const Uint block_idx)
+  void fill_block_coordinates_3d(Table<Real>& mesh_coords, const Uint block_idx, const Uint k_begin, const Uint k_end) const
   {
+    const Block& block = block_list[block_idx];
     typename ET::NodesT block_nodes;
     fill(block_nodes, *points, (*blocks)[block_idx]);
     const Table<Uint>::ConstRow& segments = (*block_subdivisions)[block_idx];
@@ -525,7 +745,7 @@ struct BlockArrays::Implementation
 
     Real w[4][3]; // weights for each edge
     Real w_mag[3]; // Magnitudes of the weights
-    for(Uint k = 0; k <= segments[ZZ]; ++k)
+    for(Uint k = k_begin; k != k_end; ++k)
     {
       for(Uint j = 0; j <= segments[YY]; ++j)
       {
@@ -563,7 +783,7 @@ struct BlockArrays::Implementation
           typename ET::CoordsT coords = sf * block_nodes;
 
           // Store the result
-          const Uint node_idx = to_local(block_list[block_idx][i][j][k].global_idx());
+          const Uint node_idx = local_idx(block.global_idx(i, j, k));
           cf3_assert(node_idx < mesh_coords.size());
           mesh_coords[node_idx][XX] = coords[XX];
           mesh_coords[node_idx][YY] = coords[YY];
@@ -573,10 +793,11 @@ struct BlockArrays::Implementation
     }
   }
 
-  /// Create the block coordinates
+  /// Create the block coordinates, for the node layers [j_begin, j_end) in the Y direction
   template<typename ET>
-  void fill_block_coordinates_2d(Table<Real>& mesh_coords, const Uint block_idx)
+  void fill_block_coordinates_2d(Table<Real>& mesh_coords, const Uint block_idx, const Uint j_begin, const Uint j_end) const
   {
+    const Block& block = block_list[block_idx];
     typename ET::NodesT block_nodes;
     fill(block_nodes, *points, (*blocks)[block_idx]);
     const Table<Uint>::ConstRow& segments = (*block_subdivisions)[block_idx];
@@ -588,7 +809,7 @@ struct BlockArrays::Implementation
 
     Real w[2][2]; // weights for each edge
     Real w_mag[2]; // Magnitudes of the weights
-    for(Uint j = 0; j <= segments[YY]; ++j)
+    for(Uint j = j_begin; j != j_end; ++j)
     {
       for(Uint i = 0; i <= segments[XX]; ++i)
       {
@@ -613,7 +834,7 @@ struct BlockArrays::Implementation
         typename ET::CoordsT coords = sf * block_nodes;
 
         // Store the result
-        const Uint node_idx = to_local(block_list[block_idx][i][j].global_idx());
+        const Uint node_idx = local_idx(block.global_idx(i, j));
         cf3_assert(node_idx < mesh_coords.size());
         mesh_coords[node_idx][XX] = coords[XX];
         mesh_coords[node_idx][YY] = coords[YY];
@@ -621,12 +842,26 @@ struct BlockArrays::Implementation
     }
   }
 
-  void add_patch(const std::string& name, Elements& patch_elems)
+  /// Set the connectivity, rank and global index of a surface element
+  void add_face(const Patch& patch, const Uint face, Elements& patch_elems, const Uint elem_idx)
   {
-    const Uint dimensions = points->row_size();
+    Uint nodes[4];
+    face_nodes(patch, face, nodes);
+    Connectivity::Row elem_row = patch_elems.geometry_space().connectivity()[elem_idx];
+    for(Uint n = 0; n != elem_row.size(); ++n)
+      elem_row[n] = to_local(nodes[n]);
+    patch_elems.rank()[elem_idx] = patch.block.rank;
+    patch_elems.glb_idx()[elem_idx] = patch.element_offset + face;
+  }
 
+  /// Surface elements of other ranks, as the patch and the index of the element in the patch
+  typedef std::vector< std::pair<const Patch*, Uint> > FaceListT;
+
+  /// Add the surface elements of the local blocks to a patch, followed by the given overlap elements
+  void add_patch(const std::string& name, Elements& patch_elems, const FaceListT& overlap_faces)
+  {
     // Determine patch number of elements
-    Uint patch_nb_elems = 0;
+    Uint patch_nb_elems = overlap_faces.size();
     BOOST_FOREACH(const Patch& patch, patch_map[name])
     {
       if(patch.block.is_local)
@@ -634,57 +869,243 @@ struct BlockArrays::Implementation
     }
     patch_elems.resize(patch_nb_elems);
 
-    Connectivity& patch_conn = patch_elems.geometry_space().connectivity();
+    Uint elem_idx = 0;
+    BOOST_FOREACH(const Patch& patch, patch_map[name])
+    {
+      if(!patch.block.is_local)
+        continue;
+      for(Uint face = 0; face != patch.nb_elems; ++face)
+        add_face(patch, face, patch_elems, elem_idx++);
+    }
+
+    BOOST_FOREACH(const FaceListT::value_type& face, overlap_faces)
+    {
+      add_face(*face.first, face.second, patch_elems, elem_idx++);
+    }
+  }
 
-    if(dimensions == 3)
+  /// Block that stores the node with the given global index
+  const Block& storing_block(const Uint gid) const
+  {
+    Uint first = 0;
+    Uint last = block_list.size();
+    while(last - first > 1)
     {
-      const Uint idx_offsets[6][4][2] = {
-        {{0,0},{0,1},{1,1},{1,0}},
-        {{0,0},{0,1},{1,1},{1,0}},
-        {{0,0},{0,1},{1,1},{1,0}},
-        {{0,0},{1,0},{1,1},{0,1}},
-        {{0,0},{0,1},{1,1},{1,0}},
-        {{0,0},{1,0},{1,1},{0,1}}
-      };
+      const Uint middle = (first + last) / 2;
+      if(block_list[middle].start_index <= gid)
+        first = middle;
+      else
+        last = middle;
+    }
+    return block_list[first];
+  }
+
+  /// Add the cells that use the node with the given global index, as pairs of block index and cell index in the block.
+  /// For each block that refers to the storing block, the walk of Block::locate is undone: a node index of 0 in the storing block
+  /// may come from the last node index of the referring block.
+  void node_cells(const Uint gid, std::vector< std::pair<Uint, Uint> >& cells) const
+  {
+    const Block& block = storing_block(gid);
+    const Uint nb_dims = block.dimensions;
+    Uint node_idx[3] = {0, 0, 0};
+    Uint remainder = gid - block.start_index;
+    for(Uint d = nb_dims; d-- != 0;)
+    {
+      node_idx[d] = remainder / block.strides[d];
+      remainder -= node_idx[d] * block.strides[d];
+    }
+    cf3_assert(node_idx[nb_dims-1] < block.nb_points[nb_dims-1]);
 
-      Uint elem_idx = 0;
-      BOOST_FOREACH(const Patch& patch, patch_map[name])
+    BOOST_FOREACH(const Block* referring, block.referring_blocks)
+    {
+      const Uint block_idx = referring - &block_list[0];
+      for(Uint walked = 0; walked != (1u << nb_dims); ++walked)
       {
-        if(!patch.block.is_local)
+        Uint idx[3] = {0, 0, 0};
+        bool valid = true;
+        for(Uint d = 0; d != nb_dims && valid; ++d)
+        {
+          if(walked & (1u << d))
+          {
+            valid = node_idx[d] == 0;
+            idx[d] = referring->segments[d];
+          }
+          else
+          {
+            valid = node_idx[d] <= referring->segments[d];
+            idx[d] = node_idx[d];
+          }
+        }
+        if(!valid)
+          continue;
+
+        Uint located_idx[3] = {idx[0], idx[1], idx[2]};
+        if(referring->find(located_idx, nb_dims) != &block || !std::equal(located_idx, located_idx + nb_dims, node_idx))
           continue;
-        for(Uint i = 0; i != patch.segments[0]; ++i)
+
+        // The cells around the node in the referring block
+        for(Uint offset = 0; offset != (1u << nb_dims); ++offset)
         {
-          for(Uint j = 0; j != patch.segments[1]; ++j)
+          Uint cell = 0;
+          Uint stride = 1;
+          bool inside = true;
+          for(Uint d = 0; d != nb_dims && inside; ++d)
           {
-            Connectivity::Row elem_row = patch_conn[elem_idx++];
-            elem_row[0] = to_local(patch.global_idx(i + idx_offsets[patch.m_orientation][0][0], j + idx_offsets[patch.m_orientation][0][1]));
-            elem_row[1] = to_local(patch.global_idx(i + idx_offsets[patch.m_orientation][1][0], j + idx_offsets[patch.m_orientation][1][1]));
-            elem_row[2] = to_local(patch.global_idx(i + idx_offsets[patch.m_orientation][2][0], j + idx_offsets[patch.m_orientation][2][1]));
-            elem_row[3] = to_local(patch.global_idx(i + idx_offsets[patch.m_orientation][3][0], j + idx_offsets[patch.m_orientation][3][1]));
+            const Uint shift = (offset >> d) & 1u;
+            inside = idx[d] >= shift && idx[d] - shift < referring->segments[d];
+            cell += (idx[d] - shift) * stride;
+            stride *= referring->segments[d];
           }
+          if(inside)
+            cells.push_back(std::make_pair(block_idx, cell));
+        }
+      }
+    }
+  }
+
+  /// Add the global indices of the nodes on the sides of a block
+  void block_side_nodes(const Block& block, std::vector<Uint>& gids) const
+  {
+    const Uint nx = block.segments[XX];
+    const Uint ny = block.segments[YY];
+    if(block.dimensions == 3)
+    {
+      const Uint nz = block.segments[ZZ];
+      for(Uint k = 0; k <= nz; ++k)
+      {
+        for(Uint j = 0; j <= ny; ++j)
+        {
+          // Away from the Y and Z sides, only the first and last node in the X direction are on a side
+          const Uint i_step = (j == 0 || j == ny || k == 0 || k == nz) ? 1 : nx;
+          for(Uint i = 0; i <= nx; i += i_step)
+            gids.push_back(block.global_idx(i, j, k));
         }
       }
     }
     else
     {
-      cf3_assert(dimensions == 2);
-      Uint elem_idx = 0;
-      BOOST_FOREACH(const Patch& patch, patch_map[name])
+      for(Uint j = 0; j <= ny; ++j)
+      {
+        const Uint i_step = (j == 0 || j == ny) ? 1 : nx;
+        for(Uint i = 0; i <= nx; i += i_step)
+          gids.push_back(block.global_idx(i, j));
+      }
+    }
+  }
+
+  /// For blocks on other ranks, the sorted indices of the overlap elements in the block
+  typedef std::map<Uint, std::vector<Uint> > OverlapCellsT;
+
+  /// Find the elements of other ranks in the first nb_layers layers around the local blocks. Each layer consists of the elements that
+  /// share a node with the local elements or the previous layers, which is what GrowOverlap adds each time it is applied. The layers are
+  /// grown node by node, starting from the nodes on the sides of the local blocks, so elements that only touch at a corner are found for
+  /// any block layout. inner_nodes is set to the sorted nodes from which the last layer was grown.
+  void find_overlap_cells(const Uint nb_layers, OverlapCellsT& overlap_cells, std::vector<Uint>& inner_nodes) const
+  {
+    overlap_cells.clear();
+    inner_nodes.clear();
+    if(nb_layers == 0)
+      return;
+
+    std::vector<Uint> front;
+    BOOST_FOREACH(const Block& block, block_list)
+    {
+      if(block.is_local)
+        block_side_nodes(block, front);
+    }
+    std::sort(front.begin(), front.end());
+    front.erase(std::unique(front.begin(), front.end()), front.end());
+    std::set<Uint> known_nodes(front.begin(), front.end());
+
+    std::set< std::pair<Uint, Uint> > found_cells;
+    std::vector< std::pair<Uint, Uint> > cells;
+    std::vector<Uint> next_front;
+    Uint nodes[8];
+    for(Uint layer = 0; layer != nb_layers; ++layer)
+    {
+      if(layer == nb_layers-1)
+        inner_nodes.assign(known_nodes.begin(), known_nodes.end());
+
+      next_front.clear();
+      BOOST_FOREACH(const Uint gid, front)
+      {
+        cells.clear();
+        node_cells(gid, cells);
+        for(Uint c = 0; c != cells.size(); ++c)
+        {
+          const Block& block = block_list[cells[c].first];
+          if(block.is_local || !found_cells.insert(cells[c]).second)
+            continue;
+          overlap_cells[cells[c].first].push_back(cells[c].second);
+          cell_nodes(block, cells[c].second, nodes);
+          const Uint nb_nodes = block.dimensions == 3 ? 8 : 4;
+          for(Uint n = 0; n != nb_nodes; ++n)
+          {
+            if(known_nodes.insert(nodes[n]).second)
+              next_front.push_back(nodes[n]);
+          }
+        }
+      }
+      front.swap(next_front);
+    }
+
+    for(OverlapCellsT::iterator it = overlap_cells.begin(); it != overlap_cells.end(); ++it)
+      std::sort(it->second.begin(), it->second.end());
+  }
+
+  /// Find the surface elements of other ranks in the overlap. As for the volume elements, a surface element is in the last layer if it
+  /// shares a node with the elements it was grown from, given as inner_nodes by find_overlap_cells.
+  void find_overlap_faces(const OverlapCellsT& overlap_cells, const std::vector<Uint>& inner_nodes, std::map<std::string, FaceListT>& overlap_faces) const
+  {
+    overlap_faces.clear();
+    if(overlap_cells.empty())
+      return;
+
+    // Only patches next to an overlap element can touch these nodes
+    Uint nodes[4];
+    for(PatchMapT::const_iterator it = patch_map.begin(); it != patch_map.end(); ++it)
+    {
+      BOOST_FOREACH(const Patch& patch, it->second)
       {
-        if(!patch.block.is_local)
+        if(patch.block.is_local || overlap_cells.count(&patch.block - &block_list[0]) == 0)
           continue;
-        const Uint first_offset = patch.fixed_direction == 0 ? 1 : 0;
-        const Uint second_offset = patch.fixed_direction == 0 ? 0 : 1;
-        for(Uint i = 0; i != patch.segments[0]; ++i)
+        const Uint nb_nodes = patch.block.dimensions == 3 ? 4 : 2;
+        for(Uint face = 0; face != patch.nb_elems; ++face)
         {
-          Connectivity::Row elem_row = patch_conn[elem_idx++];
-          elem_row[1] = to_local(patch.global_idx(i + first_offset));
-          elem_row[0] = to_local(patch.global_idx(i + second_offset));
+          face_nodes(patch, face, nodes);
+          for(Uint n = 0; n != nb_nodes; ++n)
+          {
+            if(std::binary_search(inner_nodes.begin(), inner_nodes.end(), nodes[n]))
+            {
+              overlap_faces[it->first].push_back(std::make_pair(&patch, face));
+              break;
+            }
+          }
         }
       }
     }
   }
 
+  /// Append overlap elements of a block on another rank, starting at element_idx. This adds their nodes as ghosts.
+  void add_overlap_cells(const Uint block_idx, const std::vector<Uint>& cells, Elements& elements, Uint& element_idx)
+  {
+    const Block& block = block_list[block_idx];
+    const Uint nb_nodes = block.dimensions == 3 ? 8 : 4;
+    Connectivity& connectivity = elements.geometry_space().connectivity();
+
+    Uint nodes[8];
+    BOOST_FOREACH(const Uint cell, cells)
+    {
+      cell_nodes(block, cell, nodes);
+      Connectivity::Row element_connectivity = connectivity[element_idx];
+      for(Uint n = 0; n != nb_nodes; ++n)
+        element_connectivity[n] = to_local(nodes[n]);
+      elements.rank()[element_idx] = block.rank;
+      elements.glb_idx()[element_idx] = block.element_offset + cell;
+      ++element_idx;
+    }
+  }
+
   /// Create the data structure used to partition blocks
   BlocksPartitioning create_partitioning_data()
   {
@@ -1199,6 +1620,8 @@ struct BlockArrays::Implementation
   IndexMapT global_to_local;
   std::vector<Uint> block_distribution;
   std::vector<std::string> block_regions;
+  /// Number of threads used to fill the elements and coordinates of each block
+  Uint nb_threads;
 };
 
 BlockArrays::BlockArrays(const std::string& name) :
@@ -1273,6 +1696,11 @@ BlockArrays::BlockArrays(const std::string& name) :
   options().add("overlap", 1u).pretty_name("Overlap")
     .description("Number of cell layers to overlap across parallel partitions. Ignored in serial runs");
 
+  options().add("nb_threads", 1u)
+    .pretty_name("Number of Threads")
+    .description("Number of threads used to fill the element connectivity and node coordinates of each block on this rank")
+    .link_to(&m_implementation->nb_threads);
+
   options().add("block_regions", std::vector<std::string>())
     .pretty_name("Block Regions")
     .description("For each block, the region it belongs to. Leave empty to assign each block to the region \"interior\"")
@@ -1652,43 +2080,80 @@ void BlockArrays::create_mesh(Mesh& mesh)
 
   m_implementation->trigger_block_regions();
 
-  typedef std::map< std::string, std::vector<Uint> > ElementsDistT;
-  ElementsDistT elements_dist;
-  for(Uint proc = 0; proc != nb_procs; ++proc)
-  {
-    const Uint proc_begin = m_implementation->block_distribution[proc];
-    const Uint proc_end = m_implementation->block_distribution[proc+1];
-    Uint nb_elements = 0;
-    for(Uint block = proc_begin; block != proc_end; ++block)
-    {
-      std::vector<Uint>& region_elements_dist = elements_dist[m_implementation->block_regions[block]];
-      if(region_elements_dist.empty())
-        region_elements_dist.push_back(0);
-      if(region_elements_dist.size() < proc + 2)
-        region_elements_dist.push_back(region_elements_dist.back());
-      region_elements_dist.back() += m_implementation->block_list[block].nb_elems;
-    }
-  }
+  // Global element indices follow from the block structure
+  m_implementation->create_element_numbering(nb_procs);
 
+  const std::vector<Implementation::Block>& block_list = m_implementation->block_list;
+  const std::vector<std::string>& block_regions = m_implementation->block_regions;
+  const Uint nb_blocks = block_list.size();
   const Uint blocks_begin = m_implementation->block_distribution[rank];
   const Uint blocks_end = m_implementation->block_distribution[rank+1];
+  const Uint overlap = nb_procs > 1 ? options().value<Uint>("overlap") : 0u;
+
+  // Ghost nodes of the local elements
+  for(Uint block_idx = blocks_begin; block_idx != blocks_end; ++block_idx)
+  {
+    m_implementation->add_block_ghosts(block_idx);
+  }
+
+  // Elements of the other ranks that are in the overlap
+  Implementation::OverlapCellsT overlap_cells;
+  std::vector<Uint> inner_overlap_nodes;
+  std::map<std::string, Implementation::FaceListT> overlap_faces;
+  m_implementation->find_overlap_cells(overlap, overlap_cells, inner_overlap_nodes);
+  m_implementation->find_overlap_faces(overlap_cells, inner_overlap_nodes, overlap_faces);
+
+  // Number of elements in each volume region. All regions are created on each rank, even if they are empty.
+  std::map<std::string, Uint> region_nb_elems;
+  for(Uint block_idx = 0; block_idx != nb_blocks; ++block_idx)
+  {
+    Uint& nb_elems = region_nb_elems[block_regions[block_idx]];
+    if(block_list[block_idx].is_local)
+      nb_elems += block_list[block_idx].nb_elems;
+  }
+  for(Implementation::OverlapCellsT::const_iterator it = overlap_cells.begin(); it != overlap_cells.end(); ++it)
+  {
+    region_nb_elems[block_regions[it->first]] += it->second.size();
+  }
 
   Dictionary& geometry_dict = mesh.geometry_fields();
 
   std::map<std::string, Elements*> elements_map;
-  for(ElementsDistT::const_iterator it = elements_dist.begin(); it != elements_dist.end(); ++it)
+  for(std::map<std::string, Uint>::const_iterator it = region_nb_elems.begin(); it != region_nb_elems.end(); ++it)
   {
-    const std::vector<Uint>& region_elements_dist = it->second;
     Elements& volume_elements = mesh.topology().create_region(it->first).create_elements(dimensions == 3 ? "cf3.mesh.LagrangeP1.Hexa3D" : "cf3.mesh.LagrangeP1.Quad2D", geometry_dict);
-    volume_elements.resize(region_elements_dist[rank+1]-region_elements_dist[rank]);
+    volume_elements.resize(it->second);
     elements_map[it->first] = &volume_elements;
   }
 
-  // Set the connectivity, this also updates ghost node indices
-  std::map<std::string, Uint> element_idx_map; // global element index per region
+  // Set the connectivity, ranks and global indices of the local elements
+  const Uint nb_threads = m_implementation->nb_threads;
+  std::map<std::string, Uint> element_idx_map; // element index per region
   for(Uint block_idx = blocks_begin; block_idx != blocks_end; ++block_idx)
   {
-    m_implementation->add_block(block_subdivisions[block_idx], block_idx, elements_map[m_implementation->block_regions[block_idx]]->geometry_space().connectivity(), element_idx_map[m_implementation->block_regions[block_idx]]);
+    const std::string& region = block_regions[block_idx];
+    Uint& element_idx = element_idx_map[region];
+    detail::run_threaded(nb_threads, block_subdivisions[block_idx][dimensions-1],
+      boost::bind(&Implementation::fill_block_elements, m_implementation.get(), block_idx, boost::ref(*elements_map[region]), element_idx, _1, _2));
+    element_idx += block_list[block_idx].nb_elems;
+  }
+
+  // Overlap elements are stored after the local elements
+  for(Implementation::OverlapCellsT::const_iterator it = overlap_cells.begin(); it != overlap_cells.end(); ++it)
+  {
+    const std::string& region = block_regions[it->first];
+    m_implementation->add_overlap_cells(it->first, it->second, *elements_map[region], element_idx_map[region]);
+  }
+
+  // Add surface patches
+  for(Implementation::PatchMapT::const_iterator it = m_implementation->patch_map.begin(); it != m_implementation->patch_map.end(); ++it)
+  {
+    m_implementation->add_patch
+    (
+      it->first,
+      mesh.topology().create_region(it->first).create_elements(dimensions == 3 ? "cf3.mesh.LagrangeP1.Quad3D" : "cf3.mesh.LagrangeP1.Line2D", geometry_dict),
+      overlap_faces[it->first]
+    );
   }
 
   const Uint nodes_begin = m_implementation->nodes_dist[rank];
@@ -1699,26 +2164,16 @@ void BlockArrays::create_mesh(Mesh& mesh)
   mesh.initialize_nodes(nb_nodes_local + m_implementation->ghost_counter, dimensions);
   Field& coordinates = mesh.geometry_fields().coordinates();
 
-  // Fill the coordinate array
+  // Fill the coordinate array. Blocks are handled one at a time, since neighboring blocks share nodes.
   for(Uint block_idx = blocks_begin; block_idx != blocks_end; ++block_idx)
   {
+    const Uint nb_node_layers = block_subdivisions[block_idx][dimensions-1] + 1;
     if(dimensions == 3)
-      m_implementation->fill_block_coordinates_3d<Hexa3D>(coordinates, block_idx);
+      detail::run_threaded(nb_threads, nb_node_layers, boost::bind(&Implementation::fill_block_coordinates_3d<Hexa3D>, m_implementation.get(), boost::ref(coordinates), block_idx, _1, _2));
     if(dimensions == 2)
-      m_implementation->fill_block_coordinates_2d<Quad2D>(coordinates, block_idx);
+      detail::run_threaded(nb_threads, nb_node_layers, boost::bind(&Implementation::fill_block_coordinates_2d<Quad2D>, m_implementation.get(), boost::ref(coordinates), block_idx, _1, _2));
   }
 
-  // Add surface patches
-  for(Implementation::PatchMapT::const_iterator it = m_implementation->patch_map.begin(); it != m_implementation->patch_map.end(); ++it)
-  {
-    m_implementation->add_patch
-    (
-      it->first,
-      mesh.topology().create_region(it->first).create_elements(dimensions == 3 ? "cf3.mesh.LagrangeP1.Quad3D" : "cf3.mesh.LagrangeP1.Line2D", geometry_dict)
-    );
-  }
-
-  // surface patches shouldn't have introduced new ghosts
   cf3_assert(coordinates.size() == nb_nodes_local + m_implementation->ghost_counter);
 
   if(PE::Comm::instance().is_active())
@@ -1742,6 +2197,7 @@ void BlockArrays::create_mesh(Mesh& mesh)
       ranks[local_id] = std::upper_bound(m_implementation->nodes_dist.begin(), m_implementation->nodes_dist.end(), global_id) - 1 - m_implementation->nodes_dist.begin();
     }
 
+    // The coordinates of the ghosts in the overlap come from their owners
     mesh.geometry_fields().coordinates().parallelize_with(mesh.geometry_fields().comm_pattern());
     mesh.geometry_fields().coordinates().synchronize();
   }
@@ -1750,59 +2206,7 @@ void BlockArrays::create_mesh(Mesh& mesh)
     cf3_assert(m_implementation->ghost_counter == 0);
   }
 
-  // Total number of elements on this rank
-  Uint mesh_nb_elems = 0;
-  boost_foreach(Elements& elements , find_components_recursively<Elements>(mesh))
-  {
-    mesh_nb_elems += elements.size();
-  }
-
-  std::vector<Uint> nb_elements_accumulated;
-  if(PE::Comm::instance().is_active())
-  {
-    // Get the total number of elements on each rank
-    PE::Comm::instance().all_gather(mesh_nb_elems, nb_elements_accumulated);
-  }
-  else
-  {
-    nb_elements_accumulated.push_back(mesh_nb_elems);
-  }
-  cf3_assert(nb_elements_accumulated.size() == nb_procs);
-  // Sum up the values
-  for(Uint i = 1; i != nb_procs; ++i)
-    nb_elements_accumulated[i] += nb_elements_accumulated[i-1];
-
-  // Offset to start with for this rank
-  Uint element_offset = rank == 0 ? 0 : nb_elements_accumulated[rank-1];
-
-  // Update the element ranks and gids
-  boost_foreach(Elements& elements , find_components_recursively<Elements>(mesh))
-  {
-    const Uint nb_elems = elements.size();
-    elements.rank().resize(nb_elems);
-    elements.glb_idx().resize(nb_elems);
-
-    for (Uint elem=0; elem != nb_elems; ++elem)
-    {
-      elements.rank()[elem] = rank;
-      elements.glb_idx()[elem] = elem + element_offset;
-    }
-    element_offset += nb_elems;
-  }
-
   mesh.update_structures();
-
-  const Uint overlap = options().value<Uint>("overlap");
-  if(overlap != 0 && PE::Comm::instance().size() > 1)
-  {
-    mesh.block_mesh_changed(true); // avoid triggering mesh_changed before the load event is raised
-    MeshTransformer& grow_overlap = *Handle<MeshTransformer>(create_component("GrowOverlap", "cf3.mesh.actions.GrowOverlap"));
-    for(Uint i = 0; i != overlap; ++i)
-      grow_overlap.transform(mesh);
-
-    mesh.geometry_fields().remove_component("CommPattern");
-    mesh.block_mesh_changed(false);
-  }
   mesh.raise_mesh_loaded();
 }
 
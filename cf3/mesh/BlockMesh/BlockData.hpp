@@ -78,7 +78,9 @@ public:
   /// @param gradings Uniform grading definition in the spanwise direction for each block
   void extrude_blocks(const std::vector<Real>& positions, const std::vector<Uint>& nb_segments, const std::vector<Real>& gradings);
 
-  /// Create the refined mesh
+  /// Create the refined mesh. Each rank only generates the elements of its own blocks and of the overlap. The global indices and ranks
+  /// of nodes and elements follow from the block structure, so no global numbering is needed afterwards. The overlap holds the same
+  /// elements as applying GrowOverlap "overlap" times, but it is found from the block indices.
   /// @param mesh The mesh in which the output will be stored
   void create_mesh(Mesh& mesh);
 
@@ -72,6 +72,10 @@ ChannelGenerator::ChannelGenerator(const std::string& name): MeshGenerator(name)
   options().add("grading", 0.2)
     .description("Grading ratio. Values smaller than one refine towards the wall")
     .pretty_name("Grading Ratio");
+
+  options().add("nb_threads", 1u)
+    .description("Number of threads used to generate the mesh on each process")
+    .pretty_name("Number of Threads");
 }
 
 void ChannelGenerator::execute()
@@ -92,6 +96,7 @@ void ChannelGenerator::execute()
   const Real ratio = options().value<Real>("grading");
 
   BlockArrays& blocks = *create_component<BlockArrays>("BlockArrays");
+  blocks.options().set("nb_threads", options().value<Uint>("nb_threads"));
 
   Table<Real>& points = *blocks.create_points(3, 12);
   points  << 0.     << -half_height << 0.
@@ -14,7 +14,7 @@
 #include "common/Builder.hpp"
 #include "common/FindComponents.hpp"
 #include "common/Tags.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/List.hpp"
 #include "common/PE/Comm.hpp"
 #include "common/PE/CommPattern.hpp"
@@ -302,19 +302,15 @@ void DiscontinuousDictionary::rebuild_spaces_from_geometry()
 
 void DiscontinuousDictionary::rebuild_node_to_element_connectivity()
 {
-  // Reserve memory in m_connectivity->array()
-  m_connectivity->array().resize(size());
-  for (Uint n=0; n<size(); ++n)
-  {
-    m_connectivity->set_row_size(n,1);
-  }
+  // Each node belongs to exactly one element
+  m_connectivity->set_row_sizes(std::vector<Uint>(size(),1u));
   boost_foreach (const Handle<Space>& space, spaces())
   {
     for (Uint elem_idx=0; elem_idx<space->size(); ++elem_idx)
     {
       boost_foreach (const Uint node_idx, space->connectivity()[elem_idx])
       {
-        m_connectivity->array()[node_idx][0]=SpaceElem(*space,elem_idx);
+        (*m_connectivity)[node_idx][0]=SpaceElem(*space,elem_idx);
       }
     }
   }
@@ -0,0 +1,144 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <numeric>
+
+#include "common/Builder.hpp"
+#include "common/Foreach.hpp"
+#include "common/PropertyList.hpp"
+
+#include "math/Consts.hpp"
+
+#include "mesh/ElementColouring.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Space.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+using namespace common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+ComponentBuilder< ElementColouring, Component, LibMesh > ElementColouring_Builder;
+
+////////////////////////////////////////////////////////////////////////////////
+
+ElementColouring::ElementColouring ( const std::string& name ) :
+  Component(name),
+  m_colour_offsets(1, 0u),
+  m_nb_nodes(0)
+{
+  properties()["brief"] = std::string("Colouring of the parent elements, so that elements with the same colour share no nodes");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ElementColouring::~ElementColouring()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ElementColouring::build(const Entities& entities)
+{
+  const Connectivity& connectivity = entities.geometry_space().connectivity();
+  const Uint nb_elems = connectivity.size();
+  m_nb_nodes = entities.geometry_fields().size();
+
+  // Node to element connectivity, local to these entities, in compressed row format
+  std::vector<Uint> node_offsets(m_nb_nodes+1, 0u);
+  boost_foreach(Connectivity::ConstRow elem_nodes, connectivity.array())
+  {
+    boost_foreach(const Uint node_idx, elem_nodes)
+    {
+      cf3_assert(node_idx < m_nb_nodes);
+      ++node_offsets[node_idx+1];
+    }
+  }
+  std::partial_sum(node_offsets.begin(), node_offsets.end(), node_offsets.begin());
+
+  std::vector<Uint> node_elements(node_offsets.back());
+  std::vector<Uint> fill_position(node_offsets.begin(), node_offsets.end()-1);
+  for(Uint elem = 0; elem != nb_elems; ++elem)
+  {
+    boost_foreach(const Uint node_idx, connectivity[elem])
+    {
+      node_elements[fill_position[node_idx]++] = elem;
+    }
+  }
+
+  // Greedy colouring: each element gets the lowest colour not used by an already coloured neighbour
+  const Uint not_coloured = math::Consts::uint_max();
+  m_colours.assign(nb_elems, not_coloured);
+  std::vector<Uint> colour_marker; // colour_marker[c] == elem if colour c is used by a neighbour of elem
+  std::vector<Uint> colour_sizes;
+  for(Uint elem = 0; elem != nb_elems; ++elem)
+  {
+    boost_foreach(const Uint node_idx, connectivity[elem])
+    {
+      for(Uint i = node_offsets[node_idx]; i != node_offsets[node_idx+1]; ++i)
+      {
+        const Uint neighbour_colour = m_colours[node_elements[i]];
+        if(neighbour_colour != not_coloured)
+          colour_marker[neighbour_colour] = elem;
+      }
+    }
+
+    Uint elem_colour = 0;
+    while(elem_colour != colour_marker.size() && colour_marker[elem_colour] == elem)
+      ++elem_colour;
+
+    if(elem_colour == colour_marker.size())
+    {
+      colour_marker.push_back(not_coloured);
+      colour_sizes.push_back(0);
+    }
+
+    m_colours[elem] = elem_colour;
+    ++colour_sizes[elem_colour];
+  }
+
+  // Sort the elements by colour, keeping the original order within each colour
+  m_colour_offsets.assign(colour_sizes.size()+1, 0u);
+  std::partial_sum(colour_sizes.begin(), colour_sizes.end(), m_colour_offsets.begin()+1);
+  m_elements.resize(nb_elems);
+  fill_position.assign(m_colour_offsets.begin(), m_colour_offsets.end()-1);
+  for(Uint elem = 0; elem != nb_elems; ++elem)
+  {
+    m_elements[fill_position[m_colours[elem]]++] = elem;
+  }
+
+  properties()["nb_colours"] = nb_colours();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ElementColouring::is_valid_for(const Entities& entities) const
+{
+  return m_colours.size() == entities.size() && m_nb_nodes == entities.geometry_fields().size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const ElementColouring& element_colouring(Entities& entities)
+{
+  Handle<ElementColouring> colouring(entities.get_child("element_colouring"));
+  if(is_null(colouring))
+    colouring = entities.create_component<ElementColouring>("element_colouring");
+
+  if(!colouring->is_valid_for(entities))
+    colouring->build(entities);
+
+  return *colouring;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
@@ -0,0 +1,88 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_ElementColouring_hpp
+#define cf3_mesh_ElementColouring_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include "common/Component.hpp"
+
+#include "mesh/LibMesh.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+  class Entities;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Partitions the elements of an Entities component into colours, so that
+/// no two elements with the same colour share a node of the geometry.
+/// Elements of the same colour can then be processed concurrently without
+/// conflicting writes to nodal data or to the rows of a linear system.
+/// Colours are assigned greedily, in element order.
+/// @author Bart Janssens
+class Mesh_API ElementColouring : public common::Component
+{
+public:
+
+  /// Contructor
+  /// @param name of the component
+  ElementColouring ( const std::string& name );
+
+  /// Virtual destructor
+  virtual ~ElementColouring();
+
+  /// Get the class name
+  static std::string type_name () { return "ElementColouring"; }
+
+  /// Build the colouring, based on the connectivity of the geometry space of the given entities
+  void build(const Entities& entities);
+
+  /// True if the colouring was built for entities with the same number of elements and geometry nodes
+  bool is_valid_for(const Entities& entities) const;
+
+  /// Number of colours
+  Uint nb_colours() const { return m_colour_offsets.size() - 1; }
+
+  /// Number of elements with the given colour
+  Uint colour_size(const Uint colour) const { return m_colour_offsets[colour+1] - m_colour_offsets[colour]; }
+
+  /// Element index (in the Entities) of the i-th element with the given colour
+  Uint element(const Uint colour, const Uint i) const { return m_elements[m_colour_offsets[colour] + i]; }
+
+  /// Colour of the element with the given index
+  Uint colour(const Uint element_idx) const { return m_colours[element_idx]; }
+
+private:
+  /// Colour of each element
+  std::vector<Uint> m_colours;
+
+  /// Element indices, sorted by colour
+  std::vector<Uint> m_elements;
+
+  /// Start of each colour in m_elements, with one extra entry marking the end
+  std::vector<Uint> m_colour_offsets;
+
+  /// Number of geometry nodes at the time of the last build
+  Uint m_nb_nodes;
+};
+
+/// Get the colouring of the given entities, (re)building it if needed.
+/// The colouring is cached as a child of the entities.
+Mesh_API const ElementColouring& element_colouring(Entities& entities);
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_ElementColouring_hpp
@@ -88,41 +88,23 @@ bool ElementFinderOcttree::find_element(const RealVector& target_coord, SpaceEle
   for (Uint d=0; d<target_coord.size(); ++d)
     t_coord[d] = target_coord[d];
 
-  m_elements_pool.clear();
+  if (m_octtree->find_element(t_coord,m_tmp))
+  {
+    element = SpaceElem(*const_cast<Space*>(&m_dict->space(*m_tmp.comp)),m_tmp.idx);
+    return true;
+  }
 
-  if (m_octtree->find_octtree_cell(t_coord,m_octtree_idx))
+  // No element contains the coordinate, so gather the elements in the octtree cells around it to find the closest one
+  m_elements_pool.clear();
+  if (m_closest && m_octtree->find_octtree_cell(t_coord,m_octtree_idx))
   {
-    Uint pool_size = 0;
     Uint rings=0;
-    for ( ; pool_size==0 ; ++rings)
-    {
-      pool_size=m_elements_pool.size();
+    for ( ; m_elements_pool.empty() && rings<=m_octtree->max_ring(); ++rings)
       m_octtree->gather_elements_around_idx(m_octtree_idx,rings,m_elements_pool);
-      boost_foreach(const Entity& pool_elem, boost::make_iterator_range(m_elements_pool.begin()+pool_size,m_elements_pool.end()))
-      {
-        cf3_assert(is_not_null(pool_elem.comp));
-        const RealMatrix elem_coordinates = pool_elem.get_coordinates();
-        if (pool_elem.element_type().is_coord_in_element(t_coord,elem_coordinates))
-        {
-          element = SpaceElem(*const_cast<Space*>(&m_dict->space(*pool_elem.comp)),pool_elem.idx);
-          return true;
-        }
-      }
-    }
-    // if arrived here, keep searching
-    // it means no element has been found. The search is enlarged with one more ring, for possible misses.
+    // The search is enlarged with one more ring, for possible misses.
     m_octtree->gather_elements_around_idx(m_octtree_idx,rings,m_elements_pool);
-    boost_foreach(const Entity& pool_elem, boost::make_iterator_range(m_elements_pool.begin()+pool_size,m_elements_pool.end()))
-    {
-      cf3_assert(is_not_null(pool_elem.comp));
-      const RealMatrix elem_coordinates = pool_elem.get_coordinates();
-      if (pool_elem.element_type().is_coord_in_element(t_coord,elem_coordinates))
-      {
-        element = SpaceElem(*const_cast<Space*>(&m_dict->space(*pool_elem.comp)),pool_elem.idx);
-        return true;
-      }
-    }
   }
+
   if (m_closest)
   {
 //    std::cout << "didnt find element ... will look more in a pool of " << m_elements_pool.size() << std::endl;
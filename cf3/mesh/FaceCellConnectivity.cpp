@@ -10,13 +10,14 @@
 #include "common/FindComponents.hpp"
 #include "common/Link.hpp"
 #include "common/Builder.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/OptionList.hpp"
 
 #include "math/MatrixTypes.hpp"
 #include "math/Consts.hpp"
 
 #include "mesh/FaceCellConnectivity.hpp"
+#include "mesh/FaceNodeHash.hpp"
 #include "mesh/NodeElementConnectivity.hpp"
 #include "mesh/Dictionary.hpp"
 #include "mesh/Mesh.hpp"
@@ -127,7 +128,6 @@ void FaceCellConnectivity::build_connectivity()
 
   Dictionary& geometry_fields = find_parent_component<Mesh>(*used()[0]).geometry_fields();
   Uint tot_nb_nodes = geometry_fields.size();
-  std::vector < std::vector<Uint> > mapNodeFace(tot_nb_nodes);
   std::vector<Uint> face_nodes;  face_nodes.reserve(100);
   std::vector<Entity> dummy_element_row(2);
   std::vector<Uint> tmp_row(2);
@@ -165,18 +165,14 @@ void FaceCellConnectivity::build_connectivity()
     }
   }
 
+  // Faces are matched by their nodes. Every inner face is found twice, so this is an upper bound.
+  FaceNodeHash face_hash(max_nb_faces);
+
   // Declarations to save frequent allocations in the loop algorithm
   Uint nb_inner_faces = 0;
-  Uint nb_matched_nodes = 1;
-  Uint face_node_idx;
-  Uint face_node;
   Uint face;
-  Uint connected_face;
-  Uint node;
   Uint nb_nodes;
   bool found_face = false;
-  Handle< Component > elem_location_comp;
-  Uint elem_location_idx;
 
   // loop over the element types
   m_nb_faces=0;
@@ -210,95 +206,52 @@ void FaceCellConnectivity::build_connectivity()
         Uint i(0);
         boost_foreach(const Uint face_node_idx, elements.element_type().faces().nodes_range(face_idx))
             face_nodes[i++] = elem_nodes[face_node_idx];
+        cf3_assert(face_nodes[0]<tot_nb_nodes);
 
-
-        // consider the first node belonging to the current face
-        // check if you find a face ID shared between all the other
-        // nodes building a face
-        node = face_nodes[0];
-        cf3_assert(node<tot_nb_nodes);
-
-        found_face = false;
-        // search for matching face if they are registered to the node yet
-        boost_foreach( face, mapNodeFace[node] )
+        // look up the face by its nodes, registering it if it is new
+        const std::pair<Uint,bool> face_entry = face_hash.insert(face_nodes);
+        face = face_entry.first;
+        found_face = !face_entry.second;
+        if (found_face)
         {
-          nb_matched_nodes = 1;
-          if (nb_nodes > 1)
+          // the corresponding face already exists, meaning
+          // that the face is an internal one, shared by two elements
+          // here you set the second element (==state) neighbor of the face
+          f2c.get_row(face)[1]=element;
+          face_number.get_row(face)[1]=face_idx;
+          // since it has two neighbor cells,
+          // this face is surely NOT a boundary face
+          is_bdry_face.get_row(face)=false;
+
+          if (nb_nodes > 1) // rotation is irrelevant for the point faces of the 1D case
           {
-            for (face_node_idx=1; face_node_idx!=nb_nodes; ++face_node_idx)
+            // First node in first face element:
+            Uint first_node_loc_idx = f2c.get_row(face)[0].get_nodes()[
+                                        f2c.get_row(face)[0].element_type().faces().nodes_range(
+                                          face_number.get_row(face)[0])[0]
+                                      ];
+
+            // Find orientation ( or find match between first face-nodes of both neighbouring elements )
+            Uint rotation;
+            for (rotation=0; rotation<=nb_nodes; ++rotation)
             {
-              boost_foreach (connected_face, mapNodeFace[face_nodes[face_node_idx]])
-              {
-                if (connected_face == face)
-                {
-                  ++nb_matched_nodes;
-                  break;
-                }
-              }
-
-
-              if (nb_matched_nodes == nb_nodes) // face matches the nodes
+              if (face_nodes[rotation] == first_node_loc_idx)
               {
-                // the corresponding face already exists, meaning
-                // that the face is an internal one, shared by two elements
-                // here you set the second element (==state) neighbor of the face
-                found_face = true;
-                f2c.get_row(face)[1]=element;
-                face_number.get_row(face)[1]=face_idx;
-                // since it has two neighbor cells,
-                // this face is surely NOT a boundary face
-                is_bdry_face.get_row(face)=false;
-
-                // First node in first face element:
-                Uint first_node_loc_idx = f2c.get_row(face)[0].get_nodes()[
-                                            f2c.get_row(face)[0].element_type().faces().nodes_range(
-                                              face_number.get_row(face)[0])[0]
-                                          ];
-
-                // Find orientation ( or find match between first face-nodes of both neighbouring elements )
-                Uint rotation;
-                for (rotation=0; rotation<=nb_nodes; ++rotation)
-                {
-                  if (face_nodes[rotation] == first_node_loc_idx)
-                  {
-                    cell_rotation.get_row(face)[1]=rotation;
-                    break;
-                  }
-                }
-                // Following assertion fails, it means the correct orientation was not found! This should never happen!
-                cf3_always_assert(rotation != nb_nodes);
-
-                // increment number of inner faces (they always have 2 states)
-                ++nb_inner_faces;
+                cell_rotation.get_row(face)[1]=rotation;
                 break;
               }
             }
+            // Following assertion fails, it means the correct orientation was not found! This should never happen!
+            cf3_always_assert(rotation != nb_nodes);
           }
-          else // this only applies to the 1D case
-          {
-            // the corresponding faceID already exists, meaning
-            // that the face is an internal one, shared by two elements
-            // here you set the second element (==state) neighbor of the face
-            found_face = true;
-            //(*elem_to_face)[elemID][iFace] = currFaceID;
-            f2c.get_row(face)[1]=element;
-            face_number.get_row(face)[1]=face_idx;
-            is_bdry_face.get_row(face)=false;
-
-            // increment number of inner faces (they always have 2 states)
-            ++nb_inner_faces;
-            break;
-          }
+
+          // increment number of inner faces (they always have 2 states)
+          ++nb_inner_faces;
         }
-        if (found_face == false)
+        else
         {
-          // a new face has been found
-          // add the ID of the new face in the corresponding nodes
-          // referencing it
-          boost_foreach (face_node, face_nodes)
-          {
-            mapNodeFace[face_node].push_back(m_nb_faces);
-          }
+          // a new face has been found, it got index m_nb_faces in the hash
+          cf3_assert(face == m_nb_faces);
 
           // increment the number of faces
           dummy_element_row[0]=element;
@@ -0,0 +1,121 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include <boost/functional/hash.hpp>
+
+#include "math/Consts.hpp"
+
+#include "mesh/FaceNodeHash.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint FaceNodeHash::not_found()
+{
+  return math::Consts::uint_max();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+FaceNodeHash::FaceNodeHash(const Uint expected_nb_faces) :
+  m_key_offsets(1, 0u)
+{
+  reserve(expected_nb_faces);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FaceNodeHash::reserve(const Uint nb_faces)
+{
+  m_key_offsets.reserve(nb_faces+1);
+  m_hashes.reserve(nb_faces);
+
+  // Keep the load factor below 1/2
+  Uint nb_slots = 16;
+  while(nb_slots < 2*nb_faces)
+    nb_slots *= 2;
+  if(nb_slots > m_slots.size())
+    rehash(nb_slots);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint FaceNodeHash::find(const std::vector<Uint>& nodes) const
+{
+  const Uint slot = find_slot(sort_and_hash(nodes));
+  return m_slots[slot];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::pair<Uint,bool> FaceNodeHash::insert(const std::vector<Uint>& nodes)
+{
+  if(2*(size()+1) > m_slots.size())
+    rehash(2*m_slots.size());
+
+  const std::size_t hash = sort_and_hash(nodes);
+  const Uint slot = find_slot(hash);
+  if(m_slots[slot] != not_found())
+    return std::make_pair(m_slots[slot], false);
+
+  const Uint face = size();
+  m_slots[slot] = face;
+  m_hashes.push_back(hash);
+  m_key_nodes.insert(m_key_nodes.end(), m_sorted_nodes.begin(), m_sorted_nodes.end());
+  m_key_offsets.push_back(m_key_nodes.size());
+  return std::make_pair(face, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t FaceNodeHash::sort_and_hash(const std::vector<Uint>& nodes) const
+{
+  m_sorted_nodes.assign(nodes.begin(), nodes.end());
+  std::sort(m_sorted_nodes.begin(), m_sorted_nodes.end());
+  return boost::hash_range(m_sorted_nodes.begin(), m_sorted_nodes.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint FaceNodeHash::find_slot(const std::size_t hash) const
+{
+  const std::size_t mask = m_slots.size() - 1;
+  const Uint nb_nodes = m_sorted_nodes.size();
+  for(std::size_t slot = hash & mask; ; slot = (slot+1) & mask)
+  {
+    const Uint face = m_slots[slot];
+    if(face == not_found())
+      return slot;
+    if(m_hashes[face] != hash || m_key_offsets[face+1] - m_key_offsets[face] != nb_nodes)
+      continue;
+    if(std::equal(m_sorted_nodes.begin(), m_sorted_nodes.end(), m_key_nodes.begin() + m_key_offsets[face]))
+      return slot;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FaceNodeHash::rehash(const Uint nb_slots)
+{
+  m_slots.assign(nb_slots, not_found());
+  const std::size_t mask = nb_slots - 1;
+  for(Uint face = 0; face != size(); ++face)
+  {
+    std::size_t slot = m_hashes[face] & mask;
+    while(m_slots[slot] != not_found())
+      slot = (slot+1) & mask;
+    m_slots[slot] = face;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
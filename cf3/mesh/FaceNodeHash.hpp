@@ -0,0 +1,79 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_FaceNodeHash_hpp
+#define cf3_mesh_FaceNodeHash_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include "mesh/LibMesh.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Hash table identifying faces by their nodes, irrespective of the node order.
+/// Faces are numbered in order of insertion. The sorted node tuples are stored
+/// contiguously, and the table itself uses open addressing with linear probing,
+/// so no memory is allocated per face.
+/// @note find() and insert() use an internal scratch buffer, and are not thread-safe
+class Mesh_API FaceNodeHash
+{
+public:
+
+  /// Value returned by find() if no face with the given nodes exists
+  static Uint not_found();
+
+  /// Constructor
+  /// @param expected_nb_faces number of faces to reserve space for
+  FaceNodeHash(const Uint expected_nb_faces=0);
+
+  /// Reserve space for the given number of faces
+  void reserve(const Uint nb_faces);
+
+  /// Number of faces in the table
+  Uint size() const { return m_key_offsets.size() - 1; }
+
+  /// Index of the face with the given nodes, or not_found()
+  Uint find(const std::vector<Uint>& nodes) const;
+
+  /// Add a face with the given nodes, if it is not present yet
+  /// @return the index of the face with these nodes, and true if it was newly inserted
+  std::pair<Uint,bool> insert(const std::vector<Uint>& nodes);
+
+private:
+
+  /// Sort the nodes into m_sorted_nodes, and return their hash
+  std::size_t sort_and_hash(const std::vector<Uint>& nodes) const;
+
+  /// Slot holding the face with the nodes in m_sorted_nodes, or the empty slot where it belongs
+  Uint find_slot(const std::size_t hash) const;
+
+  void rehash(const Uint nb_slots);
+
+  /// Start of the sorted nodes of each face in m_key_nodes, with one extra entry marking the end
+  std::vector<Uint> m_key_offsets;
+  /// Sorted nodes of all faces
+  std::vector<Uint> m_key_nodes;
+  /// Hash of each face
+  std::vector<std::size_t> m_hashes;
+  /// Face index in each slot, not_found() for empty slots. The size is a power of 2.
+  std::vector<Uint> m_slots;
+
+  mutable std::vector<Uint> m_sorted_nodes;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_FaceNodeHash_hpp
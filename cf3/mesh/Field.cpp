@@ -176,6 +176,36 @@ void Field::synchronize()
   m_comm_pattern->synchronize( name() );
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::begin_synchronize()
+{
+  if(!common::PE::Comm::instance().is_active())
+    return;
+
+  if(is_null(m_comm_pattern))
+  {
+    CFdebug << "Applying default parallelization from dict for field " << uri().path() << CFendl;
+    parallelize();
+  }
+
+  cf3_assert(is_not_null(m_comm_pattern));
+
+  CFdebug << "Starting synchronization of field " << uri().path() << CFendl;
+  m_comm_pattern->begin_synchronize( name() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::end_synchronize()
+{
+  if(!common::PE::Comm::instance().is_active())
+    return;
+
+  cf3_assert(is_not_null(m_comm_pattern));
+  m_comm_pattern->end_synchronize( name() );
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 void Field::set_descriptor(math::VariablesDescriptor& descriptor)
@@ -268,21 +298,21 @@ Field& Field::coordinates() const
 
 Field::Ref Field::ref()
 {
-  return Ref( &array()[0][0], size(), row_size(), Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(row_size(),row_size()-1));
+  return Ref( &array()[0][0], size(), row_size(), Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(array().strides()[0],array().strides()[1]));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 Field::Ref  Field::col(const Uint c)
 {
-  return Ref( &array()[0][c], size(), 1, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(row_size(),0) );
+  return Ref( &array()[0][c], size(), 1, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(array().strides()[0],array().strides()[1]) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 Field::RowArrayRef  Field::row(const Uint r)
 {
-  return RowArrayRef( &array()[r][0], 1, row_size() );
+  return RowArrayRef( &array()[r][0], 1, row_size(), Eigen::InnerStride<Eigen::Dynamic>(array().strides()[1]) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -296,14 +326,15 @@ Real& Field::scalar(const Uint r)
 
 Field::RowVectorRef Field::vector(const Uint r)
 {
-  return RowVectorRef( &array()[r][0], 1, row_size() );
+  return RowVectorRef( &array()[r][0], 1, row_size(), Eigen::InnerStride<Eigen::Dynamic>(array().strides()[1]) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 Field::RowTensorRef Field::tensor(const Uint r)
 {
-  return RowTensorRef( &array()[r][0],  sqrt(row_size()), sqrt(row_size()));
+  const Uint n = sqrt(row_size());
+  return RowTensorRef( &array()[r][0], n, n, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(n*array().strides()[1], array().strides()[1]) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
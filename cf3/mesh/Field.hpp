@@ -30,6 +30,10 @@ namespace mesh {
 /// Field component class
 /// This class stores fields which can be applied
 /// to fields (Field)
+/// The values of a node are stored contiguously by default. With set_column_major(true), each
+/// variable component is stored in its own contiguous array instead, which helps kernels that
+/// only use a few variables. The Eigen maps returned by ref(), col(), row(), vector() and tensor()
+/// work for both layouts.
 /// @author Willem Deconinck, Tiago Quintino
 class Mesh_API Field : public common::Table<Real> {
 
@@ -44,13 +48,13 @@ public: // typedefs
   typedef Eigen::Block<Ref, Eigen::Dynamic, 1> RefCol;
 
   typedef Eigen::Array<Real,1,Eigen::Dynamic,Eigen::RowMajor> RowArrayStorage ;
-  typedef Eigen::Map< RowArrayStorage , Eigen::Unaligned > RowArrayRef ;
+  typedef Eigen::Map< RowArrayStorage , Eigen::Unaligned, Eigen::InnerStride<Eigen::Dynamic> > RowArrayRef ;
 
   typedef Eigen::Matrix<Real,1,Eigen::Dynamic,Eigen::RowMajor> RowVectorStorage ;
-  typedef Eigen::Map< RowVectorStorage , Eigen::Unaligned > RowVectorRef ;
+  typedef Eigen::Map< RowVectorStorage , Eigen::Unaligned, Eigen::InnerStride<Eigen::Dynamic> > RowVectorRef ;
 
   typedef Eigen::Matrix<Real,Eigen::Dynamic,Eigen::Dynamic,Eigen::RowMajor> RowTensorStorage ;
-  typedef Eigen::Map< RowTensorStorage , Eigen::Unaligned > RowTensorRef ;
+  typedef Eigen::Map< RowTensorStorage , Eigen::Unaligned, Eigen::Stride<Eigen::Dynamic,Eigen::Dynamic> > RowTensorRef ;
 
 private: // typedefs
 
@@ -124,6 +128,13 @@ public: // functions
 
   void synchronize();
 
+  /// Start synchronizing the ghost values, without waiting for the communication to finish.
+  /// The ghost rows must not be accessed until end_synchronize() is called.
+  void begin_synchronize();
+
+  /// Wait for the synchronization started by begin_synchronize()
+  void end_synchronize();
+
   math::VariablesDescriptor& descriptor() const { return *m_descriptor; }
 
   void set_descriptor(math::VariablesDescriptor& descriptor);
@@ -190,18 +201,21 @@ public: // functions
     /// U = c
     Field& operator =(const Real& c)
     {
-      for (Uint i=0; i<size(); ++i)
-        for (Uint j=0; j<row_size(); ++j)
-          array()[i][j] = c;
+      // The values are contiguous in both storage orders
+      Real* values = array().data();
+      const Uint nb_values = array().num_elements();
+      for (Uint i=0; i<nb_values; ++i)
+        values[i] = c;
       return *this;
     }
 
     /// U += c
     Field& operator +=(const Real& c)
     {
-      for (Uint i=0; i<size(); ++i)
-        for (Uint j=0; j<row_size(); ++j)
-          array()[i][j] += c;
+      Real* values = array().data();
+      const Uint nb_values = array().num_elements();
+      for (Uint i=0; i<nb_values; ++i)
+        values[i] += c;
       return *this;
     }
 
@@ -210,18 +224,30 @@ public: // functions
     {
       cf3_assert(size() == U.size());
       cf3_assert(row_size() == U.row_size());
-      for (Uint i=0; i<size(); ++i)
-        for (Uint j=0; j<row_size(); ++j)
-          array()[i][j] += U.array()[i][j];
+      if (is_column_major() == U.is_column_major())
+      {
+        Real* values = array().data();
+        const Real* other_values = U.array().data();
+        const Uint nb_values = array().num_elements();
+        for (Uint i=0; i<nb_values; ++i)
+          values[i] += other_values[i];
+      }
+      else
+      {
+        for (Uint i=0; i<size(); ++i)
+          for (Uint j=0; j<row_size(); ++j)
+            array()[i][j] += U.array()[i][j];
+      }
       return *this;
     }
 
     /// U -= c
     Field& operator -=(const Real& c)
     {
-      for (Uint i=0; i<size(); ++i)
-        for (Uint j=0; j<row_size(); ++j)
-          array()[i][j] -= c;
+      Real* values = array().data();
+      const Uint nb_values = array().num_elements();
+      for (Uint i=0; i<nb_values; ++i)
+        values[i] -= c;
       return *this;
     }
 
@@ -230,18 +256,30 @@ public: // functions
     {
       cf3_assert(size() == U.size());
       cf3_assert(row_size() == U.row_size());
-      for (Uint i=0; i<size(); ++i)
-        for (Uint j=0; j<row_size(); ++j)
-          array()[i][j] -= U.array()[i][j];
+      if (is_column_major() == U.is_column_major())
+      {
+        Real* values = array().data();
+        const Real* other_values = U.array().data();
+        const Uint nb_values = array().num_elements();
+        for (Uint i=0; i<nb_values; ++i)
+          values[i] -= other_values[i];
+      }
+      else
+      {
+        for (Uint i=0; i<size(); ++i)
+          for (Uint j=0; j<row_size(); ++j)
+            array()[i][j] -= U.array()[i][j];
+      }
       return *this;
     }
 
     /// U *= c
     Field& operator *=(const Real& c)
     {
-      for (Uint i=0; i<size(); ++i)
-        for (Uint j=0; j<row_size(); ++j)
-          array()[i][j] *= c;
+      Real* values = array().data();
+      const Uint nb_values = array().num_elements();
+      for (Uint i=0; i<nb_values; ++i)
+        values[i] *= c;
       return *this;
     }
 
@@ -268,9 +306,10 @@ public: // functions
     /// U /= c
     Field& operator /=(const Real& c)
     {
-      for (Uint i=0; i<size(); ++i)
-        for (Uint j=0; j<row_size(); ++j)
-          array()[i][j] /= c;
+      Real* values = array().data();
+      const Uint nb_values = array().num_elements();
+      for (Uint i=0; i<nb_values; ++i)
+        values[i] /= c;
       return *this;
     }
 
@@ -16,7 +16,7 @@
 
 #include "common/List.hpp"
 #include "common/Table.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 
 namespace cf3 {
 namespace mesh {
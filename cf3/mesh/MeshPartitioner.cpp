@@ -17,7 +17,7 @@
 #include "common/PE/Buffer.hpp"
 #include "common/PE/debug.hpp"
 #include "common/StringConversion.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/List.hpp"
 
 #include "common/XML/Protocol.hpp"
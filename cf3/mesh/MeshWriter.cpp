@@ -4,6 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <boost/algorithm/string/replace.hpp>
+
 #include "common/Log.hpp"
 #include "common/Signal.hpp"
 #include "common/OptionURI.hpp"
@@ -33,7 +35,9 @@ using namespace common;
 ////////////////////////////////////////////////////////////////////////////////
 
 MeshWriter::MeshWriter ( const std::string& name  ) :
-  Action ( name )
+  Action ( name ),
+  m_iteration(0u),
+  m_time(0.)
 {
   mark_basic();
 
@@ -124,18 +128,25 @@ void MeshWriter::config_fields()
 ////////////////////////////////////////////////////////////////////////////////
 
 void MeshWriter::config_regions()
+{
+  resolve_regions(m_regions);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MeshWriter::resolve_regions(std::vector<Handle<Region const> >& regions) const
 {
   if (is_null(m_mesh))
     throw SetupError(FromHere(),"Mesh was not configured in mesh-writer ["+uri().string()+"]");
 
   std::vector<URI> region_uris = options()["regions"].value< std::vector<URI> >();
   cf3_assert(region_uris.size());
-  m_regions.clear();
-  m_regions.reserve(region_uris.size());
+  regions.clear();
+  regions.reserve(region_uris.size());
   boost_foreach ( const URI& uri, region_uris)
   {
-    m_regions.push_back(Handle<Region const>(m_mesh->access_component_checked(uri)));
-    if ( is_null(m_regions.back()) )
+    regions.push_back(Handle<Region const>(m_mesh->access_component_checked(uri)));
+    if ( is_null(regions.back()) )
       throw ValueNotFound(FromHere(),"Invalid URI ["+uri.string()+"]");
   }
 }
@@ -162,10 +173,8 @@ void MeshWriter::execute()
   // Configure the regions to write
   config_regions();
 
-  m_filtered_entities.clear();
-  boost_foreach(const Handle<Region const>& region, m_regions)
-    boost_foreach(const Entities& entities, find_components_recursively_with_filter<Entities>(*region,m_entities_filter))
-      m_filtered_entities.push_back(entities.handle<Entities>());
+  config_entities();
+  prepare_entities(m_filtered_entities);
 
   // Call implementation
   write();
@@ -173,6 +182,95 @@ void MeshWriter::execute()
 
 //////////////////////////////////////////////////////////////////////////////
 
+boost::shared_ptr<MeshWriter::Snapshot const> MeshWriter::prepare_write(const std::vector<Handle<Field const> >& fields, const URI& file_path) const
+{
+  if (is_null(m_mesh))
+    throw SetupError(FromHere(),"Mesh was not configured in mesh-writer ["+uri().string()+"]");
+
+  boost::shared_ptr<Snapshot> snapshot(new Snapshot());
+  snapshot->file_path = file_path;
+  snapshot->fields = fields;
+  resolve_regions(snapshot->regions);
+  resolve_entities(snapshot->regions, snapshot->filtered_entities, snapshot->mesh_entities);
+  resolve_zone_names(snapshot->filtered_entities, snapshot->zone_names);
+  snapshot->iteration = m_mesh->metadata().properties().value<Uint>("iter");
+  snapshot->time = m_mesh->metadata().properties().value<Real>("time");
+  prepare_entities(snapshot->filtered_entities);
+  return snapshot;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void MeshWriter::write_snapshot(const Snapshot& snapshot) const
+{
+  write_from_snapshot(snapshot);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void MeshWriter::write_from_snapshot(const Snapshot& snapshot) const
+{
+  throw NotSupported(FromHere(), "Mesh writer ["+uri().string()+"] can not write snapshots");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+boost::shared_ptr<MeshWriter::Snapshot const> MeshWriter::configured_snapshot() const
+{
+  boost::shared_ptr<Snapshot> snapshot(new Snapshot());
+  snapshot->file_path = m_file_path;
+  snapshot->fields = m_fields;
+  snapshot->regions = m_regions;
+  snapshot->filtered_entities = m_filtered_entities;
+  snapshot->mesh_entities = m_mesh_entities;
+  resolve_zone_names(m_filtered_entities, snapshot->zone_names);
+  snapshot->iteration = m_iteration;
+  snapshot->time = m_time;
+  return snapshot;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void MeshWriter::config_entities()
+{
+  resolve_entities(m_regions, m_filtered_entities, m_mesh_entities);
+  m_iteration = m_mesh->metadata().properties().value<Uint>("iter");
+  m_time = m_mesh->metadata().properties().value<Real>("time");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void MeshWriter::resolve_entities(const std::vector<Handle<Region const> >& regions,
+                                  std::vector<Handle<Entities const> >& filtered_entities,
+                                  std::vector<Handle<Entities const> >& mesh_entities) const
+{
+  filtered_entities.clear();
+  boost_foreach(const Handle<Region const>& region, regions)
+    boost_foreach(const Entities& entities, find_components_recursively_with_filter<Entities>(*region,EntitiesFilter(m_entities_filter)))
+      filtered_entities.push_back(entities.handle<Entities>());
+
+  mesh_entities.clear();
+  boost_foreach(const Entities& entities, find_components_recursively<Entities>(m_mesh->topology()))
+    mesh_entities.push_back(entities.handle<Entities>());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void MeshWriter::resolve_zone_names(const std::vector<Handle<Entities const> >& entities, std::vector<std::string>& zone_names) const
+{
+  const std::string topology_path = m_mesh->topology().uri().path()+"/";
+  zone_names.clear();
+  zone_names.reserve(entities.size());
+  boost_foreach(const Handle<Entities const>& entities_h, entities)
+  {
+    std::string zone_name = entities_h->parent()->uri().path();
+    boost::algorithm::replace_first(zone_name, topology_path, "");
+    zone_names.push_back(zone_name);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void MeshWriter::write_from_to(const Mesh& mesh, const URI& file_path)
 {
   options().set("mesh",mesh.handle<Mesh const>());
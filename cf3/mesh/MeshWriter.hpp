@@ -9,7 +9,10 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <boost/shared_ptr.hpp>
+
 #include "common/Action.hpp"
+#include "common/URI.hpp"
 #include "mesh/LibMesh.hpp"
 
 namespace cf3 {
@@ -55,12 +58,64 @@ public: // functions
 
   virtual void write_from_to(const Mesh& mesh, const common::URI& file_path);
 
+  /// Everything needed to write the mesh, resolved in advance by prepare_write
+  struct Snapshot
+  {
+    common::URI                          file_path;          ///< File to write
+    std::vector<Handle<Field const> >    fields;             ///< Fields to write
+    std::vector<Handle<Region const> >   regions;            ///< Selected regions
+    std::vector<Handle<Entities const> > filtered_entities;  ///< Entities selected from the regions
+    std::vector<Handle<Entities const> > mesh_entities;      ///< All entities in the mesh topology
+    std::vector<std::string>             zone_names;         ///< Path of the region holding each filtered entities, relative to the topology
+    Uint                                 iteration;          ///< Iteration from the mesh metadata
+    Real                                 time;               ///< Time from the mesh metadata
+  };
+
+  /// True if write_snapshot may be called from another thread than the one changing the mesh and fields.
+  /// This requires a writer that implements write_from_snapshot, accessing only the snapshot, the mesh data it refers to
+  /// and its own options, and that does no parallel communication.
+  virtual bool supports_background_write() const { return false; }
+
+  /// Resolve the configured regions and entities, using the given fields instead of the "fields" option
+  /// and the given file instead of the "file" option. This does not change the writer, and must be called
+  /// from the thread that changes the component tree.
+  /// The fields must belong to a dictionary of the configured mesh, but may be stored outside of it.
+  boost::shared_ptr<Snapshot const> prepare_write(const std::vector<Handle<Field const> >& fields, const common::URI& file_path) const;
+
+  /// Write a snapshot obtained from prepare_write. No components are looked up in the tree, nothing is logged to CFinfo
+  /// and the writer itself is not changed, so this can run in a background thread for writers that support it, as long as
+  /// the mesh data itself and the options of this writer do not change.
+  void write_snapshot(const Snapshot& snapshot) const;
+
+protected: // functions
+
+  /// Snapshot of the fields, regions and entities resolved by execute, for writers that implement write() through write_from_snapshot
+  boost::shared_ptr<Snapshot const> configured_snapshot() const;
+
 private: // functions
 
   virtual void write() {}
 
-  void config_fields();  ///< configure fields from URI's
-  void config_regions(); ///< configure regions from URI's
+  /// Write the given snapshot, using nothing else from this writer than the mesh and the options.
+  /// Must be implemented by writers that support background writes.
+  virtual void write_from_snapshot(const Snapshot& snapshot) const;
+
+  /// Called with the selected entities before each write, on the thread that changes the component tree.
+  /// Writers that need more components than the snapshot provides must resolve them here.
+  virtual void prepare_entities(const std::vector<Handle<Entities const> >& entities) const {}
+
+  void config_fields();   ///< configure fields from URI's
+  void config_regions();  ///< configure regions from URI's
+  void config_entities(); ///< select entities from the configured regions
+
+  /// Resolve the region URI's, relative to the configured mesh
+  void resolve_regions(std::vector<Handle<Region const> >& regions) const;
+  /// Select entities from the given regions, and collect all entities of the mesh
+  void resolve_entities(const std::vector<Handle<Region const> >& regions,
+                        std::vector<Handle<Entities const> >& filtered_entities,
+                        std::vector<Handle<Entities const> >& mesh_entities) const;
+  /// Path of the region holding each of the given entities, relative to the mesh topology
+  void resolve_zone_names(const std::vector<Handle<Entities const> >& entities, std::vector<std::string>& zone_names) const;
 
 private:
 
@@ -90,6 +145,9 @@ protected:
   std::vector<Handle<Field const> >    m_fields;             ///< Handle to configured fields
   std::vector<Handle<Region const> >   m_regions;            ///< Handle to configured regions
   std::vector<Handle<Entities const> > m_filtered_entities;  ///< Handle to selected entities
+  std::vector<Handle<Entities const> > m_mesh_entities;      ///< Handle to all entities of the mesh topology
+  Uint                                 m_iteration;          ///< Iteration from the mesh metadata
+  Real                                 m_time;               ///< Time from the mesh metadata
   bool                                 m_enable_overlap;     ///< If true, writing of overlap will be enabled
 
 };
@@ -8,6 +8,7 @@
 
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "common/Foreach.hpp"
 #include "common/Log.hpp"
@@ -17,6 +18,7 @@
 #include "common/OptionT.hpp"
 #include "common/OptionArray.hpp"
 #include "common/OptionComponent.hpp"
+#include "common/StringConversion.hpp"
 
 #include "common/PE/Comm.hpp"
 #include "common/PE/debug.hpp"
@@ -49,8 +51,23 @@ cf3::common::ComponentBuilder < Octtree, Component, LibMesh > Octtree_Builder;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+  /// Order elements according to one of the coordinates of their centroid
+  struct CentroidLess
+  {
+    CentroidLess(const std::vector<Real>& centroids, const Uint dim, const Uint direction) : m_centroids(centroids), m_dim(dim), m_direction(direction) {}
+    bool operator()(const Uint a, const Uint b) const { return m_centroids[a*m_dim+m_direction] < m_centroids[b*m_dim+m_direction]; }
+    const std::vector<Real>& m_centroids;
+    const Uint m_dim;
+    const Uint m_direction;
+  };
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 Octtree::Octtree( const std::string& name )
-  : Component(name), m_dim(0), m_N(3), m_D(3), m_octtree_idx(3)
+  : Component(name), m_dim(0), m_N(3), m_D(3), m_max_elems_per_leaf(8u), m_nb_threads(1u)
 {
 
   options().add("mesh", m_mesh)
@@ -68,6 +85,16 @@ Octtree::Octtree( const std::string& name )
       .description("The number of cells in each direction of the comb. "
                         "Takes precedence over \"Number of Elements per Octtree Cell\". ")
       .pretty_name("Number of Cells");
+
+  options().add( "max_elems_per_leaf", m_max_elems_per_leaf)
+      .description("Maximum number of elements in a leaf of the bounding volume hierarchy used to locate elements")
+      .pretty_name("Maximum Elements per Leaf")
+      .link_to(&m_max_elems_per_leaf);
+
+  options().add( "nb_threads", m_nb_threads)
+      .description("Number of threads used to locate a batch of points")
+      .pretty_name("Number of Threads")
+      .link_to(&m_nb_threads);
 }
 
 
@@ -122,11 +149,17 @@ void Octtree::create_octtree()
   // initialize the octtree
   m_octtree.resize(boost::extents[std::max(Uint(1),m_N[XX])][std::max(Uint(1),m_N[YY])][std::max(Uint(1),m_N[ZZ])]);
 
+  m_tree_elements.clear();
+  m_tree_elements.reserve(nb_elems);
+  m_element_boxes.clear();
+  m_element_boxes.reserve(2*m_dim*nb_elems);
+  std::vector<Real> centroids;
+  centroids.reserve(m_dim*nb_elems);
+
   RealVector centroid(m_dim);
   std::vector<Uint> octtree_idx(3);
   boost_foreach (Elements& elements, find_components_recursively_with_filter<Elements>(*m_mesh,IsElementsVolume()))
   {
-    Uint nb_nodes_per_element = elements.geometry_space().connectivity().row_size();
     RealMatrix coordinates;
     elements.geometry_space().allocate_coordinates(coordinates);
 
@@ -140,7 +173,36 @@ void Octtree::create_octtree()
         octtree_idx[d]=std::min((Uint) std::floor( (centroid[d] - m_bounding_box.min()[d])/m_D[d]), m_N[d]-1 );
       }
       m_octtree[octtree_idx[XX]][octtree_idx[YY]][octtree_idx[ZZ]].push_back(Entity(elements,elem_idx));
+
+      m_tree_elements.push_back(Entity(elements,elem_idx));
+      for (Uint d=0; d<m_dim; ++d)
+        m_element_boxes.push_back(coordinates.col(d).minCoeff());
+      for (Uint d=0; d<m_dim; ++d)
+        m_element_boxes.push_back(coordinates.col(d).maxCoeff());
+      for (Uint d=0; d<m_dim; ++d)
+        centroids.push_back(centroid[d]);
+    }
+  }
+
+  m_tree_nodes.clear();
+  m_tree_boxes.clear();
+  if (!m_tree_elements.empty())
+  {
+    // The tree is built on element indices, after which the elements and their boxes are put in tree order
+    std::vector<Uint> order(m_tree_elements.size());
+    for (Uint i=0; i<order.size(); ++i)
+      order[i] = i;
+    build_tree(0, m_tree_elements.size(), order, centroids);
+
+    std::vector<Entity> sorted_elements(m_tree_elements.size());
+    std::vector<Real> sorted_boxes(m_element_boxes.size());
+    for (Uint i=0; i<order.size(); ++i)
+    {
+      sorted_elements[i] = m_tree_elements[order[i]];
+      std::copy(m_element_boxes.begin() + 2*m_dim*order[i], m_element_boxes.begin() + 2*m_dim*(order[i]+1), sorted_boxes.begin() + 2*m_dim*i);
     }
+    m_tree_elements.swap(sorted_elements);
+    m_element_boxes.swap(sorted_boxes);
   }
 
 
@@ -182,6 +244,217 @@ void Octtree::create_octtree()
 }
 
 
+//////////////////////////////////////////////////////////////////////////////
+
+Uint Octtree::build_tree(const Uint begin, const Uint end, std::vector<Uint>& order, const std::vector<Real>& centroids)
+{
+  const Uint node_idx = m_tree_nodes.size();
+  TreeNode node;
+  node.begin = begin;
+  node.end = end;
+  node.left = math::Consts::uint_max();
+  node.right = math::Consts::uint_max();
+  m_tree_nodes.push_back(node);
+  m_tree_boxes.resize(m_tree_boxes.size() + 2*m_dim);
+
+  Real* box = &m_tree_boxes[2*m_dim*node_idx];
+  if (end - begin <= std::max(m_max_elems_per_leaf, 1u))
+  {
+    // Leaf: the box encloses the element boxes
+    for (Uint d=0; d<m_dim; ++d)
+    {
+      box[d] = real_max();
+      box[m_dim+d] = -real_max();
+    }
+    for (Uint i=begin; i<end; ++i)
+    {
+      const Real* elem_box = &m_element_boxes[2*m_dim*order[i]];
+      for (Uint d=0; d<m_dim; ++d)
+      {
+        box[d] = std::min(box[d], elem_box[d]);
+        box[m_dim+d] = std::max(box[m_dim+d], elem_box[m_dim+d]);
+      }
+    }
+    return node_idx;
+  }
+
+  // Split at the median centroid, along the direction in which the centroids are spread the most
+  Uint split_direction = 0;
+  Real largest_extent = -1.;
+  for (Uint d=0; d<m_dim; ++d)
+  {
+    Real min_centroid = real_max();
+    Real max_centroid = -real_max();
+    for (Uint i=begin; i<end; ++i)
+    {
+      min_centroid = std::min(min_centroid, centroids[order[i]*m_dim+d]);
+      max_centroid = std::max(max_centroid, centroids[order[i]*m_dim+d]);
+    }
+    if (max_centroid - min_centroid > largest_extent)
+    {
+      largest_extent = max_centroid - min_centroid;
+      split_direction = d;
+    }
+  }
+
+  const Uint mid = begin + (end - begin) / 2;
+  std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, detail::CentroidLess(centroids, m_dim, split_direction));
+
+  const Uint left = build_tree(begin, mid, order, centroids);
+  const Uint right = build_tree(mid, end, order, centroids);
+  m_tree_nodes[node_idx].left = left;
+  m_tree_nodes[node_idx].right = right;
+
+  // The box of a node encloses the boxes of its children
+  box = &m_tree_boxes[2*m_dim*node_idx];
+  const Real* left_box = &m_tree_boxes[2*m_dim*left];
+  const Real* right_box = &m_tree_boxes[2*m_dim*right];
+  for (Uint d=0; d<m_dim; ++d)
+  {
+    box[d] = std::min(left_box[d], right_box[d]);
+    box[m_dim+d] = std::max(left_box[m_dim+d], right_box[m_dim+d]);
+  }
+  return node_idx;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+bool Octtree::find_in_tree(const RealVector& coordinate, Entity& element, std::vector<Uint>& stack) const
+{
+  static const Real tolerance = 100*math::Consts::eps();
+
+  if (m_tree_nodes.empty())
+    return false;
+
+  stack.clear();
+  stack.push_back(0);
+  while (!stack.empty())
+  {
+    const Uint node_idx = stack.back();
+    stack.pop_back();
+    const TreeNode& node = m_tree_nodes[node_idx];
+    const Real* box = &m_tree_boxes[2*m_dim*node_idx];
+
+    bool inside = true;
+    for (Uint d=0; d<m_dim && inside; ++d)
+      inside = coordinate[d] >= box[d] - tolerance && coordinate[d] <= box[m_dim+d] + tolerance;
+    if (!inside)
+      continue;
+
+    if (node.left != math::Consts::uint_max())
+    {
+      stack.push_back(node.right);
+      stack.push_back(node.left);
+      continue;
+    }
+
+    for (Uint i=node.begin; i<node.end; ++i)
+    {
+      const Real* elem_box = &m_element_boxes[2*m_dim*i];
+      bool in_box = true;
+      for (Uint d=0; d<m_dim && in_box; ++d)
+        in_box = coordinate[d] >= elem_box[d] - tolerance && coordinate[d] <= elem_box[m_dim+d] + tolerance;
+      if (!in_box)
+        continue;
+
+      const Entity& candidate = m_tree_elements[i];
+      if (candidate.element_type().is_coord_in_element(coordinate,candidate.get_coordinates()))
+      {
+        element = candidate;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+Uint Octtree::find_elements(const boost::multi_array<Real,2>& points, std::vector<Entity>& elements, boost::multi_array<Real,2>& mapped_coords)
+{
+  if ( !is_created() )
+    create_octtree();
+
+  if (m_nb_threads == 0)
+    throw BadValue(FromHere(), "Option nb_threads for " + uri().path() + " must be at least 1");
+
+  const Uint nb_points = points.size();
+  elements.assign(nb_points, Entity());
+  mapped_coords.resize(boost::extents[nb_points][m_dim]);
+
+  const Uint nb_threads = std::max(Uint(1), std::min(m_nb_threads, nb_points));
+  std::vector<std::string> errors(nb_threads);
+  if (nb_threads == 1)
+  {
+    find_elements_range(points, elements, mapped_coords, 0, nb_points, errors[0]);
+  }
+  else
+  {
+    // Each thread handles a contiguous range of points
+    boost::thread_group threads;
+    for (Uint i=0; i<nb_threads; ++i)
+    {
+      const Uint begin = (nb_points * i) / nb_threads;
+      const Uint end = (nb_points * (i+1)) / nb_threads;
+      threads.create_thread(boost::bind(&Octtree::find_elements_range, this, boost::cref(points), boost::ref(elements), boost::ref(mapped_coords), begin, end, boost::ref(errors[i])));
+    }
+    threads.join_all();
+  }
+
+  for (Uint i=0; i<nb_threads; ++i)
+  {
+    if (!errors[i].empty())
+      throw ParallelError(FromHere(), "Error in thread " + to_str(i) + " while locating points in " + uri().path() + ": " + errors[i]);
+  }
+
+  Uint nb_found = 0;
+  boost_foreach(const Entity& element, elements)
+  {
+    if (is_not_null(element.comp))
+      ++nb_found;
+  }
+  return nb_found;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Octtree::find_elements_range(const boost::multi_array<Real,2>& points, std::vector<Entity>& elements, boost::multi_array<Real,2>& mapped_coords, const Uint begin, const Uint end, std::string& error) const
+{
+  try
+  {
+    const Uint points_dim = points.shape()[1];
+    cf3_assert(points_dim <= m_dim);
+    RealVector coord(m_dim);
+    coord.setZero();
+    RealVector mapped_coord(m_dim);
+    std::vector<Uint> stack;
+    for (Uint i=begin; i<end; ++i)
+    {
+      for (Uint d=0; d<points_dim; ++d)
+        coord[d] = points[i][d];
+
+      Entity& element = elements[i];
+      if (find_in_tree(coord, element, stack))
+      {
+        const ElementType& etype = element.element_type();
+        mapped_coord.resize(etype.dimensionality());
+        etype.compute_mapped_coordinate(coord, element.get_coordinates(), mapped_coord);
+        for (Uint d=0; d<mapped_coord.size(); ++d)
+          mapped_coords[i][d] = mapped_coord[d];
+      }
+      else
+      {
+        for (Uint d=0; d<m_dim; ++d)
+          mapped_coords[i][d] = real_max();
+      }
+    }
+  }
+  catch(std::exception& e)
+  {
+    error = e.what();
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 void Octtree::find_cell_ranks( const boost::multi_array<Real,2>& coordinates, std::vector<Uint>& ranks )
@@ -418,53 +691,22 @@ bool Octtree::find_element(const RealVector& target_coord, Entity& element)
 
   cf3_assert(target_coord.size() <= (long)m_dim);
   RealVector t_coord(m_dim);
+  t_coord.setZero();
   for (Uint d=0; d<target_coord.size(); ++d)
     t_coord[d] = target_coord[d];
 
-  for (Uint t=0; t<target_coord.size(); ++t)
+  std::vector<Uint> stack;
+  if (find_in_tree(t_coord, element, stack))
+    return true;
 
-  if (find_octtree_cell(t_coord,m_octtree_idx))
-  {
-    m_elements_pool.clear();
-    Uint pool_size = 0;
-    Uint rings=0;
-    for ( ; pool_size==0 ; ++rings)
-    {
-      pool_size=m_elements_pool.size();
-      gather_elements_around_idx(m_octtree_idx,rings,m_elements_pool);
-      boost_foreach(const Entity& pool_elem, boost::make_iterator_range(m_elements_pool.begin()+pool_size,m_elements_pool.end()))
-      {
-        cf3_assert(is_not_null(pool_elem.comp));
-        const RealMatrix elem_coordinates = pool_elem.get_coordinates();
-        if (pool_elem.element_type().is_coord_in_element(t_coord,elem_coordinates))
-        {
-          element = pool_elem;
-          return true;
-        }
-      }
-    }
-    // if arrived here, keep searching
-    // it means no element has been found. The search is enlarged with one more ring, for possible misses.
-    gather_elements_around_idx(m_octtree_idx,rings,m_elements_pool);
-    boost_foreach(const Entity& pool_elem, boost::make_iterator_range(m_elements_pool.begin()+pool_size,m_elements_pool.end()))
-    {
-      cf3_assert(is_not_null(pool_elem.comp));
-      const RealMatrix elem_coordinates = pool_elem.get_coordinates();
-      if (pool_elem.element_type().is_coord_in_element(t_coord,elem_coordinates))
-      {
-        element = pool_elem;
-        return true;
-      }
-    }
-  }
-  // if arrived here, it means no element has been found in the octtree cell. Give up.
+  // if arrived here, it means no element contains the coordinate. Give up.
   element = Entity();
   CFdebug << "coord";
   for(Uint i = 0; i != m_dim; ++i)
   {
     CFdebug << " " << common::to_str(t_coord[i]);
   }
-  CFdebug << " has not been found in the octtree cell" << CFendl;
+  CFdebug << " has not been found in the octtree" << CFendl;
   return false;
 }
 
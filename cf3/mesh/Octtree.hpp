@@ -26,7 +26,10 @@ namespace mesh {
 
 //////////////////////////////////////////////////////////////////////////////
 
-/// This class defines neutral mesh format reader
+/// Spatial search structure for the volume elements of a mesh.
+/// Elements are located using a bounding volume hierarchy over the element bounding boxes,
+/// which adapts to the local element size. A uniform grid of cells, indexed by the element
+/// centroids, is kept for the ring-based neighbour searches used by the stencil computers.
 /// @author Willem Deconinck
 class Mesh_API Octtree : public common::Component
 {
@@ -69,14 +72,46 @@ public: // functions
   /// @note subsequent calls with increasing value for ring starting from 0, will assemble everything within the last passed ring value.
   void gather_elements_around_idx(const std::vector<Uint>& octtree_idx, const Uint ring, std::vector<Entity>& element_pool);
 
+  /// @brief Find the elements containing a batch of points. The points are divided over "nb_threads" threads.
+  /// @param points        [in]  coordinates of the points, one row per point
+  /// @param elements      [out] element containing each point, or a null Entity if the point was not found
+  /// @param mapped_coords [out] mapped coordinates of each point in its element, one row per point
+  /// @return the number of points that were found
+  Uint find_elements(const boost::multi_array<Real,2>& points, std::vector<Entity>& elements, boost::multi_array<Real,2>& mapped_coords);
+
   void find_cell_ranks( const boost::multi_array<Real,2>& coordinates, std::vector<Uint>& ranks );
 
   bool is_created() const { return m_octtree.num_elements()!=0; }
 
   const Uint dimension() { return m_dim; }
 
+  /// Largest ring index passed to gather_elements_around_idx that can still contain cells
+  Uint max_ring() const { return *std::max_element(m_N.begin(), m_N.end()); }
+
+private: // functions
+
+  /// Recursively build the bounding volume hierarchy for the elements in [begin, end), returning the node index
+  Uint build_tree(const Uint begin, const Uint end, std::vector<Uint>& order, const std::vector<Real>& centroids);
+
+  /// Find the element containing the given coordinate using the bounding volume hierarchy
+  bool find_in_tree(const RealVector& coordinate, Entity& element, std::vector<Uint>& stack) const;
+
+  /// Find the elements for the points in [begin, end). Used as thread function for find_elements.
+  void find_elements_range(const boost::multi_array<Real,2>& points, std::vector<Entity>& elements, boost::multi_array<Real,2>& mapped_coords, const Uint begin, const Uint end, std::string& error) const;
+
 private: // data
 
+  /// Node of the bounding volume hierarchy
+  struct TreeNode
+  {
+    /// Range of the node elements in m_tree_elements
+    Uint begin;
+    Uint end;
+    /// Child nodes, or uint_max for a leaf
+    Uint left;
+    Uint right;
+  };
+
   ArrayT m_octtree;
 
   Uint m_dim;
@@ -85,11 +120,25 @@ private: // data
 
   Handle<Mesh> m_mesh;
 
-  std::vector<Uint> m_octtree_idx;
+  math::BoundingBox m_bounding_box;
 
-  std::vector<Entity> m_elements_pool;
+  /// Nodes of the bounding volume hierarchy, the root is the first node
+  std::vector<TreeNode> m_tree_nodes;
 
-  math::BoundingBox m_bounding_box;
+  /// Bounding box of each tree node, stored as the minimum followed by the maximum coordinates
+  std::vector<Real> m_tree_boxes;
+
+  /// Elements, ordered so each tree node holds a contiguous range
+  std::vector<Entity> m_tree_elements;
+
+  /// Bounding box of each element in m_tree_elements, stored like m_tree_boxes
+  std::vector<Real> m_element_boxes;
+
+  /// Maximum number of elements in a leaf of the tree
+  Uint m_max_elems_per_leaf;
+
+  /// Number of threads used by find_elements
+  Uint m_nb_threads;
 
 }; // end Octtree
 
@@ -16,7 +16,7 @@
 #include "common/Table.hpp"
 #include "common/Table.hpp"
 #include "common/List.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 #include "mesh/Dictionary.hpp"
 #include "mesh/Mesh.hpp"
 #include "mesh/Cells.hpp"
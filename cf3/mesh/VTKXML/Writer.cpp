@@ -221,9 +221,16 @@ std::vector<std::string> Writer::get_extensions()
 /////////////////////////////////////////////////////////////////////////////
 
 void Writer::write()
+{
+  write_from_snapshot(*configured_snapshot());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::write_from_snapshot(const Snapshot& snapshot) const
 {
   // Path for the file written by the current node
-  URI my_path(m_file_path.path());
+  URI my_path(snapshot.file_path.path());
   const URI my_dir = my_path.base_path();
   const std::string basename = my_path.base_name();
   my_path = my_dir / (basename + "_P" + to_str(PE::Comm::instance().rank()) + ".vtu");
@@ -251,11 +258,21 @@ void Writer::write()
     (GeoShape::HEXA, 12)
     (GeoShape::PRISM, 13);
 
+  // The elements were collected in the snapshot, so the component tree is not searched here
+  std::vector< Handle<Elements const> > mesh_elements;
+  boost_foreach(const Handle<Entities const>& entities, snapshot.mesh_entities)
+  {
+    const Handle<Elements const> elements(entities);
+    if(is_not_null(elements))
+      mesh_elements.push_back(elements);
+  }
+
   // Count number of elements
   Uint nb_elems = 0;
   Uint nb_conn_nodes = 0;
-  boost_foreach(const Elements& elements, find_components_recursively<Elements>(m_mesh->topology()) )
+  boost_foreach(const Handle<Elements const>& elements_h, mesh_elements)
   {
+    const Elements& elements = *elements_h;
     if(elements.element_type().dimensionality() == dim && elements.element_type().order() == 1 && etype_map.count(elements.element_type().shape()))
     {
       const Uint n_elems = elements.size();
@@ -296,8 +313,9 @@ void Writer::write()
   connectivity.set_attribute("format", "appended");
   connectivity.set_attribute("offset", to_str(appended_data.offset()));
   appended_data.start_array(nb_conn_nodes, 4);
-  boost_foreach(const Elements& elements, find_components_recursively<Elements>(m_mesh->topology()) )
+  boost_foreach(const Handle<Elements const>& elements_h, mesh_elements)
   {
+    const Elements& elements = *elements_h;
     if(elements.element_type().dimensionality() == dim && elements.element_type().order() == 1 && etype_map.count(elements.element_type().shape()))
     {
       const Uint n_elems = elements.size();
@@ -321,8 +339,9 @@ void Writer::write()
   offsets.set_attribute("offset", to_str(appended_data.offset()));
   boost::uint32_t offset = 0;
   appended_data.start_array(nb_elems, 4);
-  boost_foreach(const Elements& elements, find_components_recursively<Elements>(m_mesh->topology()) )
+  boost_foreach(const Handle<Elements const>& elements_h, mesh_elements)
   {
+    const Elements& elements = *elements_h;
     if(elements.element_type().dimensionality() == dim && elements.element_type().order() == 1 && etype_map.count(elements.element_type().shape()))
     {
       const Uint n_elems = elements.size();
@@ -342,8 +361,9 @@ void Writer::write()
   types.set_attribute("format", "appended");
   types.set_attribute("offset", to_str(appended_data.offset()));
   appended_data.start_array(nb_elems, 1);
-  boost_foreach(const Elements& elements, find_components_recursively<Elements>(m_mesh->topology()) )
+  boost_foreach(const Handle<Elements const>& elements_h, mesh_elements)
   {
+    const Elements& elements = *elements_h;
     if(elements.element_type().dimensionality() == dim && elements.element_type().order() == 1 && etype_map.count(elements.element_type().shape()))
     {
       const Uint n_elems = elements.size();
@@ -362,12 +382,13 @@ void Writer::write()
 
   std::stringstream data_header( std::ios_base::in | std::ios_base::out | std::ios_base::binary );
 
-  std::set<std::string> added_fields;
-  boost_foreach(Handle<Field const> field_ptr, m_fields)
+  // Fields are compared by address, since their URI would require a walk up the component tree
+  std::set<const Field*> added_fields;
+  boost_foreach(Handle<Field const> field_ptr, snapshot.fields)
   {
     const Field& field = *field_ptr;
 
-    if(!added_fields.insert(field.uri().string()).second)
+    if(!added_fields.insert(&field).second)
       continue;
 
     for(Uint var_idx = 0; var_idx != field.nb_vars(); ++var_idx)
@@ -412,8 +433,9 @@ void Writer::write()
       }
       else
       {
-        boost_foreach(const Elements& elements, find_components_recursively<Elements>(m_mesh->topology()) )
+        boost_foreach(const Handle<Elements const>& elements_h, mesh_elements)
         {
+          const Elements& elements = *elements_h;
           if(elements.element_type().dimensionality() == dim && elements.element_type().order() == 1 && etype_map.count(elements.element_type().shape()))
           {
             const Connectivity& field_connectivity = field.dict().space(elements).connectivity();
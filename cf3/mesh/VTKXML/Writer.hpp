@@ -45,6 +45,13 @@ public: // functions
   virtual std::string get_format() { return "VTKXML"; }
 
   virtual std::vector<std::string> get_extensions();
+
+  /// Only the configured fields are written, without communication or logging
+  virtual bool supports_background_write() const { return true; }
+
+private:
+  /// Writes the snapshot, without changing the writer or looking up components in the tree
+  virtual void write_from_snapshot(const Snapshot& snapshot) const;
 }; // end Writer
 
 
@@ -6,8 +6,9 @@
 
 #include <set>
 
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
-#include <boost/functional/hash.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "common/Log.hpp"
 #include "common/Builder.hpp"
@@ -31,8 +32,7 @@
 #include "mesh/Region.hpp"
 #include "mesh/MeshElements.hpp"
 #include "mesh/FaceCellConnectivity.hpp"
-#include "mesh/NodeElementConnectivity.hpp"
-#include "mesh/Node2FaceCellConnectivity.hpp"
+#include "mesh/FaceNodeHash.hpp"
 #include "mesh/Cells.hpp"
 #include "mesh/Mesh.hpp"
 #include "mesh/Connectivity.hpp"
@@ -51,21 +51,66 @@ namespace actions {
   using namespace common;
   using namespace math::Functions;
 
-struct FaceCompare
+namespace detail {
+
+/// Fills the cell to face connectivity for a range of faces. Every face writes to
+/// its own entries in the connectivity of its neighbour cells, so different
+/// ranges of faces can be processed concurrently.
+struct CellFaceFiller
 {
-  bool operator()(const Face2Cell& face1, const Face2Cell& face2) const
+  CellFaceFiller(const Entities& face_elements,
+                 const FaceCellConnectivity& f2c,
+                 const std::map<const Entities*, ElementConnectivity*>& cell2face) :
+    m_face_elements(face_elements),
+    m_f2c(f2c),
+    m_cell2face(cell2face)
+  {
+  }
+
+  void operator()(const Uint begin, const Uint end) const
+  {
+    const ElementConnectivity& connectivity = m_f2c.connectivity();
+    const common::List<bool>&  is_bdry      = m_f2c.is_bdry_face();
+    const common::Table<Uint>& face_nb      = m_f2c.face_number();
+    for (Uint idx=begin; idx!=end; ++idx)
+    {
+      set_face(connectivity[idx][LEFT], face_nb[idx][LEFT], idx);
+      if (is_bdry[idx] == false)
+        set_face(connectivity[idx][RIGHT], face_nb[idx][RIGHT], idx);
+    }
+  }
+
+  /// Variant for use in a thread, storing the error message if an exception occurs
+  void run_threaded(const Uint begin, const Uint end, std::string& error) const
+  {
+    try
+    {
+      (*this)(begin, end);
+    }
+    catch(std::exception& e)
+    {
+      error = e.what();
+    }
+  }
+
+private:
+  void set_face(const Entity& cell, const Uint face_nb_in_cell, const Uint face_idx) const
   {
-    std::size_t seed1=0;
-    std::size_t seed2=0;
-
-    boost::hash_combine(seed1,face1.comp->uri().string());
-    boost::hash_combine(seed2,face2.comp->uri().string());
-    boost::hash_combine(seed1,face1.idx);
-    boost::hash_combine(seed2,face2.idx);
-    return seed1 < seed2;
+    std::map<const Entities*, ElementConnectivity*>::const_iterator c2f_it = m_cell2face.find(cell.comp);
+    cf3_assert(c2f_it != m_cell2face.end());
+    ElementConnectivity& c2f = *c2f_it->second;
+    cf3_assert(cell.idx < c2f.size());
+    cf3_assert(face_nb_in_cell < c2f[cell.idx].size());
+    c2f[cell.idx][face_nb_in_cell] = Entity(m_face_elements,face_idx);
   }
+
+  const Entities& m_face_elements;
+  const FaceCellConnectivity& m_f2c;
+  const std::map<const Entities*, ElementConnectivity*>& m_cell2face;
 };
 
+} // detail
+
 ////////////////////////////////////////////////////////////////////////////////
 
 common::ComponentBuilder < BuildFaces, MeshTransformer, mesh::actions::LibActions> BuildFaces_Builder;
@@ -74,7 +119,8 @@ common::ComponentBuilder < BuildFaces, MeshTransformer, mesh::actions::LibAction
 
 BuildFaces::BuildFaces( const std::string& name )
 : MeshTransformer(name),
-  m_store_cell2face(false)
+  m_store_cell2face(false),
+  m_nb_threads(1u)
 {
 
   properties()["brief"] = std::string("Print information of the mesh");
@@ -90,6 +136,11 @@ BuildFaces::BuildFaces( const std::string& name )
       .pretty_name("Store Cell to Face")
       .mark_basic()
       .link_to(&m_store_cell2face);
+
+  options().add("nb_threads", m_nb_threads)
+      .pretty_name("Number of Threads")
+      .description("Number of threads used to build the cell to face connectivity")
+      .link_to(&m_nb_threads);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -266,21 +317,38 @@ void BuildFaces::build_face_elements(Region& region, FaceCellConnectivity& face_
 {
   Mesh& mesh = *m_mesh;
   std::set<std::string> face_types;
-  std::map<std::string,boost::shared_ptr< ElementConnectivity::Buffer > > f2c_buffer_map;
-  std::map<std::string,boost::shared_ptr< common::Table<Uint>::Buffer > > fnb_buffer_map;
-  std::map<std::string,boost::shared_ptr< common::List<bool>::Buffer > > bdry_buffer_map;
-  std::map<std::string,boost::shared_ptr< common::Table<Uint>::Buffer > > cell_rotation_buffer_map;
-  std::map<std::string,boost::shared_ptr< common::Table<bool>::Buffer > > cell_orientation_buffer_map;
-
-  Handle< Component > elem_comp;
-  Uint elem_idx;
 
   common::Table<Uint>& face_number = *Handle< common::Table<Uint> >(face_to_cell.get_child("face_number"));
 
+  // The type of a face only depends on its first cell and its face number in that cell.
+  // For every cell component, store the index in face_types of each face number,
+  // so that the face type names don't need to be built for every face.
+  const Uint unused_face = math::Consts::uint_max();
+  typedef std::map<const Entities*, std::vector<Uint> > FaceTypeIdxMap;
+  FaceTypeIdxMap face_type_idx;
+  const Entities* last_cells = NULL;
+  std::vector<Uint>* last_face_type_idx = NULL;
   for (Uint idx=0; idx<face_to_cell.size(); ++idx)
   {
-    Face2Cell face(face_to_cell,idx);
-    face_types.insert( face.element_type().derived_type_name()  );
+    const Entity element = face_to_cell.connectivity()[idx][0];
+    if ( is_null(element.comp) )
+      continue; // reported below
+    if (element.comp != last_cells)
+    {
+      last_cells = element.comp;
+      last_face_type_idx = &face_type_idx[last_cells];
+      if (last_face_type_idx->empty())
+        last_face_type_idx->assign(element.element_type().nb_faces(), unused_face);
+    }
+    (*last_face_type_idx)[face_number[idx][0]] = 0;
+  }
+  boost_foreach(FaceTypeIdxMap::value_type& cells_face_types, face_type_idx)
+  {
+    for (Uint face_nb=0; face_nb<cells_face_types.second.size(); ++face_nb)
+    {
+      if (cells_face_types.second[face_nb] != unused_face)
+        face_types.insert( cells_face_types.first->element_type().face_type(face_nb).derived_type_name() );
+    }
   }
 
   if (PE::Comm::instance().is_active())
@@ -311,8 +379,31 @@ void BuildFaces::build_face_elements(Region& region, FaceCellConnectivity& face_
     cf3_assert_desc("tree will not be synchrone!!!",pass);
     // end for debug
   }
-  boost_foreach( const std::string& face_type , face_types)
+
+  // Buffers are indexed by the position of the face type in the sorted face_types
+  const std::vector<std::string> face_type_names(face_types.begin(), face_types.end());
+  boost_foreach(FaceTypeIdxMap::value_type& cells_face_types, face_type_idx)
   {
+    for (Uint face_nb=0; face_nb<cells_face_types.second.size(); ++face_nb)
+    {
+      if (cells_face_types.second[face_nb] != unused_face)
+      {
+        const std::string face_type = cells_face_types.first->element_type().face_type(face_nb).derived_type_name();
+        cells_face_types.second[face_nb] = std::lower_bound(face_type_names.begin(), face_type_names.end(), face_type) - face_type_names.begin();
+      }
+    }
+  }
+
+  const Uint nb_face_types = face_type_names.size();
+  std::vector< boost::shared_ptr< ElementConnectivity::Buffer > > f2c_buffers(nb_face_types);
+  std::vector< boost::shared_ptr< common::Table<Uint>::Buffer > > fnb_buffers(nb_face_types);
+  std::vector< boost::shared_ptr< common::List<bool>::Buffer > > bdry_buffers(nb_face_types);
+  std::vector< boost::shared_ptr< common::Table<Uint>::Buffer > > cell_rotation_buffers(nb_face_types);
+  std::vector< boost::shared_ptr< common::Table<bool>::Buffer > > cell_orientation_buffers(nb_face_types);
+
+  for (Uint t=0; t<nb_face_types; ++t)
+  {
+    const std::string& face_type = face_type_names[t];
     const std::string shape_name = build_component_abstract_type<ElementType>(face_type,"tmp")->shape_name();
     CellFaces& faces = *region.create_component<CellFaces>(shape_name);
     //CFdebug << PERank << "  creating " << faces.uri().path() << CFendl;
@@ -330,55 +421,61 @@ void BuildFaces::build_face_elements(Region& region, FaceCellConnectivity& face_
     raw_table.set_row_size(is_inner?2:1);
     boost_foreach(Handle< Component > cells, face_to_cell.used())
       f2c.add_used(*cells);
-    f2c_buffer_map[face_type] = raw_table.create_buffer_ptr();
-    fnb_buffer_map[face_type] = Handle< common::Table<Uint> >(f2c.get_child("face_number"))->create_buffer_ptr();
-    bdry_buffer_map[face_type] = Handle< common::List<bool> >(f2c.get_child("is_bdry_face"))->create_buffer_ptr();
-    cell_rotation_buffer_map[face_type] = Handle< common::Table<Uint> >(f2c.get_child("cell_rotation"))->create_buffer_ptr();
-    cell_orientation_buffer_map[face_type] = Handle< common::Table<bool> >(f2c.get_child("cell_orientation"))->create_buffer_ptr();
+    f2c_buffers[t] = raw_table.create_buffer_ptr();
+    fnb_buffers[t] = Handle< common::Table<Uint> >(f2c.get_child("face_number"))->create_buffer_ptr();
+    bdry_buffers[t] = Handle< common::List<bool> >(f2c.get_child("is_bdry_face"))->create_buffer_ptr();
+    cell_rotation_buffers[t] = Handle< common::Table<Uint> >(f2c.get_child("cell_rotation"))->create_buffer_ptr();
+    cell_orientation_buffers[t] = Handle< common::Table<bool> >(f2c.get_child("cell_orientation"))->create_buffer_ptr();
   }
 
+  std::vector<Entity> bdry_row(1);
+  last_cells = NULL;
   for (Uint f=0; f<face_to_cell.size(); ++f)
   {
     Entity element = face_to_cell.connectivity()[f][0];
     if ( is_null(element.comp) )
       throw InvalidStructure(FromHere(),"Face matching messed up in region "+region.uri().string());
-    const Uint face_nb = face_number[f][0];
-    const std::string face_type = element.element_type().face_type(face_nb).derived_type_name();
+    if (element.comp != last_cells)
+    {
+      last_cells = element.comp;
+      last_face_type_idx = &face_type_idx[last_cells];
+    }
+    const Uint t = (*last_face_type_idx)[face_number[f][0]];
 
     if (is_inner)
     {
       if (face_to_cell.is_bdry_face()[f] == false)
       {
-        f2c_buffer_map[face_type]->add_row(face_to_cell.connectivity()[f]);
-        fnb_buffer_map[face_type]->add_row(face_number[f]);
-        bdry_buffer_map[face_type]->add_row(face_to_cell.is_bdry_face()[f]);
-        cell_rotation_buffer_map[face_type]->add_row(face_to_cell.cell_rotation()[f]);
-        cell_orientation_buffer_map[face_type]->add_row(face_to_cell.cell_orientation()[f]);
+        f2c_buffers[t]->add_row(face_to_cell.connectivity()[f]);
+        fnb_buffers[t]->add_row(face_number[f]);
+        bdry_buffers[t]->add_row(face_to_cell.is_bdry_face()[f]);
+        cell_rotation_buffers[t]->add_row(face_to_cell.cell_rotation()[f]);
+        cell_orientation_buffers[t]->add_row(face_to_cell.cell_orientation()[f]);
       }
     }
     else
     {
       if (face_to_cell.is_bdry_face()[f] == true)
       {
-        std::vector<Entity> dummy(1,face_to_cell.connectivity()[f][0]);
-        f2c_buffer_map[face_type]->add_row(dummy);
-        fnb_buffer_map[face_type]->add_row(face_number[f]);
-        bdry_buffer_map[face_type]->add_row(face_to_cell.is_bdry_face()[f]);
-        cell_rotation_buffer_map[face_type]->add_row(face_to_cell.cell_rotation()[f]);
-        cell_orientation_buffer_map[face_type]->add_row(face_to_cell.cell_orientation()[f]);
+        bdry_row[0] = face_to_cell.connectivity()[f][0];
+        f2c_buffers[t]->add_row(bdry_row);
+        fnb_buffers[t]->add_row(face_number[f]);
+        bdry_buffers[t]->add_row(face_to_cell.is_bdry_face()[f]);
+        cell_rotation_buffers[t]->add_row(face_to_cell.cell_rotation()[f]);
+        cell_orientation_buffers[t]->add_row(face_to_cell.cell_orientation()[f]);
       }
     }
   }
 
-  boost_foreach( const std::string& face_type , face_types)
+  for (Uint t=0; t<nb_face_types; ++t)
   {
-    f2c_buffer_map[face_type]->flush();
-    fnb_buffer_map[face_type]->flush();
-    bdry_buffer_map[face_type]->flush();
-    cell_rotation_buffer_map[face_type]->flush();
-    cell_orientation_buffer_map[face_type]->flush();
-
+    f2c_buffers[t]->flush();
+    fnb_buffers[t]->flush();
+    bdry_buffers[t]->flush();
+    cell_rotation_buffers[t]->flush();
+    cell_orientation_buffers[t]->flush();
 
+    const std::string& face_type = face_type_names[t];
     const std::string shape_name = build_component_abstract_type<ElementType>(face_type,"tmp")->shape_name();
     CellFaces& faces = *Handle<CellFaces>(region.get_child(shape_name));
     FaceCellConnectivity&  f2c  = *faces.connectivity_face2cell();
@@ -449,7 +546,6 @@ boost::shared_ptr< FaceCellConnectivity > BuildFaces::match_faces(Region& region
 
   CFdebug << "matching faces between regions " << region1.uri().path() << "  and  " << region2.uri().path() << CFendl;
 
-  Mesh& mesh = *m_mesh;
   // interface connectivity
   boost::shared_ptr<FaceCellConnectivity> interface = allocate_component<FaceCellConnectivity>("interface_connectivity");
   interface->options().set("face_building_algorithm",true);
@@ -467,9 +563,9 @@ boost::shared_ptr< FaceCellConnectivity > BuildFaces::match_faces(Region& region
   std::map<FaceCellConnectivity*,boost::shared_ptr<common::Table<bool>::Buffer> > buf_cell_orientation;
   std::map<FaceCellConnectivity*,boost::shared_ptr<common::Table<Uint>::Buffer> > buf_cell_rotation;
 
-  // Build a node to face connectivity matching faces2
-  boost::shared_ptr<Node2FaceCellConnectivity> node2faces2_ptr = allocate_component<Node2FaceCellConnectivity>("node2faces");
-  Node2FaceCellConnectivity& node2faces2 = *node2faces2_ptr;
+  // Hash the faces of region2 by their nodes
+  FaceNodeHash faces2_hash;
+  std::vector<Face2Cell> faces2_list;
   boost_foreach(FaceCellConnectivity& faces2, find_components_recursively_with_tag<FaceCellConnectivity>(region2,mesh::Tags::inner_faces()))
   {
     buf_fnb [&faces2] = boost::shared_ptr<common::Table<Uint>::Buffer> ( new common::Table<Uint>::Buffer(faces2.face_number().create_buffer()));
@@ -477,13 +573,24 @@ boost::shared_ptr< FaceCellConnectivity > BuildFaces::match_faces(Region& region
     buf_f2c [&faces2] = boost::shared_ptr<ElementConnectivity::Buffer> ( new ElementConnectivity::Buffer(faces2.connectivity().create_buffer()));
     buf_cell_rotation [&faces2] = boost::shared_ptr<common::Table<Uint>::Buffer> ( new common::Table<Uint>::Buffer(faces2.cell_rotation().create_buffer()));
     buf_cell_orientation [&faces2] = boost::shared_ptr<common::Table<bool>::Buffer> ( new common::Table<bool>::Buffer(faces2.cell_orientation().create_buffer()));
-    node2faces2.add_used(faces2); // it is assumed this is only face types
+
+    faces2_hash.reserve(faces2_hash.size()+faces2.size());
+    for (Uint idx=0; idx<faces2.size(); ++idx)
+    {
+      Face2Cell face2(faces2,idx);
+      if (faces2_hash.insert(face2.nodes()).second)
+        faces2_list.push_back(face2);
+    }
   }
-  node2faces2.set_nodes(mesh.geometry_fields());
-  node2faces2.build_connectivity();
 
-  Uint f1(0);
-  Uint faces1_idx(0);
+  std::vector<Uint> face1_nodes;
+  std::vector<Uint> face2_nodes;
+  std::vector<Entity> elems(2);
+  std::vector<Uint> face_nb(2);
+  std::vector<Uint> rotation(2);
+  std::vector<bool> orientation(2);
+  enum {LEFT=0,RIGHT=1};
+
   boost_foreach(FaceCellConnectivity& faces1, find_components_recursively_with_tag<FaceCellConnectivity>(region1,mesh::Tags::inner_faces()))
   {
     buf_fnb [&faces1] = boost::shared_ptr<common::Table<Uint>::Buffer> ( new common::Table<Uint>::Buffer(faces1.face_number().create_buffer()));
@@ -492,96 +599,60 @@ boost::shared_ptr< FaceCellConnectivity > BuildFaces::match_faces(Region& region
     buf_cell_rotation [&faces1] = boost::shared_ptr<common::Table<Uint>::Buffer> ( new common::Table<Uint>::Buffer(faces1.cell_rotation().create_buffer()));
     buf_cell_orientation [&faces1] = boost::shared_ptr<common::Table<bool>::Buffer> ( new common::Table<bool>::Buffer(faces1.cell_orientation().create_buffer()));
 
-
-    std::vector<Uint> face1_nodes;
-    std::vector<Uint> face2_nodes;
-    std::vector<Entity> elems(2);
-    std::vector<Uint> face_nb(2);
-    std::vector<Uint> rotation(2);
-    std::vector<bool> orientation(2);
-    enum {LEFT=0,RIGHT=1};
-    Uint nb_matches(0);
-
-
     for (Uint idx=0; idx<faces1.size(); ++idx)
     {
       Face2Cell face1(faces1,idx);
       face1_nodes = face1.nodes();
       const Uint nb_nodes_per_face = face1_nodes.size();
 
-      std::map<Face2Cell,Uint,FaceCompare> found_faces;
-      std::map<Face2Cell,Uint,FaceCompare>::iterator not_found = found_faces.end();
+      const Uint match = faces2_hash.find(face1_nodes);
+      if (match == FaceNodeHash::not_found())
+        continue;
+      Face2Cell face2 = faces2_list[match];
+
+      elems[LEFT]  = face1.cells()[0];
+      elems[RIGHT] = face2.cells()[0];
+      face_nb[LEFT] = face1.face_nb_in_cells()[0];
+      face_nb[RIGHT] = face2.face_nb_in_cells()[0];
+      orientation[LEFT] = FaceCellConnectivity::MATCHED;
+      orientation[RIGHT] = FaceCellConnectivity::INVERTED;
+      rotation[LEFT] = 0;
+
+      // NOW find the rotation and orientation of this new face to the RIGHT cell
 
-      bool match_found = false;
-      boost_foreach(const Uint face1_node, face1_nodes)
+      // Find orientation ( or find match between first face-nodes of both neighbouring elements )
+      face2_nodes = face2.nodes();
+
+      Uint rot;
+      for (rot=0; rot<nb_nodes_per_face; ++rot)
       {
-        boost_foreach(Face2Cell face2, node2faces2.connectivity()[face1_node])
+        if (face2_nodes[rot] == face1_nodes[0])
         {
-          std::map<Face2Cell,Uint,FaceCompare>::iterator it = found_faces.find(face2);
-          if ( it == not_found)
-          {
-            found_faces[face2]=1;
-          }
-          else
-          {
-            Uint& nb_faces = it->second;
-            ++nb_faces;
-            if (nb_faces == nb_nodes_per_face)
-            {
-              match_found = true;
-              elems[LEFT]  = face1.cells()[0];
-              elems[RIGHT] = face2.cells()[0];
-              face_nb[LEFT] = face1.face_nb_in_cells()[0];
-              face_nb[RIGHT] = face2.face_nb_in_cells()[0];
-              orientation[LEFT] = FaceCellConnectivity::MATCHED;
-              orientation[RIGHT] = FaceCellConnectivity::INVERTED;
-              rotation[LEFT] = 0;
-
-              // NOW find the rotation and orientation of this new face to the RIGHT cell
-
-              // Find orientation ( or find match between first face-nodes of both neighbouring elements )
-              face2_nodes = face2.nodes();
-
-              Uint rot;
-              for (rot=0; rot<=nb_nodes_per_face; ++rot)
-              {
-                if (face2_nodes[rot] == face1_nodes[0])
-                {
-                  rotation[RIGHT] = rot;
-                  break;
-                }
-              }
-              cf3_assert(rot != nb_nodes_per_face); // means that the break worked and the rotation was found
-
-
-              // Remove matches from the 2 connectivity tables and add to the interface
-              i2c.add_row(elems);
-              fnb.add_row(face_nb);
-              bdry.add_row(false);
-              cell_rotation.add_row(rotation);
-              cell_orientation.add_row(orientation);
-
-              buf_f2c [face1.comp]->rm_row(face1.idx);
-              buf_f2c [face2.comp]->rm_row(face2.idx);
-              buf_fnb [face1.comp]->rm_row(face1.idx);
-              buf_fnb [face2.comp]->rm_row(face2.idx);
-              buf_bdry[face1.comp]->rm_row(face1.idx);
-              buf_bdry[face2.comp]->rm_row(face2.idx);
-              buf_cell_orientation[face1.comp]->rm_row(face1.idx);
-              buf_cell_orientation[face2.comp]->rm_row(face2.idx);
-              buf_cell_rotation[face1.comp]->rm_row(face1.idx);
-              buf_cell_rotation[face2.comp]->rm_row(face2.idx);
-              ++nb_matches;
-              break;
-            }
-          }
-        }
-        if (match_found)
+          rotation[RIGHT] = rot;
           break;
+        }
       }
-      ++f1;
+      cf3_assert(rot != nb_nodes_per_face); // means that the break worked and the rotation was found
+
+
+      // Remove matches from the 2 connectivity tables and add to the interface
+      i2c.add_row(elems);
+      fnb.add_row(face_nb);
+      bdry.add_row(false);
+      cell_rotation.add_row(rotation);
+      cell_orientation.add_row(orientation);
+
+      buf_f2c [face1.comp]->rm_row(face1.idx);
+      buf_f2c [face2.comp]->rm_row(face2.idx);
+      buf_fnb [face1.comp]->rm_row(face1.idx);
+      buf_fnb [face2.comp]->rm_row(face2.idx);
+      buf_bdry[face1.comp]->rm_row(face1.idx);
+      buf_bdry[face2.comp]->rm_row(face2.idx);
+      buf_cell_orientation[face1.comp]->rm_row(face1.idx);
+      buf_cell_orientation[face2.comp]->rm_row(face2.idx);
+      buf_cell_rotation[face1.comp]->rm_row(face1.idx);
+      buf_cell_rotation[face2.comp]->rm_row(face2.idx);
     }
-    ++faces1_idx;
   }
 
   return interface;
@@ -592,7 +663,6 @@ boost::shared_ptr< FaceCellConnectivity > BuildFaces::match_faces(Region& region
 
 void BuildFaces::match_boundary(Region& bdry_region, Region& inner_region)
 {
-  Mesh& mesh = *m_mesh;
   const Uint INNER=0;
   // create buffers for each face_cell_connectivity of unified_inner_faces_to_cells
   std::map<FaceCellConnectivity*,boost::shared_ptr<common::Table<Uint>::Buffer> >  buf_inner_face_nb;
@@ -601,9 +671,9 @@ void BuildFaces::match_boundary(Region& bdry_region, Region& inner_region)
   std::map<FaceCellConnectivity*,boost::shared_ptr<common::Table<bool>::Buffer> >  buf_inner_orientation;
   std::map<FaceCellConnectivity*,boost::shared_ptr<common::Table<Uint>::Buffer> >  buf_inner_rotation;
 
-  // Build a node to face connectivity matching faces2
-  boost::shared_ptr<Node2FaceCellConnectivity> nodes_to_inner_faces_ptr = allocate_component<Node2FaceCellConnectivity>("node2faces");
-  Node2FaceCellConnectivity& nodes_to_inner_faces = *nodes_to_inner_faces_ptr;
+  // Hash the inner faces by their nodes
+  FaceNodeHash inner_faces_hash;
+  std::vector<Face2Cell> inner_faces_list;
   boost_foreach(FaceCellConnectivity& f2c, find_components_recursively_with_tag<FaceCellConnectivity>(inner_region,mesh::Tags::inner_faces()))
   {
     buf_inner_face_nb          [&f2c] = boost::shared_ptr<common::Table<Uint>::Buffer> ( new common::Table<Uint>::Buffer(f2c.face_number().create_buffer()));
@@ -612,11 +682,16 @@ void BuildFaces::match_boundary(Region& bdry_region, Region& inner_region)
     buf_inner_rotation          [&f2c] = boost::shared_ptr<common::Table<Uint>::Buffer> ( new common::Table<Uint>::Buffer(f2c.cell_rotation().create_buffer()));
     buf_inner_orientation       [&f2c] = boost::shared_ptr<common::Table<bool>::Buffer> ( new common::Table<bool>::Buffer(f2c.cell_orientation().create_buffer()));
 
-    nodes_to_inner_faces.add_used(f2c);
+    inner_faces_hash.reserve(inner_faces_hash.size()+f2c.size());
+    for (Uint idx=0; idx<f2c.size(); ++idx)
+    {
+      Face2Cell inner_face(f2c,idx);
+      if (inner_faces_hash.insert(inner_face.nodes()).second)
+        inner_faces_list.push_back(inner_face);
+    }
   }
-  nodes_to_inner_faces.set_nodes(mesh.geometry_fields());
-  nodes_to_inner_faces.build_connectivity();
 
+  std::vector<Uint> bdry_face_nodes;
   boost_foreach(Elements& bdry_faces, find_components<Elements>(bdry_region))
   {
     Handle< FaceCellConnectivity > bdry_face_to_cell = find_component_ptr<FaceCellConnectivity>(bdry_faces);
@@ -645,101 +720,59 @@ void BuildFaces::match_boundary(Region& bdry_region, Region& inner_region)
     // the bdry_face_connectivity table
     std::vector<Entity> elems(1);
 
-    // initialize a counter for see if matches are found.
-    // A match is found if every node of a boundary face is also found in an inner_face
-    Uint nb_matches(0);
+    // A match is found if an inner face has exactly the nodes of a boundary face
     for (Uint idx=0; idx<bdry_faces.size(); ++idx)
     {
       Entity bdry_entity(bdry_faces,idx);
-      Connectivity::ConstRow bdry_face_nodes = bdry_entity.get_nodes();
+      Connectivity::ConstRow bdry_entity_nodes = bdry_entity.get_nodes();
+      bdry_face_nodes.assign(bdry_entity_nodes.begin(), bdry_entity_nodes.end());
       const Uint nb_nodes_per_face = bdry_face_nodes.size();
 
-      std::map<Face2Cell,Uint,FaceCompare> found_faces;
-      std::map<Face2Cell,Uint,FaceCompare>::iterator not_found = found_faces.end();
+      const Uint match = inner_faces_hash.find(bdry_face_nodes);
+      if (match == FaceNodeHash::not_found())
+        continue;
+      Face2Cell inner_face = inner_faces_list[match];
+
+      elems[INNER] = inner_face.cells()[INNER];
+
+      // Remove matches from the inner_faces_connectivity tables and add to the boundary
+      bdry_face_connectivity.set_row(bdry_entity.idx,elems);
+      bdry_face_nb[bdry_entity.idx][INNER] = inner_face.face_nb_in_cells()[INNER];
+      bdry_face_is_bdry[bdry_entity.idx] = true;
 
-      bool match_found = false;
-      boost_foreach(const Uint bdry_face_node, bdry_face_nodes)
+      if (nb_nodes_per_face == 1)
+      {
+        bdry_rotation[bdry_entity.idx][INNER] = 0;
+        bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::MATCHED;
+      }
+      else
       {
-        boost_foreach( Face2Cell& inner_face, nodes_to_inner_faces.connectivity()[bdry_face_node])
+        std::vector<Uint> inner_face_nodes = inner_face.nodes();
+        Uint rot;
+        for (rot=0; rot<nb_nodes_per_face; ++rot)
         {
-          std::map<Face2Cell,Uint,FaceCompare>::iterator it = found_faces.find(inner_face);
-          if ( it == not_found)
-          {
-            found_faces[inner_face]=1;
-
-            it = found_faces.find(inner_face);
-
-            if (nb_nodes_per_face == 1)
-            {
-              match_found = true;
-              elems[INNER] = inner_face.cells()[INNER];
-
-              // Remove matches from the inner_faces_connectivity tables and add to the boundary
-              bdry_face_connectivity.set_row(bdry_entity.idx,elems);
-              bdry_face_nb[bdry_entity.idx][INNER] = inner_face.face_nb_in_cells()[INNER];
-              bdry_face_is_bdry[bdry_entity.idx] = true;
-              bdry_rotation[bdry_entity.idx][INNER] = 0;
-              bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::MATCHED;
-
-              buf_inner_face_connectivity[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_face_nb[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_face_is_bdry[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_orientation[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_rotation[inner_face.comp]->rm_row(inner_face.idx);
-
-              ++nb_matches;
-              break;
-            }
-          }
-          else
+          if (inner_face_nodes[rot] == bdry_face_nodes[0])
           {
-            Uint& nb_faces = it->second;
-            ++nb_faces;
-
-            if (nb_faces == nb_nodes_per_face)
-            {
-              match_found = true;
-              elems[0] = inner_face.cells()[INNER];
-
-              // Remove matches from the inner_faces_connectivity tables and add to the boundary
-              bdry_face_connectivity.set_row(bdry_entity.idx,elems);
-              bdry_face_nb[bdry_entity.idx][INNER] = inner_face.face_nb_in_cells()[INNER];
-              bdry_face_is_bdry[bdry_entity.idx] = true;
-
-              std::vector<Uint> inner_face_nodes = inner_face.nodes();
-              Uint rot;
-              for (rot=0; rot<=nb_nodes_per_face; ++rot)
-              {
-                if (inner_face_nodes[rot] == bdry_face_nodes[0])
-                {
-                  bdry_rotation[bdry_entity.idx][INNER] = rot;
-                  break;
-                }
-              }
-
-              // Now find the orientation (outward or inward)
-              Uint next_node = rot+1;
-              if (next_node == nb_nodes_per_face)
-                next_node = 0;
-              if (inner_face_nodes[next_node]==bdry_face_nodes[1])
-                bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::MATCHED;
-              else
-                bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::INVERTED;
-
-              buf_inner_face_connectivity[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_face_nb[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_face_is_bdry[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_orientation[inner_face.comp]->rm_row(inner_face.idx);
-              buf_inner_rotation[inner_face.comp]->rm_row(inner_face.idx);
-
-              ++nb_matches;
-              break;
-            }
+            bdry_rotation[bdry_entity.idx][INNER] = rot;
+            break;
           }
         }
-        if (match_found)
-          break;
+
+        // Now find the orientation (outward or inward)
+        Uint next_node = rot+1;
+        if (next_node == nb_nodes_per_face)
+          next_node = 0;
+        if (inner_face_nodes[next_node]==bdry_face_nodes[1])
+          bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::MATCHED;
+        else
+          bdry_orientation[bdry_entity.idx][INNER] = FaceCellConnectivity::INVERTED;
       }
+
+      buf_inner_face_connectivity[inner_face.comp]->rm_row(inner_face.idx);
+      buf_inner_face_nb[inner_face.comp]->rm_row(inner_face.idx);
+      buf_inner_face_is_bdry[inner_face.comp]->rm_row(inner_face.idx);
+      buf_inner_orientation[inner_face.comp]->rm_row(inner_face.idx);
+      buf_inner_rotation[inner_face.comp]->rm_row(inner_face.idx);
     }
   }
 
@@ -749,7 +782,7 @@ void BuildFaces::match_boundary(Region& bdry_region, Region& inner_region)
 
 void BuildFaces::build_cell_face_connectivity(Component& parent)
 {
-
+  std::map<const Entities*, ElementConnectivity*> cell2face;
   boost_foreach(Cells& elements, find_components_recursively<Cells>(parent))
   {
     ElementConnectivity& c2f = *elements.create_component<ElementConnectivity>("face_connectivity");
@@ -758,36 +791,36 @@ void BuildFaces::build_cell_face_connectivity(Component& parent)
 
     // Add shortcut to Entities component
     elements.connectivity_cell2face() = c2f.handle<ElementConnectivity>();
+    cell2face[&elements] = &c2f;
   }
 
   boost_foreach(Entities& face_elements, find_components_recursively_with_tag<Entities>(parent,mesh::Tags::face_entity()) )
   {
-    FaceCellConnectivity& f2c = *face_elements.get_child_checked("cell_connectivity")->handle<FaceCellConnectivity>();
-    const ElementConnectivity& connectivity = f2c.connectivity();
-    const common::List<bool>&  is_bdry      = f2c.is_bdry_face();
-    const common::Table<Uint>& face_nb      = f2c.face_number();
+    const FaceCellConnectivity& f2c = *face_elements.get_child_checked("cell_connectivity")->handle<FaceCellConnectivity>();
+    const detail::CellFaceFiller fill_faces(face_elements, f2c, cell2face);
+    const Uint nb_faces = face_elements.size();
 
+    if (m_nb_threads < 2)
+    {
+      fill_faces(0, nb_faces);
+      continue;
+    }
 
-    for (Uint idx=0; idx<face_elements.size(); ++idx)
+    // Each thread handles a contiguous range of faces
+    std::vector<std::string> errors(m_nb_threads);
+    boost::thread_group threads;
+    for (Uint i=0; i!=m_nb_threads; ++i)
     {
-      Face2Cell face(f2c,idx);
-      Entity left_cell = face.cells()[LEFT];
-
-      ElementConnectivity& left_c2f = *left_cell.comp->get_child("face_connectivity")->handle<ElementConnectivity>();
-      cf3_assert(left_cell.idx < left_c2f.size());
-      cf3_assert(face.face_nb_in_cells()[LEFT] < left_c2f[left_cell.idx].size());
-      left_c2f[left_cell.idx][face.face_nb_in_cells()[LEFT]] = Entity(face_elements,idx);
-      cf3_assert(left_c2f[left_cell.idx][face.face_nb_in_cells()[LEFT]].comp);
-      if (face.is_bdry() == false)
-      {
-        Entity right_cell = face.cells()[RIGHT];
+      const Uint begin = (nb_faces * i) / m_nb_threads;
+      const Uint end = (nb_faces * (i+1)) / m_nb_threads;
+      threads.create_thread(boost::bind(&detail::CellFaceFiller::run_threaded, &fill_faces, begin, end, boost::ref(errors[i])));
+    }
+    threads.join_all();
 
-        ElementConnectivity& right_c2f = *right_cell.comp->get_child("face_connectivity")->handle<ElementConnectivity>();
-        cf3_assert(right_cell.idx < right_c2f.size());
-        cf3_assert(face.face_nb_in_cells()[RIGHT] < right_c2f[right_cell.idx].size());
-        right_c2f[right_cell.idx][face.face_nb_in_cells()[RIGHT]] = Entity(face_elements,idx);
-        cf3_assert(right_c2f[right_cell.idx][face.face_nb_in_cells()[RIGHT]].comp);
-      }
+    for (Uint i=0; i!=m_nb_threads; ++i)
+    {
+      if (!errors[i].empty())
+        throw common::ParallelError(FromHere(), "Error building cell to face connectivity in thread " + to_str(i) + ": " + errors[i]);
     }
   }
 }
@@ -4,8 +4,11 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
 #include <set>
 
+#include <boost/cstdint.hpp>
+
 #include "common/Log.hpp"
 #include "common/Builder.hpp"
 #include "common/FindComponents.hpp"
@@ -55,6 +58,37 @@ common::ComponentBuilder < GlobalNumbering, MeshTransformer, mesh::actions::LibA
 
 //////////////////////////////////////////////////////////////////////////////
 
+namespace detail {
+
+/// Global index of a node or element, stored at the home rank of its hash
+struct DirectoryEntry
+{
+  boost::uint64_t category;
+  boost::uint64_t hash;
+  boost::uint64_t glb_idx;
+  boost::uint64_t rank;
+
+  bool operator<(const DirectoryEntry& other) const
+  {
+    return category < other.category || (category == other.category && hash < other.hash);
+  }
+};
+
+/// Home rank of a hash in the distributed directory. Hilbert indices of neighbouring
+/// entities are close to each other, so the bits are mixed to spread them over all ranks.
+inline Uint home_rank(const boost::uint64_t category, const boost::uint64_t hash, const Uint nb_procs)
+{
+  boost::uint64_t key = hash ^ (category * UINT64_C(0x9E3779B97F4A7C15));
+  key ^= key >> 33;
+  key *= UINT64_C(0xFF51AFD7ED558CCD);
+  key ^= key >> 33;
+  return static_cast<Uint>(key % nb_procs);
+}
+
+} // detail
+
+//////////////////////////////////////////////////////////////////////////////
+
 GlobalNumbering::GlobalNumbering( const std::string& name )
 : MeshTransformer(name),
   m_debug(false)
@@ -183,18 +217,19 @@ void GlobalNumbering::execute()
   }
 
 
-  // now renumber
+  // now renumber, using a distributed directory: the owner of each node and element registers
+  // its global index at the home rank of its hash, and ghosts query their home rank for it.
+  // This takes three all_to_all exchanges, independent of the number of processes.
 
-  //------------------------------------------------------------------------------
-  // create node_hilbert2loc mapping
-  Dictionary& nodes = mesh.geometry_fields();
-  std::map<boost::uint64_t,Uint> node_hilbert2loc;
-  Uint loc_node_idx(0);
-  boost_foreach(boost::uint64_t hilbert_idx, hilbert_indices.data())
-    node_hilbert2loc[hilbert_idx]=loc_node_idx++;
+  const Uint nb_procs = PE::Comm::instance().size();
+  const Uint my_rank = PE::Comm::instance().rank();
 
-  // Check if all nodes have been added to the map
-  cf3_assert(loc_node_idx==nodes.size());
+  // Category 0 are the nodes, category 1+k the k-th Entities, as hashes are only unique within a category.
+  // All processes find the same Entities in the same order.
+  Dictionary& nodes = mesh.geometry_fields();
+  std::vector< Handle<Entities> > entities_list;
+  boost_foreach( Entities& elements, find_components_recursively<Entities>(mesh) )
+    entities_list.push_back(elements.handle<Entities>());
 
   //------------------------------------------------------------------------------
   // get tot nb of owned indexes and communicate
@@ -211,14 +246,12 @@ void GlobalNumbering::execute()
   }
 
   Uint nb_owned_elems(0);
-  boost_foreach( Entities& elements, find_components_recursively<Entities>(mesh) )
+  boost_foreach( const Handle<Entities>& elements, entities_list )
   {
-    common::List<Uint>& elem_rank = elements.rank();
-    elem_rank.resize(elements.size());
-
-    for (Uint e=0; e<elements.size(); ++e)
+    elements->rank().resize(elements->size());
+    for (Uint e=0; e<elements->size(); ++e)
     {
-      if (elements.is_ghost(e) == false)
+      if (elements->is_ghost(e) == false)
       {
         ++nb_owned_elems;
       }
@@ -227,9 +260,9 @@ void GlobalNumbering::execute()
 
   Uint tot_nb_owned_ids=nb_owned_nodes + nb_owned_elems;
 
-  std::vector<Uint> nb_ids_per_proc(PE::Comm::instance().size());
+  std::vector<Uint> nb_ids_per_proc(nb_procs);
   PE::Comm::instance().all_gather(tot_nb_owned_ids, nb_ids_per_proc);
-  std::vector<Uint> start_id_per_proc(PE::Comm::instance().size());
+  std::vector<Uint> start_id_per_proc(nb_procs);
   Uint start_id=0;
   for (Uint p=0; p<nb_ids_per_proc.size(); ++p)
   {
@@ -239,186 +272,197 @@ void GlobalNumbering::execute()
 
   if (m_debug)
   {
-    std::cout << "["<<PE::Comm::instance().rank() << "]  start_ids gathered" << std::endl;
+    std::cout << "["<<my_rank << "]  start_ids gathered" << std::endl;
   }
 
-
   //------------------------------------------------------------------------------
-  // add glb_idx to owned nodes, broadcast/receive glb_idx for ghost nodes
+  // add glb_idx to owned nodes and elements, and prepare the directory registrations
+  // (category, hash, glb_idx) and queries (category, hash) per home rank
 
-  std::vector<boost::uint64_t> node_from(nb_owned_nodes);
-  std::vector<boost::uint64_t> node_to(nb_owned_nodes);
+  std::vector< std::vector<boost::uint64_t> > send_owned(nb_procs);
+  std::vector< std::vector<boost::uint64_t> > send_query(nb_procs);
+  std::vector< std::vector<Uint> > query_locations(nb_procs); // (category, local index) of each query
 
   common::List<Uint>& nodes_glb_idx = mesh.geometry_fields().glb_idx();
   nodes_glb_idx.resize(nodes.size());
 
-  Uint cnt=0;
-  Uint glb_id = start_id_per_proc[PE::Comm::instance().rank()];
+  Uint glb_id = start_id_per_proc[my_rank];
   for (Uint i=0; i<nodes.size(); ++i)
   {
-    cf3_assert(nodes.rank()[i] < PE::Comm::instance().size());
+    cf3_assert(nodes.rank()[i] < nb_procs);
+    const boost::uint64_t hash = hilbert_indices.data()[i];
+    const Uint home = detail::home_rank(0, hash, nb_procs);
     if ( ! nodes.is_ghost(i) )
     {
       nodes_glb_idx[i] = glb_id++;
-      node_from[cnt] = hilbert_indices.data()[i];
-      node_to[cnt]   = nodes_glb_idx[i];
-      ++cnt;
+      send_owned[home].push_back(0);
+      send_owned[home].push_back(hash);
+      send_owned[home].push_back(nodes_glb_idx[i]);
     }
     else
     {
       nodes_glb_idx[i] = uint_max();
+      send_query[home].push_back(0);
+      send_query[home].push_back(hash);
+      query_locations[home].push_back(0);
+      query_locations[home].push_back(i);
     }
   }
 
-  for (Uint root=0; root<PE::Comm::instance().size(); ++root)
+  for (Uint k=0; k<entities_list.size(); ++k)
   {
+    Entities& elements = *entities_list[k];
+    const Uint category = k+1;
+    const std::vector<boost::uint64_t>& elem_hilbert_indices = Handle<CVector_uint64>(elements.get_child("hilbert_indices"))->data();
+    common::List<Uint>& elements_glb_idx = elements.glb_idx();
+    elements_glb_idx.resize(elements.size());
+    cf3_assert(elem_hilbert_indices.size() == elements.size());
 
-    std::vector<boost::uint64_t> rcv_node_from(0);
-    PE::Comm::instance().broadcast(node_from,rcv_node_from,root);
-    std::vector<boost::uint64_t>        rcv_node_to(0);
-    PE::Comm::instance().broadcast(node_to,rcv_node_to,root);
-
-    if (m_debug)
+    for (Uint e=0; e<elements.size(); ++e)
     {
-      std::cout << "["<<PE::Comm::instance().rank() << "]  received nodes from " << root << std::endl;
-    }
+      const boost::uint64_t hash = elem_hilbert_indices[e];
+      const Uint home = detail::home_rank(category, hash, nb_procs);
+      if ( ! elements.is_ghost(e) )
+      {
+        if (m_debug)
+          std::cout << "["<<my_rank << "]  will change owned elem "<< hash << " (" << elements.uri().path() << "["<<e<<"]) to " << glb_id << std::endl;
 
-    if (PE::Comm::instance().rank() != root)
-    {
-      for (Uint p=0; p<PE::Comm::instance().size(); ++p)
+        elements_glb_idx[e] = glb_id++;
+        send_owned[home].push_back(category);
+        send_owned[home].push_back(hash);
+        send_owned[home].push_back(elements_glb_idx[e]);
+      }
+      else
       {
-        if (p == PE::Comm::instance().rank())
-        {
-          Uint rcv_idx(0);
-          boost_foreach(const boost::uint64_t hilbert_idx, rcv_node_from)
-          {
-            if ( node_hilbert2loc.count(hilbert_idx) )
-            {
-              const Uint loc_idx = node_hilbert2loc[hilbert_idx];
-              if (m_debug)
-                std::cout << "["<<PE::Comm::instance().rank() << "]  will change node "<< hilbert_idx << " (local " << loc_idx<< ") to (global " << rcv_node_to[rcv_idx] << ")" << std::endl;
-              cf3_assert(rcv_idx < rcv_node_to.size());
-              nodes_glb_idx[loc_idx]=rcv_node_to[rcv_idx];
-              cf3_assert(loc_idx < nodes_rank.size());
-              cf3_assert_desc("node "+to_str(loc_idx)+ " with hilbert_idx " +to_str(hilbert_idx) +" must be a ghost, but is owned by "+to_str(nodes_rank[loc_idx]),nodes.is_ghost(loc_idx));
-              nodes_rank[loc_idx]=std::min(root,nodes_rank[loc_idx]);
-            }
-            ++rcv_idx;
-          }
-          break;
-        }
+        elements_glb_idx[e] = uint_max();
+        send_query[home].push_back(category);
+        send_query[home].push_back(hash);
+        query_locations[home].push_back(category);
+        query_locations[home].push_back(e);
       }
     }
-    if (m_debug)
+  }
+
+  //------------------------------------------------------------------------------
+  // build the directory part of this rank, as a sorted vector
+
+  std::vector<detail::DirectoryEntry> directory;
+  {
+    std::vector< std::vector<boost::uint64_t> > recv_owned;
+    PE::Comm::instance().all_to_all(send_owned, recv_owned);
+    std::vector< std::vector<boost::uint64_t> >().swap(send_owned);
+
+    Uint nb_entries = 0;
+    for (Uint p=0; p<nb_procs; ++p)
+      nb_entries += recv_owned[p].size() / 3;
+    directory.reserve(nb_entries);
+    for (Uint p=0; p<nb_procs; ++p)
     {
-      std::cout << "["<<PE::Comm::instance().rank() << "]  changed nodes based on " << root << std::endl;
+      for (Uint i=0; i<recv_owned[p].size(); i+=3)
+      {
+        detail::DirectoryEntry entry;
+        entry.category = recv_owned[p][i];
+        entry.hash = recv_owned[p][i+1];
+        entry.glb_idx = recv_owned[p][i+2];
+        entry.rank = p;
+        directory.push_back(entry);
+      }
     }
-
   }
+  std::sort(directory.begin(), directory.end());
 
   if (m_debug)
   {
-    std::cout << "["<<PE::Comm::instance().rank() << "]  checking node validity" << std::endl;
-    for (Uint i=0; i<nodes.size(); ++i)
+    for (Uint i=1; i<directory.size(); ++i)
     {
-      cf3_assert(nodes.glb_idx()[i] != uint_max());
-      if (nodes.is_ghost(i) == false)
-      {
-        cf3_assert(nodes.glb_idx()[i] >= start_id_per_proc[PE::Comm::instance().rank()]);
-        cf3_assert(nodes.glb_idx()[i] < start_id_per_proc[PE::Comm::instance().rank()] + nb_owned_nodes);
-      }
+      if ( !(directory[i-1] < directory[i]) )
+        throw ValueExists(FromHere(), "hash "+to_str(directory[i].hash)+" is owned by processes "+to_str(directory[i-1].rank)+" and "+to_str(directory[i].rank));
     }
+    std::cout << "["<<my_rank << "]  directory built with " << directory.size() << " entries" << std::endl;
   }
 
   //------------------------------------------------------------------------------
-  // give glb idx to elements
+  // answer the queries with (glb_idx, rank), or uint_max if no process owns the hash
 
-  boost_foreach( Entities& elements, find_components_recursively<Entities>(mesh) )
+  std::vector< std::vector<boost::uint64_t> > recv_reply;
   {
-    if (m_debug)
-      std::cout << "give glb idx to elements " << elements.uri() << std::endl;
-    std::vector<boost::uint64_t>& hilbert_indices = Handle<CVector_uint64>(elements.get_child("hilbert_indices"))->data();
-    common::List<Uint>& elem_rank = elements.rank();
-    elem_rank.resize(elements.size());
-
-    //------------------------------------------------------------------------------
-    // create elem_glb2loc mapping
-    Uint nb_owned_elems=0;
-    std::map<boost::uint64_t,Uint> elem_glb2loc;
-    std::map<boost::uint64_t,Uint>::iterator elem_glb2loc_it;
-    std::map<boost::uint64_t,Uint>::iterator hash_not_found = elem_glb2loc.end();
+    std::vector< std::vector<boost::uint64_t> > recv_query;
+    PE::Comm::instance().all_to_all(send_query, recv_query);
+    std::vector< std::vector<boost::uint64_t> >().swap(send_query);
 
-    for (Uint e=0; e<elements.size(); ++e)
+    std::vector< std::vector<boost::uint64_t> > send_reply(nb_procs);
+    for (Uint p=0; p<nb_procs; ++p)
     {
-      elem_glb2loc [ hilbert_indices[e] ] = e;
-      if ( ! elements.is_ghost(e) )
-        ++nb_owned_elems;
+      send_reply[p].reserve(recv_query[p].size());
+      for (Uint i=0; i<recv_query[p].size(); i+=2)
+      {
+        detail::DirectoryEntry key;
+        key.category = recv_query[p][i];
+        key.hash = recv_query[p][i+1];
+        const std::vector<detail::DirectoryEntry>::const_iterator found = std::lower_bound(directory.begin(), directory.end(), key);
+        if (found != directory.end() && !(key < *found))
+        {
+          send_reply[p].push_back(found->glb_idx);
+          send_reply[p].push_back(found->rank);
+        }
+        else
+        {
+          send_reply[p].push_back(uint_max());
+          send_reply[p].push_back(uint_max());
+        }
+      }
     }
+    PE::Comm::instance().all_to_all(send_reply, recv_reply);
+  }
 
+  //------------------------------------------------------------------------------
+  // give glb idx and rank to the ghost nodes and elements
 
-    std::vector<boost::uint64_t> send_hash(nb_owned_elems);
-    std::vector<boost::uint64_t>   send_id(nb_owned_elems);
-
-    common::List<Uint>& elements_glb_idx = elements.glb_idx();
-    elements_glb_idx.resize(elements.size());
-    cf3_assert(hilbert_indices.size() == elements.size());
-
-    Uint cnt(0);
-    for (Uint e=0; e<elements.size(); ++e)
+  for (Uint p=0; p<nb_procs; ++p)
+  {
+    cf3_assert(recv_reply[p].size() == query_locations[p].size());
+    for (Uint i=0; i<query_locations[p].size(); i+=2)
     {
-
-      if ( ! elements.is_ghost(e) )
+      const Uint category = query_locations[p][i];
+      const Uint loc_idx = query_locations[p][i+1];
+      const Uint glb_idx = recv_reply[p][i];
+      const Uint owner = recv_reply[p][i+1];
+      if (glb_idx == uint_max())
+        continue;
+
+      if (category == 0)
       {
         if (m_debug)
-          std::cout << "["<<PE::Comm::instance().rank() << "]  will change owned elem "<< hilbert_indices[e] << " (" << elements.uri().path() << "["<<e<<"]) to " << glb_id << std::endl;
-
-        elements_glb_idx[e] = glb_id++;
-        send_hash[cnt] = hilbert_indices[e];
-        send_id[cnt]   = elements_glb_idx[e];
-        ++cnt;
+          std::cout << "["<<my_rank << "]  will change node "<< hilbert_indices.data()[loc_idx] << " (local " << loc_idx<< ") to (global " << glb_idx << ")" << std::endl;
+        cf3_assert_desc("node "+to_str(loc_idx)+" must be a ghost, but is owned by "+to_str(nodes_rank[loc_idx]),nodes.is_ghost(loc_idx));
+        nodes_glb_idx[loc_idx]=glb_idx;
+        nodes_rank[loc_idx]=std::min(owner,nodes_rank[loc_idx]);
       }
       else
       {
-        elements_glb_idx[e] = uint_max();
+        Entities& elements = *entities_list[category-1];
+        if (m_debug)
+          std::cout << "["<<my_rank << "]  will change ghost elem (" << elements.uri() << "[" << loc_idx << "]) to " << glb_idx << std::endl;
+        cf3_assert(elements.is_ghost(loc_idx));
+        elements.glb_idx()[loc_idx]=glb_idx;
+        elements.rank()[loc_idx]=owner;
       }
-    } // end foreach elem_idx
-    cf3_assert(cnt == nb_owned_elems);
+    }
+  }
 
-    for (Uint root=0; root<PE::Comm::instance().size(); ++root)
+  if (m_debug)
+  {
+    std::cout << "["<<my_rank << "]  checking node validity" << std::endl;
+    for (Uint i=0; i<nodes.size(); ++i)
     {
-      std::vector<boost::uint64_t> recv_hash(0);
-      PE::Comm::instance().broadcast(send_hash,recv_hash,root);
-      std::vector<boost::uint64_t>        recv_id(0);
-      PE::Comm::instance().broadcast(send_id,recv_id,root);
-      if (PE::Comm::instance().rank() != root)
+      cf3_assert(nodes.glb_idx()[i] != uint_max());
+      if (nodes.is_ghost(i) == false)
       {
-        for (Uint p=0; p<PE::Comm::instance().size(); ++p)
-        {
-          if (p == PE::Comm::instance().rank())
-          {
-            Uint recv_idx(0);
-            boost_foreach(const boost::uint64_t hash, recv_hash)
-            {
-              elem_glb2loc_it = elem_glb2loc.find(hash);
-              if ( elem_glb2loc_it != hash_not_found )
-              {
-                if (m_debug)
-                  std::cout << "["<<PE::Comm::instance().rank() << "]  will change ghost elem "<< elem_glb2loc_it->first << " (" << elements.uri() << "[" << elem_glb2loc_it->second << "]) to " << recv_id[recv_idx] << std::endl;
-                elements_glb_idx[elem_glb2loc_it->second]=recv_id[recv_idx];
-                cf3_assert(elements.is_ghost(elem_glb2loc_it->second));
-                elem_rank[elem_glb2loc_it->second]=root;
-              }
-              ++recv_idx;
-            }
-            break;
-          }
-        }
+        cf3_assert(nodes.glb_idx()[i] >= start_id_per_proc[my_rank]);
+        cf3_assert(nodes.glb_idx()[i] < start_id_per_proc[my_rank] + nb_owned_nodes);
       }
-    } // end foreach broadcasting process
-
-
-
-  } // end foreach elements
+    }
+  }
 
 
   // In debug mode, check if no hashes are duplicated
@@ -12,7 +12,7 @@
 
 #include "common/FindComponents.hpp"
 #include "common/Foreach.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/List.hpp"
 #include "common/OptionList.hpp"
 #include "common/PropertyList.hpp"
@@ -178,13 +178,20 @@ void Interpolate::interpolate(const Field& source, const common::Table<Real>& co
   RealVector coord(dimension); coord.setZero();
   const Uint target_dim = coordinates.row_size();
 
+  // Locate all local coordinates in one batch
+  std::vector<Entity> elements;
+  boost::multi_array<Real,2> mapped_coords;
+  m_octtree->find_elements(coordinates.array(),elements,mapped_coords);
+
+  RealVector mapped_coord(dimension);
   for(Uint i=0; i<coordinates.size(); ++i)
   {
-    for (Uint d=0; d<target_dim; ++d)
-      coord[d] = coordinates[i][d];
-    if( m_octtree->find_element(coord,element) )
+    element = elements[i];
+    if( is_not_null(element.comp) )
     {
-      interpolate_coordinate( coord, *element.comp, element.idx, target[i] );
+      for (Uint d=0; d<dimension; ++d)
+        mapped_coord[d] = mapped_coords[i][d];
+      interpolate_mapped_coordinate( mapped_coord, *element.comp, element.idx, target[i] );
 //      std::cout<< PERank << "interpolate for coord (" << coord.transpose() << ") in " << element_component->uri().path() << "["<<element_idx<<"] ... done" << std::endl;
     }
     else
@@ -321,16 +328,23 @@ void Interpolate::interpolate(const Field& source, const common::Table<Real>& co
 //////////////////////////////////////////////////////////////////////////////
 
 void Interpolate::interpolate_coordinate(const RealVector& target_coord, const Entities& element_component, const Uint element_idx, Field::Row target_row)
+{
+  RealMatrix source_geom_nodes(element_component.element_type().nb_nodes(),element_component.element_type().dimension());
+  element_component.geometry_space().put_coordinates(source_geom_nodes,element_idx);
+  RealVector local_coord(element_component.element_type().dimensionality());
+  element_component.element_type().compute_mapped_coordinate(target_coord,source_geom_nodes,local_coord);
+  interpolate_mapped_coordinate(local_coord, element_component, element_idx, target_row);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Interpolate::interpolate_mapped_coordinate(const RealVector& local_coord, const Entities& element_component, const Uint element_idx, Field::Row target_row)
 {
   cf3_assert(is_null(m_source) == false);
   const Field& source = *m_source;
   const Space& source_space = source.space(element_component);
   const ShapeFunction& sf = source_space.shape_function();
 
-  RealMatrix source_geom_nodes(element_component.element_type().nb_nodes(),element_component.element_type().dimension());
-  element_component.geometry_space().put_coordinates(source_geom_nodes,element_idx);
-  RealVector local_coord(sf.dimensionality());
-  element_component.element_type().compute_mapped_coordinate(target_coord,source_geom_nodes,local_coord);
   RealRowVector sf_value(sf.nb_nodes());
   sf.compute_value(local_coord,sf_value);
 
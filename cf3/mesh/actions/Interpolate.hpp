@@ -69,6 +69,9 @@ private:
 
   void interpolate_coordinate(const RealVector& target_coord, const Entities& element_component, const Uint element_idx, Field::Row target_row);
 
+  /// Interpolate at a point for which the mapped coordinates in the element are already known
+  void interpolate_mapped_coordinate(const RealVector& mapped_coord, const Entities& element_component, const Uint element_idx, Field::Row target_row);
+
 
 }; // end Interpolate
 
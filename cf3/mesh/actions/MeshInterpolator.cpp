@@ -112,7 +112,7 @@ void MeshInterpolator::execute()
       std::vector<Real> weights;
       std::vector<SpaceElem> dummy_stencil;
       Field::ConstRow coordrow = target_coords[i];
-      Eigen::Map<RealVector const> coord(&coordrow[0], dim);
+      Eigen::Map<RealVector const, Eigen::Unaligned, Eigen::InnerStride<> > coord(&coordrow[0], dim, Eigen::InnerStride<>(target_coords.array().strides()[1]));
       bool found = point_interpolator->compute_storage(coord, space_elems[i], dummy_stencil, points, weights);
       if(!found)
       {
@@ -196,7 +196,7 @@ void MeshInterpolator::execute()
       std::vector<Real> weights;
       std::vector<SpaceElem> dummy_stencil;
       Field::ConstRow coordrow = target_coords[i];
-      Eigen::Map<RealVector const> coord(&coordrow[0], dim);
+      Eigen::Map<RealVector const, Eigen::Unaligned, Eigen::InnerStride<> > coord(&coordrow[0], dim, Eigen::InnerStride<>(target_coords.array().strides()[1]));
       bool found = point_interpolator->compute_storage(coord, space_elems[i], dummy_stencil, points, weights);
       if(!found)
       {
@@ -245,7 +245,7 @@ void MeshInterpolator::execute()
       {
         if(target_dict->is_ghost(i))
           continue;
-        Eigen::Map<RealVector> target_row(&target_array[i][0], row_size);
+        Eigen::Map<RealVector, Eigen::Unaligned, Eigen::InnerStride<> > target_row(&target_array[i][0], row_size, Eigen::InnerStride<>(target_array.strides()[1]));
         target_row.setZero();
         RealVector avg_row(target_row);
         const Uint interp_begin = points_begin_idxs[i];
@@ -259,7 +259,7 @@ void MeshInterpolator::execute()
           {
             throw common::SetupError(FromHere(), "Point " + common::to_str(all_points[j]) + " is outside the source point range");
           }
-          Eigen::Map<RealVector const> source_row(&source_array[all_points[j]][0], row_size);
+          Eigen::Map<RealVector const, Eigen::Unaligned, Eigen::InnerStride<> > source_row(&source_array[all_points[j]][0], row_size, Eigen::InnerStride<>(source_array.strides()[1]));
           target_row += all_weights[j] * source_row;
           avg_row += source_row;
           weightsum += all_weights[j];
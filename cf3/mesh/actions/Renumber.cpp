@@ -0,0 +1,497 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include <boost/assign/list_of.hpp>
+
+#include "common/Builder.hpp"
+#include "common/CompressedTable.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
+#include "common/List.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/StringConversion.hpp"
+#include "common/Table.hpp"
+
+#include "math/BoundingBox.hpp"
+#include "math/Hilbert.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementConnectivity.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/FaceCellConnectivity.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
+
+#include "mesh/actions/Renumber.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace actions {
+
+using namespace common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < Renumber, MeshTransformer, mesh::actions::LibActions> Renumber_Builder;
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+typedef std::vector< std::vector<Uint> > AdjacencyT;
+
+/// Sort key and original index, so sorting is stable
+typedef std::pair<boost::uint64_t, Uint> KeyT;
+
+/// Convert the old indices in their new order into the new index of each old index
+std::vector<Uint> invert(const std::vector<Uint>& order)
+{
+  std::vector<Uint> new_idx(order.size());
+  for(Uint i = 0; i != order.size(); ++i)
+    new_idx[order[i]] = i;
+  return new_idx;
+}
+
+/// New index of each item, after sorting on the keys
+std::vector<Uint> sort_keys(std::vector<KeyT>& keys)
+{
+  std::sort(keys.begin(), keys.end());
+  std::vector<Uint> order(keys.size());
+  for(Uint i = 0; i != keys.size(); ++i)
+    order[i] = keys[i].second;
+  return invert(order);
+}
+
+/// Orders nodes by increasing degree, and by index for equal degree
+struct LessDegree
+{
+  LessDegree(const AdjacencyT& adjacency) : m_adjacency(adjacency) {}
+
+  bool operator()(const Uint a, const Uint b) const
+  {
+    const Uint degree_a = m_adjacency[a].size();
+    const Uint degree_b = m_adjacency[b].size();
+    return degree_a < degree_b || (degree_a == degree_b && a < b);
+  }
+
+  const AdjacencyT& m_adjacency;
+};
+
+/// Append the nodes that are reachable from start and not visited yet to result, in Cuthill-McKee order:
+/// breadth-first, visiting the neighbours of each node by increasing degree
+void cuthill_mckee(const Uint start, const AdjacencyT& adjacency, std::vector<bool>& visited, std::vector<Uint>& result)
+{
+  const LessDegree less_degree(adjacency);
+  std::vector<Uint> neighbours;
+  Uint i = result.size();
+  result.push_back(start);
+  visited[start] = true;
+  for(; i != result.size(); ++i)
+  {
+    neighbours.clear();
+    boost_foreach(const Uint neighbour, adjacency[result[i]])
+    {
+      if(!visited[neighbour])
+      {
+        visited[neighbour] = true;
+        neighbours.push_back(neighbour);
+      }
+    }
+    std::sort(neighbours.begin(), neighbours.end(), less_degree);
+    result.insert(result.end(), neighbours.begin(), neighbours.end());
+  }
+}
+
+/// New index of each node using reverse Cuthill-McKee. Each connected part starts from a pseudo-peripheral node,
+/// i.e. the last node reached in a first traversal from its node of lowest degree.
+std::vector<Uint> reverse_cuthill_mckee(const AdjacencyT& adjacency)
+{
+  const Uint nb_nodes = adjacency.size();
+  std::vector<Uint> by_degree(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    by_degree[i] = i;
+  std::sort(by_degree.begin(), by_degree.end(), LessDegree(adjacency));
+
+  std::vector<bool> visited(nb_nodes, false);
+  std::vector<Uint> order;
+  order.reserve(nb_nodes);
+  std::vector<Uint> trial;
+  boost_foreach(const Uint candidate, by_degree)
+  {
+    if(visited[candidate])
+      continue;
+
+    trial.clear();
+    cuthill_mckee(candidate, adjacency, visited, trial);
+    boost_foreach(const Uint node, trial)
+      visited[node] = false;
+
+    cuthill_mckee(trial.back(), adjacency, visited, order);
+  }
+
+  std::reverse(order.begin(), order.end());
+  return invert(order);
+}
+
+/// New index of each point, sorted along a Hilbert curve through the given coordinates
+std::vector<Uint> hilbert_order(const common::Table<Real>::ArrayT& coordinates)
+{
+  const Uint nb_points = coordinates.size();
+  if(nb_points == 0)
+    return std::vector<Uint>();
+
+  const Uint dim = coordinates.shape()[1];
+  math::BoundingBox bounding_box;
+  RealVector point(dim);
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    for(Uint d = 0; d != dim; ++d)
+      point[d] = coordinates[i][d];
+    bounding_box.extend(point);
+  }
+
+  std::vector<KeyT> keys(nb_points);
+  math::Hilbert compute_hilbert_idx(bounding_box, 20);
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    for(Uint d = 0; d != dim; ++d)
+      point[d] = coordinates[i][d];
+    keys[i] = KeyT(compute_hilbert_idx(point), i);
+  }
+  return sort_keys(keys);
+}
+
+/// Copy the rows of a table into their new position
+template<typename T>
+void permute_rows(common::Table<T>& table, const std::vector<Uint>& new_idx)
+{
+  cf3_assert(table.size() == new_idx.size());
+  const typename common::Table<T>::ArrayT old_array(table.array());
+  const Uint nb_rows = new_idx.size();
+  for(Uint i = 0; i != nb_rows; ++i)
+    table[new_idx[i]] = old_array[i];
+}
+
+/// Copy the entries of a list into their new position
+template<typename T>
+void permute_list(common::List<T>& list, const std::vector<Uint>& new_idx)
+{
+  cf3_assert(list.size() == new_idx.size());
+  const std::vector<T> old_values(list.array().begin(), list.array().end());
+  const Uint nb_rows = new_idx.size();
+  for(Uint i = 0; i != nb_rows; ++i)
+    list[new_idx[i]] = old_values[i];
+}
+
+/// Copy the rows of a compressed table into their new position
+template<typename T>
+void permute_rows(common::CompressedTable<T>& table, const std::vector<Uint>& new_idx)
+{
+  cf3_assert(table.size() == new_idx.size());
+  const std::vector<Uint> old_offsets = table.offsets();
+  const std::vector<T> old_values = table.values();
+  const Uint nb_rows = new_idx.size();
+  std::vector<Uint> row_sizes(nb_rows);
+  for(Uint i = 0; i != nb_rows; ++i)
+    row_sizes[new_idx[i]] = old_offsets[i+1] - old_offsets[i];
+  table.set_row_sizes(row_sizes);
+  for(Uint i = 0; i != nb_rows; ++i)
+    std::copy(old_values.begin() + old_offsets[i], old_values.begin() + old_offsets[i+1], table.values().begin() + table.offsets()[new_idx[i]]);
+}
+
+/// True if the element order of these entities is referenced by face to cell connectivity data
+bool has_face_connectivity(const Entities& entities)
+{
+  return !find_components_recursively<FaceCellConnectivity>(entities).empty();
+}
+
+} // detail
+
+//////////////////////////////////////////////////////////////////////////////
+
+Renumber::Renumber( const std::string& name )
+: MeshTransformer(name)
+{
+  properties()["brief"] = std::string("Renumber nodes and elements for memory locality");
+  properties()["description"] = std::string(
+      "Renumber the nodes of the continuous dictionaries using reverse Cuthill-McKee or a Hilbert curve,\n"
+      "then sort the elements by their lowest node or along a Hilbert curve through their centroids.\n"
+      "The points of discontinuous dictionaries follow the element order.");
+
+  std::vector<std::string> node_orders = boost::assign::list_of("RCM")("Hilbert")("None");
+  options().add("node_order", std::string("RCM"))
+      .pretty_name("Node Order")
+      .description("Ordering of the nodes of continuous dictionaries: RCM (reverse Cuthill-McKee), Hilbert or None")
+      .mark_basic()
+      .restricted_list() = std::vector<boost::any>(node_orders.begin(), node_orders.end());
+
+  std::vector<std::string> element_orders = boost::assign::list_of("Nodes")("Hilbert")("None");
+  options().add("element_order", std::string("Nodes"))
+      .pretty_name("Element Order")
+      .description("Ordering of the elements: Nodes (by lowest geometry node index), Hilbert (by centroid) or None")
+      .mark_basic()
+      .restricted_list() = std::vector<boost::any>(element_orders.begin(), element_orders.end());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Renumber::execute()
+{
+  Mesh& mesh = *m_mesh;
+  const bool renumber_nodes_enabled = options().value<std::string>("node_order") != "None";
+  const bool renumber_elements_enabled = options().value<std::string>("element_order") != "None";
+
+  const Uint geometry_bandwidth = bandwidth(mesh.geometry_fields());
+
+  if(renumber_nodes_enabled)
+  {
+    boost_foreach(const Handle<Dictionary>& dict, mesh.dictionaries())
+    {
+      if(dict->continuous())
+        renumber_nodes(*dict, node_order(*dict));
+    }
+  }
+
+  if(renumber_elements_enabled)
+  {
+    boost_foreach(const Handle<Entities>& entities, mesh.elements())
+    {
+      if(detail::has_face_connectivity(*entities))
+      {
+        CFdebug << "Renumber: keeping the element order of " << entities->uri().path() << ", since it has face connectivity" << CFendl;
+        continue;
+      }
+      renumber_elements(*entities, element_order(*entities));
+    }
+  }
+
+  // The points of discontinuous dictionaries are numbered in the order in which the elements use them
+  boost_foreach(const Handle<Dictionary>& dict, mesh.dictionaries())
+  {
+    if(dict->continuous())
+      continue;
+
+    const Uint nb_points = dict->size();
+    std::vector<bool> numbered(nb_points, false);
+    std::vector<Uint> order;
+    order.reserve(nb_points);
+    boost_foreach(const Handle<Space>& space, dict->spaces())
+    {
+      boost_foreach(const Connectivity::ConstRow row, space->connectivity().array())
+      {
+        boost_foreach(const Uint point, row)
+        {
+          if(!numbered[point])
+          {
+            numbered[point] = true;
+            order.push_back(point);
+          }
+        }
+      }
+    }
+    for(Uint i = 0; i != nb_points; ++i)
+    {
+      if(!numbered[i])
+        order.push_back(i);
+    }
+    renumber_nodes(*dict, detail::invert(order));
+  }
+
+  mesh.raise_mesh_changed();
+
+  CFinfo << "Renumbered " << mesh.uri().path() << ": geometry bandwidth " << geometry_bandwidth << " -> " << bandwidth(mesh.geometry_fields()) << CFendl;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+std::vector<Uint> Renumber::node_order(const Dictionary& dict) const
+{
+  const Uint nb_nodes = dict.size();
+
+  if(options().value<std::string>("node_order") == "Hilbert")
+  {
+    Handle<Field const> coordinates(dict.get_child(mesh::Tags::coordinates()));
+    if(is_not_null(coordinates))
+      return detail::hilbert_order(coordinates->array());
+
+    CFdebug << "Renumber: no coordinates in " << dict.uri().path() << ", using reverse Cuthill-McKee" << CFendl;
+  }
+
+  // Nodes are adjacent if they share an element
+  detail::AdjacencyT adjacency(nb_nodes);
+  boost_foreach(const Handle<Space>& space, dict.spaces())
+  {
+    boost_foreach(const Connectivity::ConstRow row, space->connectivity().array())
+    {
+      const Uint row_size = row.size();
+      for(Uint i = 0; i != row_size; ++i)
+      {
+        for(Uint j = 0; j != row_size; ++j)
+        {
+          if(i != j)
+            adjacency[row[i]].push_back(row[j]);
+        }
+      }
+    }
+  }
+  boost_foreach(std::vector<Uint>& neighbours, adjacency)
+  {
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+  }
+
+  return detail::reverse_cuthill_mckee(adjacency);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+std::vector<Uint> Renumber::element_order(const Entities& entities) const
+{
+  const Connectivity& connectivity = entities.geometry_space().connectivity();
+  const Uint nb_elems = connectivity.size();
+  std::vector<detail::KeyT> keys(nb_elems);
+
+  if(options().value<std::string>("element_order") == "Hilbert")
+  {
+    const Field& coordinates = entities.geometry_fields().coordinates();
+    const Uint dim = coordinates.row_size();
+    Table<Real>::ArrayT centroids(boost::extents[nb_elems][dim]);
+    for(Uint e = 0; e != nb_elems; ++e)
+    {
+      const Connectivity::ConstRow row = connectivity[e];
+      for(Uint d = 0; d != dim; ++d)
+      {
+        Real sum = 0.;
+        boost_foreach(const Uint node, row)
+          sum += coordinates[node][d];
+        centroids[e][d] = sum / static_cast<Real>(row.size());
+      }
+    }
+    return detail::hilbert_order(centroids);
+  }
+
+  for(Uint e = 0; e != nb_elems; ++e)
+  {
+    const Connectivity::ConstRow row = connectivity[e];
+    keys[e] = detail::KeyT(*std::min_element(row.begin(), row.end()), e);
+  }
+  return detail::sort_keys(keys);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Renumber::renumber_nodes(Dictionary& dict, const std::vector<Uint>& new_idx)
+{
+  const Uint nb_nodes = dict.size();
+  if(new_idx.size() != nb_nodes)
+    throw BadValue(FromHere(), "Permutation of size " + to_str(new_idx.size()) + " for " + to_str(nb_nodes) + " points in " + dict.uri().path());
+
+  boost_foreach(Field& field, find_components<Field>(dict))
+  {
+    if(field.size() == nb_nodes)
+      detail::permute_rows(field, new_idx);
+  }
+  detail::permute_list(dict.glb_idx(), new_idx);
+  detail::permute_list(dict.rank(), new_idx);
+
+  Handle< List<Uint> > periodic_links_nodes(dict.get_child("periodic_links_nodes"));
+  Handle< List<bool> > periodic_links_active(dict.get_child("periodic_links_active"));
+  if(is_not_null(periodic_links_nodes))
+  {
+    cf3_assert(is_not_null(periodic_links_active));
+    detail::permute_list(*periodic_links_nodes, new_idx);
+    detail::permute_list(*periodic_links_active, new_idx);
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      if((*periodic_links_active)[i])
+        (*periodic_links_nodes)[i] = new_idx[(*periodic_links_nodes)[i]];
+    }
+  }
+
+  Handle< CompressedTable<Uint> > glb_elem_connectivity(dict.get_child("glb_elem_connectivity"));
+  if(is_not_null(glb_elem_connectivity) && glb_elem_connectivity->size() == nb_nodes)
+    detail::permute_rows(*glb_elem_connectivity, new_idx);
+
+  boost_foreach(const Handle<Space>& space, dict.spaces())
+  {
+    boost_foreach(Connectivity::Row row, space->connectivity().array())
+    {
+      boost_foreach(Uint& node, row)
+        node = new_idx[node];
+    }
+  }
+
+  // The communication pattern is built from the point order, so it is recreated on the next synchronization
+  Handle<Component> comm_pattern = dict.get_child("CommPattern");
+  if(is_not_null(comm_pattern))
+    dict.remove_component(*comm_pattern);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Renumber::renumber_elements(Entities& entities, const std::vector<Uint>& new_idx)
+{
+  const Uint nb_elems = entities.size();
+  if(new_idx.size() != nb_elems)
+    throw BadValue(FromHere(), "Permutation of size " + to_str(new_idx.size()) + " for " + to_str(nb_elems) + " elements in " + entities.uri().path());
+
+  detail::permute_list(entities.glb_idx(), new_idx);
+  detail::permute_list(entities.rank(), new_idx);
+  boost_foreach(const Handle<Space>& space, entities.spaces())
+  {
+    detail::permute_rows(space->connectivity(), new_idx);
+  }
+
+  boost_foreach(ElementConnectivity& element_connectivity, find_components_recursively<ElementConnectivity>(find_parent_component<Mesh>(entities)))
+  {
+    boost_foreach(ElementConnectivity::Row row, element_connectivity.array())
+    {
+      boost_foreach(Entity& element, row)
+      {
+        if(element.comp == &entities)
+          element.idx = new_idx[element.idx];
+      }
+    }
+  }
+
+  // Cached element colouring is no longer valid
+  Handle<Component> colouring = entities.get_child("element_colouring");
+  if(is_not_null(colouring))
+    entities.remove_component(*colouring);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+Uint Renumber::bandwidth(const Dictionary& dict)
+{
+  Uint result = 0;
+  boost_foreach(const Handle<Space>& space, dict.spaces())
+  {
+    boost_foreach(const Connectivity::ConstRow row, space->connectivity().array())
+    {
+      const Uint min_node = *std::min_element(row.begin(), row.end());
+      const Uint max_node = *std::max_element(row.begin(), row.end());
+      result = std::max(result, max_node - min_node);
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // mesh
+} // cf3
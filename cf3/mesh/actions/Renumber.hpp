@@ -0,0 +1,79 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_actions_Renumber_hpp
+#define cf3_mesh_actions_Renumber_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mesh/MeshTransformer.hpp"
+#include "mesh/actions/LibActions.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+
+  class Dictionary;
+  class Entities;
+
+namespace actions {
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// @brief Renumber the local nodes and elements of a mesh to improve memory locality
+///
+/// The nodes of each continuous dictionary are ordered using reverse Cuthill-McKee on the graph
+/// of nodes sharing an element, or along a Hilbert space-filling curve. The elements of each
+/// Entities are then sorted by their lowest node index, or along a Hilbert curve through their
+/// centroids. The points of discontinuous dictionaries follow the new element order.
+///
+/// Connectivity tables, fields, global indices, ranks, periodic links and element connectivity
+/// tables are permuted consistently. Communication patterns of the renumbered dictionaries are
+/// removed, and rebuilt the next time a field is synchronized. Entities with a face to cell connectivity
+/// are not reordered, so it is best to run this right after loading or partitioning the mesh.
+class mesh_actions_API Renumber : public MeshTransformer
+{
+public: // functions
+
+  /// constructor
+  Renumber( const std::string& name );
+
+  /// Gets the Class name
+  static std::string type_name() { return "Renumber"; }
+
+  virtual void execute();
+
+  /// Apply a permutation to the points of a dictionary
+  /// @param [in] new_idx  New index of each point
+  static void renumber_nodes(Dictionary& dict, const std::vector<Uint>& new_idx);
+
+  /// Apply a permutation to the elements of an Entities component, updating the element connectivity tables of the parent mesh
+  /// @param [in] new_idx  New index of each element
+  static void renumber_elements(Entities& entities, const std::vector<Uint>& new_idx);
+
+  /// Largest difference between the indices of two points of the same element, over all spaces of the dictionary
+  static Uint bandwidth(const Dictionary& dict);
+
+private: // functions
+
+  /// New index for each point of the continuous dictionary, using the configured node order
+  std::vector<Uint> node_order(const Dictionary& dict) const;
+
+  /// New index for each element, using the configured element order
+  std::vector<Uint> element_order(const Entities& entities) const;
+
+}; // end Renumber
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_actions_Renumber_hpp
@@ -4,7 +4,13 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
-#include <set>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <numeric>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "common/Builder.hpp"
 
@@ -13,8 +19,13 @@
 #include "common/Option.hpp"
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
+#include "common/Log.hpp"
+#include "common/StringConversion.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "math/Consts.hpp"
 
-#include "mesh/ConnectivityData.hpp"
 #include "mesh/DiscontinuousDictionary.hpp"
 #include "mesh/ElementData.hpp"
 #include "mesh/Faces.hpp"
@@ -26,8 +37,11 @@
 #include "mesh/Connectivity.hpp"
 #include "mesh/ElementData.hpp"
 
+#include "mesh/LagrangeP1/Line2D.hpp"
 #include "mesh/LagrangeP1/Triag2D.hpp"
+#include "mesh/LagrangeP1/Triag3D.hpp"
 #include "mesh/LagrangeP1/Quad2D.hpp"
+#include "mesh/LagrangeP1/Quad3D.hpp"
 
 #include "WallDistance.hpp"
 
@@ -46,61 +60,307 @@ common::ComponentBuilder < WallDistance, MeshTransformer, mesh::actions::LibActi
 namespace detail
 {
 
+/// Geometry of the wall faces, stored independently of the mesh dictionaries so the faces of other processes can be added
+struct WallSurface
+{
+  WallSurface(const Uint dimension) :
+    dim(dimension),
+    face_offsets(1, 0u)
+  {
+  }
+
+  /// Add the faces of the given elements. wall_node_map maps each mesh node to its wall node index, or uint_max if it is not on the wall
+  void add_faces(const Elements& elements, const Field& coordinates, const common::List<Uint>& glb_idx, std::vector<Uint>& wall_node_map)
+  {
+    const ElementType& etype = elements.element_type();
+    const Uint element_nb_nodes = etype.nb_nodes();
+    // We consider lines, triangles and quads as viable surface elements
+    if(element_nb_nodes < 2 || element_nb_nodes > 4 || etype.order() != 1)
+    {
+      throw common::SetupError(FromHere(), "Unsupported surface element of type " + etype.name() + " in surface region " + elements.uri().path());
+    }
+
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+    BOOST_FOREACH(const Connectivity::ConstRow conn_row, connectivity.array())
+    {
+      BOOST_FOREACH(const Uint node_idx, conn_row)
+      {
+        Uint& wall_node = wall_node_map[node_idx];
+        if(wall_node == math::Consts::uint_max())
+        {
+          wall_node = nb_nodes();
+          coords.insert(coords.end(), coordinates[node_idx].begin(), coordinates[node_idx].end());
+          node_glb_idx.push_back(glb_idx[node_idx]);
+        }
+        face_nodes.push_back(wall_node);
+      }
+      face_offsets.push_back(face_nodes.size());
+    }
+  }
+
+  /// Append the wall faces of all other processes. Local wall node indices remain unchanged.
+  /// Nodes that are shared between processes are identified by their global index and stored only once,
+  /// so the faces around a node on a partition boundary are all connected to the same wall node.
+  void gather()
+  {
+    common::PE::Comm& comm = common::PE::Comm::instance();
+    if(!comm.is_active() || comm.size() == 1)
+      return;
+
+    std::vector<Uint> face_sizes(nb_faces());
+    for(Uint i = 0; i != nb_faces(); ++i)
+      face_sizes[i] = face_offsets[i+1] - face_offsets[i];
+
+    std::vector< std::vector<Real> > all_coords;
+    std::vector< std::vector<Uint> > all_glb_idx;
+    std::vector< std::vector<Uint> > all_face_sizes;
+    std::vector< std::vector<Uint> > all_face_nodes;
+    comm.all_gather(coords, all_coords);
+    comm.all_gather(node_glb_idx, all_glb_idx);
+    comm.all_gather(face_sizes, all_face_sizes);
+    comm.all_gather(face_nodes, all_face_nodes);
+
+    std::map<Uint, Uint> glb_to_wall_node;
+    for(Uint i = 0; i != nb_nodes(); ++i)
+      glb_to_wall_node.insert(std::make_pair(node_glb_idx[i], i));
+
+    for(Uint rank = 0; rank != comm.size(); ++rank)
+    {
+      if(rank == comm.rank())
+        continue;
+
+      // Wall node index for each node received from rank, adding the nodes that are not known yet
+      const Uint rank_nb_nodes = all_glb_idx[rank].size();
+      cf3_assert(all_coords[rank].size() == rank_nb_nodes*dim);
+      std::vector<Uint> rank_wall_nodes(rank_nb_nodes);
+      for(Uint i = 0; i != rank_nb_nodes; ++i)
+      {
+        const std::pair<std::map<Uint, Uint>::iterator, bool> inserted = glb_to_wall_node.insert(std::make_pair(all_glb_idx[rank][i], nb_nodes()));
+        if(inserted.second)
+        {
+          coords.insert(coords.end(), all_coords[rank].begin() + i*dim, all_coords[rank].begin() + (i+1)*dim);
+          node_glb_idx.push_back(all_glb_idx[rank][i]);
+        }
+        rank_wall_nodes[i] = inserted.first->second;
+      }
+
+      BOOST_FOREACH(const Uint node_idx, all_face_nodes[rank])
+        face_nodes.push_back(rank_wall_nodes[node_idx]);
+      BOOST_FOREACH(const Uint face_size, all_face_sizes[rank])
+        face_offsets.push_back(face_offsets.back() + face_size);
+    }
+  }
+
+  /// Build the connectivity from each wall node to its adjacent faces
+  void build_node_faces()
+  {
+    node_face_offsets.assign(nb_nodes()+1, 0u);
+    BOOST_FOREACH(const Uint node_idx, face_nodes)
+      ++node_face_offsets[node_idx+1];
+    std::partial_sum(node_face_offsets.begin(), node_face_offsets.end(), node_face_offsets.begin());
+
+    node_faces.resize(face_nodes.size());
+    std::vector<Uint> fill_position(node_face_offsets.begin(), node_face_offsets.end()-1);
+    for(Uint face = 0; face != nb_faces(); ++face)
+    {
+      for(Uint i = face_offsets[face]; i != face_offsets[face+1]; ++i)
+        node_faces[fill_position[face_nodes[i]]++] = face;
+    }
+  }
+
+  Uint nb_nodes() const { return coords.size() / dim; }
+  Uint nb_faces() const { return face_offsets.size() - 1; }
+
+  /// Coordinates of a wall node
+  const Real* node_coords(const Uint node_idx) const { return &coords[node_idx*dim]; }
+
+  RealVector node_vector(const Uint node_idx) const
+  {
+    RealVector result(dim);
+    for(Uint i = 0; i != dim; ++i)
+      result[i] = coords[node_idx*dim + i];
+    return result;
+  }
+
+  /// Dimension of the coordinates
+  Uint dim;
+  /// Coordinates of the wall nodes, dim values per node
+  std::vector<Real> coords;
+  /// Global index of each wall node
+  std::vector<Uint> node_glb_idx;
+  /// Start of each face in face_nodes, with one extra entry marking the end
+  std::vector<Uint> face_offsets;
+  /// Wall node indices for each face
+  std::vector<Uint> face_nodes;
+  /// Start of the faces of each wall node in node_faces, with one extra entry marking the end
+  std::vector<Uint> node_face_offsets;
+  /// Faces adjacent to each wall node
+  std::vector<Uint> node_faces;
+};
+
+/// Balanced k-d tree over the wall nodes, to find the wall node closest to a given point
+class WallNodeTree
+{
+public:
+  WallNodeTree(const WallSurface& surface) :
+    m_surface(surface),
+    m_nodes(surface.nb_nodes()),
+    m_split_dims(surface.nb_nodes(), 0u)
+  {
+    for(Uint i = 0; i != m_nodes.size(); ++i)
+      m_nodes[i] = i;
+    build(0, m_nodes.size());
+  }
+
+  /// Index of the wall node that is closest to the given point
+  Uint closest_node(const RealVector& point) const
+  {
+    cf3_assert(!m_nodes.empty());
+    Uint closest = m_nodes.front();
+    Real shortest_distance = std::numeric_limits<Real>::max();
+    search(0, m_nodes.size(), point, closest, shortest_distance);
+    return closest;
+  }
+
+private:
+  /// Order wall nodes according to one of their coordinates
+  struct CoordinateLess
+  {
+    CoordinateLess(const WallSurface& surface, const Uint dim) : m_surface(surface), m_dim(dim) {}
+    bool operator()(const Uint a, const Uint b) const { return m_surface.node_coords(a)[m_dim] < m_surface.node_coords(b)[m_dim]; }
+    const WallSurface& m_surface;
+    const Uint m_dim;
+  };
+
+  // The middle node of each range splits the range along the direction with the largest extent
+  void build(const Uint begin, const Uint end)
+  {
+    if(end - begin < 2)
+      return;
+
+    const Uint dim = m_surface.dim;
+    RealVector min_coord = RealVector::Constant(dim, std::numeric_limits<Real>::max());
+    RealVector max_coord = RealVector::Constant(dim, -std::numeric_limits<Real>::max());
+    for(Uint i = begin; i != end; ++i)
+    {
+      const Real* coords = m_surface.node_coords(m_nodes[i]);
+      for(Uint j = 0; j != dim; ++j)
+      {
+        min_coord[j] = std::min(min_coord[j], coords[j]);
+        max_coord[j] = std::max(max_coord[j], coords[j]);
+      }
+    }
+    int split_dim;
+    (max_coord - min_coord).maxCoeff(&split_dim);
+
+    const Uint mid = begin + (end - begin) / 2;
+    std::nth_element(m_nodes.begin() + begin, m_nodes.begin() + mid, m_nodes.begin() + end, CoordinateLess(m_surface, split_dim));
+    m_split_dims[mid] = split_dim;
+
+    build(begin, mid);
+    build(mid+1, end);
+  }
+
+  void search(const Uint begin, const Uint end, const RealVector& point, Uint& closest, Real& shortest_distance) const
+  {
+    if(begin >= end)
+      return;
+
+    const Uint mid = begin + (end - begin) / 2;
+    const Uint node_idx = m_nodes[mid];
+    const Real* coords = m_surface.node_coords(node_idx);
+    Real d2 = 0.;
+    for(Uint i = 0; i != m_surface.dim; ++i)
+      d2 += (point[i] - coords[i]) * (point[i] - coords[i]);
+    if(d2 < shortest_distance)
+    {
+      shortest_distance = d2;
+      closest = node_idx;
+    }
+
+    // Visit the side containing the point first, and the other side only if it can contain a closer node
+    const Uint split_dim = m_split_dims[mid];
+    const Real split_distance = point[split_dim] - coords[split_dim];
+    if(split_distance < 0.)
+    {
+      search(begin, mid, point, closest, shortest_distance);
+      if(split_distance*split_distance < shortest_distance)
+        search(mid+1, end, point, closest, shortest_distance);
+    }
+    else
+    {
+      search(mid+1, end, point, closest, shortest_distance);
+      if(split_distance*split_distance < shortest_distance)
+        search(begin, mid, point, closest, shortest_distance);
+    }
+  }
+
+  const WallSurface& m_surface;
+  /// Wall node indices, ordered as an implicit tree
+  std::vector<Uint> m_nodes;
+  /// Split direction for the node at each position in m_nodes
+  std::vector<Uint> m_split_dims;
+};
+
+/// Unit normal of a wall face, using the element type of the face
+template<typename ETYPE>
+RealVector face_normal(const RealMatrix& elem_coords)
+{
+  const typename ETYPE::NodesT nodes = elem_coords;
+  typename ETYPE::CoordsT normal;
+  ETYPE::compute_normal(nodes, normal);
+  return normal / normal.norm();
+}
+
 /// Helper struct to handle projection to the wall near a given surface node
 struct WallProjection
 {
-  WallProjection(const Field& coordinates, const CNodeConnectivity& node_connectivity) :
-    m_coords(coordinates),
-    m_node_connectivity(node_connectivity)
+  WallProjection(const WallSurface& surface) :
+    m_surface(surface)
   {
   }
 
-  // Get the wall distance for an inner node, looking at the elements that are adjacent to the given surface node
-  Real operator()(const Uint inner_node_idx, const Uint surface_node_idx)
+  // Get the wall distance for an inner node, looking at the faces that are adjacent to the given surface node
+  Real operator()(const RealVector& inner_coord, const Uint surface_node_idx) const
   {
     RealMatrix elem_coords;
-    const Uint dim = m_coords.row_size();
-    const RealVector inner_coord = to_vector(m_coords[inner_node_idx]);
+    const Uint dim = m_surface.dim;
     std::vector<Uint> neighbor_nodes; // Collect neighboring nodes, so we can project onto a sharp corner in 3D if needed (i.e. near a step)
-    // Loop over all surface elements around the given node
-    BOOST_FOREACH(const Uint elem_idx, m_node_connectivity.node_element_range(surface_node_idx))
+    // Loop over all surface faces around the given node
+    for(Uint face_i = m_surface.node_face_offsets[surface_node_idx]; face_i != m_surface.node_face_offsets[surface_node_idx+1]; ++face_i)
     {
-      // Get the element coordinates
-      const CNodeConnectivity::ElementReferenceT element_ref = m_node_connectivity.element(elem_idx);
-      const ElementType& etype = element_ref.first->element_type();
-      const Uint element_nb_nodes = etype.nb_nodes();
+      // Get the face coordinates
+      const Uint face = m_surface.node_faces[face_i];
+      const Uint element_nb_nodes = m_surface.face_offsets[face+1] - m_surface.face_offsets[face];
+      const Uint* conn_row = &m_surface.face_nodes[m_surface.face_offsets[face]];
       elem_coords.resize(element_nb_nodes, dim);
-      const Connectivity::ConstRow conn_row = element_ref.first->geometry_space().connectivity()[element_ref.second];
-      fill(elem_coords, m_coords, conn_row);
+      for(Uint i = 0; i != element_nb_nodes; ++i)
+        for(Uint j = 0; j != dim; ++j)
+          elem_coords(i, j) = m_surface.node_coords(conn_row[i])[j];
 
-      // We consider lines, triangles and quads as viable surface elements
-      if(element_nb_nodes < 2 || element_nb_nodes > 4 || etype.order() != 1)
-      {
-        throw common::SetupError(FromHere(), "Unsupported surface element of type " + etype.name() + " in surface region " + element_ref.first->uri().path());
-      }
-      
       bool in_element = false;
+      RealVector n; // normal vector
 
       if(element_nb_nodes == 2) // line segment
       {
         cf3_assert(dim == 2);
-        cf3_assert(etype.shape() == GeoShape::LINE);
         RealVector e1 = elem_coords.row(1) - elem_coords.row(0); // line segment vector
         Real e1_len = e1.norm();
         e1 /= e1_len;
         const Real projection = e1.dot(inner_coord - elem_coords.row(0).transpose());
         // If the projection of the node along the normal fits inside the element, we can take the normal distance
         in_element = projection > 0 && projection < e1_len;
+        if(in_element)
+          n = face_normal<LagrangeP1::Line2D>(elem_coords);
       }
       if(element_nb_nodes == 3)
       {
         cf3_assert(dim == 3);
-        cf3_assert(etype.shape() == GeoShape::TRIAG);
         RealVector3 e1 = (elem_coords.row(1) - elem_coords.row(0)).normalized();
         RealVector3 en = elem_coords.row(2) - elem_coords.row(0);
         RealVector3 e2 = (e1.cross(en)).cross(e1).normalized();
         RealVector3 p = inner_coord - elem_coords.row(0).transpose();
-        
+
         // Construct 2D coordinates for the boundary element
         Eigen::Matrix<Real, 3, 2> triag_coords_2d;
         triag_coords_2d.row(0).setZero();
@@ -108,13 +368,15 @@ struct WallProjection
         triag_coords_2d(1,1) = 0.;
         triag_coords_2d(2,0) = e1.dot(elem_coords.row(2) - elem_coords.row(0));
         triag_coords_2d(2,1) = e2.dot(elem_coords.row(2) - elem_coords.row(0));
-        
+
         RealVector2 p_proj(2);
         p_proj[0] = p.dot(e1);
         p_proj[1] = p.dot(e2);
-        
+
         in_element = LagrangeP1::Triag2D::is_coord_in_element(p_proj, triag_coords_2d);
-        const Uint origin_corner = std::find(conn_row.begin(), conn_row.end(), surface_node_idx) - conn_row.begin();
+        if(in_element)
+          n = face_normal<LagrangeP1::Triag3D>(elem_coords);
+        const Uint origin_corner = std::find(conn_row, conn_row + 3, surface_node_idx) - conn_row;
         if(origin_corner == 0)
         {
           neighbor_nodes.push_back(conn_row[1]);
@@ -134,7 +396,6 @@ struct WallProjection
       if(element_nb_nodes == 4)
       {
         cf3_assert(dim == 3);
-        cf3_assert(etype.shape() == GeoShape::QUAD);
         RealVector3 e1 = (elem_coords.row(1) - elem_coords.row(0)).normalized();
         RealVector3 en = elem_coords.row(3) - elem_coords.row(0);
         RealVector3 e2 = (e1.cross(en)).cross(e1).normalized();
@@ -154,7 +415,9 @@ struct WallProjection
         p_proj[1] = p.dot(e2);
 
         in_element = LagrangeP1::Quad2D::is_coord_in_element(p_proj, quad_coords_2d);
-        const Uint origin_corner = std::find(conn_row.begin(), conn_row.end(), surface_node_idx) - conn_row.begin();
+        if(in_element)
+          n = face_normal<LagrangeP1::Quad3D>(elem_coords);
+        const Uint origin_corner = std::find(conn_row, conn_row + 4, surface_node_idx) - conn_row;
         if(origin_corner == 0 || origin_corner == 2)
         {
           neighbor_nodes.push_back(conn_row[1]);
@@ -166,21 +429,19 @@ struct WallProjection
           neighbor_nodes.push_back(conn_row[2]);
         }
       }
-      
+
       // If the projection was in an element, we can just proceed to compute the normal distance
       if(in_element)
       {
-        RealVector n(dim); // normal vector
-        etype.compute_normal(elem_coords, n);
-        return fabs((n/n.norm()).dot(inner_coord - elem_coords.row(0).transpose()));
+        return fabs(n.dot(inner_coord - elem_coords.row(0).transpose()));
       }
     }
     // If we got here, no projections on the elements gave a result
     // First, verify the 3D case where we need to project on "step" edges
+    const RealVector surface_coord = m_surface.node_vector(surface_node_idx);
     BOOST_FOREACH(const Uint neighbor_node, neighbor_nodes)
     {
-      const RealVector surface_coord = to_vector(m_coords[surface_node_idx]);
-      const RealVector neighbor_coord = to_vector(m_coords[neighbor_node]);
+      const RealVector neighbor_coord = m_surface.node_vector(neighbor_node);
       RealVector e1 = neighbor_coord - surface_coord;
       Real e1_len = e1.norm();
       e1 /= e1_len;
@@ -190,74 +451,151 @@ struct WallProjection
         return (inner_coord - (surface_coord + e1*projection)).norm();
       }
     }
-    return (inner_coord - to_vector(m_coords[surface_node_idx])).norm();
+    return (inner_coord - surface_coord).norm();
+  }
+
+  const WallSurface& m_surface;
+};
+
+/// Computes the wall distance for a range of nodes
+struct WallDistanceComputer
+{
+  WallDistanceComputer(const Field& coordinates, const WallSurface& surface, const WallNodeTree& tree, const std::vector<Uint>& wall_node_map, Field& distance) :
+    m_coords(coordinates),
+    m_surface(surface),
+    m_tree(tree),
+    m_wall_node_map(wall_node_map),
+    m_distance(distance)
+  {
+  }
+
+  void operator()(const Uint begin, const Uint end) const
+  {
+    const WallProjection normal_distance(m_surface);
+    for(Uint node_idx = begin; node_idx != end; ++node_idx)
+    {
+      if(m_wall_node_map[node_idx] != math::Consts::uint_max())
+      {
+        m_distance[node_idx][0] = 0.;
+        continue;
+      }
+      const RealVector inner_coord = to_vector(m_coords[node_idx]);
+      m_distance[node_idx][0] = normal_distance(inner_coord, m_tree.closest_node(inner_coord));
+    }
+  }
+
+  /// Variant for use in a thread, storing the error message if an exception occurs
+  void run_threaded(const Uint begin, const Uint end, std::string& error) const
+  {
+    try
+    {
+      (*this)(begin, end);
+    }
+    catch(std::exception& e)
+    {
+      error = e.what();
+    }
   }
 
   const Field& m_coords;
-  const CNodeConnectivity& m_node_connectivity;
+  const WallSurface& m_surface;
+  const WallNodeTree& m_tree;
+  const std::vector<Uint>& m_wall_node_map;
+  Field& m_distance;
 };
+
 }
 
-WallDistance::WallDistance(const std::string& name) : MeshTransformer(name)
+WallDistance::WallDistance(const std::string& name) :
+  MeshTransformer(name),
+  m_nb_threads(1u),
+  m_distributed(false)
 {
   options().add("regions", m_regions)
       .pretty_name("Regions")
       .description("Regions that are to be considered as part of the wall")
       .link_to(&m_regions)
       .mark_basic();
+
+  options().add("nb_threads", m_nb_threads)
+      .pretty_name("Number of Threads")
+      .description("Number of threads used to compute the distances")
+      .link_to(&m_nb_threads);
+
+  options().add("distributed", m_distributed)
+      .pretty_name("Distributed")
+      .description("Gather the wall faces of all processes, so the distance to walls on other processes is taken into account without making the boundary global first")
+      .link_to(&m_distributed);
 }
 
 void WallDistance::execute()
 {
   Mesh& mesh = *m_mesh;
 
-  Field& d = mesh.geometry_fields().create_field("WallDistance", "wall_distance");
+  Handle<Field> existing_field(mesh.geometry_fields().get_child("WallDistance"));
+  Field& d = is_null(existing_field) ? mesh.geometry_fields().create_field("WallDistance", "wall_distance") : *existing_field;
   d.add_tag("wall_distance");
   const Field& coords = mesh.geometry_fields().coordinates();
   const Uint nb_nodes = coords.size();
 
-  boost::shared_ptr<CNodeConnectivity> node_connectivity = common::allocate_component<CNodeConnectivity>("NodeConnectivity");
-  std::vector< Handle<Entities const> > surface_entities;
+  detail::WallSurface surface(coords.row_size());
+  std::vector<Uint> wall_node_map(nb_nodes, math::Consts::uint_max());
   BOOST_FOREACH(const Handle<Region const>& region, m_regions)
   {
     BOOST_FOREACH(const mesh::Elements& elements, common::find_components_recursively_with_filter<mesh::Elements>(*region, IsElementsSurface()))
     {
-      surface_entities.push_back(elements.handle<Entities const>());
+      surface.add_faces(elements, coords, mesh.geometry_fields().glb_idx(), wall_node_map);
     }
   }
 
-  node_connectivity->initialize(nb_nodes, surface_entities);
+  // Processes without wall faces are allowed, as long as there is a wall somewhere
+  Uint nb_wall_faces = surface.nb_faces();
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  if(comm.is_active() && comm.size() > 1)
+  {
+    const Uint local_nb_wall_faces = nb_wall_faces;
+    comm.all_reduce(common::PE::plus(), &local_nb_wall_faces, 1, &nb_wall_faces);
+  }
+  if(nb_wall_faces == 0)
+    throw common::SetupError(FromHere(), "No wall faces found for " + uri().path());
 
-  boost::shared_ptr< common::List< Uint > > surface_nodes_ptr = build_used_nodes_list(surface_entities, mesh.geometry_fields(), true);
-  const common::List<Uint>& surface_nodes = *surface_nodes_ptr;
-  const Uint nb_surface_nodes = surface_nodes.size();
+  if(m_distributed)
+    surface.gather();
+
+  // Without the distributed option, processes that have no wall faces can't compute a distance
+  if(surface.nb_nodes() == 0)
+  {
+    CFwarn << "No local wall faces for " << uri().path() << " on process " << comm.rank() << ", set the distributed option or make the boundary global first" << CFendl;
+    std::fill(d.array().data(), d.array().data() + d.array().num_elements(), std::numeric_limits<Real>::max());
+    return;
+  }
 
-  detail::WallProjection normal_distance(coords, *node_connectivity);
+  surface.build_node_faces();
+  const detail::WallNodeTree tree(surface);
+  const detail::WallDistanceComputer compute_distance(coords, surface, tree, wall_node_map, d);
 
-  for(Uint inner_node_idx = 0; inner_node_idx != nb_nodes; ++inner_node_idx)
+  if(m_nb_threads < 2)
   {
-    bool is_surface_node = false;
-    Real shortest_distance = 1e20;
-    Uint closest_surface_node = 0;
-    for(Uint j = 0; j != nb_surface_nodes; ++j)
-    {
-      const Uint surface_node_idx = surface_nodes[j];
-      if(surface_node_idx == inner_node_idx)
-      {
-        is_surface_node = true;
-        break;
-      }
-      const Real d2 = (to_vector(coords[inner_node_idx]) - to_vector(coords[surface_node_idx])).squaredNorm();
-      if(d2 < shortest_distance)
-      {
-        shortest_distance = d2;
-        closest_surface_node = surface_node_idx;
-      }
-    }
+    compute_distance(0, nb_nodes);
+    return;
+  }
 
-    d[inner_node_idx][0] = is_surface_node ? 0. : normal_distance(inner_node_idx, closest_surface_node);
+  // Each thread handles a contiguous range of nodes
+  std::vector<std::string> errors(m_nb_threads);
+  boost::thread_group threads;
+  for(Uint i = 0; i != m_nb_threads; ++i)
+  {
+    const Uint begin = (nb_nodes * i) / m_nb_threads;
+    const Uint end = (nb_nodes * (i+1)) / m_nb_threads;
+    threads.create_thread(boost::bind(&detail::WallDistanceComputer::run_threaded, &compute_distance, begin, end, boost::ref(errors[i])));
   }
+  threads.join_all();
 
+  for(Uint i = 0; i != m_nb_threads; ++i)
+  {
+    if(!errors[i].empty())
+      throw common::ParallelError(FromHere(), "Error computing wall distance in thread " + common::to_str(i) + ": " + errors[i]);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////
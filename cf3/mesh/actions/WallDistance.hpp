@@ -22,6 +22,10 @@ namespace actions {
 
 //////////////////////////////////////////////////////////////////////////////
 
+/// Computes the distance from each node to the closest wall face.
+/// The closest wall node is found using a k-d tree, after which the distance is projected onto the faces around that node.
+/// With the distributed option, the wall faces of all processes are gathered first, merging the nodes shared between processes
+/// by global index. Without it, processes that have no wall faces of their own get the largest Real as distance.
 class WallDistance : public MeshTransformer
 {
 public:
@@ -32,6 +36,12 @@ public:
 private:
   /// Wall regions to operate over
   std::vector< Handle<Region> > m_regions;
+
+  /// Number of threads used to compute the distances
+  Uint m_nb_threads;
+
+  /// True if the wall faces of all processes are gathered
+  bool m_distributed;
 };
 
 
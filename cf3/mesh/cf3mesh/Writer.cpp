@@ -158,7 +158,13 @@ namespace detail
 Writer::Writer( const std::string& name )
 : MeshWriter(name)
 {
+  options().add("shared_file", false)
+    .pretty_name("Shared File")
+    .description("Write the binary data of all ranks into a single file, using MPI-IO");
 
+  options().add("compress", true)
+    .pretty_name("Compress")
+    .description("Compress the binary data");
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -181,6 +187,8 @@ void Writer::write()
   // Writer for the arrays
   boost::shared_ptr<common::BinaryDataWriter> data_writer = common::allocate_component<common::BinaryDataWriter>("DataWriter");
   const common::URI binfile = m_file_path.base_path() / (m_file_path.base_name() + ".cfbinxml");
+  data_writer->options().set("shared_file", options().value<bool>("shared_file"));
+  data_writer->options().set("compress", options().value<bool>("compress"));
   data_writer->options().set("file", binfile);
   
   common::XML::XmlDoc xml_doc("1.0", "ISO-8859-1");
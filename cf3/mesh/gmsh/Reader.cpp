@@ -4,6 +4,10 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 #include <boost/foreach.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/regex.hpp>
@@ -18,7 +22,7 @@
 #include "common/StringConversion.hpp"
 #include "common/Table.hpp"
 #include "common/List.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 
 #include "common/PE/debug.hpp"
 
@@ -97,6 +101,145 @@ std::vector<std::string> Reader::get_extensions()
 
 //////////////////////////////////////////////////////////////////////////////
 
+namespace detail {
+
+/// Tokenizer over the memory-mapped contents of a gmsh file.
+/// It avoids the locale and sentry overhead of iostream extraction,
+/// which dominates the reading time of large meshes.
+class MshTokenizer
+{
+public:
+  MshTokenizer(const char* data, const std::size_t size, const std::size_t pos=0) :
+    m_begin(data),
+    m_end(data+size),
+    m_cur(data+pos)
+  {}
+
+  bool eof() const { return m_cur >= m_end; }
+
+  std::size_t pos() const { return m_cur - m_begin; }
+
+  /// True if the next character is c
+  bool at(const char c) const { return m_cur != m_end && *m_cur == c; }
+
+  void skip_whitespace()
+  {
+    while(m_cur != m_end && is_space(*m_cur))
+      ++m_cur;
+  }
+
+  /// Skip to the start of the next line
+  void skip_line()
+  {
+    const char* newline = static_cast<const char*>(memchr(m_cur, '\n', m_end-m_cur));
+    m_cur = newline ? newline+1 : m_end;
+  }
+
+  /// Read until the end of the line, stripping trailing whitespace
+  std::string read_line()
+  {
+    const char* line_begin = m_cur;
+    skip_line();
+    const char* line_end = m_cur;
+    while(line_end != line_begin && is_space(*(line_end-1)))
+      --line_end;
+    return std::string(line_begin, line_end);
+  }
+
+  std::string read_word()
+  {
+    skip_whitespace();
+    const char* word_begin = m_cur;
+    while(m_cur != m_end && !is_space(*m_cur))
+      ++m_cur;
+    return std::string(word_begin, m_cur);
+  }
+
+  Uint read_uint()
+  {
+    skip_whitespace();
+    if(m_cur == m_end || !is_digit(*m_cur))
+      throw ParsingFailed(FromHere(), "Expected an unsigned integer at byte " + to_str(pos()));
+    Uint result = 0;
+    while(m_cur != m_end && is_digit(*m_cur))
+      result = 10*result + (*m_cur++ - '0');
+    return result;
+  }
+
+  /// Read a signed integer, as used for element tags. Partition tags of ghost elements are negative.
+  int read_int()
+  {
+    skip_whitespace();
+    const bool negative = m_cur != m_end && *m_cur == '-';
+    if(negative)
+      ++m_cur;
+    if(m_cur == m_end || !is_digit(*m_cur))
+      throw ParsingFailed(FromHere(), "Expected an integer at byte " + to_str(pos()));
+    int result = 0;
+    while(m_cur != m_end && is_digit(*m_cur))
+      result = 10*result + (*m_cur++ - '0');
+    return negative ? -result : result;
+  }
+
+  /// Skip the next whitespace-delimited token without interpreting it
+  void skip_word()
+  {
+    skip_whitespace();
+    while(m_cur != m_end && !is_space(*m_cur))
+      ++m_cur;
+  }
+
+  Real read_real()
+  {
+    skip_whitespace();
+    // strtod needs a terminated string, which the mapped file does not guarantee
+    char token[64];
+    Uint len = 0;
+    while(m_cur != m_end && !is_space(*m_cur) && len != 63)
+      token[len++] = *m_cur++;
+    token[len] = '\0';
+    char* token_end;
+    const Real result = std::strtod(token, &token_end);
+    if(token_end == token)
+      throw ParsingFailed(FromHere(), "Expected a real number at byte " + to_str(pos()));
+    return result;
+  }
+
+  /// Read a value stored in binary format, in the byte order of this machine
+  template<typename T>
+  T read_binary()
+  {
+    if(m_cur + sizeof(T) > m_end)
+      throw ParsingFailed(FromHere(), "Unexpected end of file at byte " + to_str(pos()));
+    T result;
+    memcpy(&result, m_cur, sizeof(T));
+    m_cur += sizeof(T);
+    return result;
+  }
+
+  void skip_bytes(const std::size_t nb_bytes)
+  {
+    if(m_cur + nb_bytes > m_end)
+      throw ParsingFailed(FromHere(), "Unexpected end of file at byte " + to_str(pos()));
+    m_cur += nb_bytes;
+  }
+
+private:
+  static bool is_space(const char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+  static bool is_digit(const char c) { return c >= '0' && c <= '9'; }
+
+  const char* m_begin;
+  const char* m_end;
+  const char* m_cur;
+};
+
+/// Size in bytes of one binary node record: node number and 3 coordinates
+const std::size_t binary_node_size = sizeof(int) + 3*sizeof(double);
+
+} // detail
+
+//////////////////////////////////////////////////////////////////////////////
+
 void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
 {
 
@@ -105,7 +248,7 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
   if( boost::filesystem::exists(fp) )
   {
     CFinfo <<  "Opening file " <<  fp.string() << CFendl;
-    m_file.open(fp,std::ios_base::in); // exists so open it
+    m_mapped_file.open(fp.string());
   }
   else // doesnt exist so throw exception
   {
@@ -135,22 +278,32 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
 
   if (options().value<bool>("read_fields"))
   {
-    read_element_node_data();
-    read_node_data();
+    const bool has_fields = !m_element_node_data_positions.empty() || !m_node_data_positions.empty();
+    if (has_fields && m_binary)
+    {
+      CFwarn << "Skipping the fields in binary gmsh file " << fp.string() << ": only ASCII data sections are supported" << CFendl;
+    }
+    else if (has_fields)
+    {
+      // The data sections are still read through a stream
+      m_file.open(fp,std::ios_base::in);
+      read_element_node_data();
+      read_node_data();
+      m_file.close();
+    }
   }
 
   m_node_idx_gmsh_to_cf.clear();
   m_elem_idx_gmsh_to_cf.clear();
 
   // clean-up
-  m_ghost_nodes.clear();
   m_used_nodes.clear();
-  m_node_idx_gmsh_to_cf.clear();
+  m_owned_elements = ElementRecords();
   if (is_not_null(m_hash))
     remove_component(*m_hash);
 
   // close the file
-  m_file.close();
+  m_mapped_file.close();
 
   mesh.raise_mesh_loaded();
 }
@@ -159,43 +312,59 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
 
 void Reader::get_file_positions()
 {
-  std::string region_names("$PhysicalNames");
-  std::string nodes("$Nodes");
-  std::string elements("$Elements");
-  std::string element_data("$ElementData");
-  std::string node_data("$NodeData");
-  std::string element_node_data("$ElementNodeData");
+  detail::MshTokenizer tokenizer(m_mapped_file.data(), m_mapped_file.size());
 
   m_element_data_positions.clear();
   m_node_data_positions.clear();
   m_element_node_data_positions.clear();
-  m_elements_position=0;
-  std::streampos p;
-  std::string line;
-  while (!m_file.eof())
+  m_owned_elements = ElementRecords();
+  m_owned_elements.node_offsets.push_back(0);
+  m_binary = false;
+  bool found_elements = false;
+  while (!tokenizer.eof())
   {
-    p = m_file.tellg();
-    getline(m_file,line);
-    if (line.find(region_names)!=std::string::npos) {
-      m_region_names_position=p;
-      m_file >> m_nb_regions;
+    const std::size_t p = tokenizer.pos();
+    // Only section keywords are of interest here, skip all other lines without copying them
+    if (!tokenizer.at('$'))
+    {
+      tokenizer.skip_line();
+      continue;
+    }
+    const std::string line = tokenizer.read_line();
+    if (line == "$MeshFormat")
+    {
+      const Real version = tokenizer.read_real();
+      const Uint file_type = tokenizer.read_uint();
+      const Uint data_size = tokenizer.read_uint();
+      tokenizer.skip_line();
+      if (version >= 3.)
+        throw ParsingFailed(FromHere(),"MSH format version "+to_str(version)+" is not supported. Save the mesh in version 2.2 (e.g. gmsh -format msh22)");
+      m_binary = (file_type == 1);
+      if (m_binary)
+      {
+        if (data_size != sizeof(double))
+          throw FileFormatError(FromHere(),"Binary gmsh files must store reals with "+to_str(sizeof(double))+" bytes, not "+to_str(data_size));
+        if (tokenizer.read_binary<int>() != 1)
+          throw FileFormatError(FromHere(),"Binary gmsh file was written with a different byte order");
+        tokenizer.skip_line();
+      }
+    }
+    else if (line == "$PhysicalNames") {
+      m_nb_regions = tokenizer.read_uint();
       m_region_list.resize(m_nb_regions);
 
       m_nb_gmsh_elem_in_region.resize(m_nb_regions);
       for(Uint ir = 0; ir < m_nb_regions; ++ir)
       {
-        m_nb_gmsh_elem_in_region[ir].resize(Shared::nb_gmsh_types);
-        for(Uint type = 0; type < Shared::nb_gmsh_types; ++ type)
-           (m_nb_gmsh_elem_in_region[ir])[type] = 0;
+        m_nb_gmsh_elem_in_region[ir].assign(Shared::nb_gmsh_types, 0u);
       }
 
       m_mesh_dimension = options().value<Uint>("dimension");
       for(Uint ir = 0; ir < m_nb_regions; ++ir)
       {
-        Uint phys_group_dimensionality;
-        Uint phys_group_index;
-        std::string phys_group_name;
-        m_file >> phys_group_dimensionality >> phys_group_index >> phys_group_name;
+        const Uint phys_group_dimensionality = tokenizer.read_uint();
+        const Uint phys_group_index = tokenizer.read_uint();
+        const std::string phys_group_name = tokenizer.read_word();
         m_region_list[phys_group_index-1].dim=phys_group_dimensionality;
         m_region_list[phys_group_index-1].index=phys_group_index;
         //The original name of the region in the mesh file has quotes, we want to strip them off
@@ -203,17 +372,24 @@ void Reader::get_file_positions()
         m_region_list[phys_group_index-1].region = create_region(m_region_list[phys_group_index-1].name);
         m_mesh_dimension = std::max(m_region_list[phys_group_index-1].dim,m_mesh_dimension);
       }
+      tokenizer.skip_line();
     }
-    else if (line.find(nodes)!=std::string::npos) {
-      m_coordinates_position=p;
-      m_file >> m_total_nb_nodes;
+    else if (line == "$Nodes") {
+      m_total_nb_nodes = tokenizer.read_uint();
+      tokenizer.skip_line();
 //      CFinfo << "The total number of nodes is " << m_total_nb_nodes << CFendl;
       if (m_total_nb_nodes == 0) throw ParsingFailed(FromHere(),"File contains no nodes");
+      m_coordinates_position = tokenizer.pos();
+      // ASCII node lines are skipped by the section search
+      if (m_binary)
+        tokenizer.skip_bytes(m_total_nb_nodes*detail::binary_node_size);
     }
-    else if (line.find(elements)!=std::string::npos)
+    else if (line == "$Elements")
     {
-      m_elements_position = p;
-      m_file >> m_total_nb_elements;
+      found_elements = true;
+      m_total_nb_elements = tokenizer.read_uint();
+      tokenizer.skip_line();
+      m_elements_position = tokenizer.pos();
 //      CFinfo << "The total number of elements is " << m_total_nb_elements << CFendl;
       if (m_total_nb_elements == 0) throw ParsingFailed(FromHere(),"File contains no elements");
       //Create a hash
@@ -224,42 +400,102 @@ void Reader::get_file_positions()
       m_hash->options().set("nb_parts",options().value<Uint>("nb_parts"));
       m_hash->options().set("nb_obj",num_obj);
 
-
-      Uint elem_idx, elem_type, nb_tags, phys_tag;
-
-      //Let's count how many elements of each type are present
+      // This rank owns a contiguous slice of the elements. Only those are stored,
+      // for all others only the type and physical group are needed.
+      const ParallelDistribution& elem_hash = m_hash->subhash(ELEMS);
+      const Uint owned_begin = elem_hash.start_idx_in_proc(PE::Comm::instance().rank());
+      const Uint owned_end = elem_hash.end_idx_in_proc(PE::Comm::instance().rank());
+      m_owned_elements.number.reserve(owned_end-owned_begin);
+      m_owned_elements.type.reserve(owned_end-owned_begin);
+      m_owned_elements.region.reserve(owned_end-owned_begin);
+      m_owned_elements.node_offsets.reserve(owned_end-owned_begin+1);
+
+      Uint elem_type(0), nb_tags(0), nb_in_block(0);
       for(Uint ie = 0; ie < m_total_nb_elements; ++ie)
       {
-          m_file >> elem_idx;
-          m_file >> elem_type;
-          m_file >> nb_tags;
-          m_file >> phys_tag;
-          cf3_assert(phys_tag > 0);
-          getline(m_file,line);
-          if (m_hash->subhash(ELEMS).owns(ie))
-            (m_nb_gmsh_elem_in_region[phys_tag-1])[elem_type]++;
-          m_region_list[phys_tag-1].element_types.insert(elem_type);
+        Uint elem_number;
+        if (m_binary)
+        {
+          // binary elements are grouped in blocks of the same type and number of tags
+          if (nb_in_block == 0)
+          {
+            elem_type = tokenizer.read_binary<int>();
+            nb_in_block = tokenizer.read_binary<int>();
+            nb_tags = tokenizer.read_binary<int>();
+          }
+          --nb_in_block;
+          elem_number = tokenizer.read_binary<int>();
+        }
+        else
+        {
+          elem_number = tokenizer.read_uint();
+          elem_type = tokenizer.read_uint();
+          nb_tags = tokenizer.read_uint();
+        }
+
+        if (elem_type >= Shared::nb_gmsh_types)
+          throw ParsingFailed(FromHere(),"Element "+to_str(elem_number)+" has unknown gmsh type "+to_str(elem_type));
+        if (nb_tags == 0)
+          throw ParsingFailed(FromHere(),"Element "+to_str(elem_number)+" has no physical group");
+        const Uint nb_elem_nodes = Shared::m_nodes_in_gmsh_elem[elem_type];
+
+        const int phys_tag_read = m_binary ? tokenizer.read_binary<int>() : tokenizer.read_int();
+        if (phys_tag_read <= 0 || static_cast<Uint>(phys_tag_read) > m_region_list.size())
+          throw ParsingFailed(FromHere(),"Element "+to_str(elem_number)+" has invalid physical group "+to_str(phys_tag_read));
+        const Uint phys_tag = phys_tag_read;
+        m_region_list[phys_tag-1].element_types.insert(elem_type);
+
+        if (ie >= owned_begin && ie < owned_end)
+        {
+          (m_nb_gmsh_elem_in_region[phys_tag-1])[elem_type]++;
+          m_owned_elements.number.push_back(elem_number);
+          m_owned_elements.type.push_back(elem_type);
+          m_owned_elements.region.push_back(phys_tag-1);
+          if (m_binary)
+          {
+            tokenizer.skip_bytes((nb_tags-1)*sizeof(int));
+            for (Uint j=0; j<nb_elem_nodes; ++j)
+              m_owned_elements.nodes.push_back(tokenizer.read_binary<int>());
+          }
+          else
+          {
+            // elementary entity and partition tags are not used, and partition tags may be negative
+            for(Uint itag = 0; itag < (nb_tags-1); ++itag)
+              tokenizer.skip_word();
+            for (Uint j=0; j<nb_elem_nodes; ++j)
+              m_owned_elements.nodes.push_back(tokenizer.read_uint());
+            tokenizer.skip_line();
+          }
+          m_owned_elements.node_offsets.push_back(m_owned_elements.nodes.size());
+        }
+        else if (m_binary)
+        {
+          tokenizer.skip_bytes((nb_tags-1+nb_elem_nodes)*sizeof(int));
+        }
+        else
+        {
+          tokenizer.skip_line();
+        }
       }
     }
-    else if (line.find(element_data)!=std::string::npos)
+    else if (line == "$ElementData")
     {
-      m_element_data_positions.push_back(p);
+      m_element_data_positions.push_back(std::streampos(static_cast<std::streamoff>(p)));
     }
-    else if (line.find(node_data)!=std::string::npos)
+    else if (line == "$NodeData")
     {
-      m_node_data_positions.push_back(p);
+      m_node_data_positions.push_back(std::streampos(static_cast<std::streamoff>(p)));
     }
-    else if (line.find(element_node_data)!=std::string::npos)
+    else if (line == "$ElementNodeData")
     {
-      m_element_node_data_positions.push_back(p);
+      m_element_node_data_positions.push_back(std::streampos(static_cast<std::streamoff>(p)));
     }
 
   }
-  if (m_elements_position==0)
+  if (!found_elements)
   {
     throw ParsingFailed(FromHere(),"File does not contain any elements");
   }
-  m_file.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -285,215 +521,66 @@ Handle< Region > Reader::create_region(std::string const& relative_path)
 
 void Reader::find_used_nodes()
 {
-  m_used_nodes.clear();
-  std::string line;
-
-  m_file.seekg(m_elements_position,std::ios::beg);
-  // skip next line
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "header = " << line << std::endl;
-  //Skip the line containing the actual number of elements
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "nb_elems = " << line << std::endl;
-
-  // read every line and store the connectivity in the correct region through the buffer
-  Uint elementNumber, elementType, nbElementNodes;
-  Uint gmsh_node_number, nb_tags, phys_tag, other_tag;
-
-  std::set<Uint>::iterator it=m_used_nodes.begin();
-
-//  if (PE::Comm::instance().rank()==IO_rank)
-//  {
-//    std::cout << "nb_obj = "   << m_hash->subhash(ELEMS).options()["nb_obj"].value<Uint>() << std::endl;
-//    std::cout << "nb_parts = " <<m_hash->subhash(ELEMS).options()["nb_parts"].value<Uint>() << std::endl;
-//  }
-  for (Uint i=0; i<m_total_nb_elements; ++i)
-  {
-//    if (m_total_nb_elements > 100000)
-//    {
-//      if(i%(m_total_nb_elements/20)==0)
-//        CFinfo << 100*i/m_total_nb_elements << "% " << CFflush;
-//    }
-
-    cf3_assert(m_hash);
-    if (m_hash->subhash(ELEMS).owns(i))
-    {
-      // element description
-      m_file >> elementNumber >> elementType;
-      nbElementNodes = Shared::m_nodes_in_gmsh_elem[elementType];
-
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << i << ":  elem["<<m_hash->subhash(ELEMS).part_of_obj(i)<<"] " << elementNumber << " :    ";
-      m_file >> nb_tags;
-      m_file >> phys_tag;
-      for(Uint itag = 0; itag < (nb_tags-1); ++itag)
-          m_file >> other_tag;
-
-      for (Uint j=0; j<nbElementNodes; ++j)
-      {
-        m_file >> gmsh_node_number;
-        it = m_used_nodes.insert(it,gmsh_node_number);
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << "  " << gmsh_node_number;
-      }
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << "\n";
-    }
-    getline(m_file,line); // finnish the line
-  }
-
-  // Now we have all nodes, used by the elements
-
-  // Now add owned nodes
-  m_file.seekg(m_coordinates_position,std::ios::beg);
-  //Skip the line with keyword '$Nodes':
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "header = " << line << std::endl;
-  // skip one line, which says how many (total) nodes are  present in the mesh
-  getline(m_file,line);
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << "nb_nodes = " << line << std::endl;
-
-  for (Uint node_idx=0; node_idx<m_total_nb_nodes; ++node_idx)
-  {
-//    if (m_total_nb_nodes > 100000)
-//    {
-//      if(node_idx%(m_total_nb_nodes/20)==0)
-//        CFinfo << 100*node_idx/m_total_nb_nodes << "% " << CFflush;
-//      if (node_idx == m_total_nb_nodes-1)
-//        CFinfo << CFendl;
-//    }
-    getline(m_file,line);
-
-    std::stringstream ss(line);
-    ss >> gmsh_node_number;
-    getline(ss,line);
-    if (m_hash->subhash(NODES).owns(node_idx))
-    {
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << "node " << gmsh_node_number << "\n";
-
-      it = m_used_nodes.insert(it,gmsh_node_number);
-    }
-    else
-    {
-      it = m_used_nodes.find(gmsh_node_number);
-      if (it != m_used_nodes.end())
-      {
-        m_ghost_nodes.insert(node_idx);
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << "ghostnode " << gmsh_node_number << "\n";
-      }
-    }
-  }
-//  if (PE::Comm::instance().rank()==IO_rank)
-//    std::cout << std::flush;
+  // The nodes of the owned elements were stored during the first pass.
+  // Owned nodes that are not used by any owned element are added in read_coordinates()
+  m_used_nodes = m_owned_elements.nodes;
+  std::sort(m_used_nodes.begin(), m_used_nodes.end());
+  m_used_nodes.erase(std::unique(m_used_nodes.begin(), m_used_nodes.end()), m_used_nodes.end());
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void Reader::read_coordinates()
 {
-
-  m_file.seekg(m_coordinates_position,std::ios::beg);
-
-  Dictionary& nodes = m_mesh->geometry_fields();
-  nodes.resize(m_used_nodes.size());
-  m_used_nodes.clear();
-
-  Uint part = options().value<Uint>("part");
-
-  std::string line;
-  //Skip the line with keyword '$Nodes':
-  getline(m_file,line);
-//  CFinfo << line << CFendl;
-  // skip one line, which says how many (total) nodes are  present in the mesh
-  getline(m_file,line);
-//  CFinfo << line << CFendl;
-
-
-  // declare and allocate one coordinate row
-//  std::vector<Real> rowVector(m_mesh_dimension);
-
-  std::set<Uint>::const_iterator it;
-
-  Uint coord_idx=0;
-  Uint gmsh_node_number;
-
+  detail::MshTokenizer tokenizer(m_mapped_file.data(), m_mapped_file.size(), m_coordinates_position);
+
+  const Uint part = options().value<Uint>("part");
+  const ParallelDistribution& node_hash = m_hash->subhash(NODES);
+  const Uint owned_begin = node_hash.start_idx_in_proc(PE::Comm::instance().rank());
+  const Uint owned_end = node_hash.end_idx_in_proc(PE::Comm::instance().rank());
+
+  // The number of ghost nodes is only known after this pass, so collect the nodes first
+  std::vector<Real> coordinates;
+  std::vector<Uint> glb_idx;
+  std::vector<Uint> rank;
+  coordinates.reserve(m_mesh_dimension*(owned_end-owned_begin));
+  glb_idx.reserve(owned_end-owned_begin);
+  rank.reserve(owned_end-owned_begin);
+
+  Real xyz[3];
   for (Uint node_idx=0; node_idx<m_total_nb_nodes; ++node_idx)
   {
-//    if (m_total_nb_nodes > 100000)
-//    {
-//      if(node_idx%(m_total_nb_nodes/20)==0)
-//        CFinfo << 100*node_idx/m_total_nb_nodes << "% " << CFflush;
-//      if(node_idx==m_total_nb_nodes-1)
-//        CFinfo << CFendl;
-//    }
-    getline(m_file,line);
-//    CFinfo << line << CFendl;
-    if (m_hash->subhash(NODES).owns(node_idx))
+    const bool owned = (node_idx >= owned_begin && node_idx < owned_end);
+    const Uint gmsh_node_number = m_binary ? tokenizer.read_binary<int>() : tokenizer.read_uint();
+    if (owned || std::binary_search(m_used_nodes.begin(), m_used_nodes.end(), gmsh_node_number))
     {
-      std::stringstream ss(line);
-      ss >> gmsh_node_number;
-      m_node_idx_gmsh_to_cf[gmsh_node_number]=coord_idx;
-
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << gmsh_node_number << " --> " << coord_idx << std::endl;
-
-      for (Uint dim=0; dim<m_mesh_dimension; ++dim)
-        ss >> nodes.coordinates()[coord_idx][dim];
-      if(m_mesh_dimension < DIM_3D) getline(ss,line); //Gmsh always stores 3 coordinates, even for 2D meshes
-
-      nodes.rank()[coord_idx] = part;
-      nodes.glb_idx()[coord_idx] = gmsh_node_number-1;
-
-      coord_idx++;
+      //Gmsh always stores 3 coordinates, even for 2D meshes
+      for (Uint dim=0; dim<DIM_3D; ++dim)
+        xyz[dim] = m_binary ? tokenizer.read_binary<double>() : tokenizer.read_real();
+
+      m_node_idx_gmsh_to_cf.insert(m_node_idx_gmsh_to_cf.end(), std::make_pair(gmsh_node_number, static_cast<Uint>(glb_idx.size())));
+      coordinates.insert(coordinates.end(), xyz, xyz+m_mesh_dimension);
+      glb_idx.push_back(gmsh_node_number-1);
+      rank.push_back(owned ? part : node_hash.part_of_obj(node_idx));
     }
-    else
+    else if (m_binary)
     {
-      it = m_ghost_nodes.find(node_idx);
-      if (it != m_ghost_nodes.end())
-      {
-        std::stringstream ss(line);
-        ss >> gmsh_node_number;
-        m_node_idx_gmsh_to_cf[gmsh_node_number]=coord_idx;
-
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << gmsh_node_number << " --> " << coord_idx << std::endl;
-
-        for (Uint dim=0; dim<m_mesh_dimension; ++dim)
-        ss >> nodes.coordinates()[coord_idx][dim];
-        if(m_mesh_dimension < DIM_3D) getline(ss, line);
-
-        nodes.rank()[coord_idx] = m_hash->subhash(NODES).part_of_obj(node_idx);
-        nodes.glb_idx()[coord_idx] = gmsh_node_number-1;
-
-        coord_idx++;
-      }
+      tokenizer.skip_bytes(3*sizeof(double));
     }
-
-
+    if (!m_binary)
+      tokenizer.skip_line();
   } //loop over nodes
 
-
-
-  /*
-  CFinfo << "Printing all nodal coordinates:" << CFendl;
-  for(Uint i = 0; i < m_total_nb_nodes; ++i)
+  Dictionary& nodes = m_mesh->geometry_fields();
+  nodes.resize(glb_idx.size());
+  for (Uint coord_idx=0; coord_idx<glb_idx.size(); ++coord_idx)
   {
-      CFinfo << "\t";
-      for(Uint dim = 0; dim < m_mesh_dimension; ++dim)
-        {
-            CFinfo << nodes.coordinates()[i][dim] << " ";
-        }
-      CFinfo << CFendl;
+    for (Uint dim=0; dim<m_mesh_dimension; ++dim)
+      nodes.coordinates()[coord_idx][dim] = coordinates[coord_idx*m_mesh_dimension+dim];
+    nodes.rank()[coord_idx] = rank[coord_idx];
+    nodes.glb_idx()[coord_idx] = glb_idx[coord_idx];
   }
-  */
-
-  getline(m_file,line);
+  m_used_nodes.clear();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -517,10 +604,6 @@ void Reader::read_connectivity()
 
  std::map<Uint, Entities*>::iterator elem_table_iter;
 
-// std::vector<std::map<std::string,Handle< Elements > > > elements(m_nb_regions);
-// std::vector<std::map<std::string,Handle< Connectivity::Buffer > > > buffer(m_nb_regions);
-
-
  m_elem_idx_gmsh_to_cf.clear();
  //Loop over all regions and allocate a connectivity table of proper size for each element type that
  //is present in each region. Counting of elements was done during the first pass in the function
@@ -530,10 +613,6 @@ void Reader::read_connectivity()
    // create new region
    Handle< Region > region = m_region_list[ir].region;
 
-//   elements[ir] = create_cells_in_region(*region,m_mesh->geometry_fields(),m_supported_types);
-//   buffer[ir] = create_connectivity_buffermap(elements[ir]);
-
-
    // Take the gmsh element types present in this region and generate new names of elements which correspond
    // to coolfuid naming:
    for(Uint etype = 0; etype < Shared::nb_gmsh_types; ++etype)
@@ -563,92 +642,38 @@ void Reader::read_connectivity()
    }
  }
 
-   std::string etype_CF;
-   std::set<Uint>::const_iterator it;
-   std::vector<Uint> cf_element;
-   Uint element_number, gmsh_element_type, nb_element_nodes;
-   Uint gmsh_node_number, nb_tags, phys_tag, other_tag;
-   Uint cf_node_number;
-   Uint cf_idx;
-
-   m_file.seekg(m_elements_position,std::ios::beg);
-   // skip next line
-   std::string line;
-   //Re-read the line that contains the keyword '$Elements':
-   getline(m_file,line);
-   //Parse the following line (containing the actual number of elements)
-   getline(m_file,line);
-
    for(Uint ir = 0; ir < m_nb_regions; ++ir)
      for(Uint etype = 0; etype < Shared::nb_gmsh_types; ++etype)
       (m_nb_gmsh_elem_in_region[ir])[etype] = 0;
 
-  for (Uint i=0; i<m_total_nb_elements; ++i)
+  // The owned elements were read during the first pass, so the file is not parsed again
+  const ElementRecords& records = m_owned_elements;
+  for (Uint i=0; i<records.number.size(); ++i)
   {
-//    if (m_total_nb_elements > 100000)
-//    {
-//      if(i%(m_total_nb_elements/20)==0)
-//        CFinfo << 100*i/m_total_nb_elements << "% " << CFflush;
-//      if(i==m_total_nb_elements-1)
-//        CFinfo << CFendl;
-//    }
-
-    // element description
-    m_file >> element_number >> gmsh_element_type;
-
-    nb_element_nodes = Shared::m_nodes_in_gmsh_elem[gmsh_element_type];
-
-    // get element nodes
-    if (m_hash->subhash(ELEMS).owns(i))
-    {
-      m_file >> nb_tags;
-      m_file >> phys_tag;
-      for(Uint itag = 0; itag < (nb_tags-1); ++itag)
-          m_file >> other_tag;
-
-//      CFinfo << "Reading element " << element_number << " of type " << gmsh_element_type;
-//      CFinfo << " in region " << phys_tag << " with " << nb_element_nodes << " nodes " << CFendl;
-
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << element_number << "   -->   ";
+    const Uint element_number = records.number[i];
+    const Uint gmsh_element_type = records.type[i];
+    const Uint region_idx = records.region[i];
+    const Uint nb_element_nodes = records.node_offsets[i+1] - records.node_offsets[i];
 
-      cf_element.resize(nb_element_nodes);
-      for (Uint j=0; j<nb_element_nodes; ++j)
-      {
-        cf_idx = Shared::m_nodes_gmsh_to_cf[gmsh_element_type][j];
-        m_file >> gmsh_node_number;
-        cf_node_number = m_node_idx_gmsh_to_cf[gmsh_node_number];
-        cf_element[cf_idx] = cf_node_number;
-//        if (PE::Comm::instance().rank()==IO_rank)
-//          std::cout << "  " << gmsh_node_number << "("<<m_node_idx_gmsh_to_cf[gmsh_node_number]<<")";
-      }
-//      if (PE::Comm::instance().rank()==IO_rank)
-//        std::cout << std::endl;
-
-      elem_table_iter = conn_table_idx[phys_tag-1].find(gmsh_element_type);
-      const Uint row_idx = (m_nb_gmsh_elem_in_region[phys_tag-1])[gmsh_element_type];
-
-      Handle< Elements > elements_region = Handle<Elements>(elem_table_iter->second->handle<Component>());
-      Connectivity::Row element_nodes = elements_region->geometry_space().connectivity()[row_idx];
-
-      m_elem_idx_gmsh_to_cf[element_number] = std::make_pair( elements_region , row_idx);
+    elem_table_iter = conn_table_idx[region_idx].find(gmsh_element_type);
+    const Uint row_idx = (m_nb_gmsh_elem_in_region[region_idx])[gmsh_element_type];
 
-      for(Uint node = 0; node < nb_element_nodes; ++node)
-      {
-         element_nodes[node] = cf_element[node];
-      }
-
-      elements_region->rank()[row_idx] = part;
-      elements_region->glb_idx()[row_idx] = element_number-1;
+    Handle< Elements > elements_region = Handle<Elements>(elem_table_iter->second->handle<Component>());
+    Connectivity::Row element_nodes = elements_region->geometry_space().connectivity()[row_idx];
 
-      (m_nb_gmsh_elem_in_region[phys_tag-1])[gmsh_element_type]++;
+    m_elem_idx_gmsh_to_cf.insert(m_elem_idx_gmsh_to_cf.end(), std::make_pair(element_number, std::make_pair( elements_region , row_idx)));
 
+    for (Uint j=0; j<nb_element_nodes; ++j)
+    {
+      const Uint gmsh_node_number = records.nodes[records.node_offsets[i]+j];
+      element_nodes[Shared::m_nodes_gmsh_to_cf[gmsh_element_type][j]] = m_node_idx_gmsh_to_cf[gmsh_node_number];
     }
 
-    // finish the line
-    getline(m_file,line);
+    elements_region->rank()[row_idx] = part;
+    elements_region->glb_idx()[row_idx] = element_number-1;
+
+    (m_nb_gmsh_elem_in_region[region_idx])[gmsh_element_type]++;
   }
-  getline(m_file,line);  // ENDOFSECTION
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -11,6 +11,7 @@
 
 #include <set>
 #include <boost/tuple/tuple.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 #include "mesh/MeshReader.hpp"
 
@@ -34,6 +35,10 @@ namespace gmsh {
 //////////////////////////////////////////////////////////////////////////////
 
 /// This class defines gmsh mesh format reader
+/// The mesh sections are parsed directly from a memory-mapped file, in the
+/// ASCII or binary variant of the MSH 2.2 format. Every rank only keeps the
+/// contiguous slice of elements and nodes it owns, plus the ghost nodes needed
+/// by its elements. Repartitioning is left to the LoadBalance mesh transformer.
 /// @author Willem Deconinck
 /// @author Martin Vymazal
 class gmsh_API Reader : public MeshReader, public Shared
@@ -79,6 +84,8 @@ private: // data
   std::map<Uint, Uint> m_node_idx_gmsh_to_cf;
 
   boost::filesystem::fstream m_file;
+  boost::iostreams::mapped_file_source m_mapped_file;
+  bool m_binary;
   Handle<Mesh> m_mesh;
   Handle<Region> m_region;
 
@@ -100,16 +107,25 @@ private: // data
 
   std::vector<RegionData> m_region_list;
 
-  std::set<Uint> m_ghost_nodes;
-  //std::set<Uint> m_ghost_elems;
-  std::set<Uint> m_used_nodes;
+  /// Sorted gmsh numbers of the nodes used by the owned elements
+  std::vector<Uint> m_used_nodes;
+
+  /// Owned elements, as read from the file during the first pass
+  struct ElementRecords
+  {
+    std::vector<Uint> number;
+    std::vector<Uint> type;
+    std::vector<Uint> region;
+    std::vector<Uint> node_offsets;
+    std::vector<Uint> nodes;
+  };
+  ElementRecords m_owned_elements;
   
   std::vector<std::set<Uint> > m_node_to_glb_elements;
 
   //Markers for important places in the file to be read
-  std::streampos m_region_names_position;
-  std::streampos m_coordinates_position;
-  std::streampos m_elements_position;
+  std::size_t m_coordinates_position; // start of the node records, in the mapped file
+  std::size_t m_elements_position;    // start of the element records, in the mapped file
   std::vector<std::streampos> m_element_data_positions;
   std::vector<std::streampos> m_node_data_positions;
   std::vector<std::streampos> m_element_node_data_positions;
@@ -15,7 +15,7 @@
 #include "common/Foreach.hpp"
 #include "common/StringConversion.hpp"
 #include "common/Tags.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/List.hpp"
 #include "common/PropertyList.hpp"
 
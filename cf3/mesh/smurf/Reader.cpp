@@ -17,7 +17,7 @@
 #include "common/StringConversion.hpp"
 #include "common/Table.hpp"
 #include "common/List.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 
 #include "common/PE/debug.hpp"
 
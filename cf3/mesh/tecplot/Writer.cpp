@@ -64,11 +64,47 @@ std::vector<std::string> Writer::get_extensions()
 
 /////////////////////////////////////////////////////////////////////////////
 
+void Writer::prepare_entities(const std::vector<Handle<Entities const> >& entities) const
+{
+  if (!options().value<bool>("cell_centred"))
+    return;
+
+  boost::lock_guard<boost::mutex> lock(m_cell_centres_mutex);
+  boost_foreach(const Handle<Entities const>& elements, entities)
+  {
+    const std::string shape_name = elements->element_type().shape_name();
+    if (m_cell_centres.count(shape_name))
+      continue;
+    boost::shared_ptr< ShapeFunction > P0_cell_centred = boost::dynamic_pointer_cast<ShapeFunction>(build_component("cf3.mesh.LagrangeP0."+shape_name,"tmp_shape_func"));
+    m_cell_centres[shape_name] = P0_cell_centred->local_coordinates().row(0);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+RealVector Writer::cell_centre(const std::string& shape_name) const
+{
+  boost::lock_guard<boost::mutex> lock(m_cell_centres_mutex);
+  const std::map<std::string, RealVector>::const_iterator it = m_cell_centres.find(shape_name);
+  if (it == m_cell_centres.end())
+    throw ValueNotFound(FromHere(), "No cell centre prepared for shape "+shape_name+" in writer "+name());
+  return it->second;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 void Writer::write()
+{
+  write_from_snapshot(*configured_snapshot());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Writer::write_from_snapshot(const Snapshot& snapshot) const
 {
   // if the file is present open it
   boost::filesystem::fstream file;
-  boost::filesystem::path path(m_file_path.path());
+  boost::filesystem::path path(snapshot.file_path.path());
   if (PE::Comm::instance().size() > 1)
   {
     path = boost::filesystem::basename(path) + "_P" + to_str(PE::Comm::instance().rank()) + boost::filesystem::extension(path);
@@ -82,14 +118,14 @@ void Writer::write()
   }
 
 
-  write_file(file);
+  write_file(file, snapshot);
 
   file.close();
 
 }
 /////////////////////////////////////////////////////////////////////////////
 
-void Writer::write_file(std::fstream& file)
+void Writer::write_file(std::fstream& file, const Snapshot& snapshot) const
 {
   file << "TITLE      = COOLFluiD Mesh Data" << "\n";
   file << "VARIABLES  = ";
@@ -103,7 +139,7 @@ void Writer::write_file(std::fstream& file)
 
   std::vector<Uint> cell_centered_var_ids;
   Uint zone_var_id(dimension);
-  boost_foreach(Handle<Field const> field_ptr, m_fields)
+  boost_foreach(Handle<Field const> field_ptr, snapshot.fields)
   {
     const Field& field = *field_ptr;
     for (Uint iVar=0; iVar<field.nb_vars(); ++iVar)
@@ -137,9 +173,10 @@ void Writer::write_file(std::fstream& file)
   // and create a zone in the tecplot file for each element type
 //  std::map<Handle<Component const>,Uint> zone_id;
   Uint zone_idx=0;
-  boost_foreach (const Handle<Entities const>& elements_h, m_filtered_entities )
+  cf3_assert(snapshot.zone_names.size() == snapshot.filtered_entities.size());
+  for (Uint entities_idx=0; entities_idx<snapshot.filtered_entities.size(); ++entities_idx)
   {
-    Entities const& elements = *elements_h;
+    Entities const& elements = *snapshot.filtered_entities[entities_idx];
     const ElementType& etype = elements.element_type();
 
     Uint nb_elems = elements.size();
@@ -155,8 +192,7 @@ void Writer::write_file(std::fstream& file)
       nb_elems -= nb_ghost_elems;
     }
 
-    std::string zone_name = elements.parent()->uri().path();
-    boost::algorithm::replace_first(zone_name,m_mesh->topology().uri().path()+"/","");
+    const std::string& zone_name = snapshot.zone_names[entities_idx];
     std::set<std::string> zone_names;
     if (zone_names.count(zone_name) == 0)
     {
@@ -188,9 +224,9 @@ void Writer::write_file(std::fstream& file)
     // one zone per element type per cpu
     // therefore the title is dependent on those parameters
     file << "ZONE "
-         << "  T=\"STEP"<<m_mesh->metadata().properties().value<Uint>("iter") << ":" << zone_name << "\""
+         << "  T=\"STEP"<<snapshot.iteration << ":" << zone_name << "\""
          << ", STRANDID="<<zone_idx
-         << ", SOLUTIONTIME="<<m_mesh->metadata().properties().value<Real>("time")
+         << ", SOLUTIONTIME="<<snapshot.time
          << ", N=" << used_nodes.size()
          << ", E=" << nb_elems
          << ", DATAPACKING=BLOCK"
@@ -229,7 +265,7 @@ void Writer::write_file(std::fstream& file)
     file << "\n";
 
 
-    boost_foreach(Handle<Field const> field_ptr, m_fields)
+    boost_foreach(Handle<Field const> field_ptr, snapshot.fields)
     {
       const Field& field = *field_ptr;
       Uint var_idx(0);
@@ -320,7 +356,8 @@ void Writer::write_file(std::fstream& file)
 
               if (options().value<bool>("cell_centred"))
               {
-                boost::shared_ptr< ShapeFunction > P0_cell_centred = boost::dynamic_pointer_cast<ShapeFunction>(build_component("cf3.mesh.LagrangeP0."+to_str(elements.element_type().shape_name()),"tmp_shape_func"));
+                /// get cell-centred local coordinates
+                const RealVector local_coords = cell_centre(elements.element_type().shape_name());
 
                 for (Uint e=0; e<elements.size(); ++e)
                 {
@@ -333,9 +370,6 @@ void Writer::write_file(std::fstream& file)
                       field_data[iState] = field[field_index[iState]][var_idx];
                     }
 
-                    /// get cell-centred local coordinates
-                    RealVector local_coords = P0_cell_centred->local_coordinates().row(0);
-
                     /// evaluate field shape function in P0 space
                     Real cell_centred_data = field_space.shape_function().value(local_coords)*field_data;
 
@@ -9,6 +9,12 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <map>
+
+#include <boost/thread/mutex.hpp>
+
+#include "math/MatrixTypes.hpp"
+
 #include "mesh/MeshWriter.hpp"
 #include "mesh/GeoShape.hpp"
 
@@ -46,14 +52,30 @@ public: // functions
 
   virtual std::vector<std::string> get_extensions();
 
+  /// Only the configured fields are written, without communication or logging
+  virtual bool supports_background_write() const { return true; }
+
 private: // functions
 
-  void write_file(std::fstream& file);
+  /// Builds the cell-centred shape functions for the element types that are written
+  virtual void prepare_entities(const std::vector<Handle<Entities const> >& entities) const;
+
+  /// Local coordinates of the cell centre for the given element shape, as prepared by prepare_entities
+  RealVector cell_centre(const std::string& shape_name) const;
+
+  /// Writes the snapshot, without changing the writer or looking up components in the tree
+  virtual void write_from_snapshot(const Snapshot& snapshot) const;
+
+  void write_file(std::fstream& file, const Snapshot& snapshot) const;
 
   std::string zone_type(const ElementType& etype) const;
 
 private: // data
 
+  /// Protects m_cell_centres, which is filled on the calling thread and read by background writes
+  mutable boost::mutex m_cell_centres_mutex;
+  /// Local cell centre coordinates, by element shape name
+  mutable std::map<std::string, RealVector> m_cell_centres;
 
 }; // end Writer
 
@@ -17,6 +17,7 @@
 
 #include "python/ComponentWrapper.hpp"
 #include "python/ListWrapper.hpp"
+#include "python/NumPyView.hpp"
 #include "python/Utility.hpp"
 
 namespace cf3 {
@@ -75,6 +76,12 @@ struct ListMethods
   {
     wrapped.component< common::List<ValueT> >().resize(nb_rows);
   }
+
+  static object array_view(object self)
+  {
+    ComponentWrapper& wrapped = extract<ComponentWrapper&>(self);
+    return make_numpy_view(self, wrapped.component< common::List<ValueT> >().array());
+  }
 };
 
 template<typename ValueT>
@@ -89,6 +96,7 @@ void add_clist_methods(ComponentWrapper& wrapped, boost::python::api::object& py
     // Extra methods
     typedef ListMethods<ValueT> ExtraMethodsT;
     add_function(py_obj, ExtraMethodsT::resize, "resize", "Set the size of the table, i.e. the number of rows");
+    add_function(py_obj, ExtraMethodsT::array_view, "array_view", "Return a one-dimensional NumPy array that shares the list storage without copying. The array becomes invalid when the list is resized");
   }
 }
 
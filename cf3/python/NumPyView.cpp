@@ -0,0 +1,51 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include "python/BoostPython.hpp"
+
+#include <cstddef>
+
+#include "common/StringConversion.hpp"
+
+#include "python/NumPyView.hpp"
+
+namespace cf3 {
+namespace python {
+
+using namespace boost::python;
+
+object make_numpy_view(const object& owner, void* data, const char kind, const Uint item_size,
+                       const std::vector<Uint>& shape, const std::vector<int>& strides)
+{
+  const Uint one = 1;
+  const bool little_endian = *reinterpret_cast<const char*>(&one) == 1;
+
+  list shape_list, strides_list;
+  for(Uint i = 0; i != shape.size(); ++i)
+  {
+    shape_list.append(shape[i]);
+    strides_list.append(strides[i]);
+  }
+
+  // See the NumPy array interface protocol, version 3
+  dict interface;
+  interface["version"] = 3;
+  interface["typestr"] = std::string(1, little_endian ? '<' : '>') + kind + common::to_str(item_size);
+  interface["data"] = make_tuple(reinterpret_cast<std::size_t>(data), false);
+  interface["shape"] = tuple(shape_list);
+  interface["strides"] = tuple(strides_list);
+
+  // NumPy keeps a reference to the object that provided the interface, so the owner stays alive as long as the array
+  dict attributes;
+  attributes["__array_interface__"] = interface;
+  attributes["owner"] = owner;
+  object holder_type = import("__builtin__").attr("type")("NumPyViewOwner", make_tuple(import("__builtin__").attr("object")), attributes);
+
+  return import("numpy").attr("asarray")(holder_type());
+}
+
+} // python
+} // cf3
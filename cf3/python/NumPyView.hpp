@@ -0,0 +1,67 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef CF3_Python_NumPyView_hpp
+#define CF3_Python_NumPyView_hpp
+
+#include <vector>
+
+#include <boost/multi_array.hpp>
+#include <boost/python/object_fwd.hpp>
+
+#include "common/CF.hpp"
+
+namespace cf3 {
+namespace python {
+
+/// Kind character of the NumPy type string for each supported value type
+template<typename ValueT>
+struct NumPyTypeKind;
+
+template<>
+struct NumPyTypeKind<Real>
+{
+  static char kind() { return 'f'; }
+};
+
+template<>
+struct NumPyTypeKind<Uint>
+{
+  static char kind() { return 'u'; }
+};
+
+/// Return a NumPy array that uses the given memory directly, through the NumPy array interface.
+/// NumPy is only imported when this is called, so it is not needed to build or load the python module.
+/// @param owner Python object that is kept alive for as long as the array exists
+/// @param data Pointer to the first element
+/// @param kind Kind character of the NumPy type string (i.e. 'f' for floating point, 'u' for unsigned integers)
+/// @param item_size Size of each element, in bytes
+/// @param shape Number of elements in each dimension
+/// @param strides Distance between consecutive elements in each dimension, in bytes
+boost::python::object make_numpy_view(const boost::python::object& owner, void* data, const char kind, const Uint item_size,
+                                      const std::vector<Uint>& shape, const std::vector<int>& strides);
+
+/// Return a NumPy array that shares the storage of a multi_array, with the same shape and storage order.
+/// The array becomes invalid when the multi_array is resized.
+template<typename ValueT, std::size_t NumDims>
+boost::python::object make_numpy_view(const boost::python::object& owner, boost::multi_array<ValueT, NumDims>& array)
+{
+  std::vector<Uint> shape(NumDims);
+  std::vector<int> strides(NumDims);
+  for(Uint i = 0; i != NumDims; ++i)
+  {
+    shape[i] = array.shape()[i];
+    strides[i] = array.strides()[i] * sizeof(ValueT);
+  }
+  return make_numpy_view(owner, array.data(), NumPyTypeKind<ValueT>::kind(), sizeof(ValueT), shape, strides);
+}
+
+} // python
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // CF3_Python_NumPyView_hpp
@@ -16,6 +16,7 @@
 #include "common/Table.hpp"
 
 #include "python/ComponentWrapper.hpp"
+#include "python/NumPyView.hpp"
 #include "python/TableWrapper.hpp"
 #include "python/Utility.hpp"
 
@@ -131,6 +132,22 @@ struct TableMethods
   {
     wrapped.component< common::Table<ValueT> >().set_row_size(nb_cols);
   }
+
+  static void set_column_major(ComponentWrapper& wrapped, const bool column_major)
+  {
+    wrapped.component< common::Table<ValueT> >().set_column_major(column_major);
+  }
+
+  static bool is_column_major(ComponentWrapper& wrapped)
+  {
+    return wrapped.component< common::Table<ValueT> >().is_column_major();
+  }
+
+  static object array_view(object self)
+  {
+    ComponentWrapper& wrapped = extract<ComponentWrapper&>(self);
+    return make_numpy_view(self, wrapped.component< common::Table<ValueT> >().array());
+  }
 };
 
 template<typename ValueT>
@@ -147,6 +164,9 @@ void add_ctable_methods(ComponentWrapper& wrapped, boost::python::api::object& p
     add_function(py_obj, ExtraMethodsT::row_size, "row_size", "Return the number of columns the table can hold");
     add_function(py_obj, ExtraMethodsT::resize, "resize", "Set the size of the table, i.e. the number of rows");
     add_function(py_obj, ExtraMethodsT::set_row_size, "set_row_size", "Set the size of a row, i.e. the number of columns in the table");
+    add_function(py_obj, ExtraMethodsT::set_column_major, "set_column_major", "Store each column contiguously if True, each row if False. Existing array views become invalid");
+    add_function(py_obj, ExtraMethodsT::is_column_major, "is_column_major", "True if each column is stored contiguously");
+    add_function(py_obj, ExtraMethodsT::array_view, "array_view", "Return a NumPy array of shape (rows, columns) that shares the table storage without copying. The array becomes invalid when the table is resized");
   }
 }
 
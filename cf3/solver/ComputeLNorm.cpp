@@ -7,6 +7,7 @@
 #include <cmath>
 
 #include "cf3/common/PE/Comm.hpp"
+#include "cf3/common/PE/ReductionBatch.hpp"
 #include "cf3/common/Builder.hpp"
 #include "cf3/common/Log.hpp"
 #include "cf3/common/OptionT.hpp"
@@ -27,12 +28,8 @@ namespace solver {
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-void ComputeLNorm::compute_L2( const Field& field, std::vector<Real>& norms ) const
+void ComputeLNorm::compute_L2( const Field& field, std::vector<Real>& loc_norm, Uint& N ) const
 {
-
-  std::vector<Real> loc_norm(norms.size(),0.); // norm on local processor
-  std::vector<Real> glb_norm(norms.size(),0.); // norm summed over all processors
-  Uint N=0;
   if (field.discontinuous())
   {
     // loop over all elements
@@ -52,7 +49,7 @@ void ComputeLNorm::compute_L2( const Field& field, std::vector<Real>& norms ) co
             // compute norm for these nodes
             boost_foreach( const Uint node, space->connectivity()[e] )
             {
-              for (Uint i=0; i<norms.size(); ++i)
+              for (Uint i=0; i<loc_norm.size(); ++i)
                 loc_norm[i] += field[node][i]*field[node][i];
             }
           }
@@ -67,30 +64,17 @@ void ComputeLNorm::compute_L2( const Field& field, std::vector<Real>& norms ) co
       if (!field.is_ghost(n))
       {
         ++N;
-        for (Uint i=0; i<norms.size(); ++i)
+        for (Uint i=0; i<loc_norm.size(); ++i)
           loc_norm[i] += field[n][i]*field[n][i];
       }
     }
   }
-
-  PE::Comm::instance().all_reduce( PE::plus(), &loc_norm[0], norms.size(), &glb_norm[0] );
-
-  if( options().value<bool>("scale") )
-    PE::Comm::instance().all_reduce( PE::plus(), &N, 1, &N );
-  else
-    N = 1;
-
-  for (Uint i=0; i<norms.size(); ++i)
-    norms[i] = std::sqrt(glb_norm[i]/static_cast<Real>(N));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ComputeLNorm::compute_L1( const Field& field, std::vector<Real>& norms ) const
+void ComputeLNorm::compute_L1( const Field& field, std::vector<Real>& loc_norm, Uint& N ) const
 {
-  std::vector<Real> loc_norm(norms.size(),0.); // norm on local processor
-
-  Uint N=0;
   if (field.discontinuous())
   {
     // loop over all elements
@@ -109,7 +93,7 @@ void ComputeLNorm::compute_L1( const Field& field, std::vector<Real>& norms ) co
             // compute norm for these nodes
             boost_foreach( const Uint node, space->connectivity()[e] )
             {
-              for (Uint i=0; i<norms.size(); ++i)
+              for (Uint i=0; i<loc_norm.size(); ++i)
                  loc_norm[i] += std::abs( field[node][i] );
             }
           }
@@ -124,29 +108,17 @@ void ComputeLNorm::compute_L1( const Field& field, std::vector<Real>& norms ) co
       if (!field.is_ghost(n))
       {
         ++N;
-        for (Uint i=0; i<norms.size(); ++i)
+        for (Uint i=0; i<loc_norm.size(); ++i)
           loc_norm[i] += std::abs( field[n][i] );
       }
     }
   }
-
-  PE::Comm::instance().all_reduce( PE::plus(), &loc_norm[0], norms.size(), &norms[0] );
-
-  if( options().value<bool>("scale") )
-    PE::Comm::instance().all_reduce( PE::plus(), &N, 1, &N );
-  else
-    N = 1;
-
-  for (Uint i=0; i<norms.size(); ++i)
-    norms[i] = norms[i]/static_cast<Real>(N);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ComputeLNorm::compute_Linf( const Field& field, std::vector<Real>& norms ) const
+void ComputeLNorm::compute_Linf( const Field& field, std::vector<Real>& loc_norm ) const
 {
-  std::vector<Real> loc_norm(norms.size(),0.); // norm on local processor
-
   if (field.discontinuous())
   {
     // loop over all elements
@@ -162,7 +134,7 @@ void ComputeLNorm::compute_Linf( const Field& field, std::vector<Real>& norms )
             // compute norm for these nodes
             boost_foreach( const Uint node, space->connectivity()[e] )
             {
-              for (Uint i=0; i<norms.size(); ++i)
+              for (Uint i=0; i<loc_norm.size(); ++i)
                 loc_norm[i] = std::max( std::abs(field[node][i]), loc_norm[i] );
             }
           }
@@ -176,26 +148,17 @@ void ComputeLNorm::compute_Linf( const Field& field, std::vector<Real>& norms )
     {
       if (!field.is_ghost(n))
       {
-        for (Uint i=0; i<norms.size(); ++i)
+        for (Uint i=0; i<loc_norm.size(); ++i)
           loc_norm[i] = std::max( std::abs(field[n][i]), loc_norm[i] );
       }
     }
   }
-
-  PE::Comm::instance().all_reduce( PE::max(), &loc_norm[0], norms.size(), &norms[0] );
-
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ComputeLNorm::compute_Lp( const Field& field, std::vector<Real>& norms, Uint order ) const
+void ComputeLNorm::compute_Lp( const Field& field, std::vector<Real>& loc_norm, Uint& N, Uint order ) const
 {
-  const int size = 1; // sum 1 value in each processor
-
-  std::vector<Real> loc_norm(norms.size(),0.); // norm on local processor
-  std::vector<Real> glb_norm(norms.size(),0.); // norm summed over all processors
-
-  Uint N=0;
   if (field.discontinuous())
   {
     // loop over all elements
@@ -215,7 +178,7 @@ void ComputeLNorm::compute_Lp( const Field& field, std::vector<Real>& norms, Uin
             // compute norm for these nodes
             boost_foreach( const Uint node, space->connectivity()[e] )
             {
-              for (Uint i=0; i<norms.size(); ++i)
+              for (Uint i=0; i<loc_norm.size(); ++i)
                 loc_norm[i] += std::pow( std::abs(field[node][i]), (int)order ) ;
             }
           }
@@ -230,21 +193,11 @@ void ComputeLNorm::compute_Lp( const Field& field, std::vector<Real>& norms, Uin
       if (!field.is_ghost(n))
       {
         ++N;
-        for (Uint i=0; i<norms.size(); ++i)
+        for (Uint i=0; i<loc_norm.size(); ++i)
           loc_norm[i] += std::pow( std::abs(field[n][i]), (int)order ) ;
       }
     }
   }
-
-  PE::Comm::instance().all_reduce( PE::plus(), &loc_norm[0], norms.size(), &glb_norm[0] );
-
-  if( options().value<bool>("scale") )
-    PE::Comm::instance().all_reduce( PE::plus(), &N, 1, &N );
-  else
-    N = 1;
-
-  for (Uint i=0; i<norms.size(); ++i)
-    norms[i] = std::pow(glb_norm[i]/static_cast<Real>(N), 1./order );
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -301,30 +254,52 @@ Uint ComputeLNorm::compute_nb_rows(const Field& field) const
 
 std::vector<Real> ComputeLNorm::compute_norm(Field& field) const
 {
+  const Uint order = options().value<Uint>("order");
 
-  const Uint loc_nb_rows = compute_nb_rows(field); // table size on local processor
-  Uint nb_rows = 0;                                // table size over all processors
+  // local contributions
 
-  PE::Comm::instance().all_reduce( PE::plus(), &loc_nb_rows, 1u, &nb_rows );
+  std::vector<Real> loc_norm(field.row_size(), 0.);
+  Uint N = 0;
 
-  if ( !nb_rows ) throw SetupError(FromHere(), "Table is empty");
+  switch(order) {
 
-  std::vector<Real> norm(field.row_size(), 0.);
+    case 2:  compute_L2( field, loc_norm, N );    break;
 
-  const Uint order = options().value<Uint>("order");
+    case 1:  compute_L1( field, loc_norm, N );    break;
 
-  // sum of all processors
+    case 0:  compute_Linf( field, loc_norm );  break; // consider order 0 as Linf
 
-  switch(order) {
+    default: compute_Lp( field, loc_norm, N, order );  break;
+
+  }
 
-    case 2:  compute_L2( field, norm );    break;
+  // sum of all processors, the table size, norms and number of entries are reduced together
 
-    case 1:  compute_L1( field, norm );    break;
+  PE::ReductionBatch batch;
+  const Uint nb_rows_idx = batch.add_sum( compute_nb_rows(field) );
+  const Uint norm_idx = order == 0 ? batch.add_max( &loc_norm[0], loc_norm.size() ) : batch.add_sum( &loc_norm[0], loc_norm.size() );
+  const Uint N_idx = batch.add_sum( N );
+  batch.execute();
 
-    case 0:  compute_Linf( field, norm );  break; // consider order 0 as Linf
+  if ( batch.result(nb_rows_idx) == 0. ) throw SetupError(FromHere(), "Table is empty");
 
-    default: compute_Lp( field, norm, order );  break;
+  const Real glb_N = options().value<bool>("scale") ? batch.result(N_idx) : 1.;
 
+  std::vector<Real> norm(field.row_size(), 0.);
+  for (Uint i=0; i<norm.size(); ++i)
+  {
+    const Real glb_norm = batch.result(norm_idx+i);
+    switch(order) {
+
+      case 2:  norm[i] = std::sqrt(glb_norm/glb_N);           break;
+
+      case 1:  norm[i] = glb_norm/glb_N;                      break;
+
+      case 0:  norm[i] = glb_norm;                            break;
+
+      default: norm[i] = std::pow(glb_norm/glb_N, 1./order);  break;
+
+    }
   }
 
   field.properties()["norm"] = norm;
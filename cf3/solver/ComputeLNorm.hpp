@@ -44,13 +44,16 @@ private:
 
   Uint compute_nb_rows(const mesh::Field& field) const;
 
-  void compute_L2( const mesh::Field& field, std::vector<Real>& norms ) const;
+  /// The compute functions only accumulate the local contributions to the norms and the number of entries N,
+  /// which compute_norm reduces over all processors in a single collective.
 
-  void compute_L1( const mesh::Field& field, std::vector<Real>& norms ) const;
+  void compute_L2( const mesh::Field& field, std::vector<Real>& loc_norm, Uint& N ) const;
 
-  void compute_Linf( const mesh::Field& field, std::vector<Real>& norms ) const;
+  void compute_L1( const mesh::Field& field, std::vector<Real>& loc_norm, Uint& N ) const;
 
-  void compute_Lp( const mesh::Field& field, std::vector<Real>& norms, Uint order ) const;
+  void compute_Linf( const mesh::Field& field, std::vector<Real>& loc_norm ) const;
+
+  void compute_Lp( const mesh::Field& field, std::vector<Real>& loc_norm, Uint& N, Uint order ) const;
 
   Handle<mesh::Field> m_field;
 
@@ -12,6 +12,7 @@
 #include "solver/LibSolver.hpp"
 
 namespace cf3 {
+namespace common { namespace PE { class ReductionBatch; } }
 namespace solver {
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -32,6 +33,14 @@ public: // functions
   /// Get the class name
   static std::string type_name () { return "Criterion"; }
 
+  /// Add the local values that must be reduced over all ranks before the criterion can be evaluated.
+  /// A loop that checks several criteria, such as actions::Iterate, calls this for all of them on a shared batch
+  /// and reduces it with a single collective. The default adds nothing.
+  virtual void contribute(common::PE::ReductionBatch& batch) {}
+
+  /// Read the global values added by contribute, after the batch was reduced. The default does nothing.
+  virtual void collect(const common::PE::ReductionBatch& batch) {}
+
   /// Return the state of the criterion
   virtual bool operator()() = 0;
 };
@@ -10,6 +10,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "common/Component.hpp"
+#include "common/StringConversion.hpp"
 #include "solver/LibSolver.hpp"
 #include "physics/MatrixTypes.hpp"
 
@@ -36,12 +37,26 @@ public:
     regist_typeinfo(this);
   }
 
-  static std::string type_name () { return "RiemannSolver"; }
+  /// The dimension is part of the name, so that each dimension gets its own factory
+  static std::string type_name () { return "RiemannSolver" + common::to_str(NB_DIM) + "D"; }
 
   virtual ~RiemannSolver() {}
 
   virtual void compute_riemann_flux( const Data& left, const Data& right, const ColVector_NDIM& normal,
                                      RowVector_NEQS& flux, Real& wave_speed ) = 0;
+
+  /// @brief Compute the Riemann fluxes of a batch of nb_faces faces
+  ///
+  /// The faces are passed as arrays of structures, one Data per face. The default implementation
+  /// calls compute_riemann_flux for each face. Solvers with a structure of arrays kernel, such as
+  /// physics::euler::RiemannSolverT, override this to pack the batch once and evaluate all faces
+  /// in a single vectorised loop.
+  virtual void compute_riemann_fluxes( const Uint nb_faces, const Data* left, const Data* right, const ColVector_NDIM* normal,
+                                       RowVector_NEQS* flux, Real* wave_speed )
+  {
+    for (Uint f=0; f<nb_faces; ++f)
+      compute_riemann_flux(left[f], right[f], normal[f], flux[f], wave_speed[f]);
+  }
 };
 
 ////////////////////////////////////////////////////////////////////////////////
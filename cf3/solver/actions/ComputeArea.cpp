@@ -16,6 +16,7 @@
 #include "mesh/Connectivity.hpp"
 
 #include "solver/actions/ComputeArea.hpp"
+#include "solver/actions/ElementRangeKernel.hpp"
 
 /////////////////////////////////////////////////////////////////////////////////////
 
@@ -81,6 +82,13 @@ void ComputeArea::execute()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ComputeArea::execute_range(const Uint begin, const Uint end)
+{
+  compute_element_measures<ElementArea>(elements(), *m_area_field_space, *m_area, begin, end);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // actions
 } // solver
 } // cf3
@@ -40,6 +40,12 @@ public: // functions
   /// execute the action
   virtual void execute ();
 
+  /// Compute the area of a range of elements, with the element type resolved once for the whole range
+  virtual void execute_range ( const Uint begin, const Uint end );
+
+  /// Each element only writes its own entry in the field
+  virtual bool is_range_thread_safe() const { return true; }
+
 private: // helper functions
 
   void config_field();
@@ -17,6 +17,7 @@
 #include "mesh/Connectivity.hpp"
 
 #include "solver/actions/ComputeVolume.hpp"
+#include "solver/actions/ElementRangeKernel.hpp"
 
 /////////////////////////////////////////////////////////////////////////////////////
 
@@ -82,6 +83,13 @@ void ComputeVolume::execute()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ComputeVolume::execute_range(const Uint begin, const Uint end)
+{
+  compute_element_measures<ElementVolume>(elements(), *m_volume_field_space, *m_volume, begin, end);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // actions
 } // solver
 } // cf3
@@ -0,0 +1,151 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_ElementRangeKernel_hpp
+#define cf3_solver_actions_ElementRangeKernel_hpp
+
+#include <boost/mpl/for_each.hpp>
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/ElementData.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/ElementTypes.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Space.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// Helper to run a kernel over a range of elements with the concrete element type known at compile time.
+/// Inside the kernel, element type functions such as ETYPE::volume are static and can be inlined,
+/// and the element data can be stored in fixed-size matrices.
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+
+namespace detail
+{
+  /// mpl::for_each functor that runs the kernel for the element type that matches the entities
+  template<typename KernelT>
+  struct ElementRangeDispatcher
+  {
+    ElementRangeDispatcher(const mesh::Entities& entities, KernelT& kernel, const Uint begin, const Uint end, bool& found) :
+      m_entities(entities),
+      m_kernel(kernel),
+      m_begin(begin),
+      m_end(end),
+      m_found(found)
+    {
+    }
+
+    template<typename ETYPE>
+    void operator()(const ETYPE&) const
+    {
+      if(m_found || !mesh::IsElementType<ETYPE>()(m_entities.element_type()))
+        return;
+
+      m_found = true;
+      m_kernel.template apply<ETYPE>(m_begin, m_end);
+    }
+
+    const mesh::Entities& m_entities;
+    KernelT& m_kernel;
+    const Uint m_begin;
+    const Uint m_end;
+    bool& m_found;
+  };
+}
+
+/// Run kernel.template apply<ETYPE>(begin, end), where ETYPE is the type from TypesT that matches the element type of entities.
+/// @return false if none of the types in TypesT match, in which case the kernel is not called
+template<typename TypesT, typename KernelT>
+bool run_element_range_kernel(const mesh::Entities& entities, KernelT& kernel, const Uint begin, const Uint end)
+{
+  bool found = false;
+  boost::mpl::for_each<TypesT>(detail::ElementRangeDispatcher<KernelT>(entities, kernel, begin, end, found));
+  return found;
+}
+
+/// Volume of an element, for use with compute_element_measures
+struct ElementVolume
+{
+  template<typename ETYPE>
+  static Real compute(const typename ETYPE::NodesT& nodes) { return ETYPE::volume(nodes); }
+
+  static Real compute(const mesh::ElementType& etype, const RealMatrix& nodes) { return etype.volume(nodes); }
+};
+
+/// Area of an element, for use with compute_element_measures
+struct ElementArea
+{
+  template<typename ETYPE>
+  static Real compute(const typename ETYPE::NodesT& nodes) { return ETYPE::area(nodes); }
+
+  static Real compute(const mesh::ElementType& etype, const RealMatrix& nodes) { return etype.area(nodes); }
+};
+
+namespace detail
+{
+  /// Stores MeasureT::compute for each element in a range, using the static functions of the element type
+  template<typename MeasureT>
+  struct ElementMeasureKernel
+  {
+    ElementMeasureKernel(const mesh::Entities& elements, const mesh::Space& field_space, mesh::Field& field) :
+      m_elements(elements),
+      m_field_space(field_space),
+      m_field(field)
+    {
+    }
+
+    template<typename ETYPE>
+    void apply(const Uint begin, const Uint end)
+    {
+      const common::Table<Real>& coordinates = m_elements.geometry_fields().coordinates();
+      const mesh::Connectivity& geometry_connectivity = m_elements.geometry_space().connectivity();
+      const mesh::Connectivity& field_connectivity = m_field_space.connectivity();
+      typename ETYPE::NodesT nodes;
+      for(Uint elem = begin; elem != end; ++elem)
+      {
+        mesh::fill(nodes, coordinates, geometry_connectivity[elem]);
+        m_field[field_connectivity[elem][0]][0] = MeasureT::template compute<ETYPE>(nodes);
+      }
+    }
+
+    const mesh::Entities& m_elements;
+    const mesh::Space& m_field_space;
+    mesh::Field& m_field;
+  };
+}
+
+/// Store a measure (ElementVolume or ElementArea) of each element in [begin, end) in the given field, which has one value per element.
+/// Element types that are not known at compile time use the virtual element type interface.
+template<typename MeasureT>
+void compute_element_measures(const mesh::Entities& elements, const mesh::Space& field_space, mesh::Field& field, const Uint begin, const Uint end)
+{
+  detail::ElementMeasureKernel<MeasureT> kernel(elements, field_space, field);
+  if(run_element_range_kernel<mesh::ElementTypes>(elements, kernel, begin, end))
+    return;
+
+  RealMatrix coordinates;
+  elements.geometry_space().allocate_coordinates(coordinates);
+  for(Uint elem = begin; elem != end; ++elem)
+  {
+    elements.geometry_space().put_coordinates(coordinates, elem);
+    field[field_space.connectivity()[elem][0]][0] = MeasureT::compute(elements.element_type(), coordinates);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_solver_actions_ElementRangeKernel_hpp
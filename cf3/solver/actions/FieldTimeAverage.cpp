@@ -63,8 +63,8 @@ void FieldTimeAverage::execute()
 
   for(Uint i = 0; i != nb_rows; ++i)
   {
-    const Eigen::Map<RealVector const> source_row(&source_array[i][0], row_size);
-    Eigen::Map<RealVector> avg_row(&avg_array[i][0], row_size);
+    const Eigen::Map<RealVector const, Eigen::Unaligned, Eigen::InnerStride<> > source_row(&source_array[i][0], row_size, Eigen::InnerStride<>(source_array.strides()[1]));
+    Eigen::Map<RealVector, Eigen::Unaligned, Eigen::InnerStride<> > avg_row(&avg_array[i][0], row_size, Eigen::InnerStride<>(avg_array.strides()[1]));
     avg_row = (avg_row*static_cast<Real>(m_count) + source_row) / static_cast<Real>(m_count +1);
   }
 
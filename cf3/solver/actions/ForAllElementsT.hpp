@@ -51,11 +51,14 @@ class solver_actions_API ForAllElementsT : public Loop
       /// Operation to perform
       ActionT& op;
 
+      /// Loop that runs the operation
+      ForAllElementsT& loop;
+
     public: // functions
 
       /// Constructor
-      ElementLooper(ActionT& operation, mesh::Region& region_in )
-        : region(region_in) , op(operation)
+      ElementLooper(ActionT& operation, mesh::Region& region_in, ForAllElementsT& loop_in )
+        : region(region_in) , op(operation), loop(loop_in)
       {}
 
       /// Operator
@@ -66,14 +69,7 @@ class solver_actions_API ForAllElementsT : public Loop
         {
           op.set_elements(elements);
           if (op.can_start_loop())
-          {
-            const Uint nb_elem = elements.size();
-            for ( Uint elem = 0; elem != nb_elem; ++elem )
-            {
-              op.select_loop_idx(elem);
-              op.execute();
-            }
-          }
+            loop.execute_operation(op, elements.size());
         }
       }
 
@@ -120,7 +116,7 @@ public: // functions
     {
       CFinfo << region->uri().string() << CFendl;
 
-      ElementLooper loop_elements(*m_action,*region);
+      ElementLooper loop_elements(*m_action,*region,*this);
       boost::mpl::for_each< mesh::ElementTypes >(loop_elements);
     }
   }
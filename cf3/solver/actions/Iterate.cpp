@@ -15,6 +15,7 @@
 #include "common/Core.hpp"
 #include "common/Environment.hpp"
 #include "common/PropertyList.hpp"
+#include "common/PE/ReductionBatch.hpp"
 
 #include "math/Consts.hpp"
 
@@ -36,7 +37,8 @@ Iterate::Iterate( const std::string& name  ) :
   ActionDirector(name),
   m_iter(0),
   m_verbose(false),
-  m_max_iter(uint_max())
+  m_max_iter(uint_max()),
+  m_criteria_batch(new common::PE::ReductionBatch())
 {
   mark_basic();
   properties()["brief"] = std::string("Iterator object");
@@ -70,6 +72,21 @@ void Iterate::execute ()
   bool exit_iterations = false;
   while( m_iter != m_max_iter)
   {
+    // reduce the values of all criteria together, so checking them costs at most one collective
+    m_criteria_batch->clear();
+    boost_foreach(Criterion& stop_criterion, find_components<Criterion>(*this))
+    {
+      stop_criterion.contribute(*m_criteria_batch);
+    }
+    if(m_criteria_batch->size() != 0)
+    {
+      m_criteria_batch->execute();
+      boost_foreach(Criterion& stop_criterion, find_components<Criterion>(*this))
+      {
+        stop_criterion.collect(*m_criteria_batch);
+      }
+    }
+
     // check if any criterion are met and abort if so
     boost_foreach(Criterion& stop_criterion, find_components<Criterion>(*this))
     {
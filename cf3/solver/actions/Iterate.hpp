@@ -9,10 +9,13 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <boost/scoped_ptr.hpp>
+
 #include "solver/actions/LibActions.hpp"
 #include "common/ActionDirector.hpp"
 
 namespace cf3 {
+namespace common { namespace PE { class ReductionBatch; } }
 namespace solver {
 namespace actions {
 
@@ -21,7 +24,9 @@ namespace actions {
 /// @brief Action component that iteratively executes all contained actions.
 ///
 /// To stop iterating, the configuration "max_iter" can be specified for the amount
-/// of iterations, or a stop-criterion, derived from the type solver::Criterion
+/// of iterations, or a stop-criterion, derived from the type solver::Criterion.
+/// The global values needed by all criteria are reduced together in one collective per iteration,
+/// see Criterion::contribute and Criterion::collect.
 ///
 /// @author Willem Deconinck
 class solver_actions_API Iterate : public common::ActionDirector
@@ -54,6 +59,10 @@ protected: // data
 
   /// flag to output iteration info
   bool m_verbose;
+
+private:
+  /// Reduction shared by the stop criteria
+  boost::scoped_ptr<common::PE::ReductionBatch> m_criteria_batch;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
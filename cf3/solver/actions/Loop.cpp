@@ -4,6 +4,11 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <boost/thread/thread.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/OptionList.hpp"
+#include "common/StringConversion.hpp"
 #include "common/URI.hpp"
  
 
@@ -28,6 +33,72 @@ Loop::Loop ( const std::string& name ) :
   solver::Action(name)
 {
   mark_basic();
+
+  options().add("nb_threads", 1u)
+    .pretty_name("Number of Threads")
+    .description("Number of threads used to run the loop operations that support concurrent execution of element ranges");
+  m_nb_threads.bind(options(), "nb_threads");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+  /// Runs a range of a loop operation on a thread, storing any error message
+  struct LoopRangeThread
+  {
+    LoopRangeThread(LoopOperation& op, const Uint begin, const Uint end, std::string& error) :
+      m_op(op),
+      m_begin(begin),
+      m_end(end),
+      m_error(error)
+    {
+    }
+
+    void operator()()
+    {
+      try
+      {
+        m_op.execute_range(m_begin, m_end);
+      }
+      catch(std::exception& e)
+      {
+        m_error = e.what();
+      }
+    }
+
+    LoopOperation& m_op;
+    const Uint m_begin;
+    const Uint m_end;
+    std::string& m_error;
+  };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Loop::execute_operation(LoopOperation& op, const Uint nb_elements)
+{
+  const Uint nb_threads = std::min(m_nb_threads.value(), nb_elements);
+  if(nb_threads < 2 || !op.is_range_thread_safe())
+  {
+    op.execute_range(0, nb_elements);
+    return;
+  }
+
+  std::vector<std::string> errors(nb_threads);
+  boost::thread_group threads;
+  for(Uint i = 1; i != nb_threads; ++i)
+    threads.create_thread(detail::LoopRangeThread(op, (nb_elements*i)/nb_threads, (nb_elements*(i+1))/nb_threads, errors[i]));
+
+  // The calling thread takes the first range
+  detail::LoopRangeThread(op, 0, nb_elements/nb_threads, errors[0])();
+  threads.join_all();
+
+  for(Uint i = 0; i != nb_threads; ++i)
+  {
+    if(!errors[i].empty())
+      throw common::ParallelError(FromHere(), "Error in thread " + common::to_str(i) + " while running " + op.uri().path() + ": " + errors[i]);
+  }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
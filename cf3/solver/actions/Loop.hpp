@@ -7,6 +7,8 @@
 #ifndef cf3_solver_actions_Loop_hpp
 #define cf3_solver_actions_Loop_hpp
 
+#include "common/OptionRef.hpp"
+
 #include "solver/actions/LibActions.hpp"
 #include "solver/Action.hpp"
 #include "solver/actions/LoopOperation.hpp"
@@ -51,6 +53,16 @@ public: // functions
   virtual LoopOperation& action(const std::string& name);
 
   virtual void execute() = 0;
+
+protected:
+  /// Run the operation over elements [0, nb_elements) of the entities it was set to. If option nb_threads is larger than 1
+  /// and the operation is range thread safe, the elements are split into one contiguous range per thread.
+  /// The threads are started for each call and joined before returning, so this only pays off for large element ranges.
+  void execute_operation(LoopOperation& op, const Uint nb_elements);
+
+private:
+  /// Value of option nb_threads
+  common::OptionRef<Uint> m_nb_threads;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
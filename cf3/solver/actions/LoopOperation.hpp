@@ -56,6 +56,15 @@ public: // functions
 
   bool can_start_loop() { return m_can_start_loop; }
 
+  /// Execute the operation for the elements with index in [begin, end).
+  /// The default still calls select_loop_idx() and the virtual execute() for each element. Only operations that override
+  /// this, such as ComputeVolume and ComputeArea, process the whole range in a single virtual call.
+  virtual void execute_range ( const Uint begin, const Uint end );
+
+  /// True if execute_range may be called concurrently for disjoint ranges of the same elements,
+  /// i.e. if it modifies no member data and each element only writes to its own entries.
+  virtual bool is_range_thread_safe() const { return false; }
+
 protected: // functions
 
   Uint idx() const { return m_idx; }
@@ -54,6 +54,9 @@ PrintIterationSummary::PrintIterationSummary ( const std::string& name ) : Actio
   options().add("iterator", my_iter)
       .description("component holding the iteration property")
       .link_to(&my_iter);
+
+  m_print_rate.bind(options(), "print_rate");
+  m_check_convergence.bind(options(), "check_convergence");
 }
 
 
@@ -68,8 +71,8 @@ void PrintIterationSummary::execute()
   Uint iter = my_iter->properties().value<Uint>("iteration");
   Real norm = my_norm->properties().value<Real>("norm");
 
-  Uint print_rate = options().value<Uint>("print_rate");
-  bool check_convergence = options().value<bool>("check_convergence");
+  const Uint print_rate = m_print_rate;
+  const bool check_convergence = m_check_convergence;
 
   if( print_rate > 0 && !(iter % print_rate) )
     CFinfo << "iter ["    << std::setw(4)  << iter << "]"
@@ -8,6 +8,7 @@
 #define cf3_solver_actions_PrintIterationSummary_hpp
 
 #include "common/Action.hpp"
+#include "common/OptionRef.hpp"
 
 #include "solver/actions/LibActions.hpp"
 
@@ -45,6 +46,9 @@ private: // data
   Handle<Component> my_norm;
   Handle<Component> my_iter;
 
+  common::OptionRef<Uint> m_print_rate;
+  common::OptionRef<bool> m_check_convergence;
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////
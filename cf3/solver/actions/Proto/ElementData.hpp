@@ -41,6 +41,7 @@
 #include "ElementOperations.hpp"
 #include "ElementTransforms.hpp"
 #include "FieldSync.hpp"
+#include "GeometryCache.hpp"
 #include "Terminals.hpp"
 
 namespace cf3 {
@@ -183,7 +184,11 @@ public:
 
   GeometricSupport(const mesh::Elements& elements) :
     m_coordinates(elements.geometry_fields().coordinates()),
-    m_connectivity_array(elements.geometry_space().connectivity().array())
+    m_connectivity_array(elements.geometry_space().connectivity().array()),
+    m_elements(elements),
+    m_geometry_cache(find_geometry_cache(elements)),
+    m_cache_quadrature(0),
+    m_cached_point(0)
   {
   }
 
@@ -194,6 +199,7 @@ public:
     const mesh::Connectivity::ConstRow row = m_connectivity_array[element_idx];
     std::copy(row.begin(), row.end(), m_connectivity.begin());
     mesh::fill(m_nodes, m_coordinates, m_connectivity);
+    m_cached_point = 0;
   }
 
   /// Reference to the current nodes
@@ -271,9 +277,25 @@ public:
   /// Precompute jacobian for the given mapped coordinates
   void compute_jacobian(const typename EtypeT::MappedCoordsT& mapped_coords) const
   {
+    m_cached_point = 0;
     compute_jacobian_dispatch(boost::mpl::bool_<EtypeT::dimension == EtypeT::dimensionality>(), mapped_coords);
   }
 
+  /// Precompute jacobian for quadrature point gauss_idx of the quadrature rule GaussT. The values are read from
+  /// the GeometryCache of the elements if there is one.
+  template<typename GaussT>
+  void compute_jacobian(const Uint gauss_idx) const
+  {
+    compute_jacobian_dispatch<GaussT>(boost::mpl::bool_<EtypeT::dimension == EtypeT::dimensionality>(), gauss_idx);
+  }
+
+  /// Gradient of the shape functions in physical coordinates at the current quadrature point, if it was read from
+  /// the geometry cache. Returns null otherwise.
+  const Real* cached_gradient() const
+  {
+    return m_cached_point == 0 ? 0 : m_cached_point + 1 + 2*EtypeT::dimension*EtypeT::dimension;
+  }
+
   /// Precompute the interpolated value (requires a computed EtypeT)
   void compute_coordinates() const
   {
@@ -313,6 +335,34 @@ private:
     cf3_assert(is_invertible);
   }
 
+  template<typename GaussT>
+  void compute_jacobian_dispatch(boost::mpl::false_, const Uint) const
+  {
+  }
+
+  template<typename GaussT>
+  void compute_jacobian_dispatch(boost::mpl::true_, const Uint gauss_idx) const
+  {
+    if(is_null(m_geometry_cache))
+    {
+      compute_jacobian_dispatch(boost::mpl::true_(), GaussT::instance().coords.col(gauss_idx));
+      return;
+    }
+
+    // The quadrature rule only changes between expressions, so the lookup in the cache is rare
+    if(m_cache_quadrature != &GaussT::instance())
+    {
+      m_cache_data = m_geometry_cache->template data<EtypeT, GaussT>(m_elements);
+      m_cache_quadrature = &GaussT::instance();
+    }
+
+    static const Uint jacobian_size = EtypeT::dimension*EtypeT::dimension;
+    m_cached_point = &(*m_cache_data)[0] + (m_element_idx*GaussT::nb_points + gauss_idx)*GeometryCache::PointSize<EtypeT>::value;
+    m_jacobian_determinant = m_cached_point[0];
+    m_jacobian_matrix = Eigen::Map<const typename EtypeT::JacobianT>(m_cached_point + 1);
+    m_jacobian_inverse = Eigen::Map<const typename EtypeT::JacobianT>(m_cached_point + 1 + jacobian_size);
+  }
+
   /// Stored node data
   ValueT m_nodes;
 
@@ -328,6 +378,20 @@ private:
   /// Index for the current element
   Uint m_element_idx;
 
+  const mesh::Elements& m_elements;
+
+  /// Geometry cache for the elements, if there is one
+  Handle<GeometryCache const> m_geometry_cache;
+
+  /// Quadrature rule for which m_cache_data was looked up
+  mutable const void* m_cache_quadrature;
+
+  /// Cached data for the current quadrature rule. Holding the pointer keeps the data alive if the cache is invalidated during the loop.
+  mutable GeometryCache::ValuesT m_cache_data;
+
+  /// Cached data for the current element and quadrature point, if the last jacobian was read from the cache
+  mutable const Real* m_cached_point;
+
   /// Temp storage for non-scalar results
 private:
   mutable typename EtypeT::SF::ValueT m_sf;
@@ -576,10 +640,26 @@ private:
   void compute_values_dispatch(boost::mpl::true_, const MappedCoordsT& mapped_coords) const
   {
     compute_values_dispatch(boost::mpl::false_(), mapped_coords);
+    compute_gradient(boost::is_same<EtypeT, SupportEtypeT>(), mapped_coords);
+  }
+
+  /// Compute the gradient if the variable uses a different shape function than the geometry
+  void compute_gradient(boost::false_type, const MappedCoordsT& mapped_coords) const
+  {
     EtypeT::SF::compute_gradient(mapped_coords, m_mapped_gradient_matrix);
     m_gradient.noalias() = m_support.jacobian_inverse() * m_mapped_gradient_matrix;
   }
 
+  /// Same shape function as the geometry, so the gradient may be available from the geometry cache
+  void compute_gradient(boost::true_type, const MappedCoordsT& mapped_coords) const
+  {
+    const Real* cached_gradient = m_support.cached_gradient();
+    if(cached_gradient == 0)
+      compute_gradient(boost::false_type(), mapped_coords);
+    else
+      m_gradient = Eigen::Map<const GradientT>(cached_gradient);
+  }
+
   /// Value of the field in each element node
   ValueT m_element_values;
 
@@ -618,7 +698,7 @@ public:
   typedef ElementBased<Dim> EtypeT;
 
   /// Type of returned value
-  typedef Eigen::Map< Eigen::Matrix<Real, 1, Dim> > ValueResultT;
+  typedef Eigen::Map< Eigen::Matrix<Real, 1, Dim>, Eigen::Unaligned, Eigen::InnerStride<> > ValueResultT;
 
   /// Data type for the geometric support
   typedef GeometricSupport<SupportEtypeT> SupportT;
@@ -646,7 +726,7 @@ public:
 
   ValueResultT value() const
   {
-    return ValueResultT(&m_field[m_field_idx][offset]);
+    return ValueResultT(&m_field[m_field_idx][offset], Eigen::InnerStride<>(m_field.array().strides()[1]));
   }
 
   typedef typename SupportEtypeT::MappedCoordsT MappedCoordsT;
@@ -987,6 +1067,19 @@ public:
     boost::mpl::for_each< boost::mpl::range_c<int, 0, NbVarsT::value> >(PrecomputeData<ExprT>(m_variables_data, mapped_coords));
   }
 
+  /// Precompute element matrices at quadrature point gauss_idx of the quadrature rule GaussT, for the variables found in expr.
+  /// The geometric data is taken from the GeometryCache of the elements, if there is one.
+  template<typename GaussT, typename ExprT>
+  void precompute_element_matrices(const GaussT&, const Uint gauss_idx, const ExprT& e)
+  {
+    const typename SupportEtypeT::MappedCoordsT mapped_coords = GaussT::instance().coords.col(gauss_idx);
+    m_support.compute_shape_functions(mapped_coords);
+    m_support.compute_coordinates();
+    m_support.template compute_jacobian<GaussT>(gauss_idx);
+    m_support.compute_normal(mapped_coords);
+    boost::mpl::for_each< boost::mpl::range_c<int, 0, NbVarsT::value> >(PrecomputeData<ExprT>(m_variables_data, mapped_coords));
+  }
+
   /// Return the type of the data stored for variable I (I being an Integral Constant in the boost::mpl sense)
   template<typename I>
   struct DataType
@@ -167,11 +167,11 @@ public:
     {
       typedef mesh::Integrators::GaussMappedCoords<order, ShapeFunctionT::shape> GaussT;
       ChildT e = boost::proto::child_c<1>(expr); // expression to integrate
-      data.precompute_element_matrices(GaussT::instance().coords.col(0), expr);
+      data.precompute_element_matrices(GaussT::instance(), 0, expr);
       expr.value = GaussT::instance().weights[0] * ElementMathImplicit()(e, state, data);
       for(Uint i = 1; i != GaussT::nb_points; ++i)
       {
-        data.precompute_element_matrices(GaussT::instance().coords.col(i), expr);
+        data.precompute_element_matrices(GaussT::instance(), i, expr);
         expr.value += GaussT::instance().weights[i] * ElementMathImplicit()(e, state, data);
       }
       return expr.value;
@@ -249,7 +249,7 @@ struct ElementQuadratureEval :
       for(Uint i = 0; i != GaussT::nb_points; ++i)
       {
         // Precompute the primitive element matrices (shape function values, gradients, ...) for the current Gauss point
-        data.precompute_element_matrices(GaussT::instance().coords.col(i), expr);
+        data.precompute_element_matrices(GaussT::instance(), i, expr);
         boost::mpl::for_each< boost::mpl::range_c<int, 1, boost::proto::arity_of<ExprT>::value> >
         (
           evaluate_expr(expr, state, data, GaussT::instance().weights[i])
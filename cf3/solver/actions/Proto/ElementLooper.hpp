@@ -16,10 +16,17 @@
 #include <boost/mpl/for_each.hpp>
 #include <boost/mpl/filter_view.hpp>
 
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "common/StringConversion.hpp"
+
 #include "ElementData.hpp"
 #include "ElementExpressionWrapper.hpp"
 #include "ElementGrammar.hpp"
 
+#include "mesh/ElementColouring.hpp"
 #include "mesh/Mesh.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/ElementTypePredicates.hpp"
@@ -60,7 +67,7 @@ struct CheckSameEtype
 template<typename ElementTypesT, typename ExprT, typename SupportETYPE, typename VariablesT, typename VariablesEtypesT, typename NbVarsT, typename VarIdxT>
 struct ExpressionRunner
 {
-  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems) : variables(vars), expression(expr), elements(elems), m_nb_tests(0), m_found(false) {}
+  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems, const Uint nb_thrds) : variables(vars), expression(expr), elements(elems), nb_threads(nb_thrds), m_nb_tests(0), m_found(false) {}
 
   typedef typename boost::remove_reference<typename boost::fusion::result_of::at<VariablesT, VarIdxT>::type>::type VarT;
 
@@ -89,7 +96,7 @@ struct ExpressionRunner
       NewVariablesEtypesT,
       NbVarsT,
       NextIdxT
-    >(variables, expression, elements).run();
+    >(variables, expression, elements, nb_threads).run();
   }
 
   // Chosen otherwise
@@ -141,12 +148,13 @@ struct ExpressionRunner
       NewVariablesEtypesT,
       NbVarsT,
       NextIdxT
-    >(variables, expression, elements).run();
+    >(variables, expression, elements, nb_threads).run();
   }
 
   VariablesT& variables;
   const ExprT& expression;
   mesh::Elements& elements;
+  const Uint nb_threads;
   // Number of times we tried a shape function
   mutable Uint m_nb_tests;
   mutable bool m_found;
@@ -165,6 +173,16 @@ struct ElementLooperImpl
     run(WrapExpression()(expr, mapped_coords, data), data, nb_elems);
   }
 
+  /// Run the expression for the part of each colour that is assigned to thread thread_idx.
+  /// All threads synchronize on the barrier after each colour. Any error is stored in error, and
+  /// further elements are skipped after an error, while still waiting on the barrier.
+  template<typename ExprT>
+  void operator()(const ExprT& expr, DataT& data, const mesh::ElementColouring& colouring, const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier, std::string& error) const
+  {
+    const typename DataT::SupportShapeFunction::MappedCoordsT mapped_coords; // needed to deduce proper return type when wrapping
+    run(WrapExpression()(expr, mapped_coords, data), data, colouring, thread_idx, nb_threads, barrier, error);
+  }
+
 private:
   template<typename FilteredExprT>
   void run(const FilteredExprT& expr, DataT& data, const Uint nb_elems) const
@@ -178,13 +196,111 @@ private:
       grammar(expr, elem, data);
     }
   }
+
+  template<typename FilteredExprT>
+  void run(const FilteredExprT& expr, DataT& data, const mesh::ElementColouring& colouring, const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier, std::string& error) const
+  {
+    ElementGrammar grammar;
+    const Uint nb_colours = colouring.nb_colours();
+    for(Uint colour = 0; colour != nb_colours; ++colour)
+    {
+      if(error.empty())
+      {
+        try
+        {
+          // Each thread gets a contiguous chunk of the elements of the current colour
+          const Uint colour_size = colouring.colour_size(colour);
+          const Uint chunk_end = (colour_size * (thread_idx+1)) / nb_threads;
+          for(Uint i = (colour_size * thread_idx) / nb_threads; i != chunk_end; ++i)
+          {
+            const Uint elem = colouring.element(colour, i);
+            data.set_element(elem);
+            grammar(expr, elem, data);
+          }
+        }
+        catch(std::exception& e)
+        {
+          error = e.what();
+        }
+      }
+      // Elements of the next colour may share nodes with any element of this colour
+      barrier.wait();
+    }
+  }
 };
 
+/// Functor running the part of a coloured element loop assigned to a single thread
+template<typename DataT, typename ExprT>
+struct ColouredElementLoopThread
+{
+  ColouredElementLoopThread(const ExprT& expr, DataT& data, const mesh::ElementColouring& colouring, const Uint thread_idx, const Uint nb_threads, boost::barrier& barrier, std::string& error) :
+    m_expr(expr),
+    m_data(data),
+    m_colouring(colouring),
+    m_thread_idx(thread_idx),
+    m_nb_threads(nb_threads),
+    m_barrier(barrier),
+    m_error(error)
+  {
+  }
+
+  void operator()()
+  {
+    ElementLooperImpl<DataT>()(m_expr, m_data, m_colouring, m_thread_idx, m_nb_threads, m_barrier, m_error);
+  }
+
+private:
+  const ExprT& m_expr;
+  DataT& m_data;
+  const mesh::ElementColouring& m_colouring;
+  const Uint m_thread_idx;
+  const Uint m_nb_threads;
+  boost::barrier& m_barrier;
+  std::string& m_error;
+};
+
+/// Run the expression over all elements. If nb_threads is larger than 1, the elements are coloured so
+/// that elements of the same colour share no nodes, and the elements of each colour are divided over the threads,
+/// each thread using its own element data.
+template<typename DataT, typename ExprT, typename VariablesT>
+void run_element_loop(const ExprT& expr, VariablesT& variables, mesh::Elements& elements, const Uint nb_threads)
+{
+  if(nb_threads < 2)
+  {
+    DataT data(variables, elements);
+    ElementLooperImpl<DataT>()(expr, data, elements.size());
+    return;
+  }
+
+  const mesh::ElementColouring& colouring = mesh::element_colouring(elements);
+
+  // Element data is constructed and destroyed on the calling thread, since this accesses the component tree
+  boost::ptr_vector<DataT> thread_data;
+  for(Uint i = 0; i != nb_threads; ++i)
+    thread_data.push_back(new DataT(variables, elements));
+
+  std::vector<std::string> errors(nb_threads);
+  boost::barrier barrier(nb_threads);
+  boost::thread_group threads;
+  for(Uint i = 1; i != nb_threads; ++i)
+    threads.create_thread(ColouredElementLoopThread<DataT, ExprT>(expr, thread_data[i], colouring, i, nb_threads, barrier, errors[i]));
+
+  // The calling thread takes the first chunk of each colour
+  ColouredElementLoopThread<DataT, ExprT>(expr, thread_data[0], colouring, 0, nb_threads, barrier, errors[0])();
+  threads.join_all();
+
+  for(Uint i = 0; i != nb_threads; ++i)
+  {
+    if(!errors[i].empty())
+      throw common::ParallelError(FromHere(), "Error in thread " + common::to_str(i) + " while looping over " + elements.uri().path() + ": " + errors[i]);
+  }
+}
+
 /// When we recursed to the last variable, actually run the expression
 template<typename ElementTypesT, typename ExprT, typename SupportETYPE, typename VariablesT, typename VariablesEtypesT, typename NbVarsT>
 struct ExpressionRunner<ElementTypesT, ExprT, SupportETYPE, VariablesT, VariablesEtypesT, NbVarsT, NbVarsT>
 {
-  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems) : variables(vars), expression(expr), elements(elems) {}
+  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems, const Uint nb_thrds) : variables(vars), expression(expr), elements(elems), nb_threads(nb_thrds) {}
 
   typedef ElementData<VariablesT, VariablesEtypesT, SupportETYPE, typename EquationVariables<ExprT, NbVarsT>::type> DataT;
 
@@ -196,15 +312,14 @@ struct ExpressionRunner<ElementTypesT, ExprT, SupportETYPE, VariablesT, Variable
       INVALID_ELEMENT_EXPRESSION,
       (ElementGrammar));
 
-    DataT data(variables, elements);
-
-    ElementLooperImpl<DataT>()(expression, data, elements.size());
+    run_element_loop<DataT>(expression, variables, elements, nb_threads);
   }
 
 private:
   VariablesT& variables;
   const ExprT& expression;
   mesh::Elements& elements;
+  const Uint nb_threads;
 };
 
 /// mpl::for_each compatible functor to loop over elements, using the correct shape function for the geometry
@@ -215,10 +330,12 @@ struct ElementLooper
   // Type of a fusion vector that can contain a copy of each variable that is used in the expression
   typedef typename ExpressionProperties<ExprT>::VariablesT VariablesT;
 
-  ElementLooper(mesh::Elements& elements, const ExprT& expr, VariablesT& variables) :
+  /// @param nb_threads Number of threads to use in the loop. Elements are coloured if this is larger than 1.
+  ElementLooper(mesh::Elements& elements, const ExprT& expr, VariablesT& variables, const Uint nb_threads = 1) :
     m_elements(elements),
     m_expr(expr),
-    m_variables(variables)
+    m_variables(variables),
+    m_nb_threads(nb_threads)
   {
   }
 
@@ -252,9 +369,7 @@ struct ElementLooper
     // Verify the types match, and throw an error if non-matching fields are found
     boost::fusion::for_each(m_variables, CheckSameEtype<ETYPE>(m_elements));
 
-    DataT data(m_variables, m_elements);
-
-    ElementLooperImpl<DataT>()(m_expr, data, m_elements.size());
+    run_element_loop<DataT>(m_expr, m_variables, m_elements, m_nb_threads);
   }
 
   /// Static dispatch in case different ETYPE are possible
@@ -275,13 +390,14 @@ struct ElementLooper
       boost::mpl::vector0<>, // Start with an empty vector for the per-variable element types
       NbVarsT, // number of variables
       boost::mpl::int_<0> // Start index, as MPL integral constant
-    >(m_variables, m_expr, m_elements).run();
+    >(m_variables, m_expr, m_elements, m_nb_threads).run();
   }
 
 private:
   mesh::Elements& m_elements;
   const ExprT& m_expr;
   VariablesT& m_variables;
+  const Uint m_nb_threads;
 };
 
 template<typename ElementTypesT, typename ExprT>
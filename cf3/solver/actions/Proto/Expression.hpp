@@ -49,6 +49,9 @@ public:
   /// Run the stored expression in a loop over the region
   virtual void loop(mesh::Region& region) = 0;
 
+  /// Set the number of threads used to loop over elements. Loops over nodes always use a single thread.
+  virtual void set_nb_threads(const Uint) {}
+
   /// Generate the required options for configurable items in the expression
   /// If an option already existed, only a link will be created
   /// @param options The optionlist that will hold the generated options
@@ -246,7 +249,7 @@ class ElementsExpression : public ExpressionBase<ExprT>
   typedef ExpressionBase<ExprT> BaseT;
 public:
 
-  ElementsExpression(const ExprT& expr) : BaseT(expr)
+  ElementsExpression(const ExprT& expr) : BaseT(expr), m_nb_threads(1)
   {
   }
 
@@ -255,9 +258,17 @@ public:
     // Traverse all Elements under the region and evaluate the expression
     BOOST_FOREACH(mesh::Elements& elements, common::find_components_recursively<mesh::Elements>(region) )
     {
-      boost::mpl::for_each<boost::mpl::filter_view< ElementTypes, mesh::IsMinimalOrder<1> > >( ElementLooper<ElementTypes, typename BaseT::CopiedExprT>(elements, BaseT::m_expr, BaseT::m_variables) );
+      boost::mpl::for_each<boost::mpl::filter_view< ElementTypes, mesh::IsMinimalOrder<1> > >( ElementLooper<ElementTypes, typename BaseT::CopiedExprT>(elements, BaseT::m_expr, BaseT::m_variables, m_nb_threads) );
     }
   }
+
+  void set_nb_threads(const Uint nb_threads)
+  {
+    m_nb_threads = nb_threads;
+  }
+
+private:
+  Uint m_nb_threads;
 };
 
 /// Expression for looping over nodes
@@ -31,6 +31,13 @@ void FieldSynchronizer::insert(mesh::Field& f, bool do_periodic_element_update)
 }
 
 void FieldSynchronizer::synchronize()
+{
+  // All fields are in flight at the same time
+  begin_synchronize();
+  end_synchronize();
+}
+
+void FieldSynchronizer::begin_synchronize()
 {
   // Periodic update needed even in a sequential run
   for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
@@ -63,6 +70,8 @@ void FieldSynchronizer::synchronize()
       }
 
       const Uint row_size = field.row_size();
+      typedef Eigen::Map<RealVector, Eigen::Unaligned, Eigen::InnerStride<> > RowMapT;
+      const Eigen::InnerStride<> stride(field.array().strides()[1]);
 
       for(Uint i = 0; i != nb_nodes; ++i)
       {
@@ -70,14 +79,14 @@ void FieldSynchronizer::synchronize()
         const Uint nb_links = my_links.size();
         if(nb_links == 0)
           continue;
-        Eigen::Map<RealVector> my_row(&field[i][0], row_size);
+        RowMapT my_row(&field[i][0], row_size, stride);
         for(Uint j = 0; j != nb_links; ++j)
         {
-          my_row += Eigen::Map<RealVector>(&field[my_links[j]][0], row_size);
+          my_row += RowMapT(&field[my_links[j]][0], row_size, stride);
         }
         for(Uint j = 0; j != nb_links; ++j)
         {
-          Eigen::Map<RealVector> other_row(&field[my_links[j]][0], row_size);
+          RowMapT other_row(&field[my_links[j]][0], row_size, stride);
           other_row = my_row;
         }
       }
@@ -88,13 +97,27 @@ void FieldSynchronizer::synchronize()
   {
     for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
     {
-      field_it->second.first->synchronize();
+      field_it->second.first->begin_synchronize();
     }
   }
 
+  m_fields_in_flight.insert(m_fields.begin(), m_fields.end());
   m_fields.clear();
 }
 
+void FieldSynchronizer::end_synchronize()
+{
+  if(common::PE::Comm::instance().is_active())
+  {
+    for(FieldsT::iterator field_it = m_fields_in_flight.begin(); field_it != m_fields_in_flight.end(); ++field_it)
+    {
+      field_it->second.first->end_synchronize();
+    }
+  }
+
+  m_fields_in_flight.clear();
+}
+
 } // namespace Proto
 } // namespace actions
 } // namespace solver
@@ -32,6 +32,13 @@ public:
   /// Sync fields and clear the list
   void synchronize();
 
+  /// Apply the periodic updates and start the synchronization of all inserted fields.
+  /// Work that does not touch the ghost values of these fields can be done before calling end_synchronize()
+  void begin_synchronize();
+
+  /// Wait for the synchronization started by begin_synchronize() and clear the list
+  void end_synchronize();
+
 private:
   FieldSynchronizer();
 
@@ -39,6 +46,9 @@ private:
   // on each cpu.
   typedef std::map< std::string, std::pair<Handle<mesh::Field>, bool> > FieldsT;
   FieldsT m_fields;
+
+  // Fields for which begin_synchronize was called
+  FieldsT m_fields_in_flight;
 };
 
 
@@ -0,0 +1,93 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <boost/bind.hpp>
+
+#include "common/Builder.hpp"
+#include "common/Core.hpp"
+#include "common/EventHandler.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Signal.hpp"
+
+#include "common/XML/SignalOptions.hpp"
+
+#include "mesh/Mesh.hpp"
+#include "mesh/Tags.hpp"
+
+#include "GeometryCache.hpp"
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+common::ComponentBuilder < GeometryCache, common::Component, LibActions > GeometryCache_Builder;
+
+GeometryCache::GeometryCache(const std::string& name) : Component(name)
+{
+  regist_signal( "invalidate" )
+    .connect( boost::bind( &GeometryCache::signal_invalidate, this, _1 ) )
+    .description("Clear the cached geometric data, to be called after the mesh nodes were moved")
+    .pretty_name("Invalidate");
+
+  common::Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &GeometryCache::on_mesh_changed_event);
+}
+
+GeometryCache::~GeometryCache()
+{
+}
+
+void GeometryCache::invalidate()
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_blocks.clear();
+}
+
+void GeometryCache::signal_invalidate(common::SignalArgs& args)
+{
+  invalidate();
+}
+
+void GeometryCache::on_mesh_changed_event(common::SignalArgs& args)
+{
+  common::XML::SignalOptions options(args);
+  const common::URI mesh_uri = options.value<common::URI>("mesh_uri");
+
+  Handle<mesh::Mesh> mesh = common::find_parent_component_ptr<mesh::Mesh>(*this);
+  if(is_null(mesh) || mesh->uri() == mesh_uri)
+    invalidate();
+}
+
+Uint GeometryCache::memory_size() const
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  Uint result = 0;
+  for(BlocksT::const_iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+  {
+    if(it->second.values)
+      result += it->second.values->size() * sizeof(Real);
+  }
+  return result;
+}
+
+GeometryCache& geometry_cache(mesh::Elements& elements)
+{
+  Handle<GeometryCache> cache(elements.get_child("proto_geometry_cache"));
+  if(is_null(cache))
+    cache = elements.create_component<GeometryCache>("proto_geometry_cache");
+
+  return *cache;
+}
+
+Handle<GeometryCache const> find_geometry_cache(const mesh::Elements& elements)
+{
+  return Handle<GeometryCache const>(elements.get_child("proto_geometry_cache"));
+}
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
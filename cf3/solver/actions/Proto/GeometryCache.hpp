@@ -0,0 +1,170 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_GeometryCache_hpp
+#define cf3_solver_actions_Proto_GeometryCache_hpp
+
+#include <map>
+#include <typeinfo>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/Component.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementData.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Space.hpp"
+
+#include "solver/actions/LibActions.hpp"
+
+/// @file
+/// Cache for the geometric data at the quadrature points of each element
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// Stores the Jacobian, its inverse, its determinant and the shape function gradients in physical coordinates
+/// at each quadrature point of each element, for the volume elements of the parent Elements component.
+/// Data is stored contiguously for each combination of element type and quadrature rule, and computed the first time
+/// it is requested. The cache is cleared when the mesh_changed event is raised for the parent mesh. Code that moves
+/// the mesh nodes without raising this event must call invalidate().
+class solver_actions_API GeometryCache : public common::Component
+{
+public:
+  GeometryCache(const std::string& name);
+  virtual ~GeometryCache();
+
+  static std::string type_name() { return "GeometryCache"; }
+
+  /// Number of values stored for each quadrature point: the determinant, followed by the Jacobian, its inverse
+  /// and the gradient of the shape functions in physical coordinates, each in the Eigen storage order of their type
+  template<typename ETYPE>
+  struct PointSize
+  {
+    static const Uint value = 1 + 2*ETYPE::dimension*ETYPE::dimension + ETYPE::dimension*ETYPE::nb_nodes;
+  };
+
+  /// Shared, immutable copy of the data for one element type and quadrature rule
+  typedef boost::shared_ptr< const std::vector<Real> > ValuesT;
+
+  /// Cached data for the given elements, element type and quadrature rule, computing it if needed.
+  /// The data for element e and quadrature point q starts at offset (e*GaussT::nb_points + q)*PointSize<ETYPE>::value
+  /// The returned values remain valid as long as the caller holds on to them, even if the cache is invalidated in the mean time.
+  template<typename ETYPE, typename GaussT>
+  ValuesT data(const mesh::Elements& elements) const
+  {
+    const common::Table<Real>& coordinates = elements.geometry_fields().coordinates();
+    const std::string key = std::string(typeid(ETYPE).name()) + typeid(GaussT).name();
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    Block& block = m_blocks[key];
+    if(!block.values || block.nb_nodes != coordinates.size() || block.nb_elements != elements.size())
+      compute<ETYPE, GaussT>(elements, block);
+
+    return block.values;
+  }
+
+  /// Remove all cached data, so it is recomputed on the next access
+  void invalidate();
+
+  /// Signal to invalidate the cache, e.g. from a script that moved the mesh
+  void signal_invalidate(common::SignalArgs& args);
+
+  /// Invalidate if the changed mesh is the parent mesh
+  void on_mesh_changed_event(common::SignalArgs& args);
+
+  /// Number of bytes used by the cached data
+  Uint memory_size() const;
+
+private:
+  /// Data for one element type and quadrature rule
+  struct Block
+  {
+    Block() : nb_nodes(0), nb_elements(0) {}
+
+    /// Replaced rather than modified when recomputing, so copies handed out by data() stay valid
+    ValuesT values;
+
+    /// Number of coordinate rows and elements at the time the values were computed
+    Uint nb_nodes;
+    Uint nb_elements;
+  };
+
+  template<typename ETYPE, typename GaussT>
+  static void compute(const mesh::Elements& elements, Block& block)
+  {
+    typedef typename ETYPE::JacobianT JacobianT;
+    typedef typename ETYPE::SF::GradientT GradientT;
+    static const Uint jacobian_size = ETYPE::dimension*ETYPE::dimension;
+    static const Uint gradient_size = ETYPE::dimension*ETYPE::nb_nodes;
+    static const Uint point_size = PointSize<ETYPE>::value;
+
+    const common::Table<Real>& coordinates = elements.geometry_fields().coordinates();
+    const mesh::Connectivity& connectivity = elements.geometry_space().connectivity();
+    const GaussT& gauss = GaussT::instance();
+    const Uint nb_elements = elements.size();
+
+    // The mapped gradients are the same for each element
+    GradientT mapped_gradients[GaussT::nb_points];
+    for(Uint q = 0; q != GaussT::nb_points; ++q)
+      ETYPE::SF::compute_gradient(gauss.coords.col(q), mapped_gradients[q]);
+
+    boost::shared_ptr< std::vector<Real> > values(new std::vector<Real>(nb_elements*GaussT::nb_points*point_size));
+    typename ETYPE::NodesT nodes;
+    JacobianT jacobian;
+    JacobianT jacobian_inverse;
+    GradientT gradient;
+    Real determinant;
+    bool is_invertible;
+    for(Uint e = 0; e != nb_elements; ++e)
+    {
+      mesh::fill(nodes, coordinates, connectivity[e]);
+      for(Uint q = 0; q != GaussT::nb_points; ++q)
+      {
+        ETYPE::compute_jacobian(gauss.coords.col(q), nodes, jacobian);
+        jacobian.computeInverseAndDetWithCheck(jacobian_inverse, determinant, is_invertible);
+        cf3_assert(is_invertible);
+        gradient.noalias() = jacobian_inverse * mapped_gradients[q];
+
+        Real* point = &(*values)[(e*GaussT::nb_points + q)*point_size];
+        point[0] = determinant;
+        std::copy(jacobian.data(), jacobian.data() + jacobian_size, point + 1);
+        std::copy(jacobian_inverse.data(), jacobian_inverse.data() + jacobian_size, point + 1 + jacobian_size);
+        std::copy(gradient.data(), gradient.data() + gradient_size, point + 1 + 2*jacobian_size);
+      }
+    }
+
+    block.values = values;
+    block.nb_nodes = coordinates.size();
+    block.nb_elements = nb_elements;
+  }
+
+  typedef std::map<std::string, Block> BlocksT;
+  mutable BlocksT m_blocks;
+
+  /// Protects m_blocks, since element loops may run on several threads
+  mutable boost::mutex m_mutex;
+};
+
+/// Get the geometry cache of the given elements, creating it if needed.
+/// The cache is stored as a child of the elements, and is used by all Proto element loops over these elements.
+solver_actions_API GeometryCache& geometry_cache(mesh::Elements& elements);
+
+/// Get the geometry cache of the given elements, or a null handle if it was not created
+solver_actions_API Handle<GeometryCache const> find_geometry_cache(const mesh::Elements& elements);
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_GeometryCache_hpp
@@ -13,6 +13,7 @@
 #include "common/OptionComponent.hpp"
 #include "common/URI.hpp"
 
+#include "mesh/Elements.hpp"
 #include "mesh/Region.hpp"
 
 #include "physics/PhysModel.hpp"
@@ -21,6 +22,7 @@
 
 #include "ProtoAction.hpp"
 #include "Expression.hpp"
+#include "GeometryCache.hpp"
 
 namespace cf3 {
 namespace solver {
@@ -40,6 +42,28 @@ struct ProtoAction::Implementation
     m_physical_model(physical_model)
   {
     m_component.options().option(Tags::physical_model()).attach_trigger(boost::bind(&Implementation::trigger_physical_model, this));
+
+    m_component.options().add("nb_threads", 1u)
+      .pretty_name("Number of Threads")
+      .description("Number of threads used in element loops. If larger than 1, elements are coloured so that each thread can assemble the elements of a colour without conflicts. "
+                   "All terminals in the expression must support concurrent use, which excludes assembly into a TrilinosFEVbrMatrix.")
+      .attach_trigger(boost::bind(&Implementation::trigger_nb_threads, this));
+
+    m_component.options().add("cache_geometry", false)
+      .pretty_name("Cache Geometry")
+      .description("Store the Jacobians and shape function gradients at the quadrature points of each element, instead of recomputing them in every element loop. "
+                   "This is only valid as long as the mesh does not move, and uses memory proportional to the number of elements times the number of quadrature points. "
+                   "The cache is attached to the elements, so it is shared with all other actions over the same elements.");
+  }
+
+  void trigger_nb_threads()
+  {
+    const Uint nb_threads = m_component.options().value<Uint>("nb_threads");
+    if(nb_threads == 0)
+      throw common::BadValue(FromHere(), "Option nb_threads for " + m_component.uri().path() + " must be at least 1");
+
+    if(m_expression)
+      m_expression->set_nb_threads(nb_threads);
   }
 
   void trigger_physical_model()
@@ -123,6 +147,13 @@ void ProtoAction::execute()
     if(is_null(m_implementation->m_expression))
       throw SetupError(FromHere(), "Expression for ProtoAction " + uri().path() + " is not set.");
     CFdebug << "  Action " << name() << ": running over region " << region->uri().path() << CFendl;
+    if(options().value<bool>("cache_geometry"))
+    {
+      boost_foreach(Elements& elements, find_components_recursively<Elements>(*region))
+      {
+        geometry_cache(elements);
+      }
+    }
     m_implementation->m_expression->loop(*region);
   }
 }
@@ -132,6 +163,7 @@ void ProtoAction::set_expression(const boost::shared_ptr< Expression >& expressi
   m_implementation->m_expression = expression;
   expression->add_options(options());
   m_implementation->trigger_physical_model();
+  m_implementation->trigger_nb_threads();
 }
 
 bool ProtoAction::expression_is_set() const
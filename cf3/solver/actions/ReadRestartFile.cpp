@@ -4,6 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 
@@ -11,6 +13,9 @@
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
 #include "common/BinaryDataReader.hpp"
+#include "common/Table.hpp"
+
+#include "common/PE/Comm.hpp"
 
 #include "common/XML/FileOperations.hpp"
 
@@ -38,6 +43,76 @@ common::ComponentBuilder < ReadRestartFile, common::Action, LibActions > ReadRes
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+
+/// Read a field that was written on a different number of CPUs, matching the rows through their global index.
+/// Only the data of the ranks that own global indices needed on this rank is read.
+void read_redistributed(common::BinaryDataReader& data_reader, common::XML::XmlNode field_node, mesh::Field& field)
+{
+  const common::List<Uint>& glb_idx = field.dict().glb_idx();
+  const Uint nb_rows = field.size();
+  if(nb_rows == 0)
+    return;
+
+  // Local rows, sorted by global index
+  std::vector< std::pair<Uint, Uint> > sorted_rows(nb_rows);
+  for(Uint i = 0; i != nb_rows; ++i)
+    sorted_rows[i] = std::make_pair(glb_idx[i], i);
+  std::sort(sorted_rows.begin(), sorted_rows.end());
+
+  const Uint field_block = common::from_str<Uint>(field_node.attribute_value("index"));
+  const Uint glb_idx_block = common::from_str<Uint>(field_node.attribute_value("glb_idx_index"));
+
+  boost::shared_ptr< common::List<Uint> > written_glb_idx = common::allocate_component< common::List<Uint> >("WrittenGlobalIndices");
+  boost::shared_ptr< common::Table<Real> > written_rows = common::allocate_component< common::Table<Real> >("WrittenRows");
+  std::vector<bool> found(nb_rows, false);
+  Uint nb_found = 0;
+
+  common::XML::XmlNode rank_node(field_node.content->first_node("rank"));
+  for(; rank_node.is_valid(); rank_node.content = rank_node.content->next_sibling("rank"))
+  {
+    // Skip ranks that don't own any of the global indices we need
+    const Uint glb_min = common::from_str<Uint>(rank_node.attribute_value("glb_min"));
+    const Uint glb_max = common::from_str<Uint>(rank_node.attribute_value("glb_max"));
+    std::vector< std::pair<Uint, Uint> >::const_iterator first_needed = std::lower_bound(sorted_rows.begin(), sorted_rows.end(), std::make_pair(glb_min, 0u));
+    if(glb_min > glb_max || first_needed == sorted_rows.end() || first_needed->first > glb_max)
+      continue;
+
+    const Uint rank = common::from_str<Uint>(rank_node.attribute_value("index"));
+    data_reader.read_list(*written_glb_idx, glb_idx_block, rank);
+    data_reader.read_table(*written_rows, field_block, rank);
+    if(written_rows->row_size() != field.row_size())
+      throw common::SetupError(FromHere(), "Field " + field.uri().path() + " has " + common::to_str(field.row_size()) + " columns, but the restart file has " + common::to_str(written_rows->row_size()));
+
+    const Uint nb_written_rows = written_glb_idx->size();
+    for(Uint i = 0; i != nb_written_rows; ++i)
+    {
+      const Uint written_glb_idx_i = (*written_glb_idx)[i];
+      if(written_glb_idx_i < glb_min || written_glb_idx_i > glb_max)
+        continue;
+
+      std::vector< std::pair<Uint, Uint> >::const_iterator row_it = std::lower_bound(sorted_rows.begin(), sorted_rows.end(), std::make_pair(written_glb_idx_i, 0u));
+      for(; row_it != sorted_rows.end() && row_it->first == written_glb_idx_i; ++row_it)
+      {
+        const Uint row = row_it->second;
+        if(found[row])
+          continue;
+        std::copy((*written_rows)[i].begin(), (*written_rows)[i].end(), field[row].begin());
+        found[row] = true;
+        ++nb_found;
+      }
+    }
+  }
+
+  if(nb_found != nb_rows)
+    throw common::SetupError(FromHere(), "Only " + common::to_str(nb_found) + " of the " + common::to_str(nb_rows) + " rows of field " + field.uri().path() + " were found in the restart file");
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
 ReadRestartFile::ReadRestartFile ( const std::string& name ) :
   common::Action(name)
 {  
@@ -60,6 +135,15 @@ ReadRestartFile::ReadRestartFile ( const std::string& name ) :
     .pretty_name("Read  Time Step")
     .description("Use the time step from the restart file")
     .mark_basic();
+
+  options().add("mmap", false)
+    .pretty_name("Memory Map")
+    .description("Read the binary data through memory-mapping. Most effective for uncompressed restart files.");
+
+  options().add("redistribute", false)
+    .pretty_name("Redistribute")
+    .description("Match the rows through their global index, also when the file was written on the same number of CPUs. "
+                 "Needed when the mesh was partitioned differently. Files written on a different number of CPUs are always redistributed.");
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -91,11 +175,23 @@ void ReadRestartFile::execute()
   if(common::from_str<Uint>(restart_node.attribute_value("version")) != 1)
     throw common::FileFormatError(FromHere(), "File  " + filepath.path() + " has unsupported version");
 
+  // Files written on a different number of CPUs can be read if they contain the global indices
   common::PE::Comm& comm = common::PE::Comm::instance();
-  if(common::from_str<Uint>(restart_node.attribute_value("nb_procs")) != comm.size())
-    throw common::SetupError(FromHere(), "File  " + filepath.path() + " was made for " + restart_node.attribute_value("nb_procs") + " CPUs, but we are loading on " + common::to_str(comm.size()) + " CPUs");
+  const bool redistribute = options().value<bool>("redistribute") || common::from_str<Uint>(restart_node.attribute_value("nb_procs")) != comm.size();
+  if(redistribute)
+  {
+    common::XML::XmlNode field_node = restart_node.content->first_node("field");
+    for(; field_node.is_valid(); field_node.content = field_node.content->next_sibling("field"))
+    {
+      if(field_node.attribute_value("glb_idx_index").empty())
+        throw common::SetupError(FromHere(), "File  " + filepath.path() + " was made for " + restart_node.attribute_value("nb_procs") + " CPUs and has no global indices, so it can't be redistributed on " + common::to_str(comm.size()) + " CPUs");
+    }
+  }
 
   boost::shared_ptr<common::BinaryDataReader> data_reader = common::allocate_component<common::BinaryDataReader>("DataReader");
+  data_reader->options().set("mmap", options().value<bool>("mmap"));
+  if(redistribute)
+    data_reader->options().set("rank", 0u);
   data_reader->options().set("file", common::URI(restart_node.attribute_value("binary_file")));
 
   common::XML::XmlNode field_node = restart_node.content->first_node("field");
@@ -105,7 +201,10 @@ void ReadRestartFile::execute()
     if(is_null(field))
       throw common::SetupError(FromHere(), "Field " + field_node.attribute_value("path") + " was not found in mesh " + mesh->uri().path());
 
-    data_reader->read_table(*field, common::from_str<Uint>(field_node.attribute_value("index")));
+    if(redistribute)
+      detail::read_redistributed(*data_reader, field_node, *field);
+    else
+      data_reader->read_table(*field, common::from_str<Uint>(field_node.attribute_value("index")));
   }
 }
 
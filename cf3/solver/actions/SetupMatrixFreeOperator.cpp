@@ -0,0 +1,283 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/Builder.hpp"
+#include "common/Foreach.hpp"
+#include "common/FindComponents.hpp"
+#include "common/List.hpp"
+#include "common/OptionList.hpp"
+#include "common/StringConversion.hpp"
+
+#include "math/MatrixTypes.hpp"
+#include "math/LSS/System.hpp"
+#include "math/LSS/MatrixFree/MatrixFreeMatrix.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/ShapeFunction.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/gausslegendre/Legendre.hpp"
+
+#include "solver/actions/SetupMatrixFreeOperator.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3::common;
+using namespace cf3::mesh;
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+  /// Tolerance to match local coordinates
+  const Real local_coordinates_tolerance = 1e-10;
+
+  /// Node layout of a tensor-product hexahedral shape function
+  struct TensorLayout
+  {
+    /// The distinct local coordinates along one direction, sorted
+    std::vector<Real> nodes_1d;
+    /// For each node in lexicographic order, the node index in the shape function
+    std::vector<Uint> permutation;
+  };
+
+  /// Index of x in the sorted nodes, or nodes.size() if absent
+  Uint find_node_1d(const std::vector<Real>& nodes, const Real x)
+  {
+    for(Uint i = 0; i != nodes.size(); ++i)
+      if(std::abs(nodes[i] - x) < local_coordinates_tolerance)
+        return i;
+    return nodes.size();
+  }
+
+  /// Value of the 1D Lagrange polynomial i on the given nodes
+  Real lagrange(const std::vector<Real>& nodes, const Uint i, const Real x)
+  {
+    Real result = 1.;
+    for(Uint j = 0; j != nodes.size(); ++j)
+      if(j != i)
+        result *= (x - nodes[j]) / (nodes[i] - nodes[j]);
+    return result;
+  }
+
+  /// Derivative of the 1D Lagrange polynomial i on the given nodes
+  Real lagrange_derivative(const std::vector<Real>& nodes, const Uint i, const Real x)
+  {
+    Real result = 0.;
+    for(Uint k = 0; k != nodes.size(); ++k)
+    {
+      if(k == i)
+        continue;
+      Real term = 1. / (nodes[i] - nodes[k]);
+      for(Uint j = 0; j != nodes.size(); ++j)
+        if(j != i && j != k)
+          term *= (x - nodes[j]) / (nodes[i] - nodes[j]);
+      result += term;
+    }
+    return result;
+  }
+
+  /// Build the lexicographic node layout of the shape function, checking that it is a tensor product of 1D Lagrange polynomials
+  TensorLayout tensor_layout(const ShapeFunction& sf)
+  {
+    if(sf.dimensionality() != 3 || sf.shape() != GeoShape::HEXA)
+      throw SetupError(FromHere(), "Matrix-free operators need hexahedral elements, but shape function " + sf.derived_type_name() + " is of shape " + sf.shape_name());
+
+    const RealMatrix& local_coords = sf.local_coordinates();
+    const Uint nb_nodes = local_coords.rows();
+
+    TensorLayout result;
+    for(Uint i = 0; i != nb_nodes; ++i)
+      if(find_node_1d(result.nodes_1d, local_coords(i, KSI)) == result.nodes_1d.size())
+        result.nodes_1d.push_back(local_coords(i, KSI));
+    std::sort(result.nodes_1d.begin(), result.nodes_1d.end());
+
+    const Uint nd = result.nodes_1d.size();
+    if(nd*nd*nd != nb_nodes)
+      throw SetupError(FromHere(), "Shape function " + sf.derived_type_name() + " does not have its nodes on a tensor-product grid");
+
+    result.permutation.assign(nb_nodes, nb_nodes);
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      const Uint ix = find_node_1d(result.nodes_1d, local_coords(i, KSI));
+      const Uint iy = find_node_1d(result.nodes_1d, local_coords(i, ETA));
+      const Uint iz = find_node_1d(result.nodes_1d, local_coords(i, ZTA));
+      if(ix == nd || iy == nd || iz == nd)
+        throw SetupError(FromHere(), "Shape function " + sf.derived_type_name() + " does not have its nodes on a tensor-product grid");
+      result.permutation[ix + nd*(iy + nd*iz)] = i;
+    }
+    if(std::find(result.permutation.begin(), result.permutation.end(), nb_nodes) != result.permutation.end())
+      throw SetupError(FromHere(), "Shape function " + sf.derived_type_name() + " has coinciding nodes");
+
+    // Check that the shape function is the product of the 1D Lagrange polynomials at an arbitrary point
+    RealVector test_point(3);
+    test_point << 0.31, -0.27, 0.73;
+    RealRowVector sf_values(nb_nodes);
+    sf.compute_value(test_point, sf_values);
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      const Uint node = result.permutation[i];
+      const Real tensor_value = lagrange(result.nodes_1d, i % nd, test_point[0]) * lagrange(result.nodes_1d, (i / nd) % nd, test_point[1]) * lagrange(result.nodes_1d, i / (nd*nd), test_point[2]);
+      if(std::abs(tensor_value - sf_values[node]) > 1e-8)
+        throw SetupError(FromHere(), "Shape function " + sf.derived_type_name() + " is not a tensor product of Lagrange polynomials");
+    }
+
+    return result;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < SetupMatrixFreeOperator, common::Action, LibActions > SetupMatrixFreeOperator_Builder;
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+SetupMatrixFreeOperator::SetupMatrixFreeOperator ( const std::string& name ) :
+  solver::Action(name),
+  m_quadrature_points(0u)
+{
+  options().add("lss", m_lss)
+    .pretty_name("LSS")
+    .description("Linear system with a MatrixFreeMatrix to set up")
+    .link_to(&m_lss)
+    .mark_basic();
+
+  options().add("dictionary", m_dictionary)
+    .pretty_name("Dictionary")
+    .description("Dictionary holding the unknowns. The geometry of the mesh is used if this is not set.")
+    .link_to(&m_dictionary);
+
+  options().add("quadrature_points", m_quadrature_points)
+    .pretty_name("Quadrature Points")
+    .description("Number of Gauss-Legendre points in each direction. If 0, the number of nodes in each direction is used.")
+    .link_to(&m_quadrature_points);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void SetupMatrixFreeOperator::execute()
+{
+  if(is_null(m_lss))
+    throw SetupError(FromHere(), "LSS not set for component " + uri().string());
+  if(!m_lss->is_created())
+    throw SetupError(FromHere(), "LSS " + m_lss->uri().path() + " must be created before setting up the matrix-free operator");
+
+  Handle<math::LSS::MatrixFreeMatrix> matrix(m_lss->matrix());
+  if(is_null(matrix))
+    throw SetupError(FromHere(), "SetupMatrixFreeOperator needs a MatrixFreeMatrix, but LSS " + m_lss->uri().path() + " has a " + m_lss->matrix()->derived_type_name());
+
+  const Dictionary& dict = is_null(m_dictionary) ? mesh().geometry_fields() : *m_dictionary;
+  Handle< List<int> const > used_node_map(m_lss->get_child("used_node_map"));
+
+  Uint nd = 0;
+  Uint nq = 0;
+  std::vector<Real> nodes_1d;
+  std::vector<Real> qdr_roots, qdr_weights;
+  std::vector<Uint> element_rows;
+  std::vector<Real> geometry;
+
+  RealVector mapped_coords(3);
+  RealMatrix jacobian(3, 3);
+  math::RealMatrix3 metric;
+  RealMatrix element_coords;
+
+  boost_foreach(const Handle<Region>& region, m_loop_regions)
+  {
+    boost_foreach(const Elements& elements, common::find_components_recursively_with_filter<Elements>(*region, IsElementsVolume()))
+    {
+      if(!dict.defined_for_entities(elements.handle<Entities>()))
+        continue;
+
+      const Space& space = dict.space(elements);
+      const detail::TensorLayout layout = detail::tensor_layout(space.shape_function());
+      if(nd == 0)
+      {
+        nodes_1d = layout.nodes_1d;
+        nd = nodes_1d.size();
+        nq = m_quadrature_points == 0 ? nd : m_quadrature_points;
+        const std::pair< std::vector<Real>, std::vector<Real> > qdr = gausslegendre::GaussLegendre(nq);
+        qdr_roots = qdr.first;
+        qdr_weights = qdr.second;
+      }
+      else if(layout.nodes_1d.size() != nd || !std::equal(nodes_1d.begin(), nodes_1d.end(), layout.nodes_1d.begin()))
+      {
+        throw SetupError(FromHere(), "All elements of a matrix-free operator must have the same nodes, but " + elements.uri().path() + " differs");
+      }
+
+      const Uint nb_dofs = nd*nd*nd;
+      const Uint nb_elems = elements.size();
+      const Connectivity& connectivity = space.connectivity();
+      const ElementType& etype = elements.element_type();
+      elements.geometry_space().allocate_coordinates(element_coords);
+      for(Uint elem = 0; elem != nb_elems; ++elem)
+      {
+        for(Uint i = 0; i != nb_dofs; ++i)
+        {
+          const Uint node = connectivity[elem][layout.permutation[i]];
+          const int row = is_null(used_node_map) ? static_cast<int>(node) : (*used_node_map)[node];
+          if(row < 0)
+            throw SetupError(FromHere(), "Node " + to_str(node) + " of " + elements.uri().path() + " is not in LSS " + m_lss->uri().path());
+          element_rows.push_back(static_cast<Uint>(row));
+        }
+
+        elements.geometry_space().put_coordinates(element_coords, elem);
+        for(Uint qz = 0; qz != nq; ++qz)
+        {
+          for(Uint qy = 0; qy != nq; ++qy)
+          {
+            for(Uint qx = 0; qx != nq; ++qx)
+            {
+              mapped_coords << qdr_roots[qx], qdr_roots[qy], qdr_roots[qz];
+              etype.compute_jacobian(mapped_coords, element_coords, jacobian);
+              metric = jacobian * jacobian.transpose();
+              const Real jxw = std::abs(jacobian.determinant()) * qdr_weights[qx] * qdr_weights[qy] * qdr_weights[qz];
+              const math::RealMatrix3 inverse_metric = jxw * metric.inverse();
+              geometry.push_back(jxw);
+              geometry.push_back(inverse_metric(0,0));
+              geometry.push_back(inverse_metric(0,1));
+              geometry.push_back(inverse_metric(0,2));
+              geometry.push_back(inverse_metric(1,1));
+              geometry.push_back(inverse_metric(1,2));
+              geometry.push_back(inverse_metric(2,2));
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if(nd == 0)
+    throw SetupError(FromHere(), "No hexahedral elements found for the matrix-free operator in the regions of " + uri().path());
+
+  std::vector<Real> values_1d(nq*nd), derivatives_1d(nq*nd);
+  for(Uint q = 0; q != nq; ++q)
+  {
+    for(Uint i = 0; i != nd; ++i)
+    {
+      values_1d[q*nd + i] = detail::lagrange(nodes_1d, i, qdr_roots[q]);
+      derivatives_1d[q*nd + i] = detail::lagrange_derivative(nodes_1d, i, qdr_roots[q]);
+    }
+  }
+
+  matrix->set_operator(nd, nq, values_1d, derivatives_1d, element_rows, geometry);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
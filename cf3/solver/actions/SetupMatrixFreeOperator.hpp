@@ -0,0 +1,65 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_SetupMatrixFreeOperator_hpp
+#define cf3_solver_actions_SetupMatrixFreeOperator_hpp
+
+#include "solver/Action.hpp"
+
+#include "solver/actions/LibActions.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+
+namespace math { namespace LSS { class System; } }
+namespace mesh { class Dictionary; }
+
+namespace solver {
+namespace actions {
+
+/// Fills a math::LSS::MatrixFreeMatrix with the elements of the regions of this action.
+/// The cells must be hexahedra with a tensor-product Lagrange shape function in the given dictionary, such as LagrangeP1::Hexa3D.
+/// The nodes of the shape function are sorted into lexicographic order and the 1D shape functions are derived from their
+/// local coordinates, so higher order tensor-product hexahedra are handled the same way. The geometric factors are computed
+/// at Gauss-Legendre points using the Jacobian of the geometry element type. The LSS must be created first, and a
+/// "used_node_map" child of the LSS is used to convert the node indices, as in Proto.
+class solver_actions_API SetupMatrixFreeOperator : public cf3::solver::Action {
+
+public: // functions
+  /// Contructor
+  /// @param name of the component
+  SetupMatrixFreeOperator ( const std::string& name );
+
+  /// Virtual destructor
+  virtual ~SetupMatrixFreeOperator() {}
+
+  /// Get the class name
+  static std::string type_name () { return "SetupMatrixFreeOperator"; }
+
+  /// execute the action
+  virtual void execute ();
+
+private: // data
+
+  /// The linear system to set up
+  Handle<math::LSS::System> m_lss;
+
+  /// Dictionary that holds the unknowns. The geometry of the mesh if null.
+  Handle<mesh::Dictionary> m_dictionary;
+
+  /// Number of Gauss points in each direction. If 0, the number of nodes in each direction is used.
+  Uint m_quadrature_points;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
+
+#endif // cf3_solver_actions_SetupMatrixFreeOperator_hpp
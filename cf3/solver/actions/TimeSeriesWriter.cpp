@@ -4,12 +4,28 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <deque>
+
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "common/Builder.hpp"
 #include "common/FindComponents.hpp"
+#include "common/Group.hpp"
+#include "common/Log.hpp"
 #include "common/OptionList.hpp"
+#include "common/Signal.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshWriter.hpp"
 
 #include "solver/actions/TimeSeriesWriter.hpp"
 #include "solver/Tags.hpp"
@@ -26,8 +42,161 @@ common::ComponentBuilder < TimeSeriesWriter, common::Action, LibActions > TimeSe
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
+class TimeSeriesWriter::Implementation
+{
+public:
+  /// Writes queued by one execution of the TimeSeriesWriter, using the fields of one staging buffer.
+  /// Everything the writers need is resolved into the snapshots before queueing, so the writer thread
+  /// never searches the component tree.
+  struct Job
+  {
+    Uint buffer;
+    std::vector< Handle<mesh::MeshWriter> > writers;
+    std::vector< boost::shared_ptr<mesh::MeshWriter::Snapshot const> > snapshots;
+  };
+
+  Implementation() :
+    started(false),
+    stop(false)
+  {
+  }
+
+  ~Implementation()
+  {
+    if(!started)
+      return;
+
+    {
+      boost::lock_guard<boost::mutex> lock(mutex);
+      stop = true;
+    }
+    job_condition.notify_one();
+    thread.join();
+  }
+
+  /// Start the writer thread, if it is not running yet. Must be called with the mutex locked.
+  void start()
+  {
+    if(started)
+      return;
+    thread = boost::thread(boost::bind(&Implementation::run, this));
+    started = true;
+  }
+
+  /// Writer thread main loop
+  void run()
+  {
+    while(true)
+    {
+      Job job;
+      {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while(jobs.empty() && !stop)
+          job_condition.wait(lock);
+        if(jobs.empty())
+          break;
+        job = jobs.front();
+      }
+
+      std::string job_error;
+      for(Uint i = 0; i != job.writers.size(); ++i)
+      {
+        try
+        {
+          job.writers[i]->write_snapshot(*job.snapshots[i]);
+        }
+        catch(std::exception& e)
+        {
+          job_error += "Error writing " + job.snapshots[i]->file_path.path() + ": " + e.what() + "\n";
+        }
+      }
+
+      {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        jobs.pop_front();
+        busy_buffers[job.buffer] = false;
+        error += job_error;
+      }
+      done_condition.notify_all();
+    }
+  }
+
+  /// Wait for a free staging buffer among the first nb_buffers ones and mark it as busy
+  Uint acquire_buffer(const Uint nb_buffers)
+  {
+    boost::unique_lock<boost::mutex> lock(mutex);
+    if(busy_buffers.size() < nb_buffers)
+      busy_buffers.resize(nb_buffers, false);
+    while(true)
+    {
+      const std::vector<bool>::iterator free_buffer = std::find(busy_buffers.begin(), busy_buffers.begin() + nb_buffers, false);
+      if(free_buffer != busy_buffers.begin() + nb_buffers)
+      {
+        *free_buffer = true;
+        return free_buffer - busy_buffers.begin();
+      }
+      done_condition.wait(lock);
+    }
+  }
+
+  /// Return a buffer that was acquired but not used in a job
+  void release_buffer(const Uint buffer)
+  {
+    boost::lock_guard<boost::mutex> lock(mutex);
+    busy_buffers[buffer] = false;
+  }
+
+  void queue(const Job& job)
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(mutex);
+      start();
+      jobs.push_back(job);
+    }
+    job_condition.notify_one();
+  }
+
+  /// Wait until the queue is empty
+  void wait()
+  {
+    boost::unique_lock<boost::mutex> lock(mutex);
+    while(!jobs.empty())
+      done_condition.wait(lock);
+  }
+
+  /// Throw the errors reported by the writer thread since the last call, if any
+  void check_error()
+  {
+    std::string current_error;
+    {
+      boost::lock_guard<boost::mutex> lock(mutex);
+      current_error.swap(error);
+    }
+    if(!current_error.empty())
+      throw common::FileSystemError(FromHere(), "Background time series write failed:\n" + current_error);
+  }
+
+  /// Protects all data below
+  boost::mutex mutex;
+  boost::condition_variable job_condition;
+  boost::condition_variable done_condition;
+
+  std::deque<Job> jobs;
+  std::vector<bool> busy_buffers;
+  std::string error;
+  bool started;
+  bool stop;
+
+  boost::thread thread;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+
 TimeSeriesWriter::TimeSeriesWriter ( const std::string& name ) :
-  common::Action(name)
+  common::Action(name),
+  m_asynchronous(false),
+  m_max_pending_writes(2),
+  m_implementation(new Implementation())
 {  
   options().add(Tags::time(), m_time)
     .pretty_name("Time")
@@ -40,6 +209,29 @@ TimeSeriesWriter::TimeSeriesWriter ( const std::string& name ) :
     .description("Write every interval timesteps")
     .mark_basic()
     .link_to(&m_interval);
+
+  options().add("asynchronous", m_asynchronous)
+    .pretty_name("Asynchronous")
+    .description("Write in a background thread, for the mesh writers that support it. The fields are copied into staging fields first.")
+    .link_to(&m_asynchronous);
+
+  options().add("max_pending_writes", m_max_pending_writes)
+    .pretty_name("Max Pending Writes")
+    .description("Number of sets of staging fields for asynchronous writes. Execution blocks when all of them are still being written.")
+    .link_to(&m_max_pending_writes);
+
+  regist_signal( "wait_for_writes" )
+    .connect( boost::bind( &TimeSeriesWriter::signal_wait_for_writes, this, _1 ) )
+    .description("Wait until all asynchronous writes are finished")
+    .pretty_name("Wait For Writes");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+TimeSeriesWriter::~TimeSeriesWriter()
+{
+  // Stops the writer thread after the queued writes, before the staging fields are destroyed
+  m_implementation.reset();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -57,6 +249,15 @@ void TimeSeriesWriter::execute()
   const std::string current_iter_str = common::to_str(current_iter);
 
 
+  // Writers used in the background must not be executed directly while their writes are pending
+  if(!m_asynchronous)
+    m_implementation->wait();
+  m_implementation->check_error();
+
+  Implementation::Job job;
+  std::vector<common::URI> background_file_paths;
+  std::vector<common::Action*> direct_actions;
+  std::vector<common::URI> direct_file_paths;
   BOOST_FOREACH(common::Action& action, common::find_components<common::Action>(*this))
   {
     if(action.options().check("file"))
@@ -65,11 +266,115 @@ void TimeSeriesWriter::execute()
       std::string rewritten_path = original_uri.path();
       boost::algorithm::replace_all(rewritten_path, "{time}", current_time_str);
       boost::algorithm::replace_all(rewritten_path, "{iteration}", current_iter_str);
-      action.options().set("file", common::URI(rewritten_path, original_uri.scheme()));
-      action.execute();
-      action.options().set("file", original_uri); // Set back the original URI, so we can replace the patterns on the next write
+      const common::URI rewritten_uri(rewritten_path, original_uri.scheme());
+
+      Handle<mesh::MeshWriter> writer(action.handle());
+      if(m_asynchronous && is_not_null(writer) && writer->supports_background_write())
+      {
+        job.writers.push_back(writer);
+        background_file_paths.push_back(rewritten_uri);
+      }
+      else
+      {
+        direct_actions.push_back(&action);
+        direct_file_paths.push_back(rewritten_uri);
+      }
     }
   }
+
+  // Stage the fields, resolve the mesh parts to write and queue the background writes first, so they overlap with the direct writes
+  if(!job.writers.empty())
+  {
+    if(m_max_pending_writes == 0)
+      throw common::BadValue(FromHere(), "Option max_pending_writes must be at least 1 for " + uri().path());
+
+    job.buffer = m_implementation->acquire_buffer(m_max_pending_writes);
+    try
+    {
+      for(Uint i = 0; i != job.writers.size(); ++i)
+        job.snapshots.push_back(job.writers[i]->prepare_write(stage_fields(*job.writers[i], job.buffer), background_file_paths[i]));
+    }
+    catch(...)
+    {
+      m_implementation->release_buffer(job.buffer);
+      throw;
+    }
+
+    BOOST_FOREACH(const common::URI& file_path, background_file_paths)
+      CFinfo << "Writing mesh " << file_path << " in the background" << CFendl;
+    m_implementation->queue(job);
+  }
+
+  for(Uint i = 0; i != direct_actions.size(); ++i)
+  {
+    common::Action& action = *direct_actions[i];
+    const common::URI original_uri = action.options().value<common::URI>("file");
+    action.options().set("file", direct_file_paths[i]);
+    action.execute();
+    action.options().set("file", original_uri); // Set back the original URI, so we can replace the patterns on the next write
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+std::vector< Handle<mesh::Field const> > TimeSeriesWriter::stage_fields(const mesh::MeshWriter& writer, const Uint buffer)
+{
+  const Handle<mesh::Mesh const> mesh = writer.options().value< Handle<mesh::Mesh const> >("mesh");
+  if(is_null(mesh))
+    throw common::SetupError(FromHere(), "Mesh was not configured in mesh-writer [" + writer.uri().string() + "]");
+
+  Handle<common::Group> staging(get_child("Staging"));
+  if(is_null(staging))
+    staging = create_component<common::Group>("Staging");
+  const std::string buffer_name = "Buffer" + common::to_str(buffer);
+  Handle<common::Group> buffer_group(staging->get_child(buffer_name));
+  if(is_null(buffer_group))
+    buffer_group = staging->create_component<common::Group>(buffer_name);
+
+  std::vector< Handle<mesh::Field const> > staged_fields;
+  BOOST_FOREACH(const common::URI& field_uri, writer.options().value< std::vector<common::URI> >("fields"))
+  {
+    Handle<mesh::Field const> field(mesh->access_component_checked(field_uri));
+    if(is_null(field))
+      throw common::ValueNotFound(FromHere(), "Invalid type of field URI [" + field_uri.string() + "]");
+
+    // One group per dictionary, since field names are only unique within their dictionary
+    mesh::Dictionary& dict = field->dict();
+    Handle<common::Group> dict_group(buffer_group->get_child(dict.name()));
+    if(is_null(dict_group))
+      dict_group = buffer_group->create_component<common::Group>(dict.name());
+    Handle<mesh::Field> staged(dict_group->get_child(field->name()));
+    if(is_null(staged))
+      staged = dict_group->create_component<mesh::Field>(field->name());
+
+    // The staging field shares the dictionary and variable descriptor of the original, and is only resized when needed
+    staged->set_dict(dict);
+    staged->set_descriptor(field->descriptor());
+    staged->set_var_type(field->var_type());
+    if(staged->row_size() != field->row_size())
+      staged->set_row_size(field->row_size());
+    if(staged->size() != field->size())
+      staged->resize(field->size());
+    staged->set_column_major(field->is_column_major());
+
+    std::copy(field->array().data(), field->array().data() + field->array().num_elements(), staged->array().data());
+    staged_fields.push_back(Handle<mesh::Field const>(staged));
+  }
+
+  return staged_fields;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void TimeSeriesWriter::wait_for_writes()
+{
+  m_implementation->wait();
+  m_implementation->check_error();
+}
+
+void TimeSeriesWriter::signal_wait_for_writes(common::SignalArgs& args)
+{
+  wait_for_writes();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
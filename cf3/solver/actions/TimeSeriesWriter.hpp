@@ -7,6 +7,8 @@
 #ifndef cf3_solver_actions_TimeSeriesWriter_hpp
 #define cf3_solver_actions_TimeSeriesWriter_hpp
 
+#include <boost/scoped_ptr.hpp>
+
 #include "common/Action.hpp"
 #include "solver/actions/LibActions.hpp"
 
@@ -15,6 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////
 
 namespace cf3 {
+namespace mesh { class Field; class MeshWriter; }
 namespace solver {
 namespace actions {
 
@@ -25,6 +28,15 @@ namespace actions {
 /// Filename templates can include {time} (with the{}) to include the current timestep and
 /// {iteration} to include the current iteration number
 /// The interval option controls the number of timesteps after which a solution is to be written
+///
+/// With the asynchronous option, mesh writers that support it write from a background thread. The selected
+/// fields are first copied into staging fields owned by this component, so the solver can continue to change
+/// the original fields while the output is written. Up to max_pending_writes sets of staging fields are reused
+/// between writes, and execute blocks until one of them is free again when the output falls behind.
+/// The regions, entities and fields to write are resolved before the write is queued, so the writer thread does not
+/// access the component tree and the tree may change freely while writes are pending. The mesh data itself (coordinates,
+/// connectivity) and the options of the writers are not copied, so these must not change while writes are pending.
+/// Writers that do not support background writes, as well as other actions with a "file" option, are still executed directly.
 class solver_actions_API TimeSeriesWriter : public common::Action
 {
 public: // functions
@@ -32,17 +44,33 @@ public: // functions
   /// @param name of the component
   TimeSeriesWriter ( const std::string& name );
 
-  /// Virtual destructor
-  virtual ~TimeSeriesWriter() {}
+  /// Virtual destructor. Waits for the pending writes to finish.
+  virtual ~TimeSeriesWriter();
 
   /// Get the class name
   static std::string type_name () { return "TimeSeriesWriter"; }
 
   /// execute the action
   virtual void execute();
+
+  /// Wait until all background writes are finished. Throws if one of them failed.
+  void wait_for_writes();
+
+  /// Signal to wait for the background writes
+  void signal_wait_for_writes(common::SignalArgs& args);
+
 private:
+  /// Copy the fields written by writer into the staging fields of the given buffer, returning the copies
+  std::vector< Handle<mesh::Field const> > stage_fields(const mesh::MeshWriter& writer, const Uint buffer);
+
   Handle<Time> m_time;
   Uint m_interval;
+  bool m_asynchronous;
+  Uint m_max_pending_writes;
+
+  /// Background writer thread and its queue
+  class Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -140,15 +140,17 @@ void TwoPointCorrelation::execute()
     m_y_corr.setZero();
     
     const Uint dim = m_field->row_size();
+    const Eigen::InnerStride<> sample_stride(m_sampled_values.strides()[1]);
+    typedef Eigen::Map<RealRowVector const, Eigen::Unaligned, Eigen::InnerStride<> > SampleMapT;
     
     for(Uint i = 0; i != nb_x_gids; ++i)
     {
-      const RealRowVector y_ref = Eigen::Map<RealRowVector const>(&m_sampled_values[i][0], dim);
+      const RealRowVector y_ref = SampleMapT(&m_sampled_values[i][0], dim, sample_stride);
       for(Uint j = 0; j != nb_y_gids; ++j)
       {
         const Uint x_ref_gid = nb_x_gids*j;
-        Eigen::Map<RealRowVector const> mapped_x_ref(&m_sampled_values[x_ref_gid][0], dim);
-        Eigen::Map<RealRowVector const> mapped_val(&m_sampled_values[x_ref_gid + i][0], dim);
+        SampleMapT mapped_x_ref(&m_sampled_values[x_ref_gid][0], dim, sample_stride);
+        SampleMapT mapped_val(&m_sampled_values[x_ref_gid + i][0], dim, sample_stride);
         m_x_corr.row(i).array() += mapped_x_ref.array() * mapped_val.array();
         m_y_corr.row(j).array() += y_ref.array() * mapped_val.array();
       }
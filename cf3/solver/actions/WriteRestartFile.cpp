@@ -4,6 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <map>
+
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 
@@ -14,6 +16,8 @@
 #include "common/BinaryDataWriter.hpp"
 #include "common/XML/FileOperations.hpp"
 
+#include "math/Consts.hpp"
+
 #include "mesh/Dictionary.hpp"
 #include "mesh/Mesh.hpp"
 #include "mesh/Field.hpp"
@@ -55,6 +59,15 @@ WriteRestartFile::WriteRestartFile ( const std::string& name ) :
     .pretty_name("Time")
     .description("Time component, used to extract timing and iteration information")
     .mark_basic();
+
+  options().add("shared_file", false)
+    .pretty_name("Shared File")
+    .description("Write the data of all ranks into a single binary file, using MPI-IO")
+    .mark_basic();
+
+  options().add("compress", true)
+    .pretty_name("Compress")
+    .description("Compress the binary data. Uncompressed files can be memory-mapped when reading.");
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -86,6 +99,8 @@ void WriteRestartFile::execute()
   const common::URI binfile = out_file_path.base_path() / (out_file_path.base_name() + ".cfbinxml");
   boost::shared_ptr<common::BinaryDataWriter> data_writer = common::allocate_component<common::BinaryDataWriter>("DataWriter");
   data_writer->options().set("file", binfile);
+  data_writer->options().set("shared_file", options().value<bool>("shared_file"));
+  data_writer->options().set("compress", options().value<bool>("compress"));
   
   common::XML::XmlDoc xml_doc("1.0", "ISO-8859-1");
   common::XML::XmlNode restart_node = xml_doc.add_node("restart");
@@ -97,6 +112,7 @@ void WriteRestartFile::execute()
   restart_node.set_attribute("iteration", common::to_str(time->iter()));
   
   const std::string base_path = mesh->uri().path() + "/";
+  std::map<const mesh::Dictionary*, Uint> glb_idx_blocks;
   
   BOOST_FOREACH(const Handle<mesh::Field>& field, fields)
   {
@@ -106,6 +122,39 @@ void WriteRestartFile::execute()
     cf3_assert(relative_path.size() == field->uri().path().size() - base_path.size());
     field_node.set_attribute("path", relative_path);
     field_node.set_attribute("index", common::to_str(data_writer->append_data(*field)));
+
+    // The global node indices allow restarting on a different number of CPUs
+    const mesh::Dictionary& dict = field->dict();
+    std::map<const mesh::Dictionary*, Uint>::iterator glb_idx_it = glb_idx_blocks.find(&dict);
+    if(glb_idx_it == glb_idx_blocks.end())
+      glb_idx_it = glb_idx_blocks.insert(std::make_pair(&dict, data_writer->append_data(dict.glb_idx()))).first;
+    field_node.set_attribute("glb_idx_index", common::to_str(glb_idx_it->second));
+
+    // Range of the global indices owned by each rank, so readers can skip the data of ranks they don't need
+    std::vector<Uint> my_range(2);
+    my_range[0] = math::Consts::uint_max();
+    my_range[1] = 0;
+    const Uint nb_rows = dict.size();
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      if(dict.is_ghost(i))
+        continue;
+      my_range[0] = std::min(my_range[0], dict.glb_idx()[i]);
+      my_range[1] = std::max(my_range[1], dict.glb_idx()[i]);
+    }
+    std::vector<Uint> ranges;
+    if(comm.is_active())
+      comm.all_gather(my_range, ranges);
+    else
+      ranges = my_range;
+
+    for(Uint rank = 0; rank != ranges.size()/2; ++rank)
+    {
+      common::XML::XmlNode rank_node = field_node.add_node("rank");
+      rank_node.set_attribute("index", common::to_str(rank));
+      rank_node.set_attribute("glb_min", common::to_str(ranges[2*rank]));
+      rank_node.set_attribute("glb_max", common::to_str(ranges[2*rank+1]));
+    }
   }
 
   if(comm.rank() == 0)
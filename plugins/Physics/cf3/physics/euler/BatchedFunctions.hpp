@@ -0,0 +1,250 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+/// @file BatchedFunctions.hpp
+/// @brief Approximate Riemann solvers for a batch of faces, for any dimension
+///
+/// The batched functions compute the fluxes of nb_faces faces at once. All arrays are stored
+/// as structure of arrays: variable eq of face f is found at index eq*nb_faces+f. This applies to
+/// the left and right conservative states (NDIM+2 variables), the unit normals (NDIM components)
+/// and the resulting fluxes (NDIM+2 variables). The wave speeds have one entry per face.
+/// The output arrays must not overlap with the input arrays.
+///
+/// The loop over the faces contains no branches and only works on contiguous arrays, so that the
+/// compiler can vectorise it. Whether it actually does is not verified by the build or the tests,
+/// and depends on the compiler and flags (std::sqrt needs -fno-math-errno with GCC). To check, compile
+/// euler2d/Functions.cpp with e.g. -O3 -fno-math-errno -fopt-info-vec-optimized and look for
+/// the loops of this file in the report. The dimension is a template parameter, making all inner loops
+/// over dimensions and equations fixed size. Use the non-template versions from the
+/// euler1d, euler2d and euler3d namespaces, which are compiled once in the library.
+///
+/// Contrary to the functions working on a single Data pair, the states must be physical
+/// (positive density and pressure), and all faces of a batch share the same specific heat ratio.
+
+#ifndef cf3_physics_euler_BatchedFunctions_hpp
+#define cf3_physics_euler_BatchedFunctions_hpp
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+#include "cf3/common/CF.hpp"
+
+/// Tells the compiler that the arrays of a batch do not overlap, which it needs to vectorise the loop over the faces
+#if defined(__GNUC__) || defined(_MSC_VER)
+  #define CF3_RESTRICT __restrict
+#else
+  #define CF3_RESTRICT
+#endif
+
+namespace cf3 {
+namespace physics {
+namespace euler {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+/// Primitive variables and convective flux of one state, kept in registers
+template <Uint NDIM>
+struct FaceState
+{
+  enum { NEQS = NDIM+2 };
+
+  Real cons[NEQS];
+  Real rho;
+  Real U[NDIM];
+  Real U2;
+  Real p;
+  Real H;
+  Real c;
+  Real un;
+  Real flux[NEQS];
+};
+
+/// Load the normal of face f
+template <Uint NDIM>
+inline void load_normal( const Real* normal, const std::size_t nb_faces, const std::size_t f, Real* n )
+{
+  for (Uint d=0; d<NDIM; ++d)
+    n[d] = normal[d*nb_faces+f];
+}
+
+/// Load the conservative state of face f and compute its convective flux
+template <Uint NDIM>
+inline void load_state( const Real gamma, const Real* cons, const Real* n, const std::size_t nb_faces, const std::size_t f,
+                        FaceState<NDIM>& s )
+{
+  for (Uint eq=0; eq<NDIM+2; ++eq)
+    s.cons[eq] = cons[eq*nb_faces+f];
+
+  s.rho = s.cons[0];
+  const Real inv_rho = 1./s.rho;
+  s.U2 = 0.;
+  s.un = 0.;
+  for (Uint d=0; d<NDIM; ++d)
+  {
+    s.U[d] = s.cons[1+d]*inv_rho;
+    s.U2 += s.U[d]*s.U[d];
+    s.un += s.U[d]*n[d];
+  }
+  s.p = (gamma-1.)*(s.cons[NDIM+1] - 0.5*s.rho*s.U2);
+  s.H = (s.cons[NDIM+1] + s.p)*inv_rho;
+  s.c = std::sqrt(gamma*s.p*inv_rho);
+
+  const Real rho_un = s.rho*s.un;
+  s.flux[0] = rho_un;
+  for (Uint d=0; d<NDIM; ++d)
+    s.flux[1+d] = rho_un*s.U[d] + s.p*n[d];
+  s.flux[NDIM+1] = rho_un*s.H;
+}
+
+/// Roe average of a left and right state
+template <Uint NDIM>
+inline void roe_average( const Real gamma, const FaceState<NDIM>& left, const FaceState<NDIM>& right, const Real* n,
+                         FaceState<NDIM>& roe )
+{
+  const Real sqrt_rhoL = std::sqrt(left.rho);
+  const Real sqrt_rhoR = std::sqrt(right.rho);
+  const Real inv_sum = 1./(sqrt_rhoL + sqrt_rhoR);
+  roe.rho = sqrt_rhoL*sqrt_rhoR;
+  roe.U2 = 0.;
+  roe.un = 0.;
+  for (Uint d=0; d<NDIM; ++d)
+  {
+    roe.U[d] = (sqrt_rhoL*left.U[d] + sqrt_rhoR*right.U[d])*inv_sum;
+    roe.U2 += roe.U[d]*roe.U[d];
+    roe.un += roe.U[d]*n[d];
+  }
+  roe.H = (sqrt_rhoL*left.H + sqrt_rhoR*right.H)*inv_sum;
+  roe.c = std::sqrt((gamma-1.)*(roe.H-0.5*roe.U2));
+  roe.p = roe.c*roe.c*roe.rho/gamma;
+}
+
+} // detail
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Rusanov Approximate Riemann solver for a batch of faces
+template <Uint NDIM>
+void compute_rusanov_fluxes( const Uint nb_faces, const Real gamma,
+                             const Real* CF3_RESTRICT left, const Real* CF3_RESTRICT right, const Real* CF3_RESTRICT normal,
+                             Real* CF3_RESTRICT flux, Real* CF3_RESTRICT wave_speed )
+{
+  // Indexing with std::size_t, as unsigned int arithmetic could wrap around and prevents vectorisation
+  const std::size_t n_faces = nb_faces;
+  for (std::size_t f=0; f<n_faces; ++f)
+  {
+    Real n[NDIM];
+    detail::FaceState<NDIM> L, R;
+    detail::load_normal<NDIM>(normal, n_faces, f, n);
+    detail::load_state<NDIM>(gamma, left,  n, n_faces, f, L);
+    detail::load_state<NDIM>(gamma, right, n, n_faces, f, R);
+
+    const Real ws = std::max(std::abs(L.un)+L.c, std::abs(R.un)+R.c);
+    for (Uint eq=0; eq<NDIM+2; ++eq)
+      flux[eq*n_faces+f] = 0.5*(L.flux[eq]+R.flux[eq]) - 0.5*ws*(R.cons[eq]-L.cons[eq]);
+    wave_speed[f] = ws;
+  }
+}
+
+/// @brief Roe Approximate Riemann solver for a batch of faces
+/// @note The upwind term is assembled directly from the wave strengths, without forming
+///       eigenvector matrices. This is equivalent to the single face version.
+template <Uint NDIM>
+void compute_roe_fluxes( const Uint nb_faces, const Real gamma,
+                         const Real* CF3_RESTRICT left, const Real* CF3_RESTRICT right, const Real* CF3_RESTRICT normal,
+                         Real* CF3_RESTRICT flux, Real* CF3_RESTRICT wave_speed )
+{
+  // Indexing with std::size_t, as unsigned int arithmetic could wrap around and prevents vectorisation
+  const std::size_t n_faces = nb_faces;
+  for (std::size_t f=0; f<n_faces; ++f)
+  {
+    Real n[NDIM];
+    detail::FaceState<NDIM> L, R, roe;
+    detail::load_normal<NDIM>(normal, n_faces, f, n);
+    detail::load_state<NDIM>(gamma, left,  n, n_faces, f, L);
+    detail::load_state<NDIM>(gamma, right, n, n_faces, f, R);
+    detail::roe_average<NDIM>(gamma, L, R, n, roe);
+
+    const Real drho = R.rho - L.rho;
+    const Real dp   = R.p   - L.p;
+    Real dU[NDIM];
+    Real dun = 0.;
+    Real roe_dU = 0.;
+    for (Uint d=0; d<NDIM; ++d)
+    {
+      dU[d] = R.U[d] - L.U[d];
+      dun += dU[d]*n[d];
+      roe_dU += roe.U[d]*dU[d];
+    }
+
+    // Wave strengths multiplied with the absolute wave speeds
+    const Real inv_c2 = 1./(roe.c*roe.c);
+    const Real lambda_un = std::abs(roe.un);
+    const Real entropy = lambda_un*(drho - dp*inv_c2);
+    const Real shear   = lambda_un*roe.rho;
+    const Real acoustic_plus  = std::abs(roe.un+roe.c)*0.5*(dp + roe.rho*roe.c*dun)*inv_c2;
+    const Real acoustic_minus = std::abs(roe.un-roe.c)*0.5*(dp - roe.rho*roe.c*dun)*inv_c2;
+
+    flux[f] = 0.5*(L.flux[0]+R.flux[0]) - 0.5*(entropy + acoustic_plus + acoustic_minus);
+    for (Uint d=0; d<NDIM; ++d)
+    {
+      flux[(1+d)*n_faces+f] = 0.5*(L.flux[1+d]+R.flux[1+d])
+          - 0.5*( entropy*roe.U[d]
+                + shear*(dU[d]-dun*n[d])
+                + acoustic_plus*(roe.U[d]+roe.c*n[d])
+                + acoustic_minus*(roe.U[d]-roe.c*n[d]) );
+    }
+    flux[(NDIM+1)*n_faces+f] = 0.5*(L.flux[NDIM+1]+R.flux[NDIM+1])
+        - 0.5*( entropy*0.5*roe.U2
+              + shear*(roe_dU-roe.un*dun)
+              + acoustic_plus*(roe.H+roe.c*roe.un)
+              + acoustic_minus*(roe.H-roe.c*roe.un) );
+
+    wave_speed[f] = lambda_un + roe.c;
+  }
+}
+
+/// @brief HLLE Approximate Riemann solver for a batch of faces
+/// @note The supersonic cases are handled by clipping the signal speeds to zero,
+///       instead of branching as in the single face version.
+template <Uint NDIM>
+void compute_hlle_fluxes( const Uint nb_faces, const Real gamma,
+                          const Real* CF3_RESTRICT left, const Real* CF3_RESTRICT right, const Real* CF3_RESTRICT normal,
+                          Real* CF3_RESTRICT flux, Real* CF3_RESTRICT wave_speed )
+{
+  // Indexing with std::size_t, as unsigned int arithmetic could wrap around and prevents vectorisation
+  const std::size_t n_faces = nb_faces;
+  for (std::size_t f=0; f<n_faces; ++f)
+  {
+    Real n[NDIM];
+    detail::FaceState<NDIM> L, R, roe;
+    detail::load_normal<NDIM>(normal, n_faces, f, n);
+    detail::load_state<NDIM>(gamma, left,  n, n_faces, f, L);
+    detail::load_state<NDIM>(gamma, right, n, n_faces, f, R);
+    detail::roe_average<NDIM>(gamma, L, R, n, roe);
+
+    // A zero left speed gives the left flux, a zero right speed the right flux
+    const Real wave_speed_left  = std::min(0., std::min(L.un-L.c, roe.un-roe.c));
+    const Real wave_speed_right = std::max(0., std::max(R.un+R.c, roe.un+roe.c));
+    const Real inv_span = 1./(wave_speed_right-wave_speed_left);
+    for (Uint eq=0; eq<NDIM+2; ++eq)
+    {
+      flux[eq*n_faces+f] = ( wave_speed_right*L.flux[eq] - wave_speed_left*R.flux[eq]
+                            + wave_speed_left*wave_speed_right*(R.cons[eq]-L.cons[eq]) ) * inv_span;
+    }
+    wave_speed[f] = std::abs(roe.un) + roe.c;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+} // euler
+} // physics
+} // cf3
+
+#endif // cf3_physics_euler_BatchedFunctions_hpp
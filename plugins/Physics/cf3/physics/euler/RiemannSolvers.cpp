@@ -0,0 +1,34 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include "cf3/common/Builder.hpp"
+
+#include "cf3/physics/euler/LibEuler.hpp"
+#include "cf3/physics/euler/RiemannSolvers.hpp"
+
+namespace cf3 {
+namespace physics {
+namespace euler {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < euler1d::RusanovRiemannSolver, euler1d::RusanovRiemannSolver::BaseT, LibEuler > Builder_RusanovRiemannSolver1D;
+common::ComponentBuilder < euler1d::RoeRiemannSolver,     euler1d::RoeRiemannSolver::BaseT,     LibEuler > Builder_RoeRiemannSolver1D;
+common::ComponentBuilder < euler1d::HLLERiemannSolver,    euler1d::HLLERiemannSolver::BaseT,    LibEuler > Builder_HLLERiemannSolver1D;
+
+common::ComponentBuilder < euler2d::RusanovRiemannSolver, euler2d::RusanovRiemannSolver::BaseT, LibEuler > Builder_RusanovRiemannSolver2D;
+common::ComponentBuilder < euler2d::RoeRiemannSolver,     euler2d::RoeRiemannSolver::BaseT,     LibEuler > Builder_RoeRiemannSolver2D;
+common::ComponentBuilder < euler2d::HLLERiemannSolver,    euler2d::HLLERiemannSolver::BaseT,    LibEuler > Builder_HLLERiemannSolver2D;
+
+common::ComponentBuilder < euler3d::RusanovRiemannSolver, euler3d::RusanovRiemannSolver::BaseT, LibEuler > Builder_RusanovRiemannSolver3D;
+common::ComponentBuilder < euler3d::RoeRiemannSolver,     euler3d::RoeRiemannSolver::BaseT,     LibEuler > Builder_RoeRiemannSolver3D;
+common::ComponentBuilder < euler3d::HLLERiemannSolver,    euler3d::HLLERiemannSolver::BaseT,    LibEuler > Builder_HLLERiemannSolver3D;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+} // euler
+} // physics
+} // cf3
@@ -0,0 +1,184 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+/// @file RiemannSolvers.hpp
+/// @brief Rusanov, Roe and HLLE Riemann solver components for the Euler equations in 1D, 2D and 3D
+
+#ifndef cf3_physics_euler_RiemannSolvers_hpp
+#define cf3_physics_euler_RiemannSolvers_hpp
+
+#include <vector>
+
+#include "cf3/common/StringConversion.hpp"
+
+#include "solver/RiemannSolver.hpp"
+
+#include "cf3/physics/euler/euler1d/Functions.hpp"
+#include "cf3/physics/euler/euler2d/Functions.hpp"
+#include "cf3/physics/euler/euler3d/Functions.hpp"
+
+namespace cf3 {
+namespace physics {
+namespace euler {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Rusanov flux functions, for use with RiemannSolverT
+struct RusanovFlux
+{
+  static std::string type_name() { return "Rusanov"; }
+
+  template <typename DATA, typename COLVEC, typename ROWVEC>
+  static void compute( const DATA& left, const DATA& right, const COLVEC& normal, ROWVEC& flux, Real& wave_speed )
+  {
+    compute_rusanov_flux(left, right, normal, flux, wave_speed);
+  }
+
+  template <Uint NDIM>
+  static void compute_batch( const Uint nb_faces, const Real gamma, const Real* left, const Real* right, const Real* normal,
+                             Real* flux, Real* wave_speed )
+  {
+    compute_rusanov_fluxes<NDIM>(nb_faces, gamma, left, right, normal, flux, wave_speed);
+  }
+};
+
+/// @brief Roe flux functions, for use with RiemannSolverT
+struct RoeFlux
+{
+  static std::string type_name() { return "Roe"; }
+
+  template <typename DATA, typename COLVEC, typename ROWVEC>
+  static void compute( const DATA& left, const DATA& right, const COLVEC& normal, ROWVEC& flux, Real& wave_speed )
+  {
+    compute_roe_flux(left, right, normal, flux, wave_speed);
+  }
+
+  template <Uint NDIM>
+  static void compute_batch( const Uint nb_faces, const Real gamma, const Real* left, const Real* right, const Real* normal,
+                             Real* flux, Real* wave_speed )
+  {
+    compute_roe_fluxes<NDIM>(nb_faces, gamma, left, right, normal, flux, wave_speed);
+  }
+};
+
+/// @brief HLLE flux functions, for use with RiemannSolverT
+struct HLLEFlux
+{
+  static std::string type_name() { return "HLLE"; }
+
+  template <typename DATA, typename COLVEC, typename ROWVEC>
+  static void compute( const DATA& left, const DATA& right, const COLVEC& normal, ROWVEC& flux, Real& wave_speed )
+  {
+    compute_hlle_flux(left, right, normal, flux, wave_speed);
+  }
+
+  template <Uint NDIM>
+  static void compute_batch( const Uint nb_faces, const Real gamma, const Real* left, const Real* right, const Real* normal,
+                             Real* flux, Real* wave_speed )
+  {
+    compute_hlle_fluxes<NDIM>(nb_faces, gamma, left, right, normal, flux, wave_speed);
+  }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Riemann solver component using the flux functions of FLUX
+///
+/// A batch of faces is packed into structure of arrays buffers, evaluated with the batched kernel
+/// from BatchedFunctions.hpp and unpacked again. The buffers are kept between calls, so a face
+/// loop that calls compute_riemann_fluxes with batches of the same size does not allocate.
+/// All faces of a batch must share the same specific heat ratio.
+/// The instantiations below are registered in the factory of their solver::RiemannSolver base,
+/// e.g. as "cf3.physics.euler.RoeRiemannSolver2D".
+template <typename DATA, Uint NB_DIM, typename FLUX>
+class RiemannSolverT : public solver::RiemannSolver<DATA, NB_DIM, NB_DIM+2>
+{
+public:
+  typedef solver::RiemannSolver<DATA, NB_DIM, NB_DIM+2> BaseT;
+  typedef typename BaseT::ColVector_NDIM ColVector_NDIM;
+  typedef typename BaseT::RowVector_NEQS RowVector_NEQS;
+  static const Uint NDIM = NB_DIM;
+  static const Uint NEQS = NB_DIM+2;
+
+  RiemannSolverT(const std::string& name) : BaseT(name) {}
+
+  virtual ~RiemannSolverT() {}
+
+  static std::string type_name () { return FLUX::type_name() + "RiemannSolver" + common::to_str(NB_DIM) + "D"; }
+
+  virtual void compute_riemann_flux( const DATA& left, const DATA& right, const ColVector_NDIM& normal,
+                                     RowVector_NEQS& flux, Real& wave_speed )
+  {
+    FLUX::compute(left, right, normal, flux, wave_speed);
+  }
+
+  virtual void compute_riemann_fluxes( const Uint nb_faces, const DATA* left, const DATA* right, const ColVector_NDIM* normal,
+                                       RowVector_NEQS* flux, Real* wave_speed )
+  {
+    if (nb_faces == 0)
+      return;
+
+    m_left.resize(NEQS*nb_faces);
+    m_right.resize(NEQS*nb_faces);
+    m_normal.resize(NDIM*nb_faces);
+    m_flux.resize(NEQS*nb_faces);
+
+    for (Uint f=0; f<nb_faces; ++f)
+    {
+      cf3_assert(left[f].gamma == left[0].gamma && right[f].gamma == left[0].gamma);
+      for (Uint eq=0; eq<NEQS; ++eq)
+      {
+        m_left[eq*nb_faces+f]  = left[f].cons[eq];
+        m_right[eq*nb_faces+f] = right[f].cons[eq];
+      }
+      for (Uint d=0; d<NDIM; ++d)
+        m_normal[d*nb_faces+f] = normal[f][d];
+    }
+
+    FLUX::template compute_batch<NDIM>(nb_faces, left[0].gamma, &m_left[0], &m_right[0], &m_normal[0], &m_flux[0], wave_speed);
+
+    for (Uint f=0; f<nb_faces; ++f)
+    {
+      for (Uint eq=0; eq<NEQS; ++eq)
+        flux[f][eq] = m_flux[eq*nb_faces+f];
+    }
+  }
+
+private:
+  /// Structure of arrays buffers, reused between batches
+  std::vector<Real> m_left;
+  std::vector<Real> m_right;
+  std::vector<Real> m_normal;
+  std::vector<Real> m_flux;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace euler1d {
+  typedef RiemannSolverT<Data, NDIM, RusanovFlux> RusanovRiemannSolver;
+  typedef RiemannSolverT<Data, NDIM, RoeFlux>     RoeRiemannSolver;
+  typedef RiemannSolverT<Data, NDIM, HLLEFlux>    HLLERiemannSolver;
+} // euler1d
+
+namespace euler2d {
+  typedef RiemannSolverT<Data, NDIM, RusanovFlux> RusanovRiemannSolver;
+  typedef RiemannSolverT<Data, NDIM, RoeFlux>     RoeRiemannSolver;
+  typedef RiemannSolverT<Data, NDIM, HLLEFlux>    HLLERiemannSolver;
+} // euler2d
+
+namespace euler3d {
+  typedef RiemannSolverT<Data, NDIM, RusanovFlux> RusanovRiemannSolver;
+  typedef RiemannSolverT<Data, NDIM, RoeFlux>     RoeRiemannSolver;
+  typedef RiemannSolverT<Data, NDIM, HLLEFlux>    HLLERiemannSolver;
+} // euler3d
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+} // euler
+} // physics
+} // cf3
+
+#endif // cf3_physics_euler_RiemannSolvers_hpp
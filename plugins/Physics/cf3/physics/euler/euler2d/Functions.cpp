@@ -200,6 +200,27 @@ void compute_hlle_flux( const Data& left, const Data& right, const ColVector_NDI
   compute_convective_wave_speed(roe,normal,wave_speed);
 }
 
+void compute_rusanov_fluxes( const Uint nb_faces, const Real gamma,
+                             const Real* left, const Real* right, const Real* normal,
+                             Real* flux, Real* wave_speed )
+{
+  euler::compute_rusanov_fluxes<NDIM>(nb_faces, gamma, left, right, normal, flux, wave_speed);
+}
+
+void compute_roe_fluxes( const Uint nb_faces, const Real gamma,
+                         const Real* left, const Real* right, const Real* normal,
+                         Real* flux, Real* wave_speed )
+{
+  euler::compute_roe_fluxes<NDIM>(nb_faces, gamma, left, right, normal, flux, wave_speed);
+}
+
+void compute_hlle_fluxes( const Uint nb_faces, const Real gamma,
+                          const Real* left, const Real* right, const Real* normal,
+                          Real* flux, Real* wave_speed )
+{
+  euler::compute_hlle_fluxes<NDIM>(nb_faces, gamma, left, right, normal, flux, wave_speed);
+}
+
 void compute_specific_entropy( const Data& p, Real& specific_entropy)
 {
   // Compute specific entropy from primitive variables
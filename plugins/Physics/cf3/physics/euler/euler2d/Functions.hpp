@@ -14,6 +14,7 @@
 #define cf3_physics_euler_euler2d_Functions_hpp
 
 #include "cf3/physics/euler/euler2d/Data.hpp"
+#include "cf3/physics/euler/BatchedFunctions.hpp"
 
 namespace cf3 {
 namespace physics {
@@ -65,6 +66,24 @@ void compute_roe_flux( const Data& left, const Data& right, const ColVector_NDIM
 void compute_hlle_flux( const Data& left, const Data& right, const ColVector_NDIM& normal,
                         RowVector_NEQS& flux, Real& wave_speed );
 
+/// @brief Rusanov Approximate Riemann solver for a batch of faces
+/// @see BatchedFunctions.hpp for the storage layout
+void compute_rusanov_fluxes( const Uint nb_faces, const Real gamma,
+                             const Real* left, const Real* right, const Real* normal,
+                             Real* flux, Real* wave_speed );
+
+/// @brief Roe Approximate Riemann solver for a batch of faces
+/// @see BatchedFunctions.hpp for the storage layout
+void compute_roe_fluxes( const Uint nb_faces, const Real gamma,
+                         const Real* left, const Real* right, const Real* normal,
+                         Real* flux, Real* wave_speed );
+
+/// @brief HLLE Approximate Riemann solver for a batch of faces
+/// @see BatchedFunctions.hpp for the storage layout
+void compute_hlle_fluxes( const Uint nb_faces, const Real gamma,
+                          const Real* left, const Real* right, const Real* normal,
+                          Real* flux, Real* wave_speed );
+
 /// @brief Compute the specific entropy from the primitive variables
 void compute_specific_entropy( const Data& p, Real& specific_entropy );
 
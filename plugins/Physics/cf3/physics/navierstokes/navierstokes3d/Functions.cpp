@@ -0,0 +1,65 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include "cf3/physics/navierstokes/navierstokes3d/Functions.hpp"
+#include "cf3/math/Defs.hpp"
+#include "cf3/common/BasicExceptions.hpp"
+
+namespace cf3 {
+namespace physics {
+namespace navierstokes {
+namespace navierstokes3d {
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void compute_diffusive_flux( const Data& p, const ColVector_NDIM& normal,
+                             RowVector_NEQS& flux, Real& wave_speed )
+{
+  compute_diffusive_flux(p,normal,flux);
+  compute_diffusive_wave_speed(p,normal,wave_speed);
+}
+    
+void compute_diffusive_flux( const Data& p, const ColVector_NDIM& normal,
+                             RowVector_NEQS& flux )
+{
+  const Real& nx = normal[XX];
+  const Real& ny = normal[YY];
+  const Real& nz = normal[ZZ];
+
+  Real two_third_divergence_U = 2./3.*(p.grad_u[XX] + p.grad_v[YY] + p.grad_w[ZZ]);
+
+  // Viscous stress tensor
+  // tau_ij = mu ( du_i/dx_j + du_j/dx_i - delta_ij 2/3 div(u) )
+  Real tau_xx = p.mu*(2.*p.grad_u[XX] - two_third_divergence_U);
+  Real tau_yy = p.mu*(2.*p.grad_v[YY] - two_third_divergence_U);
+  Real tau_zz = p.mu*(2.*p.grad_w[ZZ] - two_third_divergence_U);
+  Real tau_xy = p.mu*(p.grad_u[YY] + p.grad_v[XX]);
+  Real tau_xz = p.mu*(p.grad_u[ZZ] + p.grad_w[XX]);
+  Real tau_yz = p.mu*(p.grad_v[ZZ] + p.grad_w[YY]);
+
+  // Heat flux
+  Real heat_flux = -p.kappa*(p.grad_T[XX]*nx + p.grad_T[YY]*ny + p.grad_T[ZZ]*nz);
+
+  flux[0] = 0.;
+  flux[1] = tau_xx*nx + tau_xy*ny + tau_xz*nz;
+  flux[2] = tau_xy*nx + tau_yy*ny + tau_yz*nz;
+  flux[3] = tau_xz*nx + tau_yz*ny + tau_zz*nz;
+  flux[4] = p.U[XX]*flux[1] + p.U[YY]*flux[2] + p.U[ZZ]*flux[3] - heat_flux;
+}
+
+void compute_diffusive_wave_speed( const Data& p, const ColVector_NDIM& normal,
+                                   Real& wave_speed )
+{
+  // maximum of kinematic viscosity nu and thermal diffusivity alpha
+  wave_speed = std::max(p.mu/p.rho, p.kappa/(p.rho*p.Cp));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+} // navierstokes3d
+} // navierstokes
+} // physics
+} // cf3
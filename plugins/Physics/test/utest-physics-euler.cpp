@@ -8,6 +8,7 @@
 #define BOOST_TEST_MODULE "Test module for cf3::Euler"
 
 #include <iostream>
+#include <vector>
 #include <boost/test/unit_test.hpp>
 
 #include "math/Defs.hpp"
@@ -17,6 +18,8 @@
 #include "cf3/common/Environment.hpp"
 #include "cf3/physics/euler/euler1d/Functions.hpp"
 #include "cf3/physics/euler/euler2d/Functions.hpp"
+#include "cf3/physics/euler/euler3d/Functions.hpp"
+#include "cf3/physics/euler/RiemannSolvers.hpp"
 
 using namespace std;
 using namespace cf3;
@@ -25,6 +28,118 @@ using namespace cf3::physics::euler;
 
 //////////////////////////////////////////////////////////////////////////////
 
+/// Compare a batched Riemann solver with its single face version, on faces with
+/// subsonic and supersonic flow in both directions and normals in all directions
+template <typename DATA, typename COLVEC, typename ROWVEC>
+void check_batched_flux( void (*single_flux)( const DATA&, const DATA&, const COLVEC&, ROWVEC&, Real& ),
+                         void (*batched_flux)( const Uint, const Real, const Real*, const Real*, const Real*, Real*, Real* ) )
+{
+  const Uint ndim = COLVEC::RowsAtCompileTime;
+  const Uint neqs = ROWVEC::ColsAtCompileTime;
+  const Uint nb_faces = 37;
+  const Real gamma = 1.4;
+
+  std::vector<DATA> left(nb_faces), right(nb_faces);
+  std::vector<COLVEC> normals(nb_faces);
+  std::vector<Real> left_soa(neqs*nb_faces), right_soa(neqs*nb_faces), normal_soa(ndim*nb_faces);
+  for (Uint f=0; f<nb_faces; ++f)
+  {
+    ROWVEC prim_left, prim_right;
+    prim_left[0]  = 1. + 0.5*std::sin(0.3*f);
+    prim_right[0] = 1. + 0.5*std::cos(0.7*f);
+    for (Uint d=0; d<ndim; ++d)
+    {
+      prim_left[1+d]  = 600.*std::sin(1.3*f+d);
+      prim_right[1+d] = 600.*std::cos(0.9*f+2.*d);
+      normals[f][d] = std::sin(2.1*f+1.7*d+0.5);
+    }
+    prim_left[ndim+1]  = 1e5*(1.+0.5*std::cos(0.4*f));
+    prim_right[ndim+1] = 1e5*(1.+0.5*std::sin(0.2*f));
+    normals[f].normalize();
+
+    left[f].gamma = gamma;   left[f].R = 287.05;   left[f].compute_from_primitive(prim_left);
+    right[f].gamma = gamma;  right[f].R = 287.05;  right[f].compute_from_primitive(prim_right);
+    for (Uint eq=0; eq<neqs; ++eq)
+    {
+      left_soa[eq*nb_faces+f]  = left[f].cons[eq];
+      right_soa[eq*nb_faces+f] = right[f].cons[eq];
+    }
+    for (Uint d=0; d<ndim; ++d)
+      normal_soa[d*nb_faces+f] = normals[f][d];
+  }
+
+  std::vector<Real> flux_soa(neqs*nb_faces), wave_speeds(nb_faces);
+  batched_flux(nb_faces, gamma, &left_soa[0], &right_soa[0], &normal_soa[0], &flux_soa[0], &wave_speeds[0]);
+
+  for (Uint f=0; f<nb_faces; ++f)
+  {
+    ROWVEC flux;
+    Real wave_speed;
+    single_flux(left[f], right[f], normals[f], flux, wave_speed);
+    for (Uint eq=0; eq<neqs; ++eq)
+      BOOST_CHECK_SMALL( flux_soa[eq*nb_faces+f] - flux[eq], 1e-8*(1.+std::abs(flux[eq])) );
+    BOOST_CHECK_CLOSE( wave_speeds[f], wave_speed, 1e-8 );
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// Compare the batched entry point of a Riemann solver component with its single face version,
+/// for two batch sizes so that the packing buffers are reused
+template <typename SOLVER>
+void check_riemann_solver()
+{
+  typedef typename SOLVER::Data DATA;
+  typedef typename SOLVER::ColVector_NDIM COLVEC;
+  typedef typename SOLVER::RowVector_NEQS ROWVEC;
+  const Uint ndim = SOLVER::NDIM;
+  const Uint neqs = SOLVER::NEQS;
+
+  boost::shared_ptr<typename SOLVER::BaseT> solver =
+      build_component_abstract_type<typename SOLVER::BaseT>("cf3.physics.euler."+SOLVER::type_name(), "solver");
+  BOOST_CHECK( is_not_null( boost::dynamic_pointer_cast<SOLVER>(solver).get() ) );
+
+  for (Uint nb_faces=23; nb_faces<=29; nb_faces+=6)
+  {
+    std::vector<DATA> left(nb_faces), right(nb_faces);
+    std::vector<COLVEC> normals(nb_faces);
+    for (Uint f=0; f<nb_faces; ++f)
+    {
+      ROWVEC prim_left, prim_right;
+      prim_left[0]  = 1. + 0.5*std::sin(0.3*f);
+      prim_right[0] = 1. + 0.5*std::cos(0.7*f);
+      for (Uint d=0; d<ndim; ++d)
+      {
+        prim_left[1+d]  = 600.*std::sin(1.3*f+d);
+        prim_right[1+d] = 600.*std::cos(0.9*f+2.*d);
+        normals[f][d] = std::sin(2.1*f+1.7*d+0.5);
+      }
+      prim_left[ndim+1]  = 1e5*(1.+0.5*std::cos(0.4*f));
+      prim_right[ndim+1] = 1e5*(1.+0.5*std::sin(0.2*f));
+      normals[f].normalize();
+
+      left[f].gamma = 1.4;   left[f].R = 287.05;   left[f].compute_from_primitive(prim_left);
+      right[f].gamma = 1.4;  right[f].R = 287.05;  right[f].compute_from_primitive(prim_right);
+    }
+
+    std::vector<ROWVEC> fluxes(nb_faces);
+    std::vector<Real> wave_speeds(nb_faces);
+    solver->compute_riemann_fluxes(nb_faces, &left[0], &right[0], &normals[0], &fluxes[0], &wave_speeds[0]);
+
+    for (Uint f=0; f<nb_faces; ++f)
+    {
+      ROWVEC flux;
+      Real wave_speed;
+      solver->compute_riemann_flux(left[f], right[f], normals[f], flux, wave_speed);
+      for (Uint eq=0; eq<neqs; ++eq)
+        BOOST_CHECK_SMALL( fluxes[f][eq] - flux[eq], 1e-8*(1.+std::abs(flux[eq])) );
+      BOOST_CHECK_CLOSE( wave_speeds[f], wave_speed, 1e-8 );
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_SUITE( Euler_Suite )
 
 //////////////////////////////////////////////////////////////////////////////
@@ -243,6 +358,80 @@ BOOST_AUTO_TEST_CASE( Test_Euler2D_SymmetryBCs )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( Test_Euler3D_riemann )
+{
+  // A 3D state without z-velocity and a normal in the xy-plane must give the 2D fluxes
+  euler2d::Data pL2, pR2;
+  euler3d::Data pL3, pR3;
+  pL2.gamma=1.4; pR2.gamma=1.4; pL3.gamma=1.4; pR3.gamma=1.4;
+  pL2.R=287.05;  pR2.R=287.05;  pL3.R=287.05;  pR3.R=287.05;
+
+  euler2d::RowVector_NEQS prim_left2, prim_right2;
+  prim_left2  << 4.696,  50, -20, 404400; pL2.compute_from_primitive(prim_left2);
+  prim_right2 << 1.408, -30,  70, 101100; pR2.compute_from_primitive(prim_right2);
+  euler3d::RowVector_NEQS prim_left3, prim_right3;
+  prim_left3  << 4.696,  50, -20, 0., 404400; pL3.compute_from_primitive(prim_left3);
+  prim_right3 << 1.408, -30,  70, 0., 101100; pR3.compute_from_primitive(prim_right3);
+
+  euler2d::ColVector_NDIM normal2; normal2 << 0.6, 0.8;
+  euler3d::ColVector_NDIM normal3; normal3 << 0.6, 0.8, 0.;
+
+  euler2d::RowVector_NEQS flux2;
+  euler3d::RowVector_NEQS flux3;
+  Real wave_speed2, wave_speed3;
+
+  compute_roe_flux( pL2, pR2, normal2, flux2, wave_speed2 );
+  compute_roe_flux( pL3, pR3, normal3, flux3, wave_speed3 );
+  BOOST_CHECK_CLOSE( flux3[0], flux2[0], 1e-8 );
+  BOOST_CHECK_CLOSE( flux3[1], flux2[1], 1e-8 );
+  BOOST_CHECK_CLOSE( flux3[2], flux2[2], 1e-8 );
+  BOOST_CHECK_SMALL( flux3[3], 1e-8 );
+  BOOST_CHECK_CLOSE( flux3[4], flux2[3], 1e-8 );
+  BOOST_CHECK_CLOSE( wave_speed3, wave_speed2, 1e-8 );
+
+  // Conservation
+  euler3d::RowVector_NEQS flux_neg;
+  compute_roe_flux( pR3, pL3, -normal3, flux_neg, wave_speed3 );
+  for (Uint eq=0; eq<euler3d::NEQS; ++eq)
+    BOOST_CHECK_SMALL( flux3[eq] + flux_neg[eq], 1e-8*(1.+std::abs(flux3[eq])) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Test_batched_riemann )
+{
+  check_batched_flux( euler1d::compute_rusanov_flux, euler1d::compute_rusanov_fluxes );
+  check_batched_flux( euler1d::compute_roe_flux,     euler1d::compute_roe_fluxes );
+  check_batched_flux( euler1d::compute_hlle_flux,    euler1d::compute_hlle_fluxes );
+
+  check_batched_flux( euler2d::compute_rusanov_flux, euler2d::compute_rusanov_fluxes );
+  check_batched_flux( euler2d::compute_roe_flux,     euler2d::compute_roe_fluxes );
+  check_batched_flux( euler2d::compute_hlle_flux,    euler2d::compute_hlle_fluxes );
+
+  check_batched_flux( euler3d::compute_rusanov_flux, euler3d::compute_rusanov_fluxes );
+  check_batched_flux( euler3d::compute_roe_flux,     euler3d::compute_roe_fluxes );
+  check_batched_flux( euler3d::compute_hlle_flux,    euler3d::compute_hlle_fluxes );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Test_riemann_solver_components )
+{
+  check_riemann_solver<euler1d::RusanovRiemannSolver>();
+  check_riemann_solver<euler1d::RoeRiemannSolver>();
+  check_riemann_solver<euler1d::HLLERiemannSolver>();
+
+  check_riemann_solver<euler2d::RusanovRiemannSolver>();
+  check_riemann_solver<euler2d::RoeRiemannSolver>();
+  check_riemann_solver<euler2d::HLLERiemannSolver>();
+
+  check_riemann_solver<euler3d::RusanovRiemannSolver>();
+  check_riemann_solver<euler3d::RoeRiemannSolver>();
+  check_riemann_solver<euler3d::HLLERiemannSolver>();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ////////////////////////////////////////////////////////////////////////////////
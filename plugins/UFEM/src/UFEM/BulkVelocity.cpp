@@ -16,6 +16,7 @@
 #include "common/Builder.hpp"
 #include "common/OptionT.hpp"
 #include "common/EventHandler.hpp"
+#include "common/PE/ReductionBatch.hpp"
 #include "common/XML/SignalOptions.hpp"
 
 #include "math/LSS/System.hpp"
@@ -144,15 +145,12 @@ void BulkVelocity::execute()
   solver::actions::Proto::ProtoAction::execute();
   
   //TODO: Stop this from counting overlapping faces twice
-  Real global_integral = m_integral_value;
-  Real global_area = m_area;
-  
-  if(common::PE::Comm::instance().is_active())
-  {
-    common::PE::Comm::instance().all_reduce(common::PE::plus(), &m_integral_value, 1, &global_integral);
-    common::PE::Comm::instance().all_reduce(common::PE::plus(), &m_area, 1, &global_area);
-  }
-  m_result = global_integral / global_area;
+  // Integral and area are summed in a single collective
+  common::PE::ReductionBatch batch;
+  const Uint integral_idx = batch.add_sum(m_integral_value);
+  const Uint area_idx = batch.add_sum(m_area);
+  batch.execute();
+  m_result = batch.result(integral_idx) / batch.result(area_idx);
 
   m_changing_result = true;
   options().set("result", m_result);
@@ -9,6 +9,7 @@
 #include "common/OptionList.hpp"
 #include "common/OptionT.hpp"
 #include "common/PropertyList.hpp"
+#include "common/PE/ReductionBatch.hpp"
 
 #include "solver/actions/Proto/ProtoAction.hpp"
 #include "solver/actions/Proto/Expression.hpp"
@@ -34,7 +35,8 @@ ComponentBuilder< CriterionConvergence, Criterion, LibUFEM > CriterionConvergenc
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 CriterionConvergence::CriterionConvergence( const std::string& name  ) :
-  Criterion ( name )
+  Criterion ( name ),
+  m_collected(false)
 {
   // properties
 
@@ -75,6 +77,33 @@ add_component(create_proto_action("GetMaxFluidTemperature", nodes_expression (
 
 CriterionConvergence::~CriterionConvergence() {}
 
+void CriterionConvergence::contribute(common::PE::ReductionBatch& batch)
+{
+  m_min_error = 0.;
+  m_max_error = 0.;
+  m_cond_temperature = 0.;
+  m_fluid_temperature = 0.;
+
+  Handle<common::Action>(get_child("ComputeMinError"))->execute();
+  Handle<common::Action>(get_child("ComputeMaxError"))->execute();
+  Handle<common::Action>(get_child("GetMaxFluidTemperature"))->execute();
+  Handle<common::Action>(get_child("GetMaxCondTemperature"))->execute();
+
+  m_min_error_idx = batch.add_min(m_min_error);
+  m_max_error_idx = batch.add_max(m_max_error);
+  m_fluid_temperature_idx = batch.add_max(m_fluid_temperature);
+  m_cond_temperature_idx = batch.add_max(m_cond_temperature);
+}
+
+void CriterionConvergence::collect(const common::PE::ReductionBatch& batch)
+{
+  m_min_error = batch.result(m_min_error_idx);
+  m_max_error = batch.result(m_max_error_idx);
+  m_fluid_temperature = batch.result(m_fluid_temperature_idx);
+  m_cond_temperature = batch.result(m_cond_temperature_idx);
+  m_collected = true;
+}
+
 bool CriterionConvergence::operator()()
 {
 
@@ -83,18 +112,18 @@ bool CriterionConvergence::operator()()
     convergence_history.open ("convergence_history_temperature.txt",std::ios_base::app);
     convergence_history << m_max_error << "\n"; */
 
-  m_min_error = 0.;
-  m_max_error = 0.;
-  m_cond_temperature = 0.;
-  m_fluid_temperature = 0.;
-
   Handle<Iterate> iterate(m_iter_comp);
 
+  // Outside of a loop that shares its reduction, the extrema are reduced here, so all processes take the same decision
+  if(!m_collected)
+  {
+    common::PE::ReductionBatch batch;
+    contribute(batch);
+    batch.execute();
+    collect(batch);
+  }
+  m_collected = false;
 
-  Handle<common::Action>(get_child("ComputeMinError"))->execute();
-  Handle<common::Action>(get_child("ComputeMaxError"))->execute();
-  Handle<common::Action>(get_child("GetMaxFluidTemperature"))->execute();
-  Handle<common::Action>(get_child("GetMaxCondTemperature"))->execute();
  /* std::cout << "min error is " << m_min_error << std::endl;
   std::cout << "max error is " << m_max_error << std::endl;
   std::cout << "max conduction temperature is " << m_cond_temperature << std::endl;
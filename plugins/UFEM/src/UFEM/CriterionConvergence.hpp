@@ -37,6 +37,12 @@ public: // functions
   /// Get the class name
   static std::string type_name () { return "CriterionConvergence"; }
 
+  /// Compute the local errors and temperature extrema and add them to the batch
+  virtual void contribute(common::PE::ReductionBatch& batch);
+
+  /// Read the global errors and temperature extrema
+  virtual void collect(const common::PE::ReductionBatch& batch);
+
   /// Simulates this model
   virtual bool operator()();
 
@@ -53,6 +59,14 @@ private:
   Real m_cond_temperature;
   Real m_fluid_temperature;
 
+  /// Indices of the values in the batch passed to contribute
+  Uint m_min_error_idx;
+  Uint m_max_error_idx;
+  Uint m_cond_temperature_idx;
+  Uint m_fluid_temperature_idx;
+
+  /// True if the global values were collected from a batch reduced by the owning loop
+  bool m_collected;
 
 };
 
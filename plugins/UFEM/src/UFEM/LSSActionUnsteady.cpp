@@ -12,6 +12,9 @@
 #include "common/Option.hpp"
 #include "common/OptionList.hpp"
 
+#include "math/LSS/Matrix.hpp"
+#include "math/LSS/System.hpp"
+
 #include "mesh/Dictionary.hpp"
 #include "mesh/Field.hpp"
 
@@ -35,6 +38,10 @@ LSSActionUnsteady::LSSActionUnsteady(const std::string& name) :
     .description("Component that keeps track of time for this simulation")
     .attach_trigger(boost::bind(&LSSActionUnsteady::trigger_time, this))
     .link_to(&m_time);
+
+  options().add("matrix_assembly_plan", true)
+    .pretty_name("Matrix Assembly Plan")
+    .description("Reuse the location of each assembled block in the system matrix between time steps, if the matrix supports it. Turn this off when the mesh changes during the simulation.");
 }
 
 LSSActionUnsteady::~LSSActionUnsteady()
@@ -56,6 +63,16 @@ const solver::Time& LSSActionUnsteady::time() const
   return *m_time;
 }
 
+void LSSActionUnsteady::do_create_lss(PE::CommPattern& cp, const math::VariablesDescriptor& vars, std::vector<Uint>& node_connectivity, std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+{
+  LSSAction::do_create_lss(cp, vars, node_connectivity, starting_indices, periodic_links_nodes, periodic_links_active);
+
+  // The same blocks are added in the same order at every time step, so the matrix can replay their locations
+  Handle<math::LSS::Matrix> matrix = options().value< Handle<math::LSS::System> >("lss")->matrix();
+  if(options().value<bool>("matrix_assembly_plan") && matrix->options().check("assembly_plan"))
+    matrix->options().set("assembly_plan", true);
+}
+
 void LSSActionUnsteady::trigger_time()
 {
   if(is_null(m_time))
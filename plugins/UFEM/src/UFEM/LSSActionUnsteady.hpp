@@ -42,6 +42,10 @@ public: // functions
 
   const solver::Time& time() const;
 
+protected:
+  /// Enables the assembly plan on the system matrix, if it supports one
+  virtual void do_create_lss(common::PE::CommPattern& cp, const math::VariablesDescriptor& vars, std::vector<Uint>& node_connectivity, std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active);
+
 private:
 
   void trigger_time();
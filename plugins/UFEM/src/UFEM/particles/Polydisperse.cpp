@@ -133,8 +133,10 @@ struct DNSCollisionKernel
   {
     const Real vol_alpha = (*m_weighted_volume_fields[alpha])[node_idx][0] / (*m_concentration_fields[alpha])[node_idx][0] * m_reference_volume;
     const Real vol_gamma = (*m_weighted_volume_fields[gamma])[node_idx][0] / (*m_concentration_fields[gamma])[node_idx][0] * m_reference_volume;
-    const Eigen::Map<VectorT const> v_alpha(&m_particle_velocity_field[node_idx][alpha*dim]);
-    const Eigen::Map<VectorT const> v_gamma(&m_particle_velocity_field[node_idx][gamma*dim]);
+    // The fields may be stored column major, so the maps follow the array strides
+    const Eigen::InnerStride<> velocity_stride(m_particle_velocity_field.array().strides()[1]);
+    const Eigen::Map<VectorT const, Eigen::Unaligned, Eigen::InnerStride<> > v_alpha(&m_particle_velocity_field[node_idx][alpha*dim], velocity_stride);
+    const Eigen::Map<VectorT const, Eigen::Unaligned, Eigen::InnerStride<> > v_gamma(&m_particle_velocity_field[node_idx][gamma*dim], velocity_stride);
     const Real r_alpha = ::pow(3./(4.*pi())*vol_alpha, 1./3.);
     const Real r_gamma = ::pow(3./(4.*pi())*vol_gamma,1./3.);
     const Real r_col_3 = pow_int(r_alpha + r_gamma, 3); // Collision radius ^3
@@ -143,7 +145,8 @@ struct DNSCollisionKernel
     const Real beta1 = (v_alpha - v_gamma).norm() * pi() * pow_int(r_alpha + r_gamma, 2);
 
     // Velocity gradient tensor (transposed, but not important here)
-    const Eigen::Map<MatrixT> g(&((*m_gradient_fields[gamma])[node_idx][0]));
+    const Uint gradient_stride = m_gradient_fields[gamma]->array().strides()[1];
+    const Eigen::Map<MatrixT, Eigen::Unaligned, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic> > g(&((*m_gradient_fields[gamma])[node_idx][0]), Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(dim*gradient_stride, gradient_stride));
     // Rate of strain tensor
     const MatrixT s = (g + g.transpose())/2.;
     std::vector<Real> ev(3, 0.); // vector so we can use std::sort
@@ -306,7 +309,7 @@ struct MomentSourceFunctor : FunctionBase
       }
     }
 
-    Eigen::Map<RealVector> x(&(*m_source_field)[node_idx][0], nb_moments);
+    Eigen::Map<RealVector, Eigen::Unaligned, Eigen::InnerStride<> > x(&(*m_source_field)[node_idx][0], nb_moments, Eigen::InnerStride<>(m_source_field->array().strides()[1]));
     
     // Check for NaN
     for(Uint k = 0; k != nb_moments; ++k)
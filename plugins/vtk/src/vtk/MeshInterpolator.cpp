@@ -149,7 +149,7 @@ void MeshInterpolator::execute()
             continue;
           BOOST_FOREACH(const Uint node_idx, conn[elem_idx])
           {
-            const Eigen::Map<RealVector const> coord(&source_coords[node_idx][0], dim);
+            const Eigen::Map<RealVector const, Eigen::Unaligned, Eigen::InnerStride<> > coord(&source_coords[node_idx][0], dim, Eigen::InnerStride<>(source_coords.array().strides()[1]));
             if((coord.array() <= box_maxs[rank].array()).all() && (coord.array() >= box_mins[rank].array()).all())
             {
               elements_to_send[rank][elements.entities_idx()].push_back(elem_idx);
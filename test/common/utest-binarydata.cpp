@@ -7,8 +7,10 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Test module for cf3::Component"
 
+#include <fstream>
 #include <iostream>
 
+#include <boost/filesystem/operations.hpp>
 #include <boost/mpl/if.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/random/mersenne_twister.hpp>
@@ -17,6 +19,7 @@
 
 #include "common/BinaryDataReader.hpp"
 #include "common/BinaryDataWriter.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/Core.hpp"
 #include "common/List.hpp"
 #include "common/OptionList.hpp"
@@ -130,6 +133,16 @@ BOOST_AUTO_TEST_CASE( WriteBinaryData )
   writer.append_data(empty_real_list);
   writer.append_data(empty_real_table);
 
+  common::CompressedTable<Uint>& compressed_table = *group.create_component< common::CompressedTable<Uint> >("CompressedTable");
+  std::vector<Uint> row_sizes(int_table_size);
+  for(Uint i = 0; i != int_table_size; ++i)
+    row_sizes[i] = i % 5;
+  compressed_table.set_row_sizes(row_sizes);
+  for(Uint i = 0; i != compressed_table.nb_values(); ++i)
+    compressed_table.values()[i] = i + rank;
+
+  BOOST_CHECK_EQUAL(writer.append_data(compressed_table), 6);
+
   writer.close();
 }
 
@@ -171,6 +184,163 @@ BOOST_AUTO_TEST_CASE( ReadBinaryData )
   BOOST_CHECK_EQUAL(empty_real_list.size(), 0);
   BOOST_CHECK_EQUAL(empty_real_table.size(), 0);
   BOOST_CHECK_EQUAL(empty_real_table.row_size(), 8);
+
+  common::CompressedTable<Uint>& read_compressed_table = *read_group.create_component< common::CompressedTable<Uint> >("CompressedTable");
+  Handle< common::CompressedTable<Uint> > write_compressed_table(write_group->get_child("CompressedTable"));
+  reader.read_compressed_table(read_compressed_table, 6);
+
+  BOOST_CHECK_EQUAL(read_compressed_table.size(), write_compressed_table->size());
+  BOOST_CHECK(read_compressed_table.offsets() == write_compressed_table->offsets());
+  BOOST_CHECK(read_compressed_table.values() == write_compressed_table->values());
+  BOOST_CHECK_EQUAL(read_compressed_table.row_size(4), 4);
+}
+
+BOOST_AUTO_TEST_CASE( WriteSharedBinaryData )
+{
+  Handle<common::Component> write_group = common::Core::instance().root().get_child("WriteGroup");
+  Handle< common::Table<Real> > real_table(write_group->get_child("RealTable"));
+  Handle< common::List<Uint> > int_list(write_group->get_child("IntList"));
+
+  common::BinaryDataWriter& writer = *write_group->create_component<common::BinaryDataWriter>("SharedWriter");
+  writer.options().set("shared_file", true);
+  writer.options().set("compress", false);
+  writer.options().set("file", common::URI("shared_binary_data.cfbinxml"));
+
+  BOOST_CHECK_EQUAL(writer.append_data(*real_table), 0);
+  BOOST_CHECK_EQUAL(writer.append_data(*int_list), 1);
+
+  writer.close();
+}
+
+BOOST_AUTO_TEST_CASE( ReadSharedBinaryData )
+{
+  common::Component& read_group = *common::Core::instance().root().get_child("ReadGroup");
+  common::BinaryDataReader& reader = *read_group.create_component<common::BinaryDataReader>("SharedReader");
+  reader.options().set("mmap", true);
+  reader.options().set("file", common::URI("shared_binary_data.cfbinxml"));
+
+  const Uint nb_procs = common::PE::Comm::instance().size();
+  BOOST_CHECK_EQUAL(reader.nb_ranks(), nb_procs);
+
+  Handle<common::Component> write_group = common::Core::instance().root().get_child("WriteGroup");
+  Handle< common::Table<Real> > write_real_table(write_group->get_child("RealTable"));
+  Handle< common::List<Uint> > write_int_list(write_group->get_child("IntList"));
+
+  common::Table<Real>& read_real_table = *read_group.create_component< common::Table<Real> >("SharedRealTable");
+  common::List<Uint>& read_int_list = *read_group.create_component< common::List<Uint> >("SharedIntList");
+  reader.read_table(read_real_table, 0);
+  reader.read_list(read_int_list, 1);
+
+  BOOST_CHECK(read_real_table.array() == write_real_table->array());
+  BOOST_CHECK(read_int_list.array() == write_int_list->array());
+
+  // The blocks of the other ranks are in the same file
+  const Uint other_rank = (rank + 1) % nb_procs;
+  reader.read_list(read_int_list, 1, other_rank);
+  BOOST_CHECK_EQUAL(read_int_list.size(), 30000-3000*other_rank);
+  BOOST_CHECK_EQUAL(reader.block_rows(0, other_rank), 20000+2000*other_rank);
+
+  // The type check uses the block of the requested rank
+  BOOST_CHECK_THROW(reader.read_list(read_int_list, 0, other_rank), common::SetupError);
+}
+
+BOOST_AUTO_TEST_CASE( ColumnMajorBinaryData )
+{
+  Handle<common::Component> write_group = common::Core::instance().root().get_child("WriteGroup");
+  Handle< common::Table<Real> > write_real_table(write_group->get_child("RealTable"));
+
+  common::Table<Real>& column_major_table = *write_group->create_component< common::Table<Real> >("ColumnMajorTable");
+  column_major_table.set_row_size(real_table_cols);
+  column_major_table.resize(real_table_size);
+  column_major_table.array() = write_real_table->array();
+  column_major_table.set_column_major(true);
+  BOOST_CHECK(column_major_table.is_column_major());
+  BOOST_CHECK(column_major_table.array() == write_real_table->array());
+  BOOST_CHECK_EQUAL(&column_major_table[1][0] - &column_major_table[0][0], 1);
+
+  common::BinaryDataWriter& writer = *write_group->create_component<common::BinaryDataWriter>("ColumnMajorWriter");
+  writer.options().set("file", common::URI("column_major_binary_data.cfbinxml"));
+  writer.append_data(column_major_table);
+  writer.close();
+
+  // The file layout does not depend on the storage order of the tables
+  common::Component& read_group = *common::Core::instance().root().get_child("ReadGroup");
+  common::BinaryDataReader& reader = *read_group.create_component<common::BinaryDataReader>("ColumnMajorReader");
+  reader.options().set("file", common::URI("column_major_binary_data.cfbinxml"));
+
+  common::Table<Real>& row_major_read = *read_group.create_component< common::Table<Real> >("RowMajorRead");
+  reader.read_table(row_major_read, 0);
+  BOOST_CHECK(row_major_read.array() == write_real_table->array());
+
+  common::Table<Real>& column_major_read = *read_group.create_component< common::Table<Real> >("ColumnMajorRead");
+  column_major_read.set_column_major(true);
+  reader.read_table(column_major_read, 0);
+  BOOST_CHECK(column_major_read.is_column_major());
+  BOOST_CHECK(column_major_read.array() == write_real_table->array());
+}
+
+BOOST_AUTO_TEST_CASE( SharedBlockBeginBeyond4GiB )
+{
+  const boost::uint64_t gib = static_cast<boost::uint64_t>(1024)*1024*1024;
+  std::vector<boost::uint64_t> block_sizes(3, 3*gib);
+  const boost::uint64_t file_end = sizeof(Uint);
+
+  BOOST_CHECK_EQUAL(common::detail::shared_block_begin(file_end, block_sizes, 0), file_end);
+  BOOST_CHECK_EQUAL(common::detail::shared_block_begin(file_end, block_sizes, 1), file_end + 3*gib);
+  BOOST_CHECK_EQUAL(common::detail::shared_block_begin(file_end, block_sizes, 2), file_end + 6*gib);
+  BOOST_CHECK(common::detail::shared_block_begin(file_end, block_sizes, 2) > std::numeric_limits<Uint>::max());
+}
+
+BOOST_AUTO_TEST_CASE( ReadBeyond4GiB )
+{
+  static const std::string block_prefix("__CFDATA_BEGIN");
+  const boost::uint64_t block_begin = static_cast<boost::uint64_t>(5)*1024*1024*1024 + 3;
+  const Uint nb_values = 1000;
+  const boost::uint64_t block_end = block_begin + block_prefix.size() + sizeof(Uint)*nb_values;
+
+  std::vector<Uint> values(nb_values);
+  for(Uint i = 0; i != nb_values; ++i)
+    values[i] = i + rank;
+
+  // Sparse binary file holding a single uncompressed block beyond the first 4 GiB
+  const std::string binary_filename = "large_offset_binary_data_P" + common::to_str(rank) + ".cfbin";
+  const std::string xml_filename = "large_offset_binary_data_P" + common::to_str(rank) + ".cfbinxml";
+  {
+    std::ofstream binary_file(binary_filename.c_str(), std::ios_base::out | std::ios_base::binary);
+    const Uint version = 1;
+    binary_file.write(reinterpret_cast<const char*>(&version), sizeof(Uint));
+    binary_file.seekp(static_cast<std::streamoff>(block_begin));
+    binary_file.write(block_prefix.c_str(), block_prefix.size());
+    binary_file.write(reinterpret_cast<const char*>(&values[0]), sizeof(Uint)*nb_values);
+    BOOST_REQUIRE(binary_file.good());
+  }
+  {
+    std::ofstream xml_file(xml_filename.c_str());
+    xml_file << "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+             << "<cfbinary version=\"1\"><nodes><node filename=\"" << binary_filename << "\" rank=\"" << rank << "\">"
+             << "<block name=\"LargeOffsetList\" index=\"0\" type_name=\"" << common::class_name<Uint>() << "\" nb_rows=\"" << nb_values << "\" nb_cols=\"1\""
+             << " begin=\"" << block_begin << "\" end=\"" << block_end << "\" compressed=\"false\"/>"
+             << "</node></nodes></cfbinary>\n";
+  }
+
+  common::Component& read_group = *common::Core::instance().root().get_child("ReadGroup");
+  common::BinaryDataReader& reader = *read_group.create_component<common::BinaryDataReader>("LargeOffsetReader");
+  reader.options().set("file", common::URI(xml_filename));
+
+  common::List<Uint>& stream_list = *read_group.create_component< common::List<Uint> >("LargeOffsetStreamList");
+  reader.read_list(stream_list, 0);
+  BOOST_CHECK_EQUAL(stream_list.size(), nb_values);
+  BOOST_CHECK(std::equal(values.begin(), values.end(), stream_list.array().begin()));
+
+  reader.options().set("mmap", true);
+  common::List<Uint>& mmap_list = *read_group.create_component< common::List<Uint> >("LargeOffsetMmapList");
+  reader.read_list(mmap_list, 0);
+  BOOST_CHECK_EQUAL(mmap_list.size(), nb_values);
+  BOOST_CHECK(std::equal(values.begin(), values.end(), mmap_list.array().begin()));
+
+  reader.close();
+  boost::filesystem::remove(binary_filename);
+  boost::filesystem::remove(xml_filename);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,196 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::common::Tracer"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "common/ActionDirector.hpp"
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/Foreach.hpp"
+#include "common/OptionList.hpp"
+#include "common/StringConversion.hpp"
+#include "common/Tracer.hpp"
+
+#include "common/PE/Comm.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// Action that sleeps longer on higher ranks, to create a load imbalance
+struct SleepAction : Action
+{
+  SleepAction(const std::string& name) : Action(name) {}
+  static std::string type_name () { return "SleepAction"; }
+  virtual void execute()
+  {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10*(PE::Comm::instance().rank()+1)));
+  }
+};
+
+/// Records a number of spans on a separate thread
+void record_spans(const Uint nb_spans)
+{
+  for(Uint i = 0; i != nb_spans; ++i)
+    TraceSpan span("span_" + to_str(i));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( TracerSuite )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( InitMPI )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc,boost::unit_test::framework::master_test_suite().argv);
+  BOOST_CHECK_EQUAL(PE::Comm::instance().is_active(),true);
+}
+
+BOOST_AUTO_TEST_CASE( DisabledByDefault )
+{
+  BOOST_CHECK(!Tracer::instance().is_enabled());
+  {
+    TraceSpan span("ignored");
+  }
+  BOOST_CHECK(Tracer::instance().reduce_statistics().empty());
+}
+
+BOOST_AUTO_TEST_CASE( NestedSpans )
+{
+  Core::instance().environment().options().set("tracing", true);
+  BOOST_CHECK(Tracer::instance().is_enabled());
+
+  Component& root = Core::instance().root();
+  Handle<ActionDirector> director = root.create_component<ActionDirector>("director");
+  Handle<SleepAction> sleep_action = director->create_component<SleepAction>("sleep");
+
+  {
+    TraceSpan outer("outer");
+    director->execute();
+    director->execute();
+  }
+
+  const std::vector< std::vector<TraceEvent> > events = Tracer::instance().events();
+  BOOST_REQUIRE_EQUAL(events.size(), 1);
+  BOOST_REQUIRE_EQUAL(events[0].size(), 3);
+  BOOST_CHECK_EQUAL(events[0][0].name, sleep_action->uri().path());
+  BOOST_CHECK_EQUAL(events[0][0].depth, 1);
+  BOOST_CHECK_EQUAL(events[0][2].name, "outer");
+  BOOST_CHECK_EQUAL(events[0][2].depth, 0);
+  BOOST_CHECK_GE(events[0][1].start, events[0][0].start + events[0][0].duration);
+  BOOST_CHECK_GE(events[0][2].duration, events[0][0].duration + events[0][1].duration);
+
+  const std::vector<TraceStatistics> statistics = Tracer::instance().reduce_statistics();
+  BOOST_REQUIRE_EQUAL(statistics.size(), 2);
+  boost_foreach(const TraceStatistics& stats, statistics)
+  {
+    BOOST_CHECK_LE(stats.min, stats.mean);
+    BOOST_CHECK_LE(stats.mean, stats.max);
+    BOOST_CHECK_GE(stats.imbalance, 1.);
+    if(stats.name == sleep_action->uri().path())
+    {
+      BOOST_CHECK_EQUAL(stats.count, 2);
+      BOOST_CHECK_GE(stats.min, 0.019);
+      if(PE::Comm::instance().size() > 1)
+        BOOST_CHECK_GT(stats.imbalance, 1.1);
+    }
+  }
+
+  Tracer::instance().print_statistics(std::cout);
+}
+
+BOOST_AUTO_TEST_CASE( RingBuffer )
+{
+  Tracer::instance().clear();
+  BOOST_CHECK(Tracer::instance().reduce_statistics().empty());
+
+  // Only the last 4 events of the new thread are kept, but the totals count all of them
+  Tracer::instance().set_buffer_size(4);
+  boost::thread thread(boost::bind(record_spans, 10u));
+  thread.join();
+
+  const std::vector< std::vector<TraceEvent> > events = Tracer::instance().events();
+  BOOST_REQUIRE_EQUAL(events.size(), 2);
+  BOOST_CHECK(events[0].empty());
+  BOOST_REQUIRE_EQUAL(events[1].size(), 4);
+  for(Uint i = 0; i != 4; ++i)
+    BOOST_CHECK_EQUAL(events[1][i].name, "span_" + to_str(i+6));
+
+  BOOST_CHECK_EQUAL(Tracer::instance().reduce_statistics().size(), 10);
+}
+
+BOOST_AUTO_TEST_CASE( ChromeTrace )
+{
+  Tracer::instance().write_chrome_trace("utest-common-tracer.json");
+
+  const Uint nb_procs = PE::Comm::instance().size();
+  const std::string filename = nb_procs > 1 ? "utest-common-tracer-" + to_str(PE::Comm::instance().rank()) + ".json" : "utest-common-tracer.json";
+  std::ifstream file(filename.c_str());
+  BOOST_REQUIRE(file);
+  std::stringstream contents;
+  contents << file.rdbuf();
+
+  BOOST_CHECK(contents.str().find("\"traceEvents\"") != std::string::npos);
+  BOOST_CHECK(contents.str().find("\"name\":\"span_9\",\"cat\":\"cf3\",\"ph\":\"X\"") != std::string::npos);
+  BOOST_CHECK(contents.str().find("\"name\":\"span_5\"") == std::string::npos);
+
+  Core::instance().environment().options().set("tracing", false);
+}
+
+// Read out events and statistics while other threads are recording
+BOOST_AUTO_TEST_CASE( ConcurrentReads )
+{
+  Tracer::instance().enable(true);
+  Tracer::instance().clear();
+  Tracer::instance().set_buffer_size(64);
+
+  const Uint nb_threads = 4;
+  const Uint nb_spans = 20000;
+  boost::thread_group threads;
+  for(Uint i = 0; i != nb_threads; ++i)
+    threads.create_thread(boost::bind(record_spans, nb_spans));
+
+  // The number of collective calls must not depend on the timing, so it is fixed
+  for(Uint i = 0; i != 20; ++i)
+  {
+    const std::vector< std::vector<TraceEvent> > events = Tracer::instance().events();
+    boost_foreach(const std::vector<TraceEvent>& thread_events, events)
+      BOOST_CHECK(thread_events.size() <= 64);
+    BOOST_CHECK(Tracer::instance().reduce_statistics().size() <= nb_spans);
+  }
+  threads.join_all();
+
+  // Every span name was recorded once by each thread
+  const std::vector<TraceStatistics> statistics = Tracer::instance().reduce_statistics();
+  BOOST_CHECK_EQUAL(statistics.size(), nb_spans);
+  boost_foreach(const TraceStatistics& stats, statistics)
+    BOOST_CHECK_EQUAL(stats.count, nb_threads);
+
+  Tracer::instance().enable(false);
+}
+
+BOOST_AUTO_TEST_CASE( FinalizeMPI )
+{
+  PE::Comm::instance().finalize();
+  BOOST_CHECK_EQUAL(PE::Comm::instance().is_active(),false);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////
@@ -11,7 +11,10 @@
 
 #include "common/Log.hpp"
 #include "common/Component.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
 #include "common/Group.hpp"
+#include "common/StringConversion.hpp"
 
 #include "Tools/Testing/ProfiledTestFixture.hpp"
 #include "Tools/Testing/TimedTestFixture.hpp"
@@ -34,6 +37,40 @@ BOOST_AUTO_TEST_CASE( constructor )
     common::allocate_component<common::Group>("test");
 }
 
+/// Tree with 100 groups of 10 components each, searched as an action would do in each iteration
+BOOST_AUTO_TEST_CASE( repeated_search )
+{
+  boost::shared_ptr<common::Group> root = common::allocate_component<common::Group>("root");
+  for(Uint i = 0; i != 100; ++i)
+  {
+    Handle<common::Group> group = root->create_component<common::Group>("group" + common::to_str(i));
+    for(Uint j = 0; j != 10; ++j)
+      group->create_component<common::Component>("component" + common::to_str(j));
+  }
+
+  Uint nb_found = 0;
+  for(Uint i = 0; i != 10000; ++i)
+  {
+    BOOST_FOREACH(const common::Group& group, common::find_components_recursively<common::Group>(*root))
+    {
+      nb_found += group.count_children() == 10 ? 1 : 0;
+    }
+  }
+  BOOST_CHECK_EQUAL(nb_found, 1000000u);
+}
+
+BOOST_AUTO_TEST_CASE( repeated_path_access )
+{
+  boost::shared_ptr<common::Group> root = common::allocate_component<common::Group>("root");
+  Handle<common::Component> leaf = root->create_component<common::Group>("a")->create_component<common::Group>("b")->create_component<common::Group>("c");
+
+  const common::URI path("cpath:/a/b/c");
+  Uint nb_found = 0;
+  for(Uint i = 0; i != 1000000; ++i)
+    nb_found += root->access_component(path) == leaf ? 1 : 0;
+  BOOST_CHECK_EQUAL(nb_found, 1000000u);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_SUITE_END()
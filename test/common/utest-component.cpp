@@ -11,6 +11,8 @@
 
 #include <boost/foreach.hpp>
 #include <boost/iterator.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "common/Log.hpp"
 #include "common/Component.hpp"
@@ -19,6 +21,7 @@
 #include "common/Link.hpp"
 #include "common/OptionList.hpp"
 #include "common/PropertyList.hpp"
+#include "common/StringConversion.hpp"
 
 #include "common/XML/Protocol.hpp"
 #include "common/XML/SignalFrame.hpp"
@@ -297,6 +300,140 @@ BOOST_AUTO_TEST_CASE( clear )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( component_ids )
+{
+  boost::shared_ptr<Component> root = allocate_component<Group> ( "root" );
+  Handle<Component> c1 = root->create_component<Component>("c1");
+  Handle<Component> c2 = root->create_component<Component>("c2");
+
+  BOOST_CHECK(root->id() != c1->id());
+  BOOST_CHECK(c1->id() != c2->id());
+
+  // IDs are kept when renaming
+  const Uint c2_id = c2->id();
+  c2->rename("c3");
+  BOOST_CHECK_EQUAL(c2->id(), c2_id);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( cached_searches )
+{
+  boost::shared_ptr<Component> root = allocate_component<Group> ( "root" );
+  Handle<Group> g1 = root->create_component<Group>("g1");
+  Handle<Group> g2 = g1->create_component<Group>("g2");
+  g2->create_component<Component>("c");
+
+  const Uint root_generation = root->tree_generation();
+  const Uint g2_generation = g2->tree_generation();
+
+  BOOST_CHECK_EQUAL(count(find_components_recursively<Group>(*root)), 2);
+  BOOST_CHECK_EQUAL(count(find_components_recursively(*root)), 3);
+
+  // A repeated search gives the same list
+  BOOST_CHECK(root->cached_components<Group>(true) == root->cached_components<Group>(true));
+
+  // Adding a deep child changes the generation of all parents, but not of siblings
+  Handle<Group> g3 = g2->create_component<Group>("g3");
+  Handle<Group> g4 = root->create_component<Group>("g4");
+  BOOST_CHECK(root->tree_generation() != root_generation);
+  BOOST_CHECK(g2->tree_generation() != g2_generation);
+  BOOST_CHECK_EQUAL(count(find_components_recursively<Group>(*root)), 4);
+  BOOST_CHECK_EQUAL(count(find_components_recursively<Group>(*g1)), 2);
+  BOOST_CHECK_EQUAL(count(find_components<Group>(*root)), 2);
+
+  // Removed components are not kept alive by the cache
+  g2->remove_component("g3");
+  BOOST_CHECK(is_null(g3));
+  BOOST_CHECK_EQUAL(count(find_components_recursively<Group>(*root)), 3);
+
+  // Iterating stays valid when the tree changes during the loop
+  Uint nb_iterated = 0;
+  BOOST_FOREACH(Group& group, find_components_recursively<Group>(*root))
+  {
+    group.create_component<Group>("added");
+    ++nb_iterated;
+  }
+  BOOST_CHECK_EQUAL(nb_iterated, 3);
+  BOOST_CHECK_EQUAL(count(find_components_recursively<Group>(*root)), 6);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( cached_paths )
+{
+  boost::shared_ptr<Component> root = allocate_component<Group> ( "root" );
+  Handle<Component> c1 = root->create_component<Component>("c1");
+  Handle<Component> c2 = c1->create_component<Component>("c2");
+
+  BOOST_CHECK(c2->access_component("cpath:/c1/c2") == c2);
+  BOOST_CHECK(c2->access_component("cpath:/c1/c2") == c2);
+  BOOST_CHECK(c2->access_component("cpath:..") == c1);
+  BOOST_CHECK(c2->access_component("cpath:../../c1/./c2/") == c2);
+  BOOST_CHECK(c2->access_component("cpath:../../..").get() == 0);
+  BOOST_CHECK(root->access_component("cpath:/").get() == root.get());
+  BOOST_CHECK(root->access_component("cpath:c1/missing").get() == 0);
+
+  // Renaming invalidates the cached path
+  c1->rename("c3");
+  BOOST_CHECK(c2->access_component("cpath:/c1/c2").get() == 0);
+  BOOST_CHECK(c2->access_component("cpath:/c3/c2") == c2);
+
+  // A new component with the same path is found
+  root->remove_component("c3");
+  Handle<Component> c4 = root->create_component<Component>("c3");
+  BOOST_CHECK(root->access_component("cpath:c3") == c4);
+
+  // Changing another tree keeps the cached paths, but they are dropped when the component moves to another tree
+  boost::shared_ptr<Component> other = allocate_component<Group> ( "other" );
+  const Uint generation = root->tree_generation();
+  other->create_component<Component>("c3");
+  BOOST_CHECK_EQUAL(root->tree_generation(), generation);
+  Handle<Component> c5 = c4->create_component<Component>("c5");
+  BOOST_CHECK(c5->access_component("cpath:/c3") == c4);
+  c4->move_to(*other->get_child("c3"));
+  BOOST_CHECK(c5->access_component("cpath:/c3") == other->get_child("c3"));
+}
+
+/// Repeatedly searches a tree that is not modified, counting the wrong results
+void search_tree(const Component& root, const Handle<Component> leaf, Uint& nb_errors)
+{
+  for(Uint i = 0; i != 2000; ++i)
+  {
+    if(count(find_components_recursively<Group>(root)) != 10)
+      ++nb_errors;
+    if(root.access_component("cpath:g5/leaf") != leaf)
+      ++nb_errors;
+  }
+}
+
+BOOST_AUTO_TEST_CASE( concurrent_searches )
+{
+  boost::shared_ptr<Component> searched = allocate_component<Group> ( "searched" );
+  for(Uint i = 0; i != 10; ++i)
+    searched->create_component<Group>("g" + to_str(i));
+  Handle<Component> leaf = searched->get_child("g5")->create_component<Component>("leaf");
+
+  // Searches run on other threads, while another tree is modified here, which leaves their path caches valid.
+  std::vector<Uint> nb_errors(4, 0);
+  boost::thread_group threads;
+  for(Uint i = 0; i != nb_errors.size(); ++i)
+    threads.create_thread(boost::bind(search_tree, boost::cref(*searched), leaf, boost::ref(nb_errors[i])));
+
+  boost::shared_ptr<Component> modified = allocate_component<Group> ( "modified" );
+  for(Uint i = 0; i != 2000; ++i)
+  {
+    modified->create_component<Group>("tmp");
+    modified->remove_component("tmp");
+  }
+  threads.join_all();
+
+  for(Uint i = 0; i != nb_errors.size(); ++i)
+    BOOST_CHECK_EQUAL(nb_errors[i], 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -9,17 +9,39 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/iostreams/device/back_inserter.hpp>
 
 #include <iostream>
+#include <sstream>
 
 #include "common/Log.hpp"
+#include "common/LogAsyncWriter.hpp"
+#include "common/StringConversion.hpp"
 
 using namespace std;
 using namespace boost;
 using namespace cf3;
 using namespace cf3::common;
 
+/// Output function for a LogAsyncWriter target
+void append_to_string(std::string* str, const char* data, const std::streamsize size)
+{
+  str->append(data, size);
+}
+
+void no_flush()
+{
+}
+
+/// Output function that simulates a slow file system
+void append_slowly(std::string* str, const char* data, const std::streamsize size)
+{
+  boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+  str->append(data, size);
+}
+
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -67,4 +89,92 @@ BOOST_AUTO_TEST_CASE( FlushBuffer )
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
+BOOST_AUTO_TEST_CASE( AsyncWriterText )
+{
+  std::string output;
+  LogAsyncWriter writer;
+  const Uint target = writer.add_target(boost::bind(append_to_string, &output, _1, _2), no_flush, LogAsyncWriter::TEXT);
+
+  const std::string input = "a\nb\nb\nb\nc";
+  writer.write(target, input.data(), 4);
+  writer.write(target, input.data() + 4, input.size() - 4);
+  writer.flush();
+
+  BOOST_CHECK_EQUAL(output, "a\nb\n(previous message repeated 2 times)\nc");
+  BOOST_CHECK_EQUAL(writer.nb_aggregated(), 2);
+
+  // Without aggregation, every line is written
+  output.clear();
+  writer.set_aggregate_duplicates(false);
+  const std::string repeated = "\nd\nd\n";
+  writer.write(target, repeated.data(), repeated.size());
+  writer.flush();
+  BOOST_CHECK_EQUAL(output, "\nd\nd\n");
+}
+
+BOOST_AUTO_TEST_CASE( AsyncWriterBinary )
+{
+  std::string output;
+  {
+    LogAsyncWriter writer;
+    const Uint target = writer.add_target(boost::bind(append_to_string, &output, _1, _2), no_flush, LogAsyncWriter::BINARY, 3);
+    const std::string input = "first line\nsecond line\n";
+    writer.write(target, input.data(), input.size());
+  } // destructor writes the queue
+
+  std::istringstream input(output);
+  const std::vector<LogRecord> records = LogAsyncWriter::read_binary(input);
+  BOOST_REQUIRE_EQUAL(records.size(), 2);
+  BOOST_CHECK_EQUAL(records[0].rank, 3);
+  BOOST_CHECK_EQUAL(records[0].message, "first line");
+  BOOST_CHECK_EQUAL(records[1].message, "second line");
+  BOOST_CHECK_LE(records[0].time, records[1].time);
+}
+
+BOOST_AUTO_TEST_CASE( AsyncWriterBackPressure )
+{
+  std::string output;
+  std::string expected;
+  {
+    LogAsyncWriter writer;
+    writer.set_aggregate_duplicates(false);
+    writer.set_max_queue_size(32);
+    const Uint target = writer.add_target(boost::bind(append_slowly, &output, _1, _2), no_flush, LogAsyncWriter::TEXT);
+    for(Uint i = 0; i != 200; ++i)
+    {
+      const std::string line = "line " + to_str(i) + "\n";
+      writer.write(target, line.data(), line.size());
+      expected += line;
+    }
+    writer.flush();
+
+    // The producer is much faster than the output, so it must have waited for the queue to drain
+    BOOST_CHECK(writer.nb_blocked_writes() > 0);
+
+    // A single write that is larger than the queue still goes through
+    const std::string long_line(100, 'x');
+    writer.write(target, long_line.data(), long_line.size());
+    expected += long_line;
+  }
+
+  BOOST_CHECK_EQUAL(output, expected);
+}
+
+BOOST_AUTO_TEST_CASE( AsynchronousLogger )
+{
+  Logger::instance().set_asynchronous(true);
+  BOOST_CHECK(Logger::instance().async_writer() != NULL);
+
+  for(Uint i = 0; i != 3; ++i)
+    CFinfo << "this asynchronous line is printed once, with a repeat count" << CFendl;
+  CFerror << "errors are written before returning" << CFendl;
+
+  Logger::instance().set_asynchronous(false);
+  BOOST_CHECK(Logger::instance().async_writer() == NULL);
+  CFinfo << "this line is written synchronously" << CFendl;
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
 BOOST_AUTO_TEST_SUITE_END()
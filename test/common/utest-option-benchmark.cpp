@@ -0,0 +1,109 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cached option access"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Component.hpp"
+#include "common/Group.hpp"
+#include "common/OptionList.hpp"
+#include "common/OptionRef.hpp"
+
+#include "Tools/Testing/TimedTestFixture.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct OptionBenchFixture : Tools::Testing::TimedTestFixture
+{
+  /// Component with a few options, so the lookup is not in a trivial map
+  static Component& component()
+  {
+    static boost::shared_ptr<Group> comp;
+    if(!comp)
+    {
+      comp = allocate_component<Group>("options");
+      comp->options().add("alpha", 1.);
+      comp->options().add("beta", 2u);
+      comp->options().add("delta", std::string("delta"));
+      comp->options().add("gamma", 0.5);
+      comp->options().add("relaxation_factor", 0.25);
+    }
+    return *comp;
+  }
+
+  static const Uint nb_reads = 10000000;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( OptionBenchSuite, OptionBenchFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Refresh )
+{
+  Component& comp = component();
+  OptionRef<Real> relaxation(comp.options(), "relaxation_factor");
+  BOOST_CHECK(relaxation.is_bound());
+  BOOST_CHECK_EQUAL(relaxation.value(), 0.25);
+
+  comp.options().set("relaxation_factor", 0.5);
+  BOOST_CHECK_EQUAL(relaxation.value(), 0.5);
+
+  // Rebinding detaches from the first option. Gamma gets a value that differs from both relaxation factors,
+  // so reading through the old binding would be detected.
+  comp.options().set("gamma", 0.75);
+  relaxation.bind(comp.options(), "gamma");
+  BOOST_CHECK_EQUAL(relaxation.name(), "gamma");
+  BOOST_CHECK_EQUAL(relaxation.value(), 0.75);
+  comp.options().set("relaxation_factor", 0.25);
+  BOOST_CHECK_EQUAL(relaxation.value(), 0.75);
+  comp.options().set("gamma", 0.125);
+  BOOST_CHECK_EQUAL(relaxation.value(), 0.125);
+
+  // Wrong type
+  OptionRef<Uint> wrong;
+  BOOST_CHECK_THROW(wrong.bind(comp.options(), "alpha"), CastingFailed);
+}
+
+BOOST_AUTO_TEST_CASE( OutlivesOption )
+{
+  boost::shared_ptr<Group> comp = allocate_component<Group>("tmp");
+  comp->options().add("value", 3.);
+  OptionRef<Real> value(comp->options(), "value");
+  BOOST_CHECK_EQUAL(value.value(), 3.);
+  comp.reset();
+  BOOST_CHECK(!value.is_bound());
+}
+
+BOOST_AUTO_TEST_CASE( StringLookup )
+{
+  const OptionList& options = component().options();
+  Real result = 0.;
+  for(Uint i = 0; i != nb_reads; ++i)
+    result += options.value<Real>("relaxation_factor");
+  BOOST_CHECK_EQUAL(result, 0.25*static_cast<Real>(nb_reads));
+}
+
+BOOST_AUTO_TEST_CASE( CachedReference )
+{
+  OptionRef<Real> relaxation(component().options(), "relaxation_factor");
+  Real result = 0.;
+  for(Uint i = 0; i != nb_reads; ++i)
+    result += relaxation;
+  BOOST_CHECK_EQUAL(result, 0.25*static_cast<Real>(nb_reads));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -16,6 +16,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include "common/Log.hpp"
 #include "common/FindComponents.hpp"
@@ -212,6 +213,110 @@ BOOST_AUTO_TEST_CASE( commpattern_mainstream )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( commpattern_split_phase )
+{
+  // general constants in this routine
+  const int nproc=PE::Comm::instance().size();
+  const int irank=PE::Comm::instance().rank();
+
+  // commpattern
+  boost::shared_ptr<CommPattern> pecp_ptr = allocate_component<CommPattern>("CommPattern");
+  CommPattern& pecp = *pecp_ptr;
+
+  // setup gid & rank
+  std::vector<Uint> gid;
+  std::vector<Uint> rank;
+  setupGidAndRank(gid,rank);
+  pecp.insert("gid",gid,1,false);
+
+  // additional arrays for testing
+  std::vector<int> v1;
+  for(int i=0;i<6*nproc;i++) v1.push_back(-((irank+1)*1000+i+1));
+  pecp.insert("v1",v1,1,true);
+  std::vector<double> v2;
+  for(int i=0;i<12*nproc;i++) v2.push_back((double)((irank+1)*1000+i+1));
+  pecp.insert("v2",v2,2,true);
+
+  pecp.setup(Handle<CommWrapper>(pecp.get_child("gid")),rank);
+
+  // both exchanges in flight at the same time, finished in reverse order
+  // the second pass reuses the persistent requests
+  for (int pass=0; pass<2; ++pass)
+  {
+    pecp.begin_synchronize("v1");
+    pecp.begin_synchronize("v2");
+    pecp.end_synchronize("v2");
+    pecp.end_synchronize("v1");
+
+    // check results
+    Uint idx=0;
+    Uint i;
+    for (i=0; i<  nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-0*nproc)/1)+1)*1000+idx+1)) );
+    for (   ; i<3*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-1*nproc)/2)+1)*1000+idx+1)) );
+    for (   ; i<6*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-3*nproc)/3)+1)*1000+idx+1)) );
+    idx=0;
+    for (i=0; i< 2*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-0*nproc)/2)+1)*1000+idx+1) );
+    for (   ; i< 6*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-2*nproc)/4)+1)*1000+idx+1) );
+    for (   ; i<12*nproc; i++, idx++) BOOST_CHECK_EQUAL( v2[i], (double)((((i-6*nproc)/6)+1)*1000+idx+1) );
+  }
+
+  // ending an exchange that was not started is an error
+  BOOST_CHECK_THROW( pecp.end_synchronize("v1"), common::ShouldNotBeHere );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( commpattern_split_phase_replaced_objects )
+{
+  // general constants in this routine
+  const int nproc=PE::Comm::instance().size();
+  const int irank=PE::Comm::instance().rank();
+
+  // commpattern
+  boost::shared_ptr<CommPattern> pecp_ptr = allocate_component<CommPattern>("CommPattern");
+  CommPattern& pecp = *pecp_ptr;
+
+  // setup gid & rank
+  std::vector<Uint> gid;
+  std::vector<Uint> rank;
+  setupGidAndRank(gid,rank);
+  pecp.insert("gid",gid,1,false);
+  pecp.setup(Handle<CommWrapper>(pecp.get_child("gid")),rank);
+
+  // many objects in flight at once, each with its own tag
+  // objects are replaced between passes, so a new object may get the address of a removed one
+  const int nb_objects=8;
+  std::vector< std::vector<int> > data(nb_objects);
+  for (int pass=0; pass<3; ++pass)
+  {
+    for (int o=0; o<nb_objects; ++o)
+    {
+      const std::string name="v"+boost::lexical_cast<std::string>(o);
+      if (pass!=0) pecp.clear(name);
+      data[o].clear();
+      for(int i=0;i<6*nproc;i++) data[o].push_back(-((irank+1)*1000+i+1+100000*(o+nb_objects*pass)));
+      pecp.insert(name,data[o],1,true);
+    }
+
+    for (int o=0; o<nb_objects; ++o) pecp.begin_synchronize("v"+boost::lexical_cast<std::string>(o));
+    for (int o=nb_objects-1; o>=0; --o) pecp.end_synchronize("v"+boost::lexical_cast<std::string>(o));
+
+    // check results
+    for (int o=0; o<nb_objects; ++o)
+    {
+      const int offset=100000*(o+nb_objects*pass);
+      const std::vector<int>& v1=data[o];
+      Uint idx=0;
+      Uint i;
+      for (i=0; i<  nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-0*nproc)/1)+1)*1000+idx+1+offset)) );
+      for (   ; i<3*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-1*nproc)/2)+1)*1000+idx+1+offset)) );
+      for (   ; i<6*nproc; i++, idx++ ) BOOST_CHECK_EQUAL( v1[i], (int)(-((((i-3*nproc)/3)+1)*1000+idx+1+offset)) );
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( commpattern_external_synchronization )
 {
 /*
@@ -0,0 +1,100 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+//
+// IMPORTANT:
+// run it both on 1 and many cores
+// for example: mpirun -np 4 ./utest-parallel-reductionbatch --report_level=confirm or --report_level=detailed
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::common::PE::ReductionBatch"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Log.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/ReductionBatch.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::common::PE;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct ReductionBatchFixture
+{
+  ReductionBatchFixture()
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+  }
+
+  int m_argc;
+  char** m_argv;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( ReductionBatchSuite, ReductionBatchFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init )
+{
+  PE::Comm::instance().init(m_argc,m_argv);
+  BOOST_CHECK_EQUAL( PE::Comm::instance().is_active() , true );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( mixed_reductions )
+{
+  const Uint nproc = PE::Comm::instance().size();
+  const Real rank = PE::Comm::instance().rank();
+
+  ReductionBatch batch;
+  const Real sums[] = { 1., rank };
+  const Uint sum_idx = batch.add_sum(sums, 2);
+  const Uint max_idx = batch.add_max(rank);
+  const Uint min_idx = batch.add_min(rank + 10.);
+  const Uint count_idx = batch.add_sum(3.);
+  BOOST_CHECK_EQUAL(batch.size(), 5u);
+
+  batch.begin();
+  BOOST_CHECK(batch.is_pending());
+  BOOST_CHECK_THROW(batch.add_sum(1.), SetupError);
+  batch.end();
+
+  BOOST_CHECK_EQUAL(batch.result(sum_idx), static_cast<Real>(nproc));
+  BOOST_CHECK_EQUAL(batch.result(sum_idx+1), static_cast<Real>(nproc*(nproc-1)/2));
+  BOOST_CHECK_EQUAL(batch.result(max_idx), static_cast<Real>(nproc-1));
+  BOOST_CHECK_EQUAL(batch.result(min_idx), 10.);
+  BOOST_CHECK_EQUAL(batch.result(count_idx), static_cast<Real>(3*nproc));
+
+  // Reuse for a next phase with only minima
+  batch.clear();
+  const Uint neg_idx = batch.add_min(-rank);
+  batch.execute();
+  BOOST_CHECK_EQUAL(batch.result(neg_idx), -static_cast<Real>(nproc-1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( finalize )
+{
+  CFinfo.setFilterRankZero(true);
+  PE::Comm::instance().finalize();
+  BOOST_CHECK_EQUAL( PE::Comm::instance().is_active() , false );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -869,6 +869,67 @@ BOOST_AUTO_TEST_CASE( test_complete_system )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( test_assembly_plan )
+{
+  boost::shared_ptr<common::PE::CommPattern> cp_ptr = common::allocate_component<common::PE::CommPattern>("commpattern");
+  common::PE::CommPattern& cp = *cp_ptr;
+  build_commpattern(cp);
+  boost::shared_ptr<LSS::System> sys(common::allocate_component<LSS::System>("sys"));
+  sys->options().option("matrix_builder").change_value(matrix_builder);
+  build_system(*sys,cp);
+
+  // Only some matrix types support an assembly plan
+  if(!sys->matrix()->options().check("assembly_plan"))
+    return;
+
+  // Single-node blocks for the nodes that have a row in the connectivity, and on rank 1 a block coupling 3 nodes
+  std::vector< std::vector<Uint> > blocks;
+  for(Uint i = 0; i != starting_indices.size()-1; ++i)
+  {
+    if(starting_indices[i+1] != starting_indices[i])
+      blocks.push_back(std::vector<Uint>(1, i));
+  }
+  if(irank == 1)
+  {
+    std::vector<Uint> coupled_block;
+    coupled_block += 3,2,7;
+    blocks.push_back(coupled_block);
+  }
+
+  std::vector<Uint> cols, rows;
+  std::vector<Real> ref_vals, vals;
+
+  // Assemble all blocks, in the given order
+  for(Uint pass = 0; pass != 4; ++pass)
+  {
+    // pass 0: reference without plan, 1: record, 2: replay, 3: reversed order, forcing a new recording
+    if(pass == 1)
+      sys->matrix()->options().set("assembly_plan", true);
+
+    sys->matrix()->reset();
+    const Uint nb_blocks = blocks.size();
+    for(Uint b = 0; b != nb_blocks; ++b)
+    {
+      const std::vector<Uint>& block = blocks[pass == 3 ? nb_blocks-1-b : b];
+      LSS::BlockAccumulator ba;
+      ba.resize(block.size(),neq);
+      for(int i = 0; i != ba.mat.rows(); ++i)
+        for(int j = 0; j != ba.mat.cols(); ++j)
+          ba.mat(i,j) = block[i/neq]*100. + i*10. + j;
+      ba.neighbour_indices(block);
+      sys->matrix()->add_values(ba);
+    }
+
+    sys->matrix()->debug_data(rows,cols,pass == 0 ? ref_vals : vals);
+    if(pass != 0)
+    {
+      BOOST_CHECK(vals == ref_vals);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( solve_system )
 {
 
@@ -0,0 +1,383 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+//
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the native block CSR linear system backend"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/assign/std/vector.hpp>
+
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "common/PE/CommWrapper.hpp"
+
+#include "math/MatrixTypes.hpp"
+#include "math/LSS/System.hpp"
+#include "math/LSS/SolutionStrategy.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::math::LSS;
+
+using namespace boost::assign;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct BlockCSRFixture
+{
+  BlockCSRFixture() :
+    nb_owned(10),
+    nproc(1),
+    irank(0)
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+    if(common::PE::Comm::instance().is_active())
+    {
+      nproc = common::PE::Comm::instance().size();
+      irank = common::PE::Comm::instance().rank();
+    }
+    nb_global = nb_owned*nproc;
+    first_owned = nb_owned*irank;
+  }
+
+  /// Commpattern for a chain of nodes, each node connected to its neighbours. Each rank owns a contiguous part of the chain,
+  /// numbered first, followed by the ghosts at either end.
+  void build_commpattern()
+  {
+    cp = common::allocate_component<common::PE::CommPattern>("commpattern");
+    gid.clear();
+    rank.clear();
+    for(Uint i = 0; i != nb_owned; ++i)
+    {
+      gid.push_back(first_owned+i);
+      rank.push_back(irank);
+    }
+    if(irank != 0)
+    {
+      gid.push_back(first_owned-1);
+      rank.push_back(irank-1);
+    }
+    if(irank != nproc-1)
+    {
+      gid.push_back(first_owned+nb_owned);
+      rank.push_back(irank+1);
+    }
+
+    // Only the owned nodes have connectivity
+    node_connectivity.clear();
+    starting_indices.assign(1, 0u);
+    for(Uint i = 0; i != gid.size(); ++i)
+    {
+      if(i < nb_owned)
+      {
+        const Uint g = gid[i];
+        if(g != 0)
+          node_connectivity.push_back(local_index(g-1));
+        node_connectivity.push_back(i);
+        if(g != nb_global-1)
+          node_connectivity.push_back(local_index(g+1));
+      }
+      starting_indices.push_back(node_connectivity.size());
+    }
+    cp->insert("gid", gid, 1, false);
+    cp->setup(Handle<common::PE::CommWrapper>(cp->get_child("gid")), rank);
+  }
+
+  /// Local index of a global node, or gid.size() if the node is not present on this rank
+  Uint local_index(const Uint global_node) const
+  {
+    return std::find(gid.begin(), gid.end(), global_node) - gid.begin();
+  }
+
+  /// Entry (i,j) of the matrix of the 2-node element e, non-symmetric and diagonally dominant
+  static Real element_value(const Uint e, const Uint i, const Uint j, const Uint neq)
+  {
+    Real result = 0.02 * static_cast<Real>((i*7 + j*3 + e) % 5);
+    if(i == j)
+      result += 4.;
+    else if(i % neq == j % neq)
+      result -= 1.;
+    return result;
+  }
+
+  /// Create a system of neq equations per node and assemble the elements that touch an owned node
+  void build_system(const Uint neq, const std::string& preconditioner)
+  {
+    build_commpattern();
+    sys = common::allocate_component<LSS::System>("system");
+    sys->options().option("matrix_builder").change_value(std::string("cf3.math.LSS.BlockCSRMatrix"));
+    sys->options().option("solution_strategy").change_value(std::string("cf3.math.LSS.BlockCSRStrategy"));
+    sys->create(*cp, neq, node_connectivity, starting_indices);
+    sys->solution_strategy()->options().option("preconditioner").change_value(preconditioner);
+    sys->solution_strategy()->options().option("tolerance").change_value(1e-12);
+
+    BlockAccumulator ba;
+    ba.resize(2, neq);
+    const Uint size = 2*neq;
+    const Uint first_element = irank == 0 ? 0 : first_owned-1;
+    const Uint last_element = std::min(first_owned+nb_owned, nb_global-1);
+    for(Uint e = first_element; e != last_element; ++e)
+    {
+      ba.indices[0] = local_index(e);
+      ba.indices[1] = local_index(e+1);
+      for(Uint i = 0; i != size; ++i)
+        for(Uint j = 0; j != size; ++j)
+          ba.mat(i,j) = element_value(e, i, j, neq);
+      sys->matrix()->add_values(ba);
+    }
+  }
+
+  /// Dense global matrix, assembled from all elements
+  RealMatrix reference_matrix(const Uint neq)
+  {
+    const Uint size = nb_global*neq;
+    RealMatrix result(size, size);
+    result.setZero();
+    for(Uint e = 0; e != nb_global-1; ++e)
+      for(Uint i = 0; i != 2*neq; ++i)
+        for(Uint j = 0; j != 2*neq; ++j)
+          result(e*neq+i, e*neq+j) += element_value(e, i, j, neq);
+    return result;
+  }
+
+  /// Dense global copy of the local rows of the system matrix, with the other rows set to zero
+  RealMatrix dense_matrix()
+  {
+    const Uint neq = sys->matrix()->neq();
+    RealMatrix result(nb_global*neq, nb_global*neq);
+    result.setZero();
+    std::vector<Uint> rows, cols;
+    std::vector<Real> vals;
+    sys->matrix()->debug_data(rows, cols, vals);
+    for(Uint i = 0; i != vals.size(); ++i)
+      result(global_index(rows[i], neq), global_index(cols[i], neq)) = vals[i];
+    return result;
+  }
+
+  /// Global index of a local matrix or vector row
+  Uint global_index(const Uint local_row, const Uint neq) const
+  {
+    return gid[local_row/neq]*neq + local_row%neq;
+  }
+
+  /// Global indices of the rows owned by this rank
+  Uint owned_begin(const Uint neq) const { return first_owned*neq; }
+  Uint owned_end(const Uint neq) const { return (first_owned+nb_owned)*neq; }
+
+  /// Values of the owned rows of a vector, in global numbering
+  RealVector vector_values(LSS::Vector& v)
+  {
+    const Uint neq = v.neq();
+    RealVector result(nb_global*neq);
+    result.setZero();
+    for(Uint i = 0; i != nb_owned*neq; ++i)
+      v.get_value(i, result[global_index(i, neq)]);
+    return result;
+  }
+
+  /// Set all local rows of a vector from global values
+  void set_vector_values(LSS::Vector& v, const RealVector& values)
+  {
+    const Uint neq = v.neq();
+    for(Uint i = 0; i != gid.size()*neq; ++i)
+      v.set_value(i, values[global_index(i, neq)]);
+  }
+
+  /// Solve for a known solution and check the result
+  void check_solve(const Uint neq, const std::string& preconditioner)
+  {
+    build_system(neq, preconditioner);
+    const RealMatrix a = reference_matrix(neq);
+    RealVector x_exact(nb_global*neq);
+    for(Uint i = 0; i != x_exact.size(); ++i)
+      x_exact[i] = 1. + 0.1*static_cast<Real>(i);
+
+    set_vector_values(*sys->rhs(), a*x_exact);
+    sys->solution()->reset(0.);
+    sys->solve();
+
+    const RealVector x = vector_values(*sys->solution());
+    for(Uint i = owned_begin(neq); i != owned_end(neq); ++i)
+      BOOST_CHECK_CLOSE(x[i], x_exact[i], 1e-8);
+    BOOST_CHECK_SMALL(sys->solution_strategy()->compute_residual(), 1e-9);
+    BOOST_CHECK(sys->solution_strategy()->properties().value<Uint>("iterations") > 0);
+  }
+
+  /// Number of nodes owned by each rank
+  const Uint nb_owned;
+  Uint nproc;
+  Uint irank;
+  Uint nb_global;
+  Uint first_owned;
+
+  std::vector<Uint> gid;
+  std::vector<Uint> rank;
+  std::vector<Uint> node_connectivity;
+  std::vector<Uint> starting_indices;
+  boost::shared_ptr<common::PE::CommPattern> cp;
+  boost::shared_ptr<LSS::System> sys;
+
+  int m_argc;
+  char** m_argv;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( BlockCSRSuite, BlockCSRFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  common::PE::Comm::instance().init(m_argc,m_argv);
+  BOOST_CHECK_EQUAL(common::PE::Comm::instance().is_active(),true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( apply )
+{
+  build_system(3, "None");
+  const RealMatrix a = reference_matrix(3);
+  const RealMatrix a_local = dense_matrix();
+  for(Uint i = owned_begin(3); i != owned_end(3); ++i)
+    for(Uint j = 0; j != a.cols(); ++j)
+      BOOST_CHECK_EQUAL(a_local(i,j), a(i,j));
+
+  // Only the blocks of connected nodes are stored
+  if(irank == 0)
+  {
+    BOOST_CHECK_EQUAL(a_local(0, 3*(nb_global-1)), 0.);
+    BOOST_CHECK(a_local(0, 3) != 0.);
+  }
+
+  RealVector x(nb_global*3), y0(nb_global*3);
+  for(Uint i = 0; i != x.size(); ++i)
+  {
+    x[i] = static_cast<Real>(i % 4) - 1.5;
+    y0[i] = static_cast<Real>(i % 3);
+  }
+  set_vector_values(*sys->solution(), x);
+
+  // y = 2*A*x + 0.5*y, twice to check that the reused product buffer does not leak between calls
+  for(Uint repeat = 0; repeat != 2; ++repeat)
+  {
+    set_vector_values(*sys->rhs(), y0);
+    sys->matrix()->apply(sys->rhs(), sys->solution(), 2., 0.5);
+    const RealVector y = vector_values(*sys->rhs());
+    const RealVector y_ref = 2.*(a*x) + 0.5*y0;
+    for(Uint i = owned_begin(3); i != owned_end(3); ++i)
+      BOOST_CHECK_CLOSE(y[i], y_ref[i], 1e-10);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( solve_ilu )
+{
+  check_solve(3, "ILU0");
+}
+
+BOOST_AUTO_TEST_CASE( solve_jacobi )
+{
+  check_solve(3, "Jacobi");
+}
+
+BOOST_AUTO_TEST_CASE( solve_dynamic_block_size )
+{
+  check_solve(9, "ILU0");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The BC node is the first node of rank 1, so in parallel it is a ghost on rank 0
+BOOST_AUTO_TEST_CASE( symmetric_dirichlet )
+{
+  build_system(2, "ILU0");
+  const RealMatrix a = reference_matrix(2);
+  const Uint bc_node = nproc == 1 ? 4 : nb_owned;
+  const Uint dof = bc_node*2+1;
+
+  sys->rhs()->reset(1.);
+  const Uint bc_local = local_index(bc_node);
+  if(bc_local != gid.size())
+    sys->dirichlet(bc_local, 1, 3., true);
+
+  const RealMatrix a_bc = dense_matrix();
+  for(Uint i = owned_begin(2); i != owned_end(2); ++i)
+  {
+    BOOST_CHECK_EQUAL(a_bc(i, dof), i == dof ? 1. : 0.);
+    if(i == dof)
+    {
+      for(Uint j = 0; j != a_bc.cols(); ++j)
+        BOOST_CHECK_EQUAL(a_bc(dof, j), j == dof ? 1. : 0.);
+    }
+  }
+
+  // The moved column ends up in the RHS
+  const RealVector rhs = vector_values(*sys->rhs());
+  for(Uint i = owned_begin(2); i != owned_end(2); ++i)
+    BOOST_CHECK_CLOSE(rhs[i], i == dof ? 3. : 1. - 3.*a(i, dof), 1e-10);
+
+  sys->solve();
+  if(bc_local < nb_owned)
+  {
+    Real bc_value;
+    sys->solution()->get_value(bc_local, 1, bc_value);
+    BOOST_CHECK_CLOSE(bc_value, 3., 1e-8);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( get_column_and_replace_to_zero )
+{
+  build_system(2, "None");
+  const RealMatrix a = reference_matrix(2);
+  const Uint col_node = nproc == 1 ? 4 : nb_owned;
+  const Uint dof = col_node*2+1;
+  const Uint col_local = local_index(col_node);
+  if(col_local == gid.size())
+    return;
+
+  std::vector<Real> column;
+  sys->matrix()->get_column_and_replace_to_zero(col_local, 1, column);
+  BOOST_CHECK_EQUAL(column.size(), gid.size()*2);
+  for(Uint i = 0; i != nb_owned*2; ++i)
+    BOOST_CHECK_EQUAL(column[i], a(global_index(i, 2), dof));
+  for(Uint i = nb_owned*2; i != column.size(); ++i)
+    BOOST_CHECK_EQUAL(column[i], 0.);
+
+  const RealMatrix a_zero = dense_matrix();
+  for(Uint i = owned_begin(2); i != owned_end(2); ++i)
+    for(Uint j = 0; j != a.cols(); ++j)
+      BOOST_CHECK_EQUAL(a_zero(i,j), j == dof ? 0. : a(i,j));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  common::PE::Comm::instance().finalize();
+  BOOST_CHECK_EQUAL(common::PE::Comm::instance().is_active(),false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,439 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+//
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the matrix-free linear system backend"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "common/PE/CommWrapper.hpp"
+
+#include "math/MatrixTypes.hpp"
+#include "math/LSS/System.hpp"
+#include "math/LSS/SolutionStrategy.hpp"
+#include "math/LSS/MatrixFree/MatrixFreeMatrix.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::math::LSS;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct MatrixFreeFixture
+{
+  /// Two third order hexahedra per rank next to each other in the x direction, with 5 quadrature points per direction
+  MatrixFreeFixture() :
+    nd(4),
+    nq(5),
+    nproc(common::PE::Comm::instance().is_active() ? common::PE::Comm::instance().size() : 1),
+    irank(common::PE::Comm::instance().is_active() ? common::PE::Comm::instance().rank() : 0),
+    nb_elems(2*nproc),
+    nx(3*nb_elems+1),
+    nb_nodes(nx*nd*nd),
+    mass(1.),
+    diffusion(0.5)
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+
+    // The kernels don't need an actual quadrature rule, so use arbitrary points and positive weights to test the algebra
+    const Real nodes_1d[] = {-1., -1./3., 1./3., 1.};
+    const Real points_1d[] = {-0.9, -0.5, 0.1, 0.4, 0.8};
+    const Real weights_1d[] = {0.3, 0.5, 0.6, 0.4, 0.2};
+    values_1d.resize(nq*nd);
+    derivatives_1d.resize(nq*nd);
+    for(Uint q = 0; q != nq; ++q)
+    {
+      weights.push_back(weights_1d[q]);
+      for(Uint i = 0; i != nd; ++i)
+      {
+        Real value = 1.;
+        Real derivative = 0.;
+        for(Uint j = 0; j != nd; ++j)
+        {
+          if(j == i)
+            continue;
+          Real term = 1. / (nodes_1d[i] - nodes_1d[j]);
+          for(Uint k = 0; k != nd; ++k)
+            if(k != i && k != j)
+              term *= (points_1d[q] - nodes_1d[k]) / (nodes_1d[i] - nodes_1d[k]);
+          derivative += term;
+          value *= (points_1d[q] - nodes_1d[j]) / (nodes_1d[i] - nodes_1d[j]);
+        }
+        values_1d[q*nd + i] = value;
+        derivatives_1d[q*nd + i] = derivative;
+      }
+    }
+
+    // Element rows and geometric factors of an affine map with a different Jacobian for each element
+    for(Uint e = 0; e != nb_elems; ++e)
+    {
+      for(Uint iz = 0; iz != nd; ++iz)
+        for(Uint iy = 0; iy != nd; ++iy)
+          for(Uint ix = 0; ix != nd; ++ix)
+            element_rows.push_back(3*e + ix + nx*(iy + nd*iz));
+
+      RealMatrix3 jacobian;
+      jacobian << 0.5 + 0.1*e, 0.1, 0.,
+                  0.05, 0.6, 0.1*e,
+                  0., 0.02, 0.4;
+      const RealMatrix3 inverse_metric = (jacobian * jacobian.transpose()).inverse();
+      const Real det = jacobian.determinant();
+      for(Uint qz = 0; qz != nq; ++qz)
+        for(Uint qy = 0; qy != nq; ++qy)
+          for(Uint qx = 0; qx != nq; ++qx)
+          {
+            const Real jxw = det*weights[qx]*weights[qy]*weights[qz];
+            geometry.push_back(jxw);
+            geometry.push_back(jxw*inverse_metric(0,0));
+            geometry.push_back(jxw*inverse_metric(0,1));
+            geometry.push_back(jxw*inverse_metric(0,2));
+            geometry.push_back(jxw*inverse_metric(1,1));
+            geometry.push_back(jxw*inverse_metric(1,2));
+            geometry.push_back(jxw*inverse_metric(2,2));
+          }
+    }
+  }
+
+  /// Rank that owns the nodes with the given x index: each rank owns the first 6 planes of its elements, the last rank also the final plane
+  Uint owner(const Uint ix) const
+  {
+    return std::min(ix / 6, nproc-1);
+  }
+
+  /// Commpattern with the owned nodes first, followed by the ghost nodes of the elements that contain an owned node.
+  /// The node connectivity is not used by the matrix-free operator.
+  void build_commpattern()
+  {
+    local_elements.clear();
+    for(Uint e = 0; e != nb_elems; ++e)
+      if(owner(3*e) == irank || owner(3*e+3) == irank)
+        local_elements.push_back(e);
+
+    std::set<Uint> ghosts;
+    gid.clear();
+    for(Uint i = 0; i != nb_nodes; ++i)
+      if(owner(i % nx) == irank)
+        gid.push_back(i);
+    nb_owned = gid.size();
+    for(Uint e = 0; e != local_elements.size(); ++e)
+      for(Uint i = 0; i != nd*nd*nd; ++i)
+        if(owner(element_rows[local_elements[e]*nd*nd*nd + i] % nx) != irank)
+          ghosts.insert(element_rows[local_elements[e]*nd*nd*nd + i]);
+    gid.insert(gid.end(), ghosts.begin(), ghosts.end());
+
+    rank.clear();
+    local_index.clear();
+    for(Uint i = 0; i != gid.size(); ++i)
+    {
+      rank.push_back(owner(gid[i] % nx));
+      local_index[gid[i]] = i;
+    }
+
+    cp = common::allocate_component<common::PE::CommPattern>("commpattern");
+    node_connectivity.clear();
+    starting_indices.assign(gid.size()+1, 0u);
+    cp->insert("gid", gid, 1, false);
+    cp->setup(Handle<common::PE::CommWrapper>(cp->get_child("gid")), rank);
+  }
+
+  void build_system(const std::string& preconditioner)
+  {
+    build_commpattern();
+    sys = common::allocate_component<LSS::System>("system");
+    sys->options().option("matrix_builder").change_value(std::string("cf3.math.LSS.MatrixFreeMatrix"));
+    sys->options().option("solution_strategy").change_value(std::string("cf3.math.LSS.MatrixFreeStrategy"));
+    sys->create(*cp, 1, node_connectivity, starting_indices);
+    sys->solution_strategy()->options().option("preconditioner").change_value(preconditioner);
+    sys->solution_strategy()->options().option("tolerance").change_value(1e-12);
+
+    Handle<MatrixFreeMatrix> matrix(sys->matrix());
+    BOOST_REQUIRE(is_not_null(matrix));
+    matrix->options().set("mass_coefficient", mass);
+    matrix->options().set("diffusion_coefficient", diffusion);
+
+    // Operator data of the local elements, in local numbering
+    const Uint nb_dofs = nd*nd*nd;
+    const Uint nb_factors = 7*nq*nq*nq;
+    std::vector<Uint> local_rows;
+    std::vector<Real> local_geometry;
+    for(Uint e = 0; e != local_elements.size(); ++e)
+    {
+      const Uint elem = local_elements[e];
+      for(Uint i = 0; i != nb_dofs; ++i)
+        local_rows.push_back(local_index[element_rows[elem*nb_dofs + i]]);
+      local_geometry.insert(local_geometry.end(), geometry.begin() + elem*nb_factors, geometry.begin() + (elem+1)*nb_factors);
+    }
+    matrix->set_operator(nd, nq, values_1d, derivatives_1d, local_rows, local_geometry);
+  }
+
+  /// True if the global row is owned by this rank
+  bool is_owned(const Uint i) const
+  {
+    return owner(i % nx) == irank;
+  }
+
+  /// Local index of a global node, or gid.size() if it is not on this rank
+  Uint find_local(const Uint i) const
+  {
+    const std::map<Uint, Uint>::const_iterator it = local_index.find(i);
+    return it == local_index.end() ? gid.size() : it->second;
+  }
+
+  /// Dense matrix assembled from the element matrices computed without sum factorisation
+  RealMatrix reference_matrix()
+  {
+    const Uint nb_dofs = nd*nd*nd;
+    const Uint nb_qdr = nq*nq*nq;
+    RealMatrix result(nb_nodes, nb_nodes);
+    result.setZero();
+    for(Uint e = 0; e != nb_elems; ++e)
+    {
+      for(Uint q = 0; q != nb_qdr; ++q)
+      {
+        const Uint qx = q % nq, qy = (q / nq) % nq, qz = q / (nq*nq);
+        const Real* g = &geometry[(e*nb_qdr + q)*7];
+        RealMatrix3 g_mat;
+        g_mat << g[1], g[2], g[3],
+                 g[2], g[4], g[5],
+                 g[3], g[5], g[6];
+        for(Uint i = 0; i != nb_dofs; ++i)
+        {
+          const RealVector3 grad_i = gradient(i, qx, qy, qz);
+          for(Uint j = 0; j != nb_dofs; ++j)
+          {
+            const RealVector3 grad_j = gradient(j, qx, qy, qz);
+            result(element_rows[e*nb_dofs+i], element_rows[e*nb_dofs+j]) += mass*g[0]*value(i, qx, qy, qz)*value(j, qx, qy, qz) + diffusion*grad_i.dot(g_mat*grad_j);
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  Real value(const Uint i, const Uint qx, const Uint qy, const Uint qz)
+  {
+    return values_1d[qx*nd + i%nd] * values_1d[qy*nd + (i/nd)%nd] * values_1d[qz*nd + i/(nd*nd)];
+  }
+
+  RealVector3 gradient(const Uint i, const Uint qx, const Uint qy, const Uint qz)
+  {
+    const Uint ix = i%nd, iy = (i/nd)%nd, iz = i/(nd*nd);
+    RealVector3 result;
+    result[0] = derivatives_1d[qx*nd + ix] * values_1d[qy*nd + iy] * values_1d[qz*nd + iz];
+    result[1] = values_1d[qx*nd + ix] * derivatives_1d[qy*nd + iy] * values_1d[qz*nd + iz];
+    result[2] = values_1d[qx*nd + ix] * values_1d[qy*nd + iy] * derivatives_1d[qz*nd + iz];
+    return result;
+  }
+
+  /// Values of the owned rows of a vector in global numbering, zero elsewhere
+  RealVector vector_values(LSS::Vector& v)
+  {
+    RealVector result(nb_nodes);
+    result.setZero();
+    for(Uint i = 0; i != nb_owned; ++i)
+      v.get_value(i, result[gid[i]]);
+    return result;
+  }
+
+  /// Set all local rows of a vector from global values
+  void set_vector_values(LSS::Vector& v, const RealVector& values)
+  {
+    for(Uint i = 0; i != gid.size(); ++i)
+      v.set_value(i, values[gid[i]]);
+  }
+
+  const Uint nd;
+  const Uint nq;
+  const Uint nproc;
+  const Uint irank;
+  const Uint nb_elems;
+  const Uint nx;
+  const Uint nb_nodes;
+  const Real mass;
+  const Real diffusion;
+
+  std::vector<Real> weights;
+  std::vector<Real> values_1d;
+  std::vector<Real> derivatives_1d;
+  /// Global rows and geometric factors of all elements
+  std::vector<Uint> element_rows;
+  std::vector<Real> geometry;
+
+  /// Elements that contain a node owned by this rank
+  std::vector<Uint> local_elements;
+  /// Number of owned nodes, which come first in gid
+  Uint nb_owned;
+  std::map<Uint, Uint> local_index;
+
+  std::vector<Uint> gid;
+  std::vector<Uint> rank;
+  std::vector<Uint> node_connectivity;
+  std::vector<Uint> starting_indices;
+  boost::shared_ptr<common::PE::CommPattern> cp;
+  boost::shared_ptr<LSS::System> sys;
+
+  int m_argc;
+  char** m_argv;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( MatrixFreeSuite, MatrixFreeFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  common::PE::Comm::instance().init(m_argc,m_argv);
+  BOOST_CHECK_EQUAL(common::PE::Comm::instance().is_active(),true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( apply )
+{
+  build_system("None");
+  const RealMatrix a = reference_matrix();
+
+  RealVector x(nb_nodes), y0(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    x[i] = static_cast<Real>(i % 4) - 1.5;
+    y0[i] = static_cast<Real>(i % 3);
+  }
+  set_vector_values(*sys->solution(), x);
+  set_vector_values(*sys->rhs(), y0);
+
+  // y = 2*A*x + 0.5*y
+  sys->matrix()->apply(sys->rhs(), sys->solution(), 2., 0.5);
+  const RealVector y = vector_values(*sys->rhs());
+  const RealVector y_ref = 2.*(a*x) + 0.5*y0;
+  for(Uint i = 0; i != nb_nodes; ++i)
+    if(is_owned(i))
+      BOOST_CHECK_CLOSE(y[i], y_ref[i], 1e-9);
+
+  // The exported entries match the reference matrix. Exporting only works in serial.
+  if(nproc != 1)
+    return;
+  std::vector<Uint> rows, cols;
+  std::vector<Real> vals;
+  sys->matrix()->debug_data(rows, cols, vals);
+  RealMatrix exported(nb_nodes, nb_nodes);
+  exported.setZero();
+  for(Uint i = 0; i != vals.size(); ++i)
+    exported(rows[i], cols[i]) = vals[i];
+  BOOST_CHECK_SMALL((exported - a).norm() / a.norm(), 1e-12);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( diagonal )
+{
+  build_system("None");
+  const RealMatrix a = reference_matrix();
+
+  std::vector<Real> diag;
+  sys->matrix()->get_diagonal(diag);
+  BOOST_CHECK_EQUAL(diag.size(), gid.size());
+  for(Uint i = 0; i != nb_owned; ++i)
+    BOOST_CHECK_CLOSE(diag[i], a(gid[i],gid[i]), 1e-9);
+
+  // Adding to the diagonal changes the product accordingly
+  std::vector<Real> extra(gid.size(), 2.);
+  sys->matrix()->add_diagonal(extra);
+  RealVector x(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    x[i] = 1. + 0.01*static_cast<Real>(i);
+  set_vector_values(*sys->solution(), x);
+  sys->matrix()->apply(sys->rhs(), sys->solution());
+  const RealVector y = vector_values(*sys->rhs());
+  const RealVector y_ref = a*x + 2.*x;
+  for(Uint i = 0; i != nb_nodes; ++i)
+    if(is_owned(i))
+      BOOST_CHECK_CLOSE(y[i], y_ref[i], 1e-9);
+
+  // reset removes the correction
+  sys->matrix()->reset();
+  sys->matrix()->get_diagonal(diag);
+  for(Uint i = 0; i != nb_owned; ++i)
+    BOOST_CHECK_CLOSE(diag[i], a(gid[i],gid[i]), 1e-9);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( symmetric_dirichlet_solve )
+{
+  const std::string preconditioners[] = {"Chebyshev", "Jacobi", "None"};
+  for(Uint p = 0; p != 3; ++p)
+  {
+    build_system(preconditioners[p]);
+    const RealMatrix a = reference_matrix();
+
+    RealVector x_exact(nb_nodes);
+    for(Uint i = 0; i != nb_nodes; ++i)
+      x_exact[i] = 1. + 0.1*static_cast<Real>(i % 9);
+
+    // Dirichlet conditions on the nodes of the x = 0 face, which are only present on the first rank
+    set_vector_values(*sys->rhs(), a*x_exact);
+    sys->solution()->reset(0.);
+    for(Uint i = 0; i != nb_nodes; i += nx)
+      if(find_local(i) != gid.size())
+        sys->dirichlet(find_local(i), 0, x_exact[i], true);
+
+    // The constrained columns are removed
+    RealVector e(nb_nodes);
+    e.setZero();
+    e[0] = 1.;
+    set_vector_values(*sys->solution(), e);
+    sys->matrix()->apply(sys->rhs(), sys->solution(), 1., 0.);
+    if(irank == 0)
+      BOOST_CHECK_EQUAL(vector_values(*sys->rhs())[1], 0.);
+
+    // Redo the RHS, the conditions are kept since there was no reset
+    set_vector_values(*sys->rhs(), a*x_exact);
+    sys->solution()->reset(0.);
+    for(Uint i = 0; i != nb_nodes; i += nx)
+      if(find_local(i) != gid.size())
+        sys->dirichlet(find_local(i), 0, x_exact[i], true);
+
+    sys->solve();
+    const RealVector x = vector_values(*sys->solution());
+    for(Uint i = 0; i != nb_nodes; ++i)
+      if(is_owned(i))
+        BOOST_CHECK_CLOSE(x[i], x_exact[i], 1e-7);
+    BOOST_CHECK(sys->solution_strategy()->properties().value<Uint>("iterations") > 0);
+    BOOST_CHECK_SMALL(sys->solution_strategy()->compute_residual(), 1e-9);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  common::PE::Comm::instance().finalize();
+  BOOST_CHECK_EQUAL(common::PE::Comm::instance().is_active(),false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
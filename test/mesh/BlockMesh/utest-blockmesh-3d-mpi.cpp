@@ -7,11 +7,15 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Test module for cf3::mesh::BlockMesh::BlockMeshMPI"
 
+#include <cmath>
+#include <map>
+
 #include <boost/assign.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/test/unit_test.hpp>
 
 #include "common/Core.hpp"
+#include "common/FindComponents.hpp"
 #include "common/Log.hpp"
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
@@ -146,10 +150,80 @@ BOOST_AUTO_TEST_CASE( GenerateMesh )
   {
     blocks.partition_blocks(nb_procs, XX);
   }
-  
+
+  blocks.options().set("nb_threads", 2u);
   blocks.create_mesh(mesh());
 }
 
+BOOST_AUTO_TEST_CASE( Overlap )
+{
+  const Uint nb_procs = PE::Comm::instance().size();
+  const Uint rank = PE::Comm::instance().rank();
+  const Field& coords = mesh().geometry_fields().coordinates();
+  const Uint dim = coords.row_size();
+
+  // Element centroids, to check that overlap elements match the element with the same global index on their owner
+  std::map< Uint, std::vector<Real> > owned_centroids;
+  std::vector< std::vector<Real> > send(nb_procs), recv;
+  Uint nb_duplicates = 0;
+  Uint nb_overlap = 0;
+  boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh().topology()))
+  {
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+    for(Uint elem = 0; elem != elements.size(); ++elem)
+    {
+      std::vector<Real> centroid(dim, 0.);
+      boost_foreach(const Uint node, connectivity[elem])
+      {
+        for(Uint i = 0; i != dim; ++i)
+          centroid[i] += coords[node][i] / static_cast<Real>(connectivity.row_size());
+      }
+
+      const Uint gid = elements.glb_idx()[elem];
+      const Uint owner = elements.rank()[elem];
+      if(owner == rank)
+      {
+        if(!owned_centroids.insert(std::make_pair(gid, centroid)).second)
+          ++nb_duplicates;
+      }
+      else
+      {
+        ++nb_overlap;
+        send[owner].push_back(static_cast<Real>(gid));
+        send[owner].insert(send[owner].end(), centroid.begin(), centroid.end());
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL(nb_duplicates, 0);
+  if(nb_procs > 1 && domain().get_child("BlockArrays")->options().value<Uint>("overlap") != 0)
+    BOOST_CHECK(nb_overlap != 0);
+
+  PE::Comm::instance().all_to_all(send, recv);
+
+  Uint nb_mismatches = 0;
+  boost_foreach(const std::vector<Real>& received, recv)
+  {
+    for(Uint i = 0; i < received.size(); i += dim+1)
+    {
+      const std::map< Uint, std::vector<Real> >::const_iterator owned_it = owned_centroids.find(static_cast<Uint>(received[i]));
+      if(owned_it == owned_centroids.end())
+      {
+        ++nb_mismatches;
+        continue;
+      }
+      for(Uint j = 0; j != dim; ++j)
+      {
+        if(std::abs(owned_it->second[j] - received[i+1+j]) > 1e-10)
+        {
+          ++nb_mismatches;
+          break;
+        }
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL(nb_mismatches, 0);
+}
+
 BOOST_AUTO_TEST_CASE( RankField )
 {
   // Store element ranks
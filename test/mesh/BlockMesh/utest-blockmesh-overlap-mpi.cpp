@@ -0,0 +1,210 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the overlap of cf3::mesh::BlockMesh on non-convex block layouts"
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/List.hpp"
+#include "common/Table.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/BlockMesh/BlockData.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Domain.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshTransformer.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+
+/// Global node indices of each element in the mesh, per global element index
+typedef std::map< Uint, std::vector<Uint> > ElementNodesT;
+
+/// Collect the global node indices of the elements with the given owner rank, or of all elements if all_ranks is true
+void element_nodes(const Mesh& mesh, const Uint rank, const bool all_ranks, ElementNodesT& result)
+{
+  const common::List<Uint>& node_gids = mesh.geometry_fields().glb_idx();
+  boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+    for(Uint elem = 0; elem != elements.size(); ++elem)
+    {
+      if(!all_ranks && elements.rank()[elem] != rank)
+        continue;
+      std::vector<Uint>& nodes = result[elements.glb_idx()[elem]];
+      boost_foreach(const Uint node, connectivity[elem])
+        nodes.push_back(node_gids[node]);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( BlockMeshOverlap )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  BOOST_CHECK(PE::Comm::instance().is_active());
+}
+
+// L-shaped layout: the corner of the step is shared by three blocks, and elements on either side of it only touch at a node
+BOOST_AUTO_TEST_CASE( LShape )
+{
+  const Uint nb_procs = PE::Comm::instance().size();
+  const Uint rank = PE::Comm::instance().rank();
+
+  Domain& domain = *Core::instance().root().create_component<Domain>("domain");
+  BlockMesh::BlockArrays& blocks = *domain.create_component<BlockMesh::BlockArrays>("blocks");
+
+  const Uint segs = 8;
+
+  (*blocks.create_points(2, 8)) << 0. << 0.
+                                << 1. << 0.
+                                << 2. << 0.
+                                << 0. << 1.
+                                << 1. << 1.
+                                << 2. << 1.
+                                << 1. << 2.
+                                << 2. << 2.;
+
+  (*blocks.create_blocks(3)) << 0 << 1 << 4 << 3
+                             << 1 << 2 << 5 << 4
+                             << 4 << 5 << 7 << 6;
+
+  (*blocks.create_block_subdivisions()) << segs << segs
+                                        << segs << segs
+                                        << segs << segs;
+
+  (*blocks.create_block_gradings()) << 1. << 1. << 1. << 1.
+                                    << 1. << 1. << 1. << 1.
+                                    << 1. << 1. << 1. << 1.;
+
+  *blocks.create_patch("bottom", 2) << 0 << 1 << 1 << 2;
+  *blocks.create_patch("right", 2) << 2 << 5 << 5 << 7;
+  *blocks.create_patch("top", 1) << 7 << 6;
+  *blocks.create_patch("step", 2) << 6 << 4 << 4 << 3;
+  *blocks.create_patch("left", 1) << 3 << 0;
+
+  blocks.partition_blocks(nb_procs, XX);
+
+  // Reference mesh without overlap, where every rank only has its own elements
+  Mesh& reference = *domain.create_component<Mesh>("reference");
+  blocks.options().set("overlap", 0u);
+  blocks.create_mesh(reference);
+
+  Mesh& mesh = *domain.create_component<Mesh>("mesh");
+  blocks.options().set("overlap", 1u);
+  blocks.create_mesh(mesh);
+
+  // Send the owned elements of the reference mesh to all ranks, as a list of global element index, number of nodes and node indices
+  ElementNodesT owned;
+  element_nodes(reference, rank, false, owned);
+  std::vector<Uint> owned_flat;
+  for(ElementNodesT::const_iterator it = owned.begin(); it != owned.end(); ++it)
+  {
+    owned_flat.push_back(it->first);
+    owned_flat.push_back(it->second.size());
+    owned_flat.insert(owned_flat.end(), it->second.begin(), it->second.end());
+  }
+  std::vector< std::vector<Uint> > send(nb_procs, owned_flat), recv;
+  PE::Comm::instance().all_to_all(send, recv);
+
+  // Nodes of the local elements
+  std::set<Uint> local_nodes;
+  for(ElementNodesT::const_iterator it = owned.begin(); it != owned.end(); ++it)
+    local_nodes.insert(it->second.begin(), it->second.end());
+
+  // The overlap must consist of exactly the elements of other ranks that share a node with a local element
+  ElementNodesT expected_overlap;
+  for(Uint other_rank = 0; other_rank != nb_procs; ++other_rank)
+  {
+    if(other_rank == rank)
+      continue;
+    const std::vector<Uint>& received = recv[other_rank];
+    for(Uint i = 0; i < received.size(); i += 2 + received[i+1])
+    {
+      const std::vector<Uint> nodes(received.begin() + i + 2, received.begin() + i + 2 + received[i+1]);
+      for(Uint n = 0; n != nodes.size(); ++n)
+      {
+        if(local_nodes.count(nodes[n]))
+        {
+          expected_overlap[received[i]] = nodes;
+          break;
+        }
+      }
+    }
+  }
+
+  ElementNodesT all_elements;
+  element_nodes(mesh, rank, true, all_elements);
+  ElementNodesT owned_with_overlap;
+  element_nodes(mesh, rank, false, owned_with_overlap);
+
+  BOOST_CHECK(owned_with_overlap == owned);
+  BOOST_CHECK_EQUAL(all_elements.size(), owned.size() + expected_overlap.size());
+
+  Uint nb_missing = 0;
+  Uint nb_wrong_nodes = 0;
+  for(ElementNodesT::const_iterator it = expected_overlap.begin(); it != expected_overlap.end(); ++it)
+  {
+    const ElementNodesT::const_iterator found = all_elements.find(it->first);
+    if(found == all_elements.end())
+      ++nb_missing;
+    else if(found->second != it->second)
+      ++nb_wrong_nodes;
+  }
+  BOOST_CHECK_EQUAL(nb_missing, 0);
+  BOOST_CHECK_EQUAL(nb_wrong_nodes, 0);
+
+  // The reference mesh must give the same result after growing its overlap separately
+  Mesh& grown = *domain.create_component<Mesh>("grown");
+  blocks.options().set("overlap", 0u);
+  blocks.create_mesh(grown);
+  MeshTransformer& grow_overlap = *Handle<MeshTransformer>(domain.create_component("GrowOverlap", "cf3.mesh.actions.GrowOverlap"));
+  grow_overlap.transform(grown);
+  ElementNodesT grown_elements;
+  element_nodes(grown, rank, true, grown_elements);
+  BOOST_CHECK(grown_elements == all_elements);
+
+  // Second layer, grown from the nodes of the first one
+  Mesh& mesh_2 = *domain.create_component<Mesh>("mesh_2");
+  blocks.options().set("overlap", 2u);
+  blocks.create_mesh(mesh_2);
+  grow_overlap.transform(grown);
+  ElementNodesT all_elements_2;
+  element_nodes(mesh_2, rank, true, all_elements_2);
+  grown_elements.clear();
+  element_nodes(grown, rank, true, grown_elements);
+  BOOST_CHECK(all_elements_2.size() > all_elements.size());
+  BOOST_CHECK(grown_elements == all_elements_2);
+
+  Core::instance().root().remove_component("domain");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
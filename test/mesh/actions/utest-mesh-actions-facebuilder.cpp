@@ -27,6 +27,8 @@
 #include "mesh/MeshReader.hpp"
 #include "mesh/Field.hpp"
 #include "mesh/FaceCellConnectivity.hpp"
+#include "mesh/FaceNodeHash.hpp"
+#include "mesh/ElementConnectivity.hpp"
 #include "mesh/Cells.hpp"
 #include "mesh/CellFaces.hpp"
 #include "mesh/SimpleMeshGenerator.hpp"
@@ -392,6 +394,80 @@ BOOST_AUTO_TEST_CASE( build_faces_rectangle )
 
 //////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( face_node_hash )
+{
+  FaceNodeHash hash;
+  std::vector<Uint> quad = list_of(4u)(7u)(9u)(2u);
+  std::vector<Uint> rotated_quad = list_of(9u)(2u)(4u)(7u);
+  std::vector<Uint> triag = list_of(4u)(7u)(9u);
+
+  BOOST_CHECK_EQUAL(hash.find(quad), FaceNodeHash::not_found());
+  BOOST_CHECK_EQUAL(hash.insert(quad).first, 0u);
+  BOOST_CHECK_EQUAL(hash.insert(triag).first, 1u);
+
+  // the node order does not matter, the number of nodes does
+  BOOST_CHECK_EQUAL(hash.find(rotated_quad), 0u);
+  BOOST_CHECK_EQUAL(hash.insert(rotated_quad).second, false);
+  BOOST_CHECK_EQUAL(hash.find(triag), 1u);
+  BOOST_CHECK_EQUAL(hash.size(), 2u);
+
+  // grow beyond the initial number of slots
+  std::vector<Uint> line(2);
+  for (Uint i=0; i<100; ++i)
+  {
+    line[0] = i; line[1] = i+1;
+    BOOST_CHECK(hash.insert(line).second);
+  }
+  line[0] = 51; line[1] = 50;
+  BOOST_CHECK_EQUAL(hash.find(line), 52u);
+  BOOST_CHECK_EQUAL(hash.find(quad), 0u);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( build_cell2face_threaded )
+{
+  boost::shared_ptr<SimpleMeshGenerator> mesh_gen = allocate_component<SimpleMeshGenerator>("mesh_gen");
+  std::vector<Real> lengths  = list_of(10.)(10.);
+  std::vector<Uint> nb_cells = list_of(7u)(5u);
+  mesh_gen->options().set("mesh",URI("//rectangle_mesh_threaded"));
+  mesh_gen->options().set("lengths",lengths);
+  mesh_gen->options().set("nb_cells",nb_cells);
+  Mesh& rmesh = mesh_gen->generate();
+
+  boost::shared_ptr<BuildFaces> facebuilder = allocate_component<BuildFaces>("facebuilder");
+  facebuilder->options().set("store_cell2face",true);
+  facebuilder->options().set("nb_threads",3u);
+  facebuilder->set_mesh(rmesh);
+  facebuilder->execute();
+
+  // every face of every cell must point to a face that has this cell as a neighbour
+  boost_foreach(Cells& cells, find_components_recursively<Cells>(rmesh.topology()))
+  {
+    const ElementConnectivity& c2f = *cells.connectivity_cell2face();
+    BOOST_CHECK_EQUAL(c2f.size(), 35u);
+    for (Uint cell_idx=0; cell_idx<c2f.size(); ++cell_idx)
+    {
+      for (Uint face_nb=0; face_nb<c2f.row_size(); ++face_nb)
+      {
+        const Entity face = c2f[cell_idx][face_nb];
+        BOOST_REQUIRE(is_not_null(face.comp));
+        const FaceCellConnectivity& f2c = *face.comp->connectivity_face2cell();
+        bool found = false;
+        for (Uint side=0; side<f2c.connectivity().row_size(); ++side)
+        {
+          const Entity cell = f2c.connectivity()[face.idx][side];
+          if (cell.comp == &cells && cell.idx == cell_idx && f2c.face_number()[face.idx][side] == face_nb)
+            found = true;
+        }
+        BOOST_CHECK(found);
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ////////////////////////////////////////////////////////////////////////////////
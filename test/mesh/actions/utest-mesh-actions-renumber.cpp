@@ -0,0 +1,215 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Tests mesh::actions::Renumber"
+
+#include <algorithm>
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/assign/list_of.hpp>
+
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/Core.hpp"
+#include "common/Foreach.hpp"
+#include "common/List.hpp"
+
+#include "mesh/actions/Renumber.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/SimpleMeshGenerator.hpp"
+#include "mesh/Space.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::mesh::actions;
+using namespace boost::assign;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct TestRenumber_Fixture
+{
+  /// common setup for each test case
+  TestRenumber_Fixture()
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+  }
+
+  /// common tear-down for each test case
+  ~TestRenumber_Fixture()
+  {
+  }
+
+  /// Generate a rectangle with shuffled nodes and elements, and fields that can be used to check the renumbering
+  Mesh& shuffled_mesh(const std::string& name)
+  {
+    Handle<MeshGenerator> mesh_generator = Core::instance().root().create_component<SimpleMeshGenerator>("mesh_generator_"+name);
+    mesh_generator->options().set("mesh",Core::instance().root().uri()/name);
+    mesh_generator->options().set("lengths",std::vector<Real>(2,10.));
+    std::vector<Uint> nb_cells = list_of(20)(10);
+    mesh_generator->options().set("nb_cells",nb_cells);
+    Mesh& mesh = mesh_generator->generate();
+
+    Dictionary& geometry = mesh.geometry_fields();
+    Field& x = geometry.create_field("x");
+    for(Uint i = 0; i != geometry.size(); ++i)
+      x[i][0] = geometry.coordinates()[i][0];
+
+    boost_foreach(const Handle<Entities>& entities, mesh.elements())
+    {
+      Renumber::renumber_elements(*entities, permutation(entities->size()));
+    }
+    Renumber::renumber_nodes(geometry, permutation(geometry.size()));
+
+    Dictionary& elems_P0 = mesh.create_discontinuous_space("elems_P0","cf3.mesh.LagrangeP0");
+    Field& elem_idx = elems_P0.create_field("elem_idx");
+    boost_foreach(const Handle<Entities>& entities, mesh.elements())
+    {
+      const Space& space = elem_idx.space(*entities);
+      for(Uint e = 0; e != entities->size(); ++e)
+        elem_idx[space.connectivity()[e][0]][0] = entities->glb_idx()[e];
+    }
+
+    mesh.raise_mesh_changed();
+    return mesh;
+  }
+
+  /// Random permutation of size n
+  std::vector<Uint> permutation(const Uint n)
+  {
+    std::vector<Uint> result(n);
+    for(Uint i = 0; i != n; ++i)
+      result[i] = i;
+    std::random_shuffle(result.begin(), result.end());
+    return result;
+  }
+
+  /// Sum of the node coordinates of each element, by global element index
+  std::map<Uint, Real> element_coordinates(const Entities& entities)
+  {
+    std::map<Uint, Real> result;
+    const Field& coordinates = entities.geometry_fields().coordinates();
+    const Connectivity& connectivity = entities.geometry_space().connectivity();
+    for(Uint e = 0; e != entities.size(); ++e)
+    {
+      Real sum = 0.;
+      boost_foreach(const Uint node, connectivity[e])
+        sum += coordinates[node][0] + 2.*coordinates[node][1];
+      result[entities.glb_idx()[e]] = sum;
+    }
+    return result;
+  }
+
+  /// Check that all data followed the renumbering
+  void check_consistency(Mesh& mesh, const std::vector< std::map<Uint, Real> >& reference_coordinates)
+  {
+    Dictionary& geometry = mesh.geometry_fields();
+    const Field& x = *geometry.get_child("x")->handle<Field>();
+    for(Uint i = 0; i != geometry.size(); ++i)
+      BOOST_CHECK_EQUAL(x[i][0], geometry.coordinates()[i][0]);
+
+    const Field& elem_idx = *mesh.get_child("elems_P0")->get_child("elem_idx")->handle<Field>();
+    Uint entities_idx = 0;
+    boost_foreach(const Handle<Entities>& entities, mesh.elements())
+    {
+      const Space& space = elem_idx.space(*entities);
+      for(Uint e = 0; e != entities->size(); ++e)
+        BOOST_CHECK_EQUAL(elem_idx[space.connectivity()[e][0]][0], static_cast<Real>(entities->glb_idx()[e]));
+
+      const std::map<Uint, Real> renumbered_coordinates = element_coordinates(*entities);
+      const std::map<Uint, Real>& reference = reference_coordinates[entities_idx++];
+      BOOST_CHECK_EQUAL(renumbered_coordinates.size(), reference.size());
+      for(std::map<Uint, Real>::const_iterator it = reference.begin(); it != reference.end(); ++it)
+        BOOST_CHECK_CLOSE(renumbered_coordinates.find(it->first)->second, it->second, 1e-10);
+    }
+  }
+
+  std::vector< std::map<Uint, Real> > all_element_coordinates(const Mesh& mesh)
+  {
+    std::vector< std::map<Uint, Real> > result;
+    boost_foreach(const Handle<Entities>& entities, mesh.elements())
+      result.push_back(element_coordinates(*entities));
+    return result;
+  }
+
+  /// possibly common functions used on the tests below
+
+  int m_argc;
+  char** m_argv;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( TestRenumber_TestSuite, TestRenumber_Fixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  Core::instance().initiate(m_argc,m_argv);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( test_renumber_rcm )
+{
+  Mesh& mesh = shuffled_mesh("rect_rcm");
+  const std::vector< std::map<Uint, Real> > reference_coordinates = all_element_coordinates(mesh);
+  const Uint shuffled_bandwidth = Renumber::bandwidth(mesh.geometry_fields());
+
+  boost::shared_ptr<MeshTransformer> renumber = boost::dynamic_pointer_cast<MeshTransformer>(build_component("cf3.mesh.actions.Renumber","renumber"));
+  renumber->transform(mesh);
+
+  const Uint renumbered_bandwidth = Renumber::bandwidth(mesh.geometry_fields());
+  CFinfo << "RCM bandwidth: " << shuffled_bandwidth << " -> " << renumbered_bandwidth << CFendl;
+  BOOST_CHECK_LT(renumbered_bandwidth, shuffled_bandwidth / 4);
+
+  check_consistency(mesh, reference_coordinates);
+
+  // Elements are sorted by their lowest node
+  boost_foreach(const Handle<Entities>& entities, mesh.elements())
+  {
+    const Connectivity& connectivity = entities->geometry_space().connectivity();
+    for(Uint e = 1; e < connectivity.size(); ++e)
+    {
+      BOOST_CHECK_LE(*std::min_element(connectivity[e-1].begin(), connectivity[e-1].end()),
+                     *std::min_element(connectivity[e].begin(), connectivity[e].end()));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( test_renumber_hilbert )
+{
+  Mesh& mesh = shuffled_mesh("rect_hilbert");
+  const std::vector< std::map<Uint, Real> > reference_coordinates = all_element_coordinates(mesh);
+  const Uint shuffled_bandwidth = Renumber::bandwidth(mesh.geometry_fields());
+
+  boost::shared_ptr<MeshTransformer> renumber = boost::dynamic_pointer_cast<MeshTransformer>(build_component("cf3.mesh.actions.Renumber","renumber"));
+  renumber->options().set("node_order", std::string("Hilbert"));
+  renumber->options().set("element_order", std::string("Hilbert"));
+  renumber->transform(mesh);
+
+  CFinfo << "Hilbert bandwidth: " << shuffled_bandwidth << " -> " << Renumber::bandwidth(mesh.geometry_fields()) << CFendl;
+  BOOST_CHECK_LT(Renumber::bandwidth(mesh.geometry_fields()), shuffled_bandwidth);
+
+  check_consistency(mesh, reference_coordinates);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
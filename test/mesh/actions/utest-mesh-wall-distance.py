@@ -56,6 +56,7 @@ make_boundary_global.execute()
 wall_distance = root.create_component('WallDistance', 'cf3.mesh.actions.WallDistance')
 wall_distance.mesh = mesh
 wall_distance.regions = [mesh.topology.step]
+wall_distance.nb_threads = 2
 wall_distance.execute()
 
 domain.write_mesh(cf.URI('wall-distance-2dstep.pvtu'))
@@ -22,6 +22,7 @@
 #include "common/Table.hpp"
 #include "common/List.hpp"
 #include "common/Table.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/DynTable.hpp"
 #include "mesh/ElementType.hpp"
 #include "mesh/Dictionary.hpp"
@@ -700,6 +701,70 @@ BOOST_AUTO_TEST_CASE ( DynTable_test_hard )
 
 }
 
+BOOST_AUTO_TEST_CASE ( CompressedTable_test )
+{
+  CompressedTable<Uint>& table = *root.create_component< CompressedTable<Uint> >("compressed_table");
+  CompressedTable<Uint>::Buffer buffer = table.create_buffer();
+
+  std::vector<Uint> row;
+
+  row.assign(3, 0);
+  BOOST_CHECK_EQUAL(buffer.add_row(row), (Uint) 0);
+
+  row.assign(0, 1);
+  BOOST_CHECK_EQUAL(buffer.add_row(row), (Uint) 1);
+
+  row.assign(6, 2);
+  BOOST_CHECK_EQUAL(buffer.add_row(row), (Uint) 2);
+
+  BOOST_CHECK_EQUAL(table.size(), (Uint) 0);
+
+  buffer.flush();
+
+  BOOST_CHECK_EQUAL(table.size(), (Uint) 3);
+  BOOST_CHECK_EQUAL(table.nb_values(), (Uint) 9);
+
+  BOOST_CHECK_EQUAL(table[0][2], (Uint) 0);
+  BOOST_CHECK_EQUAL(table[0].size(), (Uint) 3);
+  BOOST_CHECK_EQUAL(table.row_size(1), (Uint) 0);
+  BOOST_CHECK_EQUAL(table[2][5], (Uint) 2);
+  BOOST_CHECK_EQUAL(table.row_size(2), (Uint) 6);
+
+  // grow and shrink a row in the middle of the table
+  row.assign(2, 3);
+  table.set_row(1, row);
+  BOOST_CHECK_EQUAL(table.row_size(1), (Uint) 2);
+  BOOST_CHECK_EQUAL(table[1][1], (Uint) 3);
+  BOOST_CHECK_EQUAL(table[2][0], (Uint) 2);
+
+  table.set_row_size(0, 1);
+  BOOST_CHECK_EQUAL(table.nb_values(), (Uint) 9);
+  BOOST_CHECK_EQUAL(table[1][0], (Uint) 3);
+  BOOST_CHECK_EQUAL(table[2][0], (Uint) 2);
+
+  // appending after existing rows
+  row.assign(1, 4);
+  BOOST_CHECK_EQUAL(buffer.add_row(row), (Uint) 3);
+  buffer.flush();
+  BOOST_CHECK_EQUAL(table.size(), (Uint) 4);
+  BOOST_CHECK_EQUAL(table[3][0], (Uint) 4);
+
+  table.resize(2);
+  BOOST_CHECK_EQUAL(table.size(), (Uint) 2);
+  BOOST_CHECK_EQUAL(table.nb_values(), (Uint) 3);
+
+  // two-pass fill from the row sizes
+  std::vector<Uint> sizes(3);
+  sizes[0] = 2; sizes[1] = 0; sizes[2] = 1;
+  table.set_row_sizes(sizes);
+  BOOST_CHECK_EQUAL(table.size(), (Uint) 3);
+  BOOST_CHECK_EQUAL(table.row_size(0), (Uint) 2);
+  BOOST_CHECK_EQUAL(table.row_size(1), (Uint) 0);
+  BOOST_CHECK_EQUAL(table.row_size(2), (Uint) 1);
+  table[2][0] = 7;
+  BOOST_CHECK_EQUAL(table.values().back(), (Uint) 7);
+}
+
 
 BOOST_AUTO_TEST_CASE ( Mesh_test )
 {
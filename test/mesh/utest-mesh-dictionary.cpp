@@ -309,6 +309,55 @@ BOOST_AUTO_TEST_CASE( FieldVariables )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( FieldColumnMajor )
+{
+  Handle<Dictionary> elems_P0(m_mesh->get_child("elems_P0"));
+  Field& field = elems_P0->create_field("column_major",3);
+  BOOST_CHECK(!field.is_column_major());
+  for (Uint i=0; i<field.size(); ++i)
+    for (Uint j=0; j<3; ++j)
+      field[i][j] = 10.*i + j;
+
+  field.set_column_major(true);
+  BOOST_CHECK(field.is_column_major());
+
+  // Each column is contiguous, and the values are kept
+  BOOST_CHECK_EQUAL( &field[1][2] - &field[0][2], 1 );
+  for (Uint i=0; i<field.size(); ++i)
+    for (Uint j=0; j<3; ++j)
+      BOOST_CHECK_EQUAL( field[i][j], 10.*i + j );
+
+  // The Eigen maps follow the storage order
+  BOOST_CHECK_EQUAL( field.row(1)[2], 12. );
+  BOOST_CHECK_EQUAL( field.vector(2)[1], 21. );
+  BOOST_CHECK_EQUAL( field.ref()(3,2), 32. );
+  BOOST_CHECK_EQUAL( field.col(1)(3,0), 31. );
+
+  field += 1.;
+  BOOST_CHECK_EQUAL( field[3][1], 32. );
+
+  // Mixing storage orders
+  Field& row_major = elems_P0->create_field("row_major",3);
+  row_major = field;
+  row_major += field;
+  BOOST_CHECK_EQUAL( row_major[3][1], 64. );
+  field -= row_major;
+  BOOST_CHECK_EQUAL( field[3][1], -32. );
+
+  // Resizing keeps the storage order
+  const Uint nb_rows = field.size();
+  field.resize(nb_rows+1);
+  BOOST_CHECK(field.is_column_major());
+  BOOST_CHECK_EQUAL( field[3][1], -32. );
+  field.resize(nb_rows);
+
+  field.set_column_major(false);
+  BOOST_CHECK_EQUAL( &field[0][1] - &field[0][0], 1 );
+  BOOST_CHECK_EQUAL( field[3][1], -32. );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,8 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Test module for cf3::mesh::gmsh::Reader"
 
+#include <fstream>
+
 #include <boost/test/unit_test.hpp>
 
 #include "common/Log.hpp"
@@ -26,7 +28,7 @@
 #include "mesh/Field.hpp"
 #include "mesh/Entities.hpp"
 #include "mesh/Space.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/List.hpp"
 #include "common/Table.hpp"
 #include "mesh/Dictionary.hpp"
@@ -311,6 +313,90 @@ BOOST_AUTO_TEST_CASE( read_2d_mesh_mix_p1_out )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( read_2d_mesh_binary )
+{
+  // Unit square with 2 triangles and 4 boundary lines, in the binary MSH 2.2 format
+  {
+    std::ofstream file("square-binary.msh", std::ios_base::out | std::ios_base::binary);
+    const int one = 1;
+    file << "$MeshFormat\n2.2 1 8\n";
+    file.write(reinterpret_cast<const char*>(&one), sizeof(int));
+    file << "\n$EndMeshFormat\n";
+    file << "$PhysicalNames\n2\n1 1 \"boundary\"\n2 2 \"domain\"\n$EndPhysicalNames\n";
+
+    file << "$Nodes\n4\n";
+    const double xy[4][2] = { {0.,0.}, {1.,0.}, {1.,1.}, {0.,1.} };
+    for (int n=0; n<4; ++n)
+    {
+      const int node_number = n+1;
+      const double coords[3] = { xy[n][0], xy[n][1], 0. };
+      file.write(reinterpret_cast<const char*>(&node_number), sizeof(int));
+      file.write(reinterpret_cast<const char*>(coords), 3*sizeof(double));
+    }
+    file << "\n$EndNodes\n";
+
+    file << "$Elements\n6\n";
+    // block header: element type, number of elements, number of tags
+    const int lines_header[3] = { 1, 4, 2 };
+    file.write(reinterpret_cast<const char*>(lines_header), 3*sizeof(int));
+    for (int e=0; e<4; ++e)
+    {
+      const int line[5] = { e+1, 1, 1, e+1, (e+1)%4+1 };
+      file.write(reinterpret_cast<const char*>(line), 5*sizeof(int));
+    }
+    const int triags_header[3] = { 2, 2, 2 };
+    file.write(reinterpret_cast<const char*>(triags_header), 3*sizeof(int));
+    const int triags[2][6] = { {5, 2, 1, 1, 2, 3}, {6, 2, 1, 1, 3, 4} };
+    file.write(reinterpret_cast<const char*>(triags), 12*sizeof(int));
+    file << "\n$EndElements\n";
+  }
+
+  boost::shared_ptr< MeshReader > meshreader = build_component_abstract_type<MeshReader>("cf3.mesh.gmsh.Reader","meshreader");
+  Mesh& mesh = *Core::instance().root().create_component<Mesh>("mesh_2d_binary");
+  meshreader->read_mesh_into("square-binary.msh",mesh);
+
+  BOOST_CHECK_EQUAL( mesh.dimension() , 2u );
+  BOOST_CHECK_EQUAL( find_component<Region>(mesh).recursive_elements_count(true) , 6u );
+  BOOST_CHECK_EQUAL( mesh.geometry_fields().size() , 4u );
+  BOOST_CHECK_EQUAL( mesh.geometry_fields().coordinates()[2][0] , 1. );
+  BOOST_CHECK_EQUAL( mesh.geometry_fields().coordinates()[2][1] , 1. );
+  BOOST_CHECK_EQUAL( mesh.geometry_fields().glb_idx()[3] , 3u );
+  BOOST_CHECK( is_not_null(mesh.access_component("topology/domain/elements_cf3.mesh.LagrangeP1.Triag2D")) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( read_2d_mesh_negative_tags )
+{
+  // Unit square written by a partitioned gmsh run: the partition tags of ghost elements are negative
+  {
+    std::ofstream file("square-partitioned.msh");
+    file << "$MeshFormat\n2.2 0 8\n$EndMeshFormat\n";
+    file << "$PhysicalNames\n2\n1 1 \"boundary\"\n2 2 \"domain\"\n$EndPhysicalNames\n";
+    file << "$Nodes\n4\n1 0 0 0\n2 1 0 0\n3 1 1 0\n4 0 1 0\n$EndNodes\n";
+    file << "$Elements\n6\n"
+         << "1 1 4 1 1 1 1 1 2\n"
+         << "2 1 4 1 2 1 1 2 3\n"
+         << "3 1 4 1 3 1 2 3 4\n"
+         << "4 1 4 1 4 1 2 4 1\n"
+         << "5 2 5 2 6 2 1 -2 1 2 3\n"
+         << "6 2 5 2 6 2 2 -1 1 3 4\n"
+         << "$EndElements\n";
+  }
+
+  boost::shared_ptr< MeshReader > meshreader = build_component_abstract_type<MeshReader>("cf3.mesh.gmsh.Reader","meshreader");
+  Mesh& mesh = *Core::instance().root().create_component<Mesh>("mesh_2d_negative_tags");
+  meshreader->read_mesh_into("square-partitioned.msh",mesh);
+
+  BOOST_CHECK_EQUAL( mesh.dimension() , 2u );
+  BOOST_CHECK_EQUAL( find_component<Region>(mesh).recursive_elements_count(true) , 6u );
+  BOOST_CHECK_EQUAL( mesh.geometry_fields().size() , 4u );
+  BOOST_CHECK( is_not_null(mesh.access_component("topology/domain/elements_cf3.mesh.LagrangeP1.Triag2D")) );
+  BOOST_CHECK( is_not_null(mesh.access_component("topology/boundary/elements_cf3.mesh.LagrangeP1.Line2D")) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( finalize_mpi )
 {
   Core::instance().terminate();
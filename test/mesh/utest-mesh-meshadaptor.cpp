@@ -26,7 +26,7 @@
 #include "mesh/MeshTransformer.hpp"
 #include "mesh/MeshAdaptor.hpp"
 
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/List.hpp"
 #include "common/Table.hpp"
 #include "mesh/Dictionary.hpp"
@@ -22,7 +22,7 @@
 #include "mesh/MeshWriter.hpp"
 #include "mesh/MeshTransformer.hpp"
 
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/List.hpp"
 #include "common/Table.hpp"
 #include "mesh/Dictionary.hpp"
@@ -147,6 +147,43 @@ BOOST_AUTO_TEST_CASE( Octtree_creation )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( Octtree_batch )
+{
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().get_child("mesh"));
+  Octtree& octtree = *mesh.create_component<Octtree>("batch_octtree");
+  octtree.options().set("mesh", mesh.handle<Mesh>());
+  octtree.options().set("max_elems_per_leaf", 2u);
+  octtree.options().set("nb_threads", 2u);
+
+  // The centroids of all 5x5 cells, and one point outside the mesh
+  boost::multi_array<Real,2> points(boost::extents[26][2]);
+  for (Uint j=0; j<5; ++j)
+  {
+    for (Uint i=0; i<5; ++i)
+    {
+      points[5*j+i][XX] = 1. + 2.*i;
+      points[5*j+i][YY] = 1. + 2.*j;
+    }
+  }
+  points[25][XX] = 20.;
+  points[25][YY] = 20.;
+
+  std::vector<Entity> elements;
+  boost::multi_array<Real,2> mapped_coords;
+  BOOST_CHECK_EQUAL(octtree.find_elements(points, elements, mapped_coords), 25u);
+  BOOST_CHECK_EQUAL(elements.size(), 26u);
+
+  for (Uint i=0; i<25; ++i)
+  {
+    BOOST_CHECK_EQUAL(elements[i].idx, i);
+    BOOST_CHECK_SMALL(mapped_coords[i][XX], 1e-12);
+    BOOST_CHECK_SMALL(mapped_coords[i][YY], 1e-12);
+  }
+  BOOST_CHECK(is_null(elements[25].comp));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( Octtree_parallel )
 {
   Handle< MeshGenerator > mesh_generator(Core::instance().root().get_child("mesh_generator"));
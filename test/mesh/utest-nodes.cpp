@@ -13,7 +13,7 @@
 #include "common/Log.hpp"
 #include "common/Core.hpp"
 #include "common/FindComponents.hpp"
-#include "common/DynTable.hpp"
+#include "common/CompressedTable.hpp"
 #include "common/List.hpp"
 
 #include "math/VariablesDescriptor.hpp"
@@ -37,3 +37,62 @@ cf_check_equal(table[0][0],2,'Table increment failed')
 
 print 'Full table:'
 print table
+
+# Zero-copy NumPy views, only tested if NumPy is available
+try:
+  import numpy
+except ImportError:
+  numpy = None
+  print 'NumPy not found, skipping array_view tests'
+
+if numpy is not None:
+  view = table.array_view()
+  cf_check_equal(view.shape, (10, 2), 'Incorrect array view shape')
+  cf_check_equal(view.dtype, numpy.dtype(numpy.uint32), 'Incorrect array view dtype')
+  cf_check(view[1][0] == 1 and view[1][1] == 2, 'Array view does not see the table values')
+  view[2] = [5, 6]
+  cf_check(table[2][0] == 5 and table[2][1] == 6, 'Table does not see values written through the array view')
+
+  real_table = root.create_component("real_table", "cf3.common.Table<real>")
+  real_table.set_row_size(3)
+  real_table.resize(4)
+  real_view = real_table.array_view()
+  cf_check_equal(real_view.dtype.kind, 'f', 'Incorrect array view dtype for a real table')
+  real_view[:, 1] = numpy.arange(4) * 0.5
+  cf_check_equal(real_table[3][1], 1.5, 'Column write through the array view failed')
+
+  list_component = root.create_component("list", "cf3.common.List<unsigned>")
+  list_component.resize(5)
+  list_view = list_component.array_view()
+  cf_check_equal(list_view.shape, (5,), 'Incorrect list view shape')
+  list_view[:] = numpy.arange(5)
+  cf_check_equal(list_component[4], 4, 'List write through the array view failed')
+
+  # Fields are tables, so their view shares the field storage
+  field = root.create_component("field", "cf3.mesh.Field")
+  field.set_row_size(2)
+  field.resize(3)
+  field_view = field.array_view()
+  cf_check_equal(field_view.shape, (3, 2), 'Incorrect field view shape')
+  field_view[1] = [0.25, 0.75]
+  cf_check(field[1][0] == 0.25 and field[1][1] == 0.75, 'Field does not see values written through the array view')
+  field[2][1] = 3.5
+  cf_check_equal(field_view[2][1], 3.5, 'Array view does not see values written to the field')
+
+  # Column-major tables give a view with Fortran strides
+  column_table = root.create_component("column_table", "cf3.common.Table<real>")
+  column_table.set_row_size(3)
+  column_table.resize(4)
+  column_table[2] = [1., 2., 3.]
+  column_table.set_column_major(True)
+  cf_check(column_table.is_column_major(), 'Table is not column-major after set_column_major(True)')
+  column_view = column_table.array_view()
+  item_size = column_view.dtype.itemsize
+  cf_check_equal(column_view.shape, (4, 3), 'Incorrect column-major view shape')
+  cf_check_equal(column_view.strides, (item_size, 4*item_size), 'Incorrect column-major view strides')
+  cf_check(column_view.flags['F_CONTIGUOUS'], 'Column-major view is not Fortran contiguous')
+  cf_check(column_view[2][0] == 1. and column_view[2][1] == 2. and column_view[2][2] == 3., 'Column-major view does not see the values kept by set_column_major')
+  column_view[:, 1] = numpy.arange(4) + 10.
+  cf_check_equal(column_table[3][1], 13., 'Column write through the column-major view failed')
+  column_table[0][2] = 7.
+  cf_check_equal(column_view[0][2], 7., 'Column-major view does not see values written to the table')
@@ -24,7 +24,10 @@
 #include "mesh/MeshWriter.hpp"
 #include "mesh/ElementData.hpp"
 #include "mesh/FieldManager.hpp"
+#include "mesh/Connectivity.hpp"
 #include "mesh/Dictionary.hpp"
+#include "mesh/ElementColouring.hpp"
+#include "mesh/Field.hpp"
 
 #include "mesh/Integrators/Gauss.hpp"
 #include "mesh/ElementTypes.hpp"
@@ -39,10 +42,12 @@
 #include "solver/Solver.hpp"
 #include "solver/Tags.hpp"
 
+#include "solver/actions/NodeValence.hpp"
 #include "solver/actions/Proto/ProtoAction.hpp"
 #include "solver/actions/Proto/ElementLooper.hpp"
 #include "solver/actions/Proto/Expression.hpp"
 #include "solver/actions/Proto/Functions.hpp"
+#include "solver/actions/Proto/GeometryCache.hpp"
 #include "solver/actions/Proto/NodeLooper.hpp"
 #include "solver/actions/Proto/Terminals.hpp"
 
@@ -236,6 +241,139 @@ BOOST_AUTO_TEST_CASE( ProtoVectorElementField )
   writer.execute();
 }
 
+// Check the element colouring and compare a multi-threaded element loop with the serial one
+BOOST_AUTO_TEST_CASE( ProtoThreadedElementLoop )
+{
+  Domain& dom = *Core::instance().root().create_component<Domain>("ThreadedDomain");
+  Mesh& mesh = *dom.create_component<Mesh>("mesh");
+
+  BlockMesh::BlockArrays& blocks = *dom.create_component<BlockMesh::BlockArrays>("blocks");
+
+  *blocks.create_points(2, 4) << 0. << 0. << 1. << 0. << 1. << 1. << 0. << 1.;
+  *blocks.create_blocks(1) << 0 << 1 << 2 << 3;
+  *blocks.create_block_subdivisions() << 16 << 16;
+  *blocks.create_block_gradings() << 1. << 1. << 1. << 1.;
+
+  *blocks.create_patch("bottom", 1) << 0 << 1;
+  *blocks.create_patch("right", 1) << 1 << 2;
+  *blocks.create_patch("top", 1) << 2 << 3;
+  *blocks.create_patch("left", 1) << 3 << 0;
+
+  blocks.create_mesh(mesh);
+
+  // No two elements of the same colour may share a node
+  BOOST_FOREACH(Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    const ElementColouring& colouring = element_colouring(elements);
+    BOOST_CHECK(&colouring == &element_colouring(elements));
+
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+    Uint nb_coloured = 0;
+    for(Uint colour = 0; colour != colouring.nb_colours(); ++colour)
+    {
+      std::vector<bool> node_used(mesh.geometry_fields().size(), false);
+      for(Uint i = 0; i != colouring.colour_size(colour); ++i)
+      {
+        const Uint elem = colouring.element(colour, i);
+        BOOST_CHECK_EQUAL(colouring.colour(elem), colour);
+        BOOST_FOREACH(const Uint node, connectivity[elem])
+        {
+          BOOST_CHECK(!node_used[node]);
+          node_used[node] = true;
+        }
+        ++nb_coloured;
+      }
+    }
+    BOOST_CHECK_EQUAL(nb_coloured, elements.size());
+  }
+
+  Field& valence_field = mesh.geometry_fields().create_field("node_valence", "Valence[scalar]");
+  valence_field.add_tag("node_valence");
+
+  Handle<NodeValence> valence = dom.create_component<NodeValence>("Valences");
+  valence->options().set(solver::Tags::regions(), std::vector<URI>(1, mesh.topology().uri()));
+  valence->execute();
+
+  const Field::ArrayT serial_result = valence_field.array();
+
+  valence->options().set("nb_threads", 3u);
+  valence->execute();
+
+  const Uint nb_nodes = valence_field.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    BOOST_CHECK_EQUAL(valence_field[i][0], serial_result[i][0]);
+  }
+}
+
+// Compare element integrals computed with and without the geometry cache
+BOOST_AUTO_TEST_CASE( ProtoGeometryCache )
+{
+  Domain& dom = *Core::instance().root().create_component<Domain>("CacheDomain");
+  Mesh& mesh = *dom.create_component<Mesh>("mesh");
+
+  // Skewed block, so the Jacobian differs between the quadrature points
+  BlockMesh::BlockArrays& blocks = *dom.create_component<BlockMesh::BlockArrays>("blocks");
+
+  *blocks.create_points(2, 4) << 0. << 0. << 2. << 0. << 2.5 << 1.5 << 0.3 << 1.;
+  *blocks.create_blocks(1) << 0 << 1 << 2 << 3;
+  *blocks.create_block_subdivisions() << 8 << 8;
+  *blocks.create_block_gradings() << 1. << 1. << 1. << 1.;
+
+  *blocks.create_patch("bottom", 1) << 0 << 1;
+  *blocks.create_patch("right", 1) << 1 << 2;
+  *blocks.create_patch("top", 1) << 2 << 3;
+  *blocks.create_patch("left", 1) << 3 << 0;
+
+  blocks.create_mesh(mesh);
+
+  Field& field = mesh.geometry_fields().create_field("cache_test", "T[scalar]");
+  field.add_tag("cache_test");
+  FieldVariable<0, ScalarField> T("T", "cache_test");
+  for_each_node(mesh.topology(), T = coordinates[0]*coordinates[0] + coordinates[1]);
+
+  // Integral of the norm of the gradient
+  Real result = 0.;
+  boost::shared_ptr<ProtoAction> action = create_proto_action("GradientNorm", elements_expression
+  (
+    boost::mpl::vector1<LagrangeP1::Quad2D>(),
+    element_quadrature(boost::proto::lit(result) += _norm(nabla(T)*nodal_values(T)))
+  ));
+  action->options().set(solver::Tags::regions(), std::vector<URI>(1, mesh.topology().uri()));
+  action->execute();
+  const Real reference = result;
+  BOOST_CHECK(reference > 0.);
+
+  action->options().set("cache_geometry", true);
+  result = 0.;
+  action->execute();
+  BOOST_CHECK_CLOSE(result, reference, 1e-10);
+
+  Elements& elements = find_component_recursively_with_filter<Elements>(mesh.topology(), IsElementsVolume());
+  Handle<GeometryCache const> cache = find_geometry_cache(elements);
+  BOOST_REQUIRE(is_not_null(cache));
+  BOOST_CHECK(cache->memory_size() > 0);
+
+  // Run again, using the values stored in the cache
+  result = 0.;
+  action->execute();
+  BOOST_CHECK_CLOSE(result, reference, 1e-10);
+
+  // Scaling the mesh halves the gradient and quadruples the area. The mesh_changed event clears the cache.
+  Field& coordinates_field = mesh.geometry_fields().coordinates();
+  const Uint nb_nodes = coordinates_field.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    coordinates_field[i][0] *= 2.;
+    coordinates_field[i][1] *= 2.;
+  }
+  mesh.raise_mesh_changed();
+
+  result = 0.;
+  action->execute();
+  BOOST_CHECK_CLOSE(result, 2.*reference, 1e-10);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_SUITE_END()
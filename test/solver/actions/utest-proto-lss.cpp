@@ -488,10 +488,116 @@ BOOST_AUTO_TEST_CASE( NestedCustomOps )
   BOOST_CHECK_SMALL(diff_norm.front(), 1e-10);
 }
 
+// Assemble the same system with one and with four threads, and with the assembly plan in use for the threaded matrix
+BOOST_AUTO_TEST_CASE( ThreadedAssembly )
+{
+  const std::string names[] = {"serial_lss", "threaded_lss"};
+  Handle<math::LSS::System> lss[2];
+  Handle<ProtoAction> actions[2];
+
+  FieldVariable<0, ScalarField> T("ScalarVar3", "scalar3");
+  field_manager->create_field("scalar3", mesh->geometry_fields());
+
+  Handle<math::LSS::Vector> vec_copy;
+  SFOp< CustomSFOp<ScalarLSSVector> > scalar_vector;
+
+  for(Uint i = 0; i != 2; ++i)
+  {
+    lss[i] = root.create_component<math::LSS::System>(names[i]);
+    lss[i]->options().set("matrix_builder", std::string("cf3.math.LSS.TrilinosCrsMatrix"));
+    lss[i]->create(mesh->geometry_fields().comm_pattern(), 1, node_connectivity, starting_indices);
+
+    if(i == 0)
+    {
+      Handle<math::LSS::ThyraVector> solution(lss[0]->solution());
+      Thyra::randomize(0., 1., solution->thyra_vector().ptr());
+      vec_copy = Handle<math::LSS::Vector>(root.create_component("ScalarVector3", "cf3.math.LSS.TrilinosVector"));
+      lss[0]->solution()->clone_to(*vec_copy);
+      scalar_vector.op.set_vector(vec_copy);
+    }
+
+    SystemMatrix matrix(*lss[i]);
+    SystemRHS sys_rhs(*lss[i]);
+
+    actions[i] = root.create_component<ProtoAction>(names[i] + "_action");
+    actions[i]->set_expression(elements_expression(
+      group
+      (
+        _A = _0,
+        element_quadrature
+        (
+          _A(T,T) += transpose(nabla(T)) * nabla(T) + transpose(N(T)) * N(T)
+        ),
+        matrix += _A,
+        sys_rhs += _A * scalar_vector
+      )
+    ));
+    actions[i]->options().set("physical_model", physical_model);
+    actions[i]->options().set(solver::Tags::regions(), loop_regions);
+  }
+
+  actions[1]->options().set("nb_threads", 4u);
+  lss[1]->matrix()->options().set("assembly_plan", true);
+
+  actions[0]->execute();
+
+  // Run twice, so the second assembly replays the plan recorded by the first
+  for(Uint run = 0; run != 2; ++run)
+  {
+    lss[1]->reset();
+    actions[1]->execute();
+
+    std::vector<Uint> rows[2], cols[2];
+    std::vector<Real> vals[2];
+    for(Uint i = 0; i != 2; ++i)
+      lss[i]->matrix()->debug_data(rows[i], cols[i], vals[i]);
+    BOOST_REQUIRE_EQUAL(vals[0].size(), vals[1].size());
+    BOOST_CHECK(rows[0] == rows[1]);
+    BOOST_CHECK(cols[0] == cols[1]);
+    for(Uint j = 0; j != vals[0].size(); ++j)
+      BOOST_CHECK_SMALL(vals[0][j] - vals[1][j], 1e-12);
+
+    std::vector<Real> rhs[2];
+    for(Uint i = 0; i != 2; ++i)
+      lss[i]->rhs()->debug_data(rhs[i]);
+    BOOST_REQUIRE_EQUAL(rhs[0].size(), rhs[1].size());
+    for(Uint j = 0; j != rhs[0].size(); ++j)
+      BOOST_CHECK_SMALL(rhs[0][j] - rhs[1][j], 1e-12);
+  }
+
+  // TrilinosFEVbrMatrix shares its index buffer between calls, so it refuses to be assembled from other threads
+  Handle<math::LSS::System> vbr_lss = root.create_component<math::LSS::System>("vbr_lss");
+  vbr_lss->options().set("matrix_builder", std::string("cf3.math.LSS.TrilinosFEVbrMatrix"));
+  vbr_lss->create(mesh->geometry_fields().comm_pattern(), 1, node_connectivity, starting_indices);
+  SystemMatrix vbr_matrix(*vbr_lss);
+  Handle<ProtoAction> vbr_action = root.create_component<ProtoAction>("vbr_action");
+  vbr_action->set_expression(elements_expression(
+    group
+    (
+      _A = _0,
+      element_quadrature
+      (
+        _A(T,T) += transpose(nabla(T)) * nabla(T)
+      ),
+      vbr_matrix += _A
+    )
+  ));
+  vbr_action->options().set("physical_model", physical_model);
+  vbr_action->options().set(solver::Tags::regions(), loop_regions);
+  vbr_action->options().set("nb_threads", 4u);
+  BOOST_CHECK_THROW(vbr_action->execute(), common::ParallelError);
+
+  vbr_action->options().set("nb_threads", 1u);
+  BOOST_CHECK_NO_THROW(vbr_action->execute());
+}
+
 BOOST_AUTO_TEST_CASE( CleanUp )
 {
   root.remove_component("scalar_lss");
   root.remove_component("vector_lss");
+  root.remove_component("serial_lss");
+  root.remove_component("threaded_lss");
+  root.remove_component("vbr_lss");
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,121 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the reduction shared by the stop criteria of cf3::solver::actions::Iterate"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/OptionList.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/ReductionBatch.hpp"
+
+#include "solver/Criterion.hpp"
+#include "solver/actions/Iterate.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::solver;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Criterion that counts the ranks through the batch and stops after a given number of checks
+class CountingCriterion : public Criterion
+{
+public:
+  CountingCriterion(const std::string& name) :
+    Criterion(name),
+    nb_checks(0),
+    nb_contributions(0),
+    nb_collections(0),
+    stop_after(3),
+    batch(nullptr),
+    nb_ranks(0.),
+    max_rank(-1.)
+  {
+  }
+
+  static std::string type_name() { return "CountingCriterion"; }
+
+  virtual void contribute(PE::ReductionBatch& a_batch)
+  {
+    ++nb_contributions;
+    batch = &a_batch;
+    nb_ranks_idx = a_batch.add_sum(1.);
+    max_rank_idx = a_batch.add_max(static_cast<Real>(PE::Comm::instance().rank()));
+  }
+
+  virtual void collect(const PE::ReductionBatch& a_batch)
+  {
+    ++nb_collections;
+    BOOST_CHECK_EQUAL(&a_batch, batch);
+    nb_ranks = a_batch.result(nb_ranks_idx);
+    max_rank = a_batch.result(max_rank_idx);
+  }
+
+  virtual bool operator()()
+  {
+    return ++nb_checks > stop_after;
+  }
+
+  Uint nb_checks;
+  Uint nb_contributions;
+  Uint nb_collections;
+  Uint stop_after;
+  const PE::ReductionBatch* batch;
+  Uint nb_ranks_idx;
+  Uint max_rank_idx;
+  Real nb_ranks;
+  Real max_rank;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( IterateReductionSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  BOOST_CHECK(PE::Comm::instance().is_active());
+}
+
+BOOST_AUTO_TEST_CASE( SharedBatch )
+{
+  const Real nb_procs = PE::Comm::instance().size();
+
+  actions::Iterate& iterate = *Core::instance().root().create_component<actions::Iterate>("Iterate");
+  CountingCriterion& first = *iterate.create_component<CountingCriterion>("First");
+  CountingCriterion& second = *iterate.create_component<CountingCriterion>("Second");
+  second.stop_after = 10;
+
+  iterate.execute();
+
+  // The first criterion stops the loop after three iterations, but both are reduced before every check
+  BOOST_CHECK_EQUAL(iterate.iter(), 3u);
+  BOOST_CHECK_EQUAL(first.nb_contributions, 4u);
+  BOOST_CHECK_EQUAL(second.nb_contributions, 4u);
+  BOOST_CHECK_EQUAL(first.nb_collections, 4u);
+  BOOST_CHECK_EQUAL(second.nb_collections, 4u);
+
+  // Both criteria used the batch of the loop, so their values were reduced in the same collective
+  BOOST_CHECK(first.batch != nullptr);
+  BOOST_CHECK_EQUAL(first.batch, second.batch);
+  BOOST_CHECK_EQUAL(first.nb_ranks, nb_procs);
+  BOOST_CHECK_EQUAL(second.nb_ranks, nb_procs);
+  BOOST_CHECK_EQUAL(first.max_rank, nb_procs - 1.);
+
+  Core::instance().root().remove_component("Iterate");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
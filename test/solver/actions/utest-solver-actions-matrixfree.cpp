@@ -0,0 +1,180 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::solver::actions::SetupMatrixFreeOperator"
+
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
+#include "common/OptionList.hpp"
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+
+#include "math/MatrixTypes.hpp"
+#include "math/LSS/System.hpp"
+#include "math/LSS/MatrixFree/MatrixFreeMatrix.hpp"
+
+#include "mesh/BlockMesh/BlockData.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Domain.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/ShapeFunction.hpp"
+#include "mesh/Space.hpp"
+
+#include "solver/actions/SetupMatrixFreeOperator.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::math;
+using namespace cf3::mesh;
+using namespace cf3::solver::actions;
+
+/// Dense mass plus Laplacian matrix, assembled with 2x2x2 Gauss points. The physical gradients are computed by solving
+/// with the Jacobian, to check the (J J^T)^-1 factor of the matrix-free operator independently.
+RealMatrix assembled_matrix(const Mesh& mesh, const Real mass, const Real diffusion)
+{
+  const Uint nb_nodes = mesh.geometry_fields().size();
+  RealMatrix result(nb_nodes, nb_nodes);
+  result.setZero();
+
+  const Real gauss_point = 1. / std::sqrt(3.);
+  RealVector mapped_coords(3);
+  RealMatrix jacobian(3, 3);
+  RealMatrix element_coords;
+  boost_foreach(const Elements& elements, find_components_recursively_with_filter<Elements>(mesh.topology(), IsElementsVolume()))
+  {
+    const ElementType& etype = elements.element_type();
+    const ShapeFunction& sf = etype.shape_function();
+    const Uint nb_elem_nodes = sf.nb_nodes();
+    const Connectivity& connectivity = elements.geometry_space().connectivity();
+    elements.geometry_space().allocate_coordinates(element_coords);
+    RealRowVector values(nb_elem_nodes);
+    RealMatrix mapped_gradient(3, nb_elem_nodes);
+    for(Uint elem = 0; elem != elements.size(); ++elem)
+    {
+      elements.geometry_space().put_coordinates(element_coords, elem);
+      for(Uint q = 0; q != 8; ++q)
+      {
+        mapped_coords << (q & 1 ? gauss_point : -gauss_point), (q & 2 ? gauss_point : -gauss_point), (q & 4 ? gauss_point : -gauss_point);
+        etype.compute_jacobian(mapped_coords, element_coords, jacobian);
+        sf.compute_value(mapped_coords, values);
+        sf.compute_gradient(mapped_coords, mapped_gradient);
+        const RealMatrix gradient = jacobian.fullPivLu().solve(mapped_gradient);
+        const Real jxw = std::abs(jacobian.determinant());
+        for(Uint i = 0; i != nb_elem_nodes; ++i)
+          for(Uint j = 0; j != nb_elem_nodes; ++j)
+            result(connectivity[elem][i], connectivity[elem][j]) += jxw * (mass*values[i]*values[j] + diffusion*gradient.col(i).dot(gradient.col(j)));
+      }
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( SetupMatrixFreeOperatorSuite )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  BOOST_CHECK(PE::Comm::instance().is_active());
+}
+
+// Distorted Hexa3D mesh, with a Jacobian that is neither diagonal nor symmetric and varies within the elements
+BOOST_AUTO_TEST_CASE( DistortedHexa3D )
+{
+  const Real mass = 0.7;
+  const Real diffusion = 1.3;
+
+  Domain& domain = *Core::instance().root().create_component<Domain>("domain");
+  BlockMesh::BlockArrays& blocks = *domain.create_component<BlockMesh::BlockArrays>("blocks");
+  Tools::MeshGeneration::create_channel_3d(blocks, 1., 0.5, 0.8, 3, 1, 1, 1.5);
+  Mesh& mesh = *domain.create_component<Mesh>("mesh");
+  blocks.create_mesh(mesh);
+
+  Field& coordinates = mesh.geometry_fields().coordinates();
+  for(Uint i = 0; i != coordinates.size(); ++i)
+  {
+    const Real x = coordinates[i][XX];
+    const Real y = coordinates[i][YY];
+    const Real z = coordinates[i][ZZ];
+    coordinates[i][XX] = x + 0.2*y + 0.1*y*z;
+    coordinates[i][YY] = y + 0.1*z;
+    coordinates[i][ZZ] = z + 0.15*x;
+  }
+
+  const Uint nb_nodes = coordinates.size();
+  std::vector<Uint> node_connectivity;
+  std::vector<Uint> starting_indices(nb_nodes+1, 0u);
+  Handle<math::LSS::System> lss = domain.create_component<math::LSS::System>("LSS");
+  lss->options().set("matrix_builder", std::string("cf3.math.LSS.MatrixFreeMatrix"));
+  lss->options().set("solution_strategy", std::string("cf3.math.LSS.MatrixFreeStrategy"));
+  lss->create(mesh.geometry_fields().comm_pattern(), 1, node_connectivity, starting_indices);
+  lss->matrix()->options().set("mass_coefficient", mass);
+  lss->matrix()->options().set("diffusion_coefficient", diffusion);
+
+  Handle<SetupMatrixFreeOperator> setup = domain.create_component<SetupMatrixFreeOperator>("SetupMatrixFreeOperator");
+  setup->options().set("mesh", mesh.handle<Mesh>());
+  setup->options().set("regions", std::vector<URI>(1, mesh.topology().uri()));
+  setup->options().set("lss", lss);
+  setup->execute();
+
+  Handle<math::LSS::MatrixFreeMatrix> matrix(lss->matrix());
+  BOOST_REQUIRE(is_not_null(matrix));
+  BOOST_CHECK_EQUAL(matrix->nb_elements(), 6);
+
+  const RealMatrix a = assembled_matrix(mesh, mass, diffusion);
+
+  RealVector x(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    x[i] = std::sin(0.7*static_cast<Real>(i)) + 0.5;
+    lss->solution()->set_value(i, x[i]);
+  }
+  lss->matrix()->apply(lss->rhs(), lss->solution());
+
+  const RealVector y_ref = a*x;
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    Real y;
+    lss->rhs()->get_value(i, y);
+    BOOST_CHECK_CLOSE(y, y_ref[i], 1e-9);
+  }
+
+  std::vector<Real> diag;
+  lss->matrix()->get_diagonal(diag);
+  BOOST_REQUIRE_EQUAL(diag.size(), nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    BOOST_CHECK_CLOSE(diag[i], a(i,i), 1e-9);
+
+  Core::instance().root().remove_component("domain");
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  PE::Comm::instance().finalize();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////
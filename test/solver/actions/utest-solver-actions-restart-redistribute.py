@@ -0,0 +1,99 @@
+import sys
+import coolfluid as cf
+
+# Reads a restart file by matching global indices, so every rank also reads the rows of its ghost nodes
+# and elements from the blocks written by the ranks that own them.
+
+def copy_and_reset(source, domain):
+  nb_items = len(source)
+  destination = domain.create_component(source.name(), 'cf3.mesh.Field')
+  destination.set_row_size(1)
+  destination.resize(nb_items)
+
+  for i in range(nb_items):
+    destination[i][0] = source[i][0]
+    source[i][0] = 0
+
+  return destination
+
+def reset(field):
+  for i in range(len(field)):
+    field[i][0] = 0
+
+def check_equal(domain, left, right, message):
+  differ = domain.create_component('Differ', 'cf3.common.ArrayDiff')
+  differ.left = left
+  differ.right = right
+  differ.execute()
+  equal = differ.properties()['arrays_equal']
+  domain.remove_component('Differ')
+  if not equal:
+    raise Exception(message)
+
+env = cf.Core.environment()
+env.log_level = 4
+env.only_cpu0_writes = True
+
+root = cf.Core.root()
+domain = root.create_component('Domain', 'cf3.mesh.Domain')
+mesh = domain.create_component('OriginalMesh','cf3.mesh.Mesh')
+
+blocks = root.create_component('model', 'cf3.mesh.BlockMesh.BlockArrays')
+points = blocks.create_points(dimensions = 2, nb_points = 4)
+points[0]  = [0., 0.]
+points[1]  = [1., 0.]
+points[2]  = [1., 1.]
+points[3]  = [0., 1.]
+block_nodes = blocks.create_blocks(1)
+block_nodes[0] = [0, 1, 2, 3]
+block_subdivs = blocks.create_block_subdivisions()
+block_subdivs[0] = [16,16]
+gradings = blocks.create_block_gradings()
+gradings[0] = [1., 1., 1., 1.]
+blocks.create_patch_nb_faces(name = 'bottom', nb_faces = 1)[0] = [0, 1]
+blocks.create_patch_nb_faces(name = 'right', nb_faces = 1)[0] = [1, 2]
+blocks.create_patch_nb_faces(name = 'top', nb_faces = 1)[0] = [2, 3]
+blocks.create_patch_nb_faces(name = 'left', nb_faces = 1)[0] = [3, 0]
+blocks.partition_blocks(nb_partitions = cf.Core.nb_procs(), direction = 1)
+blocks.create_mesh(mesh.uri())
+
+make_par_data = root.create_component('MakeParData', 'cf3.solver.actions.ParallelDataToFields')
+make_par_data.mesh = mesh
+make_par_data.execute()
+
+time = domain.create_component('Time', 'cf3.solver.Time')
+time.current_time = 2.
+time.time_step = 0.2
+time.iteration = 10
+
+# Write a single uncompressed file with MPI-IO
+restart_file = cf.URI('restart-redistribute-test.cf3restart')
+writer = domain.create_component('Writer', 'cf3.solver.actions.WriteRestartFile')
+writer.fields = [mesh.geometry.node_gids, mesh.elems_P0.element_gids]
+writer.file = restart_file
+writer.time = time
+writer.shared_file = True
+writer.compress = False
+writer.execute()
+
+ref_node_gids = copy_and_reset(mesh.geometry.node_gids, domain)
+ref_element_gids = copy_and_reset(mesh.elems_P0.element_gids, domain)
+
+reader = domain.create_component('Reader', 'cf3.solver.actions.ReadRestartFile')
+reader.mesh = mesh
+reader.file = restart_file
+reader.time = time
+reader.redistribute = True
+reader.execute()
+
+check_equal(domain, ref_node_gids, mesh.geometry.node_gids, 'Node GIDS do not match after a redistributed read')
+check_equal(domain, ref_element_gids, mesh.elems_P0.element_gids, 'Element GIDS do not match after a redistributed read')
+
+# Same through memory-mapping
+reset(mesh.geometry.node_gids)
+reset(mesh.elems_P0.element_gids)
+reader.mmap = True
+reader.execute()
+
+check_equal(domain, ref_node_gids, mesh.geometry.node_gids, 'Node GIDS do not match after a memory-mapped redistributed read')
+check_equal(domain, ref_element_gids, mesh.elems_P0.element_gids, 'Element GIDS do not match after a memory-mapped redistributed read')
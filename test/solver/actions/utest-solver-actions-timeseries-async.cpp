@@ -0,0 +1,182 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for asynchronous writes with cf3::solver::actions::TimeSeriesWriter"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/BoostFilesystem.hpp"
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Group.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/StringConversion.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshWriter.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/SimpleMeshGenerator.hpp"
+
+#include "solver/Time.hpp"
+#include "solver/actions/AdvanceTime.hpp"
+#include "solver/actions/TimeSeriesWriter.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+
+struct CoreInit {
+
+  /// global initiate
+  CoreInit()
+  {
+    using namespace boost::unit_test::framework;
+    Core::instance().initiate( master_test_suite().argc, master_test_suite().argv);
+  }
+
+  /// global tear-down
+  ~CoreInit()
+  {
+    Core::instance().terminate();
+  }
+
+};
+
+/// Read the first value written for the given variable in a tecplot file
+Real first_tecplot_value(const std::string& file_name, const std::string& var_name)
+{
+  std::ifstream file(file_name.c_str());
+  BOOST_REQUIRE(file.is_open());
+  const std::string marker = "### variable " + var_name;
+  std::string line;
+  while(std::getline(file, line))
+  {
+    if(line == marker)
+    {
+      Real value;
+      file >> value;
+      return value;
+    }
+  }
+  BOOST_FAIL("Variable " + var_name + " not found in " + file_name);
+  return 0.;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_GLOBAL_FIXTURE( CoreInit )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( TimeSeriesAsyncSuite )
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Keep changing the component tree, the mesh metadata and the written field while background writes are in flight
+BOOST_AUTO_TEST_CASE( BusyTree )
+{
+  Component& root = Core::instance().root();
+  Handle<Group> domain = root.create_component<Group>("Domain");
+
+  Handle<SimpleMeshGenerator> mesh_generator = domain->create_component<SimpleMeshGenerator>("MeshGenerator");
+  mesh_generator->options().set("mesh", domain->uri()/"Mesh");
+  mesh_generator->options().set("lengths", std::vector<Real>(2, 1.));
+  mesh_generator->options().set("nb_cells", std::vector<Uint>(2, 40));
+  Mesh& mesh = mesh_generator->generate();
+
+  Field& u = mesh.geometry_fields().create_field("u", "u");
+
+  Handle<Time> time = domain->create_component<Time>("Time");
+  time->options().set("time_step", 0.1);
+
+  Handle<AdvanceTime> advance_time = domain->create_component<AdvanceTime>("AdvanceTime");
+  advance_time->options().set("time", time);
+  advance_time->options().set("mesh", mesh.handle<Mesh>());
+
+  Handle<TimeSeriesWriter> series_writer = domain->create_component<TimeSeriesWriter>("SeriesWriter");
+  series_writer->options().set("time", time);
+  series_writer->options().set("interval", 1u);
+  series_writer->options().set("asynchronous", true);
+  series_writer->options().set("max_pending_writes", 2u);
+
+  const std::vector<URI> fields(1, u.uri());
+
+  Handle<Component> tecplot_writer = series_writer->create_component("TecplotWriter", "cf3.mesh.tecplot.Writer");
+  const Handle<Mesh const> written_mesh(mesh.handle<Mesh>());
+  tecplot_writer->options().set("mesh", written_mesh);
+  tecplot_writer->options().set("fields", fields);
+  tecplot_writer->options().set("file", URI("timeseries-async-{iteration}.plt"));
+
+  Handle<Component> vtk_writer = series_writer->create_component("VTKWriter", "cf3.mesh.VTKXML.Writer");
+  vtk_writer->options().set("mesh", written_mesh);
+  vtk_writer->options().set("fields", fields);
+  vtk_writer->options().set("file", URI("timeseries-async-{iteration}.pvtu"));
+
+  const Uint nb_steps = 10;
+  for(Uint step = 0; step != nb_steps; ++step)
+  {
+    std::fill(u.array().data(), u.array().data() + u.array().num_elements(), static_cast<Real>(step));
+    series_writer->execute();
+
+    // Background writes use the snapshot and leave the writer configuration alone
+    BOOST_CHECK_EQUAL(tecplot_writer->options().value<URI>("file").path(), "timeseries-async-{iteration}.plt");
+
+    // The written values were staged, so the field may change right away
+    std::fill(u.array().data(), u.array().data() + u.array().num_elements(), -1.);
+
+    // Add and remove components, both in the mesh and elsewhere, while the writes run
+    for(Uint i = 0; i != 10; ++i)
+    {
+      Handle<Group> busy = domain->create_component<Group>("Busy");
+      for(Uint j = 0; j != 20; ++j)
+        busy->create_component<Group>("Child" + to_str(j));
+      mesh.topology().create_component<Region>("BusyRegion");
+      BOOST_CHECK(common::count(find_components_recursively<Region>(mesh.topology())) > 1);
+      mesh.topology().remove_component("BusyRegion");
+      domain->remove_component("Busy");
+    }
+
+    advance_time->execute();
+  }
+
+  series_writer->wait_for_writes();
+
+  for(Uint step = 0; step != nb_steps; ++step)
+  {
+    const std::string tecplot_file = "timeseries-async-" + to_str(step) + ".plt";
+    BOOST_CHECK(boost::filesystem::exists("timeseries-async-" + to_str(step) + ".pvtu"));
+    BOOST_REQUIRE(boost::filesystem::exists(tecplot_file));
+    BOOST_CHECK_EQUAL(first_tecplot_value(tecplot_file, "u"), static_cast<Real>(step));
+
+    // The iteration comes from the mesh metadata at the time the write was queued
+    std::ifstream file(tecplot_file.c_str());
+    const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    BOOST_CHECK(contents.find("T=\"STEP" + to_str(step) + ":") != std::string::npos);
+
+    // Zone names were resolved relative to the topology before the write was queued
+    BOOST_CHECK(contents.find("T=\"STEP" + to_str(step) + ":" + mesh.topology().uri().path()) == std::string::npos);
+  }
+
+  root.remove_component("Domain");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////
@@ -82,3 +82,26 @@ for i in range(10):
     meshdiff.execute()
     if not meshdiff.properties()['mesh_equal']:
       raise Exception('Error in read mesh')
+
+# Asynchronous writes from a background thread, with at most two writes pending
+async_writer = domain.create_component('AsyncSeriesWriter', 'cf3.solver.actions.TimeSeriesWriter')
+async_writer.time = time
+async_writer.interval = 1
+async_writer.asynchronous = True
+async_writer.max_pending_writes = 2
+
+vtk_writer = async_writer.create_component('VTKWriter', 'cf3.mesh.VTKXML.Writer')
+async_template = 'timeseries-async-{iteration}.pvtu'
+vtk_writer.file = cf.URI(async_template)
+vtk_writer.mesh = mesh
+vtk_writer.fields = [mesh.geometry.coordinates.uri()]
+
+for i in range(4):
+  async_writer.execute()
+  advance_time.execute()
+async_writer.wait_for_writes()
+
+for i in range(4):
+  filename = async_template.format(iteration = time.iteration - 4 + i)
+  if not os.path.isfile(filename):
+    raise Exception('File ' + filename + ' was not written asynchronously')
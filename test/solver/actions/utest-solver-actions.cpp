@@ -224,6 +224,31 @@ BOOST_AUTO_TEST_CASE ( test_CSetFieldValue )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE ( test_ThreadedElementLoop )
+{
+  Component& root = Core::instance().root();
+  Handle< Mesh > mesh = root.get_child("mesh2")->handle<Mesh>();
+
+  Dictionary& cells_P0 = *mesh->get_child("cells_P0")->handle<Dictionary>();
+  Field& serial_volumes = *cells_P0.get_child("volume")->handle<Field>();
+  Field& threaded_volumes = cells_P0.create_field("threaded_volume");
+
+  Handle<Loop> elem_loop = root.create_component< ForAllElements >("threaded_elem_loop");
+  elem_loop->options().set("regions",std::vector<URI>(1,mesh->topology().uri()));
+  elem_loop->options().set("nb_threads",3u);
+  elem_loop->create_loop_operation("cf3.solver.actions.ComputeVolume");
+  elem_loop->action("cf3.solver.actions.ComputeVolume").options().set("volume",threaded_volumes.uri());
+  elem_loop->execute();
+
+  BOOST_CHECK_EQUAL(serial_volumes.size(), threaded_volumes.size());
+  for(Uint i = 0; i != serial_volumes.size(); ++i)
+    BOOST_CHECK_CLOSE(serial_volumes[i][0], threaded_volumes[i][0], 1e-12);
+
+  root.remove_component(*elem_loop);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE ( test_ForAllElementsT )
 {
   Component& root = Core::instance().root();